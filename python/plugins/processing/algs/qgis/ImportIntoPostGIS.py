@@ -177,6 +177,8 @@ class ImportIntoPostGIS(QgisAlgorithm):
 
         if encoding:
             options['fileEncoding'] = encoding
+        # the spatial index is created below, so that its errors are reported
+        options['SPATIAL_INDEX'] = False
 
         exporter = QgsVectorLayerExporter(uri.uri(), providerName, source.fields(),
                                           source.wkbType(), source.sourceCrs(), overwrite, options)
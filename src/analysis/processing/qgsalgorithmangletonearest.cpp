@@ -217,7 +217,7 @@ QVariantMap QgsAngleToNearestAlgorithm::processAlgorithm( const QVariantMap &par
     feedback->setProgress( i * step );
 
     return true;
-  }, QgsSpatialIndex::FlagStoreFeatureGeometries );
+  }, QgsSpatialIndex::FlagStoreFeatureGeometries | QgsSpatialIndex::FlagStaticIndex );
 
   QgsFeature f;
 
@@ -19,6 +19,9 @@
 #include "qgswkbtypes.h"
 #include "qgsvectorlayer.h"
 
+#include <QThread>
+#include <QtConcurrentMap>
+
 ///@cond PRIVATE
 
 QString QgsBufferAlgorithm::name() const
@@ -118,44 +121,75 @@ QVariantMap QgsBufferAlgorithm::processAlgorithm( const QVariantMap &parameters,
   QVector< QgsGeometry > bufferedGeometriesForDissolve;
   QgsAttributes dissolveAttrs;
 
-  while ( it.nextFeature( f ) )
+  // features are read in chunks, and their geometries are buffered concurrently. Distances are evaluated and
+  // features are output from this thread, in the order of the input features
+  struct BufferJob
   {
-    if ( feedback->isCanceled() )
-    {
-      break;
-    }
-    if ( dissolveAttrs.isEmpty() )
-      dissolveAttrs = f.attributes();
+    QgsFeature feature;
+    double distance = 0;
+    QgsGeometry buffered;
+  };
+  const int chunkSize = 256 * std::max( 1, QThread::idealThreadCount() );
+  std::vector< BufferJob > jobs;
+  jobs.reserve( chunkSize );
 
-    QgsFeature out = f;
-    if ( out.hasGeometry() )
+  bool finished = false;
+  while ( !finished && !feedback->isCanceled() )
+  {
+    jobs.clear();
+    while ( static_cast< int >( jobs.size() ) < chunkSize && it.nextFeature( f ) )
     {
-      double distance =  bufferDistance;
-      if ( dynamicBuffer )
+      if ( dissolveAttrs.isEmpty() )
+        dissolveAttrs = f.attributes();
+
+      BufferJob job;
+      job.distance = bufferDistance;
+      if ( dynamicBuffer && f.hasGeometry() )
       {
         expressionContext.setFeature( f );
-        distance = bufferProperty.valueAsDouble( expressionContext, bufferDistance );
+        job.distance = bufferProperty.valueAsDouble( expressionContext, bufferDistance );
       }
+      job.feature = f;
+      jobs.emplace_back( job );
+    }
+    finished = static_cast< int >( jobs.size() ) < chunkSize;
 
-      QgsGeometry outputGeometry = f.geometry().buffer( distance, segments, endCapStyle, joinStyle, miterLimit );
-      if ( outputGeometry.isNull() )
+    QtConcurrent::blockingMap( jobs, [ = ]( BufferJob & job )
+    {
+      if ( job.feature.hasGeometry() && !feedback->isCanceled() )
+        job.buffered = job.feature.geometry().buffer( job.distance, segments, endCapStyle, joinStyle, miterLimit );
+    } );
+
+    for ( BufferJob &job : jobs )
+    {
+      if ( feedback->isCanceled() )
       {
-        QgsMessageLog::logMessage( QObject::tr( "Error calculating buffer for feature %1" ).arg( f.id() ), QObject::tr( "Processing" ), Qgis::Warning );
+        break;
       }
-      if ( dissolve )
-        bufferedGeometriesForDissolve << outputGeometry;
-      else
+
+      QgsFeature &out = job.feature;
+      if ( out.hasGeometry() )
       {
-        outputGeometry.convertToMultiType();
-        out.setGeometry( outputGeometry );
+        QgsGeometry outputGeometry = job.buffered;
+        if ( outputGeometry.isNull() )
+        {
+          QgsMessageLog::logMessage( QObject::tr( "Error calculating buffer for feature %1" ).arg( out.id() ), QObject::tr( "Processing" ), Qgis::Warning );
+        }
+        if ( dissolve )
+          bufferedGeometriesForDissolve << outputGeometry;
+        else
+        {
+          outputGeometry.convertToMultiType();
+          out.setGeometry( outputGeometry );
+        }
       }
-    }
 
-    if ( !dissolve )
-      sink->addFeature( out, QgsFeatureSink::FastInsert );
+      if ( !dissolve )
+        sink->addFeature( out, QgsFeatureSink::FastInsert );
 
-    feedback->setProgress( current * step );
-    current++;
+      feedback->setProgress( current * step );
+      current++;
+    }
   }
 
   if ( dissolve )
@@ -112,7 +112,7 @@ QVariantMap QgsDeleteDuplicateGeometriesAlgorithm::processAlgorithm( const QVari
     current++;
     feedback->setProgress( 0.10 * current * step );
     return true;
-  } );
+  }, QgsSpatialIndex::FlagStaticIndex );
 
   QgsFeature f;
 
@@ -68,6 +68,11 @@ QgsDensifyGeometriesByCountAlgorithm *QgsDensifyGeometriesByCountAlgorithm::crea
 
 }
 
+QgsProcessingAlgorithm::Flags QgsDensifyGeometriesByCountAlgorithm::flags() const
+{
+  return QgsProcessingFeatureBasedAlgorithm::flags() | QgsProcessingAlgorithm::FlagSupportsParallelFeatures;
+}
+
 QList<int> QgsDensifyGeometriesByCountAlgorithm::inputLayerTypes() const
 {
   return QList<int>() << QgsProcessing::TypeVectorLine << QgsProcessing::TypeVectorPolygon;
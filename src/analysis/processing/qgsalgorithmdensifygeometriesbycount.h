@@ -39,6 +39,7 @@ class QgsDensifyGeometriesByCountAlgorithm : public QgsProcessingFeatureBasedAlg
     QString shortHelpString() const override;
     QString shortDescription() const override;
     QgsDensifyGeometriesByCountAlgorithm *createInstance() const override SIP_FACTORY;
+    Flags flags() const override;
     QList<int> inputLayerTypes() const override;
 
   protected:
@@ -63,6 +63,11 @@ QgsDensifyGeometriesByIntervalAlgorithm *QgsDensifyGeometriesByIntervalAlgorithm
 
 }
 
+QgsProcessingAlgorithm::Flags QgsDensifyGeometriesByIntervalAlgorithm::flags() const
+{
+  return QgsProcessingFeatureBasedAlgorithm::flags() | QgsProcessingAlgorithm::FlagSupportsParallelFeatures;
+}
+
 QList<int> QgsDensifyGeometriesByIntervalAlgorithm::inputLayerTypes() const
 {
   return QList<int>() << QgsProcessing::TypeVectorLine << QgsProcessing::TypeVectorPolygon;
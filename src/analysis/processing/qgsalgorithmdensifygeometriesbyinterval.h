@@ -39,6 +39,7 @@ class QgsDensifyGeometriesByIntervalAlgorithm : public QgsProcessingFeatureBased
     QString shortHelpString() const override;
     QString shortDescription() const override;
     QgsDensifyGeometriesByIntervalAlgorithm *createInstance() const override SIP_FACTORY;
+    Flags flags() const override;
     QList<int> inputLayerTypes() const override;
 
   protected:
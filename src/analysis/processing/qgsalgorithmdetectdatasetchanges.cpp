@@ -236,7 +236,7 @@ QVariantMap QgsDetectVectorChangesAlgorithm::processAlgorithm( const QVariantMap
     current++;
     feedback->setProgress( 0.10 * current * step );
     return true;
-  } );
+  }, QgsSpatialIndex::FlagStaticIndex );
 
   QSet<QgsFeatureId> unchangedOriginalIds;
   QSet<QgsFeatureId> addedRevisedIds;
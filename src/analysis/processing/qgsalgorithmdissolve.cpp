@@ -16,6 +16,12 @@
  ***************************************************************************/
 
 #include "qgsalgorithmdissolve.h"
+#include "qgsspatialindexutils.h"
+
+#include <QThread>
+#include <QtConcurrentMap>
+
+#include <algorithm>
 
 ///@cond PRIVATE
 
@@ -24,7 +30,7 @@
 //
 
 QVariantMap QgsCollectorAlgorithm::processCollection( const QVariantMap &parameters, QgsProcessingContext &context, QgsProcessingFeedback *feedback,
-    const std::function<QgsGeometry( const QVector< QgsGeometry >& )> &collector, int maxQueueLength, QgsProcessingFeatureSource::Flags sourceFlags )
+    const std::function<QgsGeometry( const QVector< QgsGeometry >&, QgsFeedback * )> &collector, QgsProcessingFeatureSource::Flags sourceFlags )
 {
   std::unique_ptr< QgsProcessingFeatureSource > source( parameterAsSource( parameters, QStringLiteral( "INPUT" ), context ) );
   if ( !source )
@@ -49,8 +55,10 @@ QVariantMap QgsCollectorAlgorithm::processCollection( const QVariantMap &paramet
   if ( fields.isEmpty() )
   {
     // dissolve all - not using fields
+    // first step reads the features, second step collects their geometries
+    QgsProcessingMultiStepFeedback multiStepFeedback( 2, feedback );
     bool firstFeature = true;
-    // we dissolve geometries in blocks using unaryUnion
+    // all geometries are collected at once, so that the collector can report progress and be canceled
     QVector< QgsGeometry > geomQueue;
     QgsFeature outputFeature;
 
@@ -70,21 +78,16 @@ QVariantMap QgsCollectorAlgorithm::processCollection( const QVariantMap &paramet
       if ( f.hasGeometry() && !f.geometry().isNull() )
       {
         geomQueue.append( f.geometry() );
-        if ( maxQueueLength > 0 && geomQueue.length() > maxQueueLength )
-        {
-          // queue too long, combine it
-          QgsGeometry tempOutputGeometry = collector( geomQueue );
-          geomQueue.clear();
-          geomQueue << tempOutputGeometry;
-        }
       }
 
-      feedback->setProgress( current * step );
+      multiStepFeedback.setProgress( current * step );
       current++;
     }
 
-    outputFeature.setGeometry( collector( geomQueue ) );
-    sink->addFeature( outputFeature, QgsFeatureSink::FastInsert );
+    multiStepFeedback.setCurrentStep( 1 );
+    outputFeature.setGeometry( collector( geomQueue, &multiStepFeedback ) );
+    if ( !feedback->isCanceled() )
+      sink->addFeature( outputFeature, QgsFeatureSink::FastInsert );
   }
   else
   {
@@ -127,6 +130,8 @@ QVariantMap QgsCollectorAlgorithm::processCollection( const QVariantMap &paramet
     }
 
     int numberFeatures = attributeHash.count();
+    // every group is a step, so that collectors can report progress within a group
+    QgsProcessingMultiStepFeedback multiStepFeedback( numberFeatures, feedback );
     QHash< QVariant, QgsAttributes >::const_iterator attrIt = attributeHash.constBegin();
     for ( ; attrIt != attributeHash.constEnd(); ++attrIt )
     {
@@ -135,10 +140,16 @@ QVariantMap QgsCollectorAlgorithm::processCollection( const QVariantMap &paramet
         break;
       }
 
+      multiStepFeedback.setCurrentStep( current );
       QgsFeature outputFeature;
       if ( geometryHash.contains( attrIt.key() ) )
       {
-        QgsGeometry geom = collector( geometryHash.value( attrIt.key() ) );
+        QgsGeometry geom = collector( geometryHash.value( attrIt.key() ), &multiStepFeedback );
+        // a canceled collector returns an incomplete geometry, which must not be written
+        if ( feedback->isCanceled() )
+        {
+          break;
+        }
         if ( !geom.isMultipart() )
         {
           geom.convertToMultiType();
@@ -148,8 +159,8 @@ QVariantMap QgsCollectorAlgorithm::processCollection( const QVariantMap &paramet
       outputFeature.setAttributes( attrIt.value() );
       sink->addFeature( outputFeature, QgsFeatureSink::FastInsert );
 
-      feedback->setProgress( current * 100.0 / numberFeatures );
       current++;
+      multiStepFeedback.setProgress( 100 );
     }
   }
 
@@ -214,9 +225,11 @@ QgsDissolveAlgorithm *QgsDissolveAlgorithm::createInstance() const
 
 QVariantMap QgsDissolveAlgorithm::processAlgorithm( const QVariantMap &parameters, QgsProcessingContext &context, QgsProcessingFeedback *feedback )
 {
-  return processCollection( parameters, context, feedback, [ & ]( const QVector< QgsGeometry > &parts )->QgsGeometry
+  return processCollection( parameters, context, feedback, [ & ]( const QVector< QgsGeometry > &parts, QgsFeedback * collectorFeedback )->QgsGeometry
   {
-    QgsGeometry result( QgsGeometry::unaryUnion( parts ) );
+    QgsGeometry result( cascadedUnion( parts, collectorFeedback ) );
+    if ( feedback->isCanceled() )
+      return result;
     if ( QgsWkbTypes::geometryType( result.wkbType() ) == QgsWkbTypes::LineGeometry )
       result = result.mergeLines();
     // Geos may fail in some cases, let's try a slower but safer approach
@@ -244,7 +257,109 @@ QVariantMap QgsDissolveAlgorithm::processAlgorithm( const QVariantMap &parameter
         throw QgsProcessingException( QObject::tr( "The algorithm returned no output." ) );
     }
     return result;
-  }, 10000 );
+  } );
+}
+
+QgsGeometry QgsDissolveAlgorithm::cascadedUnion( const QVector< QgsGeometry > &geometries, QgsFeedback *feedback )
+{
+  // number of geometries unioned at once by a thread. Small enough for tiles to be unioned quickly,
+  // large enough for most shared boundaries to be dissolved within the tiles
+  const int tileSize = 256;
+  // number of neighboring tiles merged at once on the next level
+  const int mergeSize = 4;
+
+  if ( geometries.size() <= tileSize )
+    return QgsGeometry::unaryUnion( geometries );
+
+  // sort geometries along a Hilbert curve, so that every tile holds geometries which are close to each other
+  QgsRectangle extent;
+  extent.setMinimal();
+  for ( const QgsGeometry &geometry : geometries )
+    extent.combineExtentWith( geometry.boundingBox() );
+
+  const double scaleX = extent.width() > 0 ? 65535 / extent.width() : 0;
+  const double scaleY = extent.height() > 0 ? 65535 / extent.height() : 0;
+  std::vector< std::pair< quint32, int > > order;
+  order.reserve( static_cast< std::size_t >( geometries.size() ) );
+  for ( int i = 0; i < geometries.size(); ++i )
+  {
+    const QgsPointXY center = geometries.at( i ).boundingBox().center();
+    const double x = qBound( 0.0, ( center.x() - extent.xMinimum() ) * scaleX, 65535.0 );
+    const double y = qBound( 0.0, ( center.y() - extent.yMinimum() ) * scaleY, 65535.0 );
+    order.emplace_back( QgsSpatialIndexUtils::hilbertValue( static_cast< quint32 >( x ), static_cast< quint32 >( y ) ), i );
+  }
+  std::sort( order.begin(), order.end() );
+
+  struct Tile
+  {
+    QVector< QgsGeometry > parts;
+    QgsGeometry result;
+  };
+
+  std::vector< Tile > tiles;
+  tiles.reserve( order.size() / tileSize + 1 );
+  for ( std::size_t i = 0; i < order.size(); i += tileSize )
+  {
+    Tile tile;
+    const std::size_t end = std::min( i + tileSize, order.size() );
+    tile.parts.reserve( static_cast< int >( end - i ) );
+    for ( std::size_t j = i; j < end; ++j )
+      tile.parts << geometries.at( order[j].second );
+    tiles.emplace_back( std::move( tile ) );
+  }
+
+  // the total number of unions over all levels, for progress reports
+  std::size_t totalUnions = 0;
+  for ( std::size_t count = tiles.size(); ; count = ( count + mergeSize - 1 ) / mergeSize )
+  {
+    totalUnions += count;
+    if ( count == 1 )
+      break;
+  }
+
+  // tiles are unioned in batches, to report progress and check for cancellation between batches
+  const std::size_t batchSize = static_cast< std::size_t >( std::max( 1, QThread::idealThreadCount() ) ) * 2;
+  std::size_t unions = 0;
+  while ( true )
+  {
+    for ( std::size_t batchStart = 0; batchStart < tiles.size(); batchStart += batchSize )
+    {
+      if ( feedback && feedback->isCanceled() )
+        return QgsGeometry();
+
+      const std::size_t batchEnd = std::min( batchStart + batchSize, tiles.size() );
+      QtConcurrent::blockingMap( tiles.begin() + batchStart, tiles.begin() + batchEnd, []( Tile & tile )
+      {
+        tile.result = QgsGeometry::unaryUnion( tile.parts );
+        tile.parts.clear();
+      } );
+
+      for ( std::size_t i = batchStart; i < batchEnd; ++i )
+      {
+        if ( !tiles[i].result.lastError().isEmpty() )
+          return QgsGeometry::unaryUnion( geometries );
+      }
+
+      unions += batchEnd - batchStart;
+      if ( feedback )
+        feedback->setProgress( 100.0 * unions / totalUnions );
+    }
+
+    if ( tiles.size() == 1 )
+      return tiles.front().result;
+
+    // merge the results of neighboring tiles along the curve
+    std::vector< Tile > merged;
+    merged.reserve( ( tiles.size() + mergeSize - 1 ) / mergeSize );
+    for ( std::size_t i = 0; i < tiles.size(); i += mergeSize )
+    {
+      Tile tile;
+      for ( std::size_t j = i; j < std::min( i + mergeSize, tiles.size() ); ++j )
+        tile.parts << tiles[j].result;
+      merged.emplace_back( std::move( tile ) );
+    }
+    tiles.swap( merged );
+  }
 }
 
 //
@@ -278,10 +393,10 @@ QString QgsCollectAlgorithm::groupId() const
 
 QVariantMap QgsCollectAlgorithm::processAlgorithm( const QVariantMap &parameters, QgsProcessingContext &context, QgsProcessingFeedback *feedback )
 {
-  return processCollection( parameters, context, feedback, []( const QVector< QgsGeometry > &parts )->QgsGeometry
+  return processCollection( parameters, context, feedback, []( const QVector< QgsGeometry > &parts, QgsFeedback * )->QgsGeometry
   {
     return QgsGeometry::collectGeometry( parts );
-  }, 0, QgsProcessingFeatureSource::FlagSkipGeometryValidityChecks );
+  }, QgsProcessingFeatureSource::FlagSkipGeometryValidityChecks );
 }
 
 
@@ -34,7 +34,7 @@ class QgsCollectorAlgorithm : public QgsProcessingAlgorithm
   protected:
 
     QVariantMap processCollection( const QVariantMap &parameters, QgsProcessingContext &context, QgsProcessingFeedback *feedback,
-                                   const std::function<QgsGeometry( const QVector<QgsGeometry>& )> &collector, int maxQueueLength = 0, QgsProcessingFeatureSource::Flags sourceFlags = QgsProcessingFeatureSource::Flags() );
+                                   const std::function<QgsGeometry( const QVector<QgsGeometry>&, QgsFeedback * )> &collector, QgsProcessingFeatureSource::Flags sourceFlags = QgsProcessingFeatureSource::Flags() );
 };
 
 /**
@@ -57,6 +57,16 @@ class QgsDissolveAlgorithm : public QgsCollectorAlgorithm
     QString shortHelpString() const override;
     QgsDissolveAlgorithm *createInstance() const override SIP_FACTORY;
 
+    /**
+     * Unions \a geometries in tiles of nearby geometries, which are unioned concurrently, and then
+     * merges the results of neighboring tiles level by level until a single geometry remains.
+     *
+     * Progress is reported to \a feedback, which can also cancel the union, in which case a null
+     * geometry is returned. If GEOS fails to union a tile, all geometries are unioned at once
+     * instead, so that the returned geometry holds the GEOS error.
+     */
+    static QgsGeometry cascadedUnion( const QVector< QgsGeometry > &geometries, QgsFeedback *feedback = nullptr );
+
   protected:
 
     QVariantMap processAlgorithm( const QVariantMap &parameters,
@@ -16,6 +16,7 @@
  ***************************************************************************/
 
 #include "qgsalgorithmextractbyexpression.h"
+#include "qgsfeaturebatch.h"
 
 ///@cond PRIVATE
 
@@ -128,27 +129,34 @@ QVariantMap QgsExtractByExpressionAlgorithm::processAlgorithm( const QVariantMap
     expressionContext.setFields( source->fields() );
     expression.prepare( &expressionContext );
 
+    // the expression is evaluated for a whole batch of features at once
     QgsFeatureIterator it = source->getFeatures();
-    QgsFeature f;
-    while ( it.nextFeature( f ) )
+    QgsFeatureBatch batch;
+    QVector< bool > selection;
+    while ( !feedback->isCanceled() && it.nextBatch( batch ) )
     {
-      if ( feedback->isCanceled() )
-      {
-        break;
-      }
+      expression.evaluateBatch( batch, &expressionContext, &selection );
 
-      expressionContext.setFeature( f );
-      if ( expression.evaluate( &expressionContext ).toBool() )
+      for ( int row = 0; row < batch.count(); ++row )
       {
-        matchingSink->addFeature( f, QgsFeatureSink::FastInsert );
+        if ( feedback->isCanceled() )
+        {
+          break;
+        }
+
+        QgsFeature f = batch.feature( row );
+        if ( selection.at( row ) )
+        {
+          matchingSink->addFeature( f, QgsFeatureSink::FastInsert );
+        }
+        else
+        {
+          nonMatchingSink->addFeature( f, QgsFeatureSink::FastInsert );
+        }
+
+        feedback->setProgress( current * step );
+        current++;
       }
-      else
-      {
-        nonMatchingSink->addFeature( f, QgsFeatureSink::FastInsert );
-      }
-
-      feedback->setProgress( current * step );
-      current++;
     }
   }
 
@@ -17,6 +17,7 @@
 
 #include "qgsalgorithmextractbylocation.h"
 #include "qgsgeometryengine.h"
+#include "qgspreparedgeometrycache.h"
 #include "qgsvectorlayer.h"
 
 ///@cond PRIVATE
@@ -237,7 +238,9 @@ void QgsLocationBasedAlgorithm::processByIteratingOverIntersectSource( const Qgs
   double step = intersectSource->featureCount() > 0 ? 100.0 / intersectSource->featureCount() : 1;
   int current = 0;
   QgsFeature f;
-  std::unique_ptr< QgsGeometryEngine > engine;
+  std::shared_ptr< QgsGeometryEngine > engine;
+  // intersect features are often tested again by later runs, so their prepared geometries are kept by the context
+  const QString cacheKey = QStringLiteral( "%1:%2" ).arg( intersectSource->sourceName(), targetSource->sourceCrs().authid() );
   while ( fIt.nextFeature( f ) )
   {
     if ( feedback->isCanceled() )
@@ -273,8 +276,7 @@ void QgsLocationBasedAlgorithm::processByIteratingOverIntersectSource( const Qgs
 
       if ( !engine )
       {
-        engine.reset( QgsGeometry::createGeometryEngine( f.geometry().constGet() ) );
-        engine->prepareGeometry();
+        engine = context.preparedGeometryCache()->preparedEngine( cacheKey, f.id(), f.geometry() );
       }
 
       bool isMatch = false;
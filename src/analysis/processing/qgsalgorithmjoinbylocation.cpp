@@ -18,6 +18,7 @@
 #include "qgsalgorithmjoinbylocation.h"
 #include "qgsprocessing.h"
 #include "qgsgeometryengine.h"
+#include "qgspreparedgeometrycache.h"
 #include "qgsvectorlayer.h"
 #include "qgsapplication.h"
 #include "qgsfeature.h"
@@ -326,7 +327,7 @@ void QgsJoinByLocationAlgorithm::processAlgorithmByIteratingOverJoinedSource( Qg
     if ( feedback->isCanceled() )
       break;
 
-    processFeatureFromJoinSource( f, feedback );
+    processFeatureFromJoinSource( f, context, feedback );
 
     i++;
     feedback->setProgress( i * step );
@@ -414,13 +415,13 @@ void QgsJoinByLocationAlgorithm::sortPredicates( QList<int> &predicates )
   } );
 }
 
-bool QgsJoinByLocationAlgorithm::processFeatureFromJoinSource( QgsFeature &joinFeature, QgsProcessingFeedback *feedback )
+bool QgsJoinByLocationAlgorithm::processFeatureFromJoinSource( QgsFeature &joinFeature, QgsProcessingContext &context, QgsProcessingFeedback *feedback )
 {
   if ( !joinFeature.hasGeometry() )
     return false;
 
   const QgsGeometry featGeom = joinFeature.geometry();
-  std::unique_ptr< QgsGeometryEngine > engine;
+  std::shared_ptr< QgsGeometryEngine > engine;
   QgsFeatureRequest req = QgsFeatureRequest().setFilterRect( featGeom.boundingBox() );
   QgsFeatureIterator it = mBaseSource->getFeatures( req );
   QList<QgsFeature> filtered;
@@ -452,8 +453,8 @@ bool QgsJoinByLocationAlgorithm::processFeatureFromJoinSource( QgsFeature &joinF
 
     if ( !engine )
     {
-      engine.reset( QgsGeometry::createGeometryEngine( featGeom.constGet() ) );
-      engine->prepareGeometry();
+      // join features are often tested again by later runs, so their prepared geometries are kept by the context
+      engine = context.preparedGeometryCache()->preparedEngine( QStringLiteral( "%1:%2" ).arg( mJoinSource->sourceName(), mBaseSource->sourceCrs().authid() ), joinFeature.id(), featGeom );
       for ( int ix : qgis::as_const( mJoinedFieldIndices ) )
       {
         joinAttributes.append( joinFeature.attribute( ix ) );
@@ -215,7 +215,7 @@ QVariantMap QgsJoinByNearestAlgorithm::processAlgorithm( const QVariantMap &para
     input2AttributeCache.insert( f.id(), attributes );
 
     return true;
-  }, QgsSpatialIndex::FlagStoreFeatureGeometries );
+  }, QgsSpatialIndex::FlagStoreFeatureGeometries | QgsSpatialIndex::FlagStaticIndex );
 
   QgsFeature f;
 
@@ -69,6 +69,11 @@ QgsOffsetLinesAlgorithm *QgsOffsetLinesAlgorithm::createInstance() const
   return new QgsOffsetLinesAlgorithm();
 }
 
+QgsProcessingAlgorithm::Flags QgsOffsetLinesAlgorithm::flags() const
+{
+  return QgsProcessingFeatureBasedAlgorithm::flags() | QgsProcessingAlgorithm::FlagSupportsParallelFeatures;
+}
+
 void QgsOffsetLinesAlgorithm::initParameters( const QVariantMap & )
 {
   std::unique_ptr< QgsProcessingParameterDistance > offset = qgis::make_unique< QgsProcessingParameterDistance >( QStringLiteral( "DISTANCE" ),
@@ -123,15 +123,19 @@ QVariantMap QgsRasterLayerUniqueValuesReportAlgorithm::processAlgorithm( const Q
   qgssize noDataCount = 0;
 
   qgssize layerSize = static_cast< qgssize >( mLayerWidth ) * static_cast< qgssize >( mLayerHeight );
-  int maxWidth = QgsRasterIterator::DEFAULT_MAXIMUM_TILE_WIDTH;
-  int maxHeight = QgsRasterIterator::DEFAULT_MAXIMUM_TILE_HEIGHT;
-  int nbBlocksWidth = std::ceil( 1.0 * mLayerWidth / maxWidth );
-  int nbBlocksHeight = std::ceil( 1.0 * mLayerHeight / maxHeight );
-  int nbBlocks = nbBlocksWidth * nbBlocksHeight;
 
   QgsRasterIterator iter( mInterface.get() );
+  // the next block is read while the values of the current one are counted
+  iter.setPrefetchEnabled( true );
   iter.startRasterRead( mBand, mLayerWidth, mLayerHeight, mExtent );
 
+  // tiles are aligned to the blocks of the provider
+  int maxWidth = iter.maximumTileWidth();
+  int maxHeight = iter.maximumTileHeight();
+  int nbBlocksWidth = std::ceil( 1.0 * mLayerWidth / maxWidth );
+  int nbBlocksHeight = std::ceil( 1.0 * mLayerHeight / maxHeight );
+  int nbBlocks = nbBlocksWidth * nbBlocksHeight;
+
   int iterLeft = 0;
   int iterTop = 0;
   int iterCols = 0;
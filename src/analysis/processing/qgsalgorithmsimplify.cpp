@@ -62,6 +62,11 @@ QgsSimplifyAlgorithm *QgsSimplifyAlgorithm::createInstance() const
   return new QgsSimplifyAlgorithm();
 }
 
+QgsProcessingAlgorithm::Flags QgsSimplifyAlgorithm::flags() const
+{
+  return QgsProcessingFeatureBasedAlgorithm::flags() | QgsProcessingAlgorithm::FlagSupportsParallelFeatures;
+}
+
 QList<int> QgsSimplifyAlgorithm::inputLayerTypes() const
 {
   return QList<int>() << QgsProcessing::TypeVectorLine << QgsProcessing::TypeVectorPolygon;
@@ -83,6 +83,11 @@ QgsSingleSidedBufferAlgorithm *QgsSingleSidedBufferAlgorithm::createInstance() c
   return new QgsSingleSidedBufferAlgorithm();
 }
 
+QgsProcessingAlgorithm::Flags QgsSingleSidedBufferAlgorithm::flags() const
+{
+  return QgsProcessingFeatureBasedAlgorithm::flags() | QgsProcessingAlgorithm::FlagSupportsParallelFeatures;
+}
+
 void QgsSingleSidedBufferAlgorithm::initParameters( const QVariantMap & )
 {
   auto bufferParam = qgis::make_unique < QgsProcessingParameterDistance >( QStringLiteral( "DISTANCE" ), QObject::tr( "Distance" ), 10, QStringLiteral( "INPUT" ) );
@@ -84,6 +84,11 @@ QgsTransformAlgorithm *QgsTransformAlgorithm::createInstance() const
   return new QgsTransformAlgorithm();
 }
 
+QgsProcessingAlgorithm::Flags QgsTransformAlgorithm::flags() const
+{
+  return QgsProcessingFeatureBasedAlgorithm::flags() | QgsProcessingAlgorithm::FlagSupportsParallelFeatures;
+}
+
 bool QgsTransformAlgorithm::prepareAlgorithm( const QVariantMap &parameters, QgsProcessingContext &context, QgsProcessingFeedback * )
 {
   prepareSource( parameters, context );
@@ -18,6 +18,11 @@
 #include "qgsgeometryengine.h"
 #include "qgsprocessingalgorithm.h"
 
+#include <QThread>
+#include <QtConcurrentMap>
+
+#include <algorithm>
+
 ///@cond PRIVATE
 
 bool QgsOverlayUtils::sanitizeIntersectionResult( QgsGeometry &geom, QgsWkbTypes::GeometryType geometryType )
@@ -82,6 +87,108 @@ static bool sanitizeDifferenceResult( QgsGeometry &geom, QgsWkbTypes::GeometryTy
 }
 
 
+/**
+ * Overlays the features read from \a fitA with the features of \a sourceB, calling \a overlay to compute the output
+ * features for each feature A from the features B whose bounding box intersects the bounding box of A.
+ *
+ * Features A are read in batches. The features B intersecting any feature of a batch are fetched at once, and the
+ * features of the batch are then overlaid concurrently, each thread using its own GEOS context. Every feature A
+ * belongs to a single batch, so there are no duplicated results to remove, and output features are written in the
+ * order of the features A.
+ */
+template <typename Overlay>
+static void overlayFeatures( QgsFeatureIterator &fitA, const QgsSpatialIndex &indexB, const QgsFeatureSource &sourceB, const QgsFeatureRequest &requestB,
+                             QgsFeatureSink &sink, QgsProcessingFeedback *feedback, int &count, int totalCount, const Overlay &overlay )
+{
+  struct Item
+  {
+    QgsFeature featureA;
+    QList< QgsFeatureId > candidatesB;
+    QgsFeatureList output;
+    QString error;
+  };
+
+  if ( totalCount == 0 )
+    totalCount = 1;  // avoid division by zero
+
+  // large enough to keep the cost of synchronizing threads low, small enough to keep the features B of a batch in memory
+  const std::size_t batchSize = static_cast< std::size_t >( std::max( 1, QThread::idealThreadCount() ) ) * 64;
+
+  std::vector< Item > batch;
+  batch.reserve( batchSize );
+  QHash< QgsFeatureId, QgsFeature > featuresB;
+  bool finished = false;
+  while ( !finished && !feedback->isCanceled() )
+  {
+    batch.clear();
+    QgsFeatureIds idsB;
+    QgsFeature featA;
+    while ( batch.size() < batchSize && fitA.nextFeature( featA ) )
+    {
+      Item item;
+      item.featureA = featA;
+      if ( featA.hasGeometry() )
+      {
+        item.candidatesB = indexB.intersects( featA.geometry().boundingBox() );
+        std::sort( item.candidatesB.begin(), item.candidatesB.end() );
+        for ( QgsFeatureId id : qgis::as_const( item.candidatesB ) )
+          idsB.insert( id );
+      }
+      batch.emplace_back( std::move( item ) );
+    }
+    finished = batch.size() < batchSize;
+    if ( batch.empty() )
+      break;
+
+    // features B are fetched from this thread, as a source must not be iterated from several threads
+    featuresB.clear();
+    if ( !idsB.isEmpty() )
+    {
+      QgsFeatureRequest request( requestB );
+      request.setFilterFids( idsB );
+      QgsFeature featB;
+      QgsFeatureIterator fitB = sourceB.getFeatures( request );
+      while ( fitB.nextFeature( featB ) )
+      {
+        if ( feedback->isCanceled() )
+          return;
+
+        // geometries B are shared by the threads, so compute their cached bounding box now
+        featB.geometry().boundingBox();
+        featuresB.insert( featB.id(), featB );
+      }
+    }
+
+    const QHash< QgsFeatureId, QgsFeature > &constFeaturesB = featuresB;
+    QtConcurrent::blockingMap( batch, [&overlay, &constFeaturesB, feedback]( Item & item )
+    {
+      if ( feedback->isCanceled() )
+        return;
+
+      try
+      {
+        item.output = overlay( item.featureA, item.candidatesB, constFeaturesB );
+      }
+      catch ( QgsProcessingException &e )
+      {
+        item.error = e.what();
+      }
+    } );
+
+    for ( Item &item : batch )
+    {
+      if ( !item.error.isEmpty() )
+        throw QgsProcessingException( item.error );
+
+      for ( QgsFeature &outFeat : item.output )
+        sink.addFeature( outFeat, QgsFeatureSink::FastInsert );
+
+      ++count;
+      feedback->setProgress( count / ( double ) totalCount * 100. );
+    }
+  }
+}
+
 void QgsOverlayUtils::difference( const QgsFeatureSource &sourceA, const QgsFeatureSource &sourceB, QgsFeatureSink &sink, QgsProcessingContext &context, QgsProcessingFeedback *feedback, int &count, int totalCount, QgsOverlayUtils::DifferenceOutput outputAttrs )
 {
   QgsWkbTypes::GeometryType geometryType = QgsWkbTypes::geometryType( QgsWkbTypes::multiType( sourceA.wkbType() ) );
@@ -89,106 +196,92 @@ void QgsOverlayUtils::difference( const QgsFeatureSource &sourceA, const QgsFeat
   requestB.setNoAttributes();
   if ( outputAttrs != OutputBA )
     requestB.setDestinationCrs( sourceA.sourceCrs(), context.transformContext() );
-  QgsSpatialIndex indexB( sourceB.getFeatures( requestB ), feedback );
+  QgsSpatialIndex indexB( sourceB.getFeatures( requestB ), feedback, QgsSpatialIndex::FlagStaticIndex );
 
   int fieldsCountA = sourceA.fields().count();
   int fieldsCountB = sourceB.fields().count();
-  QgsAttributes attrs;
-  attrs.resize( outputAttrs == OutputA ? fieldsCountA : ( fieldsCountA + fieldsCountB ) );
-
-  if ( totalCount == 0 )
-    totalCount = 1;  // avoid division by zero
+  const int attrCount = outputAttrs == OutputA ? fieldsCountA : ( fieldsCountA + fieldsCountB );
 
-  QgsFeature featA;
   QgsFeatureRequest requestA;
   requestA.setInvalidGeometryCheck( context.invalidGeometryCheck() );
   if ( outputAttrs == OutputBA )
     requestA.setDestinationCrs( sourceB.sourceCrs(), context.transformContext() );
   QgsFeatureIterator fitA = sourceA.getFeatures( requestA );
-  while ( fitA.nextFeature( featA ) )
-  {
-    if ( feedback->isCanceled() )
-      break;
 
-    if ( featA.hasGeometry() )
+  auto overlay = [geometryType, fieldsCountA, fieldsCountB, attrCount, outputAttrs]( const QgsFeature & featA, const QList< QgsFeatureId > &candidatesB, const QHash< QgsFeatureId, QgsFeature > &featuresB )
+  {
+    QgsFeatureList output;
+    if ( !featA.hasGeometry() )
     {
-      QgsGeometry geom( featA.geometry() );
-      QgsFeatureIds intersects = qgis::listToSet( indexB.intersects( geom.boundingBox() ) );
+      // TODO: should we write out features that do not have geometry?
+      output << featA;
+      return output;
+    }
+
+    QgsGeometry geom( featA.geometry() );
 
-      QgsFeatureRequest request;
-      request.setFilterFids( intersects );
-      request.setNoAttributes();
-      if ( outputAttrs != OutputBA )
-        request.setDestinationCrs( sourceA.sourceCrs(), context.transformContext() );
+    std::unique_ptr< QgsGeometryEngine > engine;
+    QVector<QgsGeometry> geometriesB;
+    for ( QgsFeatureId idB : candidatesB )
+    {
+      auto featB = featuresB.constFind( idB );
+      if ( featB == featuresB.constEnd() )
+        continue;
 
-      std::unique_ptr< QgsGeometryEngine > engine;
-      if ( !intersects.isEmpty() )
+      if ( !engine )
       {
         // use prepared geometries for faster intersection tests
         engine.reset( QgsGeometry::createGeometryEngine( geom.constGet() ) );
         engine->prepareGeometry();
       }
 
-      QVector<QgsGeometry> geometriesB;
-      QgsFeature featB;
-      QgsFeatureIterator fitB = sourceB.getFeatures( request );
-      while ( fitB.nextFeature( featB ) )
-      {
-        if ( feedback->isCanceled() )
-          break;
-
-        if ( engine->intersects( featB.geometry().constGet() ) )
-          geometriesB << featB.geometry();
-      }
+      if ( engine->intersects( featB->geometry().constGet() ) )
+        geometriesB << featB->geometry();
+    }
 
-      if ( !geometriesB.isEmpty() )
+    if ( !geometriesB.isEmpty() )
+    {
+      QgsGeometry geomB = QgsGeometry::unaryUnion( geometriesB );
+      if ( !geomB.lastError().isEmpty() )
       {
-        QgsGeometry geomB = QgsGeometry::unaryUnion( geometriesB );
-        if ( !geomB.lastError().isEmpty() )
-        {
-          // This may happen if input geometries from a layer do not line up well (for example polygons
-          // that are nearly touching each other, but there is a very tiny overlap or gap at one of the edges).
-          // It is possible to get rid of this issue in two steps:
-          // 1. snap geometries with a small tolerance (e.g. 1cm) using QgsGeometrySnapperSingleSource
-          // 2. fix geometries (removes polygons collapsed to lines etc.) using MakeValid
-          throw QgsProcessingException( QStringLiteral( "%1\n\n%2" ).arg( QObject::tr( "GEOS geoprocessing error: unary union failed." ), geomB.lastError() ) );
-        }
-        geom = geom.difference( geomB );
+        // This may happen if input geometries from a layer do not line up well (for example polygons
+        // that are nearly touching each other, but there is a very tiny overlap or gap at one of the edges).
+        // It is possible to get rid of this issue in two steps:
+        // 1. snap geometries with a small tolerance (e.g. 1cm) using QgsGeometrySnapperSingleSource
+        // 2. fix geometries (removes polygons collapsed to lines etc.) using MakeValid
+        throw QgsProcessingException( QStringLiteral( "%1\n\n%2" ).arg( QObject::tr( "GEOS geoprocessing error: unary union failed." ), geomB.lastError() ) );
       }
+      geom = geom.difference( geomB );
+    }
 
-      if ( !sanitizeDifferenceResult( geom, geometryType ) )
-        continue;
-
-      const QgsAttributes attrsA( featA.attributes() );
-      switch ( outputAttrs )
-      {
-        case OutputA:
-          attrs = attrsA;
-          break;
-        case OutputAB:
-          for ( int i = 0; i < fieldsCountA; ++i )
-            attrs[i] = attrsA[i];
-          break;
-        case OutputBA:
-          for ( int i = 0; i < fieldsCountA; ++i )
-            attrs[i + fieldsCountB] = attrsA[i];
-          break;
-      }
+    if ( !sanitizeDifferenceResult( geom, geometryType ) )
+      return output;
 
-      QgsFeature outFeat;
-      outFeat.setGeometry( geom );
-      outFeat.setAttributes( attrs );
-      sink.addFeature( outFeat, QgsFeatureSink::FastInsert );
-    }
-    else
+    QgsAttributes attrs( attrCount );
+    const QgsAttributes attrsA( featA.attributes() );
+    switch ( outputAttrs )
     {
-      // TODO: should we write out features that do not have geometry?
-      sink.addFeature( featA, QgsFeatureSink::FastInsert );
+      case OutputA:
+        attrs = attrsA;
+        break;
+      case OutputAB:
+        for ( int i = 0; i < fieldsCountA; ++i )
+          attrs[i] = attrsA[i];
+        break;
+      case OutputBA:
+        for ( int i = 0; i < fieldsCountA; ++i )
+          attrs[i + fieldsCountB] = attrsA[i];
+        break;
     }
 
-    ++count;
-    feedback->setProgress( count / ( double ) totalCount * 100. );
-  }
+    QgsFeature outFeat;
+    outFeat.setGeometry( geom );
+    outFeat.setAttributes( attrs );
+    output << outFeat;
+    return output;
+  };
+
+  overlayFeatures( fitA, indexB, sourceB, requestB, sink, feedback, count, totalCount, overlay );
 }
 
 
@@ -201,32 +294,24 @@ void QgsOverlayUtils::intersection( const QgsFeatureSource &sourceA, const QgsFe
   request.setNoAttributes();
   request.setDestinationCrs( sourceA.sourceCrs(), context.transformContext() );
 
-  QgsFeature outFeat;
-  QgsSpatialIndex indexB( sourceB.getFeatures( request ), feedback );
+  QgsSpatialIndex indexB( sourceB.getFeatures( request ), feedback, QgsSpatialIndex::FlagStaticIndex );
 
-  if ( totalCount == 0 )
-    totalCount = 1;  // avoid division by zero
+  QgsFeatureRequest requestB;
+  requestB.setDestinationCrs( sourceA.sourceCrs(), context.transformContext() );
+  requestB.setSubsetOfAttributes( fieldIndicesB );
 
-  QgsFeature featA;
   QgsFeatureIterator fitA = sourceA.getFeatures( QgsFeatureRequest().setSubsetOfAttributes( fieldIndicesA ) );
-  while ( fitA.nextFeature( featA ) )
-  {
-    if ( feedback->isCanceled() )
-      break;
 
+  auto overlay = [geometryType, attrCount, &fieldIndicesA, &fieldIndicesB]( const QgsFeature & featA, const QList< QgsFeatureId > &candidatesB, const QHash< QgsFeatureId, QgsFeature > &featuresB )
+  {
+    QgsFeatureList output;
     if ( !featA.hasGeometry() )
-      continue;
+      return output;
 
     QgsGeometry geom( featA.geometry() );
-    QgsFeatureIds intersects = qgis::listToSet( indexB.intersects( geom.boundingBox() ) );
-
-    QgsFeatureRequest request;
-    request.setFilterFids( intersects );
-    request.setDestinationCrs( sourceA.sourceCrs(), context.transformContext() );
-    request.setSubsetOfAttributes( fieldIndicesB );
 
     std::unique_ptr< QgsGeometryEngine > engine;
-    if ( !intersects.isEmpty() )
+    if ( !candidatesB.isEmpty() )
     {
       // use prepared geometries for faster intersection tests
       engine.reset( QgsGeometry::createGeometryEngine( geom.constGet() ) );
@@ -238,14 +323,13 @@ void QgsOverlayUtils::intersection( const QgsFeatureSource &sourceA, const QgsFe
     for ( int i = 0; i < fieldIndicesA.count(); ++i )
       outAttributes[i] = attrsA[fieldIndicesA[i]];
 
-    QgsFeature featB;
-    QgsFeatureIterator fitB = sourceB.getFeatures( request );
-    while ( fitB.nextFeature( featB ) )
+    for ( QgsFeatureId idB : candidatesB )
     {
-      if ( feedback->isCanceled() )
-        break;
+      auto featB = featuresB.constFind( idB );
+      if ( featB == featuresB.constEnd() )
+        continue;
 
-      QgsGeometry tmpGeom( featB.geometry() );
+      QgsGeometry tmpGeom( featB->geometry() );
       if ( !engine->intersects( tmpGeom.constGet() ) )
         continue;
 
@@ -253,18 +337,19 @@ void QgsOverlayUtils::intersection( const QgsFeatureSource &sourceA, const QgsFe
       if ( !sanitizeIntersectionResult( intGeom, geometryType ) )
         continue;
 
-      const QgsAttributes attrsB( featB.attributes() );
+      const QgsAttributes attrsB( featB->attributes() );
       for ( int i = 0; i < fieldIndicesB.count(); ++i )
         outAttributes[fieldIndicesA.count() + i] = attrsB[fieldIndicesB[i]];
 
+      QgsFeature outFeat;
       outFeat.setGeometry( intGeom );
       outFeat.setAttributes( outAttributes );
-      sink.addFeature( outFeat, QgsFeatureSink::FastInsert );
+      output << outFeat;
     }
+    return output;
+  };
 
-    ++count;
-    feedback->setProgress( count / ( double ) totalCount * 100. );
-  }
+  overlayFeatures( fitA, indexB, sourceB, requestB, sink, feedback, count, totalCount, overlay );
 }
 
 void QgsOverlayUtils::resolveOverlaps( const QgsFeatureSource &source, QgsFeatureSink &sink, QgsProcessingFeedback *feedback )
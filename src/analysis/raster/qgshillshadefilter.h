@@ -35,6 +35,8 @@ class ANALYSIS_EXPORT QgsHillshadeFilter: public QgsDerivativeFilter
                                  float *x12, float *x22, float *x32,
                                  float *x13, float *x23, float *x33 ) override;
 
+    bool isThreadSafe() const override { return true; }
+
     float lightAzimuth() const { return mLightAzimuth; }
     void setLightAzimuth( float azimuth );
     float lightAngle() const { return mLightAngle; }
@@ -30,7 +30,12 @@
 #include <QFile>
 #include <QDebug>
 #include <QFileInfo>
+#include <QThread>
+#include <QtConcurrentMap>
+#include <algorithm>
 #include <iterator>
+#include <numeric>
+#include <vector>
 
 
 
@@ -401,16 +406,52 @@ int QgsNineCellFilter::processRasterCPU( QgsFeedback *feedback )
     return 6;
   }
 
-  //keep only three scanlines in memory at a time, make room for initial and final nodata
-  std::size_t bufferSize( sizeof( float ) * ( xSize + 2 ) );
-  float *scanLine1 = ( float * ) CPLMalloc( bufferSize );
-  float *scanLine2 = ( float * ) CPLMalloc( bufferSize );
-  float *scanLine3 = ( float * ) CPLMalloc( bufferSize );
-
-  float *resultLine = ( float * ) CPLMalloc( sizeof( float ) * xSize );
+  // rows are filtered by bands, read at once along with the rows above and below the band,
+  // and make room for initial and final nodata columns
+  const std::size_t paddedXSize = static_cast< std::size_t >( xSize ) + 2;
+
+  int blockXSize = 0;
+  int blockYSize = 0;
+  GDALGetBlockSize( rasterBand, &blockXSize, &blockYSize );
+  blockYSize = std::max( blockYSize, 1 );
+  const bool parallel = isThreadSafe() && QThread::idealThreadCount() > 1;
+  // enough rows to keep every thread busy
+  const int minimumBandRows = parallel ? 16 * QThread::idealThreadCount() : 1;
+  // the input and result buffers of a band are limited in size, whatever the block height, as rasters
+  // stored in a single strip have a single block
+  const std::size_t maximumBandBytes = 64 * 1024 * 1024;
+  const std::size_t rowBytes = ( paddedXSize + static_cast< std::size_t >( xSize ) ) * sizeof( float );
+  const int maximumBandRows = static_cast< int >( std::max< std::size_t >( std::min< std::size_t >( maximumBandBytes / rowBytes, ySize ), 1 ) );
+  int bandRows = std::min( minimumBandRows, maximumBandRows );
+  // read whole GDAL blocks when they fit within the limit
+  const int blockBandRows = ( ( bandRows + blockYSize - 1 ) / blockYSize ) * blockYSize;
+  if ( blockBandRows <= maximumBandRows )
+    bandRows = blockBandRows;
+  bandRows = std::min( bandRows, ySize );
 
   //values outside the layer extent (if the 3x3 window is on the border) are sent to the processing method as (input) nodata values
-  for ( int yIndex = 0; yIndex < ySize; ++yIndex )
+  std::vector< float > input( paddedXSize * ( bandRows + 2 ), mInputNodataValue );
+  std::vector< float > result( static_cast< std::size_t >( xSize ) * bandRows );
+
+  auto filterRow = [this, &input, &result, paddedXSize, xSize]( int row )
+  {
+    float *scanLine1 = input.data() + row * paddedXSize;
+    float *scanLine2 = scanLine1 + paddedXSize;
+    float *scanLine3 = scanLine2 + paddedXSize;
+    float *resultLine = result.data() + static_cast< std::size_t >( row ) * xSize;
+
+    // j is the x axis index, skip 0 and last cell that have been filled with nodata
+    for ( int xIndex = 0; xIndex < xSize ; ++xIndex )
+    {
+      // cells(x, y) x11, x21, x31, x12, x22, x32, x13, x23, x33
+      resultLine[ xIndex ] = processNineCellWindow( &scanLine1[ xIndex ], &scanLine1[ xIndex + 1 ], &scanLine1[ xIndex + 2 ],
+                             &scanLine2[ xIndex ], &scanLine2[ xIndex + 1 ], &scanLine2[ xIndex + 2 ],
+                             &scanLine3[ xIndex ], &scanLine3[ xIndex + 1 ], &scanLine3[ xIndex + 2 ] );
+    }
+  };
+
+  std::vector< int > rows;
+  for ( int bandStart = 0; bandStart < ySize; bandStart += bandRows )
   {
     if ( feedback && feedback->isCanceled() )
     {
@@ -419,74 +460,44 @@ int QgsNineCellFilter::processRasterCPU( QgsFeedback *feedback )
 
     if ( feedback )
     {
-      feedback->setProgress( 100.0 * static_cast< double >( yIndex ) / ySize );
+      feedback->setProgress( 100.0 * static_cast< double >( bandStart ) / ySize );
     }
 
-    if ( yIndex == 0 )
+    const int rowCount = std::min( bandRows, ySize - bandStart );
+
+    // the first line of the buffer is the row above the band, and keeps its nodata values for the first band
+    const int readStart = std::max( bandStart - 1, 0 );
+    const int readEnd = std::min( bandStart + rowCount + 1, ySize );
+    float *readLine = input.data() + ( readStart - bandStart + 1 ) * paddedXSize + 1;
+    if ( GDALRasterIO( rasterBand, GF_Read, 0, readStart, xSize, readEnd - readStart, readLine, xSize, readEnd - readStart, GDT_Float32,
+                       sizeof( float ), static_cast< GSpacing >( paddedXSize * sizeof( float ) ) ) != CE_None )
     {
-      //fill scanline 1 with (input) nodata for the values above the first row and feed scanline2 with the first row
-      for ( int a = 0; a < xSize + 2 ; ++a )
-      {
-        scanLine1[a] = mInputNodataValue;
-      }
-      // Read scanline2
-      if ( GDALRasterIO( rasterBand, GF_Read, 0, 0, xSize, 1, &scanLine2[1], xSize, 1, GDT_Float32, 0, 0 ) != CE_None )
-      {
-        QgsDebugMsg( QStringLiteral( "Raster IO Error" ) );
-      }
+      QgsDebugMsg( QStringLiteral( "Raster IO Error" ) );
     }
-    else
+
+    if ( readEnd == ySize ) //fill the row below the bottom with nodata values
     {
-      //normally fetch only scanLine3 and release scanline 1 if we move forward one row
-      CPLFree( scanLine1 );
-      scanLine1 = scanLine2;
-      scanLine2 = scanLine3;
-      scanLine3 = ( float * ) CPLMalloc( bufferSize );
+      std::fill_n( input.data() + ( rowCount + 1 ) * paddedXSize, paddedXSize, mInputNodataValue );
     }
 
-    // Read scanline 3
-    if ( yIndex == ySize - 1 ) //fill the row below the bottom with nodata values
+    if ( parallel )
     {
-      for ( int a = 0; a < xSize + 2; ++a )
-      {
-        scanLine3[a] = mInputNodataValue;
-      }
+      rows.resize( rowCount );
+      std::iota( rows.begin(), rows.end(), 0 );
+      QtConcurrent::blockingMap( rows, filterRow );
     }
     else
     {
-      if ( GDALRasterIO( rasterBand, GF_Read, 0, yIndex + 1, xSize, 1, &scanLine3[1], xSize, 1, GDT_Float32, 0, 0 ) != CE_None )
-      {
-        QgsDebugMsg( QStringLiteral( "Raster IO Error" ) );
-      }
+      for ( int row = 0; row < rowCount; ++row )
+        filterRow( row );
     }
-    // Set first and last extra columns to nodata
-    scanLine1[0] = scanLine1[xSize + 1] = mInputNodataValue;
-    scanLine2[0] = scanLine2[xSize + 1] = mInputNodataValue;
-    scanLine3[0] = scanLine3[xSize + 1] = mInputNodataValue;
-
 
-
-    // j is the x axis index, skip 0 and last cell that have been filled with nodata
-    for ( int xIndex = 0; xIndex < xSize ; ++xIndex )
-    {
-      // cells(x, y) x11, x21, x31, x12, x22, x32, x13, x23, x33
-      resultLine[ xIndex ] = processNineCellWindow( &scanLine1[ xIndex ], &scanLine1[ xIndex + 1 ], &scanLine1[ xIndex + 2 ],
-                             &scanLine2[ xIndex ], &scanLine2[ xIndex + 1 ], &scanLine2[ xIndex + 2 ],
-                             &scanLine3[ xIndex ], &scanLine3[ xIndex + 1 ], &scanLine3[ xIndex + 2 ] );
-
-    }
-
-    if ( GDALRasterIO( outputRasterBand, GF_Write, 0, yIndex, xSize, 1, resultLine, xSize, 1, GDT_Float32, 0, 0 ) != CE_None )
+    if ( GDALRasterIO( outputRasterBand, GF_Write, 0, bandStart, xSize, rowCount, result.data(), xSize, rowCount, GDT_Float32, 0, 0 ) != CE_None )
     {
       QgsDebugMsg( QStringLiteral( "Raster IO Error" ) );
     }
   }
 
-  CPLFree( resultLine );
-  CPLFree( scanLine1 );
-  CPLFree( scanLine2 );
-  CPLFree( scanLine3 );
-
   if ( feedback && feedback->isCanceled() )
   {
     //delete the dataset without closing (because it is faster)
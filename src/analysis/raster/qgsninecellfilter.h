@@ -80,6 +80,16 @@ class ANALYSIS_EXPORT QgsNineCellFilter
                                          float *x12, float *x22, float *x32,
                                          float *x13, float *x23, float *x33 ) = 0;
 
+    /**
+     * Returns TRUE if processNineCellWindow() can safely be called from several threads at once,
+     * in which case the rows of the raster are filtered in parallel.
+     *
+     * The default implementation returns FALSE.
+     *
+     * \since QGIS 3.18
+     */
+    virtual bool isThreadSafe() const { return false; }
+
   private:
     //default constructor forbidden. We need input file, output file and format obligatory
     QgsNineCellFilter() = delete;
@@ -101,6 +111,10 @@ class ANALYSIS_EXPORT QgsNineCellFilter
 
     /**
      * \brief processRasterCPU executes the computation on the CPU
+     *
+     * Rows are read and written by bands of whole GDAL blocks, and the rows of each band are filtered
+     * concurrently if the filter isThreadSafe().
+     *
      * \param feedback instance of QgsFeedback, to allow for progress monitoring and cancellation
      * \return an opaque integer for error codes: 0 in case of success
      */
@@ -0,0 +1,291 @@
+/***************************************************************************
+                          qgsrastercalckernel.cpp
+                          -----------------------
+    begin                : February 2021
+    copyright            : (C) 2021 by QGIS.org
+    email                : info at qgis dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsrastercalckernel.h"
+#include "qgsrasterblock.h"
+
+#include <algorithm>
+#include <cmath>
+
+//! Number of cells computed by each instruction of the program at once
+static const int CHUNK_SIZE = 256;
+
+std::unique_ptr< QgsRasterCalcKernel > QgsRasterCalcKernel::compile( const QgsRasterCalcNode &node )
+{
+  std::unique_ptr< QgsRasterCalcKernel > kernel( new QgsRasterCalcKernel() );
+  int stackDepth = 0;
+  if ( !kernel->compileNode( &node, stackDepth ) )
+    return nullptr;
+
+  return kernel;
+}
+
+bool QgsRasterCalcKernel::compileNode( const QgsRasterCalcNode *node, int &stackDepth )
+{
+  if ( !node )
+    return false;
+
+  Instruction instruction;
+  switch ( node->mType )
+  {
+    case QgsRasterCalcNode::tNumber:
+      instruction.type = Instruction::Number;
+      instruction.number = node->mNumber;
+      break;
+
+    case QgsRasterCalcNode::tRasterRef:
+      instruction.type = Instruction::Input;
+      instruction.input = mRasterReferences.indexOf( node->mRasterName );
+      if ( instruction.input < 0 )
+      {
+        instruction.input = mRasterReferences.size();
+        mRasterReferences << node->mRasterName;
+      }
+      break;
+
+    case QgsRasterCalcNode::tOperator:
+    {
+      switch ( node->mOperator )
+      {
+        case QgsRasterCalcNode::opSQRT:
+        case QgsRasterCalcNode::opSIN:
+        case QgsRasterCalcNode::opCOS:
+        case QgsRasterCalcNode::opTAN:
+        case QgsRasterCalcNode::opASIN:
+        case QgsRasterCalcNode::opACOS:
+        case QgsRasterCalcNode::opATAN:
+        case QgsRasterCalcNode::opSIGN:
+        case QgsRasterCalcNode::opLOG:
+        case QgsRasterCalcNode::opLOG10:
+        case QgsRasterCalcNode::opABS:
+          if ( !compileNode( node->mLeft, stackDepth ) )
+            return false;
+          break;
+
+        case QgsRasterCalcNode::opNONE:
+          return false;
+
+        default:
+          if ( !compileNode( node->mLeft, stackDepth ) || !compileNode( node->mRight, stackDepth ) )
+            return false;
+          // the two operands are replaced by the result
+          stackDepth--;
+          break;
+      }
+      instruction.type = Instruction::Operator;
+      instruction.op = node->mOperator;
+      mProgram.push_back( instruction );
+      return true;
+    }
+
+    case QgsRasterCalcNode::tMatrix:
+      return false;
+  }
+
+  mProgram.push_back( instruction );
+  stackDepth++;
+  mStackSize = std::max( mStackSize, stackDepth );
+  return true;
+}
+
+//! Returns the result of a two argument operator for valid values, as QgsRasterMatrix computes it
+static inline double calculateTwoArgumentOp( QgsRasterCalcNode::Operator op, double arg1, double arg2, double nodataValue )
+{
+  switch ( op )
+  {
+    case QgsRasterCalcNode::opPLUS:
+      return arg1 + arg2;
+    case QgsRasterCalcNode::opMINUS:
+      return arg1 - arg2;
+    case QgsRasterCalcNode::opMUL:
+      return arg1 * arg2;
+    case QgsRasterCalcNode::opDIV:
+      return arg2 == 0 ? nodataValue : arg1 / arg2;
+    case QgsRasterCalcNode::opPOW:
+      // no complex numbers
+      if ( ( arg1 == 0 && arg2 < 0 ) || ( arg1 < 0 && ( arg2 - std::floor( arg2 ) ) > 0 ) )
+        return nodataValue;
+      return std::pow( arg1, arg2 );
+    case QgsRasterCalcNode::opEQ:
+      return arg1 == arg2 ? 1.0 : 0.0;
+    case QgsRasterCalcNode::opNE:
+      return arg1 == arg2 ? 0.0 : 1.0;
+    case QgsRasterCalcNode::opGT:
+      return arg1 > arg2 ? 1.0 : 0.0;
+    case QgsRasterCalcNode::opLT:
+      return arg1 < arg2 ? 1.0 : 0.0;
+    case QgsRasterCalcNode::opGE:
+      return arg1 >= arg2 ? 1.0 : 0.0;
+    case QgsRasterCalcNode::opLE:
+      return arg1 <= arg2 ? 1.0 : 0.0;
+    case QgsRasterCalcNode::opAND:
+      return arg1 && arg2 ? 1.0 : 0.0;
+    case QgsRasterCalcNode::opOR:
+      return arg1 || arg2 ? 1.0 : 0.0;
+    case QgsRasterCalcNode::opMAX:
+      return std::max( arg1, arg2 );
+    case QgsRasterCalcNode::opMIN:
+      return std::min( arg1, arg2 );
+    default:
+      break;
+  }
+  return nodataValue;
+}
+
+//! Returns the result of a one argument operator for a valid value, as QgsRasterMatrix computes it
+static inline double calculateOneArgumentOp( QgsRasterCalcNode::Operator op, double value, double nodataValue )
+{
+  switch ( op )
+  {
+    case QgsRasterCalcNode::opSQRT:
+      return value < 0 ? nodataValue : std::sqrt( value );
+    case QgsRasterCalcNode::opSIN:
+      return std::sin( value );
+    case QgsRasterCalcNode::opCOS:
+      return std::cos( value );
+    case QgsRasterCalcNode::opTAN:
+      return std::tan( value );
+    case QgsRasterCalcNode::opASIN:
+      return std::asin( value );
+    case QgsRasterCalcNode::opACOS:
+      return std::acos( value );
+    case QgsRasterCalcNode::opATAN:
+      return std::atan( value );
+    case QgsRasterCalcNode::opSIGN:
+      return -value;
+    case QgsRasterCalcNode::opLOG:
+      return value <= 0 ? nodataValue : std::log( value );
+    case QgsRasterCalcNode::opLOG10:
+      return value <= 0 ? nodataValue : std::log10( value );
+    case QgsRasterCalcNode::opABS:
+      return std::fabs( value );
+    default:
+      break;
+  }
+  return nodataValue;
+}
+
+//! Applies a two argument operator to \a count values, with a switch on the operator for the whole chunk
+template <typename Operation>
+static inline void applyTwoArgumentOp( double *left, const double *right, int count, double nodataValue, Operation operation )
+{
+  for ( int i = 0; i < count; ++i )
+  {
+    // operations with nodata values always generate nodata
+    left[i] = left[i] == nodataValue || right[i] == nodataValue ? nodataValue : operation( left[i], right[i] );
+  }
+}
+
+void QgsRasterCalcKernel::evaluate( const QVector< const QgsRasterBlock * > &inputs, qgssize offset, int count, float *result, double nodataValue ) const
+{
+  // the evaluation stack, holding a chunk of values for each level
+  std::vector< double > stack( static_cast< std::size_t >( mStackSize ) * CHUNK_SIZE );
+
+  for ( int chunkStart = 0; chunkStart < count; chunkStart += CHUNK_SIZE )
+  {
+    const int chunkSize = std::min( CHUNK_SIZE, count - chunkStart );
+    const qgssize chunkOffset = offset + chunkStart;
+    int depth = 0;
+
+    for ( const Instruction &instruction : mProgram )
+    {
+      switch ( instruction.type )
+      {
+        case Instruction::Input:
+        {
+          double *values = stack.data() + static_cast< std::size_t >( depth++ ) * CHUNK_SIZE;
+          const QgsRasterBlock *block = inputs.at( instruction.input );
+          bool isNoData = false;
+          for ( int i = 0; i < chunkSize; ++i )
+          {
+            const double value = block->valueAndNoData( chunkOffset + i, isNoData );
+            values[i] = isNoData ? nodataValue : value;
+          }
+          break;
+        }
+
+        case Instruction::Number:
+        {
+          double *values = stack.data() + static_cast< std::size_t >( depth++ ) * CHUNK_SIZE;
+          std::fill( values, values + chunkSize, instruction.number );
+          break;
+        }
+
+        case Instruction::Operator:
+        {
+          switch ( instruction.op )
+          {
+            case QgsRasterCalcNode::opSQRT:
+            case QgsRasterCalcNode::opSIN:
+            case QgsRasterCalcNode::opCOS:
+            case QgsRasterCalcNode::opTAN:
+            case QgsRasterCalcNode::opASIN:
+            case QgsRasterCalcNode::opACOS:
+            case QgsRasterCalcNode::opATAN:
+            case QgsRasterCalcNode::opSIGN:
+            case QgsRasterCalcNode::opLOG:
+            case QgsRasterCalcNode::opLOG10:
+            case QgsRasterCalcNode::opABS:
+            {
+              double *values = stack.data() + static_cast< std::size_t >( depth - 1 ) * CHUNK_SIZE;
+              for ( int i = 0; i < chunkSize; ++i )
+              {
+                if ( values[i] != nodataValue )
+                  values[i] = calculateOneArgumentOp( instruction.op, values[i], nodataValue );
+              }
+              break;
+            }
+
+            default:
+            {
+              depth--;
+              double *left = stack.data() + static_cast< std::size_t >( depth - 1 ) * CHUNK_SIZE;
+              const double *right = left + CHUNK_SIZE;
+              // the most common operators get loops of their own, which the compiler can vectorize
+              switch ( instruction.op )
+              {
+                case QgsRasterCalcNode::opPLUS:
+                  applyTwoArgumentOp( left, right, chunkSize, nodataValue, []( double a, double b ) { return a + b; } );
+                  break;
+                case QgsRasterCalcNode::opMINUS:
+                  applyTwoArgumentOp( left, right, chunkSize, nodataValue, []( double a, double b ) { return a - b; } );
+                  break;
+                case QgsRasterCalcNode::opMUL:
+                  applyTwoArgumentOp( left, right, chunkSize, nodataValue, []( double a, double b ) { return a * b; } );
+                  break;
+                case QgsRasterCalcNode::opDIV:
+                  applyTwoArgumentOp( left, right, chunkSize, nodataValue, [nodataValue]( double a, double b ) { return b == 0 ? nodataValue : a / b; } );
+                  break;
+                default:
+                {
+                  const QgsRasterCalcNode::Operator op = instruction.op;
+                  applyTwoArgumentOp( left, right, chunkSize, nodataValue, [op, nodataValue]( double a, double b ) { return calculateTwoArgumentOp( op, a, b, nodataValue ); } );
+                  break;
+                }
+              }
+              break;
+            }
+          }
+          break;
+        }
+      }
+    }
+
+    const double *values = stack.data();
+    std::copy( values, values + chunkSize, result + chunkStart );
+  }
+}
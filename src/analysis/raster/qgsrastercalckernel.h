@@ -0,0 +1,102 @@
+/***************************************************************************
+                          qgsrastercalckernel.h
+                          ---------------------
+    begin                : February 2021
+    copyright            : (C) 2021 by QGIS.org
+    email                : info at qgis dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSRASTERCALCKERNEL_H
+#define QGSRASTERCALCKERNEL_H
+
+#define SIP_NO_FILE
+
+#include "qgis_analysis.h"
+#include "qgis.h"
+#include "qgsrastercalcnode.h"
+
+#include <QStringList>
+#include <QVector>
+#include <memory>
+#include <vector>
+
+class QgsRasterBlock;
+
+/**
+ * \ingroup analysis
+ * \class QgsRasterCalcKernel
+ * A raster calculator expression compiled to a flat program, which computes the expression for
+ * many cells at once without building intermediate QgsRasterMatrix objects for each node.
+ *
+ * Cells are computed by chunks: each instruction of the program runs over a whole chunk of cells,
+ * in buffers which are reused for the whole evaluation.
+ *
+ * Results are identical to the ones of QgsRasterCalcNode::calculate(): nodata cells of the input
+ * rasters and invalid operations result in nodata cells.
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.18
+ */
+class ANALYSIS_EXPORT QgsRasterCalcKernel
+{
+  public:
+
+    /**
+     * Compiles the expression of a \a node.
+     *
+     * Returns nullptr if the expression can't be compiled, e.g. if it contains matrices.
+     */
+    static std::unique_ptr< QgsRasterCalcKernel > compile( const QgsRasterCalcNode &node );
+
+    /**
+     * Returns the names of the rasters referenced by the expression, in the order in which their
+     * blocks must be passed to evaluate().
+     */
+    QStringList rasterReferences() const { return mRasterReferences; }
+
+    /**
+     * Evaluates the expression for \a count cells, starting at the \a offset index of the \a inputs blocks,
+     * which must all have the same size. Results are written to \a result, with \a nodataValue for nodata cells.
+     *
+     * This method is thread safe, evaluations can run concurrently.
+     */
+    void evaluate( const QVector< const QgsRasterBlock * > &inputs, qgssize offset, int count, float *result, double nodataValue ) const;
+
+  private:
+
+    QgsRasterCalcKernel() = default;
+
+    //! Appends the instructions of a \a node to the program, returns FALSE if it can't be compiled
+    bool compileNode( const QgsRasterCalcNode *node, int &stackDepth );
+
+    struct Instruction
+    {
+      enum Type
+      {
+        Input, //!< Pushes the values of an input raster
+        Number, //!< Pushes a number
+        Operator, //!< Replaces the top value(s) by the result of an operator
+      };
+
+      Type type = Number;
+      //! Index of the input raster
+      int input = -1;
+      double number = 0;
+      QgsRasterCalcNode::Operator op = QgsRasterCalcNode::opNONE;
+    };
+
+    std::vector< Instruction > mProgram;
+    QStringList mRasterReferences;
+    int mStackSize = 0;
+};
+
+#endif // QGSRASTERCALCKERNEL_H
@@ -137,6 +137,8 @@ class ANALYSIS_EXPORT QgsRasterCalcNode
     QgsRasterMatrix *mMatrix = nullptr;
     Operator mOperator = opNONE;
 
+    friend class QgsRasterCalcKernel;
+
 };
 
 
@@ -17,6 +17,7 @@
 
 #include "qgsgdalutils.h"
 #include "qgsrastercalculator.h"
+#include "qgsrastercalckernel.h"
 #include "qgsrasterdataprovider.h"
 #include "qgsrasterinterface.h"
 #include "qgsrasterlayer.h"
@@ -27,7 +28,9 @@
 #include "qgsproject.h"
 
 #include <QFile>
+#include <QtConcurrentMap>
 
+#include <algorithm>
 #include <cpl_string.h>
 #include <gdalwarper.h>
 
@@ -160,93 +163,146 @@ QgsRasterCalculator::Result QgsRasterCalculator::processCalculation( QgsFeedback
   GDALSetRasterNoDataValue( outputRasterBand, outputNodataValue );
 
 
-  // Take the fast route (process one line at a time) if we can
+  // Take the fast route (process a strip of rows at a time) if we can
   if ( ! requiresMatrix )
   {
-    // Map of raster names -> blocks
-    std::map<QString, std::unique_ptr<QgsRasterBlock>> inputBlocks;
-    std::map<QString, QgsRasterCalculatorEntry> uniqueRasterEntries;
-    const QList<const QgsRasterCalcNode *> rasterRefNodes = calcNode->findNodes( QgsRasterCalcNode::Type::tRasterRef );
-    for ( const QgsRasterCalcNode *r : rasterRefNodes )
+    // the expression is compiled to a single program, computed concurrently over chunks of the strips
+    std::unique_ptr< QgsRasterCalcKernel > kernel = QgsRasterCalcKernel::compile( *calcNode );
+    if ( !kernel )
     {
-      QString layerRef( r->toString().remove( 0, 1 ) );
-      layerRef.chop( 1 );
-      if ( ! inputBlocks.count( layerRef ) )
-      {
-        for ( const QgsRasterCalculatorEntry &ref : qgis::as_const( mRasterEntries ) )
-        {
-          if ( ref.ref == layerRef )
-          {
-            uniqueRasterEntries[layerRef] = ref;
-            inputBlocks[layerRef ] = qgis::make_unique<QgsRasterBlock>();
-          }
-        }
-      }
+      gdal::fast_delete_and_close( outputDataset, outputDriver, mOutputFile );
+      return CalculationError;
     }
 
-    //read / write line by line
-    QMap<QString, QgsRasterBlock * > _rasterData;
-    // Cast to float
-    std::vector<float> castedResult( static_cast<size_t>( mNumOutputColumns ), 0 );
-    auto rowHeight = mOutputRectangle.height() / mNumOutputRows;
-    for ( size_t row = 0; row < static_cast<size_t>( mNumOutputRows ); ++row )
+    // entries of the rasters used by the kernel, in the order of its inputs
+    QVector< QgsRasterCalculatorEntry > kernelEntries;
+    const QStringList rasterReferences = kernel->rasterReferences();
+    for ( const QString &layerRef : rasterReferences )
     {
-      if ( feedback )
+      auto entry = std::find_if( mRasterEntries.constBegin(), mRasterEntries.constEnd(), [&layerRef]( const QgsRasterCalculatorEntry & e ) { return e.ref == layerRef; } );
+      if ( entry == mRasterEntries.constEnd() )
       {
-        feedback->setProgress( 100.0 * static_cast< double >( row ) / mNumOutputRows );
+        QgsDebugMsg( QStringLiteral( "Error: could not find raster data for \"%1\"" ).arg( layerRef ) );
+        gdal::fast_delete_and_close( outputDataset, outputDriver, mOutputFile );
+        return CalculationError;
       }
+      kernelEntries << *entry;
+    }
 
-      if ( feedback && feedback->isCanceled() )
-      {
-        break;
-      }
+    // about a million cells per strip
+    const int stripRows = std::max( 1, std::min( mNumOutputRows, 1024 * 1024 / std::max( mNumOutputColumns, 1 ) ) );
+    const double rowHeight = mOutputRectangle.height() / mNumOutputRows;
+    const int chunkSize = 16384;
+
+    struct Strip
+    {
+      int firstRow = 0;
+      int rowCount = 0;
+      std::vector< std::unique_ptr< QgsRasterBlock > > blocks;
+      QVector< const QgsRasterBlock * > inputs;
+      std::vector< qgssize > chunkOffsets;
+      std::vector< float > result;
+    };
+
+    auto readStrip = [&]( int firstRow ) -> std::unique_ptr< Strip >
+    {
+      std::unique_ptr< Strip > strip = qgis::make_unique< Strip >();
+      strip->firstRow = firstRow;
+      strip->rowCount = std::min( stripRows, mNumOutputRows - firstRow );
 
-      // Calculates the rect for a single row read
+      // Calculates the rect for the rows of the strip
       QgsRectangle rect( mOutputRectangle );
-      rect.setYMaximum( rect.yMaximum() - rowHeight * row );
-      rect.setYMinimum( rect.yMaximum() - rowHeight );
+      rect.setYMaximum( rect.yMaximum() - rowHeight * firstRow );
+      rect.setYMinimum( rect.yMaximum() - rowHeight * strip->rowCount );
 
-      // Read rows into input blocks
-      for ( auto &layerRef : inputBlocks )
+      for ( const QgsRasterCalculatorEntry &ref : qgis::as_const( kernelEntries ) )
       {
-        QgsRasterCalculatorEntry ref = uniqueRasterEntries[layerRef.first];
+        std::unique_ptr< QgsRasterBlock > block;
         if ( ref.raster->crs() != mOutputCrs )
         {
           QgsRasterProjector proj;
           proj.setCrs( ref.raster->crs(), mOutputCrs, mTransformContext );
           proj.setInput( ref.raster->dataProvider() );
           proj.setPrecision( QgsRasterProjector::Exact );
-          layerRef.second.reset( proj.block( ref.bandNumber, rect, mNumOutputColumns, 1 ) );
+          block.reset( proj.block( ref.bandNumber, rect, mNumOutputColumns, strip->rowCount ) );
         }
         else
         {
-          layerRef.second.reset( ref.raster->dataProvider()->block( ref.bandNumber, rect, mNumOutputColumns, 1 ) );
+          block.reset( ref.raster->dataProvider()->block( ref.bandNumber, rect, mNumOutputColumns, strip->rowCount ) );
         }
+        if ( !block || block->isEmpty() )
+          return nullptr;
+
+        strip->inputs << block.get();
+        strip->blocks.emplace_back( std::move( block ) );
       }
 
-      // 1 row X mNumOutputColumns matrix
-      QgsRasterMatrix resultMatrix( mNumOutputColumns, 1, nullptr, outputNodataValue );
+      const qgssize cellCount = static_cast< qgssize >( mNumOutputColumns ) * strip->rowCount;
+      for ( qgssize offset = 0; offset < cellCount; offset += chunkSize )
+        strip->chunkOffsets.push_back( offset );
+      strip->result.resize( cellCount );
+      return strip;
+    };
 
-      _rasterData.clear();
-      for ( const auto &layerRef : inputBlocks )
+    auto writeStrip = [&]( const Strip &strip )
+    {
+      if ( GDALRasterIO( outputRasterBand, GF_Write, 0, strip.firstRow, mNumOutputColumns, strip.rowCount, const_cast< float * >( strip.result.data() ),
+                         mNumOutputColumns, strip.rowCount, GDT_Float32, 0, 0 ) != CE_None )
       {
-        _rasterData.insert( layerRef.first, layerRef.second.get() );
+        QgsDebugMsg( QStringLiteral( "RasterIO error!" ) );
       }
+    };
 
-      if ( calcNode->calculate( _rasterData, resultMatrix, 0 ) )
+    // Reading the next strip and writing the previous one happen while a strip is computed
+    std::unique_ptr< Strip > current = readStrip( 0 );
+    std::unique_ptr< Strip > previous;
+    for ( int firstRow = 0; firstRow < mNumOutputRows; firstRow += stripRows )
+    {
+      if ( feedback )
       {
-        std::copy( resultMatrix.data(), resultMatrix.data() + mNumOutputColumns, castedResult.begin() );
-        if ( GDALRasterIO( outputRasterBand, GF_Write, 0, row, mNumOutputColumns, 1, castedResult.data(), mNumOutputColumns, 1, GDT_Float32, 0, 0 ) != CE_None )
-        {
-          QgsDebugMsg( QStringLiteral( "RasterIO error!" ) );
-        }
+        feedback->setProgress( 100.0 * static_cast< double >( firstRow ) / mNumOutputRows );
       }
-      else
+
+      if ( feedback && feedback->isCanceled() )
       {
-        //delete the dataset without closing (because it is faster)
+        break;
+      }
+
+      if ( !current )
+      {
+        mLastError = QObject::tr( "Could not allocate required memory for %1" ).arg( mFormulaString );
         gdal::fast_delete_and_close( outputDataset, outputDriver, mOutputFile );
-        return CalculationError;
+        return MemoryError;
       }
+
+      Strip *strip = current.get();
+      const qgssize cellCount = strip->result.size();
+      const QgsRasterCalcKernel *stripKernel = kernel.get();
+      QFuture< void > computation = QtConcurrent::map( strip->chunkOffsets, [strip, stripKernel, cellCount, chunkSize, outputNodataValue]( qgssize offset )
+      {
+        const int count = static_cast< int >( std::min( static_cast< qgssize >( chunkSize ), cellCount - offset ) );
+        stripKernel->evaluate( strip->inputs, offset, count, strip->result.data() + offset, outputNodataValue );
+      } );
+
+      if ( previous )
+      {
+        writeStrip( *previous );
+        previous.reset();
+      }
+      std::unique_ptr< Strip > next;
+      if ( firstRow + stripRows < mNumOutputRows )
+      {
+        next = readStrip( firstRow + stripRows );
+      }
+
+      computation.waitForFinished();
+      previous = std::move( current );
+      current = std::move( next );
+    }
+
+    if ( previous && !( feedback && feedback->isCanceled() ) )
+    {
+      writeStrip( *previous );
     }
 
     if ( feedback )
@@ -32,6 +32,8 @@ class ANALYSIS_EXPORT QgsRuggednessFilter: public QgsNineCellFilter
   public:
     QgsRuggednessFilter( const QString &inputFile, const QString &outputFile, const QString &outputFormat );
 
+    bool isThreadSafe() const override { return true; }
+
   protected:
 
     float processNineCellWindow( float *x11, float *x21, float *x31,
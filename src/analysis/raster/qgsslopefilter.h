@@ -34,6 +34,8 @@ class ANALYSIS_EXPORT QgsSlopeFilter: public QgsDerivativeFilter
                                  float *x12, float *x22, float *x32,
                                  float *x13, float *x23, float *x33 ) override;
 
+    bool isThreadSafe() const override { return true; }
+
 
 #ifdef HAVE_OPENCL
   private:
@@ -30,6 +30,8 @@ class ANALYSIS_EXPORT QgsTotalCurvatureFilter: public QgsNineCellFilter
   public:
     QgsTotalCurvatureFilter( const QString &inputFile, const QString &outputFile, const QString &outputFormat );
 
+    bool isThreadSafe() const override { return true; }
+
   protected:
 
     float processNineCellWindow( float *x11, float *x21, float *x31,
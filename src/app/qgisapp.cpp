@@ -55,6 +55,7 @@
 #include <QShortcut>
 #include <QSpinBox>
 #include <QSplashScreen>
+#include <QStandardPaths>
 #ifndef QT_NO_SSL
 #include <QSslConfiguration>
 #endif
@@ -269,6 +270,7 @@ Q_GUI_EXPORT extern int qt_defaultDpiX();
 #include "qgsmapcanvasdockwidget.h"
 #include "qgsmapcanvassnappingutils.h"
 #include "qgsmapcanvastracer.h"
+#include "qgsmaprendererdiskcache.h"
 #include "qgsmaplayer.h"
 #include "qgsmaplayerstyleguiutils.h"
 #include "qgsmapoverviewcanvas.h"
@@ -2559,12 +2561,35 @@ void QgisApp::applyDefaultSettingsToCanvas( QgsMapCanvas *canvas )
   double zoomFactor = settings.value( QStringLiteral( "qgis/zoom_factor" ), 2 ).toDouble();
   canvas->setWheelFactor( zoomFactor );
   canvas->setCachingEnabled( settings.value( QStringLiteral( "qgis/enable_render_caching" ), true ).toBool() );
+  canvas->setDiskCache( mapRendererDiskCache() );
   canvas->setParallelRenderingEnabled( settings.value( QStringLiteral( "qgis/parallel_rendering" ), true ).toBool() );
   canvas->setMapUpdateInterval( settings.value( QStringLiteral( "qgis/map_update_interval" ), 250 ).toInt() );
   canvas->setSegmentationTolerance( settings.value( QStringLiteral( "qgis/segmentationTolerance" ), "0.01745" ).toDouble() );
   canvas->setSegmentationToleranceType( QgsAbstractGeometry::SegmentationToleranceType( settings.enumValue( QStringLiteral( "qgis/segmentationToleranceType" ), QgsAbstractGeometry::MaximumAngle ) ) );
 }
 
+QgsMapRendererDiskCache *QgisApp::mapRendererDiskCache()
+{
+  QgsSettings settings;
+  if ( !settings.value( QStringLiteral( "qgis/enable_render_disk_cache" ), false ).toBool() )
+    return nullptr;
+
+  const qint64 maximumSize = settings.value( QStringLiteral( "qgis/render_disk_cache_size" ), 256 * 1024 * 1024 ).toLongLong();
+  if ( mMapRendererDiskCache )
+  {
+    mMapRendererDiskCache->setMaximumSize( maximumSize );
+  }
+  else
+  {
+    // stored next to the network cache, in its own directory
+    QString cacheDirectory = settings.value( QStringLiteral( "cache/directory" ) ).toString();
+    if ( cacheDirectory.isEmpty() )
+      cacheDirectory = QStandardPaths::writableLocation( QStandardPaths::CacheLocation );
+    mMapRendererDiskCache = qgis::make_unique< QgsMapRendererDiskCache >( QDir( cacheDirectory ).filePath( QStringLiteral( "maprenderer" ) ), maximumSize );
+  }
+  return mMapRendererDiskCache.get();
+}
+
 int QgisApp::chooseReasonableDefaultIconSize() const
 {
   QScreen *screen = QApplication::screens().at( 0 );
@@ -68,6 +68,7 @@ class QgsMapCanvas;
 class QgsMapCanvasDockWidget;
 class QgsMapLayer;
 class QgsMapLayerConfigWidgetFactory;
+class QgsMapRendererDiskCache;
 class QgsMapOverviewCanvas;
 class QgsMapTip;
 class QgsMapTool;
@@ -2278,6 +2279,12 @@ class APP_EXPORT QgisApp : public QMainWindow, private Ui::MainWindow
      */
     void applyDefaultSettingsToCanvas( QgsMapCanvas *canvas );
 
+    /**
+     * Returns the disk cache of rendered layer images shared by all map canvases, or NULLPTR
+     * if it is disabled in the settings.
+     */
+    QgsMapRendererDiskCache *mapRendererDiskCache();
+
     /**
      * Configures positioning of a newly created dock widget.
      * The \a isFloating and \a dockGeometry arguments can be used to specify an initial floating state
@@ -2708,6 +2715,9 @@ class APP_EXPORT QgisApp : public QMainWindow, private Ui::MainWindow
 
     std::unique_ptr< QgsBearingNumericFormat > mBearingNumericFormat;
 
+    //! Disk cache of rendered layer images shared by all map canvases, kept until exit once created
+    std::unique_ptr< QgsMapRendererDiskCache > mMapRendererDiskCache;
+
     QgsNetworkLogger *mNetworkLogger = nullptr;
     QgsScopedDevToolWidgetFactory mNetworkLoggerWidgetFactory;
     QgsScopedDevToolWidgetFactory mStartupProfilerWidgetFactory;
@@ -24,6 +24,8 @@
 #include "qgsproject.h"
 #include "qgsexpressioncontextutils.h"
 #include "qgsexpression_p.h"
+#include "qgsexpressionbatchevaluator_p.h"
+#include "qgsfeaturebatch.h"
 
 // from parser
 extern QgsExpressionNode *parseExpression( const QString &str, QString &parserErrorMsg, QList<QgsExpression::ParserError> &parserErrors );
@@ -52,6 +54,7 @@ void QgsExpression::setExpression( const QString &expression )
   d->mEvalErrorString = QString();
   d->mExp = expression;
   d->mIsPrepared = false;
+  d->mProgram.reset();
 }
 
 QString QgsExpression::expression() const
@@ -324,6 +327,7 @@ bool QgsExpression::prepare( const QgsExpressionContext *context )
 {
   detach();
   d->mEvalErrorString = QString();
+  d->mProgram.reset();
   if ( !d->mRootNode )
   {
     //re-parse expression. Creation of QgsExpressionContexts may have added extra
@@ -340,7 +344,11 @@ bool QgsExpression::prepare( const QgsExpressionContext *context )
 
   initGeomCalculator( context );
   d->mIsPrepared = true;
-  return d->mRootNode->prepare( this, context );
+  if ( !d->mRootNode->prepare( this, context ) )
+    return false;
+
+  d->mProgram = QgsExpressionProgram::compile( d->mRootNode );
+  return true;
 }
 
 QVariant QgsExpression::evaluate()
@@ -368,9 +376,65 @@ QVariant QgsExpression::evaluate( const QgsExpressionContext *context )
   {
     prepare( context );
   }
+  if ( d->mProgram )
+    return d->mProgram->run( this, context );
+
   return d->mRootNode->eval( this, context );
 }
 
+QVector< QVariant > QgsExpression::evaluateBatch( const QgsFeatureBatch &batch, QgsExpressionContext *context, QVector< bool > *selection )
+{
+  const int count = batch.count();
+  QVector< QVariant > results( count );
+  if ( selection )
+    selection->fill( false, count );
+
+  // features which can't be evaluated at once are set on the context, so a context is needed even if none was given
+  QgsExpressionContext localContext;
+  if ( !context )
+    context = &localContext;
+
+  d->mEvalErrorString = QString();
+  if ( !d->mRootNode )
+  {
+    d->mEvalErrorString = tr( "No root node! Parsing failed?" );
+    return results;
+  }
+
+  if ( ! d->mIsPrepared )
+  {
+    prepare( context );
+  }
+
+  QVector< int > fallbackRows;
+  QgsExpressionBatchEvaluator evaluator( this, batch, context );
+  if ( !evaluator.evaluate( d->mRootNode, results, fallbackRows ) )
+  {
+    fallbackRows.clear();
+    fallbackRows.reserve( count );
+    for ( int row = 0; row < count; ++row )
+      fallbackRows << row;
+  }
+
+  // remaining features are evaluated one by one, keeping the first error
+  QString error;
+  for ( int row : qgis::as_const( fallbackRows ) )
+  {
+    context->setFeature( batch.feature( row ) );
+    results[row] = evaluate( context );
+    if ( hasEvalError() && error.isNull() )
+      error = d->mEvalErrorString;
+  }
+  d->mEvalErrorString = error;
+
+  if ( selection )
+  {
+    for ( int row = 0; row < count; ++row )
+      ( *selection )[row] = results.at( row ).toBool();
+  }
+  return results;
+}
+
 bool QgsExpression::hasEvalError() const
 {
   return !d->mEvalErrorString.isNull();
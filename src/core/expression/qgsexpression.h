@@ -21,6 +21,7 @@
 #include <QStringList>
 #include <QVariant>
 #include <QList>
+#include <QVector>
 #include <QDomDocument>
 #include <QCoreApplication>
 #include <QSet>
@@ -32,6 +33,7 @@
 #include "qgsexpressionnode.h"
 
 class QgsFeature;
+class QgsFeatureBatch;
 class QgsGeometry;
 class QgsOgcUtils;
 class QgsVectorLayer;
@@ -342,6 +344,33 @@ class CORE_EXPORT QgsExpression
      */
     QVariant evaluate( const QgsExpressionContext *context );
 
+#ifndef SIP_RUN
+
+    /**
+     * Evaluates the expression for all features of a \a batch, and returns the results in the order
+     * of the features in the batch.
+     *
+     * Arithmetic, comparisons, boolean logic, CASE, IN and common math and string functions are evaluated
+     * for all features at once, directly on the typed attribute columns of the batch. Features for which
+     * this is not possible (e.g. because of values which cannot be converted, or parts of the expression
+     * which need the whole feature such as geometry functions) are set as the feature of the \a context and
+     * evaluated one by one, so that the results are always the same as calling evaluate() for each feature.
+     *
+     * If \a selection is specified, it will be filled with the results converted to booleans, i.e. whether each
+     * feature would be accepted by the expression used as a filter.
+     *
+     * If evaluating the expression failed for some features, their results are NULL and hasEvalError() returns TRUE,
+     * with the error of the first of these features.
+     *
+     * If \a context is NULLPTR, features which cannot be evaluated at once are evaluated with an empty context.
+     *
+     * \note prepare() should be called before calling this method, with a context using the same fields as the batch.
+     * \note not available in Python bindings
+     * \since QGIS 3.18
+     */
+    QVector< QVariant > evaluateBatch( const QgsFeatureBatch &batch, QgsExpressionContext *context, QVector< bool > *selection = nullptr );
+#endif
+
     //! Returns TRUE if an error occurred when evaluating last input
     bool hasEvalError() const;
     //! Returns evaluation error
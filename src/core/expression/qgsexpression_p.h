@@ -24,6 +24,7 @@
 #include "qgsdistancearea.h"
 #include "qgsunittypes.h"
 #include "qgsexpressionnode.h"
+#include "qgsexpressionprogram_p.h"
 
 ///@cond
 
@@ -84,6 +85,9 @@ class QgsExpressionPrivate
     //! Whether prepare() has been called before evaluate()
     bool mIsPrepared = false;
 
+    //! Compiled form of the prepared expression, or NULLPTR if it is evaluated through the tree
+    std::unique_ptr<QgsExpressionProgram> mProgram;
+
     QgsExpressionPrivate &operator= ( const QgsExpressionPrivate & ) = delete;
 };
 
@@ -0,0 +1,1305 @@
+/***************************************************************************
+                         qgsexpressionbatchevaluator_p.cpp
+                         ---------------------------------
+    begin                : February 2021
+    copyright            : (C) 2021 by QGIS.org
+    email                : info at qgis dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsexpressionbatchevaluator_p.h"
+#include "qgsexpression.h"
+#include "qgsexpressionfunction.h"
+#include "qgsexpressionnodeimpl.h"
+#include "qgsexpressionutils.h"
+#include "qgsexpressioncontext.h"
+#include "qgsfeaturebatch.h"
+
+#include <QSet>
+#include <cmath>
+
+/// @cond PRIVATE
+
+//
+// Column
+//
+
+void QgsExpressionBatchEvaluator::Column::reset( Type columnType, int count )
+{
+  type = columnType;
+  nullType = QVariant::Invalid;
+  states.assign( count, columnType == Null ? NullValue : Valid );
+  ints.clear();
+  doubles.clear();
+  strings.clear();
+  variants.clear();
+
+  switch ( type )
+  {
+    case Null:
+      break;
+    case Int:
+    case LongLong:
+      ints.resize( count );
+      break;
+    case Double:
+      doubles.resize( count );
+      break;
+    case String:
+      strings.resize( count );
+      break;
+    case Variant:
+      variants.resize( count );
+      break;
+  }
+}
+
+QVariant QgsExpressionBatchEvaluator::Column::value( int row ) const
+{
+  switch ( states[row] )
+  {
+    case Valid:
+      break;
+    case TypedNull:
+      return QVariant( nullType );
+    case NullValue:
+    case Fallback:
+      return QVariant();
+  }
+
+  switch ( type )
+  {
+    case Null:
+      return QVariant();
+    case Int:
+      return QVariant( static_cast< int >( ints[row] ) );
+    case LongLong:
+      return QVariant( static_cast< qlonglong >( ints[row] ) );
+    case Double:
+      return QVariant( doubles[row] );
+    case String:
+      return QVariant( strings[row] );
+    case Variant:
+      return variants[row];
+  }
+  return QVariant();
+}
+
+bool QgsExpressionBatchEvaluator::Column::isNull( int row ) const
+{
+  switch ( states[row] )
+  {
+    case NullValue:
+    case TypedNull:
+      return true;
+    case Valid:
+      return type == Variant && variants[row].isNull();
+    case Fallback:
+      break;
+  }
+  return false;
+}
+
+bool QgsExpressionBatchEvaluator::Column::isFiniteNumber( int row ) const
+{
+  switch ( type )
+  {
+    case Int:
+    case LongLong:
+      return true;
+    case Double:
+      // NaN and infinite values are rejected by QgsExpressionUtils::getDoubleValue()
+      return std::isfinite( doubles[row] );
+    case Null:
+    case String:
+    case Variant:
+      break;
+  }
+  return false;
+}
+
+void QgsExpressionBatchEvaluator::Column::convertToVariant()
+{
+  if ( type == Variant )
+    return;
+
+  const int count = static_cast< int >( states.size() );
+  std::vector< QVariant > values( count );
+  for ( int row = 0; row < count; ++row )
+  {
+    if ( states[row] == Valid )
+      values[row] = value( row );
+  }
+
+  type = Variant;
+  variants.swap( values );
+  ints.clear();
+  doubles.clear();
+  strings.clear();
+}
+
+void QgsExpressionBatchEvaluator::Column::markNullStrings()
+{
+  if ( type != String )
+    return;
+
+  const int count = static_cast< int >( states.size() );
+  for ( int row = 0; row < count; ++row )
+  {
+    if ( states[row] == Valid && strings[row].isNull() )
+    {
+      if ( nullType != QVariant::Invalid && nullType != QVariant::String )
+      {
+        convertToVariant();
+        return;
+      }
+      nullType = QVariant::String;
+      states[row] = TypedNull;
+    }
+  }
+}
+
+void QgsExpressionBatchEvaluator::Column::store( int row, const QVariant &v )
+{
+  if ( !v.isValid() )
+  {
+    states[row] = NullValue;
+    return;
+  }
+
+  if ( v.isNull() )
+  {
+    if ( type != Variant && ( nullType == QVariant::Invalid || nullType == v.type() ) )
+    {
+      nullType = v.type();
+      states[row] = TypedNull;
+      return;
+    }
+    convertToVariant();
+    variants[row] = v;
+    states[row] = Valid;
+    return;
+  }
+
+  Type valueType = Variant;
+  switch ( v.type() )
+  {
+    case QVariant::Int:
+      valueType = Int;
+      break;
+    case QVariant::LongLong:
+      valueType = LongLong;
+      break;
+    case QVariant::Double:
+      valueType = Double;
+      break;
+    case QVariant::String:
+      valueType = String;
+      break;
+    default:
+      break;
+  }
+
+  if ( type == Null && valueType != Variant )
+  {
+    // first value of a column which only contained NULL values so far
+    const int count = static_cast< int >( states.size() );
+    type = valueType;
+    if ( valueType == Double )
+      doubles.resize( count );
+    else if ( valueType == String )
+      strings.resize( count );
+    else
+      ints.resize( count );
+  }
+  else if ( valueType != type )
+  {
+    convertToVariant();
+  }
+
+  switch ( type )
+  {
+    case Null:
+      break;
+    case Int:
+      ints[row] = v.toInt();
+      break;
+    case LongLong:
+      ints[row] = v.toLongLong();
+      break;
+    case Double:
+      doubles[row] = v.toDouble();
+      break;
+    case String:
+      strings[row] = v.toString();
+      break;
+    case Variant:
+      variants[row] = v;
+      break;
+  }
+  states[row] = Valid;
+}
+
+//
+// Helpers
+//
+
+static QgsExpressionUtils::TVL toTvl( quint8 logic )
+{
+  return logic == 0 ? QgsExpressionUtils::False : ( logic == 1 ? QgsExpressionUtils::True : QgsExpressionUtils::Unknown );
+}
+
+/**
+ * Same as QgsExpressionNodeInOperator::evalNode(), for an already evaluated value and list \a items.
+ */
+static QVariant inOperatorValue( const QVariant &v1, const QVector< QVariant > &items, bool notIn, QgsExpression *parent )
+{
+  if ( QgsExpressionUtils::isNull( v1 ) )
+    return TVL_Unknown;
+
+  bool listHasNull = false;
+  for ( const QVariant &v2 : items )
+  {
+    if ( QgsExpressionUtils::isNull( v2 ) )
+    {
+      listHasNull = true;
+      continue;
+    }
+
+    bool equal = false;
+    if ( ( v1.type() != QVariant::String || v2.type() != QVariant::String ) &&
+         QgsExpressionUtils::isDoubleSafe( v1 ) && QgsExpressionUtils::isDoubleSafe( v2 ) )
+    {
+      double f1 = QgsExpressionUtils::getDoubleValue( v1, parent );
+      ENSURE_NO_EVAL_ERROR
+      double f2 = QgsExpressionUtils::getDoubleValue( v2, parent );
+      ENSURE_NO_EVAL_ERROR
+      equal = qgsDoubleNear( f1, f2 );
+    }
+    else
+    {
+      QString s1 = QgsExpressionUtils::getStringValue( v1, parent );
+      ENSURE_NO_EVAL_ERROR
+      QString s2 = QgsExpressionUtils::getStringValue( v2, parent );
+      ENSURE_NO_EVAL_ERROR
+      equal = QString::compare( s1, s2 ) == 0;
+    }
+
+    if ( equal )
+      return notIn ? TVL_False : TVL_True;
+  }
+
+  if ( listHasNull )
+    return TVL_Unknown;
+  else
+    return notIn ? TVL_True : TVL_False;
+}
+
+//! Pure functions which can be evaluated on columns of values
+static const QSet< QString > &batchFunctions()
+{
+  static const QSet< QString > sFunctions
+  {
+    QStringLiteral( "abs" ),
+    QStringLiteral( "sqrt" ),
+    QStringLiteral( "floor" ),
+    QStringLiteral( "ceil" ),
+    QStringLiteral( "round" ),
+    QStringLiteral( "exp" ),
+    QStringLiteral( "ln" ),
+    QStringLiteral( "log10" ),
+    QStringLiteral( "min" ),
+    QStringLiteral( "max" ),
+    QStringLiteral( "clamp" ),
+    QStringLiteral( "to_int" ),
+    QStringLiteral( "to_real" ),
+    QStringLiteral( "to_string" ),
+    QStringLiteral( "coalesce" ),
+    QStringLiteral( "upper" ),
+    QStringLiteral( "lower" ),
+    QStringLiteral( "title" ),
+    QStringLiteral( "trim" ),
+    QStringLiteral( "length" ),
+    QStringLiteral( "substr" ),
+    QStringLiteral( "left" ),
+    QStringLiteral( "right" ),
+    QStringLiteral( "lpad" ),
+    QStringLiteral( "rpad" ),
+    QStringLiteral( "strpos" ),
+    QStringLiteral( "replace" ),
+    QStringLiteral( "concat" ),
+  };
+  return sFunctions;
+}
+
+//
+// QgsExpressionBatchEvaluator
+//
+
+QgsExpressionBatchEvaluator::QgsExpressionBatchEvaluator( QgsExpression *parent, const QgsFeatureBatch &batch, const QgsExpressionContext *context )
+  : mParent( parent )
+  , mBatch( batch )
+  , mContext( context )
+  , mCount( batch.count() )
+{
+}
+
+bool QgsExpressionBatchEvaluator::evaluate( QgsExpressionNode *root, QVector< QVariant > &results, QVector< int > &fallbackRows )
+{
+  Column column;
+  if ( !root || !evalNode( root, column ) )
+  {
+    takeError();
+    return false;
+  }
+
+  for ( int row = 0; row < mCount; ++row )
+  {
+    if ( column.states[row] == Fallback )
+      fallbackRows << row;
+    else
+      results[row] = column.value( row );
+  }
+  return true;
+}
+
+bool QgsExpressionBatchEvaluator::takeError()
+{
+  if ( !mParent->hasEvalError() )
+    return false;
+
+  mParent->setEvalErrorString( QString() );
+  return true;
+}
+
+bool QgsExpressionBatchEvaluator::evalNode( QgsExpressionNode *node, Column &result )
+{
+  if ( node->hasCachedStaticValue() )
+    return evalConstant( node->cachedStaticValue(), result );
+
+  switch ( node->nodeType() )
+  {
+    case QgsExpressionNode::ntLiteral:
+      return evalConstant( static_cast< QgsExpressionNodeLiteral * >( node )->value(), result );
+    case QgsExpressionNode::ntColumnRef:
+      return evalColumnRef( node, result );
+    case QgsExpressionNode::ntUnaryOperator:
+      return evalUnaryOperator( node, result );
+    case QgsExpressionNode::ntBinaryOperator:
+      return evalBinaryOperator( node, result );
+    case QgsExpressionNode::ntInOperator:
+      return evalIn( node, result );
+    case QgsExpressionNode::ntCondition:
+      return evalCondition( node, result );
+    case QgsExpressionNode::ntFunction:
+      return evalFunction( node, result );
+    case QgsExpressionNode::ntIndexOperator:
+      break;
+  }
+  return false;
+}
+
+bool QgsExpressionBatchEvaluator::evalConstant( const QVariant &value, Column &result )
+{
+  if ( !value.isValid() )
+  {
+    result.reset( Column::Null, mCount );
+    return true;
+  }
+
+  if ( value.isNull() )
+  {
+    result.reset( Column::Null, mCount );
+    result.states.assign( mCount, TypedNull );
+    result.nullType = value.type();
+    return true;
+  }
+
+  switch ( value.type() )
+  {
+    case QVariant::Int:
+      result.reset( Column::Int, mCount );
+      result.ints.assign( mCount, value.toInt() );
+      break;
+    case QVariant::LongLong:
+      result.reset( Column::LongLong, mCount );
+      result.ints.assign( mCount, value.toLongLong() );
+      break;
+    case QVariant::Double:
+      result.reset( Column::Double, mCount );
+      result.doubles.assign( mCount, value.toDouble() );
+      break;
+    case QVariant::String:
+      result.reset( Column::String, mCount );
+      result.strings.assign( mCount, value.toString() );
+      break;
+    default:
+      result.reset( Column::Variant, mCount );
+      result.variants.assign( mCount, value );
+      break;
+  }
+  return true;
+}
+
+bool QgsExpressionBatchEvaluator::evalColumnRef( QgsExpressionNode *node, Column &result )
+{
+  QgsExpressionNodeColumnRef *columnRef = static_cast< QgsExpressionNodeColumnRef * >( node );
+  const int index = columnRef->mIndex;
+
+  // the field index was resolved when preparing the expression, so the batch must have the same fields
+  const QgsFields fields = mBatch.fields();
+  if ( index < 0 || index >= fields.count() || fields.lookupField( columnRef->name() ) != index )
+    return false;
+
+  const QVariant::Type fieldType = fields.at( index ).type();
+  switch ( mBatch.columnType( index ) )
+  {
+    case QgsFeatureBatch::Int64Column:
+    {
+      // boolean and unsigned fields are returned as other QVariant types, which are left to the expression tree
+      if ( fieldType == QVariant::Int )
+        result.reset( Column::Int, mCount );
+      else if ( fieldType == QVariant::LongLong )
+        result.reset( Column::LongLong, mCount );
+      else
+        return false;
+
+      const qint64 *values = mBatch.int64Column( index );
+      std::copy( values, values + mCount, result.ints.begin() );
+      break;
+    }
+
+    case QgsFeatureBatch::DoubleColumn:
+    {
+      result.reset( Column::Double, mCount );
+      const double *values = mBatch.doubleColumn( index );
+      std::copy( values, values + mCount, result.doubles.begin() );
+      break;
+    }
+
+    case QgsFeatureBatch::StringColumn:
+      result.reset( Column::String, mCount );
+      for ( int row = 0; row < mCount; ++row )
+        result.strings[row] = mBatch.stringRef( index, row ).toString();
+      result.markNullStrings();
+      break;
+
+    case QgsFeatureBatch::VariantColumn:
+      result.reset( Column::Variant, mCount );
+      for ( int row = 0; row < mCount; ++row )
+        result.variants[row] = mBatch.value( index, row );
+      return true;
+  }
+
+  // NULL attributes are returned as NULL values of the field type
+  result.nullType = fieldType;
+  for ( int row = 0; row < mCount; ++row )
+  {
+    if ( mBatch.isNull( index, row ) )
+      result.states[row] = TypedNull;
+  }
+  return true;
+}
+
+bool QgsExpressionBatchEvaluator::evalUnaryOperator( QgsExpressionNode *node, Column &result )
+{
+  QgsExpressionNodeUnaryOperator *unary = static_cast< QgsExpressionNodeUnaryOperator * >( node );
+
+  Column operand;
+  if ( !evalNode( unary->operand(), operand ) )
+    return false;
+
+  if ( unary->op() == QgsExpressionNodeUnaryOperator::uoNot )
+  {
+    std::vector< Logic > logic;
+    logicValues( operand, logic );
+    for ( Logic &value : logic )
+    {
+      if ( value != LogicFallback )
+        value = static_cast< Logic >( QgsExpressionUtils::NOT[toTvl( value )] );
+    }
+    setLogic( result, logic );
+    return true;
+  }
+
+  std::vector< int > genericRows;
+  if ( operand.isInteger() || operand.type == Column::Double )
+  {
+    result.reset( operand.isInteger() ? Column::LongLong : Column::Double, mCount );
+    for ( int row = 0; row < mCount; ++row )
+    {
+      if ( operand.states[row] == Fallback )
+        result.states[row] = Fallback;
+      else if ( operand.states[row] != Valid || !operand.isFiniteNumber( row ) )
+        genericRows.push_back( row );
+      else if ( operand.isInteger() )
+        result.ints[row] = -operand.ints[row];
+      else
+        result.doubles[row] = -operand.doubles[row];
+    }
+  }
+  else
+  {
+    result.reset( Column::Null, mCount );
+    for ( int row = 0; row < mCount; ++row )
+    {
+      if ( operand.states[row] == Fallback )
+        result.states[row] = Fallback;
+      else
+        genericRows.push_back( row );
+    }
+  }
+
+  for ( int row : genericRows )
+  {
+    const QVariant value = unary->evalOperand( operand.value( row ), mParent );
+    if ( takeError() )
+      result.states[row] = Fallback;
+    else
+      result.store( row, value );
+  }
+  return true;
+}
+
+bool QgsExpressionBatchEvaluator::evalBinaryOperator( QgsExpressionNode *node, Column &result )
+{
+  QgsExpressionNodeBinaryOperator *binary = static_cast< QgsExpressionNodeBinaryOperator * >( node );
+  if ( binary->op() == QgsExpressionNodeBinaryOperator::boAnd || binary->op() == QgsExpressionNodeBinaryOperator::boOr )
+    return evalLogic( node, result );
+
+  Column left;
+  Column right;
+  if ( !evalNode( binary->opLeft(), left ) || !evalNode( binary->opRight(), right ) )
+    return false;
+
+  std::vector< int > genericRows;
+  switch ( binary->op() )
+  {
+    case QgsExpressionNodeBinaryOperator::boPlus:
+    case QgsExpressionNodeBinaryOperator::boMinus:
+    case QgsExpressionNodeBinaryOperator::boMul:
+    case QgsExpressionNodeBinaryOperator::boDiv:
+    case QgsExpressionNodeBinaryOperator::boIntDiv:
+    case QgsExpressionNodeBinaryOperator::boMod:
+    case QgsExpressionNodeBinaryOperator::boPow:
+    case QgsExpressionNodeBinaryOperator::boConcat:
+      evalArithmetic( node, left, right, result, genericRows );
+      break;
+
+    case QgsExpressionNodeBinaryOperator::boEQ:
+    case QgsExpressionNodeBinaryOperator::boNE:
+    case QgsExpressionNodeBinaryOperator::boLE:
+    case QgsExpressionNodeBinaryOperator::boGE:
+    case QgsExpressionNodeBinaryOperator::boLT:
+    case QgsExpressionNodeBinaryOperator::boGT:
+    case QgsExpressionNodeBinaryOperator::boIs:
+    case QgsExpressionNodeBinaryOperator::boIsNot:
+      evalComparison( node, left, right, result, genericRows );
+      break;
+
+    case QgsExpressionNodeBinaryOperator::boRegexp:
+    case QgsExpressionNodeBinaryOperator::boLike:
+    case QgsExpressionNodeBinaryOperator::boNotLike:
+    case QgsExpressionNodeBinaryOperator::boILike:
+    case QgsExpressionNodeBinaryOperator::boNotILike:
+    case QgsExpressionNodeBinaryOperator::boOr:
+    case QgsExpressionNodeBinaryOperator::boAnd:
+      result.reset( Column::Null, mCount );
+      for ( int row = 0; row < mCount; ++row )
+      {
+        if ( left.states[row] == Fallback || right.states[row] == Fallback )
+          result.states[row] = Fallback;
+        else
+          genericRows.push_back( row );
+      }
+      break;
+  }
+
+  // rows which the typed loops cannot handle are evaluated by the node itself
+  for ( int row : genericRows )
+  {
+    const QVariant value = binary->evalOperands( left.value( row ), right.value( row ), mParent, mContext );
+    if ( takeError() )
+      result.states[row] = Fallback;
+    else
+      result.store( row, value );
+  }
+  return true;
+}
+
+void QgsExpressionBatchEvaluator::evalArithmetic( QgsExpressionNode *node, const Column &left, const Column &right, Column &result, std::vector< int > &genericRows )
+{
+  QgsExpressionNodeBinaryOperator *binary = static_cast< QgsExpressionNodeBinaryOperator * >( node );
+  const QgsExpressionNodeBinaryOperator::BinaryOperator op = binary->op();
+
+  if ( ( op == QgsExpressionNodeBinaryOperator::boPlus || op == QgsExpressionNodeBinaryOperator::boConcat )
+       && left.type == Column::String && right.type == Column::String )
+  {
+    result.reset( Column::String, mCount );
+    for ( int row = 0; row < mCount; ++row )
+    {
+      const RowState leftState = left.states[row];
+      const RowState rightState = right.states[row];
+      if ( leftState == Fallback || rightState == Fallback )
+        result.states[row] = Fallback;
+      else if ( leftState == Valid && rightState == Valid )
+        result.strings[row] = left.strings[row] + right.strings[row];
+      else if ( op == QgsExpressionNodeBinaryOperator::boConcat || leftState == NullValue || rightState == NullValue )
+        result.states[row] = NullValue;
+      else
+        genericRows.push_back( row ); // NULL strings are concatenated as empty strings by +
+    }
+    result.markNullStrings();
+    return;
+  }
+
+  if ( !left.isNumeric() || !right.isNumeric() )
+  {
+    result.reset( Column::Null, mCount );
+    for ( int row = 0; row < mCount; ++row )
+    {
+      if ( left.states[row] == Fallback || right.states[row] == Fallback )
+        result.states[row] = Fallback;
+      else
+        genericRows.push_back( row );
+    }
+    return;
+  }
+
+  const bool integerResult = left.isInteger() && right.isInteger() &&
+                             ( op == QgsExpressionNodeBinaryOperator::boPlus || op == QgsExpressionNodeBinaryOperator::boMinus
+                               || op == QgsExpressionNodeBinaryOperator::boMul || op == QgsExpressionNodeBinaryOperator::boMod );
+  const bool isIntDiv = op == QgsExpressionNodeBinaryOperator::boIntDiv;
+  const bool isPow = op == QgsExpressionNodeBinaryOperator::boPow;
+  const bool isConcat = op == QgsExpressionNodeBinaryOperator::boConcat;
+  if ( isConcat )
+    result.reset( Column::Null, mCount );
+  else
+    result.reset( integerResult || isIntDiv ? Column::LongLong : Column::Double, mCount );
+
+  for ( int row = 0; row < mCount; ++row )
+  {
+    const RowState leftState = left.states[row];
+    const RowState rightState = right.states[row];
+    if ( leftState == Fallback || rightState == Fallback )
+    {
+      result.states[row] = Fallback;
+    }
+    else if ( leftState != Valid || rightState != Valid )
+    {
+      // integer division does not handle NULL values, and NULL strings are concatenated by +
+      if ( isIntDiv || ( op == QgsExpressionNodeBinaryOperator::boPlus && ( leftState == TypedNull || rightState == TypedNull ) ) )
+        genericRows.push_back( row );
+      else
+        result.states[row] = NullValue;
+    }
+    else if ( isConcat || !left.isFiniteNumber( row ) || !right.isFiniteNumber( row ) )
+    {
+      genericRows.push_back( row );
+    }
+    else if ( integerResult )
+    {
+      if ( op == QgsExpressionNodeBinaryOperator::boMod && right.ints[row] == 0 )
+        result.states[row] = NullValue;
+      else
+        result.ints[row] = binary->computeInt( left.ints[row], right.ints[row] );
+    }
+    else
+    {
+      const double fL = left.number( row );
+      const double fR = right.number( row );
+      if ( isPow )
+        result.doubles[row] = std::pow( fL, fR );
+      else if ( fR == 0. && ( isIntDiv || op == QgsExpressionNodeBinaryOperator::boDiv || op == QgsExpressionNodeBinaryOperator::boMod ) )
+        result.states[row] = NullValue; // division by zero
+      else if ( isIntDiv )
+        result.ints[row] = qlonglong( std::floor( fL / fR ) );
+      else
+        result.doubles[row] = binary->computeDouble( fL, fR );
+    }
+  }
+}
+
+void QgsExpressionBatchEvaluator::evalComparison( QgsExpressionNode *node, const Column &left, const Column &right, Column &result, std::vector< int > &genericRows )
+{
+  QgsExpressionNodeBinaryOperator *binary = static_cast< QgsExpressionNodeBinaryOperator * >( node );
+  const bool isIs = binary->op() == QgsExpressionNodeBinaryOperator::boIs;
+  const bool isIsNot = binary->op() == QgsExpressionNodeBinaryOperator::boIsNot;
+  const bool bothNumeric = left.isNumeric() && right.isNumeric();
+  const bool bothStrings = left.type == Column::String && right.type == Column::String;
+
+  result.reset( Column::Int, mCount );
+  for ( int row = 0; row < mCount; ++row )
+  {
+    if ( left.states[row] == Fallback || right.states[row] == Fallback )
+    {
+      result.states[row] = Fallback;
+      continue;
+    }
+
+    const bool leftNull = left.isNull( row );
+    const bool rightNull = right.isNull( row );
+    if ( isIs || isIsNot )
+    {
+      if ( leftNull || rightNull )
+      {
+        result.ints[row] = ( leftNull && rightNull ) == isIs ? 1 : 0;
+        continue;
+      }
+    }
+    else if ( leftNull || rightNull )
+    {
+      result.states[row] = NullValue;
+      continue;
+    }
+
+    if ( bothNumeric && left.isFiniteNumber( row ) && right.isFiniteNumber( row ) )
+    {
+      const double fL = left.number( row );
+      const double fR = right.number( row );
+      if ( isIs || isIsNot )
+        result.ints[row] = qgsDoubleNear( fL, fR ) == isIs ? 1 : 0;
+      else
+        result.ints[row] = binary->compare( fL - fR ) ? 1 : 0;
+    }
+    else if ( bothStrings )
+    {
+      const int diff = QString::compare( left.strings[row], right.strings[row] );
+      if ( isIs || isIsNot )
+        result.ints[row] = ( diff == 0 ) == isIs ? 1 : 0;
+      else
+        result.ints[row] = binary->compare( diff ) ? 1 : 0;
+    }
+    else
+    {
+      genericRows.push_back( row );
+    }
+  }
+}
+
+void QgsExpressionBatchEvaluator::logicValues( const Column &column, std::vector< Logic > &logic )
+{
+  logic.resize( mCount );
+  for ( int row = 0; row < mCount; ++row )
+  {
+    switch ( column.states[row] )
+    {
+      case Fallback:
+        logic[row] = LogicFallback;
+        continue;
+      case NullValue:
+      case TypedNull:
+        logic[row] = LogicUnknown;
+        continue;
+      case Valid:
+        break;
+    }
+
+    switch ( column.type )
+    {
+      case Column::Null:
+        logic[row] = LogicUnknown;
+        break;
+      case Column::Int:
+        logic[row] = column.ints[row] != 0 ? LogicTrue : LogicFalse;
+        break;
+      case Column::LongLong:
+      case Column::Double:
+        logic[row] = !qgsDoubleNear( column.number( row ), 0.0 ) ? LogicTrue : LogicFalse;
+        break;
+      case Column::String:
+      case Column::Variant:
+      {
+        const QgsExpressionUtils::TVL tvl = QgsExpressionUtils::getTVLValue( column.value( row ), mParent );
+        if ( takeError() )
+          logic[row] = LogicFallback;
+        else
+          logic[row] = tvl == QgsExpressionUtils::True ? LogicTrue : ( tvl == QgsExpressionUtils::False ? LogicFalse : LogicUnknown );
+        break;
+      }
+    }
+  }
+}
+
+void QgsExpressionBatchEvaluator::setLogic( Column &result, const std::vector< Logic > &logic )
+{
+  // same values as QgsExpressionUtils::tvl2variant()
+  const int count = static_cast< int >( logic.size() );
+  result.reset( Column::Int, count );
+  for ( int row = 0; row < count; ++row )
+  {
+    switch ( logic[row] )
+    {
+      case LogicFalse:
+        result.ints[row] = 0;
+        break;
+      case LogicTrue:
+        result.ints[row] = 1;
+        break;
+      case LogicUnknown:
+        result.states[row] = NullValue;
+        break;
+      case LogicFallback:
+        result.states[row] = Fallback;
+        break;
+    }
+  }
+}
+
+bool QgsExpressionBatchEvaluator::evalLogic( QgsExpressionNode *node, Column &result )
+{
+  QgsExpressionNodeBinaryOperator *binary = static_cast< QgsExpressionNodeBinaryOperator * >( node );
+  const bool isAnd = binary->op() == QgsExpressionNodeBinaryOperator::boAnd;
+
+  Column left;
+  Column right;
+  if ( !evalNode( binary->opLeft(), left ) || !evalNode( binary->opRight(), right ) )
+    return false;
+
+  std::vector< Logic > leftLogic;
+  std::vector< Logic > rightLogic;
+  logicValues( left, leftLogic );
+  logicValues( right, rightLogic );
+
+  for ( int row = 0; row < mCount; ++row )
+  {
+    const Logic l = leftLogic[row];
+    // the right operand is not evaluated at all for rows where the left operand decides the result
+    if ( l == LogicFallback || ( isAnd && l == LogicFalse ) || ( !isAnd && l == LogicTrue ) )
+      continue;
+
+    const Logic r = rightLogic[row];
+    if ( r == LogicFallback )
+      leftLogic[row] = LogicFallback;
+    else
+      leftLogic[row] = static_cast< Logic >( isAnd ? QgsExpressionUtils::AND[toTvl( l )][toTvl( r )] : QgsExpressionUtils::OR[toTvl( l )][toTvl( r )] );
+  }
+
+  setLogic( result, leftLogic );
+  return true;
+}
+
+bool QgsExpressionBatchEvaluator::evalIn( QgsExpressionNode *node, Column &result )
+{
+  QgsExpressionNodeInOperator *inNode = static_cast< QgsExpressionNodeInOperator * >( node );
+  const QList< QgsExpressionNode * > list = inNode->list()->list();
+  if ( list.isEmpty() )
+    return false;
+
+  // only lists of static values are handled
+  QVector< QVariant > items;
+  items.reserve( list.size() );
+  bool allNumbers = true;
+  bool allStrings = true;
+  bool listHasNull = false;
+  for ( QgsExpressionNode *item : list )
+  {
+    QVariant value;
+    if ( item->hasCachedStaticValue() )
+      value = item->cachedStaticValue();
+    else if ( item->nodeType() == QgsExpressionNode::ntLiteral )
+      value = static_cast< QgsExpressionNodeLiteral * >( item )->value();
+    else
+      return false;
+
+    if ( value.isNull() )
+    {
+      listHasNull = true;
+      continue;
+    }
+
+    const bool isNumber = ( value.type() == QVariant::Int || value.type() == QVariant::LongLong || value.type() == QVariant::Double )
+                          && std::isfinite( value.toDouble() );
+    allNumbers &= isNumber;
+    allStrings &= value.type() == QVariant::String;
+    items << value;
+  }
+
+  Column value;
+  if ( !evalNode( inNode->node(), value ) )
+    return false;
+
+  const bool notIn = inNode->isNotIn();
+  const qint64 found = notIn ? 0 : 1;
+  const qint64 notFound = notIn ? 1 : 0;
+
+  std::vector< double > numbers;
+  if ( allNumbers && value.isNumeric() )
+  {
+    for ( const QVariant &item : qgis::as_const( items ) )
+      numbers.push_back( item.toDouble() );
+  }
+  const bool numberLoop = !numbers.empty() || ( items.isEmpty() && value.isNumeric() );
+  const bool stringLoop = allStrings && value.type == Column::String;
+
+  result.reset( Column::Int, mCount );
+  for ( int row = 0; row < mCount; ++row )
+  {
+    if ( value.states[row] == Fallback )
+    {
+      result.states[row] = Fallback;
+      continue;
+    }
+    else if ( value.isNull( row ) )
+    {
+      result.states[row] = NullValue;
+      continue;
+    }
+
+    if ( numberLoop && value.isFiniteNumber( row ) )
+    {
+      const double number = value.number( row );
+      bool isFound = false;
+      for ( double item : numbers )
+      {
+        if ( qgsDoubleNear( number, item ) )
+        {
+          isFound = true;
+          break;
+        }
+      }
+      if ( isFound )
+        result.ints[row] = found;
+      else if ( listHasNull )
+        result.states[row] = NullValue;
+      else
+        result.ints[row] = notFound;
+    }
+    else if ( stringLoop )
+    {
+      const QString &string = value.strings[row];
+      bool isFound = false;
+      for ( const QVariant &item : qgis::as_const( items ) )
+      {
+        if ( QString::compare( string, item.toString() ) == 0 )
+        {
+          isFound = true;
+          break;
+        }
+      }
+      if ( isFound )
+        result.ints[row] = found;
+      else if ( listHasNull )
+        result.states[row] = NullValue;
+      else
+        result.ints[row] = notFound;
+    }
+    else
+    {
+      QVector< QVariant > allItems = items;
+      if ( listHasNull )
+        allItems << QVariant();
+      const QVariant v = inOperatorValue( value.value( row ), allItems, notIn, mParent );
+      if ( takeError() )
+        result.states[row] = Fallback;
+      else
+        result.store( row, v );
+    }
+  }
+  return true;
+}
+
+void QgsExpressionBatchEvaluator::selectRows( const std::vector< const Column * > &columns, const std::vector< int > &selected, Column &result )
+{
+  // use a typed result if all columns have the same type
+  Column::Type type = Column::Null;
+  QVariant::Type nullType = QVariant::Invalid;
+  bool mixed = false;
+  for ( const Column *column : columns )
+  {
+    if ( column->type != Column::Null )
+    {
+      if ( type == Column::Null )
+        type = column->type;
+      else if ( type != column->type )
+        mixed = true;
+    }
+    if ( column->nullType != QVariant::Invalid )
+    {
+      if ( nullType == QVariant::Invalid )
+        nullType = column->nullType;
+      else if ( nullType != column->nullType )
+        mixed = true;
+    }
+  }
+  if ( mixed )
+  {
+    type = Column::Variant;
+    nullType = QVariant::Invalid;
+  }
+
+  const int count = static_cast< int >( selected.size() );
+  result.reset( type, count );
+  result.nullType = nullType;
+  for ( int row = 0; row < count; ++row )
+  {
+    if ( selected[row] < 0 )
+    {
+      result.states[row] = Fallback;
+      continue;
+    }
+
+    const Column &column = *columns[selected[row]];
+    const RowState state = column.states[row];
+    if ( state == TypedNull && mixed )
+    {
+      result.variants[row] = column.value( row );
+      result.states[row] = Valid;
+      continue;
+    }
+    result.states[row] = state;
+    if ( state != Valid )
+      continue;
+
+    switch ( type )
+    {
+      case Column::Null:
+        break;
+      case Column::Int:
+      case Column::LongLong:
+        result.ints[row] = column.ints[row];
+        break;
+      case Column::Double:
+        result.doubles[row] = column.doubles[row];
+        break;
+      case Column::String:
+        result.strings[row] = column.strings[row];
+        break;
+      case Column::Variant:
+        result.variants[row] = column.value( row );
+        break;
+    }
+  }
+}
+
+bool QgsExpressionBatchEvaluator::evalCondition( QgsExpressionNode *node, Column &result )
+{
+  QgsExpressionNodeCondition *condition = static_cast< QgsExpressionNodeCondition * >( node );
+  const QgsExpressionNodeCondition::WhenThenList conditions = condition->conditions();
+  const int branchCount = conditions.size();
+
+  std::vector< Column > branches( branchCount + 1 );
+  std::vector< std::vector< Logic > > whens( branchCount );
+  for ( int i = 0; i < branchCount; ++i )
+  {
+    Column when;
+    if ( !evalNode( conditions.at( i )->whenExp(), when ) || !evalNode( conditions.at( i )->thenExp(), branches[i] ) )
+      return false;
+    logicValues( when, whens[i] );
+  }
+
+  if ( condition->elseExp() )
+  {
+    if ( !evalNode( condition->elseExp(), branches[branchCount] ) )
+      return false;
+  }
+  else
+  {
+    evalConstant( QVariant(), branches[branchCount] );
+  }
+
+  // the first WHEN which is true picks the branch, and a fallback WHEN before it makes the whole row a fallback
+  std::vector< int > selected( mCount, branchCount );
+  for ( int row = 0; row < mCount; ++row )
+  {
+    for ( int i = 0; i < branchCount; ++i )
+    {
+      const Logic logic = whens[i][row];
+      if ( logic == LogicFallback )
+      {
+        selected[row] = -1;
+        break;
+      }
+      else if ( logic == LogicTrue )
+      {
+        selected[row] = i;
+        break;
+      }
+    }
+  }
+
+  std::vector< const Column * > columns;
+  columns.reserve( branches.size() );
+  for ( const Column &branch : branches )
+    columns.push_back( &branch );
+  selectRows( columns, selected, result );
+  return true;
+}
+
+bool QgsExpressionBatchEvaluator::evalFunction( QgsExpressionNode *node, Column &result )
+{
+  QgsExpressionNodeFunction *functionNode = static_cast< QgsExpressionNodeFunction * >( node );
+  QgsExpressionFunction *function = QgsExpression::Functions()[functionNode->fnIndex()];
+  const QString name = function->name();
+  if ( function->lazyEval() || !dynamic_cast< QgsStaticExpressionFunction * >( function ) || !batchFunctions().contains( name ) )
+    return false;
+
+  // functions can be overridden by the context
+  if ( mContext && mContext->hasFunction( name ) )
+    return false;
+
+  const QList< QgsExpressionNode * > argNodes = functionNode->args() ? functionNode->args()->list() : QList< QgsExpressionNode * >();
+  const int argCount = argNodes.size();
+  std::vector< Column > args( argCount );
+  for ( int i = 0; i < argCount; ++i )
+  {
+    if ( !evalNode( argNodes.at( i ), args[i] ) )
+      return false;
+  }
+
+  if ( name == QLatin1String( "coalesce" ) )
+  {
+    // the first non NULL argument, or NULL. All arguments are evaluated before coalesce runs, so an
+    // error in any of them is an error of the whole function, even after a non NULL argument
+    std::vector< const Column * > columns;
+    for ( const Column &arg : args )
+      columns.push_back( &arg );
+    Column nullColumn;
+    nullColumn.reset( Column::Null, mCount );
+    columns.push_back( &nullColumn );
+
+    std::vector< int > selected( mCount, argCount );
+    for ( int row = 0; row < mCount; ++row )
+    {
+      for ( int i = 0; i < argCount; ++i )
+      {
+        if ( args[i].states[row] == Fallback )
+        {
+          selected[row] = -1;
+          break;
+        }
+        else if ( selected[row] == argCount && !args[i].isNull( row ) )
+        {
+          selected[row] = i;
+        }
+      }
+    }
+    selectRows( columns, selected, result );
+    return true;
+  }
+
+  // same rules as QgsExpressionFunction::run(): functions return NULL when any argument is NULL, and
+  // arguments are evaluated in order
+  const QgsExpressionFunction::ParameterList &parameters = function->parameters();
+  std::vector< RowState > argStates( mCount, Valid );
+  for ( int i = 0; i < argCount; ++i )
+  {
+    const bool defaultParamIsNull = parameters.count() > i && parameters.at( i ).optional() && !parameters.at( i ).defaultValue().isValid();
+    const bool checkNull = !defaultParamIsNull && !function->handlesNull();
+    for ( int row = 0; row < mCount; ++row )
+    {
+      if ( argStates[row] != Valid )
+        continue;
+      if ( args[i].states[row] == Fallback )
+        argStates[row] = Fallback;
+      else if ( checkNull && args[i].isNull( row ) )
+        argStates[row] = NullValue;
+    }
+  }
+
+  enum TypedFunction
+  {
+    NoTypedFunction,
+    NumericFunction,
+    StringFunction,
+    StringLength,
+  };
+  TypedFunction typedFunction = NoTypedFunction;
+  if ( argCount == 1 && args[0].isNumeric() && ( name == QLatin1String( "abs" ) || name == QLatin1String( "sqrt" ) || name == QLatin1String( "floor" ) || name == QLatin1String( "ceil" ) ) )
+    typedFunction = NumericFunction;
+  else if ( argCount == 1 && args[0].type == Column::String && ( name == QLatin1String( "upper" ) || name == QLatin1String( "lower" ) || name == QLatin1String( "trim" ) ) )
+    typedFunction = StringFunction;
+  else if ( argCount == 1 && args[0].type == Column::String && name == QLatin1String( "length" ) )
+    typedFunction = StringLength;
+
+  switch ( typedFunction )
+  {
+    case NoTypedFunction:
+      result.reset( Column::Null, mCount );
+      break;
+    case NumericFunction:
+      result.reset( Column::Double, mCount );
+      break;
+    case StringFunction:
+      result.reset( Column::String, mCount );
+      break;
+    case StringLength:
+      result.reset( Column::Int, mCount );
+      break;
+  }
+
+  std::vector< int > genericRows;
+  for ( int row = 0; row < mCount; ++row )
+  {
+    if ( argStates[row] != Valid )
+    {
+      result.states[row] = argStates[row];
+      continue;
+    }
+
+    switch ( typedFunction )
+    {
+      case NoTypedFunction:
+        genericRows.push_back( row );
+        break;
+
+      case NumericFunction:
+      {
+        if ( !args[0].isFiniteNumber( row ) )
+        {
+          genericRows.push_back( row );
+          break;
+        }
+        const double x = args[0].number( row );
+        if ( name == QLatin1String( "abs" ) )
+          result.doubles[row] = std::fabs( x );
+        else if ( name == QLatin1String( "sqrt" ) )
+          result.doubles[row] = std::sqrt( x );
+        else if ( name == QLatin1String( "floor" ) )
+          result.doubles[row] = std::floor( x );
+        else
+          result.doubles[row] = std::ceil( x );
+        break;
+      }
+
+      case StringFunction:
+        if ( name == QLatin1String( "upper" ) )
+          result.strings[row] = args[0].strings[row].toUpper();
+        else if ( name == QLatin1String( "lower" ) )
+          result.strings[row] = args[0].strings[row].toLower();
+        else
+          result.strings[row] = args[0].strings[row].trimmed();
+        break;
+
+      case StringLength:
+        result.ints[row] = args[0].strings[row].length();
+        break;
+    }
+  }
+  result.markNullStrings();
+
+  QVariantList values;
+  for ( int row : genericRows )
+  {
+    values.clear();
+    for ( const Column &arg : args )
+      values << arg.value( row );
+
+    const QVariant value = function->func( values, mContext, mParent, functionNode );
+    if ( takeError() )
+      result.states[row] = Fallback;
+    else
+      result.store( row, value );
+  }
+  return true;
+}
+
+/// @endcond
@@ -0,0 +1,177 @@
+/***************************************************************************
+                         qgsexpressionbatchevaluator_p.h
+                         -------------------------------
+    begin                : February 2021
+    copyright            : (C) 2021 by QGIS.org
+    email                : info at qgis dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSEXPRESSIONBATCHEVALUATOR_PRIVATE_H
+#define QGSEXPRESSIONBATCHEVALUATOR_PRIVATE_H
+
+#define SIP_NO_FILE
+
+/// @cond PRIVATE
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the QGIS API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+
+#include "qgis_core.h"
+
+#include <QString>
+#include <QVariant>
+#include <QVector>
+#include <vector>
+
+class QgsExpression;
+class QgsExpressionContext;
+class QgsExpressionNode;
+class QgsFeatureBatch;
+
+/**
+ * \ingroup core
+ * \class QgsExpressionBatchEvaluator
+ * Evaluates a prepared expression tree for all features of a QgsFeatureBatch at once, one node at a time,
+ * on columns of values instead of individual features.
+ *
+ * Every node produces a typed column (integers, doubles or strings) with a state for each row, so that most
+ * operators run as plain loops over arrays. Rows which the typed loops cannot handle are evaluated with the
+ * operator implementation of the node itself, and rows for which this gives an error are flagged so that the
+ * whole feature is evaluated through QgsExpression::evaluate() instead. This guarantees that the results
+ * are identical to evaluating the features one by one.
+ *
+ * \since QGIS 3.18
+ */
+class CORE_EXPORT QgsExpressionBatchEvaluator
+{
+  public:
+
+    /**
+     * Constructor for QgsExpressionBatchEvaluator, for the features of a \a batch.
+     *
+     * Evaluation errors are reported through the \a parent expression, and functions are looked
+     * up in the expression \a context.
+     */
+    QgsExpressionBatchEvaluator( QgsExpression *parent, const QgsFeatureBatch &batch, const QgsExpressionContext *context );
+
+    /**
+     * Evaluates the prepared expression tree starting at \a root into \a results.
+     *
+     * Rows which need to be evaluated through QgsExpression::evaluate() are added to \a fallbackRows, and
+     * their results are left untouched.
+     *
+     * Returns FALSE if the expression cannot be evaluated on the columns of the batch at all, in which case
+     * all features need to be evaluated one by one.
+     */
+    bool evaluate( QgsExpressionNode *root, QVector< QVariant > &results, QVector< int > &fallbackRows );
+
+  private:
+
+    //! State of a row of a column
+    enum RowState : quint8
+    {
+      Valid, //!< Row has a value
+      NullValue, //!< Row is an invalid QVariant
+      TypedNull, //!< Row is a NULL QVariant of the column's null type, e.g. a NULL attribute
+      Fallback, //!< Row must be evaluated through the expression tree
+    };
+
+    //! Three valued logic values of a row, with an additional state for fallback rows
+    enum Logic : quint8
+    {
+      LogicFalse,
+      LogicTrue,
+      LogicUnknown,
+      LogicFallback,
+    };
+
+    struct Column
+    {
+      enum Type
+      {
+        Null, //!< All rows are NULL or fallback rows
+        Int, //!< QVariant::Int values, stored in ints
+        LongLong, //!< QVariant::LongLong values, stored in ints
+        Double, //!< QVariant::Double values, stored in doubles
+        String, //!< QVariant::String values, stored in strings
+        Variant, //!< Any values, stored in variants
+      };
+
+      void reset( Type type, int count );
+      QVariant value( int row ) const;
+      bool isNull( int row ) const;
+      bool isNumeric() const { return type == Int || type == LongLong || type == Double; }
+      bool isInteger() const { return type == Int || type == LongLong; }
+      double number( int row ) const { return type == Double ? doubles[row] : static_cast< double >( ints[row] ); }
+
+      //! Returns TRUE if a valid row holds a finite number
+      bool isFiniteNumber( int row ) const;
+
+      //! Converts the column to a variant column
+      void convertToVariant();
+
+      //! Flags null QStrings of a string column as NULL values, as they are NULL once converted to QVariants
+      void markNullStrings();
+
+      /**
+       * Stores a value computed by the expression tree in a row, converting the column to a variant column
+       * if the value does not match the column's type.
+       */
+      void store( int row, const QVariant &value );
+
+      Type type = Null;
+      std::vector< RowState > states;
+      std::vector< qint64 > ints;
+      std::vector< double > doubles;
+      std::vector< QString > strings;
+      std::vector< QVariant > variants;
+      QVariant::Type nullType = QVariant::Invalid;
+    };
+
+    bool evalNode( QgsExpressionNode *node, Column &result );
+    bool evalConstant( const QVariant &value, Column &result );
+    bool evalColumnRef( QgsExpressionNode *node, Column &result );
+    bool evalUnaryOperator( QgsExpressionNode *node, Column &result );
+    bool evalBinaryOperator( QgsExpressionNode *node, Column &result );
+    bool evalLogic( QgsExpressionNode *node, Column &result );
+    bool evalIn( QgsExpressionNode *node, Column &result );
+    bool evalCondition( QgsExpressionNode *node, Column &result );
+    bool evalFunction( QgsExpressionNode *node, Column &result );
+
+    void evalArithmetic( QgsExpressionNode *node, const Column &left, const Column &right, Column &result, std::vector< int > &genericRows );
+    void evalComparison( QgsExpressionNode *node, const Column &left, const Column &right, Column &result, std::vector< int > &genericRows );
+
+    //! Converts the rows of a column to logic values
+    void logicValues( const Column &column, std::vector< Logic > &logic );
+    static void setLogic( Column &result, const std::vector< Logic > &logic );
+
+    //! Picks the rows of the result from several columns, e.g. for CASE or coalesce()
+    static void selectRows( const std::vector< const Column * > &columns, const std::vector< int > &selected, Column &result );
+
+    //! Marks rows with errors as fallback rows, and clears the error
+    bool takeError();
+
+    QgsExpression *mParent = nullptr;
+    const QgsFeatureBatch &mBatch;
+    const QgsExpressionContext *mContext = nullptr;
+    int mCount = 0;
+};
+
+/// @endcond
+
+#endif // QGSEXPRESSIONBATCHEVALUATOR_PRIVATE_H
@@ -78,10 +78,19 @@ class CORE_EXPORT QgsExpressionNodeUnaryOperator : public QgsExpressionNode
     QString text() const;
 
   private:
+
+    /**
+     * Applies the operator to an already evaluated operand value.
+     */
+    QVariant evalOperand( const QVariant &val, QgsExpression *parent );
+
     UnaryOperator mOp;
     QgsExpressionNode *mOperand = nullptr;
 
     static const char *UNARY_OPERATOR_TEXT[];
+
+    friend class QgsExpressionProgram;
+    friend class QgsExpressionBatchEvaluator;
 };
 
 /**
@@ -188,6 +197,12 @@ class CORE_EXPORT QgsExpressionNodeBinaryOperator : public QgsExpressionNode
     QString text() const;
 
   private:
+
+    /**
+     * Applies the operator to already evaluated left and right operand values.
+     */
+    QVariant evalOperands( const QVariant &vL, const QVariant &vR, QgsExpression *parent, const QgsExpressionContext *context );
+
     bool compare( double diff );
     qlonglong computeInt( qlonglong x, qlonglong y );
     double computeDouble( double x, double y );
@@ -204,6 +219,9 @@ class CORE_EXPORT QgsExpressionNodeBinaryOperator : public QgsExpressionNode
     QgsExpressionNode *mOpRight = nullptr;
 
     static const char *BINARY_OPERATOR_TEXT[];
+
+    friend class QgsExpressionProgram;
+    friend class QgsExpressionBatchEvaluator;
 };
 
 /**
@@ -431,6 +449,9 @@ class CORE_EXPORT QgsExpressionNodeColumnRef : public QgsExpressionNode
   private:
     QString mName;
     int mIndex;
+
+    friend class QgsExpressionProgram;
+    friend class QgsExpressionBatchEvaluator;
 };
 
 /**
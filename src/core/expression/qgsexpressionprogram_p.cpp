@@ -0,0 +1,828 @@
+/***************************************************************************
+                         qgsexpressionprogram_p.cpp
+                         --------------------------
+    begin                : February 2021
+    copyright            : (C) 2021 by QGIS.org
+    email                : info at qgis dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsexpressionprogram_p.h"
+#include "qgsexpression.h"
+#include "qgsexpressionfunction.h"
+#include "qgsexpressionnodeimpl.h"
+#include "qgsexpressionutils.h"
+#include "qgsexpressioncontext.h"
+#include "qgsfeature.h"
+
+#include <QVarLengthArray>
+#include <cmath>
+
+/// @cond PRIVATE
+
+//
+// Value
+//
+
+QgsExpressionProgram::Value QgsExpressionProgram::Value::fromVariant( const QVariant &variant )
+{
+  Value value;
+  switch ( variant.type() )
+  {
+    case QVariant::Invalid:
+      return value;
+
+    case QVariant::Int:
+      if ( variant.isNull() )
+        break;
+      value.type = Int;
+      value.intValue = variant.toInt();
+      return value;
+
+    case QVariant::LongLong:
+      if ( variant.isNull() )
+        break;
+      value.type = LongLong;
+      value.intValue = variant.toLongLong();
+      return value;
+
+    case QVariant::Double:
+      if ( variant.isNull() )
+        break;
+      value.type = Double;
+      value.doubleValue = variant.toDouble();
+      return value;
+
+    case QVariant::String:
+      if ( variant.isNull() )
+        break;
+      value.type = String;
+      value.stringValue = variant.toString();
+      return value;
+
+    default:
+      break;
+  }
+
+  // typed NULL values and everything else are kept as is, and always take the generic paths
+  value.type = Variant;
+  value.variant = variant;
+  return value;
+}
+
+QVariant QgsExpressionProgram::Value::toVariant() const
+{
+  switch ( type )
+  {
+    case Null:
+      return QVariant();
+    case Int:
+      return QVariant( static_cast< int >( intValue ) );
+    case LongLong:
+      return QVariant( intValue );
+    case Double:
+      return QVariant( doubleValue );
+    case String:
+      return QVariant( stringValue );
+    case Variant:
+      return variant;
+  }
+  return QVariant();
+}
+
+bool QgsExpressionProgram::Value::isNumber() const
+{
+  switch ( type )
+  {
+    case Int:
+    case LongLong:
+      return true;
+    case Double:
+      // NaN and infinite values are rejected by QgsExpressionUtils::getDoubleValue()
+      return std::isfinite( doubleValue );
+    case Null:
+    case String:
+    case Variant:
+      return false;
+  }
+  return false;
+}
+
+static double numberValue( const QgsExpressionProgram::Value &value )
+{
+  return value.type == QgsExpressionProgram::Value::Double ? value.doubleValue : static_cast< double >( value.intValue );
+}
+
+static bool isInteger( const QgsExpressionProgram::Value &value )
+{
+  return value.type == QgsExpressionProgram::Value::Int || value.type == QgsExpressionProgram::Value::LongLong;
+}
+
+static bool isNull( const QgsExpressionProgram::Value &value )
+{
+  return value.type == QgsExpressionProgram::Value::Null
+         || ( value.type == QgsExpressionProgram::Value::Variant && value.variant.isNull() );
+}
+
+static QgsExpressionProgram::Value intValue( qlonglong v, QgsExpressionProgram::Value::Type type = QgsExpressionProgram::Value::LongLong )
+{
+  QgsExpressionProgram::Value value;
+  value.type = type;
+  value.intValue = v;
+  return value;
+}
+
+static QgsExpressionProgram::Value doubleValue( double v )
+{
+  QgsExpressionProgram::Value value;
+  value.type = QgsExpressionProgram::Value::Double;
+  value.doubleValue = v;
+  return value;
+}
+
+static QgsExpressionProgram::Value stringValue( const QString &v )
+{
+  QgsExpressionProgram::Value value;
+  value.type = QgsExpressionProgram::Value::String;
+  value.stringValue = v;
+  return value;
+}
+
+//! Same conversion as QgsExpressionUtils::tvl2variant()
+static QgsExpressionProgram::Value tvlValue( QgsExpressionUtils::TVL tvl )
+{
+  switch ( tvl )
+  {
+    case QgsExpressionUtils::True:
+      return intValue( 1, QgsExpressionProgram::Value::Int );
+    case QgsExpressionUtils::False:
+      return intValue( 0, QgsExpressionProgram::Value::Int );
+    case QgsExpressionUtils::Unknown:
+      break;
+  }
+  return QgsExpressionProgram::Value();
+}
+
+static QgsExpressionProgram::Value tvlValue( bool value )
+{
+  return tvlValue( value ? QgsExpressionUtils::True : QgsExpressionUtils::False );
+}
+
+/**
+ * Converts a value to three valued logic, in the same way as QgsExpressionUtils::getTVLValue().
+ * Returns FALSE if the value needs to be converted by QgsExpressionUtils::getTVLValue().
+ */
+static bool truthValue( const QgsExpressionProgram::Value &value, QgsExpressionUtils::TVL &tvl )
+{
+  switch ( value.type )
+  {
+    case QgsExpressionProgram::Value::Null:
+      tvl = QgsExpressionUtils::Unknown;
+      return true;
+    case QgsExpressionProgram::Value::Int:
+      tvl = value.intValue != 0 ? QgsExpressionUtils::True : QgsExpressionUtils::False;
+      return true;
+    case QgsExpressionProgram::Value::LongLong:
+    case QgsExpressionProgram::Value::Double:
+      tvl = !qgsDoubleNear( numberValue( value ), 0.0 ) ? QgsExpressionUtils::True : QgsExpressionUtils::False;
+      return true;
+    case QgsExpressionProgram::Value::String:
+    case QgsExpressionProgram::Value::Variant:
+      break;
+  }
+  return false;
+}
+
+//! Returns the logic value of a register written by a Truth, And or Or instruction
+static QgsExpressionUtils::TVL registerTvl( const QgsExpressionProgram::Value &value )
+{
+  if ( value.type == QgsExpressionProgram::Value::Null )
+    return QgsExpressionUtils::Unknown;
+  return value.intValue != 0 ? QgsExpressionUtils::True : QgsExpressionUtils::False;
+}
+
+//
+// QgsExpressionProgram
+//
+
+std::unique_ptr< QgsExpressionProgram > QgsExpressionProgram::compile( QgsExpressionNode *root )
+{
+  if ( !root || root->hasCachedStaticValue() )
+    return nullptr;
+
+  std::unique_ptr< QgsExpressionProgram > program( new QgsExpressionProgram() );
+  program->mResultRegister = program->allocateRegister();
+  program->compileNode( root, program->mResultRegister );
+
+  // nothing was compiled, so the program would only add overhead
+  if ( program->fallbackCount() == program->mInstructions.size() )
+    return nullptr;
+
+  return program;
+}
+
+int QgsExpressionProgram::fallbackCount() const
+{
+  int count = 0;
+  for ( const Instruction &instruction : mInstructions )
+  {
+    if ( instruction.opcode == EvalNode )
+      count++;
+  }
+  return count;
+}
+
+int QgsExpressionProgram::addInstruction( const Instruction &instruction )
+{
+  mInstructions.append( instruction );
+  return mInstructions.size() - 1;
+}
+
+void QgsExpressionProgram::compileNode( QgsExpressionNode *node, int dest )
+{
+  if ( node->hasCachedStaticValue() )
+  {
+    compileConstant( node->cachedStaticValue(), dest );
+    return;
+  }
+
+  switch ( node->nodeType() )
+  {
+    case QgsExpressionNode::ntLiteral:
+      compileConstant( static_cast< QgsExpressionNodeLiteral * >( node )->value(), dest );
+      return;
+
+    case QgsExpressionNode::ntColumnRef:
+    {
+      QgsExpressionNodeColumnRef *columnRef = static_cast< QgsExpressionNodeColumnRef * >( node );
+      if ( columnRef->mIndex < 0 )
+        break;
+
+      Instruction instruction;
+      instruction.opcode = LoadField;
+      instruction.dest = dest;
+      instruction.a = columnRef->mIndex;
+      instruction.node = node;
+      addInstruction( instruction );
+      return;
+    }
+
+    case QgsExpressionNode::ntUnaryOperator:
+    {
+      QgsExpressionNodeUnaryOperator *unary = static_cast< QgsExpressionNodeUnaryOperator * >( node );
+      Instruction instruction;
+      instruction.opcode = UnaryOperator;
+      instruction.dest = dest;
+      instruction.a = allocateRegister();
+      instruction.node = node;
+      compileNode( unary->mOperand, instruction.a );
+      addInstruction( instruction );
+      return;
+    }
+
+    case QgsExpressionNode::ntBinaryOperator:
+    {
+      QgsExpressionNodeBinaryOperator *binary = static_cast< QgsExpressionNodeBinaryOperator * >( node );
+      if ( binary->mOp == QgsExpressionNodeBinaryOperator::boAnd || binary->mOp == QgsExpressionNodeBinaryOperator::boOr )
+      {
+        compileLogic( node, dest );
+        return;
+      }
+
+      Instruction instruction;
+      instruction.opcode = BinaryOperator;
+      instruction.dest = dest;
+      instruction.a = allocateRegister();
+      instruction.b = allocateRegister();
+      instruction.node = node;
+      compileNode( binary->mOpLeft, instruction.a );
+      compileNode( binary->mOpRight, instruction.b );
+      addInstruction( instruction );
+      return;
+    }
+
+    case QgsExpressionNode::ntCondition:
+      compileCondition( node, dest );
+      return;
+
+    case QgsExpressionNode::ntFunction:
+      if ( compileFunction( node, dest ) )
+        return;
+      break;
+
+    case QgsExpressionNode::ntInOperator:
+    case QgsExpressionNode::ntIndexOperator:
+      break;
+  }
+
+  compileFallback( node, dest );
+}
+
+void QgsExpressionProgram::compileFallback( QgsExpressionNode *node, int dest )
+{
+  Instruction instruction;
+  instruction.opcode = EvalNode;
+  instruction.dest = dest;
+  instruction.node = node;
+  addInstruction( instruction );
+}
+
+void QgsExpressionProgram::compileConstant( const QVariant &value, int dest )
+{
+  mConstants.append( Value::fromVariant( value ) );
+
+  Instruction instruction;
+  instruction.opcode = LoadConstant;
+  instruction.dest = dest;
+  instruction.a = mConstants.size() - 1;
+  addInstruction( instruction );
+}
+
+void QgsExpressionProgram::compileLogic( QgsExpressionNode *node, int dest )
+{
+  QgsExpressionNodeBinaryOperator *binary = static_cast< QgsExpressionNodeBinaryOperator * >( node );
+  const bool isAnd = binary->mOp == QgsExpressionNodeBinaryOperator::boAnd;
+
+  Instruction combine;
+  combine.opcode = isAnd ? And : Or;
+  combine.dest = dest;
+  combine.a = allocateRegister();
+  combine.b = allocateRegister();
+
+  QgsExpressionUtils::TVL staticLeft = QgsExpressionUtils::Unknown;
+  if ( binary->mOpLeft->hasCachedStaticValue() && truthValue( Value::fromVariant( binary->mOpLeft->cachedStaticValue() ), staticLeft ) )
+  {
+    // fold the shortcut of a static left operand, even if the right operand is not static
+    if ( isAnd && staticLeft == QgsExpressionUtils::False )
+    {
+      compileConstant( QVariant( 0 ), dest );
+      return;
+    }
+    else if ( !isAnd && staticLeft == QgsExpressionUtils::True )
+    {
+      compileConstant( QVariant( 1 ), dest );
+      return;
+    }
+
+    const int right = allocateRegister();
+    compileNode( binary->mOpRight, right );
+
+    Instruction truth;
+    truth.opcode = Truth;
+    truth.a = right;
+    if ( staticLeft != QgsExpressionUtils::Unknown )
+    {
+      // TRUE AND x, FALSE OR x: the result is the logic value of x
+      truth.dest = dest;
+      addInstruction( truth );
+      return;
+    }
+
+    truth.dest = combine.b;
+    addInstruction( truth );
+    compileConstant( QVariant(), combine.a );
+    addInstruction( combine );
+    return;
+  }
+
+  const int left = allocateRegister();
+  compileNode( binary->mOpLeft, left );
+
+  Instruction truth;
+  truth.opcode = Truth;
+  truth.dest = combine.a;
+  truth.a = left;
+  addInstruction( truth );
+
+  Instruction copy;
+  copy.opcode = Copy;
+  copy.dest = dest;
+  copy.a = combine.a;
+  addInstruction( copy );
+
+  Instruction jump;
+  jump.opcode = isAnd ? JumpIfFalse : JumpIfTrue;
+  jump.a = combine.a;
+  const int shortcutJump = addInstruction( jump );
+
+  const int right = allocateRegister();
+  compileNode( binary->mOpRight, right );
+
+  truth.dest = combine.b;
+  truth.a = right;
+  addInstruction( truth );
+  addInstruction( combine );
+
+  mInstructions[shortcutJump].target = mInstructions.size();
+}
+
+void QgsExpressionProgram::compileCondition( QgsExpressionNode *node, int dest )
+{
+  QgsExpressionNodeCondition *condition = static_cast< QgsExpressionNodeCondition * >( node );
+
+  QVector< int > endJumps;
+  bool matched = false;
+  const QgsExpressionNodeCondition::WhenThenList conditions = condition->conditions();
+  for ( QgsExpressionNodeCondition::WhenThen *whenThen : conditions )
+  {
+    QgsExpressionNode *when = whenThen->whenExp();
+    QgsExpressionUtils::TVL staticWhen = QgsExpressionUtils::Unknown;
+    if ( when->hasCachedStaticValue() && truthValue( Value::fromVariant( when->cachedStaticValue() ), staticWhen ) )
+    {
+      if ( staticWhen == QgsExpressionUtils::True )
+      {
+        // none of the following branches can ever be reached
+        compileNode( whenThen->thenExp(), dest );
+        matched = true;
+        break;
+      }
+      // this branch can never be taken
+      continue;
+    }
+
+    const int value = allocateRegister();
+    compileNode( when, value );
+
+    Instruction truth;
+    truth.opcode = Truth;
+    truth.dest = allocateRegister();
+    truth.a = value;
+    addInstruction( truth );
+
+    Instruction skip;
+    skip.opcode = JumpIfNotTrue;
+    skip.a = truth.dest;
+    const int skipJump = addInstruction( skip );
+
+    compileNode( whenThen->thenExp(), dest );
+
+    Instruction end;
+    end.opcode = Jump;
+    endJumps << addInstruction( end );
+
+    mInstructions[skipJump].target = mInstructions.size();
+  }
+
+  if ( !matched )
+  {
+    if ( condition->elseExp() )
+      compileNode( condition->elseExp(), dest );
+    else
+      compileConstant( QVariant(), dest );
+  }
+
+  for ( int jump : qgis::as_const( endJumps ) )
+    mInstructions[jump].target = mInstructions.size();
+}
+
+bool QgsExpressionProgram::compileFunction( QgsExpressionNode *node, int dest )
+{
+  QgsExpressionNodeFunction *functionNode = static_cast< QgsExpressionNodeFunction * >( node );
+  QgsExpressionFunction *function = QgsExpression::Functions()[functionNode->fnIndex()];
+
+  // only functions which evaluate all their arguments through the default QgsExpressionFunction::run()
+  // implementation can be called directly
+  if ( function->lazyEval() || !dynamic_cast< QgsStaticExpressionFunction * >( function ) )
+    return false;
+
+  Instruction checkOverride;
+  checkOverride.opcode = CheckFunctionOverride;
+  checkOverride.dest = dest;
+  checkOverride.node = node;
+  checkOverride.function = function;
+  QVector< int > endJumps;
+  endJumps << addInstruction( checkOverride );
+
+  const QList< QgsExpressionNode * > args = functionNode->args() ? functionNode->args()->list() : QList< QgsExpressionNode * >();
+  const QgsExpressionFunction::ParameterList &parameters = function->parameters();
+
+  Instruction call;
+  call.opcode = CallFunction;
+  call.dest = dest;
+  call.a = mRegisterCount;
+  call.b = args.size();
+  call.node = node;
+  call.function = function;
+  mRegisterCount += args.size();
+
+  for ( int i = 0; i < args.size(); ++i )
+  {
+    compileNode( args.at( i ), call.a + i );
+
+    // same rules as QgsExpressionFunction::run(): functions return NULL when any parameter is NULL
+    const bool defaultParamIsNull = parameters.count() > i && parameters.at( i ).optional() && !parameters.at( i ).defaultValue().isValid();
+    if ( defaultParamIsNull || function->handlesNull() )
+      continue;
+    if ( args.at( i )->hasCachedStaticValue() && !args.at( i )->cachedStaticValue().isNull() )
+      continue;
+
+    Instruction check;
+    check.opcode = CheckArgument;
+    check.dest = dest;
+    check.a = call.a + i;
+    endJumps << addInstruction( check );
+  }
+
+  addInstruction( call );
+
+  for ( int jump : qgis::as_const( endJumps ) )
+    mInstructions[jump].target = mInstructions.size();
+  return true;
+}
+
+bool QgsExpressionProgram::evalUnaryOperator( QgsExpressionNode *node, const Value &operand, Value &result )
+{
+  QgsExpressionNodeUnaryOperator *unary = static_cast< QgsExpressionNodeUnaryOperator * >( node );
+  switch ( unary->mOp )
+  {
+    case QgsExpressionNodeUnaryOperator::uoNot:
+    {
+      QgsExpressionUtils::TVL tvl;
+      if ( !truthValue( operand, tvl ) )
+        return false;
+      result = tvlValue( QgsExpressionUtils::NOT[tvl] );
+      return true;
+    }
+
+    case QgsExpressionNodeUnaryOperator::uoMinus:
+      if ( isInteger( operand ) )
+        result = intValue( -operand.intValue );
+      else if ( operand.isNumber() )
+        result = doubleValue( -operand.doubleValue );
+      else
+        return false;
+      return true;
+  }
+  return false;
+}
+
+bool QgsExpressionProgram::evalBinaryOperator( QgsExpressionNode *node, const Value &left, const Value &right, Value &result )
+{
+  // the fast paths below must give exactly the same results as QgsExpressionNodeBinaryOperator::evalOperands(),
+  // anything else is left to the node
+  if ( left.type == Value::Variant || right.type == Value::Variant )
+    return false;
+
+  QgsExpressionNodeBinaryOperator *binary = static_cast< QgsExpressionNodeBinaryOperator * >( node );
+  const bool anyNull = left.type == Value::Null || right.type == Value::Null;
+  const bool bothNumbers = left.isNumber() && right.isNumber();
+  const bool bothStrings = left.type == Value::String && right.type == Value::String;
+
+  switch ( binary->mOp )
+  {
+    case QgsExpressionNodeBinaryOperator::boPlus:
+      if ( bothStrings )
+      {
+        result = stringValue( left.stringValue + right.stringValue );
+        return true;
+      }
+      FALLTHROUGH
+    case QgsExpressionNodeBinaryOperator::boMinus:
+    case QgsExpressionNodeBinaryOperator::boMul:
+    case QgsExpressionNodeBinaryOperator::boDiv:
+    case QgsExpressionNodeBinaryOperator::boMod:
+      if ( anyNull )
+      {
+        result = Value();
+        return true;
+      }
+      else if ( !bothNumbers )
+      {
+        return false;
+      }
+      else if ( binary->mOp != QgsExpressionNodeBinaryOperator::boDiv && isInteger( left ) && isInteger( right ) )
+      {
+        if ( binary->mOp == QgsExpressionNodeBinaryOperator::boMod && right.intValue == 0 )
+          result = Value();
+        else
+          result = intValue( binary->computeInt( left.intValue, right.intValue ) );
+        return true;
+      }
+      else
+      {
+        const double fR = numberValue( right );
+        if ( ( binary->mOp == QgsExpressionNodeBinaryOperator::boDiv || binary->mOp == QgsExpressionNodeBinaryOperator::boMod ) && fR == 0. )
+          result = Value();
+        else
+          result = doubleValue( binary->computeDouble( numberValue( left ), fR ) );
+        return true;
+      }
+
+    case QgsExpressionNodeBinaryOperator::boIntDiv:
+    {
+      if ( !bothNumbers )
+        return false;
+      const double fR = numberValue( right );
+      if ( fR == 0. )
+        result = Value();
+      else
+        result = intValue( qlonglong( std::floor( numberValue( left ) / fR ) ) );
+      return true;
+    }
+
+    case QgsExpressionNodeBinaryOperator::boPow:
+      if ( anyNull )
+        result = Value();
+      else if ( bothNumbers )
+        result = doubleValue( std::pow( numberValue( left ), numberValue( right ) ) );
+      else
+        return false;
+      return true;
+
+    case QgsExpressionNodeBinaryOperator::boEQ:
+    case QgsExpressionNodeBinaryOperator::boNE:
+    case QgsExpressionNodeBinaryOperator::boLT:
+    case QgsExpressionNodeBinaryOperator::boGT:
+    case QgsExpressionNodeBinaryOperator::boLE:
+    case QgsExpressionNodeBinaryOperator::boGE:
+      if ( anyNull )
+        result = Value();
+      else if ( bothNumbers )
+        result = tvlValue( binary->compare( numberValue( left ) - numberValue( right ) ) );
+      else if ( bothStrings )
+        result = tvlValue( binary->compare( QString::compare( left.stringValue, right.stringValue ) ) );
+      else
+        return false;
+      return true;
+
+    case QgsExpressionNodeBinaryOperator::boIs:
+    case QgsExpressionNodeBinaryOperator::boIsNot:
+    {
+      const bool isOp = binary->mOp == QgsExpressionNodeBinaryOperator::boIs;
+      bool equal = false;
+      if ( left.type == Value::Null && right.type == Value::Null )
+        equal = true;
+      else if ( anyNull )
+        equal = false;
+      else if ( bothNumbers )
+        equal = qgsDoubleNear( numberValue( left ), numberValue( right ) );
+      else if ( bothStrings )
+        equal = QString::compare( left.stringValue, right.stringValue ) == 0;
+      else
+        return false;
+      result = tvlValue( equal == isOp );
+      return true;
+    }
+
+    case QgsExpressionNodeBinaryOperator::boConcat:
+      if ( anyNull )
+        result = Value();
+      else if ( bothStrings )
+        result = stringValue( left.stringValue + right.stringValue );
+      else
+        return false;
+      return true;
+
+    case QgsExpressionNodeBinaryOperator::boOr:
+    case QgsExpressionNodeBinaryOperator::boAnd:
+    case QgsExpressionNodeBinaryOperator::boRegexp:
+    case QgsExpressionNodeBinaryOperator::boLike:
+    case QgsExpressionNodeBinaryOperator::boNotLike:
+    case QgsExpressionNodeBinaryOperator::boILike:
+    case QgsExpressionNodeBinaryOperator::boNotILike:
+      break;
+  }
+  return false;
+}
+
+QVariant QgsExpressionProgram::run( QgsExpression *parent, const QgsExpressionContext *context ) const
+{
+  QVarLengthArray< Value, 32 > registers( mRegisterCount );
+
+  // the feature is only fetched from the context once per run
+  QgsFeature feature;
+  bool hasFetchedFeature = false;
+
+  const int count = mInstructions.size();
+  int pc = 0;
+  while ( pc < count )
+  {
+    const Instruction &instruction = mInstructions.at( pc++ );
+    switch ( instruction.opcode )
+    {
+      case LoadConstant:
+        registers[instruction.dest] = mConstants.at( instruction.a );
+        break;
+
+      case LoadField:
+        registers[instruction.dest] = Value();
+        if ( !context )
+          break;
+
+        if ( !hasFetchedFeature )
+        {
+          feature = context->feature();
+          hasFetchedFeature = true;
+        }
+
+        if ( feature.isValid() )
+          registers[instruction.dest] = Value::fromVariant( feature.attribute( instruction.a ) );
+        else
+          parent->setEvalErrorString( QgsExpressionNode::tr( "No feature available for field '%1' evaluation" ).arg( static_cast< QgsExpressionNodeColumnRef * >( instruction.node )->name() ) );
+        break;
+
+      case EvalNode:
+        registers[instruction.dest] = Value::fromVariant( instruction.node->eval( parent, context ) );
+        break;
+
+      case Copy:
+        registers[instruction.dest] = registers[instruction.a];
+        break;
+
+      case Truth:
+      {
+        QgsExpressionUtils::TVL tvl;
+        if ( !truthValue( registers[instruction.a], tvl ) )
+          tvl = QgsExpressionUtils::getTVLValue( registers[instruction.a].toVariant(), parent );
+        registers[instruction.dest] = tvlValue( tvl );
+        break;
+      }
+
+      case And:
+        registers[instruction.dest] = tvlValue( QgsExpressionUtils::AND[registerTvl( registers[instruction.a] )][registerTvl( registers[instruction.b] )] );
+        break;
+
+      case Or:
+        registers[instruction.dest] = tvlValue( QgsExpressionUtils::OR[registerTvl( registers[instruction.a] )][registerTvl( registers[instruction.b] )] );
+        break;
+
+      case UnaryOperator:
+      {
+        Value result;
+        if ( !evalUnaryOperator( instruction.node, registers[instruction.a], result ) )
+          result = Value::fromVariant( static_cast< QgsExpressionNodeUnaryOperator * >( instruction.node )->evalOperand( registers[instruction.a].toVariant(), parent ) );
+        registers[instruction.dest] = result;
+        break;
+      }
+
+      case BinaryOperator:
+      {
+        Value result;
+        if ( !evalBinaryOperator( instruction.node, registers[instruction.a], registers[instruction.b], result ) )
+          result = Value::fromVariant( static_cast< QgsExpressionNodeBinaryOperator * >( instruction.node )->evalOperands( registers[instruction.a].toVariant(), registers[instruction.b].toVariant(), parent, context ) );
+        registers[instruction.dest] = result;
+        break;
+      }
+
+      case CheckFunctionOverride:
+        if ( context && context->hasFunction( instruction.function->name() ) )
+        {
+          registers[instruction.dest] = Value::fromVariant( instruction.node->eval( parent, context ) );
+          pc = instruction.target;
+        }
+        break;
+
+      case CheckArgument:
+        if ( isNull( registers[instruction.a] ) )
+        {
+          registers[instruction.dest] = Value();
+          pc = instruction.target;
+        }
+        break;
+
+      case CallFunction:
+      {
+        QVariantList values;
+        values.reserve( instruction.b );
+        for ( int i = 0; i < instruction.b; ++i )
+          values.append( registers[instruction.a + i].toVariant() );
+        registers[instruction.dest] = Value::fromVariant( instruction.function->func( values, context, parent, static_cast< QgsExpressionNodeFunction * >( instruction.node ) ) );
+        break;
+      }
+
+      case Jump:
+        pc = instruction.target;
+        continue;
+
+      case JumpIfTrue:
+        if ( registerTvl( registers[instruction.a] ) == QgsExpressionUtils::True )
+          pc = instruction.target;
+        continue;
+
+      case JumpIfFalse:
+        if ( registerTvl( registers[instruction.a] ) == QgsExpressionUtils::False )
+          pc = instruction.target;
+        continue;
+
+      case JumpIfNotTrue:
+        if ( registerTvl( registers[instruction.a] ) != QgsExpressionUtils::True )
+          pc = instruction.target;
+        continue;
+    }
+
+    if ( parent->hasEvalError() )
+      return QVariant();
+  }
+
+  return registers[mResultRegister].toVariant();
+}
+
+/// @endcond
@@ -0,0 +1,176 @@
+/***************************************************************************
+                         qgsexpressionprogram_p.h
+                         ------------------------
+    begin                : February 2021
+    copyright            : (C) 2021 by QGIS.org
+    email                : info at qgis dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSEXPRESSIONPROGRAM_PRIVATE_H
+#define QGSEXPRESSIONPROGRAM_PRIVATE_H
+
+#define SIP_NO_FILE
+
+/// @cond PRIVATE
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the QGIS API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+
+#include "qgis_core.h"
+
+#include <QString>
+#include <QVariant>
+#include <QVector>
+#include <memory>
+
+class QgsExpression;
+class QgsExpressionContext;
+class QgsExpressionNode;
+class QgsExpressionFunction;
+
+/**
+ * \ingroup core
+ * \class QgsExpressionProgram
+ * A prepared expression tree lowered to a flat list of instructions, which are executed on a
+ * small register machine instead of recursively evaluating the nodes of the tree.
+ *
+ * Registers hold unboxed integer, double and string values, so that arithmetic, comparisons
+ * and boolean logic on attribute values avoid creating and inspecting intermediate QVariants.
+ * Any value which cannot be handled by the fast paths (dates, geometries, typed nulls, ...)
+ * is passed back to the implementation of the corresponding node, so a program always gives
+ * exactly the same results and errors as evaluating the tree.
+ *
+ * Nodes which are not understood by the compiler (e.g. IN, index operators or functions with
+ * lazily evaluated arguments) are evaluated through the expression tree, as are nodes with a
+ * static value which are loaded as constants.
+ *
+ * \since QGIS 3.18
+ */
+class CORE_EXPORT QgsExpressionProgram
+{
+  public:
+
+    /**
+     * Compiles the prepared expression tree starting at \a root.
+     *
+     * Returns NULLPTR if compiling the tree would give no benefit over evaluating it, e.g. if
+     * the whole expression is static or cannot be handled by the compiler.
+     */
+    static std::unique_ptr< QgsExpressionProgram > compile( QgsExpressionNode *root );
+
+    /**
+     * Runs the program for the specified expression \a context and returns the result.
+     *
+     * Evaluation errors are reported through \a parent, exactly as for QgsExpressionNode::eval().
+     * The program does not keep any state between runs, so it may be used from several threads
+     * at once in the same way as the expression tree.
+     */
+    QVariant run( QgsExpression *parent, const QgsExpressionContext *context ) const;
+
+    /**
+     * Returns the number of instructions in the program.
+     */
+    int instructionCount() const { return mInstructions.size(); }
+
+    /**
+     * Returns the number of instructions in the program which evaluate nodes of the expression tree.
+     */
+    int fallbackCount() const;
+
+    //! Unboxed value held by a register
+    struct Value
+    {
+      enum Type
+      {
+        Null, //!< Invalid QVariant
+        Int, //!< Non null QVariant::Int
+        LongLong, //!< Non null QVariant::LongLong
+        Double, //!< Non null QVariant::Double
+        String, //!< Non null QVariant::String
+        Variant, //!< Any other value, kept as a QVariant
+      };
+
+      static Value fromVariant( const QVariant &variant );
+      QVariant toVariant() const;
+
+      //! Returns TRUE if the value is numeric and finite
+      bool isNumber() const;
+
+      Type type = Null;
+      qlonglong intValue = 0;
+      double doubleValue = 0;
+      QString stringValue;
+      QVariant variant;
+    };
+
+  private:
+
+    enum Opcode
+    {
+      LoadConstant, //!< dest = constant[a]
+      LoadField, //!< dest = feature attribute a, for the column reference node
+      EvalNode, //!< dest = tree evaluation of node
+      Copy, //!< dest = register a
+      Truth, //!< dest = three valued logic value of register a
+      And, //!< dest = AND of the logic values in registers a and b
+      Or, //!< dest = OR of the logic values in registers a and b
+      UnaryOperator, //!< dest = unary operator node applied to register a
+      BinaryOperator, //!< dest = binary operator node applied to registers a and b
+      CheckFunctionOverride, //!< if the context overrides the function of node, dest = tree evaluation of node and jump to target
+      CheckArgument, //!< if register a is null, dest = NULL and jump to target
+      CallFunction, //!< dest = function of node called with b registers starting at a
+      Jump, //!< jump to target
+      JumpIfTrue, //!< jump to target if register a is true
+      JumpIfFalse, //!< jump to target if register a is false
+      JumpIfNotTrue, //!< jump to target if register a is false or unknown
+    };
+
+    struct Instruction
+    {
+      Opcode opcode = Jump;
+      int dest = -1;
+      int a = -1;
+      int b = -1;
+      int target = -1;
+      QgsExpressionNode *node = nullptr;
+      QgsExpressionFunction *function = nullptr;
+    };
+
+    QgsExpressionProgram() = default;
+
+    static bool evalUnaryOperator( QgsExpressionNode *node, const Value &operand, Value &result );
+    static bool evalBinaryOperator( QgsExpressionNode *node, const Value &left, const Value &right, Value &result );
+
+    int allocateRegister() { return mRegisterCount++; }
+    int addInstruction( const Instruction &instruction );
+    void compileNode( QgsExpressionNode *node, int dest );
+    void compileFallback( QgsExpressionNode *node, int dest );
+    void compileConstant( const QVariant &value, int dest );
+    void compileLogic( QgsExpressionNode *node, int dest );
+    void compileCondition( QgsExpressionNode *node, int dest );
+    bool compileFunction( QgsExpressionNode *node, int dest );
+
+    QVector< Instruction > mInstructions;
+    QVector< Value > mConstants;
+    int mRegisterCount = 0;
+    int mResultRegister = 0;
+};
+
+/// @endcond
+
+#endif // QGSEXPRESSIONPROGRAM_PRIVATE_H
@@ -27,6 +27,7 @@ email                : marco.hugentobler at sourcepole dot com
 #include "qgsgeometryeditutils.h"
 #include <limits>
 #include <cstdio>
+#include <QThreadStorage>
 
 #define DEFAULT_QUADRANT_SEGMENTS 8
 
@@ -113,7 +114,15 @@ class GEOSInit
     GEOSInit &operator=( const GEOSInit &rh ) = delete;
 };
 
-Q_GLOBAL_STATIC( GEOSInit, geosinit )
+// GEOS context handles must not be used concurrently, so every thread gets its own handle
+Q_GLOBAL_STATIC( QThreadStorage< GEOSInit * >, sGeosInit )
+
+static GEOSInit *geosinit()
+{
+  if ( !sGeosInit()->hasLocalData() )
+    sGeosInit()->setLocalData( new GEOSInit() );
+  return sGeosInit()->localData();
+}
 
 void geos::GeosDeleter::operator()( GEOSGeometry *geom )
 {
@@ -0,0 +1,83 @@
+/***************************************************************************
+                         qgspreparedgeometrycache.cpp
+                         ----------------------------
+    begin                : February 2021
+    copyright            : (C) 2021 by QGIS.org
+    email                : info at qgis dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgspreparedgeometrycache.h"
+#include "qgsgeometryengine.h"
+
+#include <algorithm>
+#include <limits>
+
+QgsPreparedGeometryCache::QgsPreparedGeometryCache( int maximumSize )
+  : mCache( maximumSize )
+{
+}
+
+std::shared_ptr< QgsGeometryEngine > QgsPreparedGeometryCache::preparedEngine( const QString &sourceKey, QgsFeatureId id, const QgsGeometry &geometry )
+{
+  if ( geometry.isNull() )
+    return nullptr;
+
+  const QPair< QString, QgsFeatureId > key( sourceKey, id );
+  if ( Entry *entry = mCache.object( key ) )
+  {
+    // the geometry of a feature can change between uses of the cache, e.g. when a layer is edited
+    if ( entry->geometry.constGet() == geometry.constGet() || entry->geometry.equals( geometry ) )
+      return entry->engine;
+  }
+
+  std::unique_ptr< Entry > entry = qgis::make_unique< Entry >();
+  entry->geometry = geometry;
+  entry->engine.reset( QgsGeometry::createGeometryEngine( entry->geometry.constGet() ) );
+  entry->engine->prepareGeometry();
+
+  std::shared_ptr< QgsGeometryEngine > engine = entry->engine;
+  // the cache takes ownership of the entry, and deletes it right away if it is larger than the whole cache
+  mCache.insert( key, entry.release(), estimatedSize( geometry ) );
+  return engine;
+}
+
+int QgsPreparedGeometryCache::maximumSize() const
+{
+  return mCache.maxCost();
+}
+
+void QgsPreparedGeometryCache::setMaximumSize( int size )
+{
+  mCache.setMaxCost( size );
+}
+
+int QgsPreparedGeometryCache::size() const
+{
+  return mCache.totalCost();
+}
+
+int QgsPreparedGeometryCache::count() const
+{
+  return mCache.count();
+}
+
+void QgsPreparedGeometryCache::clear()
+{
+  mCache.clear();
+}
+
+int QgsPreparedGeometryCache::estimatedSize( const QgsGeometry &geometry )
+{
+  // GEOS keeps its own copy of the coordinates, plus an index of the segments of the prepared geometry
+  const qint64 bytes = 1024 + static_cast< qint64 >( geometry.constGet()->nCoordinates() ) * 96;
+  return static_cast< int >( std::min< qint64 >( bytes / 1024, std::numeric_limits< int >::max() ) );
+}
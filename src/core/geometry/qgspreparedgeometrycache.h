@@ -0,0 +1,122 @@
+/***************************************************************************
+                         qgspreparedgeometrycache.h
+                         --------------------------
+    begin                : February 2021
+    copyright            : (C) 2021 by QGIS.org
+    email                : info at qgis dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSPREPAREDGEOMETRYCACHE_H
+#define QGSPREPAREDGEOMETRYCACHE_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+#include "qgsfeatureid.h"
+#include "qgsgeometry.h"
+
+#include <QCache>
+#include <QPair>
+#include <QString>
+#include <memory>
+
+class QgsGeometryEngine;
+
+/**
+ * \ingroup core
+ * \class QgsPreparedGeometryCache
+ * \brief A least recently used cache of prepared geometry engines for the geometries of features.
+ *
+ * Preparing a geometry is costly for complex geometries, so when the same features are tested
+ * against many other geometries, possibly by several algorithms or runs of an algorithm, the
+ * cache allows their geometry to be prepared only once.
+ *
+ * Entries are identified by a key for the source of the features and the feature ID. A cached
+ * engine is only returned when it was prepared for an identical geometry, so a stale key never
+ * results in a wrong engine.
+ *
+ * The cache is limited by the approximate memory used by the prepared geometries. It is not
+ * thread safe, and engines returned by the cache must not be used from several threads at once.
+ *
+ * \since QGIS 3.18
+ */
+class CORE_EXPORT QgsPreparedGeometryCache
+{
+  public:
+
+    //! Default maximum size of the cache, in kilobytes
+    static const int DEFAULT_MAXIMUM_SIZE = 256 * 1024;
+
+    /**
+     * Constructor for QgsPreparedGeometryCache, with a maximum size of \a maximumSize kilobytes.
+     */
+    explicit QgsPreparedGeometryCache( int maximumSize = DEFAULT_MAXIMUM_SIZE );
+
+    QgsPreparedGeometryCache( const QgsPreparedGeometryCache &other ) = delete;
+    QgsPreparedGeometryCache &operator=( const QgsPreparedGeometryCache &other ) = delete;
+
+    /**
+     * Returns a prepared geometry engine for the \a geometry of the feature with matching \a id from
+     * the source identified by \a sourceKey.
+     *
+     * The engine is taken from the cache when the feature's geometry was already prepared, or is prepared
+     * and added to the cache otherwise. The returned engine remains valid when it is evicted from the cache.
+     *
+     * Returns NULLPTR if the geometry is null.
+     */
+    std::shared_ptr< QgsGeometryEngine > preparedEngine( const QString &sourceKey, QgsFeatureId id, const QgsGeometry &geometry );
+
+    /**
+     * Returns the maximum size of the cache, in kilobytes.
+     * \see setMaximumSize()
+     */
+    int maximumSize() const;
+
+    /**
+     * Sets the maximum \a size of the cache, in kilobytes. The least recently used engines
+     * are evicted when the cache is larger than its maximum size.
+     * \see maximumSize()
+     */
+    void setMaximumSize( int size );
+
+    /**
+     * Returns the approximate memory used by the cached engines, in kilobytes.
+     */
+    int size() const;
+
+    /**
+     * Returns the number of cached engines.
+     */
+    int count() const;
+
+    /**
+     * Removes all engines from the cache.
+     */
+    void clear();
+
+    /**
+     * Returns the approximate memory used by a prepared engine for a \a geometry, in kilobytes.
+     */
+    static int estimatedSize( const QgsGeometry &geometry );
+
+  private:
+
+    struct Entry
+    {
+      QgsGeometry geometry;
+      std::shared_ptr< QgsGeometryEngine > engine;
+    };
+
+    QCache< QPair< QString, QgsFeatureId >, Entry > mCache;
+};
+
+#endif // QGSPREPAREDGEOMETRYCACHE_H
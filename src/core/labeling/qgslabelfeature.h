@@ -179,6 +179,24 @@ class CORE_EXPORT QgsLabelFeature
     //! Sets coordinates of the fixed position (relevant only if hasFixedPosition() returns TRUE)
     void setFixedPosition( const QgsPointXY &point ) { mFixedPosition = point; }
 
+    /**
+     * Returns the placement of the label from the previous render of the map, or NULLPTR
+     * if the label should be placed from scratch.
+     *
+     * \see setPreviousPlacement()
+     * \since QGIS 3.18
+     */
+    const QgsPreviousLabelPlacement *previousPlacement() const { return mPreviousPlacement.get(); }
+
+    /**
+     * Sets the \a placement of the label from the previous render of the map. If set, the
+     * label will only be considered at this placement.
+     *
+     * \see previousPlacement()
+     * \since QGIS 3.18
+     */
+    void setPreviousPlacement( const QgsPreviousLabelPlacement &placement ) { mPreviousPlacement = qgis::make_unique< QgsPreviousLabelPlacement >( placement ); }
+
     /**
      * In case of quadrand or aligned positioning, this is set to the anchor point.
      * This can be used for proper vector based output like DXF.
@@ -593,6 +611,8 @@ class CORE_EXPORT QgsLabelFeature
 
     double mLineAnchorPercent = 0.5;
     QgsLabelLineSettings::AnchorType mLineAnchorType = QgsLabelLineSettings::AnchorType::HintOnly;
+
+    std::unique_ptr< QgsPreviousLabelPlacement > mPreviousPlacement;
 };
 
 #endif // QGSLABELFEATURE_H
@@ -28,6 +28,13 @@
 #include "qgssymbol.h"
 #include "qgsexpressioncontextutils.h"
 #include "qgsvectorlayerlabelprovider.h"
+#include "qgsvectorlayerdiagramprovider.h"
+#include "qgsvectorlayer.h"
+#include "qgsdiagramrenderer.h"
+#include "qgsreadwritecontext.h"
+
+#include <QCryptographicHash>
+#include <QDomDocument>
 
 // helper function for checking for job cancellation within PAL
 static bool _palIsCanceled( void *ctx )
@@ -35,6 +42,41 @@ static bool _palIsCanceled( void *ctx )
   return ( reinterpret_cast< QgsRenderContext * >( ctx ) )->renderingStopped();
 }
 
+// key of a label placement in QgsLabelingResults
+static QString _placementKey( const QgsLabelFeature *feature )
+{
+  return QStringLiteral( "%1:%2:%3" ).arg( feature->provider()->layerId(), feature->provider()->providerId() ).arg( feature->id() );
+}
+
+// configuration of a label provider, as far as it affects where labels are placed
+static QString _providerSignature( QgsAbstractLabelProvider *provider )
+{
+  QString signature = QStringLiteral( "%1|%2|%3|%4|%5|%6|%7" ).arg( provider->layerId(), provider->providerId() )
+                      .arg( static_cast< int >( provider->flags() ) )
+                      .arg( static_cast< int >( provider->placement() ) )
+                      .arg( qgsDoubleToString( provider->priority() ) )
+                      .arg( static_cast< int >( provider->obstacleType() ) )
+                      .arg( static_cast< int >( provider->upsidedownLabels() ) );
+
+  // placement, distance, quadrant and obstacle settings are not all exposed by the providers, so compare all of them
+  QDomDocument doc;
+  if ( const QgsVectorLayerLabelProvider *labelProvider = dynamic_cast< const QgsVectorLayerLabelProvider * >( provider ) )
+  {
+    doc.appendChild( labelProvider->settings().writeXml( doc, QgsReadWriteContext() ) );
+  }
+  else if ( dynamic_cast< const QgsVectorLayerDiagramProvider * >( provider ) )
+  {
+    const QgsVectorLayer *vl = qobject_cast< const QgsVectorLayer * >( provider->layer() );
+    if ( vl && vl->diagramLayerSettings() )
+    {
+      QDomElement layerElem = doc.createElement( QStringLiteral( "layer" ) );
+      vl->diagramLayerSettings()->writeXml( layerElem, doc );
+      doc.appendChild( layerElem );
+    }
+  }
+  return signature + doc.toString( -1 );
+}
+
 /**
  * \ingroup core
  * \class QgsLabelSorter
@@ -93,6 +135,22 @@ void QgsLabelingEngine::setMapSettings( const QgsMapSettings &mapSettings )
     mResults->setMapSettings( mapSettings );
 }
 
+void QgsLabelingEngine::setPreviousResults( const QgsLabelingResults *results )
+{
+  if ( results )
+  {
+    mPreviousPlacements = results->mPlacements;
+    mPreviousPlacementsCrs = results->mPlacementsCrs;
+    mPreviousPlacementsSignature = results->mPlacementsSignature;
+  }
+  else
+  {
+    mPreviousPlacements.clear();
+    mPreviousPlacementsCrs = QgsCoordinateReferenceSystem();
+    mPreviousPlacementsSignature.clear();
+  }
+}
+
 QList< QgsMapLayer * > QgsLabelingEngine::participatingLayers() const
 {
   QList< QgsMapLayer * > layers;
@@ -241,8 +299,13 @@ void QgsLabelingEngine::processProvider( QgsAbstractLabelProvider *provider, Qgs
 
   const QList<QgsLabelFeature *> features = provider->labelFeatures( context );
 
+  const bool usePreviousPlacements = canUsePreviousPlacements( provider );
+
   for ( QgsLabelFeature *feature : features )
   {
+    if ( usePreviousPlacements )
+      applyPreviousPlacement( feature );
+
     try
     {
       l->registerFeature( feature );
@@ -264,6 +327,138 @@ void QgsLabelingEngine::processProvider( QgsAbstractLabelProvider *provider, Qgs
   }
 }
 
+bool QgsLabelingEngine::canUsePreviousPlacements( QgsAbstractLabelProvider *provider ) const
+{
+  if ( mPreviousPlacements.isEmpty() || !mMapSettings.labelingEngineSettings().testFlag( QgsLabelingEngineSettings::UsePreviousPlacements ) )
+    return false;
+
+  // placements are stored in map units, so they are only valid for an unrotated map in the same crs.
+  // Boundaries and blocking regions may have moved with the map, so play safe and place all labels again.
+  if ( !qgsDoubleNear( mMapSettings.rotation(), 0.0 )
+       || mPreviousPlacementsCrs != mMapSettings.destinationCrs()
+       || !mMapSettings.labelBoundaryGeometry().isNull()
+       || !mMapSettings.labelBlockingRegions().isEmpty() )
+    return false;
+
+  // curved labels are made of several parts, and merged lines may change with the visible extent
+  switch ( provider->placement() )
+  {
+    case QgsPalLayerSettings::Curved:
+    case QgsPalLayerSettings::PerimeterCurved:
+      return false;
+
+    default:
+      break;
+  }
+  return !provider->flags().testFlag( QgsAbstractLabelProvider::MergeConnectedLines );
+}
+
+void QgsLabelingEngine::applyPreviousPlacement( QgsLabelFeature *feature ) const
+{
+  if ( feature->hasFixedPosition() || feature->repeatDistance() > 0 )
+    return;
+
+  auto it = mPreviousPlacements.constFind( _placementKey( feature ) );
+  if ( it == mPreviousPlacements.constEnd() || it->width < 0 )
+    return;
+
+  const QgsPreviousLabelPlacement &placement = *it;
+
+  // the feature must not have been edited, and the label must still have the same size
+  const QgsGeometry geometry = feature->feature().geometry();
+  if ( QgsWkbTypes::isMultiType( geometry.wkbType() ) || geometry.boundingBox() != placement.featureBounds )
+    return;
+
+  const QSizeF size = feature->size( placement.angle );
+  if ( !qgsDoubleNear( size.width(), placement.width, placement.width * 1e-6 )
+       || !qgsDoubleNear( size.height(), placement.height, placement.height * 1e-6 ) )
+    return;
+
+  // labels which are not fully visible anymore may conflict with the map border, so they are placed again
+  const QgsRectangle extent = mMapSettings.visibleExtent();
+  const double cosAngle = std::cos( placement.angle );
+  const double sinAngle = std::sin( placement.angle );
+  const double cornersX[] = { 0, placement.width, placement.width, 0 };
+  const double cornersY[] = { 0, 0, placement.height, placement.height };
+  for ( int i = 0; i < 4; ++i )
+  {
+    const QgsPointXY corner( placement.x + cornersX[i] * cosAngle - cornersY[i] * sinAngle,
+                             placement.y + cornersX[i] * sinAngle + cornersY[i] * cosAngle );
+    if ( !extent.contains( corner ) )
+      return;
+  }
+
+  feature->setPreviousPlacement( placement );
+}
+
+void QgsLabelingEngine::updatePlacementsSignature()
+{
+  const QgsLabelingEngineSettings &settings = mMapSettings.labelingEngineSettings();
+
+  QCryptographicHash hash( QCryptographicHash::Sha1 );
+  hash.addData( QStringLiteral( "%1|%2|%3|%4" ).arg( static_cast< int >( settings.flags() ) )
+                .arg( qgsDoubleToString( settings.maximumLineCandidatesPerCm() ) )
+                .arg( qgsDoubleToString( settings.maximumPolygonCandidatesPerCmSquared() ) )
+                .arg( static_cast< int >( settings.placementVersion() ) ).toUtf8() );
+
+  for ( QgsAbstractLabelProvider *provider : qgis::as_const( mProviders ) )
+  {
+    hash.addData( _providerSignature( provider ).toUtf8() );
+    const QList< QgsAbstractLabelProvider * > subProviders = provider->subProviders();
+    for ( QgsAbstractLabelProvider *subProvider : subProviders )
+      hash.addData( _providerSignature( subProvider ).toUtf8() );
+  }
+  mPlacementsSignature = hash.result();
+}
+
+void QgsLabelingEngine::storePlacements()
+{
+  mResults->mPlacements.clear();
+  mResults->mPlacementsCrs = mMapSettings.destinationCrs();
+  mResults->mPlacementsSignature = mPlacementsSignature;
+
+  if ( !mMapSettings.labelingEngineSettings().testFlag( QgsLabelingEngineSettings::UsePreviousPlacements )
+       || !qgsDoubleNear( mMapSettings.rotation(), 0.0 ) )
+    return;
+
+  for ( pal::LabelPosition *label : qgis::as_const( mLabels ) )
+  {
+    if ( label->nextPart() )
+      continue;
+
+    QgsLabelFeature *lf = label->getFeaturePart()->feature();
+    const QString key = _placementKey( lf );
+    auto it = mResults->mPlacements.find( key );
+    if ( it != mResults->mPlacements.end() )
+    {
+      // several labels were placed for this feature, so it's not known which one a placement belongs to
+      it->width = -1;
+      continue;
+    }
+
+    QgsPreviousLabelPlacement placement;
+    placement.featureBounds = lf->feature().geometry().boundingBox();
+    placement.width = label->getWidth();
+    placement.height = label->getHeight();
+    placement.quadrant = label->getQuadrant();
+    placement.reversed = label->getReversed();
+    if ( label->getUpsideDown() )
+    {
+      // recreate the label as it was before being turned upright
+      placement.x = label->getX( 2 );
+      placement.y = label->getY( 2 );
+      placement.angle = label->getAlpha() + M_PI;
+    }
+    else
+    {
+      placement.x = label->getX( 0 );
+      placement.y = label->getY( 0 );
+      placement.angle = label->getAlpha();
+    }
+    mResults->mPlacements.insert( key, placement );
+  }
+}
+
 void QgsLabelingEngine::registerLabels( QgsRenderContext &context )
 {
   const QgsLabelingEngineSettings &settings = mMapSettings.labelingEngineSettings();
@@ -276,6 +471,14 @@ void QgsLabelingEngine::registerLabels( QgsRenderContext &context )
   mPal->setShowPartialLabels( settings.testFlag( QgsLabelingEngineSettings::UsePartialCandidates ) );
   mPal->setPlacementVersion( settings.placementVersion() );
 
+  if ( settings.testFlag( QgsLabelingEngineSettings::UsePreviousPlacements ) )
+  {
+    updatePlacementsSignature();
+    // a change to the settings of any provider, including those which only act as obstacles, may move any label
+    if ( mPlacementsSignature != mPreviousPlacementsSignature )
+      mPreviousPlacements.clear();
+  }
+
   // for each provider: get labels and register them in PAL
   for ( QgsAbstractLabelProvider *provider : qgis::as_const( mProviders ) )
   {
@@ -395,6 +598,9 @@ void QgsLabelingEngine::solve( QgsRenderContext &context )
   // sort labels
   std::sort( mLabels.begin(), mLabels.end(), QgsLabelSorter( mMapSettings ) );
 
+  if ( mResults )
+    storePlacements();
+
   QgsDebugMsgLevel( QStringLiteral( "LABELING work:  %1 ms ... labels# %2" ).arg( t.elapsed() ).arg( mLabels.size() ), 4 );
 }
 
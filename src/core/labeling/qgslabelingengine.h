@@ -265,9 +265,37 @@ class CORE_EXPORT QgsLabelingEngine
     //! For internal use by the providers
     QgsLabelingResults *results() const { return mResults.get(); }
 
+    /**
+     * Sets the labeling \a results from the previous render of the map.
+     *
+     * If the QgsLabelingEngineSettings::UsePreviousPlacements flag is set, labels which were placed
+     * in the previous results and which remain fully visible will keep their placement. The placements
+     * are copied from \a results, which does not need to outlive the engine.
+     *
+     * \since QGIS 3.18
+     */
+    void setPreviousResults( const QgsLabelingResults *results );
+
   protected:
     void processProvider( QgsAbstractLabelProvider *provider, QgsRenderContext &context, pal::Pal &p );
 
+  private:
+
+    /**
+     * Returns TRUE if the placements from the previous results can be reused for the
+     * labels of \a provider.
+     */
+    bool canUsePreviousPlacements( QgsAbstractLabelProvider *provider ) const;
+
+    //! Restores the placement of the label \a feature from the previous results, if it is still valid
+    void applyPreviousPlacement( QgsLabelFeature *feature ) const;
+
+    //! Stores the placements of the solved labels in the results, so that they can be reused by the next render
+    void storePlacements();
+
+    //! Computes the signature of the labeling configuration, which must match the one of the previous placements to reuse them
+    void updatePlacementsSignature();
+
   protected:
 
     /**
@@ -322,6 +350,17 @@ class CORE_EXPORT QgsLabelingEngine
     QList<pal::LabelPosition *> mUnlabeled;
     QList<pal::LabelPosition *> mLabels;
 
+  private:
+
+    //! Placements from the previous results, by label provider and feature id
+    QHash< QString, QgsPreviousLabelPlacement > mPreviousPlacements;
+    //! Destination CRS of the map for the previous placements
+    QgsCoordinateReferenceSystem mPreviousPlacementsCrs;
+    //! Signature of the labeling configuration for the previous placements
+    QByteArray mPreviousPlacementsSignature;
+    //! Signature of the current labeling configuration
+    QByteArray mPlacementsSignature;
+
 };
 
 /**
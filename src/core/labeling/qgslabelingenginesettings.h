@@ -40,6 +40,7 @@ class CORE_EXPORT QgsLabelingEngineSettings
       DrawLabelRectOnly     = 1 << 4,  //!< Whether to only draw the label rect and not the actual label text (used for unit tests)
       DrawCandidates        = 1 << 5,  //!< Whether to draw rectangles of generated candidates (good for debugging)
       DrawUnplacedLabels    = 1 << 6,  //!< Whether to render unplaced labels as an indicator/warning for users
+      UsePreviousPlacements = 1 << 7,  //!< Whether labels which were placed by the previous render of the map and remain fully visible should keep their placement, instead of being placed from scratch (since QGIS 3.18)
     };
     Q_DECLARE_FLAGS( Flags, Flag )
 
@@ -46,6 +46,7 @@
 #include "qgslabelthinningsettings.h"
 #include "qgslabellinesettings.h"
 #include "qgslabeling.h"
+#include "qgscoordinatereferencesystem.h"
 
 class QgsTextDocument;
 
@@ -1214,6 +1215,38 @@ class CORE_EXPORT QgsLabelCandidate
 
 
 
+#ifndef SIP_RUN
+
+/**
+ * \ingroup core
+ * \brief Placement of a single label as chosen by the labeling engine, which can be reused
+ * by the next render of the map.
+ *
+ * \see QgsLabelingEngineSettings::UsePreviousPlacements
+ * \note not available in Python bindings
+ * \since QGIS 3.18
+ */
+struct CORE_EXPORT QgsPreviousLabelPlacement
+{
+  //! Bounding box of the labeled feature's geometry, used to detect features which were modified
+  QgsRectangle featureBounds;
+  //! X coordinate of the first corner of the label (before it is turned upright), in map units
+  double x = 0;
+  //! Y coordinate of the first corner of the label (before it is turned upright), in map units
+  double y = 0;
+  //! Label width, in map units. A negative width marks a placement which cannot be reused.
+  double width = 0;
+  //! Label height, in map units
+  double height = 0;
+  //! Label rotation (before it is turned upright), in radians
+  double angle = 0;
+  //! Quadrant of the label relative to the labeled point
+  int quadrant = 0;
+  //! Whether the label was reversed
+  bool reversed = false;
+};
+
+#endif
 
 /**
  * \ingroup core
@@ -1249,6 +1282,16 @@ class CORE_EXPORT QgsLabelingResults
 
     std::unique_ptr< QgsLabelSearchTree > mLabelSearchTree;
 
+#ifndef SIP_RUN
+    //! Placements of the labels, by label provider and feature id
+    QHash< QString, QgsPreviousLabelPlacement > mPlacements;
+    //! Destination CRS of the map for which the placements were computed
+    QgsCoordinateReferenceSystem mPlacementsCrs;
+    //! Signature of the labeling configuration with which the placements were computed
+    QByteArray mPlacementsSignature;
+#endif
+
+    friend class QgsLabelingEngine;
     friend class QgsPalLabeling;
     friend class QgsVectorLayerLabelProvider;
     friend class QgsVectorLayerDiagramProvider;
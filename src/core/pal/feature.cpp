@@ -2069,6 +2069,11 @@ std::vector< std::unique_ptr< LabelPosition > > FeaturePart::createCandidates( P
   {
     lPos.emplace_back( qgis::make_unique< LabelPosition> ( 0, mLF->fixedPosition().x(), mLF->fixedPosition().y(), getLabelWidth( angle ), getLabelHeight( angle ), angle, 0.0, this, false, LabelPosition::Quadrant::QuadrantOver ) );
   }
+  else if ( const QgsPreviousLabelPlacement *previous = mLF->previousPlacement() )
+  {
+    // keep the label where it was placed by the previous render of the map
+    lPos.emplace_back( qgis::make_unique< LabelPosition> ( 0, previous->x, previous->y, previous->width, previous->height, previous->angle, 0.0, this, previous->reversed, static_cast< LabelPosition::Quadrant >( previous->quadrant ) ) );
+  }
   else
   {
     switch ( type )
@@ -432,6 +432,14 @@ void LabelPosition::insertIntoIndex( PalRtree<LabelPosition> &index )
   index.insert( this, QgsRectangle( amin[0], amin[1], amax[0], amax[1] ) );
 }
 
+void LabelPosition::insertIntoIndex( PalStaticRtree<LabelPosition> &index )
+{
+  double amin[2];
+  double amax[2];
+  getBoundingBox( amin, amax );
+  index.add( this, QgsRectangle( amin[0], amin[1], amax[0], amax[1] ) );
+}
+
 double LabelPosition::getDistanceToPoint( double xp, double yp ) const
 {
   //first check if inside, if so then distance is -1
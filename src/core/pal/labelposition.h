@@ -36,6 +36,7 @@
 #include "qgis_core.h"
 #include "pointset.h"
 #include "palrtree.h"
+#include "palstaticrtree.h"
 #include <fstream>
 
 namespace pal
@@ -303,6 +304,13 @@ namespace pal
        */
       void insertIntoIndex( PalRtree<LabelPosition> &index );
 
+      /**
+       * Adds the label position to the specified static \a index.
+       *
+       * \since QGIS 3.18
+       */
+      void insertIntoIndex( PalStaticRtree<LabelPosition> &index );
+
     protected:
 
       int id;
@@ -41,9 +41,12 @@
 #include "internalexception.h"
 #include "util.h"
 #include "palrtree.h"
+#include "palstaticrtree.h"
 #include "qgssettings.h"
 #include <cfloat>
 #include <list>
+#include <QtConcurrentMap>
+#include <QThread>
 
 using namespace pal;
 
@@ -96,9 +99,8 @@ std::unique_ptr<Problem> Pal::extract( const QgsRectangle &extent, const QgsGeom
   // and the consequence of inserting coordinates outside this extent is worse than the consequence of setting this value too large.)
   const QgsRectangle maxCoordinateExtentForSpatialIndices = extent.buffered( std::max( extent.width(), extent.height() ) * 1000 );
 
-  // to store obstacles
-  PalRtree< FeaturePart > obstacles( maxCoordinateExtentForSpatialIndices );
-  PalRtree< LabelPosition > allCandidatesFirstRound( maxCoordinateExtentForSpatialIndices );
+  // candidates are tested against obstacles once all of them are created, so they are stored in a static index
+  PalStaticRtree< LabelPosition > allCandidatesFirstRound;
   std::vector< FeaturePart * > allObstacleParts;
   std::unique_ptr< Problem > prob = qgis::make_unique< Problem >( maxCoordinateExtentForSpatialIndices );
 
@@ -156,6 +158,11 @@ std::unique_ptr<Problem> Pal::extract( const QgsRectangle &extent, const QgsGeom
     QMutexLocker locker( &layer->mMutex );
 
     // generate candidates for all features
+    std::vector< std::vector< std::unique_ptr< LabelPosition > > > layerCandidates = createCandidates( layer->mFeatureParts );
+    if ( isCanceled() )
+      return nullptr;
+
+    std::size_t featurePartIndex = 0;
     for ( FeaturePart *featurePart : qgis::as_const( layer->mFeatureParts ) )
     {
       if ( isCanceled() )
@@ -165,7 +172,6 @@ std::unique_ptr<Problem> Pal::extract( const QgsRectangle &extent, const QgsGeom
       for ( int i = 0; i < featurePart->getNumSelfObstacles(); i++ )
       {
         FeaturePart *selfObstacle =  featurePart->getSelfObstacle( i );
-        obstacles.insert( selfObstacle, selfObstacle->boundingBox() );
         allObstacleParts.emplace_back( selfObstacle );
 
         if ( !featurePart->getSelfObstacle( i )->getHoleOf() )
@@ -174,11 +180,8 @@ std::unique_ptr<Problem> Pal::extract( const QgsRectangle &extent, const QgsGeom
         }
       }
 
-      // generate candidates for the feature part
-      std::vector< std::unique_ptr< LabelPosition > > candidates = featurePart->createCandidates( this );
-
-      if ( isCanceled() )
-        break;
+      // candidates for the feature part
+      std::vector< std::unique_ptr< LabelPosition > > candidates = std::move( layerCandidates[ featurePartIndex++ ] );
 
       // purge candidates that are outside the bbox
       candidates.erase( std::remove_if( candidates.begin(), candidates.end(), [&mapBoundaryPrepared, this]( std::unique_ptr< LabelPosition > &candidate )
@@ -246,8 +249,6 @@ std::unique_ptr<Problem> Pal::extract( const QgsRectangle &extent, const QgsGeom
       if ( isCanceled() )
         break; // do not continue searching
 
-      // insert into obstacles
-      obstacles.insert( obstaclePart, obstaclePart->boundingBox() );
       allObstacleParts.emplace_back( obstaclePart );
       obstacleCount++;
     }
@@ -280,6 +281,8 @@ std::unique_ptr<Problem> Pal::extract( const QgsRectangle &extent, const QgsGeom
 
   if ( !features.empty() )
   {
+    allCandidatesFirstRound.finish();
+
     // Filtering label positions against obstacles
     for ( FeaturePart *obstaclePart : allObstacleParts )
     {
@@ -310,6 +313,7 @@ std::unique_ptr<Problem> Pal::extract( const QgsRectangle &extent, const QgsGeom
       return nullptr;
     }
 
+    PalStaticRtree< LabelPosition > allCandidates;
     int idlp = 0;
     for ( std::size_t i = 0; i < prob->mFeatureCount; i++ ) /* foreach feature into prob */
     {
@@ -415,11 +419,15 @@ std::unique_ptr<Problem> Pal::extract( const QgsRectangle &extent, const QgsGeom
       for ( std::unique_ptr< LabelPosition > &candidate : feat->candidates )
       {
         candidate->insertIntoIndex( prob->allCandidatesIndex() );
+        candidate->insertIntoIndex( allCandidates );
         candidate->setProblemIds( static_cast< int >( i ), idlp++ );
       }
       features.emplace_back( std::move( feat ) );
     }
 
+    // the candidates don't change while counting their overlaps, so use a static index which is faster to query
+    allCandidates.finish();
+
     int nbOverlaps = 0;
 
     double amin[2];
@@ -445,7 +453,7 @@ std::unique_ptr<Problem> Pal::extract( const QgsRectangle &extent, const QgsGeom
 
         // lookup for overlapping candidate
         lp->getBoundingBox( amin, amax );
-        prob->allCandidatesIndex().intersects( QgsRectangle( amin[0], amin[1], amax[0], amax[1] ), [&lp]( const LabelPosition * lp2 )->bool
+        allCandidates.intersects( QgsRectangle( amin[0], amin[1], amax[0], amax[1] ), [&lp]( const LabelPosition * lp2 )->bool
         {
           if ( lp->isInConflict( lp2 ) )
           {
@@ -472,6 +480,54 @@ std::unique_ptr<Problem> Pal::extract( const QgsRectangle &extent, const QgsGeom
   return prob;
 }
 
+std::vector< std::vector< std::unique_ptr< LabelPosition > > > Pal::createCandidates( const QLinkedList< FeaturePart * > &parts )
+{
+  const std::vector< FeaturePart * > partList( parts.constBegin(), parts.constEnd() );
+  std::vector< std::vector< std::unique_ptr< LabelPosition > > > candidates( partList.size() );
+
+  // group the parts by label feature, in order of first appearance
+  std::vector< std::vector< std::size_t > > groups;
+  QHash< QgsLabelFeature *, std::size_t > groupIndex;
+  for ( std::size_t i = 0; i < partList.size(); ++i )
+  {
+    QgsLabelFeature *labelFeature = partList[i]->feature();
+    auto it = groupIndex.constFind( labelFeature );
+    if ( it == groupIndex.constEnd() )
+    {
+      groupIndex.insert( labelFeature, groups.size() );
+      groups.emplace_back( std::vector< std::size_t >{ i } );
+    }
+    else
+    {
+      groups[ it.value() ].push_back( i );
+    }
+  }
+
+  auto createGroupCandidates = [this, &partList, &candidates]( const std::vector< std::size_t > &group )
+  {
+    for ( std::size_t index : group )
+    {
+      if ( isCanceled() )
+        return;
+
+      candidates[ index ] = partList[ index ]->createCandidates( this );
+    }
+  };
+
+  // each part gets its own slot in the result, so the outcome does not depend on the scheduling of the tasks
+  if ( groups.size() < 2 * static_cast< std::size_t >( QThread::idealThreadCount() ) )
+  {
+    for ( const std::vector< std::size_t > &group : groups )
+      createGroupCandidates( group );
+  }
+  else
+  {
+    QtConcurrent::blockingMap( groups, createGroupCandidates );
+  }
+
+  return candidates;
+}
+
 void Pal::registerCancellationCallback( Pal::FnIsCanceled fnCanceled, void *context )
 {
   fnIsCanceled = fnCanceled;
@@ -492,7 +548,7 @@ QList<LabelPosition *> Pal::solveProblem( Problem *prob, bool displayAll, QList<
 
   try
   {
-    prob->chain_search();
+    prob->chainSearchByComponent();
   }
   catch ( InternalException::Empty & )
   {
@@ -39,6 +39,7 @@
 #include "qgspallabeling.h"
 #include "qgslabelingenginesettings.h"
 #include <QList>
+#include <QLinkedList>
 #include <iostream>
 #include <ctime>
 #include <QMutex>
@@ -56,6 +57,7 @@ namespace pal
   class PalStat;
   class Problem;
   class PointSet;
+  class FeaturePart;
 
   //! Search method to use
   enum SearchMethod
@@ -285,6 +287,15 @@ namespace pal
        */
       std::unique_ptr< Problem > extract( const QgsRectangle &extent, const QgsGeometry &mapBoundary );
 
+      /**
+       * Generates the label candidates for all feature \a parts, returning a list of candidates
+       * for each part in the same order as \a parts.
+       *
+       * Candidates are generated concurrently. All parts which belong to the same label feature
+       * are handled by the same task, as they share the geometries of this feature.
+       */
+      std::vector< std::vector< std::unique_ptr< LabelPosition > > > createCandidates( const QLinkedList< FeaturePart * > &parts );
+
       /**
        * \brief Choose the size of popmusic subpart's
        * \param r subpart size
@@ -0,0 +1,125 @@
+/***************************************************************************
+  palstaticrtree.h
+  ------------------------
+  Date                 : February 2021
+  Copyright            : (C) 2021 by QGIS.org
+  Email                : info at qgis dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsrectangle.h"
+#include "qgspackedhilbertrtree.h"
+#include <functional>
+#include <vector>
+
+#ifndef QGSPALSTATICRTREE_H
+#define QGSPALSTATICRTREE_H
+
+#define SIP_NO_FILE
+
+/**
+ * \ingroup core
+ * \class PalStaticRtree
+ *
+ * A packed, static rtree spatial index for use in the pal labeling engine.
+ *
+ * Unlike PalRtree, data cannot be added or removed once the index is built. All data is
+ * added with add(), and finish() must be called before querying the index. The index then
+ * builds a QgsPackedHilbertRTree of the data, which makes it much faster to build and query
+ * than PalRtree when the indexed data doesn't change, e.g. for the candidates of a labeling problem.
+ *
+ * \note Not available in Python bindings.
+ * \since QGIS 3.18
+ */
+template <typename T>
+class PalStaticRtree
+{
+  public:
+
+    /**
+     * Constructor for PalStaticRtree, reserving space for \a count data objects.
+     */
+    explicit PalStaticRtree( std::size_t count = 0 )
+    {
+      mData.reserve( count );
+      mBoxes.reserve( count * 4 );
+    }
+
+    /**
+     * Adds new \a data to the spatial index, with the specified \a bounds.
+     *
+     * Must be called before finish(). Ownership of \a data is not transferred, and it is the caller's
+     * responsibility to ensure that it exists for the lifetime of the spatial index.
+     */
+    void add( T *data, const QgsRectangle &bounds )
+    {
+      Q_ASSERT( !mFinished );
+      mData.emplace_back( data );
+      mBoxes.emplace_back( bounds.xMinimum() );
+      mBoxes.emplace_back( bounds.yMinimum() );
+      mBoxes.emplace_back( bounds.xMaximum() );
+      mBoxes.emplace_back( bounds.yMaximum() );
+    }
+
+    /**
+     * Builds the spatial index from the data added with add().
+     *
+     * Must be called once, before the index is queried.
+     */
+    void finish()
+    {
+      Q_ASSERT( !mFinished );
+      mFinished = true;
+
+      mTree = QgsPackedHilbertRTree( mBoxes );
+      mBoxes = std::vector< double >();
+
+      // data, in the order of the leaves of the tree
+      const std::vector< std::size_t > &order = mTree.leafOrder();
+      std::vector< T * > data( mData.size() );
+      for ( std::size_t i = 0; i < data.size(); ++i )
+        data[i] = mData[order[i]];
+      mData = std::move( data );
+    }
+
+    /**
+     * Returns the number of data objects in the index.
+     */
+    std::size_t size() const { return mData.size(); }
+
+    /**
+     * Performs an intersection check against the index, for data intersecting the specified \a bounds.
+     *
+     * The \a callback function will be called once for each matching data object encountered. If the callback
+     * returns FALSE, the search is stopped.
+     */
+    bool intersects( const QgsRectangle &bounds, const std::function< bool( T *data )> &callback ) const
+    {
+      Q_ASSERT( mFinished );
+      mTree.intersects( bounds, [this, &callback]( std::size_t position )
+      {
+        return callback( mData[position] );
+      } );
+      return true;
+    }
+
+  private:
+
+    bool mFinished = false;
+
+    //! Data, in the order of the leaves of the tree once the index is built
+    std::vector< T * > mData;
+
+    //! Boxes of the data added before the index is built
+    std::vector< double > mBoxes;
+
+    QgsPackedHilbertRTree mTree;
+};
+
+#endif
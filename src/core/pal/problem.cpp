@@ -39,6 +39,9 @@
 #include "internalexception.h"
 #include <cfloat>
 #include <limits> //for std::numeric_limits<int>::max()
+#include <numeric>
+#include <atomic>
+#include <QtConcurrentMap>
 
 #include "qgslabelingengine.h"
 
@@ -55,7 +58,8 @@ inline void delete_chain( Chain *chain )
 }
 
 Problem::Problem( const QgsRectangle &extent )
-  : mAllCandidatesIndex( extent )
+  : mExtent( extent )
+  , mAllCandidatesIndex( extent )
   , mActiveCandidatesIndex( extent )
 {
 
@@ -654,6 +658,144 @@ void Problem::chain_search()
   delete[] ok;
 }
 
+std::vector< std::vector< int > > Problem::conflictComponents() const
+{
+  // union-find over problem features, linking features with conflicting candidates
+  std::vector< int > parent( mFeatureCount );
+  std::iota( parent.begin(), parent.end(), 0 );
+  auto findRoot = [&parent]( int feature )
+  {
+    while ( parent[ feature ] != feature )
+    {
+      parent[ feature ] = parent[ parent[ feature ] ];
+      feature = parent[ feature ];
+    }
+    return feature;
+  };
+
+  double amin[2];
+  double amax[2];
+  for ( int i = 0; i < static_cast< int >( mFeatureCount ); i++ )
+  {
+    for ( int j = 0; j < mFeatNbLp[i]; j++ )
+    {
+      const LabelPosition *lp = mLabelPositions[ mFeatStartId[i] + j ].get();
+      lp->getBoundingBox( amin, amax );
+      mAllCandidatesIndex.intersects( QgsRectangle( amin[0], amin[1], amax[0], amax[1] ), [lp, i, &parent, &findRoot]( const LabelPosition * lp2 ) -> bool
+      {
+        const int rootA = findRoot( i );
+        const int rootB = findRoot( lp2->getProblemFeatureId() );
+        // only test for conflicts which would merge two components
+        if ( rootA != rootB && lp->isInConflict( lp2 ) )
+        {
+          parent[ std::max( rootA, rootB ) ] = std::min( rootA, rootB );
+        }
+        return true;
+      } );
+    }
+  }
+
+  std::vector< std::vector< int > > components;
+  std::vector< int > componentIndex( mFeatureCount, -1 );
+  for ( int i = 0; i < static_cast< int >( mFeatureCount ); i++ )
+  {
+    const int root = findRoot( i );
+    if ( componentIndex[ root ] < 0 )
+    {
+      componentIndex[ root ] = static_cast< int >( components.size() );
+      components.emplace_back();
+    }
+    components[ componentIndex[ root ] ].push_back( i );
+  }
+  return components;
+}
+
+void Problem::chainSearchByComponent()
+{
+  if ( mFeatureCount == 0 )
+    return;
+
+  const std::vector< std::vector< int > > components = conflictComponents();
+  if ( components.size() == 1 )
+  {
+    // a single component is exactly the whole problem
+    chain_search();
+    return;
+  }
+
+  // move the remaining candidates of each component into a problem of its own, with local ids
+  std::vector< std::unique_ptr< Problem > > subProblems;
+  subProblems.reserve( components.size() );
+  for ( const std::vector< int > &component : components )
+  {
+    std::unique_ptr< Problem > subProblem = qgis::make_unique< Problem >( mExtent );
+    subProblem->pal = pal;
+    subProblem->mDisplayAll = mDisplayAll;
+    subProblem->mFeatureCount = component.size();
+    subProblem->mFeatStartId.reserve( component.size() );
+    subProblem->mFeatNbLp.reserve( component.size() );
+    subProblem->mInactiveCost.reserve( component.size() );
+
+    int lpId = 0;
+    for ( int localFeature = 0; localFeature < static_cast< int >( component.size() ); localFeature++ )
+    {
+      const int feature = component[ localFeature ];
+      subProblem->mFeatStartId.push_back( lpId );
+      subProblem->mFeatNbLp.push_back( mFeatNbLp[ feature ] );
+      subProblem->mInactiveCost.push_back( mInactiveCost[ feature ] );
+      for ( int j = 0; j < mFeatNbLp[ feature ]; j++ )
+      {
+        std::unique_ptr< LabelPosition > &lp = mLabelPositions[ mFeatStartId[ feature ] + j ];
+        lp->setProblemIds( localFeature, lpId++ );
+        lp->insertIntoIndex( subProblem->mAllCandidatesIndex );
+        subProblem->mLabelPositions.emplace_back( std::move( lp ) );
+      }
+    }
+    subProblem->mTotalCandidates = lpId;
+    subProblem->mAllNblp = lpId;
+    subProblems.emplace_back( std::move( subProblem ) );
+  }
+
+  std::atomic< bool > emptyQueue( false );
+  QtConcurrent::blockingMap( subProblems, [&emptyQueue]( std::unique_ptr< Problem > &subProblem )
+  {
+    try
+    {
+      subProblem->chain_search();
+    }
+    catch ( InternalException::Empty & )
+    {
+      emptyQueue = true;
+    }
+  } );
+
+  // move the candidates back, and merge the solutions
+  mSol.init( mFeatureCount );
+  for ( std::size_t c = 0; c < components.size(); c++ )
+  {
+    const std::vector< int > &component = components[ c ];
+    Problem *subProblem = subProblems[ c ].get();
+    int lpId = 0;
+    for ( int localFeature = 0; localFeature < static_cast< int >( component.size() ); localFeature++ )
+    {
+      const int feature = component[ localFeature ];
+      for ( int j = 0; j < mFeatNbLp[ feature ]; j++ )
+      {
+        std::unique_ptr< LabelPosition > &lp = subProblem->mLabelPositions[ lpId++ ];
+        lp->setProblemIds( feature, mFeatStartId[ feature ] + j );
+        mLabelPositions[ mFeatStartId[ feature ] + j ] = std::move( lp );
+      }
+
+      const int localLabel = localFeature < static_cast< int >( subProblem->mSol.activeLabelIds.size() ) ? subProblem->mSol.activeLabelIds[ localFeature ] : -1;
+      mSol.activeLabelIds[ feature ] = localLabel < 0 ? -1 : mFeatStartId[ feature ] + localLabel - subProblem->mFeatStartId[ localFeature ];
+    }
+    mSol.totalCost += subProblem->mSol.totalCost;
+  }
+
+  if ( emptyQueue )
+    throw InternalException::Empty();
+}
+
 QList<LabelPosition *> Problem::getSolution( bool returnInactive, QList<LabelPosition *> *unlabeled )
 {
   QList<LabelPosition *> finalLabelPlacements;
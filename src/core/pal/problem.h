@@ -117,6 +117,18 @@ namespace pal
        */
       void chain_search();
 
+      /**
+       * Runs chain_search() concurrently on each group of features whose candidates can conflict with each
+       * other (the connected components of the conflict graph).
+       *
+       * Features from different groups can never affect each other's placement, so each group is solved as an
+       * independent problem. The groups are built and solved in a fixed order, so the result only depends on the
+       * problem and not on the number of threads used.
+       *
+       * \since QGIS 3.18
+       */
+      void chainSearchByComponent();
+
       /**
        * Solves the labeling problem, selecting the best candidate locations for all labels and returns a list of these
        * calculated label positions.
@@ -154,6 +166,16 @@ namespace pal
 
     private:
 
+      /**
+       * Returns the groups of features whose candidates conflict with each other, directly or through other
+       * features. Each group lists problem feature ids in increasing order, and groups are sorted by their first
+       * feature.
+       */
+      std::vector< std::vector< int > > conflictComponents() const;
+
+      //! Bounds of the incoming coordinates, used for the spatial indexes of the problem
+      QgsRectangle mExtent;
+
       /**
        * Total number of layers containing labels
        */
@@ -28,6 +28,7 @@
 #include "qgsprocessingparametertype.h"
 #include "qgsexpressioncontextutils.h"
 #include "qgsprocessingmodelgroupbox.h"
+#include "qgsprocessingfeaturestream_p.h"
 
 #include <QFile>
 #include <QTextStream>
@@ -45,6 +46,10 @@ void QgsProcessingModelAlgorithm::initAlgorithm( const QVariantMap & )
   std::unique_ptr< QgsProcessingParameterBoolean > verboseLog = qgis::make_unique< QgsProcessingParameterBoolean >( QStringLiteral( "VERBOSE_LOG" ), QObject::tr( "Verbose logging" ), false, true );
   verboseLog->setFlags( verboseLog->flags() | QgsProcessingParameterDefinition::FlagHidden );
   addParameter( verboseLog.release() );
+
+  std::unique_ptr< QgsProcessingParameterBoolean > pipelineFeatures = qgis::make_unique< QgsProcessingParameterBoolean >( QStringLiteral( "PIPELINE_FEATURES" ), QObject::tr( "Stream features between algorithms" ), false, true );
+  pipelineFeatures->setFlags( pipelineFeatures->flags() | QgsProcessingParameterDefinition::FlagHidden );
+  addParameter( pipelineFeatures.release() );
 }
 
 QString QgsProcessingModelAlgorithm::name() const
@@ -260,6 +265,93 @@ bool QgsProcessingModelAlgorithm::childOutputIsRequired( const QString &childId,
   return false;
 }
 
+bool QgsProcessingModelAlgorithm::childOutputCanBeStreamed( const QString &childId, const QSet< QString > &toExecute ) const
+{
+  const QgsProcessingModelChildAlgorithm &child = mChildAlgorithms[ childId ];
+  if ( !dynamic_cast< const QgsProcessingFeatureBasedAlgorithm * >( child.algorithm() )
+       || child.algorithm()->flags() & QgsProcessingAlgorithm::FlagPruneModelBranchesBasedOnAlgorithmResults
+       || !child.modelOutputs().isEmpty() )
+    return false;
+
+  // expression variables for the outputs of this child, which can't be evaluated from streamed features
+  QStringList outputVariablePrefixes;
+  const QgsProcessingOutputDefinitions outputDefinitions = child.algorithm()->outputDefinitions();
+  for ( const QgsProcessingOutputDefinition *outputDef : outputDefinitions )
+  {
+    QString name = QStringLiteral( "%1_%2" ).arg( child.description().isEmpty() ? childId : child.description(), outputDef->name() );
+    outputVariablePrefixes << name.replace( QRegularExpression( QStringLiteral( "[\\s'\"\\(\\):\\.]" ) ), QStringLiteral( "_" ) );
+  }
+  auto refersToOutputs = [&outputVariablePrefixes]( const QSet< QString > &variables )->bool
+  {
+    for ( const QString &variable : variables )
+    {
+      for ( const QString &prefix : outputVariablePrefixes )
+      {
+        if ( variable.startsWith( prefix ) )
+          return true;
+      }
+    }
+    return false;
+  };
+
+  // find the algorithms which directly depend on this child -- there must be exactly one
+  QString dependentId;
+  QMap< QString, QgsProcessingModelChildAlgorithm >::const_iterator childIt = mChildAlgorithms.constBegin();
+  for ( ; childIt != mChildAlgorithms.constEnd(); ++childIt )
+  {
+    if ( childIt->childId() == childId || !childIt->isActive() )
+      continue;
+
+    bool isDependent = false;
+    const QList< QgsProcessingModelChildDependency > constDependencies = childIt->dependencies();
+    for ( const QgsProcessingModelChildDependency &dep : constDependencies )
+    {
+      if ( dep.childId == childId )
+      {
+        isDependent = true;
+        break;
+      }
+    }
+
+    const QMap<QString, QgsProcessingModelChildParameterSources> childParams = childIt->parameterSources();
+    QMap<QString, QgsProcessingModelChildParameterSources>::const_iterator paramIt = childParams.constBegin();
+    for ( ; paramIt != childParams.constEnd(); ++paramIt )
+    {
+      for ( const QgsProcessingModelChildParameterSource &source : paramIt.value() )
+      {
+        if ( source.source() == QgsProcessingModelChildParameterSource::ChildOutput && source.outputChildId() == childId )
+        {
+          isDependent = true;
+          // the features can only be streamed to the input features of a feature based algorithm
+          const QgsProcessingFeatureBasedAlgorithm *featureBasedAlg = dynamic_cast< const QgsProcessingFeatureBasedAlgorithm * >( childIt->algorithm() );
+          if ( !featureBasedAlg || paramIt.key() != featureBasedAlg->inputParameterName() || paramIt.value().size() != 1 )
+            return false;
+        }
+        else if ( source.source() == QgsProcessingModelChildParameterSource::Expression
+                  && refersToOutputs( QgsExpression( source.expression() ).referencedVariables() ) )
+        {
+          return false;
+        }
+        else if ( source.source() == QgsProcessingModelChildParameterSource::ExpressionText
+                  && refersToOutputs( QgsExpression::referencedVariables( source.expressionText() ) ) )
+        {
+          return false;
+        }
+      }
+    }
+
+    if ( !isDependent )
+      continue;
+
+    if ( !dependentId.isEmpty() )
+      return false;
+
+    dependentId = childIt->childId();
+  }
+
+  return !dependentId.isEmpty() && toExecute.contains( dependentId );
+}
+
 QVariantMap QgsProcessingModelAlgorithm::processAlgorithm( const QVariantMap &parameters, QgsProcessingContext &context, QgsProcessingFeedback *feedback )
 {
   QSet< QString > toExecute;
@@ -289,6 +381,12 @@ QVariantMap QgsProcessingModelAlgorithm::processAlgorithm( const QVariantMap &pa
   QVariantMap childInputs;
 
   const bool verboseLog = parameterAsBool( parameters, QStringLiteral( "VERBOSE_LOG" ), context );
+  const bool pipelineFeatures = parameterAsBool( parameters, QStringLiteral( "PIPELINE_FEATURES" ), context );
+
+  // streams for the outputs of child algorithms which are piped to the next algorithm, rather than being written to a layer
+  std::vector< std::unique_ptr< QgsProcessingFeatureStream > > streams;
+  QHash< QObject *, QString > streamChildIds;
+  QSet< QString > streamed;
 
   QVariantMap finalResults;
   QSet< QString > executed;
@@ -336,9 +434,21 @@ QVariantMap QgsProcessingModelAlgorithm::processAlgorithm( const QVariantMap &pa
       if ( feedback && !skipGenericLogging )
         feedback->setProgressText( QObject::tr( "Running %1 [%2/%3]" ).arg( child.description() ).arg( executed.count() + 1 ).arg( toExecute.count() ) );
 
-      childInputs.insert( childId, childParams );
+      // streams only exist while the model runs, so the inputs which are kept refer to the child algorithm producing them instead
+      QVariantMap inputParams = childParams;
+      for ( auto inputParamIt = inputParams.begin(); inputParamIt != inputParams.end(); ++inputParamIt )
+      {
+        if ( inputParamIt.value().canConvert< QObject * >() )
+        {
+          const auto streamIt = streamChildIds.constFind( inputParamIt.value().value< QObject * >() );
+          if ( streamIt != streamChildIds.constEnd() )
+            inputParamIt.value() = streamIt.value();
+        }
+      }
+
+      childInputs.insert( childId, inputParams );
       QStringList params;
-      for ( auto childParamIt = childParams.constBegin(); childParamIt != childParams.constEnd(); ++childParamIt )
+      for ( auto childParamIt = inputParams.constBegin(); childParamIt != inputParams.constEnd(); ++childParamIt )
       {
         params << QStringLiteral( "%1: %2" ).arg( childParamIt.key(),
                child.algorithm()->parameterDefinition( childParamIt.key() )->valueAsPythonString( childParamIt.value(), context ) );
@@ -353,12 +463,39 @@ QVariantMap QgsProcessingModelAlgorithm::processAlgorithm( const QVariantMap &pa
       QElapsedTimer childTime;
       childTime.start();
 
-      bool ok = false;
-      QVariantMap results = childAlg->run( childParams, context, &modelFeedback, &ok, child.configuration() );
-      if ( !ok )
+      QVariantMap results;
+      if ( pipelineFeatures && childOutputCanBeStreamed( childId, toExecute ) )
       {
-        const QString error = ( childAlg->flags() & QgsProcessingAlgorithm::FlagCustomException ) ? QString() : QObject::tr( "Error encountered while running %1" ).arg( child.description() );
-        throw QgsProcessingException( error );
+        // the features of this child are computed while the dependent algorithm iterates over them
+        QString message;
+        if ( !childAlg->checkParameterValues( childParams, context, &message ) )
+          throw QgsProcessingException( message.isEmpty() ? QObject::tr( "Error encountered while running %1" ).arg( child.description() ) : message );
+
+        std::unique_ptr< QgsProcessingFeatureBasedAlgorithm > featureBasedAlg( static_cast< QgsProcessingFeatureBasedAlgorithm * >( childAlg->create( child.configuration() ) ) );
+        if ( !featureBasedAlg->prepare( childParams, context, &modelFeedback ) )
+          throw QgsProcessingException( QObject::tr( "Error encountered while running %1" ).arg( child.description() ) );
+        featureBasedAlg->prepareSource( childParams, context );
+
+        QgsExpressionContext streamContext = context.expressionContext();
+        streamContext.appendScopes( featureBasedAlg->createExpressionContext( childParams, context, featureBasedAlg->mSource.get() ).takeScopes() );
+
+        streams.emplace_back( qgis::make_unique< QgsProcessingFeatureStream >( std::move( featureBasedAlg ), context, streamContext, &modelFeedback ) );
+        results.insert( QStringLiteral( "OUTPUT" ), QVariant::fromValue< QObject * >( streams.back().get() ) );
+        streamChildIds.insert( streams.back().get(), childId );
+        streamed.insert( childId );
+
+        if ( feedback && !skipGenericLogging )
+          feedback->pushInfo( QObject::tr( "Features will be streamed to the next algorithm" ) );
+      }
+      else
+      {
+        bool ok = false;
+        results = childAlg->run( childParams, context, &modelFeedback, &ok, child.configuration() );
+        if ( !ok )
+        {
+          const QString error = ( childAlg->flags() & QgsProcessingAlgorithm::FlagCustomException ) ? QString() : QObject::tr( "Error encountered while running %1" ).arg( child.description() );
+          throw QgsProcessingException( error );
+        }
       }
       childResults.insert( childId, results );
 
@@ -439,7 +576,8 @@ QVariantMap QgsProcessingModelAlgorithm::processAlgorithm( const QVariantMap &pa
 
       childAlg.reset( nullptr );
       modelFeedback.setCurrentStep( executed.count() );
-      if ( feedback && !skipGenericLogging )
+      // streamed children only run while their features are read by the next algorithm
+      if ( feedback && !skipGenericLogging && !streamed.contains( childId ) )
         feedback->pushInfo( QObject::tr( "OK. Execution took %1 s (%2 outputs)." ).arg( childTime.elapsed() / 1000.0 ).arg( results.count() ) );
     }
 
@@ -449,6 +587,10 @@ QVariantMap QgsProcessingModelAlgorithm::processAlgorithm( const QVariantMap &pa
   if ( feedback )
     feedback->pushDebugInfo( QObject::tr( "Model processed OK. Executed %1 algorithms total in %2 s." ).arg( executed.count() ).arg( totalTime.elapsed() / 1000.0 ) );
 
+  // streamed outputs are only valid while the model runs
+  for ( const QString &childId : qgis::as_const( streamed ) )
+    childResults.insert( childId, QVariantMap() );
+
   mResults = finalResults;
   mResults.insert( QStringLiteral( "CHILD_RESULTS" ), childResults );
   mResults.insert( QStringLiteral( "CHILD_INPUTS" ), childInputs );
@@ -1348,7 +1490,7 @@ QVariant QgsProcessingModelAlgorithm::toVariant() const
   QVariantMap paramDefMap;
   for ( const QgsProcessingParameterDefinition *def : mParameters )
   {
-    if ( def->name() == QLatin1String( "VERBOSE_LOG" ) )
+    if ( def->name() == QLatin1String( "VERBOSE_LOG" ) || def->name() == QLatin1String( "PIPELINE_FEATURES" ) )
       continue;
 
     paramDefMap.insert( def->name(), def->toVariantMap() );
@@ -1424,7 +1566,7 @@ bool QgsProcessingModelAlgorithm::loadVariant( const QVariant &model )
     // with no way for users to repair them
     if ( param )
     {
-      if ( param->name() == QLatin1String( "VERBOSE_LOG" ) )
+      if ( param->name() == QLatin1String( "VERBOSE_LOG" ) || param->name() == QLatin1String( "PIPELINE_FEATURES" ) )
         return; // internal parameter -- some versions of QGIS incorrectly stored this in the model definition file
 
       // set parameter help from help content
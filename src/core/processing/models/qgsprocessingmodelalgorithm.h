@@ -547,6 +547,15 @@ class CORE_EXPORT QgsProcessingModelAlgorithm : public QgsProcessingAlgorithm
      */
     bool childOutputIsRequired( const QString &childId, const QString &outputName ) const;
 
+    /**
+     * Returns TRUE if the output of the child algorithm with matching \a childId can be streamed
+     * to the single child algorithm which depends on it, instead of being written to a layer.
+     *
+     * This is the case when both child algorithms are feature based algorithms, the output is not
+     * a model output, and it is only used as the input features of the dependent algorithm.
+     */
+    bool childOutputCanBeStreamed( const QString &childId, const QSet< QString > &toExecute ) const;
+
     /**
      * Checks whether the output vector type given by \a outputType is compatible
      * with the list of acceptable data types specified by \a acceptableDataTypes.
@@ -30,6 +30,9 @@
 #include "qgsmeshlayer.h"
 #include "qgsexpressioncontextutils.h"
 
+#include <QThread>
+#include <QtConcurrentMap>
+
 
 QgsProcessingAlgorithm::~QgsProcessingAlgorithm()
 {
@@ -978,7 +981,7 @@ QgsCoordinateReferenceSystem QgsProcessingFeatureBasedAlgorithm::sourceCrs() con
   if ( mSource )
     return mSource->sourceCrs();
   else
-    return QgsCoordinateReferenceSystem();
+    return mParallelSourceCrs;
 }
 
 QVariantMap QgsProcessingFeatureBasedAlgorithm::processAlgorithm( const QVariantMap &parameters, QgsProcessingContext &context, QgsProcessingFeedback *feedback )
@@ -1005,9 +1008,12 @@ QVariantMap QgsProcessingFeatureBasedAlgorithm::processAlgorithm( const QVariant
   QgsFeature f;
   QgsFeatureIterator it = mSource->getFeatures( request(), sourceFlags() );
 
+  const bool processedInParallel = ( flags() & FlagSupportsParallelFeatures ) && QThread::idealThreadCount() > 1
+                                   && processFeaturesInParallel( parameters, it, sink.get(), context, feedback, count );
+
   double step = count > 0 ? 100.0 / count : 1;
   int current = 0;
-  while ( it.nextFeature( f ) )
+  while ( !processedInParallel && it.nextFeature( f ) )
   {
     if ( feedback->isCanceled() )
     {
@@ -1033,6 +1039,200 @@ QVariantMap QgsProcessingFeatureBasedAlgorithm::processAlgorithm( const QVariant
   return outputs;
 }
 
+///@cond PRIVATE
+
+/**
+ * Feedback for the features processed by a worker thread, which keeps the reported messages so that they can be
+ * forwarded to the algorithm's feedback from the main thread, in the order of the features.
+ */
+class QgsProcessingFeatureWorkerFeedback : public QgsProcessingFeedback
+{
+  public:
+
+    QgsProcessingFeatureWorkerFeedback()
+      : QgsProcessingFeedback( false )
+    {}
+
+    void reportError( const QString &error, bool fatalError ) override { mMessages.append( { fatalError ? FatalError : Error, error } ); }
+    void pushWarning( const QString &warning ) override { mMessages.append( { Warning, warning } ); }
+    void pushInfo( const QString &info ) override { mMessages.append( { Info, info } ); }
+    void pushCommandInfo( const QString &info ) override { mMessages.append( { CommandInfo, info } ); }
+    void pushDebugInfo( const QString &info ) override { mMessages.append( { DebugInfo, info } ); }
+    void pushConsoleInfo( const QString &info ) override { mMessages.append( { ConsoleInfo, info } ); }
+
+    //! Forwards the messages reported since the last call to \a feedback
+    void forwardMessages( QgsProcessingFeedback *feedback )
+    {
+      for ( const QPair< MessageType, QString > &message : qgis::as_const( mMessages ) )
+      {
+        switch ( message.first )
+        {
+          case Error:
+          case FatalError:
+            feedback->reportError( message.second, message.first == FatalError );
+            break;
+          case Warning:
+            feedback->pushWarning( message.second );
+            break;
+          case Info:
+            feedback->pushInfo( message.second );
+            break;
+          case CommandInfo:
+            feedback->pushCommandInfo( message.second );
+            break;
+          case DebugInfo:
+            feedback->pushDebugInfo( message.second );
+            break;
+          case ConsoleInfo:
+            feedback->pushConsoleInfo( message.second );
+            break;
+        }
+      }
+      mMessages.clear();
+    }
+
+  private:
+
+    enum MessageType
+    {
+      Error,
+      FatalError,
+      Warning,
+      Info,
+      CommandInfo,
+      DebugInfo,
+      ConsoleInfo,
+    };
+
+    QVector< QPair< MessageType, QString > > mMessages;
+};
+
+///@endcond
+
+bool QgsProcessingFeatureBasedAlgorithm::processFeaturesInParallel( const QVariantMap &parameters, QgsFeatureIterator &iterator, QgsFeatureSink *sink,
+    QgsProcessingContext &context, QgsProcessingFeedback *feedback, long featureCount )
+{
+  // number of features handed to each thread at once, large enough to keep the cost of synchronizing threads low
+  const std::size_t featuresPerWorker = 256;
+
+  struct Worker
+  {
+    std::unique_ptr< QgsProcessingFeatureBasedAlgorithm > algorithm;
+    std::unique_ptr< QgsProcessingContext > context;
+    std::unique_ptr< QgsProcessingFeatureWorkerFeedback > feedback;
+    std::size_t begin = 0;
+    std::size_t end = 0;
+    std::size_t errorIndex = 0;
+    QString error;
+  };
+
+  // every thread gets its own copy of the algorithm, prepared with the same parameters, and its own context.
+  // Copies are prepared with the algorithm's context, so that they resolve the same layers, and any messages
+  // they report are dropped as they were already reported when preparing the algorithm itself. The source is
+  // only read by this algorithm, so copies don't open it again and only get its CRS
+  const QgsCoordinateReferenceSystem crs = sourceCrs();
+  QgsProcessingFeedback prepareFeedback( false );
+  std::vector< Worker > workers( static_cast< std::size_t >( QThread::idealThreadCount() ) );
+  for ( Worker &worker : workers )
+  {
+    std::unique_ptr< QgsProcessingAlgorithm > algorithm( create() );
+    worker.algorithm.reset( dynamic_cast< QgsProcessingFeatureBasedAlgorithm * >( algorithm.get() ) );
+    if ( !worker.algorithm )
+      return false;
+    algorithm.release();
+
+    if ( !worker.algorithm->prepare( parameters, context, &prepareFeedback ) )
+      return false;
+    worker.algorithm->mParallelSourceCrs = crs;
+
+    worker.feedback = qgis::make_unique< QgsProcessingFeatureWorkerFeedback >();
+    worker.context = qgis::make_unique< QgsProcessingContext >();
+    worker.context->copyThreadSafeSettings( context );
+    worker.context->setFeedback( worker.feedback.get() );
+
+    QObject::connect( feedback, &QgsFeedback::canceled, worker.feedback.get(), &QgsFeedback::cancel, Qt::DirectConnection );
+  }
+
+  const std::size_t chunkSize = workers.size() * featuresPerWorker;
+  std::vector< QgsFeature > features;
+  std::vector< QgsFeatureList > results;
+  features.reserve( chunkSize );
+
+  double step = featureCount > 0 ? 100.0 / featureCount : 1;
+  long current = 0;
+  bool finished = false;
+  while ( !finished && !feedback->isCanceled() )
+  {
+    features.clear();
+    QgsFeature f;
+    while ( features.size() < chunkSize && iterator.nextFeature( f ) )
+      features.emplace_back( f );
+    finished = features.size() < chunkSize;
+    if ( features.empty() )
+      break;
+
+    results.assign( features.size(), QgsFeatureList() );
+    const std::size_t workerSize = ( features.size() + workers.size() - 1 ) / workers.size();
+    for ( std::size_t i = 0; i < workers.size(); ++i )
+    {
+      workers[i].begin = std::min( i * workerSize, features.size() );
+      workers[i].end = std::min( workers[i].begin + workerSize, features.size() );
+      workers[i].errorIndex = workers[i].end;
+    }
+
+    QtConcurrent::blockingMap( workers, [&features, &results]( Worker & worker )
+    {
+      for ( std::size_t i = worker.begin; i < worker.end; ++i )
+      {
+        if ( worker.feedback->isCanceled() )
+          break;
+
+        worker.context->expressionContext().setFeature( features[i] );
+        try
+        {
+          results[i] = worker.algorithm->processFeature( features[i], *worker.context, worker.feedback.get() );
+        }
+        catch ( QgsException &e )
+        {
+          worker.error = e.what();
+          worker.errorIndex = i;
+          break;
+        }
+        catch ( std::exception &e )
+        {
+          worker.error = QObject::tr( "Unexpected error while processing feature: %1" ).arg( QString::fromLocal8Bit( e.what() ) );
+          worker.errorIndex = i;
+          break;
+        }
+        catch ( ... )
+        {
+          worker.error = QObject::tr( "Unknown error while processing feature" );
+          worker.errorIndex = i;
+          break;
+        }
+      }
+    } );
+
+    // output features and messages are forwarded in the order of the input features, up to the first error
+    for ( Worker &worker : workers )
+    {
+      worker.feedback->forwardMessages( feedback );
+      for ( std::size_t i = worker.begin; i < worker.errorIndex; ++i )
+      {
+        for ( QgsFeature transformedFeature : results[i] )
+          sink->addFeature( transformedFeature, QgsFeatureSink::FastInsert );
+      }
+      // exceptions can't leave the worker threads, and are raised again from this thread
+      if ( worker.errorIndex < worker.end )
+        throw QgsProcessingException( worker.error );
+    }
+
+    current += static_cast< long >( features.size() );
+    feedback->setProgress( current * step );
+  }
+  return true;
+}
+
 QgsFeatureRequest QgsProcessingFeatureBasedAlgorithm::request() const
 {
   return QgsFeatureRequest();
@@ -81,6 +81,7 @@ class CORE_EXPORT QgsProcessingAlgorithm
       FlagSkipGenericModelLogging = 1 << 12, //!< When running as part of a model, the generic algorithm setup and results logging should be skipped
       FlagNotAvailableInStandaloneTool = 1 << 13, //!< Algorithm should not be available from the standalone "qgis_process" tool. Used to flag algorithms which make no sense outside of the QGIS application, such as "select by..." style algorithms.
       FlagRequiresProject = 1 << 14, //!< The algorithm requires that a valid QgsProject is available from the processing context in order to execute
+      FlagSupportsParallelFeatures = 1 << 15, //!< The processFeature() implementation of a QgsProcessingFeatureBasedAlgorithm is thread safe, and features can be processed concurrently on separately prepared copies of the algorithm (since QGIS 3.18)
       FlagDeprecated = FlagHideFromToolbox | FlagHideFromModeler, //!< Algorithm is deprecated
     };
     Q_DECLARE_FLAGS( Flags, Flag )
@@ -1114,6 +1115,13 @@ class CORE_EXPORT QgsProcessingFeatureBasedAlgorithm : public QgsProcessingAlgor
      * prevent the algorithm execution from continuing. This can be annoying for users though as it
      * can break valid model execution - so use with extreme caution, and consider using
      * \a feedback to instead report non-fatal processing failures for features instead.
+     *
+     * Algorithms which return the FlagSupportsParallelFeatures flag have features processed concurrently
+     * from several threads. Each thread then uses its own copy of the algorithm, created with create()
+     * and prepared with the same parameters, along with its own \a context and \a feedback objects.
+     * Output features are still added to the algorithm's output in the order of the input features.
+     * QgsGeometry methods backed by GEOS can be used safely from these threads, as each thread uses
+     * its own GEOS context handle.
      */
     virtual QgsFeatureList processFeature( const QgsFeature &feature, QgsProcessingContext &context, QgsProcessingFeedback *feedback ) SIP_THROW( QgsProcessingException ) = 0 SIP_VIRTUALERRORHANDLER( processing_exception_handler );
 
@@ -1248,8 +1256,23 @@ class CORE_EXPORT QgsProcessingFeatureBasedAlgorithm : public QgsProcessingAlgor
 
   private:
 
+    /**
+     * Processes the features of \a iterator in chunks, on copies of the algorithm running in several threads, and
+     * adds the output features to \a sink in the order of the input features.
+     *
+     * Returns FALSE if the copies of the algorithm could not be prepared, in which case no feature was read.
+     */
+    bool processFeaturesInParallel( const QVariantMap &parameters, QgsFeatureIterator &iterator, QgsFeatureSink *sink,
+                                    QgsProcessingContext &context, QgsProcessingFeedback *feedback, long featureCount ) SIP_SKIP;
+
     std::unique_ptr< QgsProcessingFeatureSource > mSource;
 
+    //! Source CRS of the copies of the algorithm which process features in parallel, without a source of their own
+    QgsCoordinateReferenceSystem mParallelSourceCrs;
+
+    friend class QgsProcessingModelAlgorithm;
+    friend class QgsProcessingFeatureStream;
+
 };
 
 // clazy:excludeall=qstring-allocations
@@ -17,12 +17,14 @@
 
 #include "qgsprocessingcontext.h"
 #include "qgsprocessingutils.h"
+#include "qgspreparedgeometrycache.h"
 #include "qgsproviderregistry.h"
 #include "qgssettings.h"
 
 QgsProcessingContext::QgsProcessingContext()
   : mPreferredVectorFormat( QgsProcessingUtils::defaultVectorExtension() )
   , mPreferredRasterFormat( QgsProcessingUtils::defaultRasterExtension() )
+  , mPreparedGeometryCache( qgis::make_unique< QgsPreparedGeometryCache >() )
 {
   auto callback = [ = ]( const QgsFeature & feature )
   {
@@ -29,6 +29,7 @@
 #include "qgsprocessingutils.h"
 
 class QgsProcessingLayerPostProcessorInterface;
+class QgsPreparedGeometryCache;
 
 /**
  * \class QgsProcessingContext
@@ -624,6 +625,22 @@ class CORE_EXPORT QgsProcessingContext
      * \since QGIS 3.10
      */
     void setPreferredRasterFormat( const QString &format ) { mPreferredRasterFormat = format; }
+#ifndef SIP_RUN
+
+    /**
+     * Returns the cache of prepared geometries owned by the context.
+     *
+     * Algorithms can use it to avoid preparing the geometries of the same features again, e.g. when
+     * features of a source are tested against features of another source, or when an algorithm is
+     * run several times with the same context.
+     *
+     * The cache is not thread safe, and must only be used from the thread of the context.
+     *
+     * \note Not available in Python bindings
+     * \since QGIS 3.18
+     */
+    QgsPreparedGeometryCache *preparedGeometryCache() const { return mPreparedGeometryCache.get(); }
+#endif
 
   private:
 
@@ -654,6 +671,8 @@ class CORE_EXPORT QgsProcessingContext
     QString mPreferredVectorFormat;
     QString mPreferredRasterFormat;
 
+    std::unique_ptr< QgsPreparedGeometryCache > mPreparedGeometryCache;
+
 #ifdef SIP_RUN
     QgsProcessingContext( const QgsProcessingContext &other );
 #endif
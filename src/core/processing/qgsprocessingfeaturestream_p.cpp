@@ -0,0 +1,148 @@
+/***************************************************************************
+                         qgsprocessingfeaturestream_p.cpp
+                         --------------------------------
+    begin                : February 2021
+    copyright            : (C) 2021 by QGIS.org
+    email                : info at qgis dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsprocessingfeaturestream_p.h"
+#include "qgsprocessingalgorithm.h"
+#include "qgsprocessingcontext.h"
+#include "qgsprocessingfeedback.h"
+#include "qgsexception.h"
+#include "qgslogger.h"
+
+///@cond PRIVATE
+
+QgsProcessingFeatureStream::QgsProcessingFeatureStream( std::unique_ptr<QgsProcessingFeatureBasedAlgorithm> algorithm, const QgsProcessingContext &context,
+    const QgsExpressionContext &expressionContext, QgsProcessingFeedback *feedback )
+  : mAlgorithm( std::move( algorithm ) )
+  , mContext( qgis::make_unique< QgsProcessingContext >() )
+  , mFeedback( feedback )
+{
+  mContext->copyThreadSafeSettings( context );
+  mContext->setExpressionContext( expressionContext );
+  setObjectName( mAlgorithm->displayName() );
+}
+
+QgsProcessingFeatureStream::~QgsProcessingFeatureStream() = default;
+
+QgsFeatureIterator QgsProcessingFeatureStream::getFeatures( const QgsFeatureRequest &request ) const
+{
+  return QgsFeatureIterator( new QgsProcessingFeatureStreamIterator( this, request ) );
+}
+
+QgsCoordinateReferenceSystem QgsProcessingFeatureStream::sourceCrs() const
+{
+  return mAlgorithm->outputCrs( mAlgorithm->mSource->sourceCrs() );
+}
+
+QgsFields QgsProcessingFeatureStream::fields() const
+{
+  return mAlgorithm->outputFields( mAlgorithm->mSource->fields() );
+}
+
+QgsWkbTypes::Type QgsProcessingFeatureStream::wkbType() const
+{
+  return mAlgorithm->outputWkbType( mAlgorithm->mSource->wkbType() );
+}
+
+long QgsProcessingFeatureStream::featureCount() const
+{
+  // an estimate, as algorithms can skip features or return several features for each input feature
+  return mAlgorithm->mSource->featureCount();
+}
+
+QString QgsProcessingFeatureStream::sourceName() const
+{
+  return mAlgorithm->displayName();
+}
+
+QgsFeatureIterator QgsProcessingFeatureStream::inputFeatures() const
+{
+  return mAlgorithm->mSource->getFeatures( mAlgorithm->request(), mAlgorithm->sourceFlags() );
+}
+
+QgsFeatureList QgsProcessingFeatureStream::processFeature( const QgsFeature &feature ) const
+{
+  mContext->expressionContext().setFeature( feature );
+  return mAlgorithm->processFeature( feature, *mContext, mFeedback );
+}
+
+//
+// QgsProcessingFeatureStreamIterator
+//
+
+QgsProcessingFeatureStreamIterator::QgsProcessingFeatureStreamIterator( const QgsProcessingFeatureStream *stream, const QgsFeatureRequest &request )
+  : QgsAbstractFeatureIterator( request )
+  , mStream( stream )
+  , mInput( stream->inputFeatures() )
+{
+  if ( mRequest.destinationCrs().isValid() && mRequest.destinationCrs() != mStream->sourceCrs() )
+  {
+    mTransform = QgsCoordinateTransform( mStream->sourceCrs(), mRequest.destinationCrs(), mRequest.transformContext() );
+  }
+}
+
+bool QgsProcessingFeatureStreamIterator::rewind()
+{
+  mPending.clear();
+  mNextId = 1;
+  return mInput.rewind();
+}
+
+bool QgsProcessingFeatureStreamIterator::close()
+{
+  mPending.clear();
+  return mInput.close();
+}
+
+bool QgsProcessingFeatureStreamIterator::fetchFeature( QgsFeature &feature )
+{
+  while ( true )
+  {
+    while ( mPending.isEmpty() )
+    {
+      QgsFeature input;
+      if ( !mInput.nextFeature( input ) )
+        return false;
+
+      mPending = mStream->processFeature( input );
+    }
+
+    feature = mPending.takeFirst();
+    // output features get new ids, as they would when written to a layer
+    feature.setId( mNextId++ );
+    feature.setValid( true );
+
+    if ( mTransform.isValid() && feature.hasGeometry() )
+    {
+      try
+      {
+        QgsGeometry geometry = feature.geometry();
+        geometry.transform( mTransform );
+        feature.setGeometry( geometry );
+      }
+      catch ( QgsCsException & )
+      {
+        QgsDebugMsg( QStringLiteral( "Could not transform feature %1" ).arg( feature.id() ) );
+        feature.clearGeometry();
+      }
+    }
+
+    if ( mRequest.acceptFeature( feature ) )
+      return true;
+  }
+}
+
+///@endcond
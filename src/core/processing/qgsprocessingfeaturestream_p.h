@@ -0,0 +1,129 @@
+/***************************************************************************
+                         qgsprocessingfeaturestream_p.h
+                         ------------------------------
+    begin                : February 2021
+    copyright            : (C) 2021 by QGIS.org
+    email                : info at qgis dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSPROCESSINGFEATURESTREAM_PRIVATE_H
+#define QGSPROCESSINGFEATURESTREAM_PRIVATE_H
+
+#define SIP_NO_FILE
+
+/// @cond PRIVATE
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the QGIS API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+
+#include "qgis_core.h"
+#include "qgsfeaturesource.h"
+#include "qgsfeatureiterator.h"
+#include "qgscoordinatetransform.h"
+
+#include <QObject>
+#include <memory>
+
+class QgsProcessingContext;
+class QgsProcessingFeatureBasedAlgorithm;
+class QgsProcessingFeedback;
+class QgsExpressionContext;
+
+/**
+ * \ingroup core
+ * \class QgsProcessingFeatureStream
+ * A feature source for the output of a feature based algorithm, whose features are computed on the fly
+ * from the algorithm's input features while they are iterated, instead of being written to a layer.
+ *
+ * The stream is a QObject, so that it can be passed as the value of a feature source parameter of another
+ * algorithm. It is used by models to stream features between their child algorithms.
+ *
+ * \since QGIS 3.18
+ */
+class CORE_EXPORT QgsProcessingFeatureStream : public QObject, public QgsFeatureSource
+{
+  public:
+
+    /**
+     * Constructor for QgsProcessingFeatureStream, for the output features of an \a algorithm.
+     *
+     * The \a algorithm must already be prepared, along with its input source. Features are processed with a copy
+     * of the thread safe settings of \a context, using the \a expressionContext of the algorithm, and any
+     * message is reported to \a feedback.
+     */
+    QgsProcessingFeatureStream( std::unique_ptr< QgsProcessingFeatureBasedAlgorithm > algorithm, const QgsProcessingContext &context,
+                                const QgsExpressionContext &expressionContext, QgsProcessingFeedback *feedback );
+    ~QgsProcessingFeatureStream() override;
+
+    QgsFeatureIterator getFeatures( const QgsFeatureRequest &request = QgsFeatureRequest() ) const override;
+    QgsCoordinateReferenceSystem sourceCrs() const override;
+    QgsFields fields() const override;
+    QgsWkbTypes::Type wkbType() const override;
+    long featureCount() const override;
+    QString sourceName() const override;
+
+  private:
+
+    //! Returns an iterator over the input features of the algorithm
+    QgsFeatureIterator inputFeatures() const;
+
+    //! Processes an input \a feature through the algorithm
+    QgsFeatureList processFeature( const QgsFeature &feature ) const;
+
+    std::unique_ptr< QgsProcessingFeatureBasedAlgorithm > mAlgorithm;
+    std::unique_ptr< QgsProcessingContext > mContext;
+    QgsProcessingFeedback *mFeedback = nullptr;
+
+    friend class QgsProcessingFeatureStreamIterator;
+};
+
+/**
+ * \ingroup core
+ * \class QgsProcessingFeatureStreamIterator
+ * Iterator over the features of a QgsProcessingFeatureStream.
+ *
+ * \since QGIS 3.18
+ */
+class CORE_EXPORT QgsProcessingFeatureStreamIterator : public QgsAbstractFeatureIterator
+{
+  public:
+
+    QgsProcessingFeatureStreamIterator( const QgsProcessingFeatureStream *stream, const QgsFeatureRequest &request );
+
+    bool rewind() override;
+    bool close() override;
+
+  protected:
+
+    bool fetchFeature( QgsFeature &feature ) override;
+
+  private:
+
+    const QgsProcessingFeatureStream *mStream = nullptr;
+    QgsFeatureIterator mInput;
+    QgsCoordinateTransform mTransform;
+
+    //! Output features of the last input feature which were not returned yet
+    QgsFeatureList mPending;
+
+    QgsFeatureId mNextId = 1;
+};
+
+/// @endcond
+
+#endif // QGSPROCESSINGFEATURESTREAM_PRIVATE_H
@@ -5342,6 +5342,10 @@ bool QgsProcessingParameterFeatureSource::checkValueIsAcceptable( const QVariant
   {
     return true;
   }
+  else if ( dynamic_cast< QgsFeatureSource * >( qvariant_cast<QObject *>( input ) ) )
+  {
+    return true;
+  }
 
   if ( var.type() != QVariant::String || var.toString().isEmpty() )
     return mFlags & FlagOptional;
@@ -5436,6 +5440,10 @@ QString QgsProcessingParameterFeatureSource::valueAsPythonString( const QVariant
   {
     return QgsProcessingUtils::stringToPythonLiteral( layer->source() );
   }
+  else if ( QgsFeatureSource *source = dynamic_cast< QgsFeatureSource * >( qvariant_cast<QObject *>( value ) ) )
+  {
+    return QgsProcessingUtils::stringToPythonLiteral( source->sourceName() );
+  }
 
   QString layerString = value.toString();
 
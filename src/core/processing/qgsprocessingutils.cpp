@@ -379,6 +379,14 @@ QgsProcessingFeatureSource *QgsProcessingUtils::variantToSource( const QVariant
       source->setInvalidGeometryCheck( geometryCheck );
     return source.release();
   }
+  else if ( QgsFeatureSource *featureSource = dynamic_cast< QgsFeatureSource * >( qvariant_cast<QObject *>( val ) ) )
+  {
+    // other feature sources, e.g. features streamed between the child algorithms of a model
+    std::unique_ptr< QgsProcessingFeatureSource> source = qgis::make_unique< QgsProcessingFeatureSource >( featureSource, context, false, featureLimit );
+    if ( overrideGeometryCheck )
+      source->setInvalidGeometryCheck( geometryCheck );
+    return source.release();
+  }
 
   QString layerRef;
   if ( val.canConvert<QgsProperty>() )
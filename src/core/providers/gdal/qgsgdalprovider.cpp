@@ -63,6 +63,8 @@
 #include <cpl_conv.h>
 #include <cpl_string.h>
 
+#include <algorithm>
+
 #define ERRMSG(message) QGS_ERROR_MESSAGE(message,"GDAL provider")
 #define ERR(message) QgsError(message,"GDAL provider")
 
@@ -1126,6 +1128,33 @@ bool QgsGdalProvider::readBlock( int bandNo, QgsRectangle  const &reqExtent, int
 
   QgsDebugMsgLevel( QStringLiteral( "srcTop = %1 srcBottom = %2 srcWidth = %3 srcHeight = %4" ).arg( srcTop ).arg( srcBottom ).arg( srcWidth ).arg( srcHeight ), 5 );
 
+  // At the raster resolution, with the target grid aligned to the raster grid, GDAL
+  // can write the pixels directly into the block, without a temporary buffer
+  const double srcLeftOffset = ( intersectExtent.xMinimum() - mExtent.xMinimum() ) / srcXRes;
+  const double srcTopOffset = ( mExtent.yMaximum() - intersectExtent.yMaximum() ) / -srcYRes;
+  if ( tgtWidth == srcWidth && tgtHeight == srcHeight &&
+       std::fabs( reqXRes - srcXRes ) < 0.001 * srcXRes && std::fabs( reqYRes + srcYRes ) < 0.001 * -srcYRes &&
+       std::fabs( srcLeftOffset - srcLeft ) < 0.01 && std::fabs( srcTopOffset - srcTop ) < 0.01 )
+  {
+    QgsDebugMsgLevel( QStringLiteral( "reading directly into the block" ), 5 );
+    CPLErrorReset();
+    CPLErr err = gdalRasterIO( gdalBand, GF_Read,
+                               srcLeft, srcTop, srcWidth, srcHeight,
+                               static_cast<char *>( data ) + dataSize * ( static_cast<size_t>( tgtTop ) * bufferWidthPix + tgtLeft ),
+                               srcWidth, srcHeight, type,
+                               static_cast<int>( dataSize ), static_cast<int>( dataSize ) * bufferWidthPix, feedback );
+    if ( err != CPLE_None )
+    {
+      const QString lastError = QString::fromUtf8( CPLGetLastErrorMsg() ) ;
+      if ( feedback )
+        feedback->appendError( lastError );
+
+      QgsLogger::warning( "RasterIO error: " + lastError );
+      return false;
+    }
+    return true;
+  }
+
   // Determine the dimensions of the buffer into which we will ask GDAL to write
   // pixels.
   // In downsampling scenarios, we will use the request resolution to compute the dimension
@@ -1663,7 +1692,8 @@ QgsRasterDataProvider::ProviderCapabilities QgsGdalProvider::providerCapabilitie
 {
   return ProviderCapability::ProviderHintBenefitsFromResampling |
          ProviderCapability::ProviderHintCanPerformProviderResampling |
-         ProviderCapability::ReloadData;
+         ProviderCapability::ReloadData |
+         ProviderCapability::ThreadSafeRead;
 }
 
 // This is used also by global isValidRasterFileName
@@ -2803,19 +2833,33 @@ QgsRasterBandStats QgsGdalProvider::bandStatistics( int bandNo, int stats, const
   // see above and https://trac.osgeo.org/gdal/ticket/4857
   // -> Cannot used cached GDAL stats for exact
 
-  CPLErr myerval =
-    GDALGetRasterStatistics( myGdalBand, bApproxOK, true, &pdfMin, &pdfMax, &pdfMean, &pdfStdDev );
+  // ... but exact statistics which were computed before are kept in a band metadata domain of their own,
+  // along with the source no data value they were computed with, as no other no data values are used here
+  const QString noData = sourceHasNoDataValue( bandNo ) ? QString::number( sourceNoDataValue( bandNo ), 'g', 17 ) : QStringLiteral( "none" );
+  const bool persistedExactStats = !bApproxOK && readExactStatistics( myGdalBand, noData, pdfMin, pdfMax, pdfMean, pdfStdDev );
+
+  CPLErr myerval = persistedExactStats ? CE_None :
+                   GDALGetRasterStatistics( myGdalBand, bApproxOK, true, &pdfMin, &pdfMax, &pdfMean, &pdfStdDev );
 
   QgsDebugMsgLevel( QStringLiteral( "myerval = %1" ).arg( myerval ), 2 );
 
+  if ( persistedExactStats )
+  {
+    QgsDebugMsgLevel( QStringLiteral( "Using persisted exact statistics" ), 2 );
+  }
   // if cached stats are not found, compute them
-  if ( !bApproxOK || CE_None != myerval )
+  else if ( !bApproxOK || CE_None != myerval )
   {
     QgsDebugMsgLevel( QStringLiteral( "Calculating statistics by GDAL" ), 2 );
     myerval = GDALComputeRasterStatistics( myGdalBand, bApproxOK,
                                            &pdfMin, &pdfMax, &pdfMean, &pdfStdDev,
                                            progressCallback, &myProg );
     mStatisticsAreReliable = true;
+
+    if ( !bApproxOK && CE_None == myerval && !( feedback && feedback->isCanceled() ) )
+    {
+      writeExactStatistics( myGdalBand, noData, pdfMin, pdfMax, pdfMean, pdfStdDev );
+    }
   }
   else
   {
@@ -2888,6 +2932,61 @@ QgsRasterBandStats QgsGdalProvider::bandStatistics( int bandNo, int stats, const
 
 } // QgsGdalProvider::bandStatistics
 
+// Metadata items of the exact statistics of a band, in a domain of their own so that they are not
+// overwritten by approximate statistics computed by GDAL
+static const char *EXACT_STATISTICS_DOMAIN = "QGIS_EXACT_STATISTICS";
+static const char *const EXACT_STATISTICS_ITEMS[] = { "MINIMUM", "MAXIMUM", "MEAN", "STDDEV" };
+static const char *EXACT_STATISTICS_NODATA_ITEM = "NODATA";
+
+bool QgsGdalProvider::readExactStatistics( GDALRasterBandH band, const QString &noData, double &minimum, double &maximum, double &mean, double &stdDev )
+{
+  const char *noDataItem = GDALGetMetadataItem( band, EXACT_STATISTICS_NODATA_ITEM, EXACT_STATISTICS_DOMAIN );
+  if ( !noDataItem || QString( noDataItem ) != noData )
+    return false;
+
+  double values[4];
+  for ( int i = 0; i < 4; ++i )
+  {
+    const char *item = GDALGetMetadataItem( band, EXACT_STATISTICS_ITEMS[i], EXACT_STATISTICS_DOMAIN );
+    if ( !item )
+      return false;
+
+    bool ok = false;
+    values[i] = QString( item ).toDouble( &ok );
+    if ( !ok )
+      return false;
+  }
+
+  minimum = values[0];
+  maximum = values[1];
+  mean = values[2];
+  stdDev = values[3];
+  return true;
+}
+
+void QgsGdalProvider::writeExactStatistics( GDALRasterBandH band, const QString &noData, double minimum, double maximum, double mean, double stdDev )
+{
+  // GDAL persists the metadata in the auxiliary file of the dataset (.aux.xml)
+  const double values[4] = { minimum, maximum, mean, stdDev };
+  for ( int i = 0; i < 4; ++i )
+  {
+    GDALSetMetadataItem( band, EXACT_STATISTICS_ITEMS[i], QString::number( values[i], 'g', 17 ).toUtf8().constData(), EXACT_STATISTICS_DOMAIN );
+  }
+  GDALSetMetadataItem( band, EXACT_STATISTICS_NODATA_ITEM, noData.toUtf8().constData(), EXACT_STATISTICS_DOMAIN );
+}
+
+void QgsGdalProvider::clearExactStatistics( GDALRasterBandH band )
+{
+  if ( !GDALGetMetadataItem( band, EXACT_STATISTICS_ITEMS[0], EXACT_STATISTICS_DOMAIN ) )
+    return;
+
+  for ( const char *item : EXACT_STATISTICS_ITEMS )
+  {
+    GDALSetMetadataItem( band, item, nullptr, EXACT_STATISTICS_DOMAIN );
+  }
+  GDALSetMetadataItem( band, EXACT_STATISTICS_NODATA_ITEM, nullptr, EXACT_STATISTICS_DOMAIN );
+}
+
 bool QgsGdalProvider::initIfNeeded()
 {
   if ( mHasInit )
@@ -3277,6 +3376,8 @@ bool QgsGdalProvider::write( void *data, int band, int width, int height, int xO
   {
     return false;
   }
+  // the persisted statistics do not match the data anymore
+  clearExactStatistics( rasterBand );
   return gdalRasterIO( rasterBand, GF_Write, xOffset, yOffset, width, height, data, width, height, GDALGetRasterDataType( rasterBand ), 0, 0 ) == CE_None;
 }
 
@@ -3302,6 +3403,17 @@ bool QgsGdalProvider::setNoDataValue( int bandNo, double noDataValue )
   mSrcNoDataValue[bandNo - 1] = noDataValue;
   mSrcHasNoDataValue[bandNo - 1] = true;
   mUseSrcNoDataValue[bandNo - 1] = true;
+
+  // the statistics of the band were computed with other no data values
+  clearExactStatistics( rasterBand );
+  mStatistics.erase( std::remove_if( mStatistics.begin(), mStatistics.end(), [bandNo]( const QgsRasterBandStats & stats )
+  {
+    return stats.bandNumber == bandNo;
+  } ), mStatistics.end() );
+  mHistograms.erase( std::remove_if( mHistograms.begin(), mHistograms.end(), [bandNo]( const QgsRasterHistogram & histogram )
+  {
+    return histogram.bandNumber == bandNo;
+  } ), mHistograms.end() );
   return true;
 }
 
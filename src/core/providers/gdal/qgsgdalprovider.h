@@ -311,6 +311,18 @@ class QgsGdalProvider final: public QgsRasterDataProvider, QgsGdalProviderBase
     //! Wrapper for GDALGetRasterBand() that takes into account mMaskBandExposedAsAlpha.
     GDALRasterBandH getBand( int bandNo ) const;
 
+    /**
+     * Reads the exact statistics of a \a band which were persisted by writeExactStatistics().
+     * Returns FALSE if there are none, or if they were computed with another \a noData value.
+     */
+    static bool readExactStatistics( GDALRasterBandH band, const QString &noData, double &minimum, double &maximum, double &mean, double &stdDev );
+
+    //! Persists the exact statistics of a \a band computed with a \a noData value, in its metadata saved next to the dataset
+    static void writeExactStatistics( GDALRasterBandH band, const QString &noData, double minimum, double maximum, double mean, double stdDev );
+
+    //! Removes the persisted exact statistics of a \a band, once its data changed
+    static void clearExactStatistics( GDALRasterBandH band );
+
     //! \brief Close data set and release related data
     void closeDataset();
 
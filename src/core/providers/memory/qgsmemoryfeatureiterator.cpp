@@ -23,6 +23,7 @@
 #include "qgsproject.h"
 #include "qgsexception.h"
 #include "qgsexpressioncontextutils.h"
+#include "qgsfeaturebatch.h"
 
 ///@cond PRIVATE
 
@@ -97,131 +98,150 @@ bool QgsMemoryFeatureIterator::fetchFeature( QgsFeature &feature )
   if ( mClosed )
     return false;
 
-  if ( mUsingFeatureIdList )
-    return nextFeatureUsingList( feature );
-  else
-    return nextFeatureTraverseAll( feature );
-}
+  const QgsFeature *candidate = nextMatchingFeature();
+  if ( !candidate )
+  {
+    close();
+    return false;
+  }
 
+  // copy feature
+  feature = *candidate;
+  feature.setValid( true );
+  feature.setFields( mSource->mFields ); // allow name-based attribute lookups
+  geometryToDestinationCrs( feature, mTransform );
+  return true;
+}
 
-bool QgsMemoryFeatureIterator::nextFeatureUsingList( QgsFeature &feature )
+int QgsMemoryFeatureIterator::fetchFeatureBatch( QgsFeatureBatch &batch, int maximumCount )
 {
-  bool hasFeature = false;
+  // filter expressions are never compiled for memory layers
+  if ( mRequest.filterType() != QgsFeatureRequest::FilterNone )
+    return -1;
+
+  if ( mClosed )
+    return 0;
 
-  // option 1: we have a list of features to traverse
-  QgsFeature candidate;
-  while ( mFeatureIdListIterator != mFeatureIdList.constEnd() )
+  batch.setFields( mSource->mFields );
+  batch.reserve( maximumCount );
+
+  const QgsAttributeList attributes = mRequest.flags() & QgsFeatureRequest::SubsetOfAttributes
+                                      ? mRequest.subsetOfAttributes() : mSource->mFields.allAttributesList();
+  const bool fetchGeometry = !( mRequest.flags() & QgsFeatureRequest::NoGeometry );
+
+  int fetched = 0;
+  while ( fetched < maximumCount )
   {
-    candidate = mSource->mFeatures.value( *mFeatureIdListIterator );
-    if ( !mFilterRect.isNull() )
+    const QgsFeature *candidate = nextMatchingFeature();
+    if ( !candidate )
     {
-      if ( mRequest.flags() & QgsFeatureRequest::ExactIntersect )
-      {
-        // do exact check in case we're doing intersection
-        if ( candidate.hasGeometry() && mSelectRectEngine->intersects( candidate.geometry().constGet() ) )
-          hasFeature = true;
-      }
-      else if ( mSource->mSpatialIndex )
+      close();
+      break;
+    }
+
+    // values are copied straight from the stored feature, without creating a new QgsFeature
+    batch.addRow( candidate->id() );
+    const QgsAttributes candidateAttributes = candidate->attributes();
+    for ( int idx : attributes )
+    {
+      if ( idx >= 0 && idx < candidateAttributes.count() )
+        batch.setValue( idx, candidateAttributes.at( idx ) );
+    }
+
+    if ( fetchGeometry && candidate->hasGeometry() )
+    {
+      if ( mTransform.isValid() )
       {
-        // using a spatial index - so we already know that the bounding box intersects correctly
-        hasFeature = true;
+        QgsFeature transformed = *candidate;
+        geometryToDestinationCrs( transformed, mTransform );
+        batch.setGeometry( transformed.geometry() );
       }
       else
       {
-        // do bounding box check if we aren't using a spatial index
-        if ( candidate.hasGeometry() && candidate.geometry().boundingBoxIntersects( mFilterRect ) )
-          hasFeature = true;
+        batch.setGeometry( candidate->geometry() );
       }
     }
-    else
-      hasFeature = true;
-
-    if ( hasFeature && mSubsetExpression )
-    {
-      mSource->expressionContext()->setFeature( candidate );
-      if ( !mSubsetExpression->evaluate( mSource->expressionContext() ).toBool() )
-        hasFeature = false;
-    }
-
-    if ( hasFeature )
-      break;
-
-    ++mFeatureIdListIterator;
-  }
-
-  // copy feature
-  if ( hasFeature )
-  {
-    feature = candidate;
-    ++mFeatureIdListIterator;
-  }
-  else
-    close();
-
-  if ( hasFeature )
-  {
-    feature.setFields( mSource->mFields ); // allow name-based attribute lookups
-    geometryToDestinationCrs( feature, mTransform );
+    fetched++;
   }
-
-  return hasFeature;
+  return fetched;
 }
 
-
-bool QgsMemoryFeatureIterator::nextFeatureTraverseAll( QgsFeature &feature )
+const QgsFeature *QgsMemoryFeatureIterator::nextMatchingFeature()
 {
-  bool hasFeature = false;
-
-  // option 2: traversing the whole layer
-  while ( mSelectIterator != mSource->mFeatures.constEnd() )
+  if ( mUsingFeatureIdList )
   {
-    if ( mFilterRect.isNull() )
-    {
-      // selection rect empty => using all features
-      hasFeature = true;
-    }
-    else
+    // option 1: we have a list of features to traverse
+    while ( mFeatureIdListIterator != mFeatureIdList.constEnd() )
     {
-      if ( mRequest.flags() & QgsFeatureRequest::ExactIntersect )
+      QgsFeatureMap::const_iterator it = mSource->mFeatures.constFind( *mFeatureIdListIterator );
+      ++mFeatureIdListIterator;
+      if ( it == mSource->mFeatures.constEnd() )
+        continue;
+
+      const QgsFeature &candidate = it.value();
+      if ( !mFilterRect.isNull() )
       {
-        // using exact test when checking for intersection
-        if ( mSelectIterator->hasGeometry() && mSelectRectEngine->intersects( mSelectIterator->geometry().constGet() ) )
-          hasFeature = true;
+        if ( mRequest.flags() & QgsFeatureRequest::ExactIntersect )
+        {
+          // do exact check in case we're doing intersection
+          if ( !candidate.hasGeometry() || !mSelectRectEngine->intersects( candidate.geometry().constGet() ) )
+            continue;
+        }
+        else if ( !mSource->mSpatialIndex )
+        {
+          // do bounding box check if we aren't using a spatial index (otherwise we already know that
+          // the bounding box intersects correctly)
+          if ( !candidate.hasGeometry() || !candidate.geometry().boundingBoxIntersects( mFilterRect ) )
+            continue;
+        }
       }
-      else
+
+      if ( mSubsetExpression )
       {
-        // check just bounding box against rect when not using intersection
-        if ( mSelectIterator->hasGeometry() && mSelectIterator->geometry().boundingBox().intersects( mFilterRect ) )
-          hasFeature = true;
+        mSource->expressionContext()->setFeature( candidate );
+        if ( !mSubsetExpression->evaluate( mSource->expressionContext() ).toBool() )
+          continue;
       }
-    }
 
-    if ( mSubsetExpression )
-    {
-      mSource->expressionContext()->setFeature( *mSelectIterator );
-      if ( !mSubsetExpression->evaluate( mSource->expressionContext() ).toBool() )
-        hasFeature = false;
+      return &candidate;
     }
+  }
+  else
+  {
+    // option 2: traversing the whole layer
+    while ( mSelectIterator != mSource->mFeatures.constEnd() )
+    {
+      const QgsFeature &candidate = mSelectIterator.value();
+      ++mSelectIterator;
 
-    if ( hasFeature )
-      break;
+      if ( !mFilterRect.isNull() )
+      {
+        if ( mRequest.flags() & QgsFeatureRequest::ExactIntersect )
+        {
+          // using exact test when checking for intersection
+          if ( !candidate.hasGeometry() || !mSelectRectEngine->intersects( candidate.geometry().constGet() ) )
+            continue;
+        }
+        else
+        {
+          // check just bounding box against rect when not using intersection
+          if ( !candidate.hasGeometry() || !candidate.geometry().boundingBox().intersects( mFilterRect ) )
+            continue;
+        }
+      }
 
-    ++mSelectIterator;
-  }
+      if ( mSubsetExpression )
+      {
+        mSource->expressionContext()->setFeature( candidate );
+        if ( !mSubsetExpression->evaluate( mSource->expressionContext() ).toBool() )
+          continue;
+      }
 
-  // copy feature
-  if ( hasFeature )
-  {
-    feature = mSelectIterator.value();
-    ++mSelectIterator;
-    feature.setValid( true );
-    feature.setFields( mSource->mFields ); // allow name-based attribute lookups
-    geometryToDestinationCrs( feature, mTransform );
+      return &candidate;
+    }
   }
-  else
-    close();
 
-  return hasFeature;
+  return nullptr;
 }
 
 bool QgsMemoryFeatureIterator::rewind()
@@ -65,10 +65,12 @@ class QgsMemoryFeatureIterator final: public QgsAbstractFeatureIteratorFromSourc
   protected:
 
     bool fetchFeature( QgsFeature &feature ) override;
+    int fetchFeatureBatch( QgsFeatureBatch &batch, int maximumCount ) override;
 
   private:
-    bool nextFeatureUsingList( QgsFeature &feature );
-    bool nextFeatureTraverseAll( QgsFeature &feature );
+
+    //! Returns the next stored feature which matches the request, or NULLPTR if there are no more matching features
+    const QgsFeature *nextMatchingFeature();
 
     QgsGeometry mSelectRectGeom;
     std::unique_ptr< QgsGeometryEngine > mSelectRectEngine;
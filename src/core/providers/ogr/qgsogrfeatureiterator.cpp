@@ -28,6 +28,8 @@
 #include "qgsexception.h"
 #include "qgswkbtypes.h"
 #include "qgsogrtransaction.h"
+#include "qgsfeaturebatch.h"
+#include "qgspackedspatialindexfile.h"
 
 #include <QTextCodec>
 #include <QFile>
@@ -179,10 +181,25 @@ QgsOgrFeatureIterator::QgsOgrFeatureIterator( QgsOgrFeatureSource *source, bool
       QgsOgrProviderUtils::setRelevantFields( mOgrLayerOri, mSource->mFields.count(), mFetchGeometry, attrs, mSource->mFirstFieldIsFid, mSource->mSubsetString );
   }
 
+  // files without a native spatial index may have a sidecar index, which gives the ids of the features
+  // matching the filter rectangle so that they can be read directly instead of scanning the whole file
+  if ( mAllowResetReading && !mFilterRect.isNull() && mSource->mSidecarIndex && !mSharedDS && mSource->mSubsetString.isEmpty()
+       && ( mRequest.filterType() == QgsFeatureRequest::FilterNone || mRequest.filterType() == QgsFeatureRequest::FilterExpression )
+       && !mFilterRect.contains( mSource->mSidecarIndex->extent() ) )
+  {
+    // entries are sorted by their offset, so reading them in this order reads the file forward
+    const QVector< QgsPackedSpatialIndexFile::Entry > entries = mSource->mSidecarIndex->intersects( mFilterRect );
+    mSidecarFids.reserve( entries.size() );
+    for ( const QgsPackedSpatialIndexFile::Entry &entry : entries )
+      mSidecarFids.emplace_back( entry.id );
+    mSidecarFidsPosition = 0;
+    mUseSidecarIndex = true;
+  }
+
   // spatial query to select features
   if ( mAllowResetReading )
   {
-    if ( !mFilterRect.isNull() )
+    if ( !mFilterRect.isNull() && !mUseSidecarIndex )
     {
       OGR_L_SetSpatialFilterRect( mOgrLayer, mFilterRect.xMinimum(), mFilterRect.yMinimum(), mFilterRect.xMaximum(), mFilterRect.yMaximum() );
       if ( mOgrLayerOri && mOgrLayerOri != mOgrLayer )
@@ -196,7 +213,8 @@ QgsOgrFeatureIterator::QgsOgrFeatureIterator( QgsOgrFeatureSource *source, bool
     }
   }
 
-  if ( request.filterType() == QgsFeatureRequest::FilterExpression )
+  // features read by id through the sidecar index ignore OGR attribute filters, so the expression is always evaluated by QGIS
+  if ( request.filterType() == QgsFeatureRequest::FilterExpression && !mUseSidecarIndex )
   {
     QgsSqlExpressionCompiler *compiler = nullptr;
     if ( source->mDriverName == QLatin1String( "SQLite" ) || source->mDriverName == QLatin1String( "GPKG" ) )
@@ -361,6 +379,16 @@ bool QgsOgrFeatureIterator::fetchFeature( QgsFeature &feature )
     close(); // the feature has been read or was not found: we have finished here
     return result;
   }
+  else if ( mUseSidecarIndex )
+  {
+    while ( mSidecarFidsPosition < mSidecarFids.size() )
+    {
+      if ( fetchFeatureWithId( mSidecarFids[mSidecarFidsPosition++], feature ) )
+        return true;
+    }
+    close();
+    return false;
+  }
   else if ( mRequest.filterType() == QgsFeatureRequest::FilterFids )
   {
     while ( mFilterFidsIt != mFilterFids.end() )
@@ -409,6 +437,97 @@ bool QgsOgrFeatureIterator::fetchFeature( QgsFeature &feature )
   return false;
 }
 
+int QgsOgrFeatureIterator::fetchFeatureBatch( QgsFeatureBatch &batch, int maximumCount )
+{
+  if ( ( mRequest.filterType() == QgsFeatureRequest::FilterExpression && !mExpressionCompiled ) || mUseSidecarIndex )
+    return -1;
+
+  // features which need to be reprojected or checked against their exact geometry are read through QgsGeometry
+  if ( mTransform.isValid() || mSource->mOgrGeometryTypeFilter != wkbUnknown || ( mRequest.flags() & QgsFeatureRequest::ExactIntersect ) )
+    return -1;
+
+#if GDAL_VERSION_NUM >= GDAL_COMPUTE_VERSION(2,2,0)
+  if ( !QgsOgrProviderUtils::canDriverShareSameDatasetAmongLayers( mSource->mDriverName ) )
+    return -1;
+#endif
+
+  QMutexLocker locker( mSharedDS ? &mSharedDS->mutex() : nullptr );
+
+  QgsCPLHTTPFetchOverrider oCPLHTTPFetcher( mAuthCfg, mInterruptionChecker );
+  QgsSetCPLHTTPFetchOverriderInitiatorClass( oCPLHTTPFetcher, QStringLiteral( "QgsOgrFeatureIterator" ) );
+
+  if ( mClosed || !mOgrLayer )
+    return 0;
+
+  batch.setFields( mSource->mFields );
+  batch.reserve( maximumCount );
+
+  const QgsAttributeList attributes = mRequest.flags() & QgsFeatureRequest::SubsetOfAttributes
+                                      ? mRequest.subsetOfAttributes() : mSource->mFields.allAttributesList();
+  QVector< QVariant::Type > attributeTypes;
+  attributeTypes.reserve( attributes.size() );
+  for ( int idx : attributes )
+    attributeTypes << mSource->mFields.at( idx ).type();
+
+  const bool useIntersect = !mFilterRect.isNull();
+  const bool forceMultiType = QgsWkbTypes::isMultiType( mSource->mWkbType );
+  QByteArray wkb;
+
+  int fetched = 0;
+  gdal::ogr_feature_unique_ptr fet;
+  while ( fetched < maximumCount && ( fet.reset( OGR_L_GetNextFeature( mOgrLayer ) ), fet ) )
+  {
+    OGRGeometryH geom = mFetchGeometry || useIntersect ? OGR_F_GetGeometryRef( fet.get() ) : nullptr;
+    if ( useIntersect )
+    {
+      // same bounding box check as in readFeature() and checkFeature()
+      if ( !geom || OGR_G_IsEmpty( geom ) )
+        continue;
+
+      OGREnvelope envelope;
+      OGR_G_GetEnvelope( geom, &envelope );
+      if ( !mFilterRect.intersects( QgsRectangle( envelope.MinX, envelope.MinY, envelope.MaxX, envelope.MaxY ) ) )
+        continue;
+    }
+
+    batch.addRow( OGR_F_GetFID( fet.get() ) );
+
+    for ( int i = 0; i < attributes.size(); ++i )
+    {
+      getFeatureAttribute( fet.get(), batch, attributes.at( i ), attributeTypes.at( i ) );
+    }
+
+    if ( mFetchGeometry && geom )
+    {
+      const OGRwkbGeometryType geometryType = OGR_G_GetGeometryType( geom );
+      if ( wkbFlatten( geometryType ) == wkbGeometryCollection
+           || ( forceMultiType && !QgsWkbTypes::isMultiType( QgsOgrUtils::ogrGeometryTypeToQgsWkbType( geometryType ) ) ) )
+      {
+        // needs the same conversions as readFeature()
+        QgsGeometry g = QgsOgrUtils::ogrGeometryToQgsGeometry( geom );
+        if ( forceMultiType && !g.isMultipart() )
+          g.convertToMultiType();
+        batch.setGeometry( g );
+      }
+      else
+      {
+        // copy the geometry straight into the batch
+        const int size = OGR_G_WkbSize( geom );
+        wkb.resize( size );
+        OGR_G_ExportToIsoWkb( geom, static_cast<OGRwkbByteOrder>( QgsApplication::endian() ), reinterpret_cast< unsigned char * >( wkb.data() ) );
+        batch.setGeometryWkb( wkb.constData(), size );
+      }
+    }
+
+    fetched++;
+  }
+
+  if ( fetched < maximumCount )
+    close();
+
+  return fetched;
+}
+
 void QgsOgrFeatureIterator::resetReading()
 {
   if ( ! mAllowResetReading )
@@ -438,6 +557,7 @@ bool QgsOgrFeatureIterator::rewind()
   resetReading();
 
   mFilterFidsIt = mFilterFids.begin();
+  mSidecarFidsPosition = 0;
 
   return true;
 }
@@ -507,6 +627,48 @@ void QgsOgrFeatureIterator::getFeatureAttribute( OGRFeatureH ogrFet, QgsFeature
   f.setAttribute( attindex, value );
 }
 
+void QgsOgrFeatureIterator::getFeatureAttribute( OGRFeatureH ogrFet, QgsFeatureBatch &batch, int attindex, QVariant::Type type ) const
+{
+  if ( mFirstFieldIsFid && attindex == 0 )
+  {
+    batch.setInt64( 0, static_cast<qint64>( OGR_F_GetFID( ogrFet ) ) );
+    return;
+  }
+
+  const int attindexWithoutFid = ( mFirstFieldIsFid ) ? attindex - 1 : attindex;
+  if ( !OGR_F_IsFieldSetAndNotNull( ogrFet, attindexWithoutFid ) )
+    return;
+
+  // read values of the common types without creating a QVariant
+  switch ( type )
+  {
+    case QVariant::String:
+    {
+      const char *value = OGR_F_GetFieldAsString( ogrFet, attindexWithoutFid );
+      batch.setString( attindex, mSource->mEncoding ? mSource->mEncoding->toUnicode( value ) : QString::fromUtf8( value ) );
+      break;
+    }
+    case QVariant::Int:
+    case QVariant::Bool:
+      batch.setInt64( attindex, OGR_F_GetFieldAsInteger( ogrFet, attindexWithoutFid ) );
+      break;
+    case QVariant::LongLong:
+      batch.setInt64( attindex, OGR_F_GetFieldAsInteger64( ogrFet, attindexWithoutFid ) );
+      break;
+    case QVariant::Double:
+      batch.setDouble( attindex, OGR_F_GetFieldAsDouble( ogrFet, attindexWithoutFid ) );
+      break;
+    default:
+    {
+      bool ok = false;
+      const QVariant value = QgsOgrUtils::getOgrFeatureAttribute( ogrFet, mFieldsWithoutFid, attindexWithoutFid, mSource->mEncoding, &ok );
+      if ( ok )
+        batch.setValue( attindex, value );
+      break;
+    }
+  }
+}
+
 bool QgsOgrFeatureIterator::readFeature( gdal::ogr_feature_unique_ptr fet, QgsFeature &feature ) const
 {
   feature.setId( OGR_F_GetFID( fet.get() ) );
@@ -599,6 +761,10 @@ QgsOgrFeatureSource::QgsOgrFeatureSource( const QgsOgrProvider *p )
     mTransaction = p->mTransaction;
     mSharedDS = p->mTransaction->sharedDS();
   }
+  else
+  {
+    mSidecarIndex = p->sidecarSpatialIndex();
+  }
   for ( int i = ( p->mFirstFieldIsFid ) ? 1 : 0; i < mFields.size(); i++ )
     mFieldsWithoutFid.append( mFields.at( i ) );
   QgsOgrConnPool::instance()->ref( QgsOgrProviderUtils::connectionPoolId( mDataSource, mShareSameDatasetAmongLayers ) );
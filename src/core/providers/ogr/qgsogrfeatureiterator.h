@@ -23,6 +23,7 @@
 
 #include <memory>
 #include <set>
+#include <vector>
 #include "qgis_sip.h"
 
 ///@cond PRIVATE
@@ -33,6 +34,8 @@ class QgsOgrProvider;
 class QgsOgrDataset;
 using QgsOgrDatasetSharedPtr = std::shared_ptr< QgsOgrDataset>;
 
+class QgsPackedSpatialIndexFile;
+
 class QgsOgrFeatureSource final: public QgsAbstractFeatureSource
 {
   public:
@@ -58,6 +61,7 @@ class QgsOgrFeatureSource final: public QgsAbstractFeatureSource
     QgsWkbTypes::Type mWkbType = QgsWkbTypes::Unknown;
     QgsOgrDatasetSharedPtr mSharedDS = nullptr;
     QgsTransaction *mTransaction = nullptr;
+    std::shared_ptr< QgsPackedSpatialIndexFile > mSidecarIndex;
 
     friend class QgsOgrFeatureIterator;
     friend class QgsOgrExpressionCompiler;
@@ -79,6 +83,7 @@ class QgsOgrFeatureIterator final: public QgsAbstractFeatureIteratorFromSource<Q
     bool checkFeature( gdal::ogr_feature_unique_ptr &fet, QgsFeature &feature ) ;
     bool fetchFeature( QgsFeature &feature ) override;
     bool nextFeatureFilterExpression( QgsFeature &f ) override;
+    int fetchFeatureBatch( QgsFeatureBatch &batch, int maximumCount ) override;
 
   private:
 
@@ -87,6 +92,9 @@ class QgsOgrFeatureIterator final: public QgsAbstractFeatureIteratorFromSource<Q
     //! Gets an attribute associated with a feature
     void getFeatureAttribute( OGRFeatureH ogrFet, QgsFeature &f, int attindex ) const;
 
+    //! Reads an attribute of type \a type associated with a feature into the last row of a \a batch
+    void getFeatureAttribute( OGRFeatureH ogrFet, QgsFeatureBatch &batch, int attindex, QVariant::Type type ) const;
+
     QgsOgrConn *mConn = nullptr;
     OGRLayerH mOgrLayer = nullptr; // when mOgrLayerUnfiltered != null and mOgrLayer != mOgrLayerUnfiltered, this is a SQL layer
     OGRLayerH mOgrLayerOri = nullptr; // only set when there's a mSubsetString. In which case this a regular OGR layer. Potentially == mOgrLayer
@@ -103,6 +111,13 @@ class QgsOgrFeatureIterator final: public QgsAbstractFeatureIteratorFromSource<Q
     QgsCoordinateTransform mTransform;
     QgsOgrDatasetSharedPtr mSharedDS = nullptr;
 
+    //! Whether the features matching the filter rectangle are looked up in the sidecar spatial index, and read by id
+    bool mUseSidecarIndex = false;
+
+    //! Ids of the features found in the sidecar spatial index, in the order of the features in the file
+    std::vector<QgsFeatureId> mSidecarFids;
+    std::size_t mSidecarFidsPosition = 0;
+
     bool mFirstFieldIsFid = false;
     QgsFields mFieldsWithoutFid;
     QString mAuthCfg;
@@ -47,6 +47,7 @@ email                : sherman at mrcc.com
 #include "qgsprovidermetadata.h"
 #include "qgsogrdbconnection.h"
 #include "qgsgeopackageproviderconnection.h"
+#include "qgspackedspatialindexfile.h"
 #include "qgis.h"
 
 
@@ -2696,6 +2697,11 @@ bool QgsOgrProvider::createSpatialIndex()
 
   if ( !mOgrOrigLayer )
     return false;
+
+  // files without native spatial index support get a sidecar index, without modifying the file itself
+  if ( supportsSidecarSpatialIndex() )
+    return createSidecarSpatialIndex();
+
   if ( !doInitialActionsForEdition() )
     return false;
 
@@ -2726,6 +2732,88 @@ bool QgsOgrProvider::createSpatialIndex()
   return false;
 }
 
+bool QgsOgrProvider::supportsSidecarSpatialIndex() const
+{
+  if ( !mOgrOrigLayer || mGDALDriverName == QLatin1String( "ESRI Shapefile" ) ||
+       mGDALDriverName == QLatin1String( "GPKG" ) || mGDALDriverName == QLatin1String( "SQLite" ) )
+    return false;
+
+  // features found in the index are read by id, which must not require a scan of the file
+  if ( mOgrOrigLayer->TestCapability( OLCFastSpatialFilter ) || !mOgrOrigLayer->TestCapability( OLCRandomRead ) )
+    return false;
+
+  return QgsOgrProviderUtils::canDriverShareSameDatasetAmongLayers( mGDALDriverName ) && QFileInfo( mFilePath ).isFile();
+}
+
+bool QgsOgrProvider::createSidecarSpatialIndex()
+{
+  // read the whole layer through its own connection, as the layer of the provider may be filtered by a subset string
+  QgsOgrConn *conn = QgsOgrConnPool::instance()->acquireConnection( QgsOgrProviderUtils::connectionPoolId( dataSourceUri( true ), mShareSameDatasetAmongLayers ) );
+  if ( !conn || !conn->ds )
+  {
+    if ( conn )
+      QgsOgrConnPool::instance()->releaseConnection( conn );
+    return false;
+  }
+
+  OGRLayerH layer = mLayerName.isNull() ? GDALDatasetGetLayer( conn->ds, mLayerIndex )
+                    : GDALDatasetGetLayerByName( conn->ds, mLayerName.toUtf8().constData() );
+  if ( !layer )
+  {
+    QgsOgrConnPool::instance()->releaseConnection( conn );
+    return false;
+  }
+
+  QgsOgrProviderUtils::setRelevantFields( layer, mAttributeFields.count(), true, QgsAttributeList(), mFirstFieldIsFid, QString() );
+  OGR_L_SetSpatialFilter( layer, nullptr );
+  OGR_L_SetAttributeFilter( layer, nullptr );
+  OGR_L_ResetReading( layer );
+
+  std::vector< QgsPackedSpatialIndexFile::Entry > entries;
+  gdal::ogr_feature_unique_ptr fet;
+  while ( fet.reset( OGR_L_GetNextFeature( layer ) ), fet )
+  {
+    OGRGeometryH geom = OGR_F_GetGeometryRef( fet.get() );
+    if ( !geom || OGR_G_IsEmpty( geom ) )
+      continue;
+
+    OGREnvelope envelope;
+    OGR_G_GetEnvelope( geom, &envelope );
+
+    QgsPackedSpatialIndexFile::Entry entry;
+    entry.id = OGR_F_GetFID( fet.get() );
+    entry.bounds = QgsRectangle( envelope.MinX, envelope.MinY, envelope.MaxX, envelope.MaxY );
+    entries.emplace_back( entry );
+  }
+  QgsOgrConnPool::instance()->releaseConnection( conn );
+
+  // release the current index file, which is replaced by the new one
+  mSidecarSpatialIndex.reset();
+  const QString indexPath = QgsPackedSpatialIndexFile::indexPath( mFilePath, mLayerName );
+  QString error;
+  if ( !QgsPackedSpatialIndexFile::write( indexPath, mFilePath, std::move( entries ), &error ) )
+  {
+    pushError( error );
+    return false;
+  }
+
+  mSidecarSpatialIndex = QgsPackedSpatialIndexFile::open( indexPath, mFilePath );
+  mSidecarSpatialIndexChecked = true;
+  return static_cast< bool >( mSidecarSpatialIndex );
+}
+
+std::shared_ptr< QgsPackedSpatialIndexFile > QgsOgrProvider::sidecarSpatialIndex() const
+{
+  if ( !mSidecarSpatialIndex || !mSidecarSpatialIndex->isUpToDate() )
+  {
+    mSidecarSpatialIndex.reset();
+    if ( supportsSidecarSpatialIndex() )
+      mSidecarSpatialIndex = QgsPackedSpatialIndexFile::open( QgsPackedSpatialIndexFile::indexPath( mFilePath, mLayerName ), mFilePath );
+  }
+  mSidecarSpatialIndexChecked = true;
+  return mSidecarSpatialIndex;
+}
+
 QString QgsOgrProvider::createIndexName( QString tableName, QString field )
 {
   QRegularExpression safeExp( QStringLiteral( "[^a-zA-Z0-9]" ) );
@@ -3007,6 +3095,10 @@ void QgsOgrProvider::computeCapabilities()
       ability |= CreateSpatialIndex;
       ability |= CreateAttributeIndex;
     }
+    else if ( supportsSidecarSpatialIndex() )
+    {
+      ability |= CreateSpatialIndex;
+    }
 
     /* Curve geometries are available in some drivers starting with GDAL 2.0 */
     if ( mOgrLayer->TestCapability( "CurveGeometries" ) )
@@ -4186,6 +4278,9 @@ QgsFeatureSource::SpatialIndexPresence QgsOgrProvider::hasSpatialIndex() const
 
   if ( mOgrLayer && mOgrLayer->TestCapability( OLCFastSpatialFilter ) )
     return QgsFeatureSource::SpatialIndexPresent;
+  // the sidecar index is checked again each time features are requested, which updates the cached state
+  else if ( mOgrLayer && ( mSidecarSpatialIndexChecked ? static_cast< bool >( mSidecarSpatialIndex ) : static_cast< bool >( sidecarSpatialIndex() ) ) )
+    return QgsFeatureSource::SpatialIndexPresent;
   else if ( mOgrLayer )
     return QgsFeatureSource::SpatialIndexNotPresent;
   else
@@ -5032,6 +5127,8 @@ void QgsOgrProvider::close()
   mOgrSqlLayer.reset();
   mOgrOrigLayer.reset();
   mOgrLayer = nullptr;
+  mSidecarSpatialIndex.reset();
+  mSidecarSpatialIndexChecked = false;
   mValid = false;
   setProperty( "_debug_open_mode", "invalid" );
 
@@ -39,6 +39,7 @@ class QgsOgrFeatureIterator;
 
 class QgsOgrLayer;
 class QgsOgrTransaction;
+class QgsPackedSpatialIndexFile;
 
 /**
  * Releases a QgsOgrLayer
@@ -228,6 +229,18 @@ class QgsOgrProvider final: public QgsVectorDataProvider
 
     void addSubLayerDetailsToSubLayerList( int i, QgsOgrLayer *layer, bool withFeatureCount ) const;
 
+    /**
+     * Returns TRUE if the layer is a local file without a native spatial index, for which
+     * a packed spatial index can be stored in a sidecar file.
+     */
+    bool supportsSidecarSpatialIndex() const;
+
+    //! Scans the layer and writes its sidecar spatial index
+    bool createSidecarSpatialIndex();
+
+    //! Returns the sidecar spatial index of the layer, or NULLPTR if there is no up to date sidecar index
+    std::shared_ptr< QgsPackedSpatialIndexFile > sidecarSpatialIndex() const;
+
     QStringList _subLayers( bool withFeatureCount ) const;
 
     QgsFields mAttributeFields;
@@ -298,6 +311,12 @@ class QgsOgrProvider final: public QgsVectorDataProvider
     //! Whether we can share the same dataset handle among different layers
     bool mShareSameDatasetAmongLayers = true;
 
+    //! Sidecar spatial index, for files without a native spatial index
+    mutable std::shared_ptr< QgsPackedSpatialIndexFile > mSidecarSpatialIndex;
+
+    //! Whether mSidecarSpatialIndex was looked up, so that hasSpatialIndex() does not check the files on every call
+    mutable bool mSidecarSpatialIndexChecked = false;
+
     bool mValid = false;
 
     OGRwkbGeometryType mOGRGeomType = wkbUnknown;
@@ -19,6 +19,7 @@
 #include "qgsfeature.h"
 #include "qgsfeaturerequest.h"
 #include "qgsfeatureiterator.h"
+#include "qgsfeaturebatch.h"
 #include "qgsgeometry.h"
 #include "qgsvectorlayer.h"
 
@@ -677,18 +678,23 @@ QVariant QgsAggregateCalculator::calculateNumericAggregate( QgsFeatureIterator &
   Q_ASSERT( expression || attr >= 0 );
 
   QgsStatisticalSummary s( stat );
-  QgsFeature f;
 
-  while ( fit.nextFeature( f ) )
+  if ( expression )
   {
-    if ( expression )
+    Q_ASSERT( context );
+    // expressions are evaluated for a whole batch of features at once
+    QgsFeatureBatch batch;
+    while ( fit.nextBatch( batch ) )
     {
-      Q_ASSERT( context );
-      context->setFeature( f );
-      QVariant v = expression->evaluate( context );
-      s.addVariant( v );
+      const QVector< QVariant > values = expression->evaluateBatch( batch, context );
+      for ( const QVariant &v : values )
+        s.addVariant( v );
     }
-    else
+  }
+  else
+  {
+    QgsFeature f;
+    while ( fit.nextFeature( f ) )
     {
       s.addVariant( f.attribute( attr ) );
     }
@@ -704,18 +710,22 @@ QVariant QgsAggregateCalculator::calculateStringAggregate( QgsFeatureIterator &f
   Q_ASSERT( expression || attr >= 0 );
 
   QgsStringStatisticalSummary s( stat );
-  QgsFeature f;
 
-  while ( fit.nextFeature( f ) )
+  if ( expression )
   {
-    if ( expression )
+    Q_ASSERT( context );
+    QgsFeatureBatch batch;
+    while ( fit.nextBatch( batch ) )
     {
-      Q_ASSERT( context );
-      context->setFeature( f );
-      QVariant v = expression->evaluate( context );
-      s.addValue( v );
+      const QVector< QVariant > values = expression->evaluateBatch( batch, context );
+      for ( const QVariant &v : values )
+        s.addValue( v );
     }
-    else
+  }
+  else
+  {
+    QgsFeature f;
+    while ( fit.nextFeature( f ) )
     {
       s.addValue( f.attribute( attr ) );
     }
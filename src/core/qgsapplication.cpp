@@ -416,6 +416,9 @@ void QgsApplication::invalidateCaches()
   // invalidate coordinate cache while the PROJ context held by the thread-locale
   // QgsProjContextStore object is still alive. Otherwise if this later object
   // is destroyed before the static variables of the cache, we might use freed memory.
+  // Pooled contexts of finished threads are released first, while the caches still
+  // allow removing the objects which belong to them.
+  QgsProjContext::clearPool();
   QgsCoordinateTransform::invalidateCache( true );
   QgsCoordinateReferenceSystem::invalidateCache( true );
   QgsEllipsoidUtils::invalidateCache( true );
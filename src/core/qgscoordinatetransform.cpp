@@ -51,6 +51,7 @@
 QReadWriteLock QgsCoordinateTransform::sCacheLock;
 QMultiHash< QPair< QString, QString >, QgsCoordinateTransform > QgsCoordinateTransform::sTransforms; //same auth_id pairs might have different datum transformations
 bool QgsCoordinateTransform::sDisableCache = false;
+int QgsCoordinateTransform::sMaximumCacheSize = 1000;
 
 std::function< void( const QgsCoordinateReferenceSystem &sourceCrs,
                      const QgsCoordinateReferenceSystem &destinationCrs,
@@ -646,6 +647,26 @@ void QgsCoordinateTransform::transformCoords( int numPoints, double *x, double *
     return;
   }
 
+#if PROJ_VERSION_MAJOR>=6
+  if ( d->mKernel.isValid() )
+  {
+    // simple operations are done without proj. Any coordinates which can't be handled by the
+    // closed form kernel (e.g. at the poles) are left for proj to transform
+    const bool inverse = !( ( direction == ForwardTransform && !d->mIsReversed ) || ( direction == ReverseTransform && d->mIsReversed ) );
+    const int transformed = d->mKernel.transform( numPoints, x, y, inverse );
+    if ( transformed == numPoints )
+    {
+      mFallbackOperationOccurred = false;
+      return;
+    }
+
+    x += transformed;
+    y += transformed;
+    z += transformed;
+    numPoints -= transformed;
+  }
+#endif
+
   std::vector< int > zNanPositions;
   for ( int i = 0; i < numPoints; i++ )
   {
@@ -990,6 +1011,9 @@ bool QgsCoordinateTransform::setFromCache( const QgsCoordinateReferenceSystem &s
       *this = *valIt;
       locker.unlock();
 
+      d->mLastCacheAccess = ++QgsCoordinateTransformPrivate::sCacheAccessCounter;
+      QgsCoordinateTransformPrivate::sCacheHits++;
+
       mContext = context;
 #ifdef QGISDEBUG
       mHasContext = hasContext;
@@ -998,6 +1022,7 @@ bool QgsCoordinateTransform::setFromCache( const QgsCoordinateReferenceSystem &s
       return true;
     }
   }
+  QgsCoordinateTransformPrivate::sCacheMisses++;
   return false;
 }
 #else
@@ -1033,6 +1058,9 @@ bool QgsCoordinateTransform::setFromCache( const QgsCoordinateReferenceSystem &s
       *this = *valIt;
       locker.unlock();
 
+      d->mLastCacheAccess = ++QgsCoordinateTransformPrivate::sCacheAccessCounter;
+      QgsCoordinateTransformPrivate::sCacheHits++;
+
       mContext = context;
 #ifdef QGISDEBUG
       mHasContext = hasContext;
@@ -1042,6 +1070,7 @@ bool QgsCoordinateTransform::setFromCache( const QgsCoordinateReferenceSystem &s
     }
     Q_NOWARN_DEPRECATED_POP
   }
+  QgsCoordinateTransformPrivate::sCacheMisses++;
   return false;
 }
 #endif
@@ -1063,7 +1092,79 @@ void QgsCoordinateTransform::addToCache()
   if ( sDisableCache )
     return;
 
+  d->mLastCacheAccess = ++QgsCoordinateTransformPrivate::sCacheAccessCounter;
   sTransforms.insert( qMakePair( sourceKey, destKey ), *this );
+  trimCache();
+}
+
+void QgsCoordinateTransform::trimCache()
+{
+  if ( sMaximumCacheSize <= 0 )
+    return;
+
+  while ( sTransforms.size() > sMaximumCacheSize )
+  {
+    // the cache only changes when a new transform is created, so a linear scan is cheap enough
+    auto leastRecentlyUsed = sTransforms.begin();
+    for ( auto it = sTransforms.begin(); it != sTransforms.end(); ++it )
+    {
+      if ( it.value().d->mLastCacheAccess < leastRecentlyUsed.value().d->mLastCacheAccess )
+        leastRecentlyUsed = it;
+    }
+    sTransforms.erase( leastRecentlyUsed );
+    QgsCoordinateTransformPrivate::sCacheEvictions++;
+  }
+}
+
+QgsCoordinateTransform::CacheStatistics QgsCoordinateTransform::cacheStatistics()
+{
+  CacheStatistics statistics;
+  {
+    QgsReadWriteLocker locker( sCacheLock, QgsReadWriteLocker::Read );
+    statistics.cachedTransforms = sTransforms.size();
+  }
+  statistics.cacheHits = QgsCoordinateTransformPrivate::sCacheHits;
+  statistics.cacheMisses = QgsCoordinateTransformPrivate::sCacheMisses;
+  statistics.evictions = QgsCoordinateTransformPrivate::sCacheEvictions;
+  statistics.projObjectsCreated = QgsCoordinateTransformPrivate::sProjObjectsCreated;
+  statistics.projObjectsCloned = QgsCoordinateTransformPrivate::sProjObjectsCloned;
+  statistics.projCreationTime = QgsCoordinateTransformPrivate::sProjCreationTimeNs / 1000000.0;
+  return statistics;
+}
+
+void QgsCoordinateTransform::setMaximumCacheSize( int size )
+{
+  QgsReadWriteLocker locker( sCacheLock, QgsReadWriteLocker::Write );
+  sMaximumCacheSize = size;
+  trimCache();
+}
+
+int QgsCoordinateTransform::maximumCacheSize()
+{
+  QgsReadWriteLocker locker( sCacheLock, QgsReadWriteLocker::Read );
+  return sMaximumCacheSize;
+}
+
+int QgsCoordinateTransform::warmUpCache( const QList<QgsCoordinateReferenceSystem> &sourceCrs, const QList<QgsCoordinateReferenceSystem> &destinationCrs, const QgsCoordinateTransformContext &context )
+{
+  int count = 0;
+  for ( const QgsCoordinateReferenceSystem &source : sourceCrs )
+  {
+    if ( !source.isValid() )
+      continue;
+
+    for ( const QgsCoordinateReferenceSystem &destination : destinationCrs )
+    {
+      if ( !destination.isValid() || destination == source )
+        continue;
+
+      // creating the transform prepares the proj coordinate operation for this thread and stores it in the cache
+      const QgsCoordinateTransform transform( source, destination, context );
+      if ( transform.isValid() )
+        count++;
+    }
+  }
+  return count;
 }
 
 int QgsCoordinateTransform::sourceDatumTransformId() const
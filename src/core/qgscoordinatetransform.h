@@ -324,6 +324,10 @@ class CORE_EXPORT QgsCoordinateTransform
      * \param y array of y coordinates to transform
      * \param z array of z coordinates to transform
      * \param direction transform direction (defaults to ForwardTransform)
+     *
+     * \note Simple coordinate operations (such as Web Mercator or UTM projections on the same datum) are
+     * calculated directly instead of through proj, so transforming many coordinates with a single call is
+     * considerably faster than transforming them one by one.
      */
     void transformCoords( int numPoint, double *x, double *y, double *z, TransformDirection direction = ForwardTransform ) const SIP_THROW( QgsCsException );
 
@@ -553,6 +557,85 @@ class CORE_EXPORT QgsCoordinateTransform
     static void invalidateCache( bool disableCache SIP_PYARGREMOVE = false );
 #endif
 
+    /**
+     * \ingroup core
+     * \brief Statistics about the reuse of cached coordinate transforms and of the proj
+     * objects created for them.
+     *
+     * All counts are accumulated since the start of the process.
+     *
+     * \see QgsCoordinateTransform::cacheStatistics()
+     * \since QGIS 3.18
+     */
+    struct CORE_EXPORT CacheStatistics
+    {
+      //! Number of transforms currently stored in the cache
+      int cachedTransforms = 0;
+
+      //! Number of transforms which were initialized from the cache
+      qint64 cacheHits = 0;
+
+      //! Number of transforms which were not found in the cache and had to be created
+      qint64 cacheMisses = 0;
+
+      //! Number of least recently used transforms which were removed because the cache was full
+      qint64 evictions = 0;
+
+      //! Number of proj coordinate operations which were created from scratch
+      qint64 projObjectsCreated = 0;
+
+      //! Number of proj coordinate operations which were cloned from an operation already created for another thread
+      qint64 projObjectsCloned = 0;
+
+      //! Total time spent creating and cloning proj coordinate operations, in milliseconds
+      double projCreationTime = 0;
+    };
+
+    /**
+     * Returns statistics about the coordinate transform cache, e.g. to check how often transforms
+     * and their proj objects are reused between map render jobs or server requests.
+     *
+     * \since QGIS 3.18
+     */
+    static QgsCoordinateTransform::CacheStatistics cacheStatistics();
+
+    /**
+     * Sets the maximum number of transforms which are stored in the cache used to
+     * initialize QgsCoordinateTransform objects.
+     *
+     * When the cache is full, the least recently used transforms are removed from it. A \a size
+     * of 0 or less means that the cache is unbounded.
+     *
+     * \see maximumCacheSize()
+     * \since QGIS 3.18
+     */
+    static void setMaximumCacheSize( int size );
+
+    /**
+     * Returns the maximum number of transforms which are stored in the cache used to
+     * initialize QgsCoordinateTransform objects. A value of 0 or less means that the cache is unbounded.
+     *
+     * \see setMaximumCacheSize()
+     * \since QGIS 3.18
+     */
+    static int maximumCacheSize();
+
+    /**
+     * Creates the transforms between every valid pair of reference systems from the \a sourceCrs and
+     * \a destinationCrs lists, using the specified transform \a context, and stores them in the cache.
+     *
+     * This moves the cost of selecting and preparing the coordinate operations out of the first
+     * requests which need them, e.g. when a QGIS Server project is loaded. Pairs of identical
+     * reference systems are skipped.
+     *
+     * Returns the number of valid transforms which were prepared.
+     *
+     * \since QGIS 3.18
+     */
+    static int warmUpCache( const QList< QgsCoordinateReferenceSystem > &sourceCrs,
+                            const QList< QgsCoordinateReferenceSystem > &destinationCrs,
+                            const QgsCoordinateTransformContext &context );
+
     /**
      * Computes an *estimated* conversion factor between source and destination units:
      *
@@ -694,10 +777,14 @@ class CORE_EXPORT QgsCoordinateTransform
 #endif
     void addToCache();
 
+    // Removes the least recently used transforms until the cache fits sMaximumCacheSize. sCacheLock must be locked for writing.
+    static void trimCache();
+
     // cache
     static QReadWriteLock sCacheLock;
     static QMultiHash< QPair< QString, QString >, QgsCoordinateTransform > sTransforms; //same auth_id pairs might have different datum transformations
     static bool sDisableCache;
+    static int sMaximumCacheSize;
 
 
     static std::function< void( const QgsCoordinateReferenceSystem &sourceCrs,
@@ -32,6 +32,7 @@
 #include <sqlite3.h>
 
 #include <QStringList>
+#include <QElapsedTimer>
 
 /// @cond PRIVATE
 
@@ -71,6 +72,14 @@ QgsProjContextStore::~QgsProjContextStore()
 
 #endif
 
+std::atomic< quint64 > QgsCoordinateTransformPrivate::sCacheAccessCounter{ 0 };
+std::atomic< qint64 > QgsCoordinateTransformPrivate::sCacheHits{ 0 };
+std::atomic< qint64 > QgsCoordinateTransformPrivate::sCacheMisses{ 0 };
+std::atomic< qint64 > QgsCoordinateTransformPrivate::sCacheEvictions{ 0 };
+std::atomic< qint64 > QgsCoordinateTransformPrivate::sProjObjectsCreated{ 0 };
+std::atomic< qint64 > QgsCoordinateTransformPrivate::sProjObjectsCloned{ 0 };
+std::atomic< qint64 > QgsCoordinateTransformPrivate::sProjCreationTimeNs{ 0 };
+
 Q_NOWARN_DEPRECATED_PUSH // because of deprecated members
 QgsCoordinateTransformPrivate::QgsCoordinateTransformPrivate()
 {
@@ -113,6 +122,7 @@ QgsCoordinateTransformPrivate::QgsCoordinateTransformPrivate( const QgsCoordinat
   , mShouldReverseCoordinateOperation( other.mShouldReverseCoordinateOperation )
   , mAllowFallbackTransforms( other.mAllowFallbackTransforms )
   , mIsReversed( other.mIsReversed )
+  , mKernel( other.mKernel )
   , mProjLock()
   , mProjProjections()
   , mProjFallbackProjections()
@@ -146,6 +156,7 @@ void QgsCoordinateTransformPrivate::invalidate()
 {
   mShortCircuit = true;
   mIsValid = false;
+  mKernel = QgsCoordinateTransformKernel();
 #if PROJ_VERSION_MAJOR >= 6
   mAvailableOpCount = -1;
 #endif
@@ -228,6 +239,8 @@ bool QgsCoordinateTransformPrivate::initialize()
 #if PROJ_VERSION_MAJOR>=6
   if ( !res )
     mIsValid = false;
+  else
+    mKernel = QgsCoordinateTransformKernel::fromProjDefinition( QString( proj_pj_info( res ).definition ) );
 #else
   if ( !res.first || !res.second )
   {
@@ -346,6 +359,22 @@ ProjData QgsCoordinateTransformPrivate::threadLocalProjData()
   locker.changeMode( QgsReadWriteLocker::Write );
 
 #if PROJ_VERSION_MAJOR>=6
+  QElapsedTimer creationTimer;
+  creationTimer.start();
+
+  if ( !mProjProjections.isEmpty() )
+  {
+    // the coordinate operation was already selected for another thread, so cloning it is much
+    // cheaper than running the whole operation search again
+    if ( PJ *clone = proj_clone( context, mProjProjections.first() ) )
+    {
+      mProjProjections.insert( reinterpret_cast< uintptr_t>( context ), clone );
+      sProjObjectsCloned++;
+      sProjCreationTimeNs += creationTimer.nsecsElapsed();
+      return clone;
+    }
+  }
+
   // use a temporary proj error collector
   QStringList projErrors;
   proj_log_func( context, &projErrors, proj_collecting_logger );
@@ -585,6 +614,8 @@ ProjData QgsCoordinateTransformPrivate::threadLocalProjData()
 
   ProjData res = transform.release();
   mProjProjections.insert( reinterpret_cast< uintptr_t>( context ), res );
+  sProjObjectsCreated++;
+  sProjCreationTimeNs += creationTimer.nsecsElapsed();
 #else
 #ifdef USE_THREAD_LOCAL
   Q_NOWARN_DEPRECATED_PUSH
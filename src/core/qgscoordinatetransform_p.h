@@ -32,6 +32,7 @@
 //
 
 #include <QSharedData>
+#include <atomic>
 
 #if PROJ_VERSION_MAJOR<6
 typedef void *projPJ;
@@ -47,6 +48,7 @@ typedef PJ *ProjData;
 
 #include "qgscoordinatereferencesystem.h"
 #include "qgscoordinatetransformcontext.h"
+#include "qgscoordinatetransformkernel_p.h"
 
 #if PROJ_VERSION_MAJOR<6
 
@@ -140,6 +142,13 @@ class QgsCoordinateTransformPrivate : public QSharedData
     //! True if the proj transform corresponds to the reverse direction, and must be flipped when transforming...
     bool mIsReversed = false;
 
+    /**
+     * Closed form implementation of the proj transform, which is used instead of proj when
+     * the coordinate operation is simple enough (e.g. Web Mercator or UTM on the same datum).
+     * Invalid if the operation must always be done by proj.
+     */
+    QgsCoordinateTransformKernel mKernel;
+
 #if PROJ_VERSION_MAJOR<6
 
     /**
@@ -158,6 +167,20 @@ class QgsCoordinateTransformPrivate : public QSharedData
     QMap < uintptr_t, ProjData > mProjProjections;
     QMap < uintptr_t, ProjData > mProjFallbackProjections;
 
+    //! Value of sCacheAccessCounter when the transform was last taken from (or added to) the transform cache
+    mutable std::atomic< quint64 > mLastCacheAccess{ 0 };
+
+    //! Monotonic counter used to find the least recently used transforms in the transform cache
+    static std::atomic< quint64 > sCacheAccessCounter;
+
+    //! Transform cache statistics, see QgsCoordinateTransform::cacheStatistics()
+    static std::atomic< qint64 > sCacheHits;
+    static std::atomic< qint64 > sCacheMisses;
+    static std::atomic< qint64 > sCacheEvictions;
+    static std::atomic< qint64 > sProjObjectsCreated;
+    static std::atomic< qint64 > sProjObjectsCloned;
+    static std::atomic< qint64 > sProjCreationTimeNs;
+
     /**
      * Sets a custom handler to use when a coordinate transform is created between \a sourceCrs and
      * \a destinationCrs, yet the coordinate operation requires a transform \a grid which is not present
@@ -0,0 +1,773 @@
+/***************************************************************************
+               qgscoordinatetransformkernel_p.cpp
+               ----------------------------------
+    begin                : February 2021
+    copyright            : (C) 2021 by QGIS.org
+    email                : info at qgis dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgscoordinatetransformkernel_p.h"
+#include "qgis.h"
+
+#include <QHash>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+/// @cond PRIVATE
+
+// number of coordinates transformed at once, small enough for the chunk buffers to stay in L1 cache
+constexpr int CHUNK_SIZE = 256;
+
+// tolerances used by proj when checking the input of projections
+constexpr double EPS10 = 1e-10;
+constexpr double EPS12 = 1e-12;
+
+// limit of the Poder/Engsager Transverse Mercator implementation in proj (150 degrees)
+constexpr double TMERC_MAX_CE = 2.623395162778;
+
+constexpr int TMERC_ORDER = 6;
+
+/**
+ * Reduces a longitude in radians to the range [-pi, pi], exactly as proj's adjlon().
+ */
+static inline double adjlon( double longitude )
+{
+  if ( std::fabs( longitude ) < M_PI + EPS12 )
+    return longitude;
+
+  longitude += M_PI;
+  longitude -= 2 * M_PI * std::floor( longitude / ( 2 * M_PI ) );
+  longitude -= M_PI;
+  return longitude;
+}
+
+// The following functions are the Clenshaw summations of the Poder/Engsager Transverse Mercator
+// implementation of proj (tmerc.cpp), which this kernel must match to the millimeter.
+
+static inline double gatg( const double *p1, double B )
+{
+  const double cos_2B = 2 * std::cos( 2 * B );
+  const double *p = p1 + TMERC_ORDER;
+  double h = 0;
+  double h1 = *--p;
+  double h2 = 0;
+  while ( p - p1 )
+  {
+    h = -h2 + cos_2B * h1 + *--p;
+    h2 = h1;
+    h1 = h;
+  }
+  return B + h * std::sin( 2 * B );
+}
+
+static inline double clenS( const double *a, double arg_r, double arg_i, double *R, double *I )
+{
+  const double *p = a + TMERC_ORDER;
+  const double sin_arg_r = std::sin( arg_r );
+  const double cos_arg_r = std::cos( arg_r );
+  const double sinh_arg_i = std::sinh( arg_i );
+  const double cosh_arg_i = std::cosh( arg_i );
+  double r = 2 * cos_arg_r * cosh_arg_i;
+  double i = -2 * sin_arg_r * sinh_arg_i;
+  double hr = *--p;
+  double hr1 = 0;
+  double hr2 = 0;
+  double hi = 0;
+  double hi1 = 0;
+  double hi2 = 0;
+  while ( a - p )
+  {
+    hr2 = hr1;
+    hi2 = hi1;
+    hr1 = hr;
+    hi1 = hi;
+    hr = -hr2 + r * hr1 - i * hi1 + *--p;
+    hi = -hi2 + i * hr1 + r * hi1;
+  }
+  r = sin_arg_r * cosh_arg_i;
+  i = cos_arg_r * sinh_arg_i;
+  *R = r * hr - i * hi;
+  *I = r * hi + i * hr;
+  return *R;
+}
+
+static inline double clens( const double *a, double arg_r )
+{
+  const double *p = a + TMERC_ORDER;
+  const double r = 2 * std::cos( arg_r );
+  double hr = *--p;
+  double hr1 = 0;
+  double hr2 = 0;
+  while ( a - p )
+  {
+    hr2 = hr1;
+    hr1 = hr;
+    hr = -hr2 + r * hr1 + *--p;
+  }
+  return std::sin( arg_r ) * hr;
+}
+
+/**
+ * Returns the affine matrix of applying \a first and then \a second.
+ */
+static void composeMatrices( const double *first, const double *second, double *result )
+{
+  result[0] = second[0] + second[1] * first[0] + second[2] * first[3];
+  result[1] = second[1] * first[1] + second[2] * first[4];
+  result[2] = second[1] * first[2] + second[2] * first[5];
+  result[3] = second[3] + second[4] * first[0] + second[5] * first[3];
+  result[4] = second[4] * first[1] + second[5] * first[4];
+  result[5] = second[4] * first[2] + second[5] * first[5];
+}
+
+/**
+ * Calculates the inverse of an affine \a matrix. Returns FALSE if the matrix is not invertible.
+ */
+static bool invertMatrix( const double *matrix, double *result )
+{
+  const double det = matrix[1] * matrix[5] - matrix[2] * matrix[4];
+  if ( det == 0 || !std::isfinite( det ) )
+    return false;
+
+  result[1] = matrix[5] / det;
+  result[2] = -matrix[2] / det;
+  result[4] = -matrix[4] / det;
+  result[5] = matrix[1] / det;
+  result[0] = -( result[1] * matrix[0] + result[2] * matrix[3] );
+  result[3] = -( result[4] * matrix[0] + result[5] * matrix[3] );
+  return true;
+}
+
+/**
+ * Returns the conversion factor of a proj unit, to meters for linear units or to radians for
+ * angular units. Returns 0 for unknown units.
+ */
+static double unitFactor( const QString &unit, bool &isAngular )
+{
+  isAngular = false;
+  if ( unit == QLatin1String( "m" ) )
+    return 1;
+  else if ( unit == QLatin1String( "km" ) )
+    return 1000;
+  else if ( unit == QLatin1String( "cm" ) )
+    return 0.01;
+  else if ( unit == QLatin1String( "mm" ) )
+    return 0.001;
+  else if ( unit == QLatin1String( "ft" ) )
+    return 0.3048;
+  else if ( unit == QLatin1String( "us-ft" ) )
+    return 1200.0 / 3937.0;
+
+  isAngular = true;
+  if ( unit == QLatin1String( "rad" ) )
+    return 1;
+  else if ( unit == QLatin1String( "deg" ) )
+    return M_PI / 180.0;
+  else if ( unit == QLatin1String( "grad" ) )
+    return M_PI / 200.0;
+
+  // a numeric conversion factor to meters
+  isAngular = false;
+  bool ok = false;
+  const double factor = unit.toDouble( &ok );
+  return ok && factor > 0 ? factor : 0;
+}
+
+/**
+ * Parses the ellipsoid parameters of a step. Returns FALSE if they cannot be handled.
+ */
+static bool parseEllipsoid( QHash< QString, QString > &params, double &a, double &es )
+{
+  // proj's default ellipsoid
+  a = 6378137.0;
+  double rf = 298.257222101;
+
+  const QString ellps = params.take( QStringLiteral( "ellps" ) );
+  const QString datum = params.take( QStringLiteral( "datum" ) );
+  if ( ellps == QLatin1String( "WGS84" ) || ( ellps.isEmpty() && datum == QLatin1String( "WGS84" ) ) )
+  {
+    rf = 298.257223563;
+  }
+  else if ( !ellps.isEmpty() && ellps != QLatin1String( "GRS80" ) )
+  {
+    return false;
+  }
+  else if ( !datum.isEmpty() && datum != QLatin1String( "WGS84" ) )
+  {
+    return false;
+  }
+
+  bool ok = true;
+  if ( params.contains( QStringLiteral( "R" ) ) )
+  {
+    a = params.take( QStringLiteral( "R" ) ).toDouble( &ok );
+    es = 0;
+    return ok && a > 0 && !params.contains( QStringLiteral( "a" ) ) && !params.contains( QStringLiteral( "b" ) )
+           && !params.contains( QStringLiteral( "rf" ) ) && !params.contains( QStringLiteral( "f" ) );
+  }
+
+  if ( params.contains( QStringLiteral( "a" ) ) )
+  {
+    a = params.take( QStringLiteral( "a" ) ).toDouble( &ok );
+    if ( !ok || a <= 0 )
+      return false;
+  }
+
+  double f = 1 / rf;
+  if ( params.contains( QStringLiteral( "rf" ) ) )
+  {
+    rf = params.take( QStringLiteral( "rf" ) ).toDouble( &ok );
+    if ( !ok || rf <= 0 )
+      return false;
+    f = 1 / rf;
+  }
+  else if ( params.contains( QStringLiteral( "f" ) ) )
+  {
+    f = params.take( QStringLiteral( "f" ) ).toDouble( &ok );
+    if ( !ok || f < 0 || f >= 1 )
+      return false;
+  }
+  else if ( params.contains( QStringLiteral( "b" ) ) )
+  {
+    const double b = params.take( QStringLiteral( "b" ) ).toDouble( &ok );
+    if ( !ok || b <= 0 || b > a )
+      return false;
+    f = ( a - b ) / a;
+  }
+
+  es = f * ( 2 - f );
+  return true;
+}
+
+/**
+ * Takes an optional numeric parameter from a step. Returns FALSE if it is present but not numeric.
+ */
+static bool takeNumber( QHash< QString, QString > &params, const QString &key, double &value )
+{
+  if ( !params.contains( key ) )
+    return true;
+
+  bool ok = false;
+  value = params.take( key ).toDouble( &ok );
+  return ok && std::isfinite( value );
+}
+
+bool QgsCoordinateTransformKernel::parseStep( const QStringList &tokens, Step &step, bool &isNoop )
+{
+  isNoop = false;
+
+  QHash< QString, QString > params;
+  for ( const QString &token : tokens )
+  {
+    const int equals = token.indexOf( '=' );
+    if ( equals < 0 )
+      params.insert( token, QString() );
+    else
+      params.insert( token.left( equals ), token.mid( equals + 1 ) );
+  }
+
+  step.inverse = params.remove( QStringLiteral( "inv" ) ) > 0;
+  const QString proj = params.take( QStringLiteral( "proj" ) );
+
+  // parameters which have no effect on the transformation
+  params.remove( QStringLiteral( "no_defs" ) );
+  params.remove( QStringLiteral( "wktext" ) );
+  params.remove( QStringLiteral( "type" ) );
+  if ( params.contains( QStringLiteral( "units" ) ) && params.take( QStringLiteral( "units" ) ) != QLatin1String( "m" ) )
+    return false;
+
+  if ( proj != QLatin1String( "webmerc" ) && proj != QLatin1String( "utm" ) && proj != QLatin1String( "tmerc" ) )
+  {
+    // ellipsoid parameters (e.g. set globally for a pipeline) don't affect the other steps
+    double a = 0;
+    double es = 0;
+    if ( !parseEllipsoid( params, a, es ) )
+      return false;
+  }
+
+  if ( proj == QLatin1String( "noop" ) )
+  {
+    isNoop = true;
+  }
+  else if ( proj == QLatin1String( "unitconvert" ) )
+  {
+    const QString in = params.take( QStringLiteral( "xy_in" ) );
+    const QString out = params.take( QStringLiteral( "xy_out" ) );
+    if ( in.isEmpty() && out.isEmpty() )
+    {
+      isNoop = true;
+    }
+    else
+    {
+      bool inIsAngular = false;
+      bool outIsAngular = false;
+      const double inFactor = unitFactor( in, inIsAngular );
+      const double outFactor = unitFactor( out, outIsAngular );
+      if ( inFactor == 0 || outFactor == 0 || inIsAngular != outIsAngular )
+        return false;
+
+      const double factor = inFactor / outFactor;
+      step.type = Step::Affine;
+      step.forwardMatrix[1] = factor;
+      step.forwardMatrix[5] = factor;
+      step.inverseMatrix[1] = 1 / factor;
+      step.inverseMatrix[5] = 1 / factor;
+    }
+  }
+  else if ( proj == QLatin1String( "axisswap" ) )
+  {
+    const QStringList order = params.take( QStringLiteral( "order" ) ).split( ',' );
+    if ( order.size() < 2 )
+      return false;
+
+    double matrix[6] = { 0, 0, 0, 0, 0, 0 };
+    for ( int i = 0; i < order.size(); ++i )
+    {
+      bool ok = false;
+      const int axis = order.at( i ).toInt( &ok );
+      if ( !ok || axis == 0 )
+        return false;
+
+      if ( i < 2 )
+      {
+        // only swapping and flipping the horizontal axes can be handled
+        if ( std::abs( axis ) > 2 )
+          return false;
+        matrix[ i * 3 + std::abs( axis ) ] = axis > 0 ? 1 : -1;
+      }
+      else if ( axis != i + 1 )
+      {
+        return false;
+      }
+    }
+
+    step.type = Step::Affine;
+    std::copy( matrix, matrix + 6, step.forwardMatrix );
+    if ( !invertMatrix( step.forwardMatrix, step.inverseMatrix ) )
+      return false;
+  }
+  else if ( proj == QLatin1String( "affine" ) )
+  {
+    double matrix[6] = { 0, 1, 0, 0, 0, 1 };
+    double zOffset = 0;
+    double tOffset = 0;
+    double tScale = 1;
+    double zMatrix[5] = { 0, 0, 0, 0, 1 };
+    if ( !takeNumber( params, QStringLiteral( "xoff" ), matrix[0] )
+         || !takeNumber( params, QStringLiteral( "s11" ), matrix[1] )
+         || !takeNumber( params, QStringLiteral( "s12" ), matrix[2] )
+         || !takeNumber( params, QStringLiteral( "yoff" ), matrix[3] )
+         || !takeNumber( params, QStringLiteral( "s21" ), matrix[4] )
+         || !takeNumber( params, QStringLiteral( "s22" ), matrix[5] )
+         || !takeNumber( params, QStringLiteral( "zoff" ), zOffset )
+         || !takeNumber( params, QStringLiteral( "toff" ), tOffset )
+         || !takeNumber( params, QStringLiteral( "tscale" ), tScale )
+         || !takeNumber( params, QStringLiteral( "s13" ), zMatrix[0] )
+         || !takeNumber( params, QStringLiteral( "s23" ), zMatrix[1] )
+         || !takeNumber( params, QStringLiteral( "s31" ), zMatrix[2] )
+         || !takeNumber( params, QStringLiteral( "s32" ), zMatrix[3] )
+         || !takeNumber( params, QStringLiteral( "s33" ), zMatrix[4] ) )
+      return false;
+
+    // the z coordinate must not be touched
+    if ( zOffset != 0 || tOffset != 0 || tScale != 1
+         || zMatrix[0] != 0 || zMatrix[1] != 0 || zMatrix[2] != 0 || zMatrix[3] != 0 || zMatrix[4] != 1 )
+      return false;
+
+    step.type = Step::Affine;
+    std::copy( matrix, matrix + 6, step.forwardMatrix );
+    if ( !invertMatrix( step.forwardMatrix, step.inverseMatrix ) )
+      return false;
+  }
+  else if ( proj == QLatin1String( "webmerc" ) )
+  {
+    double es = 0;
+    double lat0 = 0;
+    double lon0 = 0;
+    if ( !parseEllipsoid( params, step.a, es )
+         || !takeNumber( params, QStringLiteral( "lat_0" ), lat0 )
+         || !takeNumber( params, QStringLiteral( "lon_0" ), lon0 )
+         || !takeNumber( params, QStringLiteral( "x_0" ), step.x0 )
+         || !takeNumber( params, QStringLiteral( "y_0" ), step.y0 ) )
+      return false;
+
+    // webmerc always uses a sphere with the semi major axis of the ellipsoid, and a scale factor of 1
+    params.remove( QStringLiteral( "k" ) );
+    params.remove( QStringLiteral( "k_0" ) );
+    if ( lat0 != 0 )
+      return false;
+
+    step.type = Step::WebMercator;
+    step.lam0 = lon0 * M_PI / 180.0;
+  }
+  else if ( proj == QLatin1String( "utm" ) || proj == QLatin1String( "tmerc" ) )
+  {
+    double es = 0;
+    if ( !parseEllipsoid( params, step.a, es ) || es == 0 )
+      return false;
+
+    // proj uses an approximate algorithm for points near the central meridian with algo=auto, which differs from
+    // the Poder/Engsager algorithm by far less than a millimeter
+    const QString algo = params.take( QStringLiteral( "algo" ) );
+    if ( !algo.isEmpty() && algo != QLatin1String( "auto" ) && algo != QLatin1String( "poder_engsager" ) )
+      return false;
+
+    double k0 = 1;
+    double phi0 = 0;
+    if ( proj == QLatin1String( "utm" ) )
+    {
+      bool ok = false;
+      const int zone = params.take( QStringLiteral( "zone" ) ).toInt( &ok );
+      if ( !ok || zone < 1 || zone > 60 )
+        return false;
+
+      k0 = 0.9996;
+      step.lam0 = ( zone - 0.5 ) * M_PI / 30.0 - M_PI;
+      step.x0 = 500000;
+      step.y0 = params.remove( QStringLiteral( "south" ) ) > 0 ? 10000000 : 0;
+    }
+    else
+    {
+      double lat0 = 0;
+      double lon0 = 0;
+      if ( !takeNumber( params, QStringLiteral( "lat_0" ), lat0 )
+           || !takeNumber( params, QStringLiteral( "lon_0" ), lon0 )
+           || !takeNumber( params, QStringLiteral( "k" ), k0 )
+           || !takeNumber( params, QStringLiteral( "k_0" ), k0 )
+           || !takeNumber( params, QStringLiteral( "x_0" ), step.x0 )
+           || !takeNumber( params, QStringLiteral( "y_0" ), step.y0 ) )
+        return false;
+
+      phi0 = lat0 * M_PI / 180.0;
+      step.lam0 = lon0 * M_PI / 180.0;
+    }
+
+    step.type = Step::TransverseMercator;
+
+    // this matches the setup of the Poder/Engsager algorithm in proj
+    const double f = es / ( 1 + std::sqrt( 1 - es ) );
+    const double n = f / ( 2 - f );
+    double np = n;
+
+    step.cgb[0] = n * ( 2 + n * ( -2 / 3.0 + n * ( -2 + n * ( 116 / 45.0 + n * ( 26 / 45.0 + n * ( -2854 / 675.0 ) ) ) ) ) );
+    step.cbg[0] = n * ( -2 + n * ( 2 / 3.0 + n * ( 4 / 3.0 + n * ( -82 / 45.0 + n * ( 32 / 45.0 + n * ( 4642 / 4725.0 ) ) ) ) ) );
+    np *= n;
+    step.cgb[1] = np * ( 7 / 3.0 + n * ( -8 / 5.0 + n * ( -227 / 45.0 + n * ( 2704 / 315.0 + n * ( 2323 / 945.0 ) ) ) ) );
+    step.cbg[1] = np * ( 5 / 3.0 + n * ( -16 / 15.0 + n * ( -13 / 9.0 + n * ( 904 / 315.0 + n * ( -1522 / 945.0 ) ) ) ) );
+    np *= n;
+    step.cgb[2] = np * ( 56 / 15.0 + n * ( -136 / 35.0 + n * ( -1262 / 105.0 + n * ( 73814 / 2835.0 ) ) ) );
+    step.cbg[2] = np * ( -26 / 15.0 + n * ( 34 / 21.0 + n * ( 8 / 5.0 + n * ( -12686 / 2835.0 ) ) ) );
+    np *= n;
+    step.cgb[3] = np * ( 4279 / 630.0 + n * ( -332 / 35.0 + n * ( -399572 / 14175.0 ) ) );
+    step.cbg[3] = np * ( 1237 / 630.0 + n * ( -12 / 5.0 + n * ( -24832 / 14175.0 ) ) );
+    np *= n;
+    step.cgb[4] = np * ( 4174 / 315.0 + n * ( -144838 / 6237.0 ) );
+    step.cbg[4] = np * ( -734 / 315.0 + n * ( 109598 / 31185.0 ) );
+    np *= n;
+    step.cgb[5] = np * ( 601676 / 22275.0 );
+    step.cbg[5] = np * ( 444337 / 155925.0 );
+
+    np = n * n;
+    step.Qn = k0 / ( 1 + n ) * ( 1 + np * ( 1 / 4.0 + np * ( 1 / 64.0 + np / 256.0 ) ) );
+
+    step.utg[0] = n * ( -0.5 + n * ( 2 / 3.0 + n * ( -37 / 96.0 + n * ( 1 / 360.0 + n * ( 81 / 512.0 + n * ( -96199 / 604800.0 ) ) ) ) ) );
+    step.gtu[0] = n * ( 0.5 + n * ( -2 / 3.0 + n * ( 5 / 16.0 + n * ( 41 / 180.0 + n * ( -127 / 288.0 + n * ( 7891 / 37800.0 ) ) ) ) ) );
+    step.utg[1] = np * ( -1 / 48.0 + n * ( -1 / 15.0 + n * ( 437 / 1440.0 + n * ( -46 / 105.0 + n * ( 1118711 / 3870720.0 ) ) ) ) );
+    step.gtu[1] = np * ( 13 / 48.0 + n * ( -3 / 5.0 + n * ( 557 / 1440.0 + n * ( 281 / 630.0 + n * ( -1983433 / 1935360.0 ) ) ) ) );
+    np *= n;
+    step.utg[2] = np * ( -17 / 480.0 + n * ( 37 / 840.0 + n * ( 209 / 4480.0 + n * ( -5569 / 90720.0 ) ) ) );
+    step.gtu[2] = np * ( 61 / 240.0 + n * ( -103 / 140.0 + n * ( 15061 / 26880.0 + n * ( 167603 / 181440.0 ) ) ) );
+    np *= n;
+    step.utg[3] = np * ( -4397 / 161280.0 + n * ( 11 / 504.0 + n * ( 830251 / 7257600.0 ) ) );
+    step.gtu[3] = np * ( 49561 / 161280.0 + n * ( -179 / 168.0 + n * ( 6601661 / 7257600.0 ) ) );
+    np *= n;
+    step.utg[4] = np * ( -4583 / 161280.0 + n * ( 108847 / 3991680.0 ) );
+    step.gtu[4] = np * ( 34729 / 80640.0 + n * ( -3418889 / 1995840.0 ) );
+    np *= n;
+    step.utg[5] = np * ( -20648693 / 638668800.0 );
+    step.gtu[5] = np * ( 212378941 / 319334400.0 );
+
+    // origin northing minus true northing at the origin latitude
+    const double Z = gatg( step.cbg, phi0 );
+    step.Zb = -step.Qn * ( Z + clens( step.gtu, 2 * Z ) );
+  }
+  else
+  {
+    return false;
+  }
+
+  // any remaining parameter (e.g. over, lon_wrap, towgs84, nadgrids, z_in) changes the result in a way
+  // which isn't handled
+  return params.isEmpty();
+}
+
+QgsCoordinateTransformKernel QgsCoordinateTransformKernel::fromProjDefinition( const QString &definition )
+{
+  QgsCoordinateTransformKernel kernel;
+
+  bool isPipeline = false;
+  QStringList globalTokens;
+  QList< QStringList > stepTokens;
+  const QStringList tokens = definition.split( ' ', QString::SkipEmptyParts );
+  for ( QString token : tokens )
+  {
+    if ( token.startsWith( '+' ) )
+      token = token.mid( 1 );
+
+    if ( token == QLatin1String( "proj=pipeline" ) )
+      isPipeline = true;
+    else if ( token == QLatin1String( "step" ) )
+      stepTokens << QStringList();
+    else if ( stepTokens.isEmpty() )
+      globalTokens << token;
+    else
+      stepTokens.last() << token;
+  }
+
+  if ( !isPipeline )
+  {
+    stepTokens.clear();
+    stepTokens << globalTokens;
+    globalTokens.clear();
+  }
+  else if ( globalTokens.contains( QStringLiteral( "inv" ) ) )
+  {
+    return kernel;
+  }
+
+  std::vector< Step > steps;
+  for ( const QStringList &stepToken : qgis::as_const( stepTokens ) )
+  {
+    // global pipeline parameters apply to every step, unless the step overrides them
+    Step step;
+    bool isNoop = false;
+    if ( !parseStep( globalTokens + stepToken, step, isNoop ) )
+      return kernel;
+
+    if ( isNoop )
+      continue;
+
+    if ( step.type == Step::Affine && !steps.empty() && steps.back().type == Step::Affine )
+    {
+      // merge consecutive affine steps (e.g. axis swapping and unit conversions) into a single pass
+      Step &previous = steps.back();
+      const double *previousForward = previous.inverse ? previous.inverseMatrix : previous.forwardMatrix;
+      const double *forward = step.inverse ? step.inverseMatrix : step.forwardMatrix;
+      double mergedForward[6];
+      composeMatrices( previousForward, forward, mergedForward );
+      double mergedInverse[6];
+      if ( !invertMatrix( mergedForward, mergedInverse ) )
+        return kernel;
+
+      previous.inverse = false;
+      std::copy( mergedForward, mergedForward + 6, previous.forwardMatrix );
+      std::copy( mergedInverse, mergedInverse + 6, previous.inverseMatrix );
+      continue;
+    }
+
+    steps.push_back( step );
+  }
+
+  kernel.mSteps = steps;
+  return kernel;
+}
+
+void QgsCoordinateTransformKernel::applyStep( const Step &step, bool inverse, int count, double *x, double *y )
+{
+  constexpr double NaN = std::numeric_limits< double >::quiet_NaN();
+
+  switch ( step.type )
+  {
+    case Step::Affine:
+    {
+      const double *m = inverse ? step.inverseMatrix : step.forwardMatrix;
+      const double m0 = m[0];
+      const double m1 = m[1];
+      const double m2 = m[2];
+      const double m3 = m[3];
+      const double m4 = m[4];
+      const double m5 = m[5];
+      for ( int i = 0; i < count; ++i )
+      {
+        const double px = x[i];
+        const double py = y[i];
+        x[i] = m0 + m1 * px + m2 * py;
+        y[i] = m3 + m4 * px + m5 * py;
+      }
+      break;
+    }
+
+    case Step::WebMercator:
+    {
+      const double a = step.a;
+      const double ra = 1 / step.a;
+      if ( !inverse )
+      {
+        for ( int i = 0; i < count; ++i )
+        {
+          const double lam = x[i];
+          const double phi = y[i];
+          if ( std::fabs( lam ) > 10 || std::fabs( phi ) > M_PI_2 + EPS12 || std::fabs( std::fabs( phi ) - M_PI_2 ) <= EPS10 )
+          {
+            x[i] = NaN;
+            y[i] = NaN;
+            continue;
+          }
+          x[i] = a * adjlon( lam - step.lam0 ) + step.x0;
+          y[i] = a * std::asinh( std::tan( phi ) ) + step.y0;
+        }
+      }
+      else
+      {
+        for ( int i = 0; i < count; ++i )
+        {
+          const double lam = ( x[i] - step.x0 ) * ra;
+          const double phi = std::atan( std::sinh( ( y[i] - step.y0 ) * ra ) );
+          x[i] = adjlon( lam + step.lam0 );
+          y[i] = phi;
+        }
+      }
+      break;
+    }
+
+    case Step::TransverseMercator:
+    {
+      const double a = step.a;
+      const double ra = 1 / step.a;
+      if ( !inverse )
+      {
+        for ( int i = 0; i < count; ++i )
+        {
+          const double lam = x[i];
+          double Cn = y[i];
+          if ( std::fabs( lam ) > 10 || std::fabs( Cn ) > M_PI_2 + EPS12 )
+          {
+            x[i] = NaN;
+            y[i] = NaN;
+            continue;
+          }
+          double Ce = adjlon( lam - step.lam0 );
+
+          // ellipsoidal latitude, longitude -> Gaussian latitude, longitude
+          Cn = gatg( step.cbg, Cn );
+          // Gaussian latitude, longitude -> complementary spherical latitude
+          const double sin_Cn = std::sin( Cn );
+          const double cos_Cn = std::cos( Cn );
+          const double sin_Ce = std::sin( Ce );
+          const double cos_Ce = std::cos( Ce );
+          Cn = std::atan2( sin_Cn, cos_Ce * cos_Cn );
+          Ce = std::atan2( sin_Ce * cos_Cn, std::hypot( sin_Cn, cos_Cn * cos_Ce ) );
+          // complementary spherical N, E -> ellipsoidal normalized N, E
+          Ce = std::asinh( std::tan( Ce ) );
+          double dCn = 0;
+          double dCe = 0;
+          Cn += clenS( step.gtu, 2 * Cn, 2 * Ce, &dCn, &dCe );
+          Ce += dCe;
+          if ( std::fabs( Ce ) > TMERC_MAX_CE )
+          {
+            x[i] = NaN;
+            y[i] = NaN;
+            continue;
+          }
+          x[i] = a * ( step.Qn * Ce ) + step.x0;
+          y[i] = a * ( step.Qn * Cn + step.Zb ) + step.y0;
+        }
+      }
+      else
+      {
+        for ( int i = 0; i < count; ++i )
+        {
+          // normalize N, E
+          double Cn = ( ( y[i] - step.y0 ) * ra - step.Zb ) / step.Qn;
+          double Ce = ( ( x[i] - step.x0 ) * ra ) / step.Qn;
+          if ( std::fabs( Ce ) > TMERC_MAX_CE )
+          {
+            x[i] = NaN;
+            y[i] = NaN;
+            continue;
+          }
+          // normalized N, E -> complementary spherical latitude, longitude
+          double dCn = 0;
+          double dCe = 0;
+          Cn += clenS( step.utg, 2 * Cn, 2 * Ce, &dCn, &dCe );
+          Ce += dCe;
+          Ce = std::atan( std::sinh( Ce ) );
+          // complementary spherical latitude -> Gaussian latitude, longitude
+          const double sin_Cn = std::sin( Cn );
+          const double cos_Cn = std::cos( Cn );
+          const double sin_Ce = std::sin( Ce );
+          const double cos_Ce = std::cos( Ce );
+          Ce = std::atan2( sin_Ce, cos_Ce * cos_Cn );
+          Cn = std::atan2( sin_Cn * cos_Ce, std::hypot( sin_Ce, cos_Ce * cos_Cn ) );
+          // Gaussian latitude, longitude -> ellipsoidal latitude, longitude
+          x[i] = adjlon( Ce + step.lam0 );
+          y[i] = gatg( step.cgb, Cn );
+        }
+      }
+      break;
+    }
+  }
+}
+
+int QgsCoordinateTransformKernel::transform( int count, double *x, double *y, bool inverse ) const
+{
+  if ( mSteps.empty() )
+    return 0;
+
+  double chunkX[ CHUNK_SIZE ];
+  double chunkY[ CHUNK_SIZE ];
+
+  int transformed = 0;
+  while ( transformed < count )
+  {
+    const int chunkCount = std::min( CHUNK_SIZE, count - transformed );
+    double *srcX = x + transformed;
+    double *srcY = y + transformed;
+
+    bool finite = true;
+    for ( int i = 0; i < chunkCount; ++i )
+    {
+      chunkX[i] = srcX[i];
+      chunkY[i] = srcY[i];
+      finite &= std::isfinite( chunkX[i] ) && std::isfinite( chunkY[i] );
+    }
+    if ( !finite )
+      return transformed;
+
+    if ( !inverse )
+    {
+      for ( auto it = mSteps.cbegin(); it != mSteps.cend(); ++it )
+        applyStep( *it, it->inverse, chunkCount, chunkX, chunkY );
+    }
+    else
+    {
+      for ( auto it = mSteps.crbegin(); it != mSteps.crend(); ++it )
+        applyStep( *it, !it->inverse, chunkCount, chunkX, chunkY );
+    }
+
+    // points outside of the domain of a step are flagged as NaN, and must be handed to proj
+    for ( int i = 0; i < chunkCount; ++i )
+    {
+      finite &= std::isfinite( chunkX[i] ) && std::isfinite( chunkY[i] );
+    }
+    if ( !finite )
+      return transformed;
+
+    std::copy( chunkX, chunkX + chunkCount, srcX );
+    std::copy( chunkY, chunkY + chunkCount, srcY );
+    transformed += chunkCount;
+  }
+  return transformed;
+}
+
+/// @endcond
@@ -0,0 +1,130 @@
+/***************************************************************************
+               qgscoordinatetransformkernel_p.h
+               --------------------------------
+    begin                : February 2021
+    copyright            : (C) 2021 by QGIS.org
+    email                : info at qgis dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSCOORDINATETRANSFORMKERNEL_PRIVATE_H
+#define QGSCOORDINATETRANSFORMKERNEL_PRIVATE_H
+
+#define SIP_NO_FILE
+
+/// @cond PRIVATE
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the QGIS API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+
+#include "qgis_core.h"
+
+#include <QString>
+#include <QStringList>
+#include <vector>
+
+/**
+ * \ingroup core
+ * \class QgsCoordinateTransformKernel
+ * A closed form implementation of simple proj coordinate operations, used by
+ * QgsCoordinateTransform to transform large numbers of coordinates without the per-point
+ * overhead of proj.
+ *
+ * A kernel is created from the definition of a proj pipeline, and is only valid if every
+ * step of the pipeline is one of:
+ *
+ * - an affine transformation (axisswap, unitconvert of horizontal units, 2D affine, noop)
+ * - the Web Mercator projection (webmerc)
+ * - a Transverse Mercator projection on an ellipsoid (utm, tmerc), using the same
+ *   Poder/Engsager algorithm as proj
+ *
+ * Pipelines which change the datum, use grids or touch the z coordinate are never handled.
+ *
+ * Coordinates are transformed in fixed size chunks of contiguous values, so that the loops
+ * of each step can be vectorized by the compiler.
+ *
+ * \since QGIS 3.18
+ */
+class CORE_EXPORT QgsCoordinateTransformKernel
+{
+  public:
+
+    /**
+     * Creates a kernel for a proj \a definition, e.g. as returned by proj_pj_info().
+     *
+     * If the definition contains any step which cannot be handled, an invalid kernel is returned.
+     */
+    static QgsCoordinateTransformKernel fromProjDefinition( const QString &definition );
+
+    /**
+     * Returns TRUE if the kernel is valid and can be used to transform coordinates.
+     */
+    bool isValid() const { return !mSteps.empty(); }
+
+    /**
+     * Transforms \a count coordinates from the \a x and \a y arrays in place, in the forward
+     * direction of the proj operation, or its \a inverse direction.
+     *
+     * Transformation stops at the first chunk of coordinates which contains a point which
+     * is not finite or outside of the domain of the operation (e.g. the poles for Web Mercator).
+     * Returns the number of leading coordinates which were transformed, and the remaining
+     * coordinates are left untouched so that they can be transformed by proj instead.
+     */
+    int transform( int count, double *x, double *y, bool inverse ) const;
+
+  private:
+
+    struct Step
+    {
+      enum Type
+      {
+        Affine,
+        WebMercator,
+        TransverseMercator,
+      };
+
+      Type type = Affine;
+      bool inverse = false;
+
+      //! Forward and inverse affine matrices, as x0, xx, xy, y0, yx, yy
+      double forwardMatrix[6] = { 0, 1, 0, 0, 0, 1 };
+      double inverseMatrix[6] = { 0, 1, 0, 0, 0, 1 };
+
+      //! Ellipsoid semi major axis, central meridian in radians and false easting / northing
+      double a = 0;
+      double lam0 = 0;
+      double x0 = 0;
+      double y0 = 0;
+
+      //! Transverse Mercator constants
+      double Qn = 0;
+      double Zb = 0;
+      double cgb[6] = { 0, 0, 0, 0, 0, 0 };
+      double cbg[6] = { 0, 0, 0, 0, 0, 0 };
+      double utg[6] = { 0, 0, 0, 0, 0, 0 };
+      double gtu[6] = { 0, 0, 0, 0, 0, 0 };
+    };
+
+    static bool parseStep( const QStringList &tokens, Step &step, bool &isNoop );
+    static void applyStep( const Step &step, bool inverse, int count, double *x, double *y );
+
+    std::vector< Step > mSteps;
+};
+
+/// @endcond
+
+#endif // QGSCOORDINATETRANSFORMKERNEL_PRIVATE_H
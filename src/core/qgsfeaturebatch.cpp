@@ -0,0 +1,467 @@
+/***************************************************************************
+                         qgsfeaturebatch.cpp
+                         -------------------
+    begin                : February 2021
+    copyright            : (C) 2021 by QGIS.org
+    email                : info at qgis dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsfeaturebatch.h"
+#include "qgsfeature.h"
+#include "qgsgeometry.h"
+#include "qgsapplication.h"
+#include "qgsexception.h"
+#include "qgswkbptr.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+QgsFeatureBatch::ColumnType QgsFeatureBatch::columnTypeForField( QVariant::Type type )
+{
+  switch ( type )
+  {
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::LongLong:
+    case QVariant::Bool:
+      return Int64Column;
+
+    case QVariant::Double:
+      return DoubleColumn;
+
+    case QVariant::String:
+      return StringColumn;
+
+    default:
+      return VariantColumn;
+  }
+}
+
+void QgsFeatureBatch::setFields( const QgsFields &fields )
+{
+  if ( fields == mFields && static_cast< int >( mColumns.size() ) == fields.count() )
+  {
+    clear();
+    return;
+  }
+
+  mFields = fields;
+  mColumns.clear();
+  mColumns.resize( fields.count() );
+  for ( int i = 0; i < fields.count(); ++i )
+  {
+    mColumns[i].fieldType = fields.at( i ).type();
+    mColumns[i].type = columnTypeForField( mColumns[i].fieldType );
+  }
+  clear();
+}
+
+void QgsFeatureBatch::clear()
+{
+  mIds.clear();
+  mWkbOffsets.resize( 1 );
+  mWkb.resize( 0 );
+  for ( Column &column : mColumns )
+  {
+    column.nulls.clear();
+    switch ( column.type )
+    {
+      case Int64Column:
+        column.int64Values.clear();
+        break;
+      case DoubleColumn:
+        column.doubleValues.clear();
+        break;
+      case StringColumn:
+        column.stringOffsets.resize( 1 );
+        column.stringData.resize( 0 );
+        break;
+      case VariantColumn:
+        column.variantValues.clear();
+        break;
+    }
+  }
+}
+
+void QgsFeatureBatch::reserve( int count )
+{
+  mIds.reserve( count );
+  mWkbOffsets.reserve( count + 1 );
+  for ( Column &column : mColumns )
+  {
+    column.nulls.reserve( count );
+    switch ( column.type )
+    {
+      case Int64Column:
+        column.int64Values.reserve( count );
+        break;
+      case DoubleColumn:
+        column.doubleValues.reserve( count );
+        break;
+      case StringColumn:
+        column.stringOffsets.reserve( count + 1 );
+        break;
+      case VariantColumn:
+        column.variantValues.reserve( count );
+        break;
+    }
+  }
+}
+
+const qint64 *QgsFeatureBatch::int64Column( int field ) const
+{
+  const Column &column = mColumns.at( field );
+  return column.type == Int64Column ? column.int64Values.constData() : nullptr;
+}
+
+const double *QgsFeatureBatch::doubleColumn( int field ) const
+{
+  const Column &column = mColumns.at( field );
+  return column.type == DoubleColumn ? column.doubleValues.constData() : nullptr;
+}
+
+qint64 QgsFeatureBatch::int64Value( int field, int row ) const
+{
+  const Column &column = mColumns.at( field );
+  switch ( column.type )
+  {
+    case Int64Column:
+      return column.int64Values.at( row );
+    case DoubleColumn:
+      return static_cast< qint64 >( column.doubleValues.at( row ) );
+    case StringColumn:
+      return stringRef( field, row ).toLongLong();
+    case VariantColumn:
+      return column.variantValues.at( row ).toLongLong();
+  }
+  return 0;
+}
+
+double QgsFeatureBatch::doubleValue( int field, int row ) const
+{
+  const Column &column = mColumns.at( field );
+  switch ( column.type )
+  {
+    case Int64Column:
+      return static_cast< double >( column.int64Values.at( row ) );
+    case DoubleColumn:
+      return column.doubleValues.at( row );
+    case StringColumn:
+      return stringRef( field, row ).toDouble();
+    case VariantColumn:
+      return column.variantValues.at( row ).toDouble();
+  }
+  return 0;
+}
+
+QStringRef QgsFeatureBatch::stringRef( int field, int row ) const
+{
+  const Column &column = mColumns.at( field );
+  if ( column.type != StringColumn )
+    return QStringRef();
+
+  const int start = column.stringOffsets.at( row );
+  return QStringRef( &column.stringData, start, column.stringOffsets.at( row + 1 ) - start );
+}
+
+QVariant QgsFeatureBatch::value( int field, int row ) const
+{
+  const Column &column = mColumns.at( field );
+  if ( column.nulls.at( row ) )
+    return QVariant( column.fieldType );
+
+  switch ( column.type )
+  {
+    case Int64Column:
+    {
+      const qint64 value = column.int64Values.at( row );
+      switch ( column.fieldType )
+      {
+        case QVariant::Int:
+          return QVariant( static_cast< int >( value ) );
+        case QVariant::UInt:
+          return QVariant( static_cast< uint >( value ) );
+        case QVariant::Bool:
+          return QVariant( value != 0 );
+        default:
+          return QVariant( value );
+      }
+    }
+
+    case DoubleColumn:
+      return QVariant( column.doubleValues.at( row ) );
+
+    case StringColumn:
+      return QVariant( stringRef( field, row ).toString() );
+
+    case VariantColumn:
+      return column.variantValues.at( row );
+  }
+  return QVariant();
+}
+
+QByteArray QgsFeatureBatch::geometryWkb( int row ) const
+{
+  const int start = mWkbOffsets.at( row );
+  const int size = mWkbOffsets.at( row + 1 ) - start;
+  if ( size == 0 )
+    return QByteArray();
+
+  return QByteArray::fromRawData( mWkb.constData() + start, size );
+}
+
+QgsGeometry QgsFeatureBatch::geometry( int row ) const
+{
+  QgsGeometry geometry;
+  if ( hasGeometry( row ) )
+  {
+    const int start = mWkbOffsets.at( row );
+    geometry.fromWkb( QByteArray( mWkb.constData() + start, mWkbOffsets.at( row + 1 ) - start ) );
+  }
+  return geometry;
+}
+
+QgsFeature QgsFeatureBatch::feature( int row ) const
+{
+  QgsFeature feature( mFields, mIds.at( row ) );
+  for ( int i = 0; i < static_cast< int >( mColumns.size() ); ++i )
+    feature.setAttribute( i, value( i, row ) );
+  if ( hasGeometry( row ) )
+    feature.setGeometry( geometry( row ) );
+  return feature;
+}
+
+/**
+ * Vertices gathered from the geometries of a batch, together with their position in the WKB buffer.
+ */
+struct BatchVertices
+{
+  QVector< double > x;
+  QVector< double > y;
+  QVector< int > offsets;
+  QVector< bool > swapped;
+};
+
+static void collectWkbVertices( QgsConstWkbPtr &wkbPtr, const unsigned char *start, BatchVertices &vertices )
+{
+  const bool swapped = *static_cast< const unsigned char * >( wkbPtr ) != static_cast< unsigned char >( QgsApplication::endian() );
+  const QgsWkbTypes::Type type = wkbPtr.readHeader();
+  // z and m values are skipped
+  const int extraSize = ( QgsWkbTypes::coordDimensions( type ) - 2 ) * static_cast< int >( sizeof( double ) );
+
+  auto collectPoints = [&]( int count )
+  {
+    for ( int i = 0; i < count; ++i )
+    {
+      double x = 0;
+      double y = 0;
+      vertices.offsets << static_cast< int >( static_cast< const unsigned char * >( wkbPtr ) - start );
+      wkbPtr >> x >> y;
+      wkbPtr += extraSize;
+      vertices.x << x;
+      vertices.y << y;
+      vertices.swapped << swapped;
+    }
+  };
+
+  switch ( QgsWkbTypes::flatType( type ) )
+  {
+    case QgsWkbTypes::Point:
+      collectPoints( 1 );
+      break;
+
+    case QgsWkbTypes::LineString:
+    case QgsWkbTypes::CircularString:
+    {
+      int count = 0;
+      wkbPtr >> count;
+      collectPoints( count );
+      break;
+    }
+
+    case QgsWkbTypes::Polygon:
+    case QgsWkbTypes::Triangle:
+    {
+      int ringCount = 0;
+      wkbPtr >> ringCount;
+      for ( int ring = 0; ring < ringCount; ++ring )
+      {
+        int count = 0;
+        wkbPtr >> count;
+        collectPoints( count );
+      }
+      break;
+    }
+
+    case QgsWkbTypes::MultiPoint:
+    case QgsWkbTypes::MultiLineString:
+    case QgsWkbTypes::MultiPolygon:
+    case QgsWkbTypes::GeometryCollection:
+    case QgsWkbTypes::CompoundCurve:
+    case QgsWkbTypes::CurvePolygon:
+    case QgsWkbTypes::MultiCurve:
+    case QgsWkbTypes::MultiSurface:
+    {
+      int partCount = 0;
+      wkbPtr >> partCount;
+      for ( int part = 0; part < partCount; ++part )
+        collectWkbVertices( wkbPtr, start, vertices );
+      break;
+    }
+
+    default:
+      throw QgsWkbException( QStringLiteral( "Unsupported geometry type %1" ).arg( QgsWkbTypes::displayString( type ) ) );
+  }
+}
+
+static void writeWkbDouble( char *dest, double value, bool swapped )
+{
+  char *data = reinterpret_cast< char * >( &value );
+  if ( swapped )
+    std::reverse( data, data + sizeof( double ) );
+  memcpy( dest, data, sizeof( double ) );
+}
+
+void QgsFeatureBatch::transform( const QgsCoordinateTransform &ct, QgsCoordinateTransform::TransformDirection direction )
+{
+  if ( ct.isShortCircuited() || mWkb.isEmpty() )
+    return;
+
+  BatchVertices vertices;
+  const unsigned char *start = reinterpret_cast< const unsigned char * >( mWkb.constData() );
+  for ( int row = 0; row < mIds.count(); ++row )
+  {
+    const int offset = mWkbOffsets.at( row );
+    const int size = mWkbOffsets.at( row + 1 ) - offset;
+    if ( size == 0 )
+      continue;
+
+    QgsConstWkbPtr wkbPtr( start + offset, size );
+    collectWkbVertices( wkbPtr, start, vertices );
+  }
+
+  if ( vertices.offsets.isEmpty() )
+    return;
+
+  // like QgsGeometry::transform(), z values are not transformed
+  QVector< double > z( vertices.offsets.count(), std::numeric_limits< double >::quiet_NaN() );
+
+  QString error;
+  try
+  {
+    ct.transformCoords( vertices.offsets.count(), vertices.x.data(), vertices.y.data(), z.data(), direction );
+  }
+  catch ( const QgsCsException &e )
+  {
+    // record the exception, but don't rethrow it until we've written the coordinates we *could* transform
+    error = e.what();
+  }
+
+  char *data = mWkb.data();
+  for ( int i = 0; i < vertices.offsets.count(); ++i )
+  {
+    char *vertex = data + vertices.offsets.at( i );
+    const bool swapped = vertices.swapped.at( i );
+    writeWkbDouble( vertex, vertices.x.at( i ), swapped );
+    writeWkbDouble( vertex + sizeof( double ), vertices.y.at( i ), swapped );
+  }
+
+  if ( !error.isEmpty() )
+    throw QgsCsException( error );
+}
+
+int QgsFeatureBatch::addRow( QgsFeatureId id )
+{
+  mIds.append( id );
+  mWkbOffsets.append( mWkb.size() );
+  for ( Column &column : mColumns )
+  {
+    column.nulls.append( true );
+    switch ( column.type )
+    {
+      case Int64Column:
+        column.int64Values.append( 0 );
+        break;
+      case DoubleColumn:
+        column.doubleValues.append( 0.0 );
+        break;
+      case StringColumn:
+        column.stringOffsets.append( column.stringData.size() );
+        break;
+      case VariantColumn:
+        column.variantValues.append( QVariant() );
+        break;
+    }
+  }
+  return mIds.count() - 1;
+}
+
+void QgsFeatureBatch::setValue( int field, const QVariant &value )
+{
+  if ( value.isNull() )
+    return;
+
+  Column &column = mColumns[ field ];
+  switch ( column.type )
+  {
+    case Int64Column:
+    {
+      bool ok = false;
+      const qint64 intValue = value.toLongLong( &ok );
+      if ( ok )
+        setInt64( field, intValue );
+      break;
+    }
+
+    case DoubleColumn:
+    {
+      bool ok = false;
+      const double doubleValue = value.toDouble( &ok );
+      if ( ok )
+        setDouble( field, doubleValue );
+      break;
+    }
+
+    case StringColumn:
+      setString( field, value.toString() );
+      break;
+
+    case VariantColumn:
+      column.variantValues.last() = value;
+      column.nulls.last() = false;
+      break;
+  }
+}
+
+void QgsFeatureBatch::setGeometry( const QgsGeometry &geometry )
+{
+  if ( geometry.isNull() )
+    return;
+
+  const QByteArray wkb = geometry.asWkb();
+  setGeometryWkb( wkb.constData(), wkb.size() );
+}
+
+void QgsFeatureBatch::appendFeature( const QgsFeature &feature )
+{
+  addRow( feature.id() );
+
+  const QgsAttributes attributes = feature.attributes();
+  const int attributeCount = std::min( attributes.count(), static_cast< int >( mColumns.size() ) );
+  const QVariant *attributeData = attributes.constData();
+  for ( int i = 0; i < attributeCount; ++i )
+    setValue( i, attributeData[i] );
+
+  if ( feature.hasGeometry() )
+    setGeometry( feature.geometry() );
+}
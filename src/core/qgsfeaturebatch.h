@@ -0,0 +1,303 @@
+/***************************************************************************
+                         qgsfeaturebatch.h
+                         -----------------
+    begin                : February 2021
+    copyright            : (C) 2021 by QGIS.org
+    email                : info at qgis dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSFEATUREBATCH_H
+#define QGSFEATUREBATCH_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+#include "qgsfeatureid.h"
+#include "qgsfields.h"
+#include "qgscoordinatetransform.h"
+
+#include <QByteArray>
+#include <QString>
+#include <QStringRef>
+#include <QVariant>
+#include <QVector>
+#include <vector>
+
+class QgsFeature;
+class QgsGeometry;
+
+/**
+ * \ingroup core
+ * \class QgsFeatureBatch
+ * A batch of features, stored in columns ("structure of arrays") instead of individual QgsFeature objects.
+ *
+ * Feature batches are filled by QgsFeatureIterator::nextBatch(). Attribute values are stored in
+ * contiguous typed buffers, one per field:
+ *
+ * - integer and boolean fields are stored as 64 bit integers, see int64Column()
+ * - double fields are stored as doubles, see doubleColumn()
+ * - string fields are stored in a single character buffer with per feature offsets, see stringRef()
+ * - all other field types are stored as QVariant values
+ *
+ * Geometries are stored as WKB in a single buffer, see geometryWkb().
+ *
+ * This allows code which scans large numbers of features (e.g. aggregates, renderers or processing
+ * algorithms) to access attribute values without constructing a QgsFeature and boxing every value
+ * in a QVariant. Attributes which were not requested from the iterator are NULL for all features.
+ *
+ * A batch can be reused for subsequent calls to QgsFeatureIterator::nextBatch(), in which case
+ * its buffers are reused as well.
+ *
+ * \note Not available in Python bindings
+ * \since QGIS 3.18
+ */
+class CORE_EXPORT QgsFeatureBatch
+{
+  public:
+
+    //! Storage type of an attribute column
+    enum ColumnType
+    {
+      Int64Column, //!< Values stored as 64 bit integers (integer and boolean fields)
+      DoubleColumn, //!< Values stored as doubles
+      StringColumn, //!< Values stored in a shared character buffer
+      VariantColumn, //!< Values stored as QVariant (all other field types)
+    };
+
+    //! Constructor for an empty QgsFeatureBatch, without any fields
+    QgsFeatureBatch() = default;
+
+    /**
+     * Returns the storage type used for values of a field of the specified \a type.
+     */
+    static ColumnType columnTypeForField( QVariant::Type type );
+
+    /**
+     * Sets the \a fields of the features in the batch, and removes all features from the batch.
+     *
+     * This is called by feature iterators before filling the batch, and has no cost if the fields
+     * are unchanged.
+     */
+    void setFields( const QgsFields &fields );
+
+    /**
+     * Returns the fields of the features in the batch.
+     */
+    QgsFields fields() const { return mFields; }
+
+    /**
+     * Removes all features from the batch, while keeping the allocated buffers for reuse.
+     */
+    void clear();
+
+    /**
+     * Reserves space for \a count features in all buffers.
+     */
+    void reserve( int count );
+
+    /**
+     * Returns the number of features in the batch.
+     */
+    int count() const { return mIds.count(); }
+
+    /**
+     * Returns TRUE if the batch contains no features.
+     */
+    bool isEmpty() const { return mIds.isEmpty(); }
+
+    /**
+     * Returns the IDs of all features in the batch.
+     */
+    const QVector< QgsFeatureId > &ids() const { return mIds; }
+
+    /**
+     * Returns the ID of the feature at \a row.
+     */
+    QgsFeatureId id( int row ) const { return mIds.at( row ); }
+
+    /**
+     * Returns the storage type of the column for the field at index \a field.
+     */
+    ColumnType columnType( int field ) const { return mColumns.at( field ).type; }
+
+    /**
+     * Returns TRUE if the value of the field at index \a field is NULL for the feature at \a row.
+     */
+    bool isNull( int field, int row ) const { return mColumns.at( field ).nulls.at( row ); }
+
+    /**
+     * Returns the values of an Int64Column, or NULLPTR if the field at index \a field is
+     * stored differently. The array contains count() values, and NULL values are stored as 0.
+     */
+    const qint64 *int64Column( int field ) const;
+
+    /**
+     * Returns the values of a DoubleColumn, or NULLPTR if the field at index \a field is
+     * stored differently. The array contains count() values, and NULL values are stored as 0.
+     */
+    const double *doubleColumn( int field ) const;
+
+    /**
+     * Returns the value of a field as a 64 bit integer, for the feature at \a row.
+     * NULL values and values which are not numeric are returned as 0.
+     */
+    qint64 int64Value( int field, int row ) const;
+
+    /**
+     * Returns the value of a field as a double, for the feature at \a row.
+     * NULL values and values which are not numeric are returned as 0.
+     */
+    double doubleValue( int field, int row ) const;
+
+    /**
+     * Returns a reference to the value of a StringColumn for the feature at \a row, without copying
+     * the string. An empty reference is returned for other column types.
+     *
+     * The reference is only valid until the batch is modified.
+     */
+    QStringRef stringRef( int field, int row ) const;
+
+    /**
+     * Returns the value of a field for the feature at \a row, as a QVariant of the field's type.
+     */
+    QVariant value( int field, int row ) const;
+
+    /**
+     * Returns TRUE if the feature at \a row has a geometry.
+     */
+    bool hasGeometry( int row ) const { return mWkbOffsets.at( row + 1 ) > mWkbOffsets.at( row ); }
+
+    /**
+     * Returns the WKB representation of the geometry of the feature at \a row, or an empty
+     * byte array if the feature has no geometry.
+     *
+     * The returned byte array references the batch's geometry buffer without copying it, and is
+     * only valid until the batch is modified.
+     */
+    QByteArray geometryWkb( int row ) const;
+
+    /**
+     * Returns the geometry of the feature at \a row.
+     */
+    QgsGeometry geometry( int row ) const;
+
+    /**
+     * Returns a copy of the feature at \a row.
+     */
+    QgsFeature feature( int row ) const;
+
+    /**
+     * Transforms the geometries of all features in the batch in place, using the coordinate transform \a ct.
+     *
+     * The vertices of all geometries are gathered and transformed with a single call to
+     * QgsCoordinateTransform::transformCoords(), instead of transforming every geometry (and part)
+     * separately. As for QgsGeometry::transform(), z values are not transformed.
+     *
+     * \throws QgsCsException if some coordinates could not be transformed. All other coordinates are still
+     * transformed, and the failed ones are set to the values returned by proj.
+     */
+    void transform( const QgsCoordinateTransform &ct, QgsCoordinateTransform::TransformDirection direction = QgsCoordinateTransform::ForwardTransform );
+
+    /**
+     * Adds a feature with the specified \a id to the batch. All attributes of the new feature are
+     * NULL and it has no geometry, until the values are set with the setter methods.
+     *
+     * Returns the row of the new feature.
+     */
+    int addRow( QgsFeatureId id );
+
+    /**
+     * Sets the value of the field at index \a field for the last added feature, which must be stored in
+     * an Int64Column.
+     */
+    void setInt64( int field, qint64 value )
+    {
+      Column &column = mColumns[ field ];
+      column.int64Values.last() = value;
+      column.nulls.last() = false;
+    }
+
+    /**
+     * Sets the value of the field at index \a field for the last added feature, which must be stored in
+     * a DoubleColumn.
+     */
+    void setDouble( int field, double value )
+    {
+      Column &column = mColumns[ field ];
+      column.doubleValues.last() = value;
+      column.nulls.last() = false;
+    }
+
+    /**
+     * Sets the value of the field at index \a field for the last added feature, which must be stored in
+     * a StringColumn. The value can only be set once for each feature.
+     */
+    void setString( int field, const QString &value )
+    {
+      Column &column = mColumns[ field ];
+      column.stringData.append( value );
+      column.stringOffsets.last() = column.stringData.size();
+      column.nulls.last() = false;
+    }
+
+    /**
+     * Sets the \a value of the field at index \a field for the last added feature, converting it to the
+     * storage type of the field's column. NULL values are ignored.
+     */
+    void setValue( int field, const QVariant &value );
+
+    /**
+     * Sets the geometry of the last added feature, as \a size bytes of WKB \a data.
+     * The geometry can only be set once for each feature.
+     */
+    void setGeometryWkb( const char *data, int size )
+    {
+      mWkb.append( data, size );
+      mWkbOffsets.last() = mWkb.size();
+    }
+
+    /**
+     * Sets the \a geometry of the last added feature.
+     * The geometry can only be set once for each feature.
+     */
+    void setGeometry( const QgsGeometry &geometry );
+
+    /**
+     * Adds a copy of a \a feature to the batch.
+     */
+    void appendFeature( const QgsFeature &feature );
+
+  private:
+
+    struct Column
+    {
+      ColumnType type = VariantColumn;
+      QVariant::Type fieldType = QVariant::Invalid;
+      QVector< bool > nulls;
+      QVector< qint64 > int64Values;
+      QVector< double > doubleValues;
+      //! Offsets of the strings in stringData, with one more entry than there are features
+      QVector< int > stringOffsets;
+      QString stringData;
+      QVector< QVariant > variantValues;
+    };
+
+    QgsFields mFields;
+    std::vector< Column > mColumns;
+    QVector< QgsFeatureId > mIds;
+
+    //! Offsets of the geometries in mWkb, with one more entry than there are features
+    QVector< int > mWkbOffsets = QVector< int >() << 0;
+    QByteArray mWkb;
+};
+
+#endif // QGSFEATUREBATCH_H
@@ -13,6 +13,7 @@
  *                                                                         *
  ***************************************************************************/
 #include "qgsfeatureiterator.h"
+#include "qgsfeaturebatch.h"
 #include "qgslogger.h"
 
 #include "qgssimplifymethod.h"
@@ -71,6 +72,45 @@ bool QgsAbstractFeatureIterator::nextFeature( QgsFeature &f )
   return dataOk;
 }
 
+bool QgsAbstractFeatureIterator::nextBatch( QgsFeatureBatch &batch, int maximumCount )
+{
+  batch.clear();
+  if ( mRequest.limit() >= 0 )
+    maximumCount = static_cast< int >( std::min< long >( maximumCount, mRequest.limit() - mFetchedCount ) );
+  if ( maximumCount <= 0 )
+    return false;
+
+  int fetched = -1;
+  if ( !mUseCachedFeatures && ( mRequest.filterType() == QgsFeatureRequest::FilterNone || mRequest.filterType() == QgsFeatureRequest::FilterExpression ) )
+  {
+    fetched = fetchFeatureBatch( batch, maximumCount );
+    if ( fetched > 0 )
+      mFetchedCount += fetched;
+  }
+
+  if ( fetched < 0 )
+  {
+    fetched = 0;
+    QgsFeature f;
+    while ( fetched < maximumCount && nextFeature( f ) )
+    {
+      if ( fetched == 0 && batch.fields() != f.fields() )
+        batch.setFields( f.fields() );
+      batch.appendFeature( f );
+      fetched++;
+    }
+  }
+
+  return fetched > 0;
+}
+
+int QgsAbstractFeatureIterator::fetchFeatureBatch( QgsFeatureBatch &batch, int maximumCount )
+{
+  Q_UNUSED( batch )
+  Q_UNUSED( maximumCount )
+  return -1;
+}
+
 bool QgsAbstractFeatureIterator::nextFeatureFilterExpression( QgsFeature &f )
 {
   while ( fetchFeature( f ) )
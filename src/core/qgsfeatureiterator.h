@@ -20,6 +20,7 @@
 #include "qgsindexedfeature.h"
 
 class QgsFeedback;
+class QgsFeatureBatch;
 
 /**
  * \ingroup core
@@ -46,6 +47,18 @@ class CORE_EXPORT QgsAbstractFeatureIterator
     //! fetch next feature, return TRUE on success
     virtual bool nextFeature( QgsFeature &f );
 
+    /**
+     * Fetches up to \a maximumCount of the next features into a columnar \a batch, replacing
+     * its previous contents. Returns TRUE if at least one feature was fetched.
+     *
+     * Features are written directly into the batch by iterators which implement fetchFeatureBatch(),
+     * and are otherwise fetched one by one using nextFeature().
+     *
+     * \note not available in Python bindings
+     * \since QGIS 3.18
+     */
+    virtual bool nextBatch( QgsFeatureBatch &batch, int maximumCount ) SIP_SKIP;
+
     //! reset the iterator to the starting position
     virtual bool rewind() = 0;
     //! end of iterating: free the resources / lock
@@ -127,6 +140,24 @@ class CORE_EXPORT QgsAbstractFeatureIterator
      */
     virtual bool nextFeatureFilterFids( QgsFeature &f );
 
+    /**
+     * Fetches up to \a maximumCount features directly into a columnar \a batch, without
+     * constructing intermediate QgsFeature objects. Iterators should call QgsFeatureBatch::setFields()
+     * on the \a batch before adding features to it.
+     *
+     * This is only called for requests which don't need any further filtering by the base class,
+     * i.e. requests without a filter or with a filter expression (in which case the iterator must
+     * return -1 if the expression is not completely handled by the provider).
+     *
+     * Returns the number of features added to the \a batch, or -1 if the request cannot be handled
+     * in this way, in which case features are fetched with fetchFeature() instead. The default
+     * implementation returns -1.
+     *
+     * \note not available in Python bindings
+     * \since QGIS 3.18
+     */
+    virtual int fetchFeatureBatch( QgsFeatureBatch &batch, int maximumCount ) SIP_SKIP;
+
     /**
      * Transforms \a feature's geometry according to the specified coordinate \a transform.
      * If \a feature has no geometry or \a transform is invalid then calling this method
@@ -299,6 +330,19 @@ class CORE_EXPORT QgsFeatureIterator
     QgsFeatureIterator &operator=( const QgsFeatureIterator &other );
 
     bool nextFeature( QgsFeature &f );
+
+    /**
+     * Fetches up to \a maximumCount of the next features into a columnar \a batch, replacing
+     * its previous contents. Returns TRUE if at least one feature was fetched.
+     *
+     * This allows scanning large numbers of features without constructing a QgsFeature
+     * for each of them, see QgsFeatureBatch.
+     *
+     * \note not available in Python bindings
+     * \since QGIS 3.18
+     */
+    bool nextBatch( QgsFeatureBatch &batch, int maximumCount = 1024 ) SIP_SKIP;
+
     bool rewind();
     bool close();
 
@@ -376,6 +420,11 @@ inline bool QgsFeatureIterator::nextFeature( QgsFeature &f )
   return mIter ? mIter->nextFeature( f ) : false;
 }
 
+inline bool QgsFeatureIterator::nextBatch( QgsFeatureBatch &batch, int maximumCount )
+{
+  return mIter ? mIter->nextBatch( batch, maximumCount ) : false;
+}
+
 inline bool QgsFeatureIterator::rewind()
 {
   if ( mIter )
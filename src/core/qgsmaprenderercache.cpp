@@ -14,6 +14,7 @@
  ***************************************************************************/
 
 #include "qgsmaprenderercache.h"
+#include "qgsmaprendererdiskcache.h"
 
 #include "qgsmaplayer.h"
 #include "qgsmaplayerlistutils.h"
@@ -22,6 +23,8 @@
 #include <QImage>
 #include <QPainter>
 #include <algorithm>
+#include <cmath>
+#include <cstring>
 
 QgsMapRendererCache::QgsMapRendererCache()
 {
@@ -39,29 +42,26 @@ void QgsMapRendererCache::clearInternal()
   mExtent.setMinimal();
   mScale = 0;
 
-  // make sure we are disconnected from all layers
-  for ( const QgsWeakMapLayerPointer &layer : qgis::as_const( mConnectedLayers ) )
-  {
-    if ( layer.data() )
-    {
-      disconnect( layer.data(), &QgsMapLayer::repaintRequested, this, &QgsMapRendererCache::layerRequestedRepaint );
-      disconnect( layer.data(), &QgsMapLayer::willBeDeleted, this, &QgsMapRendererCache::layerRequestedRepaint );
-    }
-  }
   mCachedImages.clear();
-  mConnectedLayers.clear();
+  // make sure we are disconnected from all layers, except those with images in the disk cache
+  dropUnusedConnections();
 }
 
 void QgsMapRendererCache::dropUnusedConnections()
 {
   QSet< QgsWeakMapLayerPointer > stillDepends = dependentLayers();
+  for ( const QgsWeakMapLayerPointer &layer : qgis::as_const( mDiskCacheLayers ) )
+  {
+    if ( layer.data() )
+      stillDepends << layer;
+  }
   const QSet< QgsWeakMapLayerPointer > disconnects = mConnectedLayers.subtract( stillDepends );
   for ( const QgsWeakMapLayerPointer &layer : disconnects )
   {
     if ( layer.data() )
     {
       disconnect( layer.data(), &QgsMapLayer::repaintRequested, this, &QgsMapRendererCache::layerRequestedRepaint );
-      disconnect( layer.data(), &QgsMapLayer::willBeDeleted, this, &QgsMapRendererCache::layerRequestedRepaint );
+      disconnect( layer.data(), &QgsMapLayer::willBeDeleted, this, &QgsMapRendererCache::layerWillBeDeleted );
     }
   }
 
@@ -163,9 +163,12 @@ void QgsMapRendererCache::setCacheImageWithParameters( const QString &cacheKey,
       if ( !mConnectedLayers.contains( QgsWeakMapLayerPointer( layer ) ) )
       {
         connect( layer, &QgsMapLayer::repaintRequested, this, &QgsMapRendererCache::layerRequestedRepaint );
-        connect( layer, &QgsMapLayer::willBeDeleted, this, &QgsMapRendererCache::layerRequestedRepaint );
+        connect( layer, &QgsMapLayer::willBeDeleted, this, &QgsMapRendererCache::layerWillBeDeleted );
         mConnectedLayers << layer;
       }
+      // the image may also be stored in the disk cache, which must be invalidated along with it
+      if ( mDiskCache )
+        mDiskCacheLayers << layer;
     }
   }
 
@@ -268,6 +271,59 @@ QImage QgsMapRendererCache::transformedCacheImage( const QString &cacheKey, cons
   }
 }
 
+QImage QgsMapRendererCache::pannedCacheImage( const QString &cacheKey, QRect &validRect ) const
+{
+  validRect = QRect();
+
+  QMutexLocker lock( &mMutex );
+  auto it = mCachedImages.constFind( cacheKey );
+  if ( it == mCachedImages.constEnd() )
+    return QImage();
+
+  const CacheParameters &params = it.value();
+  if ( params.cachedImage.isNull() || params.cachedImage.depth() % 8 != 0 )
+    return QImage();
+
+  if ( params.cachedMtp.mapWidth() != mMtp.mapWidth() || params.cachedMtp.mapHeight() != mMtp.mapHeight()
+       || !qgsDoubleNear( params.cachedMtp.mapRotation(), mMtp.mapRotation() )
+       || !qgsDoubleNear( params.cachedMtp.mapUnitsPerPixel(), mMtp.mapUnitsPerPixel(), mMtp.mapUnitsPerPixel() * 1e-6 ) )
+    return QImage();
+
+  // position of the cached image's origin in the current map, in device pixels
+  const double dpr = params.cachedImage.devicePixelRatio();
+  const QPointF offset = _transform( mMtp, params.cachedMtp.toMapCoordinates( 0.0, 0.0 ), dpr );
+  const int dx = static_cast< int >( std::round( offset.x() ) );
+  const int dy = static_cast< int >( std::round( offset.y() ) );
+
+  // a sub-pixel shift would require resampling the image, which blurs it
+  if ( !qgsDoubleNear( offset.x(), dx, 0.01 ) || !qgsDoubleNear( offset.y(), dy, 0.01 ) )
+    return QImage();
+
+  const QRect imageRect( QPoint( 0, 0 ), params.cachedImage.size() );
+  const QRect overlap = imageRect.intersected( imageRect.translated( dx, dy ) );
+  if ( overlap.isEmpty() )
+    return QImage();
+
+  QImage ret( params.cachedImage.size(), params.cachedImage.format() );
+  ret.setDevicePixelRatio( dpr );
+  ret.setDotsPerMeterX( params.cachedImage.dotsPerMeterX() );
+  ret.setDotsPerMeterY( params.cachedImage.dotsPerMeterY() );
+  ret.fill( Qt::transparent );
+
+  // copy the overlapping scanlines directly, the pixel offset is exact
+  const int bytesPerPixel = params.cachedImage.depth() / 8;
+  const int rowBytes = overlap.width() * bytesPerPixel;
+  for ( int y = overlap.top(); y <= overlap.bottom(); ++y )
+  {
+    const uchar *src = params.cachedImage.constScanLine( y - dy ) + ( overlap.left() - dx ) * bytesPerPixel;
+    uchar *dest = ret.scanLine( y ) + overlap.left() * bytesPerPixel;
+    memcpy( dest, src, rowBytes );
+  }
+
+  validRect = overlap;
+  return ret;
+}
+
 QList< QgsMapLayer * > QgsMapRendererCache::dependentLayers( const QString &cacheKey ) const
 {
   auto it = mCachedImages.constFind( cacheKey );
@@ -285,6 +341,20 @@ void QgsMapRendererCache::layerRequestedRepaint()
   invalidateCacheForLayer( layer );
 }
 
+void QgsMapRendererCache::layerWillBeDeleted()
+{
+  QgsMapLayer *layer = qobject_cast<QgsMapLayer *>( sender() );
+  if ( !layer )
+    return;
+
+  QMutexLocker lock( &mMutex );
+
+  // images in the disk cache stay valid, e.g. for when the layer is loaded again with its project
+  mDiskCacheLayers.remove( QgsWeakMapLayerPointer( layer ) );
+  removeLayerImages( layer );
+  dropUnusedConnections();
+}
+
 void QgsMapRendererCache::invalidateCacheForLayer( QgsMapLayer *layer )
 {
   if ( !layer )
@@ -292,6 +362,17 @@ void QgsMapRendererCache::invalidateCacheForLayer( QgsMapLayer *layer )
 
   QMutexLocker lock( &mMutex );
 
+  removeLayerImages( layer );
+  if ( mDiskCache )
+  {
+    mDiskCache->invalidateLayer( layer->id() );
+    mDiskCacheLayers.remove( QgsWeakMapLayerPointer( layer ) );
+  }
+  dropUnusedConnections();
+}
+
+void QgsMapRendererCache::removeLayerImages( QgsMapLayer *layer )
+{
   // check through all cached images to clear any which depend on this layer
   QMap<QString, CacheParameters>::iterator it = mCachedImages.begin();
   for ( ; it != mCachedImages.end(); )
@@ -304,9 +385,25 @@ void QgsMapRendererCache::invalidateCacheForLayer( QgsMapLayer *layer )
 
     it = mCachedImages.erase( it );
   }
+}
+
+void QgsMapRendererCache::setDiskCache( QgsMapRendererDiskCache *cache )
+{
+  QMutexLocker lock( &mMutex );
+  if ( cache == mDiskCache )
+    return;
+
+  mDiskCache = cache;
+  mDiskCacheLayers.clear();
   dropUnusedConnections();
 }
 
+QgsMapRendererDiskCache *QgsMapRendererCache::diskCache() const
+{
+  QMutexLocker lock( &mMutex );
+  return mDiskCache;
+}
+
 void QgsMapRendererCache::clearCacheImage( const QString &cacheKey )
 {
   QMutexLocker lock( &mMutex );
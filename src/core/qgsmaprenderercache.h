@@ -24,6 +24,7 @@
 #include "qgsrectangle.h"
 #include "qgsmaplayer.h"
 
+class QgsMapRendererDiskCache;
 
 /**
  * \ingroup core
@@ -154,6 +155,23 @@ class CORE_EXPORT QgsMapRendererCache : public QObject
      */
     QImage transformedCacheImage( const QString &cacheKey, const QgsMapToPixel &mtp ) const;
 
+    /**
+     * Returns the cached image for the specified \a cacheKey translated to the current
+     * cache parameters, if the map has only been panned since the image was rendered.
+     *
+     * Reuse is only possible if the cached image was rendered at the same scale, rotation and
+     * size, and the map was moved by a whole number of pixels. Otherwise a null image is returned,
+     * as is the case if the cached image does not overlap the current extent at all.
+     *
+     * The \a validRect argument is set to the area of the returned image (in device pixels) which
+     * is covered by the previous render. The remaining, newly exposed, parts of the image are transparent
+     * and must be rendered by the caller.
+     *
+     * \see transformedCacheImage()
+     * \since QGIS 3.18
+     */
+    QImage pannedCacheImage( const QString &cacheKey, QRect &validRect SIP_OUT ) const;
+
     /**
      * Returns a list of map layers on which an image in the cache depends.
      * \since QGIS 3.0
@@ -169,14 +187,47 @@ class CORE_EXPORT QgsMapRendererCache : public QObject
     /**
      * Invalidates cached images which relate to the specified map \a layer.
      *
+     * Images of the layer in the disk cache are invalidated too.
+     *
+     * \see setDiskCache()
      * \since QGIS 3.14
      */
     void invalidateCacheForLayer( QgsMapLayer *layer );
 
+    /**
+     * Sets a persistent \a cache which is used as a second tier behind this in-memory cache.
+     *
+     * Map renderer jobs will look up layer images in the disk cache when they are not
+     * present in memory, and store freshly rendered layer images in it.
+     *
+     * Ownership of \a cache is not transferred, and it must exist for the lifetime of this
+     * cache (or until another disk cache is set). Set to NULLPTR to disable the disk tier.
+     *
+     * The cache stays connected to the layers of all images passed to setCacheImage() while a disk
+     * cache is set, so that their images in the disk cache are invalidated whenever they request a
+     * repaint, even once their images were cleared from memory.
+     *
+     * \see diskCache()
+     * \since QGIS 3.18
+     */
+    void setDiskCache( QgsMapRendererDiskCache *cache );
+
+    /**
+     * Returns the persistent disk cache used as a second tier behind this cache, or NULLPTR
+     * if no disk cache is set.
+     *
+     * \see setDiskCache()
+     * \since QGIS 3.18
+     */
+    QgsMapRendererDiskCache *diskCache() const;
+
   private slots:
     //! Remove layer (that emitted the signal) from the cache
     void layerRequestedRepaint();
 
+    //! Remove layer (that emitted the signal) from the cache, keeping its images in the disk cache
+    void layerWillBeDeleted();
+
   private:
 
     struct CacheParameters
@@ -193,6 +244,9 @@ class CORE_EXPORT QgsMapRendererCache : public QObject
     //! Disconnects from layers we no longer care about
     void dropUnusedConnections();
 
+    //! Removes the images which depend on a \a layer from memory (without locking)
+    void removeLayerImages( QgsMapLayer *layer );
+
     QSet< QgsWeakMapLayerPointer > dependentLayers() const;
 
     mutable QMutex mMutex;
@@ -205,6 +259,10 @@ class CORE_EXPORT QgsMapRendererCache : public QObject
     QMap<QString, CacheParameters> mCachedImages;
     //! List of all layers on which this cache is currently connected
     QSet< QgsWeakMapLayerPointer > mConnectedLayers;
+
+    QgsMapRendererDiskCache *mDiskCache = nullptr;
+    //! Layers which may have images in the disk cache, and remain connected to invalidate them
+    QSet< QgsWeakMapLayerPointer > mDiskCacheLayers;
 };
 
 
@@ -101,6 +101,7 @@ void QgsMapRendererCustomPainterJob::start()
   {
     mLabelingEngineV2.reset( new QgsDefaultLabelingEngine() );
     mLabelingEngineV2->setMapSettings( mSettings );
+    mLabelingEngineV2->setPreviousResults( previousLabelingResults() );
   }
 
   bool canUseLabelCache = prepareLabelCache();
@@ -308,7 +309,8 @@ void QgsMapRendererCustomPainterJob::doRender()
       QElapsedTimer layerTime;
       layerTime.start();
 
-      if ( job.img )
+      // images of panned renders already hold the reused part of the previous render
+      if ( job.img && !job.partiallyCached )
       {
         job.img->fill( 0 );
         job.imageInitialized = true;
@@ -379,7 +381,8 @@ void QgsMapRendererCustomPainterJob::doRender()
         QElapsedTimer layerTime;
         layerTime.start();
 
-        if ( job.img )
+        // images of panned renders already hold the reused part of the previous render
+        if ( job.img && !job.partiallyCached )
         {
           job.img->fill( 0 );
           job.imageInitialized = true;
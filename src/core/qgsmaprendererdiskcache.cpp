@@ -0,0 +1,624 @@
+/***************************************************************************
+  qgsmaprendererdiskcache.cpp
+  --------------------------------------
+  Date                 : February 2021
+  Copyright            : (C) 2021 by QGIS.org
+  Email                : info at qgis dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsmaprendererdiskcache.h"
+
+#include "qgsmaplayer.h"
+#include "qgsmaplayerstyle.h"
+#include "qgsmaplayertemporalproperties.h"
+#include "qgsmaplayerelevationproperties.h"
+#include "qgsmapsettings.h"
+#include "qgsproviderregistry.h"
+#include "qgsvectorlayer.h"
+#include "qgslogger.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QLockFile>
+#include <QSaveFile>
+#include <QSet>
+#include <QVector>
+#include <QtConcurrentRun>
+#include <memory>
+#include <algorithm>
+
+//! Identifies image and index files written by QgsMapRendererDiskCache ("QRDC")
+static const quint32 DISK_CACHE_MAGIC = 0x51524443;
+static const qint32 DISK_CACHE_VERSION = 1;
+
+//! Size of the header in image files. Pixel data starts at this offset so that it can be memory mapped.
+static const qint64 IMAGE_HEADER_SIZE = 64;
+
+static const QString INDEX_FILE_NAME = QStringLiteral( "index.dat" );
+static const QString INDEX_LOCK_FILE_NAME = QStringLiteral( "index.lock" );
+static const QString IMAGE_FILE_SUFFIX = QStringLiteral( "raw" );
+
+//! Maximum time to wait for another process to release the index, in milliseconds
+static const int INDEX_LOCK_TIMEOUT = 5000;
+
+//! Minimum age of image files missing from the index before they are removed, in milliseconds
+static const qint64 ORPHAN_IMAGE_AGE = 60 * 60 * 1000;
+
+///@cond PRIVATE
+static void deleteMappedImageFile( void *info )
+{
+  // closing the file also unmaps the image data
+  delete static_cast< QFile * >( info );
+}
+///@endcond
+
+QgsMapRendererDiskCache::QgsMapRendererDiskCache( const QString &directory, qint64 maximumSize )
+  : mDirectory( directory )
+  , mMaximumSize( maximumSize )
+{
+  QDir().mkpath( mDirectory );
+  readIndex();
+
+  QMutexLocker locker( &mMutex );
+  const bool oversized = mCurrentSize > mMaximumSize;
+  locker.unlock();
+  if ( oversized )
+  {
+    QMutexLocker writeLocker( &mIndexWriteMutex );
+    writeIndex();
+  }
+}
+
+QgsMapRendererDiskCache::~QgsMapRendererDiskCache()
+{
+  sync();
+
+  QMutexLocker locker( &mMutex );
+  for ( const LayerKey &layerKey : qgis::as_const( mLayerKeys ) )
+  {
+    for ( const QMetaObject::Connection &connection : layerKey.connections )
+      QObject::disconnect( connection );
+  }
+}
+
+QString QgsMapRendererDiskCache::directory() const
+{
+  return mDirectory;
+}
+
+qint64 QgsMapRendererDiskCache::maximumSize() const
+{
+  QMutexLocker locker( &mMutex );
+  return mMaximumSize;
+}
+
+void QgsMapRendererDiskCache::setMaximumSize( qint64 size )
+{
+  QMutexLocker locker( &mMutex );
+  mMaximumSize = size;
+  if ( mCurrentSize > mMaximumSize )
+  {
+    evict( 0 );
+    scheduleIndexWrite();
+  }
+}
+
+qint64 QgsMapRendererDiskCache::currentSize() const
+{
+  QMutexLocker locker( &mMutex );
+  return mCurrentSize;
+}
+
+int QgsMapRendererDiskCache::count() const
+{
+  QMutexLocker locker( &mMutex );
+  return mEntries.count();
+}
+
+bool QgsMapRendererDiskCache::canCacheLayer( QgsMapLayer *layer, const QgsMapSettings &settings )
+{
+  if ( !layer || !layer->isValid() )
+    return false;
+
+  // the layer's content is expected to change
+  if ( layer->hasAutoRefreshEnabled() )
+    return false;
+
+  // the render depends on map properties which are not part of the cache key
+  if ( settings.isTemporal() && layer->temporalProperties() && layer->temporalProperties()->isActive() )
+    return false;
+  if ( !settings.zRange().isInfinite() && layer->elevationProperties() && layer->elevationProperties()->hasElevation() )
+    return false;
+
+  if ( QgsVectorLayer *vl = qobject_cast< QgsVectorLayer * >( layer ) )
+  {
+    if ( vl->isEditable() )
+      return false;
+    if ( settings.testFlag( QgsMapSettings::DrawSelection ) && vl->selectedFeatureCount() > 0 )
+      return false;
+  }
+
+  return true;
+}
+
+QByteArray QgsMapRendererDiskCache::layerHash( QgsMapLayer *layer )
+{
+  QMutexLocker locker( &mMutex );
+  auto it = mLayerKeys.constFind( layer );
+  if ( it != mLayerKeys.constEnd() )
+    return it->hash;
+  locker.unlock();
+
+  QgsMapLayerStyle style;
+  style.readFromLayer( layer );
+
+  QCryptographicHash hash( QCryptographicHash::Sha1 );
+  hash.addData( layer->id().toUtf8() );
+  hash.addData( layer->providerType().toUtf8() );
+  hash.addData( layer->source().toUtf8() );
+  hash.addData( style.xmlData().toUtf8() );
+
+  // local files may be modified outside of QGIS
+  const QVariantMap uriParts = QgsProviderRegistry::instance()->decodeUri( layer->providerType(), layer->source() );
+  const QFileInfo fileInfo( uriParts.value( QStringLiteral( "path" ) ).toString() );
+  if ( fileInfo.isFile() )
+  {
+    hash.addData( QStringLiteral( "%1:%2" ).arg( fileInfo.lastModified().toMSecsSinceEpoch() ).arg( fileInfo.size() ).toUtf8() );
+  }
+
+  // the hash is computed again once the layer's style or data changes, or once it is repainted (e.g. when
+  // its file is modified)
+  LayerKey layerKey;
+  layerKey.hash = hash.result();
+  const auto forget = [this, layer] { forgetLayer( layer ); };
+  layerKey.connections << QObject::connect( layer, &QgsMapLayer::styleChanged, forget )
+                       << QObject::connect( layer, &QgsMapLayer::rendererChanged, forget )
+                       << QObject::connect( layer, &QgsMapLayer::dataSourceChanged, forget )
+                       << QObject::connect( layer, &QgsMapLayer::repaintRequested, forget )
+                       << QObject::connect( layer, &QgsMapLayer::willBeDeleted, forget );
+
+  locker.relock();
+  forgetLayerInternal( layer );
+  mLayerKeys.insert( layer, layerKey );
+  return layerKey.hash;
+}
+
+void QgsMapRendererDiskCache::forgetLayer( QgsMapLayer *layer )
+{
+  QMutexLocker locker( &mMutex );
+  forgetLayerInternal( layer );
+}
+
+void QgsMapRendererDiskCache::forgetLayerInternal( QgsMapLayer *layer )
+{
+  auto it = mLayerKeys.find( layer );
+  if ( it == mLayerKeys.end() )
+    return;
+
+  for ( const QMetaObject::Connection &connection : qgis::as_const( it->connections ) )
+    QObject::disconnect( connection );
+  mLayerKeys.erase( it );
+}
+
+QString QgsMapRendererDiskCache::entryKey( QgsMapLayer *layer, const QgsMapSettings &settings )
+{
+  QCryptographicHash hash( QCryptographicHash::Sha1 );
+  hash.addData( layerHash( layer ) );
+  hash.addData( settings.layerStyleOverrides().value( layer->id() ).toUtf8() );
+
+  const QString renderParameters = QStringLiteral( "%1|%2|%3|%4x%5|%6|%7|%8|%9" )
+                                   .arg( settings.visibleExtent().toString( 17 ) )
+                                   .arg( qgsDoubleToString( settings.mapToPixel().mapUnitsPerPixel(), 17 ) )
+                                   .arg( qgsDoubleToString( settings.rotation() ) )
+                                   .arg( settings.outputSize().width() )
+                                   .arg( settings.outputSize().height() )
+                                   .arg( qgsDoubleToString( settings.devicePixelRatio() ) )
+                                   .arg( qgsDoubleToString( settings.outputDpi() ) )
+                                   .arg( static_cast< int >( settings.flags() ) )
+                                   .arg( static_cast< int >( settings.outputImageFormat() ) );
+  hash.addData( renderParameters.toUtf8() );
+  hash.addData( settings.destinationCrs().toWkt().toUtf8() );
+
+  return QString::fromLatin1( hash.result().toHex() );
+}
+
+bool QgsMapRendererDiskCache::insertImage( QgsMapLayer *layer, const QgsMapSettings &settings, const QImage &image )
+{
+  if ( image.isNull() || !canCacheLayer( layer, settings ) )
+    return false;
+
+  const QString key = entryKey( layer, settings );
+  const qint64 dataSize = static_cast< qint64 >( image.bytesPerLine() ) * image.height();
+  const qint64 fileSize = IMAGE_HEADER_SIZE + dataSize;
+
+  QMutexLocker locker( &mMutex );
+  if ( fileSize > mMaximumSize )
+    return false;
+
+  removeEntry( key );
+  evict( fileSize );
+
+  Entry entry;
+  entry.fileName = QStringLiteral( "%1.%2" ).arg( key, IMAGE_FILE_SUFFIX );
+  entry.layerId = layer->id();
+  entry.size = fileSize;
+  entry.lastAccess = QDateTime::currentMSecsSinceEpoch();
+
+  QSaveFile file( QDir( mDirectory ).filePath( entry.fileName ) );
+  if ( !file.open( QIODevice::WriteOnly ) )
+  {
+    QgsDebugMsg( QStringLiteral( "Could not write map renderer disk cache file %1" ).arg( file.fileName() ) );
+    return false;
+  }
+
+  QDataStream stream( &file );
+  stream.setVersion( QDataStream::Qt_5_9 );
+  stream << DISK_CACHE_MAGIC << DISK_CACHE_VERSION
+         << static_cast< qint32 >( image.width() ) << static_cast< qint32 >( image.height() )
+         << static_cast< qint32 >( image.bytesPerLine() ) << static_cast< qint32 >( image.format() )
+         << static_cast< double >( image.devicePixelRatio() );
+
+  if ( !file.seek( IMAGE_HEADER_SIZE )
+       || file.write( reinterpret_cast< const char * >( image.constBits() ), dataSize ) != dataSize
+       || !file.commit() )
+  {
+    QgsDebugMsg( QStringLiteral( "Could not write map renderer disk cache file %1" ).arg( file.fileName() ) );
+    return false;
+  }
+
+  mEntries.insert( key, entry );
+  mAddedKeys.insert( key );
+  mCurrentSize += fileSize;
+  // the index is written in the background, so that rendering is not held up by repeated writes
+  scheduleIndexWrite();
+  return true;
+}
+
+QImage QgsMapRendererDiskCache::cacheImage( QgsMapLayer *layer, const QgsMapSettings &settings )
+{
+  if ( !canCacheLayer( layer, settings ) )
+    return QImage();
+
+  const QString key = entryKey( layer, settings );
+
+  QMutexLocker locker( &mMutex );
+  auto it = mEntries.find( key );
+  if ( it == mEntries.end() )
+  {
+    mMisses++;
+    return QImage();
+  }
+
+  std::unique_ptr< QFile > file = qgis::make_unique< QFile >( QDir( mDirectory ).filePath( it->fileName ) );
+  if ( !file->open( QIODevice::ReadOnly ) )
+  {
+    removeEntry( key );
+    scheduleIndexWrite();
+    mMisses++;
+    return QImage();
+  }
+
+  quint32 magic = 0;
+  qint32 version = 0;
+  qint32 width = 0;
+  qint32 height = 0;
+  qint32 bytesPerLine = 0;
+  qint32 format = 0;
+  double devicePixelRatio = 1.0;
+  QDataStream stream( file.get() );
+  stream.setVersion( QDataStream::Qt_5_9 );
+  stream >> magic >> version >> width >> height >> bytesPerLine >> format >> devicePixelRatio;
+
+  const qint64 dataSize = static_cast< qint64 >( bytesPerLine ) * height;
+  if ( stream.status() != QDataStream::Ok || magic != DISK_CACHE_MAGIC || version != DISK_CACHE_VERSION
+       || width <= 0 || height <= 0 || file->size() < IMAGE_HEADER_SIZE + dataSize )
+  {
+    QgsDebugMsg( QStringLiteral( "Invalid map renderer disk cache file %1" ).arg( file->fileName() ) );
+    file.reset();
+    removeEntry( key );
+    scheduleIndexWrite();
+    mMisses++;
+    return QImage();
+  }
+
+  QImage image;
+  if ( uchar *data = file->map( IMAGE_HEADER_SIZE, dataSize ) )
+  {
+    // the image keeps the file (and therefore the mapping) alive until it is destroyed
+    image = QImage( const_cast< const uchar * >( data ), width, height, bytesPerLine, static_cast< QImage::Format >( format ),
+                    deleteMappedImageFile, file.release() );
+  }
+  else
+  {
+    // mapping is not supported by the file system, fall back to reading the data
+    image = QImage( width, height, static_cast< QImage::Format >( format ) );
+    file->seek( IMAGE_HEADER_SIZE );
+    for ( int y = 0; y < height; ++y )
+    {
+      file->read( reinterpret_cast< char * >( image.scanLine( y ) ), bytesPerLine );
+    }
+  }
+  image.setDevicePixelRatio( devicePixelRatio );
+
+  it->lastAccess = QDateTime::currentMSecsSinceEpoch();
+  mHits++;
+  return image;
+}
+
+void QgsMapRendererDiskCache::invalidateLayer( const QString &layerId )
+{
+  QMutexLocker locker( &mMutex );
+
+  QStringList keys;
+  for ( auto it = mEntries.constBegin(); it != mEntries.constEnd(); ++it )
+  {
+    if ( it->layerId == layerId )
+      keys << it.key();
+  }
+  if ( keys.isEmpty() )
+    return;
+
+  for ( const QString &key : qgis::as_const( keys ) )
+    removeEntry( key );
+  scheduleIndexWrite();
+}
+
+void QgsMapRendererDiskCache::clear()
+{
+  QMutexLocker locker( &mMutex );
+
+  const QStringList keys = mEntries.keys();
+  for ( const QString &key : keys )
+    removeEntry( key );
+  scheduleIndexWrite();
+}
+
+void QgsMapRendererDiskCache::sync()
+{
+  QMutexLocker locker( &mMutex );
+  QFuture< void > pendingWrite = mIndexWrite;
+  locker.unlock();
+
+  // any earlier background write finishes before the last scheduled one starts
+  pendingWrite.waitForFinished();
+
+  QMutexLocker writeLocker( &mIndexWriteMutex );
+  locker.relock();
+  mIndexDirty = false;
+  locker.unlock();
+  writeIndex();
+}
+
+qint64 QgsMapRendererDiskCache::hits() const
+{
+  QMutexLocker locker( &mMutex );
+  return mHits;
+}
+
+qint64 QgsMapRendererDiskCache::misses() const
+{
+  QMutexLocker locker( &mMutex );
+  return mMisses;
+}
+
+void QgsMapRendererDiskCache::resetStatistics()
+{
+  QMutexLocker locker( &mMutex );
+  mHits = 0;
+  mMisses = 0;
+}
+
+QHash< QString, QgsMapRendererDiskCache::Entry > QgsMapRendererDiskCache::readIndexFile() const
+{
+  QHash< QString, Entry > entries;
+
+  const QDir dir( mDirectory );
+  QFile file( dir.filePath( INDEX_FILE_NAME ) );
+  if ( !file.open( QIODevice::ReadOnly ) )
+    return entries;
+
+  QDataStream stream( &file );
+  stream.setVersion( QDataStream::Qt_5_9 );
+
+  quint32 magic = 0;
+  qint32 version = 0;
+  qint32 count = 0;
+  stream >> magic >> version >> count;
+  if ( magic != DISK_CACHE_MAGIC || version != DISK_CACHE_VERSION )
+    return entries;
+
+  for ( int i = 0; i < count && stream.status() == QDataStream::Ok; ++i )
+  {
+    QString key;
+    Entry entry;
+    stream >> key >> entry.fileName >> entry.layerId >> entry.size >> entry.lastAccess;
+    if ( stream.status() != QDataStream::Ok )
+      break;
+
+    const QFileInfo imageInfo( dir.filePath( entry.fileName ) );
+    if ( !imageInfo.isFile() || imageInfo.size() != entry.size )
+      continue;
+
+    entries.insert( key, entry );
+  }
+  return entries;
+}
+
+void QgsMapRendererDiskCache::readIndex()
+{
+  // other processes sharing the directory must not write the index while it is read
+  const QDir dir( mDirectory );
+  QLockFile lock( dir.filePath( INDEX_LOCK_FILE_NAME ) );
+  if ( !lock.tryLock( INDEX_LOCK_TIMEOUT ) )
+  {
+    QgsDebugMsg( QStringLiteral( "Could not lock map renderer disk cache index in %1" ).arg( mDirectory ) );
+    return;
+  }
+
+  QMutexLocker locker( &mMutex );
+  mEntries = readIndexFile();
+  for ( const Entry &entry : qgis::as_const( mEntries ) )
+    mCurrentSize += entry.size;
+
+  // remove image files which are no longer referenced by the index. Images which were recently written may
+  // belong to another process sharing the directory, which did not write its index yet.
+  QSet< QString > indexedFiles;
+  for ( const Entry &entry : qgis::as_const( mEntries ) )
+    indexedFiles.insert( entry.fileName );
+
+  const qint64 now = QDateTime::currentMSecsSinceEpoch();
+  const QFileInfoList imageFiles = dir.entryInfoList( QStringList() << QStringLiteral( "*.%1" ).arg( IMAGE_FILE_SUFFIX ), QDir::Files );
+  for ( const QFileInfo &imageFile : imageFiles )
+  {
+    if ( !indexedFiles.contains( imageFile.fileName() ) && now - imageFile.lastModified().toMSecsSinceEpoch() > ORPHAN_IMAGE_AGE )
+      QFile::remove( imageFile.filePath() );
+  }
+}
+
+void QgsMapRendererDiskCache::scheduleIndexWrite()
+{
+  mIndexDirty = true;
+  if ( mIndexWritePending )
+    return;
+
+  mIndexWritePending = true;
+  mIndexWrite = QtConcurrent::run( [this] { writePendingIndex(); } );
+}
+
+void QgsMapRendererDiskCache::writePendingIndex()
+{
+  QMutexLocker writeLocker( &mIndexWriteMutex );
+
+  QMutexLocker locker( &mMutex );
+  mIndexWritePending = false;
+  if ( !mIndexDirty )
+    return;
+
+  mIndexDirty = false;
+  locker.unlock();
+
+  writeIndex();
+}
+
+void QgsMapRendererDiskCache::writeIndex()
+{
+  const QDir dir( mDirectory );
+  QLockFile lock( dir.filePath( INDEX_LOCK_FILE_NAME ) );
+  if ( !lock.tryLock( INDEX_LOCK_TIMEOUT ) )
+  {
+    QgsDebugMsg( QStringLiteral( "Could not lock map renderer disk cache index in %1" ).arg( mDirectory ) );
+    QMutexLocker locker( &mMutex );
+    mIndexDirty = true;
+    return;
+  }
+
+  // other processes sharing the directory may have changed the index since it was last read
+  const QHash< QString, Entry > diskEntries = readIndexFile();
+
+  QMutexLocker locker( &mMutex );
+  mergeIndex( diskEntries );
+  const QHash< QString, Entry > entries = mEntries;
+  locker.unlock();
+
+  QSaveFile file( dir.filePath( INDEX_FILE_NAME ) );
+  if ( !file.open( QIODevice::WriteOnly ) )
+  {
+    QgsDebugMsg( QStringLiteral( "Could not write map renderer disk cache index %1" ).arg( file.fileName() ) );
+    return;
+  }
+
+  QDataStream stream( &file );
+  stream.setVersion( QDataStream::Qt_5_9 );
+  stream << DISK_CACHE_MAGIC << DISK_CACHE_VERSION << static_cast< qint32 >( entries.count() );
+  for ( auto it = entries.constBegin(); it != entries.constEnd(); ++it )
+  {
+    stream << it.key() << it->fileName << it->layerId << it->size << it->lastAccess;
+  }
+  file.commit();
+}
+
+void QgsMapRendererDiskCache::mergeIndex( const QHash< QString, Entry > &diskEntries )
+{
+  // entries which were indexed on disk, but which were since removed by another process
+  for ( auto it = mEntries.begin(); it != mEntries.end(); )
+  {
+    if ( !diskEntries.contains( it.key() ) && !mAddedKeys.contains( it.key() ) )
+    {
+      mCurrentSize -= it->size;
+      it = mEntries.erase( it );
+    }
+    else
+    {
+      ++it;
+    }
+  }
+
+  // entries added by other processes, unless they were removed by this one
+  for ( auto it = diskEntries.constBegin(); it != diskEntries.constEnd(); ++it )
+  {
+    if ( mRemovedKeys.contains( it.key() ) )
+      continue;
+
+    auto entryIt = mEntries.find( it.key() );
+    if ( entryIt != mEntries.end() )
+    {
+      entryIt->lastAccess = std::max( entryIt->lastAccess, it->lastAccess );
+    }
+    else
+    {
+      mEntries.insert( it.key(), it.value() );
+      mCurrentSize += it->size;
+    }
+  }
+
+  // removals by eviction are written along with the merged entries
+  mAddedKeys.clear();
+  evict( 0 );
+  mRemovedKeys.clear();
+}
+
+void QgsMapRendererDiskCache::evict( qint64 requiredSpace )
+{
+  if ( mCurrentSize + requiredSpace <= mMaximumSize )
+    return;
+
+  QVector< QPair< qint64, QString > > entriesByAccess;
+  entriesByAccess.reserve( mEntries.count() );
+  for ( auto it = mEntries.constBegin(); it != mEntries.constEnd(); ++it )
+    entriesByAccess << qMakePair( it->lastAccess, it.key() );
+  std::sort( entriesByAccess.begin(), entriesByAccess.end() );
+
+  for ( const QPair< qint64, QString > &entry : qgis::as_const( entriesByAccess ) )
+  {
+    if ( mCurrentSize + requiredSpace <= mMaximumSize )
+      break;
+
+    removeEntry( entry.second );
+  }
+}
+
+void QgsMapRendererDiskCache::removeEntry( const QString &key )
+{
+  auto it = mEntries.find( key );
+  if ( it == mEntries.end() )
+    return;
+
+  // may fail on some platforms while the image is still mapped, in which case the
+  // file is removed when the index is next read
+  QFile::remove( QDir( mDirectory ).filePath( it->fileName ) );
+  mCurrentSize -= it->size;
+  mAddedKeys.remove( key );
+  mRemovedKeys.insert( key );
+  mEntries.erase( it );
+}
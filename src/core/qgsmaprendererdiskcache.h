@@ -0,0 +1,257 @@
+/***************************************************************************
+  qgsmaprendererdiskcache.h
+  --------------------------------------
+  Date                 : February 2021
+  Copyright            : (C) 2021 by QGIS.org
+  Email                : info at qgis dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSMAPRENDERERDISKCACHE_H
+#define QGSMAPRENDERERDISKCACHE_H
+
+#include "qgis_core.h"
+#include "qgis_sip.h"
+
+#include <QFuture>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QString>
+
+class QgsMapLayer;
+class QgsMapSettings;
+
+/**
+ * \ingroup core
+ * Persistent, size bounded cache of rendered map layer images, stored on disk.
+ *
+ * The disk cache acts as a second tier behind the in-memory QgsMapRendererCache: images
+ * of layers which are not found in memory are looked up on disk before the layer gets rendered,
+ * and freshly rendered layer images are written to disk. This allows the reuse of renders of
+ * static layers (e.g. basemaps) when returning to a previously visited view, and across
+ * application restarts.
+ *
+ * Images are keyed by the layer ID, a hash of the layer's source and style, and the
+ * parameters of the map render (extent, scale, rotation, output size, DPI and destination CRS).
+ * Images are stored as raw pixel data, which is memory mapped when the image is read back.
+ * An index file in the cache directory keeps track of the cached images, and the least recently
+ * used images are removed when the cache grows beyond its maximum size.
+ *
+ * Changes to the data of a layer cannot be detected for all data sources (e.g. tables in a
+ * remote database), so invalidateLayer() should be called when a layer's data is known to
+ * have changed. The modification time of local files is only checked again once a layer
+ * is repainted, or its style or data source changes.
+ *
+ * Several processes can share the same cache directory: the index is locked while it is
+ * read or written, and the changes of the other processes are merged into it.
+ *
+ * The class is thread-safe (multiple classes can access the same instance safely).
+ *
+ * \see QgsMapRendererCache::setDiskCache()
+ * \since QGIS 3.18
+ */
+class CORE_EXPORT QgsMapRendererDiskCache
+{
+  public:
+
+    /**
+     * Constructor for QgsMapRendererDiskCache, storing images in the specified \a directory
+     * and using at most \a maximumSize bytes of disk space.
+     *
+     * Any existing cache index in the \a directory is read, so that images cached by a
+     * previous instance can be reused.
+     */
+    QgsMapRendererDiskCache( const QString &directory, qint64 maximumSize = 256 * 1024 * 1024 );
+
+    ~QgsMapRendererDiskCache();
+
+    //! QgsMapRendererDiskCache cannot be copied
+    QgsMapRendererDiskCache( const QgsMapRendererDiskCache &other ) = delete;
+    //! QgsMapRendererDiskCache cannot be copied
+    QgsMapRendererDiskCache &operator=( const QgsMapRendererDiskCache &other ) = delete;
+
+    /**
+     * Returns the directory in which images are cached.
+     */
+    QString directory() const;
+
+    /**
+     * Returns the maximum size of the cache, in bytes.
+     * \see setMaximumSize()
+     */
+    qint64 maximumSize() const;
+
+    /**
+     * Sets the maximum \a size of the cache, in bytes. Least recently used images are removed
+     * if the cache is currently larger.
+     * \see maximumSize()
+     */
+    void setMaximumSize( qint64 size );
+
+    /**
+     * Returns the total size of all images currently in the cache, in bytes.
+     */
+    qint64 currentSize() const;
+
+    /**
+     * Returns the number of images in the cache.
+     */
+    int count() const;
+
+    /**
+     * Returns TRUE if renders of the specified \a layer with the map \a settings can
+     * be stored in the disk cache.
+     *
+     * Layers which are being edited, automatically refreshed, or whose rendering depends on
+     * the map's temporal or elevation range are never cached on disk.
+     */
+    static bool canCacheLayer( QgsMapLayer *layer, const QgsMapSettings &settings );
+
+    /**
+     * Stores the rendered \a image of a \a layer, which was rendered with the map \a settings.
+     *
+     * Returns TRUE if the image was successfully written to the cache.
+     *
+     * \note This method must be called from the thread which owns the \a layer.
+     */
+    bool insertImage( QgsMapLayer *layer, const QgsMapSettings &settings, const QImage &image );
+
+    /**
+     * Returns the cached image of the \a layer, rendered with the map \a settings.
+     * A null image is returned if no matching image is cached.
+     *
+     * The returned image is read-only and backed by a memory mapped file.
+     *
+     * \note This method must be called from the thread which owns the \a layer.
+     */
+    QImage cacheImage( QgsMapLayer *layer, const QgsMapSettings &settings );
+
+    /**
+     * Removes all cached images of the layer with matching \a layerId.
+     */
+    void invalidateLayer( const QString &layerId );
+
+    /**
+     * Removes all images from the cache.
+     */
+    void clear();
+
+    /**
+     * Writes the cache index to disk. This is done automatically in a background thread when
+     * images are added or removed, but the last access times of images are only written by
+     * this method (or when the cache is destroyed).
+     */
+    void sync();
+
+    /**
+     * Returns the number of successful image lookups since the cache was created
+     * or the statistics were reset.
+     * \see misses()
+     * \see resetStatistics()
+     */
+    qint64 hits() const;
+
+    /**
+     * Returns the number of failed image lookups since the cache was created
+     * or the statistics were reset.
+     * \see hits()
+     * \see resetStatistics()
+     */
+    qint64 misses() const;
+
+    /**
+     * Resets the hit and miss counters.
+     * \see hits()
+     * \see misses()
+     */
+    void resetStatistics();
+
+  private:
+#ifdef SIP_RUN
+    QgsMapRendererDiskCache( const QgsMapRendererDiskCache &other );
+#endif
+
+    struct Entry
+    {
+      QString fileName;
+      QString layerId;
+      qint64 size = 0;
+      qint64 lastAccess = 0;
+    };
+
+    //! Hash of the source and style of a layer, and its connections to the signals which invalidate it
+    struct LayerKey
+    {
+      QByteArray hash;
+      QList< QMetaObject::Connection > connections;
+    };
+
+    //! Returns the key identifying a render of a layer
+    QString entryKey( QgsMapLayer *layer, const QgsMapSettings &settings );
+    //! Returns the hash of the source and style of a \a layer, computed once until the layer changes
+    QByteArray layerHash( QgsMapLayer *layer );
+    //! Forgets the hash of a \a layer
+    void forgetLayer( QgsMapLayer *layer );
+    //! Forgets the hash of a \a layer (without locking)
+    void forgetLayerInternal( QgsMapLayer *layer );
+
+    //! Reads the index, and removes image files which are not indexed
+    void readIndex();
+    //! Returns the entries of the index file, without locking the directory
+    QHash< QString, Entry > readIndexFile() const;
+
+    /**
+     * Merges the index of the directory, which may have been changed by other processes,
+     * and writes it to disk (without locking the mutex, but holding the index write mutex).
+     */
+    void writeIndex();
+    //! Merges entries read from the index on disk into the entries (without locking)
+    void mergeIndex( const QHash< QString, Entry > &diskEntries );
+
+    /**
+     * Schedules a write of the index in a background thread (without locking). Changes made
+     * before the write starts are written together.
+     */
+    void scheduleIndexWrite();
+    //! Writes the index if it changed since the last write
+    void writePendingIndex();
+
+    //! Removes least recently used entries until \a requiredSpace additional bytes fit in the cache (without locking)
+    void evict( qint64 requiredSpace );
+    //! Removes an entry and its image file (without locking)
+    void removeEntry( const QString &key );
+
+    mutable QMutex mMutex;
+    QString mDirectory;
+    qint64 mMaximumSize = 0;
+    qint64 mCurrentSize = 0;
+    QHash< QString, Entry > mEntries;
+    //! Keys of the entries added since the index was last written
+    QSet< QString > mAddedKeys;
+    //! Keys of the entries removed since the index was last written
+    QSet< QString > mRemovedKeys;
+    QHash< QgsMapLayer *, LayerKey > mLayerKeys;
+
+    //! Serializes writes of the index
+    QMutex mIndexWriteMutex;
+    //! TRUE if the index changed since it was last written
+    bool mIndexDirty = false;
+    //! TRUE if a background write of the index is scheduled but did not start yet
+    bool mIndexWritePending = false;
+    //! The last scheduled background write of the index
+    QFuture< void > mIndexWrite;
+
+    qint64 mHits = 0;
+    qint64 mMisses = 0;
+};
+
+#endif // QGSMAPRENDERERDISKCACHE_H
@@ -27,6 +27,7 @@
 #include "qgsmaplayerrenderer.h"
 #include "qgsmaplayerstylemanager.h"
 #include "qgsmaprenderercache.h"
+#include "qgsmaprendererdiskcache.h"
 #include "qgsmessagelog.h"
 #include "qgspallabeling.h"
 #include "qgsexception.h"
@@ -37,6 +38,7 @@
 #include "qgsexpressioncontextutils.h"
 #include "qgssymbol.h"
 #include "qgsrenderer.h"
+#include "qgspainteffect.h"
 #include "qgssymbollayer.h"
 #include "qgsvectorlayerutils.h"
 #include "qgssymbollayerutils.h"
@@ -44,6 +46,9 @@
 #include "qgsmaplayerelevationproperties.h"
 #include "qgsvectorlayerrenderer.h"
 
+//! Margin (in pixels) by which the feature request extents of the newly exposed parts of a panned map are grown
+static const int PANNED_RENDER_EXTENT_MARGIN_PIXELS = 64;
+
 ///@cond PRIVATE
 
 const QString QgsMapRendererJob::LABEL_CACHE_ID = QStringLiteral( "_labels_" );
@@ -306,15 +311,92 @@ QPainter *QgsMapRendererJob::allocateImageAndPainter( QString layerId, QImage *&
   image = allocateImage( layerId );
   if ( image )
   {
-    painter = new QPainter( image );
-    painter->setRenderHint( QPainter::Antialiasing, mSettings.testFlag( QgsMapSettings::Antialiasing ) );
+    painter = createImagePainter( image );
+  }
+  return painter;
+}
+
+QPainter *QgsMapRendererJob::createImagePainter( QImage *image ) const
+{
+  QPainter *painter = new QPainter( image );
+  painter->setRenderHint( QPainter::Antialiasing, mSettings.testFlag( QgsMapSettings::Antialiasing ) );
 #if QT_VERSION >= QT_VERSION_CHECK(5, 13, 0)
-    painter->setRenderHint( QPainter::LosslessImageRendering, mSettings.testFlag( QgsMapSettings::LosslessImageRendering ) );
+  painter->setRenderHint( QPainter::LosslessImageRendering, mSettings.testFlag( QgsMapSettings::LosslessImageRendering ) );
 #endif
-  }
   return painter;
 }
 
+bool QgsMapRendererJob::preparePannedRender( LayerRenderJob &job )
+{
+  QgsVectorLayer *vl = qobject_cast< QgsVectorLayer * >( job.layer );
+  QgsVectorLayerRenderer *renderer = dynamic_cast< QgsVectorLayerRenderer * >( job.renderer );
+  if ( !vl || !renderer || !vl->renderer() )
+    return false;
+
+  // labels and diagrams would be registered once for every rendered part
+  if ( job.context.labelingEngine() && QgsPalLabeling::staticWillUseLayer( vl ) )
+    return false;
+
+  // paint effects are applied to the rendered layer as a whole, so they would show seams between the parts
+  if ( vl->renderer()->paintEffect() && vl->renderer()->paintEffect()->enabled() )
+    return false;
+
+  if ( !qgsDoubleNear( mSettings.rotation(), 0.0 ) || job.context.testFlag( QgsRenderContext::ApplyClipAfterReprojection ) )
+    return false;
+
+  QRect validRect;
+  const QImage pannedImage = mCache->pannedCacheImage( job.layerId, validRect );
+  const QSize deviceSize = mSettings.deviceOutputSize();
+  if ( pannedImage.isNull() || pannedImage.size() != deviceSize || pannedImage.format() != mSettings.outputImageFormat() )
+    return false;
+
+  // newly exposed strips, in device pixels: full width strips above and below the reused area,
+  // and strips to the left and right of it
+  QList< QRect > strips;
+  if ( validRect.top() > 0 )
+    strips << QRect( 0, 0, deviceSize.width(), validRect.top() );
+  if ( validRect.bottom() < deviceSize.height() - 1 )
+    strips << QRect( 0, validRect.bottom() + 1, deviceSize.width(), deviceSize.height() - 1 - validRect.bottom() );
+  if ( validRect.left() > 0 )
+    strips << QRect( 0, validRect.top(), validRect.left(), validRect.height() );
+  if ( validRect.right() < deviceSize.width() - 1 )
+    strips << QRect( validRect.right() + 1, validRect.top(), deviceSize.width() - 1 - validRect.right(), validRect.height() );
+
+  const double dpr = mSettings.devicePixelRatio();
+  const double mapUnitsPerPixel = mSettings.mapUnitsPerPixel();
+  const QgsRectangle visibleExtent = mSettings.visibleExtent();
+  // features just outside of a strip may have symbols reaching into it
+  const double margin = mSettings.extentBuffer() + PANNED_RENDER_EXTENT_MARGIN_PIXELS * mapUnitsPerPixel;
+  const QgsCoordinateTransform ct = job.context.coordinateTransform();
+
+  QList< QgsRectangle > extents;
+  QList< QRectF > clipRects;
+  for ( const QRect &strip : qgis::as_const( strips ) )
+  {
+    QgsRectangle extent( visibleExtent.xMinimum() + strip.left() / dpr * mapUnitsPerPixel,
+                         visibleExtent.yMaximum() - ( strip.bottom() + 1 ) / dpr * mapUnitsPerPixel,
+                         visibleExtent.xMinimum() + ( strip.right() + 1 ) / dpr * mapUnitsPerPixel,
+                         visibleExtent.yMaximum() - strip.top() / dpr * mapUnitsPerPixel );
+    extent.grow( margin );
+    if ( ct.isValid() )
+    {
+      QgsRectangle r2;
+      if ( !reprojectToLayerExtent( job.layer, ct, extent, r2 ) || !extent.isFinite() )
+        return false;
+    }
+
+    extents << extent;
+    clipRects << QRectF( strip.left() / dpr, strip.top() / dpr, strip.width() / dpr, strip.height() / dpr );
+  }
+
+  job.img = new QImage( pannedImage );
+  job.imageInitialized = true;
+  job.partiallyCached = true;
+  job.context.setPainter( createImagePainter( job.img ) );
+  renderer->setPartialRenderRegions( extents, clipRects );
+  return true;
+}
+
 LayerRenderJobs QgsMapRendererJob::prepareJobs( QPainter *painter, QgsLabelingEngine *labelingEngine2, bool deferredPainterSet )
 {
   LayerRenderJobs layerJobs;
@@ -332,6 +414,22 @@ LayerRenderJobs QgsMapRendererJob::prepareJobs( QPainter *painter, QgsLabelingEn
 
   bool requiresLabelRedraw = !( mCache && mCache->hasCacheImage( LABEL_CACHE_ID ) );
 
+  // layers taking part in selective masking are rendered again in a second pass, which always covers the whole map
+  bool canReusePannedImages = mCache;
+  if ( canReusePannedImages )
+  {
+    const QList< QgsMapLayer * > layers = mSettings.layers();
+    for ( QgsMapLayer *ml : layers )
+    {
+      QgsVectorLayer *vl = qobject_cast< QgsVectorLayer * >( ml );
+      if ( vl && ( !QgsVectorLayerUtils::labelMasks( vl ).isEmpty() || !QgsVectorLayerUtils::symbolLayerMasks( vl ).isEmpty() ) )
+      {
+        canReusePannedImages = false;
+        break;
+      }
+    }
+  }
+
   while ( li.hasPrevious() )
   {
     QgsMapLayer *ml = li.previous();
@@ -390,9 +488,9 @@ LayerRenderJobs QgsMapRendererJob::prepareJobs( QPainter *painter, QgsLabelingEn
 
     // Force render of layers that are being edited
     // or if there's a labeling engine that needs the layer to register features
+    const bool requiresLabeling = mCache && ( labelingEngine2 && QgsPalLabeling::staticWillUseLayer( ml ) ) && requiresLabelRedraw;
     if ( mCache )
     {
-      const bool requiresLabeling = ( labelingEngine2 && QgsPalLabeling::staticWillUseLayer( ml ) ) && requiresLabelRedraw;
       if ( ( vl && vl->isEditable() ) || requiresLabeling )
       {
         mCache->clearCacheImage( ml->id() );
@@ -430,6 +528,16 @@ LayerRenderJobs QgsMapRendererJob::prepareJobs( QPainter *painter, QgsLabelingEn
     // apply default opacity handling here!
     job.opacity = ml->type() != QgsMapLayerType::RasterLayer ? ml->opacity() : 1.0;
 
+    // look for a render of the layer in the persistent cache, if it's not in memory
+    if ( mCache && mCache->diskCache() && !mCache->hasCacheImage( ml->id() ) && !( vl && vl->isEditable() ) && !requiresLabeling )
+    {
+      const QImage diskImage = mCache->diskCache()->cacheImage( ml, mSettings );
+      if ( !diskImage.isNull() && diskImage.size() == mSettings.deviceOutputSize() )
+      {
+        mCache->setCacheImageWithParameters( ml->id(), diskImage, mSettings.visibleExtent(), mSettings.mapToPixel(), QList< QgsMapLayer * >() << ml );
+      }
+    }
+
     // if we can use the cache, let's do it and avoid rendering!
     if ( mCache && mCache->hasCacheImage( ml->id() ) )
     {
@@ -448,10 +556,13 @@ LayerRenderJobs QgsMapRendererJob::prepareJobs( QPainter *painter, QgsLabelingEn
     if ( job.renderer )
       job.renderer->setLayerRenderingTimeHint( job.estimatedRenderingTime );
 
+    // after a map pan, reuse the overlapping part of the previous render and only draw the newly exposed parts
+    const bool pannedRender = canReusePannedImages && preparePannedRender( job );
+
     // If we are drawing with an alternative blending mode then we need to render to a separate image
     // before compositing this on the map. This effectively flattens the layer and prevents
     // blending occurring between objects on the layer
-    if ( mCache || ( !painter && !deferredPainterSet ) || ( job.renderer && job.renderer->forceRasterRender() ) )
+    if ( !pannedRender && ( mCache || ( !painter && !deferredPainterSet ) || ( job.renderer && job.renderer->forceRasterRender() ) ) )
     {
       // Flattened image for drawing when a blending mode is set
       job.context.setPainter( allocateImageAndPainter( ml->id(), job.img ) );
@@ -687,6 +798,11 @@ void QgsMapRendererJob::cleanupJobs( LayerRenderJobs &jobs )
         QgsDebugMsgLevel( QStringLiteral( "caching image for %1" ).arg( job.layerId ), 2 );
         mCache->setCacheImageWithParameters( job.layerId, *job.img, mSettings.visibleExtent(), mSettings.mapToPixel(), QList< QgsMapLayer * >() << job.layer );
         mCache->setCacheImageWithParameters( job.layerId + QStringLiteral( "_preview" ), *job.img, mSettings.visibleExtent(), mSettings.mapToPixel(), QList< QgsMapLayer * >() << job.layer );
+
+        if ( QgsMapRendererDiskCache *diskCache = mCache->diskCache() )
+        {
+          diskCache->insertImage( job.layer, mSettings, *job.img );
+        }
       }
 
       delete job.img;
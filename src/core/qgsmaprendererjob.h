@@ -64,6 +64,15 @@ struct LayerRenderJob
   double opacity;
   //! If TRUE, img already contains cached image from previous rendering
   bool cached;
+
+  /**
+   * TRUE if img was initialized with the translated image of a previous render of the
+   * layer, and only the newly exposed parts of the map need to be rendered.
+   *
+   * \since QGIS 3.18
+   */
+  bool partiallyCached = false;
+
   QgsWeakMapLayerPointer layer;
 
   /**
@@ -130,6 +139,25 @@ struct LayerRenderJob
    * In this latter case, the second element of the QPair gives the label mask id.
    */
   QList<QPair<LayerRenderJob *, int>> maskJobs;
+
+  /**
+   * Pointer to the layer job which this job renders a spatial tile of.
+   *
+   * Set when a layer is split into several horizontal tiles which are rendered in parallel
+   * (see QgsMapSettings::RenderLayerTilesInParallel). The tile image is composed into the
+   * image of the parent job once all tiles have finished rendering.
+   *
+   * \since QGIS 3.18
+   */
+  LayerRenderJob *tileParentJob = nullptr;
+
+  /**
+   * Vertical offset of the tile image within the parent job's image, in device pixels.
+   * Only used for tile jobs.
+   *
+   * \since QGIS 3.18
+   */
+  int tileOffset = 0;
 };
 
 typedef QList<LayerRenderJob> LayerRenderJobs;
@@ -272,6 +300,24 @@ class CORE_EXPORT QgsMapRendererJob : public QObject
      */
     const QgsFeatureFilterProvider *featureFilterProvider() const { return mFeatureFilterProvider; }
 
+    /**
+     * Sets the labeling \a results from the previous render of the map. If the
+     * QgsLabelingEngineSettings::UsePreviousPlacements flag is set, labels from these results
+     * which remain fully visible will keep their placement.
+     *
+     * Ownership is not transferred and the results must not be deleted before the job is started.
+     * \see previousLabelingResults()
+     * \since QGIS 3.18
+     */
+    void setPreviousLabelingResults( const QgsLabelingResults *results ) { mPreviousLabelingResults = results; }
+
+    /**
+     * Returns the labeling results from the previous render of the map.
+     * \see setPreviousLabelingResults()
+     * \since QGIS 3.18
+     */
+    const QgsLabelingResults *previousLabelingResults() const { return mPreviousLabelingResults; }
+
     struct Error
     {
       Error( const QString &lid, const QString &msg )
@@ -461,8 +507,6 @@ class CORE_EXPORT QgsMapRendererJob : public QObject
     //! \note not available in Python bindings
     static void drawLabeling( QgsRenderContext &renderContext, QgsLabelingEngine *labelingEngine2, QPainter *painter ) SIP_SKIP;
 
-  private:
-
     /**
      * Convenience function to project an extent into the layer source
      * CRS, but also split it into two extents if it crosses
@@ -473,16 +517,32 @@ class CORE_EXPORT QgsMapRendererJob : public QObject
      * If FALSE is returned then the extent could not be accurately
      * transformed to the layer's CRS, and a "full globe" extent
      * was used instead.
+     *
+     * \note not available in Python bindings
      */
-    static bool reprojectToLayerExtent( const QgsMapLayer *ml, const QgsCoordinateTransform &ct, QgsRectangle &extent, QgsRectangle &r2 );
+    static bool reprojectToLayerExtent( const QgsMapLayer *ml, const QgsCoordinateTransform &ct, QgsRectangle &extent, QgsRectangle &r2 ) SIP_SKIP;
+
+  private:
 
     const QgsFeatureFilterProvider *mFeatureFilterProvider = nullptr;
 
+    const QgsLabelingResults *mPreviousLabelingResults = nullptr;
+
     //! Convenient method to allocate a new image and stack an error if not enough memory is available
     QImage *allocateImage( QString layerId );
 
     //! Convenient method to allocate a new image and a new QPainter on this image
     QPainter *allocateImageAndPainter( QString layerId, QImage *&image );
+
+    //! Creates a new QPainter on an \a image, using the render hints from the map settings
+    QPainter *createImagePainter( QImage *image ) const;
+
+    /**
+     * Sets up a \a job to reuse the cached image of its layer translated after a map pan, so that
+     * only the newly exposed parts of the map are rendered. Returns FALSE if the cached image cannot
+     * be reused, in which case the job is left unchanged.
+     */
+    bool preparePannedRender( LayerRenderJob &job );
 };
 
 
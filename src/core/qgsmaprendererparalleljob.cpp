@@ -22,10 +22,31 @@
 #include "qgsproject.h"
 #include "qgsmaplayer.h"
 #include "qgsmaplayerlistutils.h"
+#include "qgsmaplayerstylemanager.h"
+#include "qgsvectorlayer.h"
+#include "qgsvectorlayerrenderer.h"
+#include "qgsrenderer.h"
+#include "qgspainteffect.h"
+#include "qgsexpressioncontextutils.h"
 
 #include <QtConcurrentMap>
 #include <QtConcurrentRun>
 
+//! Layers with a shorter estimated rendering time (in ms) are not worth splitting into tiles
+static const int MIN_TIME_FOR_TILED_RENDERING = 200;
+
+//! Maximum number of tiles a single layer is split into
+static const int MAX_TILES_PER_LAYER = 16;
+
+//! Minimum height of a single tile, in device pixels
+static const int MIN_TILE_HEIGHT = 64;
+
+/**
+ * Margin (in pixels) by which the feature request extent of each tile is grown, so that symbols
+ * of features located just outside a tile are still drawn in the part of the tile they cover.
+ */
+static const int TILE_EXTENT_MARGIN_PIXELS = 64;
+
 QgsMapRendererParallelJob::QgsMapRendererParallelJob( const QgsMapSettings &settings )
   : QgsMapRendererQImageJob( settings )
   , mStatus( Idle )
@@ -55,6 +76,7 @@ void QgsMapRendererParallelJob::start()
   {
     mLabelingEngineV2.reset( new QgsDefaultLabelingEngine() );
     mLabelingEngineV2->setMapSettings( mSettings );
+    mLabelingEngineV2->setPreviousResults( previousLabelingResults() );
   }
 
   bool canUseLabelCache = prepareLabelCache();
@@ -62,13 +84,22 @@ void QgsMapRendererParallelJob::start()
   mLabelJob = prepareLabelingJob( nullptr, mLabelingEngineV2.get(), canUseLabelCache );
   mSecondPassLayerJobs = prepareSecondPassJobs( mLayerJobs, mLabelJob );
 
+  if ( mSettings.testFlag( QgsMapSettings::RenderLayerTilesInParallel ) )
+    prepareTileJobs();
+
+  mRenderQueue.clear();
+  for ( LayerRenderJob &job : mLayerJobs )
+    mRenderQueue << &job;
+  for ( LayerRenderJob &job : mTileLayerJobs )
+    mRenderQueue << &job;
+
   QgsDebugMsgLevel( QStringLiteral( "QThreadPool max thread count is %1" ).arg( QThreadPool::globalInstance()->maxThreadCount() ), 2 );
 
   // start async job
 
   connect( &mFutureWatcher, &QFutureWatcher<void>::finished, this, &QgsMapRendererParallelJob::renderLayersFinished );
 
-  mFuture = QtConcurrent::map( mLayerJobs, renderLayerStatic );
+  mFuture = QtConcurrent::map( mRenderQueue, renderQueuedLayerStatic );
   mFutureWatcher.setFuture( mFuture );
 }
 
@@ -86,6 +117,12 @@ void QgsMapRendererParallelJob::cancel()
     if ( it->renderer && it->renderer->feedback() )
       it->renderer->feedback()->cancel();
   }
+  for ( LayerRenderJobs::iterator it = mTileLayerJobs.begin(); it != mTileLayerJobs.end(); ++it )
+  {
+    it->context.setRenderingStopped( true );
+    if ( it->renderer && it->renderer->feedback() )
+      it->renderer->feedback()->cancel();
+  }
 
   if ( mStatus == RenderingLayers )
   {
@@ -131,6 +168,12 @@ void QgsMapRendererParallelJob::cancelWithoutBlocking()
     if ( it->renderer && it->renderer->feedback() )
       it->renderer->feedback()->cancel();
   }
+  for ( LayerRenderJobs::iterator it = mTileLayerJobs.begin(); it != mTileLayerJobs.end(); ++it )
+  {
+    it->context.setRenderingStopped( true );
+    if ( it->renderer && it->renderer->feedback() )
+      it->renderer->feedback()->cancel();
+  }
 
   if ( mStatus == RenderingLayers )
   {
@@ -224,6 +267,9 @@ void QgsMapRendererParallelJob::renderLayersFinished()
 {
   Q_ASSERT( mStatus == RenderingLayers );
 
+  composeTileJobs();
+  cleanupTileJobs();
+
   LayerRenderJobs::const_iterator it = mLayerJobs.constBegin();
   for ( ; it != mLayerJobs.constEnd(); ++it )
   {
@@ -299,6 +345,9 @@ void QgsMapRendererParallelJob::renderingFinished()
 
     logRenderingTime( mLayerJobs, mSecondPassLayerJobs, mLabelJob );
 
+    // tile jobs are still around if the render was canceled without blocking
+    cleanupTileJobs();
+
     cleanupJobs( mLayerJobs );
 
     cleanupLabelJob( mLabelJob );
@@ -350,7 +399,8 @@ void QgsMapRendererParallelJob::renderLayerStatic( LayerRenderJob &job )
   if ( job.cached )
     return;
 
-  if ( job.img )
+  // images of panned renders already hold the reused part of the previous render
+  if ( job.img && !job.partiallyCached )
   {
     job.img->fill( 0 );
     job.imageInitialized = true;
@@ -387,6 +437,209 @@ void QgsMapRendererParallelJob::renderLayerStatic( LayerRenderJob &job )
 }
 
 
+void QgsMapRendererParallelJob::renderQueuedLayerStatic( LayerRenderJob *job )
+{
+  renderLayerStatic( *job );
+}
+
+bool QgsMapRendererParallelJob::canRenderInTiles( const LayerRenderJob &job ) const
+{
+  if ( job.cached || job.partiallyCached || !job.renderer || !job.img || job.maskImage )
+    return false;
+
+  // layers which were quick to render last time are not worth the overhead
+  if ( job.estimatedRenderingTime > 0 && job.estimatedRenderingTime < MIN_TIME_FOR_TILED_RENDERING )
+    return false;
+
+  if ( job.context.testFlag( QgsRenderContext::ApplyClipAfterReprojection ) )
+    return false;
+
+  QgsVectorLayer *vl = qobject_cast< QgsVectorLayer * >( job.layer );
+  if ( !vl || !dynamic_cast< QgsVectorLayerRenderer * >( job.renderer ) )
+    return false;
+
+  // paint effects are applied to the rendered layer as a whole, so they would show seams between tiles
+  if ( !vl->renderer() || ( vl->renderer()->paintEffect() && vl->renderer()->paintEffect()->enabled() ) )
+    return false;
+  if ( !vl->featureRendererGenerators().isEmpty() )
+    return false;
+
+  // layers taking part in selective masking are rendered again in a second pass, using the first pass image
+  for ( const LayerRenderJob &secondPassJob : mSecondPassLayerJobs )
+  {
+    if ( secondPassJob.firstPassJob == &job )
+      return false;
+  }
+
+  return true;
+}
+
+void QgsMapRendererParallelJob::prepareTileJobs()
+{
+  if ( !qgsDoubleNear( mSettings.rotation(), 0.0 ) )
+    return;
+
+  int jobsToRender = 0;
+  QList< LayerRenderJob * > tiledJobs;
+  for ( LayerRenderJob &job : mLayerJobs )
+  {
+    if ( job.cached || !job.renderer )
+      continue;
+
+    jobsToRender++;
+    if ( canRenderInTiles( job ) )
+      tiledJobs << &job;
+  }
+
+  if ( tiledJobs.isEmpty() )
+    return;
+
+  // share the threads which are not busy with other layers between the tiled layers
+  const QSize deviceSize = mSettings.deviceOutputSize();
+  const int freeThreads = QThreadPool::globalInstance()->maxThreadCount() - ( jobsToRender - tiledJobs.count() );
+  const int tileCount = std::min( std::min( freeThreads / tiledJobs.count(), MAX_TILES_PER_LAYER ), deviceSize.height() / MIN_TILE_HEIGHT );
+  if ( tileCount < 2 )
+    return;
+
+  const double dpr = mSettings.devicePixelRatio();
+  const double mapUnitsPerPixel = mSettings.mapUnitsPerPixel();
+  const QgsRectangle visibleExtent = mSettings.visibleExtent();
+  const double margin = mSettings.extentBuffer() + TILE_EXTENT_MARGIN_PIXELS * mapUnitsPerPixel;
+
+  for ( LayerRenderJob *job : qgis::as_const( tiledJobs ) )
+  {
+    QgsMapLayer *ml = job->layer;
+    const QgsCoordinateTransform ct = job->context.coordinateTransform();
+
+    // horizontal bands, in device pixels, and the corresponding extents in the layer's crs
+    QVector< int > tileTops;
+    QVector< int > tileHeights;
+    QVector< QgsRectangle > tileExtents;
+    bool extentsValid = true;
+    for ( int i = 0; i < tileCount && extentsValid; ++i )
+    {
+      const int top = deviceSize.height() * i / tileCount;
+      const int bottom = deviceSize.height() * ( i + 1 ) / tileCount;
+
+      QgsRectangle extent( visibleExtent.xMinimum(), visibleExtent.yMaximum() - bottom / dpr * mapUnitsPerPixel,
+                           visibleExtent.xMaximum(), visibleExtent.yMaximum() - top / dpr * mapUnitsPerPixel );
+      extent.grow( margin );
+      if ( ct.isValid() )
+      {
+        QgsRectangle r2;
+        extentsValid = reprojectToLayerExtent( ml, ct, extent, r2 ) && extent.isFinite();
+      }
+
+      tileTops << top;
+      tileHeights << bottom - top;
+      tileExtents << extent;
+    }
+    if ( !extentsValid )
+      continue;
+
+    QgsVectorLayerRenderer *primaryRenderer = static_cast< QgsVectorLayerRenderer * >( job->renderer );
+
+    // the layer's own renderer draws the first tile directly into the layer image...
+    job->context.setExtent( tileExtents.at( 0 ) );
+    job->context.painter()->setClipRect( QRectF( 0, 0, deviceSize.width() / dpr, tileHeights.at( 0 ) / dpr ) );
+
+    // ...while additional renderers draw the other tiles into separate images
+    for ( int i = 1; i < tileCount; ++i )
+    {
+      std::unique_ptr< QImage > img = qgis::make_unique< QImage >( deviceSize.width(), tileHeights.at( i ), mSettings.outputImageFormat() );
+      if ( img->isNull() )
+      {
+        mErrors.append( Error( ml->id(), tr( "Insufficient memory for image %1x%2" ).arg( deviceSize.width() ).arg( tileHeights.at( i ) ) ) );
+        break;
+      }
+      img->setDevicePixelRatio( dpr );
+
+      mTileLayerJobs.append( LayerRenderJob() );
+      LayerRenderJob &tile = mTileLayerJobs.last();
+      tile.cached = false;
+      tile.layer = ml;
+      tile.layerId = ml->id();
+      tile.blendMode = job->blendMode;
+      tile.opacity = job->opacity;
+      tile.estimatedRenderingTime = job->estimatedRenderingTime;
+      tile.renderingTime = -1;
+      tile.tileParentJob = job;
+      tile.tileOffset = tileTops.at( i );
+      tile.img = img.release();
+
+      QPainter *painter = new QPainter( tile.img );
+      painter->setRenderHint( QPainter::Antialiasing, mSettings.testFlag( QgsMapSettings::Antialiasing ) );
+#if QT_VERSION >= QT_VERSION_CHECK(5, 13, 0)
+      painter->setRenderHint( QPainter::LosslessImageRendering, mSettings.testFlag( QgsMapSettings::LosslessImageRendering ) );
+#endif
+      painter->translate( 0, -tileTops.at( i ) / dpr );
+
+      // labels are registered through the layer's own renderer, so the tiles must not create label providers
+      tile.context = QgsRenderContext::fromMapSettings( mSettings );
+      tile.context.expressionContext().appendScope( QgsExpressionContextUtils::layerScope( ml ) );
+      tile.context.setPainter( painter );
+      tile.context.setLabelingEngine( nullptr );
+      tile.context.setCoordinateTransform( ct );
+      tile.context.setExtent( tileExtents.at( i ) );
+      if ( featureFilterProvider() )
+        tile.context.setFeatureFilterProvider( featureFilterProvider() );
+
+      QgsMapLayerStyleOverride styleOverride( ml );
+      if ( mSettings.layerStyleOverrides().contains( ml->id() ) )
+        styleOverride.setOverrideStyle( mSettings.layerStyleOverrides().value( ml->id() ) );
+
+      tile.renderer = ml->createMapRenderer( tile.context );
+      tile.renderer->setLayerRenderingTimeHint( tile.estimatedRenderingTime );
+      primaryRenderer->shareLabelingWith( static_cast< QgsVectorLayerRenderer * >( tile.renderer ) );
+    }
+
+    QgsDebugMsgLevel( QStringLiteral( "layer %1 split into %2 tiles" ).arg( job->layerId ).arg( tileCount ), 2 );
+  }
+}
+
+void QgsMapRendererParallelJob::composeTileJobs()
+{
+  for ( LayerRenderJob &tile : mTileLayerJobs )
+  {
+    LayerRenderJob *parent = tile.tileParentJob;
+
+    parent->errors.append( tile.errors );
+    parent->completed = parent->completed && tile.completed;
+    // tiles are rendered concurrently, so the layer took as long as its slowest tile
+    parent->renderingTime = std::max( parent->renderingTime, tile.renderingTime );
+
+    if ( !tile.imageInitialized || !parent->img || !parent->context.painter() )
+      continue;
+
+    QPainter *painter = parent->context.painter();
+    painter->save();
+    painter->setClipping( false );
+    painter->setCompositionMode( QPainter::CompositionMode_Source );
+    painter->drawImage( QPointF( 0, tile.tileOffset / mSettings.devicePixelRatio() ), *tile.img );
+    painter->restore();
+  }
+}
+
+void QgsMapRendererParallelJob::cleanupTileJobs()
+{
+  mRenderQueue.clear();
+
+  for ( LayerRenderJob &tile : mTileLayerJobs )
+  {
+    if ( tile.img )
+    {
+      delete tile.context.painter();
+      tile.context.setPainter( nullptr );
+      delete tile.img;
+      tile.img = nullptr;
+    }
+
+    delete tile.renderer;
+    tile.renderer = nullptr;
+  }
+  mTileLayerJobs.clear();
+}
+
 void QgsMapRendererParallelJob::renderLabelsStatic( QgsMapRendererParallelJob *self )
 {
   LabelRenderJob &job = self->mLabelJob;
@@ -27,6 +27,10 @@
  * The resulting map image can be retrieved with renderedImage() function.
  * It is safe to call that function while rendering is active to see preview of the map.
  *
+ * If the QgsMapSettings::RenderLayerTilesInParallel flag is set, vector layers are also
+ * split into horizontal tiles which are rendered in parallel, so that maps with only
+ * few but heavy layers can make use of all available threads.
+ *
  * \since QGIS 2.4
  */
 class CORE_EXPORT QgsMapRendererParallelJob : public QgsMapRendererQImageJob
@@ -61,8 +65,34 @@ class CORE_EXPORT QgsMapRendererParallelJob : public QgsMapRendererQImageJob
     //! \note not available in Python bindings
     static void renderLayerStatic( LayerRenderJob &job ) SIP_SKIP;
     //! \note not available in Python bindings
+    static void renderQueuedLayerStatic( LayerRenderJob *job ) SIP_SKIP;
+    //! \note not available in Python bindings
     static void renderLabelsStatic( QgsMapRendererParallelJob *self ) SIP_SKIP;
 
+    /**
+     * Splits eligible vector layer jobs into several horizontal tiles, which are rendered in parallel.
+     * \note not available in Python bindings
+     */
+    void prepareTileJobs() SIP_SKIP;
+
+    /**
+     * Returns TRUE if the layer rendered by \a job can be split into tiles.
+     * \note not available in Python bindings
+     */
+    bool canRenderInTiles( const LayerRenderJob &job ) const SIP_SKIP;
+
+    /**
+     * Composes the rendered tile images into the images of their parent jobs.
+     * \note not available in Python bindings
+     */
+    void composeTileJobs() SIP_SKIP;
+
+    /**
+     * Deletes the tile jobs, their images and renderers.
+     * \note not available in Python bindings
+     */
+    void cleanupTileJobs() SIP_SKIP;
+
     QImage mFinalImage;
 
     //! \note not available in Python bindings
@@ -74,6 +104,12 @@ class CORE_EXPORT QgsMapRendererParallelJob : public QgsMapRendererQImageJob
     LayerRenderJobs mLayerJobs;
     LabelRenderJob mLabelJob;
 
+    //! Jobs rendering additional spatial tiles of layers from mLayerJobs
+    LayerRenderJobs mTileLayerJobs;
+
+    //! Layer and tile jobs to render in the first pass
+    QList< LayerRenderJob * > mRenderQueue;
+
     LayerRenderJobs mSecondPassLayerJobs;
     QFuture<void> mSecondPassFuture;
     QFutureWatcher<void> mSecondPassFutureWatcher;
@@ -111,7 +111,8 @@ bool QgsMapRendererStagedRenderJob::renderCurrentPart( QPainter *painter )
       painter->setCompositionMode( job.blendMode );
     }
 
-    if ( job.img )
+    // images of panned renders already hold the reused part of the previous render
+    if ( job.img && !job.partiallyCached )
     {
       job.img->fill( 0 );
       job.imageInitialized = true;
@@ -393,6 +393,7 @@ class CORE_EXPORT QgsMapSettings : public QgsTemporalRangeObject
       RenderBlocking           = 0x800, //!< Render and load remote sources in the same thread to ensure rendering remote sources (svg and images). WARNING: this flag must NEVER be used from GUI based applications (like the main QGIS application) or crashes will result. Only for use in external scripts or QGIS server.
       LosslessImageRendering   = 0x1000, //!< Render images losslessly whenever possible, instead of the default lossy jpeg rendering used for some destination devices (e.g. PDF). This flag only works with builds based on Qt 5.13 or later.
       Render3DMap              = 0x2000, //!< Render is for a 3D map
+      RenderLayerTilesInParallel = 0x4000, //!< Allow vector layers to be split into spatial tiles which are rendered in parallel threads. Only supported by QgsMapRendererParallelJob. Added in QGIS 3.18
       // TODO: ignore scale-based visibility (overview)
     };
     Q_DECLARE_FLAGS( Flags, Flag )
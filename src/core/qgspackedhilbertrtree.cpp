@@ -0,0 +1,232 @@
+/***************************************************************************
+                         qgspackedhilbertrtree.cpp
+                         -------------------------
+    begin                : February 2021
+    copyright            : (C) 2021 by QGIS.org
+    email                : info at qgis dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgspackedhilbertrtree.h"
+#include "qgsspatialindexutils.h"
+
+#include <QThread>
+#include <QtConcurrentMap>
+
+#include <array>
+#include <functional>
+#include <limits>
+
+///@cond PRIVATE
+
+//! Number of boxes from which the tree is built by several threads
+static const std::size_t PARALLEL_BUILD_THRESHOLD = 1 << 16;
+
+//! Calls \a function for consecutive ranges of [0, count), from several threads for large counts
+static void forEachRange( std::size_t count, const std::function< void( std::size_t, std::size_t ) > &function )
+{
+  const std::size_t threads = static_cast< std::size_t >( std::max( 1, QThread::idealThreadCount() ) );
+  if ( count < PARALLEL_BUILD_THRESHOLD || threads < 2 )
+  {
+    function( 0, count );
+    return;
+  }
+
+  std::vector< std::pair< std::size_t, std::size_t > > ranges;
+  const std::size_t rangeSize = ( count + threads - 1 ) / threads;
+  for ( std::size_t begin = 0; begin < count; begin += rangeSize )
+    ranges.emplace_back( begin, std::min( begin + rangeSize, count ) );
+
+  QtConcurrent::blockingMap( ranges, [&function]( std::pair< std::size_t, std::size_t > &range )
+  {
+    function( range.first, range.second );
+  } );
+}
+
+//! Sorts \a keys, by sorting ranges of keys in parallel and then merging them for large counts
+template <typename Key>
+static void sortKeys( std::vector< Key > &keys )
+{
+  const std::size_t threads = static_cast< std::size_t >( std::max( 1, QThread::idealThreadCount() ) );
+  if ( keys.size() < PARALLEL_BUILD_THRESHOLD || threads < 2 )
+  {
+    std::sort( keys.begin(), keys.end() );
+    return;
+  }
+
+  std::vector< std::pair< std::size_t, std::size_t > > ranges;
+  const std::size_t rangeSize = ( keys.size() + threads - 1 ) / threads;
+  for ( std::size_t begin = 0; begin < keys.size(); begin += rangeSize )
+    ranges.emplace_back( begin, std::min( begin + rangeSize, keys.size() ) );
+
+  QtConcurrent::blockingMap( ranges, [&keys]( std::pair< std::size_t, std::size_t > &range )
+  {
+    std::sort( keys.begin() + range.first, keys.begin() + range.second );
+  } );
+
+  // merge pairs of sorted ranges until a single one is left
+  while ( ranges.size() > 1 )
+  {
+    std::vector< std::array< std::size_t, 3 > > merges;
+    std::vector< std::pair< std::size_t, std::size_t > > merged;
+    for ( std::size_t i = 0; i < ranges.size(); i += 2 )
+    {
+      if ( i + 1 < ranges.size() )
+      {
+        merges.push_back( { { ranges[i].first, ranges[i].second, ranges[i + 1].second } } );
+        merged.emplace_back( ranges[i].first, ranges[i + 1].second );
+      }
+      else
+      {
+        merged.emplace_back( ranges[i] );
+      }
+    }
+
+    QtConcurrent::blockingMap( merges, [&keys]( std::array< std::size_t, 3 > &merge )
+    {
+      std::inplace_merge( keys.begin() + merge[0], keys.begin() + merge[1], keys.begin() + merge[2] );
+    } );
+    ranges = std::move( merged );
+  }
+}
+
+///@endcond
+
+QgsPackedHilbertRTree::QgsPackedHilbertRTree( const std::vector< double > &boxes )
+{
+  const std::size_t count = boxes.size() / 4;
+  if ( count == 0 )
+    return;
+
+  // extent of all boxes, used to map box centers to the Hilbert curve
+  double minX = std::numeric_limits< double >::max();
+  double minY = std::numeric_limits< double >::max();
+  double maxX = std::numeric_limits< double >::lowest();
+  double maxY = std::numeric_limits< double >::lowest();
+  for ( std::size_t i = 0; i < count; ++i )
+  {
+    const double *box = boxes.data() + i * 4;
+    minX = std::min( minX, box[0] );
+    minY = std::min( minY, box[1] );
+    maxX = std::max( maxX, box[2] );
+    maxY = std::max( maxY, box[3] );
+  }
+
+  const double hilbertMax = ( 1 << 16 ) - 1;
+  const double width = maxX - minX;
+  const double height = maxY - minY;
+  auto hilbertValue = [&]( std::size_t i )
+  {
+    const double *box = boxes.data() + i * 4;
+    const quint32 x = width > 0 ? static_cast< quint32 >( hilbertMax * ( ( box[0] + box[2] ) / 2 - minX ) / width ) : 0;
+    const quint32 y = height > 0 ? static_cast< quint32 >( hilbertMax * ( ( box[1] + box[3] ) / 2 - minY ) / height ) : 0;
+    return QgsSpatialIndexUtils::hilbertValue( x, y );
+  };
+
+  // boxes are sorted by Hilbert value then by position, which keeps boxes with the same Hilbert value in order
+  mLeafOrder.resize( count );
+  if ( static_cast< quint64 >( count ) <= std::numeric_limits< quint32 >::max() )
+  {
+    // sort keys hold the Hilbert value in their high bits and the position in their low bits, so
+    // that a plain sort of integers is enough
+    std::vector< quint64 > keys( count );
+    forEachRange( count, [&]( std::size_t begin, std::size_t end )
+    {
+      for ( std::size_t i = begin; i < end; ++i )
+        keys[i] = ( static_cast< quint64 >( hilbertValue( i ) ) << 32 ) | static_cast< quint64 >( i );
+    } );
+    sortKeys( keys );
+    forEachRange( count, [&]( std::size_t begin, std::size_t end )
+    {
+      for ( std::size_t i = begin; i < end; ++i )
+        mLeafOrder[i] = static_cast< std::size_t >( keys[i] & 0xFFFFFFFF );
+    } );
+  }
+  else
+  {
+    // positions don't fit in the low bits of a single key
+    std::vector< std::pair< quint32, std::size_t > > keys( count );
+    forEachRange( count, [&]( std::size_t begin, std::size_t end )
+    {
+      for ( std::size_t i = begin; i < end; ++i )
+        keys[i] = std::make_pair( hilbertValue( i ), i );
+    } );
+    sortKeys( keys );
+    forEachRange( count, [&]( std::size_t begin, std::size_t end )
+    {
+      for ( std::size_t i = begin; i < end; ++i )
+        mLeafOrder[i] = keys[i].second;
+    } );
+  }
+
+  mLevelBounds = levelBoundsForCount( count );
+  mOwnedBoxes.resize( nodeCount() * 4 );
+
+  // leaves, in Hilbert order
+  forEachRange( count, [&]( std::size_t begin, std::size_t end )
+  {
+    for ( std::size_t i = begin; i < end; ++i )
+      std::copy_n( boxes.data() + mLeafOrder[i] * 4, 4, mOwnedBoxes.data() + i * 4 );
+  } );
+
+  // parent nodes enclose consecutive groups of NODE_SIZE nodes from the level below
+  std::size_t position = count;
+  for ( std::size_t level = 0; level + 1 < mLevelBounds.size(); ++level )
+  {
+    const std::size_t levelEnd = mLevelBounds[level];
+    std::size_t child = level == 0 ? 0 : mLevelBounds[level - 1];
+    while ( child < levelEnd )
+    {
+      double *box = mOwnedBoxes.data() + position * 4;
+      box[0] = std::numeric_limits< double >::max();
+      box[1] = std::numeric_limits< double >::max();
+      box[2] = std::numeric_limits< double >::lowest();
+      box[3] = std::numeric_limits< double >::lowest();
+      for ( std::size_t j = 0; j < NODE_SIZE && child < levelEnd; ++j, ++child )
+      {
+        const double *childBox = mOwnedBoxes.data() + child * 4;
+        box[0] = std::min( box[0], childBox[0] );
+        box[1] = std::min( box[1], childBox[1] );
+        box[2] = std::max( box[2], childBox[2] );
+        box[3] = std::max( box[3], childBox[3] );
+      }
+      position++;
+    }
+  }
+
+  mBoxes = mOwnedBoxes.data();
+}
+
+QgsPackedHilbertRTree::QgsPackedHilbertRTree( const double *boxes, std::vector< std::size_t > levelBounds )
+  : mBoxes( boxes )
+  , mLevelBounds( std::move( levelBounds ) )
+{
+  Q_ASSERT( mLevelBounds == levelBoundsForCount( count() ) );
+}
+
+std::vector< std::size_t > QgsPackedHilbertRTree::levelBoundsForCount( std::size_t count )
+{
+  std::vector< std::size_t > levelBounds;
+  if ( count == 0 )
+    return levelBounds;
+
+  // count the nodes of each level, up to the single root node
+  std::size_t levelCount = count;
+  std::size_t nodeCount = count;
+  levelBounds.emplace_back( count );
+  while ( levelCount != 1 )
+  {
+    levelCount = ( levelCount + NODE_SIZE - 1 ) / NODE_SIZE;
+    nodeCount += levelCount;
+    levelBounds.emplace_back( nodeCount );
+  }
+  return levelBounds;
+}
@@ -0,0 +1,181 @@
+/***************************************************************************
+                         qgspackedhilbertrtree.h
+                         -----------------------
+    begin                : February 2021
+    copyright            : (C) 2021 by QGIS.org
+    email                : info at qgis dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSPACKEDHILBERTRTREE_H
+#define QGSPACKEDHILBERTRTREE_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+#include "qgsrectangle.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+/**
+ * \ingroup core
+ * \class QgsPackedHilbertRTree
+ *
+ * A static, packed Hilbert R-tree of bounding boxes, which is the common structure of the static spatial
+ * indexes: QgsSpatialIndex::FlagStaticIndex indexes, PalStaticRtree and QgsPackedSpatialIndexFile.
+ *
+ * Boxes are sorted along a Hilbert curve of their centers and packed into full nodes of NODE_SIZE
+ * entries, level by level up to a single root node. All boxes are stored in a single array, with 4 values
+ * (xmin, ymin, xmax, ymax) per box: first the leaves in Hilbert order, then the nodes of each level. The
+ * children of a node are found from its position instead of pointers, so a tree can also be used as is from
+ * a memory mapped file.
+ *
+ * \note Not available in Python bindings.
+ * \since QGIS 3.18
+ */
+class CORE_EXPORT QgsPackedHilbertRTree
+{
+  public:
+
+    //! Number of entries of each node
+    static constexpr std::size_t NODE_SIZE = 16;
+
+    //! Constructor for an empty tree
+    QgsPackedHilbertRTree() = default;
+
+    /**
+     * Builds a tree from \a boxes, with 4 values (xmin, ymin, xmax, ymax) per box.
+     *
+     * Boxes with the same Hilbert value keep their order, so that the tree only depends on the
+     * order of the boxes. Large trees are built by several threads.
+     *
+     * leafOrder() gives the position in \a boxes of each leaf of the tree.
+     */
+    explicit QgsPackedHilbertRTree( const std::vector< double > &boxes );
+
+    /**
+     * Constructor for a tree built previously, e.g. read from a file, with the \a boxes of all its nodes
+     * and the end position of each level in \a levelBounds.
+     *
+     * The boxes are not copied and must exist for the lifetime of the tree. The \a levelBounds must match
+     * levelBoundsForCount().
+     */
+    QgsPackedHilbertRTree( const double *boxes, std::vector< std::size_t > levelBounds );
+
+    QgsPackedHilbertRTree( const QgsPackedHilbertRTree &other ) = delete;
+    QgsPackedHilbertRTree &operator=( const QgsPackedHilbertRTree &other ) = delete;
+    QgsPackedHilbertRTree( QgsPackedHilbertRTree &&other ) = default;
+    QgsPackedHilbertRTree &operator=( QgsPackedHilbertRTree &&other ) = default;
+
+    /**
+     * Returns the end position of each level of a tree of \a count leaves, from the leaves to the root.
+     */
+    static std::vector< std::size_t > levelBoundsForCount( std::size_t count );
+
+    /**
+     * Returns the number of leaves of the tree.
+     */
+    std::size_t count() const { return mLevelBounds.empty() ? 0 : mLevelBounds.front(); }
+
+    /**
+     * Returns the number of nodes of the tree, including the leaves.
+     */
+    std::size_t nodeCount() const { return mLevelBounds.empty() ? 0 : mLevelBounds.back(); }
+
+    /**
+     * Returns the boxes of all nodes, with 4 values per node.
+     */
+    const double *boxes() const { return mBoxes; }
+
+    /**
+     * Returns the end position of each level, from the leaves to the root.
+     */
+    const std::vector< std::size_t > &levelBounds() const { return mLevelBounds; }
+
+    /**
+     * Returns the position in the boxes the tree was built from of each leaf. Empty for trees
+     * which were not built by this object.
+     */
+    const std::vector< std::size_t > &leafOrder() const { return mLeafOrder; }
+
+    /**
+     * Returns the position of the first child of the node at \a position, on \a level.
+     */
+    std::size_t firstChild( std::size_t position, std::size_t level ) const
+    {
+      const std::size_t levelStart = mLevelBounds[level - 1];
+      const std::size_t childLevelStart = level >= 2 ? mLevelBounds[level - 2] : 0;
+      return childLevelStart + ( position - levelStart ) * NODE_SIZE;
+    }
+
+    /**
+     * Calls \a callback with the position of each leaf whose box intersects \a rectangle, including
+     * boxes which only touch it. If the callback returns FALSE, the search is stopped and FALSE is returned.
+     */
+    template <typename Callback>
+    bool intersects( const QgsRectangle &rectangle, Callback &&callback ) const
+    {
+      if ( mLevelBounds.empty() )
+        return true;
+
+      const double xMin = rectangle.xMinimum();
+      const double yMin = rectangle.yMinimum();
+      const double xMax = rectangle.xMaximum();
+      const double yMax = rectangle.yMaximum();
+
+      // pairs of first node and level of the nodes which remain to be visited
+      std::vector< std::pair< std::size_t, std::size_t > > stack;
+      stack.emplace_back( nodeCount() - 1, mLevelBounds.size() - 1 );
+
+      bool overlaps[NODE_SIZE];
+      while ( !stack.empty() )
+      {
+        const std::size_t first = stack.back().first;
+        const std::size_t level = stack.back().second;
+        stack.pop_back();
+
+        const std::size_t count = std::min( first + NODE_SIZE, mLevelBounds[level] ) - first;
+        const double *box = mBoxes + first * 4;
+
+        // branchless test of all the boxes of the node
+        for ( std::size_t i = 0; i < count; ++i, box += 4 )
+          overlaps[i] = ( box[0] <= xMax ) & ( box[1] <= yMax ) & ( box[2] >= xMin ) & ( box[3] >= yMin );
+
+        for ( std::size_t i = 0; i < count; ++i )
+        {
+          if ( !overlaps[i] )
+            continue;
+
+          if ( level == 0 )
+          {
+            if ( !callback( first + i ) )
+              return false;
+          }
+          else
+          {
+            stack.emplace_back( firstChild( first + i, level ), level - 1 );
+          }
+        }
+      }
+      return true;
+    }
+
+  private:
+
+    std::vector< double > mOwnedBoxes;
+    const double *mBoxes = nullptr;
+    std::vector< std::size_t > mLevelBounds;
+    std::vector< std::size_t > mLeafOrder;
+};
+
+#endif // QGSPACKEDHILBERTRTREE_H
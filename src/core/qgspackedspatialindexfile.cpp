@@ -0,0 +1,293 @@
+/***************************************************************************
+                         qgspackedspatialindexfile.cpp
+                         -----------------------------
+    begin                : February 2021
+    copyright            : (C) 2021 by QGIS.org
+    email                : info at qgis dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgspackedspatialindexfile.h"
+#include "qgslogger.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QObject>
+#include <QRegularExpression>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+///@cond PRIVATE
+
+static const char INDEX_MAGIC[8] = { 'Q', 'G', 'I', 'S', 'P', 'S', 'I', 'X' };
+static const quint32 INDEX_VERSION = 2;
+static const quint32 INDEX_BYTE_ORDER = 0x01020304;
+
+/**
+ * Header of an index file, followed by the level bounds, the boxes of all nodes, the
+ * feature ids and the feature offsets. All values are stored in native byte order
+ * and are 8 bytes aligned, so that the file can be used as is once memory mapped.
+ */
+struct IndexHeader
+{
+  char magic[8];
+  quint32 version;
+  quint32 nodeSize;
+  quint32 byteOrder;
+  quint32 levelCount;
+  qint64 sourceSize;
+  qint64 sourceModified;
+  qint64 count;
+  qint64 nodeCount;
+  double extent[4];
+  char optionsHash[16];
+};
+
+static QByteArray sourceOptionsHash( const QString &sourceOptions )
+{
+  return QCryptographicHash::hash( sourceOptions.toUtf8(), QCryptographicHash::Md5 );
+}
+
+static bool sourceFileStamp( const QString &sourcePath, qint64 &size, qint64 &modified )
+{
+  const QFileInfo info( sourcePath );
+  if ( !info.isFile() )
+    return false;
+
+  size = info.size();
+  modified = info.lastModified().toMSecsSinceEpoch();
+  return true;
+}
+
+///@endcond
+
+QgsPackedSpatialIndexFile::~QgsPackedSpatialIndexFile()
+{
+  if ( mData )
+    mFile.unmap( mData );
+}
+
+QString QgsPackedSpatialIndexFile::indexPath( const QString &sourcePath, const QString &layerName, const QString &sourceOptions )
+{
+  QString path = sourcePath;
+  if ( !layerName.isEmpty() )
+  {
+    QString safeLayerName = layerName;
+    safeLayerName.replace( QRegularExpression( QStringLiteral( "[^a-zA-Z0-9_-]" ) ), QStringLiteral( "_" ) );
+    path += '.' + safeLayerName;
+  }
+
+  // layers reading the same file with other options use their own index file, instead of replacing
+  // each other's index, which also fails on Windows while the other layer has it memory mapped
+  if ( !sourceOptions.isEmpty() )
+    path += '.' + QString::fromLatin1( sourceOptionsHash( sourceOptions ).toHex().left( 8 ) );
+
+  return path + QStringLiteral( ".qgsidx" );
+}
+
+bool QgsPackedSpatialIndexFile::write( const QString &indexPath, const QString &sourcePath, std::vector< Entry > entries, QString *error, const QString &sourceOptions )
+{
+  IndexHeader header;
+  std::memcpy( header.magic, INDEX_MAGIC, sizeof( INDEX_MAGIC ) );
+  std::memcpy( header.optionsHash, sourceOptionsHash( sourceOptions ).constData(), sizeof( header.optionsHash ) );
+  header.version = INDEX_VERSION;
+  header.nodeSize = QgsPackedHilbertRTree::NODE_SIZE;
+  header.byteOrder = INDEX_BYTE_ORDER;
+  if ( !sourceFileStamp( sourcePath, header.sourceSize, header.sourceModified ) )
+  {
+    if ( error )
+      *error = QObject::tr( "Could not find file %1" ).arg( sourcePath );
+    return false;
+  }
+
+  // features without geometry are not indexed
+  entries.erase( std::remove_if( entries.begin(), entries.end(), []( const Entry & entry )
+  {
+    return !( entry.bounds.xMinimum() <= entry.bounds.xMaximum() && entry.bounds.yMinimum() <= entry.bounds.yMaximum() );
+  } ), entries.end() );
+  const qint64 count = static_cast< qint64 >( entries.size() );
+
+  // extent of all entries
+  double minX = std::numeric_limits< double >::max();
+  double minY = std::numeric_limits< double >::max();
+  double maxX = std::numeric_limits< double >::lowest();
+  double maxY = std::numeric_limits< double >::lowest();
+  std::vector< double > entryBoxes( entries.size() * 4 );
+  for ( std::size_t i = 0; i < entries.size(); ++i )
+  {
+    const QgsRectangle &bounds = entries[i].bounds;
+    minX = std::min( minX, bounds.xMinimum() );
+    minY = std::min( minY, bounds.yMinimum() );
+    maxX = std::max( maxX, bounds.xMaximum() );
+    maxY = std::max( maxY, bounds.yMaximum() );
+    entryBoxes[i * 4] = bounds.xMinimum();
+    entryBoxes[i * 4 + 1] = bounds.yMinimum();
+    entryBoxes[i * 4 + 2] = bounds.xMaximum();
+    entryBoxes[i * 4 + 3] = bounds.yMaximum();
+  }
+  const QgsRectangle extent = count > 0 ? QgsRectangle( minX, minY, maxX, maxY ) : QgsRectangle();
+
+  const QgsPackedHilbertRTree tree( entryBoxes );
+  entryBoxes = std::vector< double >();
+
+  const std::vector< qint64 > levelBounds( tree.levelBounds().begin(), tree.levelBounds().end() );
+  const qint64 nodeCount = static_cast< qint64 >( tree.nodeCount() );
+
+  // ids and offsets of the leaves, in the order of the tree
+  const std::vector< std::size_t > &order = tree.leafOrder();
+  std::vector< qint64 > ids( count );
+  std::vector< qint64 > offsets( count );
+  for ( qint64 i = 0; i < count; ++i )
+  {
+    const Entry &entry = entries[order[i]];
+    ids[i] = entry.id;
+    offsets[i] = entry.offset;
+  }
+
+  header.levelCount = static_cast< quint32 >( levelBounds.size() );
+  header.count = count;
+  header.nodeCount = nodeCount;
+  header.extent[0] = extent.xMinimum();
+  header.extent[1] = extent.yMinimum();
+  header.extent[2] = extent.xMaximum();
+  header.extent[3] = extent.yMaximum();
+
+  QSaveFile file( indexPath );
+  if ( !file.open( QIODevice::WriteOnly ) )
+  {
+    if ( error )
+      *error = QObject::tr( "Could not create spatial index file %1: %2" ).arg( indexPath, file.errorString() );
+    return false;
+  }
+
+  file.write( reinterpret_cast< const char * >( &header ), sizeof( IndexHeader ) );
+  file.write( reinterpret_cast< const char * >( levelBounds.data() ), static_cast< qint64 >( levelBounds.size() * sizeof( qint64 ) ) );
+  file.write( reinterpret_cast< const char * >( tree.boxes() ), nodeCount * 4 * static_cast< qint64 >( sizeof( double ) ) );
+  file.write( reinterpret_cast< const char * >( ids.data() ), count * static_cast< qint64 >( sizeof( qint64 ) ) );
+  file.write( reinterpret_cast< const char * >( offsets.data() ), count * static_cast< qint64 >( sizeof( qint64 ) ) );
+  if ( !file.commit() )
+  {
+    if ( error )
+      *error = QObject::tr( "Could not write spatial index file %1: %2" ).arg( indexPath, file.errorString() );
+    return false;
+  }
+  return true;
+}
+
+std::unique_ptr< QgsPackedSpatialIndexFile > QgsPackedSpatialIndexFile::open( const QString &indexPath, const QString &sourcePath, const QString &sourceOptions )
+{
+  std::unique_ptr< QgsPackedSpatialIndexFile > index( new QgsPackedSpatialIndexFile() );
+  index->mSourcePath = sourcePath;
+  index->mFile.setFileName( indexPath );
+  if ( !index->mFile.exists() || !index->mFile.open( QIODevice::ReadOnly ) )
+    return nullptr;
+
+  const qint64 size = index->mFile.size();
+  if ( size < static_cast< qint64 >( sizeof( IndexHeader ) ) )
+    return nullptr;
+
+  index->mData = index->mFile.map( 0, size );
+  if ( !index->mData )
+  {
+    QgsDebugMsg( QStringLiteral( "Could not map spatial index file %1" ).arg( indexPath ) );
+    return nullptr;
+  }
+
+  IndexHeader header;
+  std::memcpy( &header, index->mData, sizeof( IndexHeader ) );
+  if ( std::memcmp( header.magic, INDEX_MAGIC, sizeof( INDEX_MAGIC ) ) != 0 || header.version != INDEX_VERSION
+       || header.byteOrder != INDEX_BYTE_ORDER || header.nodeSize != QgsPackedHilbertRTree::NODE_SIZE
+       || header.count < 0 || header.nodeCount < header.count )
+  {
+    QgsDebugMsg( QStringLiteral( "Unsupported spatial index file %1" ).arg( indexPath ) );
+    return nullptr;
+  }
+
+  const qint64 expectedSize = static_cast< qint64 >( sizeof( IndexHeader ) )
+                              + static_cast< qint64 >( header.levelCount ) * 8 + header.nodeCount * 4 * 8 + header.count * 2 * 8;
+  if ( size != expectedSize )
+  {
+    QgsDebugMsg( QStringLiteral( "Truncated spatial index file %1" ).arg( indexPath ) );
+    return nullptr;
+  }
+
+  if ( std::memcmp( header.optionsHash, sourceOptionsHash( sourceOptions ).constData(), sizeof( header.optionsHash ) ) != 0 )
+  {
+    QgsDebugMsgLevel( QStringLiteral( "Spatial index file %1 was built with other options" ).arg( indexPath ), 2 );
+    return nullptr;
+  }
+
+  index->mSourceSize = header.sourceSize;
+  index->mSourceModified = header.sourceModified;
+  if ( !index->isUpToDate() )
+  {
+    QgsDebugMsgLevel( QStringLiteral( "Spatial index file %1 is outdated" ).arg( indexPath ), 2 );
+    return nullptr;
+  }
+
+  index->mCount = header.count;
+  if ( header.count > 0 )
+    index->mExtent = QgsRectangle( header.extent[0], header.extent[1], header.extent[2], header.extent[3] );
+
+  const uchar *data = index->mData + sizeof( IndexHeader );
+  const qint64 *levelBoundsData = reinterpret_cast< const qint64 * >( data );
+  std::vector< std::size_t > levelBounds( levelBoundsData, levelBoundsData + header.levelCount );
+  data += static_cast< qint64 >( header.levelCount ) * 8;
+  const double *boxes = reinterpret_cast< const double * >( data );
+  data += header.nodeCount * 4 * 8;
+  index->mIds = reinterpret_cast< const qint64 * >( data );
+  data += header.count * 8;
+  index->mOffsets = reinterpret_cast< const qint64 * >( data );
+
+  // the levels must be the ones of a tree of count leaves, ending with the last node
+  if ( levelBounds != QgsPackedHilbertRTree::levelBoundsForCount( static_cast< std::size_t >( header.count ) )
+       || ( header.count > 0 && static_cast< qint64 >( levelBounds.back() ) != header.nodeCount ) )
+  {
+    QgsDebugMsg( QStringLiteral( "Invalid node levels in spatial index file %1" ).arg( indexPath ) );
+    return nullptr;
+  }
+  index->mTree = QgsPackedHilbertRTree( boxes, std::move( levelBounds ) );
+
+  return index;
+}
+
+bool QgsPackedSpatialIndexFile::isUpToDate() const
+{
+  qint64 size = 0;
+  qint64 modified = 0;
+  return sourceFileStamp( mSourcePath, size, modified ) && size == mSourceSize && modified == mSourceModified;
+}
+
+QVector< QgsPackedSpatialIndexFile::Entry > QgsPackedSpatialIndexFile::intersects( const QgsRectangle &rectangle ) const
+{
+  QVector< Entry > results;
+  const double *boxes = mTree.boxes();
+  mTree.intersects( rectangle, [this, boxes, &results]( std::size_t position )
+  {
+    const double *box = boxes + position * 4;
+    Entry entry;
+    entry.id = mIds[position];
+    entry.offset = mOffsets[position];
+    entry.bounds = QgsRectangle( box[0], box[1], box[2], box[3] );
+    results << entry;
+    return true;
+  } );
+
+  std::sort( results.begin(), results.end(), []( const Entry & a, const Entry & b )
+  {
+    return a.offset < b.offset || ( a.offset == b.offset && a.id < b.id );
+  } );
+  return results;
+}
@@ -0,0 +1,153 @@
+/***************************************************************************
+                         qgspackedspatialindexfile.h
+                         ---------------------------
+    begin                : February 2021
+    copyright            : (C) 2021 by QGIS.org
+    email                : info at qgis dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSPACKEDSPATIALINDEXFILE_H
+#define QGSPACKEDSPATIALINDEXFILE_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+#include "qgsfeatureid.h"
+#include "qgspackedhilbertrtree.h"
+#include "qgsrectangle.h"
+
+#include <QFile>
+#include <QString>
+#include <QVector>
+#include <memory>
+#include <vector>
+
+/**
+ * \ingroup core
+ * \class QgsPackedSpatialIndexFile
+ *
+ * A static, packed Hilbert rtree of feature bounding boxes, stored in a sidecar file next to a
+ * data file which has no spatial index of its own (e.g. GeoJSON, GML or delimited text files).
+ *
+ * The index is written once with write(), after a full scan of the data file, and is then memory mapped
+ * by open() so that bounding box queries only touch the few pages of the tree they need, without
+ * loading the whole index or rescanning the data file.
+ *
+ * Alongside its id, every feature carries an \a offset, which is an opaque position of the feature
+ * in the data file defined by the provider which built the index, e.g. to seek directly to the matching
+ * records of a text file.
+ *
+ * The size and modification time of the data file are stored in the index, and an index which does not
+ * match its data file any more is never opened. Providers whose features depend on options of the layer
+ * rather than on the data file alone, e.g. the geometry columns of a delimited text file, also pass these
+ * \a sourceOptions, so that each set of options gets its own index file and an index built with other
+ * options is never opened.
+ *
+ * \note Not available in Python bindings.
+ * \since QGIS 3.18
+ */
+class CORE_EXPORT QgsPackedSpatialIndexFile
+{
+  public:
+
+    //! A feature stored in the index
+    struct Entry
+    {
+      //! Feature id
+      QgsFeatureId id = FID_NULL;
+
+      //! Provider specific position of the feature in the data file, or -1
+      qint64 offset = -1;
+
+      //! Bounding box of the feature's geometry
+      QgsRectangle bounds;
+    };
+
+    ~QgsPackedSpatialIndexFile();
+
+    QgsPackedSpatialIndexFile( const QgsPackedSpatialIndexFile &other ) = delete;
+    QgsPackedSpatialIndexFile &operator=( const QgsPackedSpatialIndexFile &other ) = delete;
+
+    /**
+     * Returns the path of the index file for the data file at \a sourcePath.
+     *
+     * Files containing several layers use a separate index file for each \a layerName, and a separate
+     * index file is used for each set of provider specific \a sourceOptions.
+     */
+    static QString indexPath( const QString &sourcePath, const QString &layerName = QString(), const QString &sourceOptions = QString() );
+
+    /**
+     * Builds a packed index from \a entries, and writes it to \a indexPath for the data file at \a sourcePath
+     * read with the provider specific \a sourceOptions.
+     *
+     * Entries with an empty or invalid bounding box, e.g. as set by QgsRectangle::setMinimal(), are skipped. The index is first
+     * written to a temporary file which replaces any existing index once complete, so that readers never see a partially written index.
+     *
+     * Returns FALSE if the index could not be written, e.g. because the directory is read only or because
+     * the existing index file is still memory mapped by another reader on Windows, in which case the \a error
+     * argument will be set to a descriptive message.
+     */
+    static bool write( const QString &indexPath, const QString &sourcePath, std::vector< Entry > entries, QString *error = nullptr, const QString &sourceOptions = QString() );
+
+    /**
+     * Opens the index file at \a indexPath built for the data file at \a sourcePath read with the provider
+     * specific \a sourceOptions.
+     *
+     * Returns NULLPTR if there is no index file, if it is invalid, if it was built with other
+     * options or if the data file was modified since the index was built.
+     */
+    static std::unique_ptr< QgsPackedSpatialIndexFile > open( const QString &indexPath, const QString &sourcePath, const QString &sourceOptions = QString() );
+
+    /**
+     * Returns TRUE if the data file still matches the index, i.e. if it was not modified
+     * since the index was built.
+     */
+    bool isUpToDate() const;
+
+    /**
+     * Returns the number of features in the index.
+     */
+    qint64 count() const { return mCount; }
+
+    /**
+     * Returns the extent of all features in the index.
+     */
+    QgsRectangle extent() const { return mExtent; }
+
+    /**
+     * Returns the entries of all features whose bounding box intersects \a rectangle,
+     * sorted by offset then id, so that the matching features can be read in file order.
+     */
+    QVector< Entry > intersects( const QgsRectangle &rectangle ) const;
+
+  private:
+
+    QgsPackedSpatialIndexFile() = default;
+
+    QFile mFile;
+    QString mSourcePath;
+    qint64 mSourceSize = 0;
+    qint64 mSourceModified = 0;
+
+    qint64 mCount = 0;
+    QgsRectangle mExtent;
+
+    //! Tree of the boxes of the mapped file
+    QgsPackedHilbertRTree mTree;
+
+    // pointers to the mapped file
+    uchar *mData = nullptr;
+    const qint64 *mIds = nullptr;
+    const qint64 *mOffsets = nullptr;
+};
+
+#endif // QGSPACKEDSPATIALINDEXFILE_H
@@ -21,6 +21,8 @@
 #include <QString>
 #include <QSet>
 #include <QRegularExpression>
+#include <QMutex>
+#include <QThread>
 
 #if PROJ_VERSION_MAJOR>=6
 #include <proj.h>
@@ -35,9 +37,33 @@ thread_local QgsProjContext QgsProjContext::sProjContext;
 QThreadStorage< QgsProjContext * > QgsProjContext::sProjContext;
 #endif
 
+#if PROJ_VERSION_MAJOR>=6
+///@cond PRIVATE
+struct QgsProjContextPool
+{
+  QMutex mutex;
+  QList< PJ_CONTEXT * > contexts;
+  int maximumSize = std::max( 2, QThread::idealThreadCount() * 2 );
+  bool disabled = false;
+};
+///@endcond
+
+Q_GLOBAL_STATIC( QgsProjContextPool, sProjContextPool )
+#endif
+
 QgsProjContext::QgsProjContext()
 {
 #if PROJ_VERSION_MAJOR>=6
+  if ( QgsProjContextPool *pool = sProjContextPool() )
+  {
+    QMutexLocker locker( &pool->mutex );
+    if ( !pool->contexts.isEmpty() )
+    {
+      // most recently released context first, it is the most likely to hold the proj objects needed now
+      mContext = pool->contexts.takeLast();
+      return;
+    }
+  }
   mContext = proj_context_create();
 #else
   mContext = pj_ctx_alloc();
@@ -47,6 +73,17 @@ QgsProjContext::QgsProjContext()
 QgsProjContext::~QgsProjContext()
 {
 #if PROJ_VERSION_MAJOR>=6
+  if ( QgsProjContextPool *pool = sProjContextPool() )
+  {
+    QMutexLocker locker( &pool->mutex );
+    if ( !pool->disabled && pool->contexts.size() < pool->maximumSize )
+    {
+      // keep the context, along with the proj objects cached for it, for the next thread
+      pool->contexts << mContext;
+      return;
+    }
+  }
+
   // Call removeFromCacheObjectsBelongingToCurrentThread() before
   // destroying the context
   QgsCoordinateTransform::removeFromCacheObjectsBelongingToCurrentThread( mContext );
@@ -76,6 +113,59 @@ PJ_CONTEXT *QgsProjContext::get()
 #endif
 }
 
+void QgsProjContext::setMaximumPoolSize( int size )
+{
+#if PROJ_VERSION_MAJOR>=6
+  QList< PJ_CONTEXT * > removed;
+  if ( QgsProjContextPool *pool = sProjContextPool() )
+  {
+    QMutexLocker locker( &pool->mutex );
+    pool->maximumSize = std::max( 0, size );
+    while ( pool->contexts.size() > pool->maximumSize )
+      removed << pool->contexts.takeFirst();
+  }
+  for ( PJ_CONTEXT *context : qgis::as_const( removed ) )
+  {
+    QgsCoordinateTransform::removeFromCacheObjectsBelongingToCurrentThread( context );
+    QgsCoordinateReferenceSystem::removeFromCacheObjectsBelongingToCurrentThread( context );
+    proj_context_destroy( context );
+  }
+#else
+  Q_UNUSED( size )
+#endif
+}
+
+int QgsProjContext::maximumPoolSize()
+{
+#if PROJ_VERSION_MAJOR>=6
+  if ( QgsProjContextPool *pool = sProjContextPool() )
+  {
+    QMutexLocker locker( &pool->mutex );
+    return pool->maximumSize;
+  }
+#endif
+  return 0;
+}
+
+void QgsProjContext::clearPool()
+{
+#if PROJ_VERSION_MAJOR>=6
+  QList< PJ_CONTEXT * > removed;
+  if ( QgsProjContextPool *pool = sProjContextPool() )
+  {
+    QMutexLocker locker( &pool->mutex );
+    pool->disabled = true;
+    removed.swap( pool->contexts );
+  }
+  for ( PJ_CONTEXT *context : qgis::as_const( removed ) )
+  {
+    QgsCoordinateTransform::removeFromCacheObjectsBelongingToCurrentThread( context );
+    QgsCoordinateReferenceSystem::removeFromCacheObjectsBelongingToCurrentThread( context );
+    proj_context_destroy( context );
+  }
+#endif
+}
+
 #if PROJ_VERSION_MAJOR>=6
 void QgsProjUtils::ProjPJDeleter::operator()( PJ *object )
 {
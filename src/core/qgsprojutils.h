@@ -173,6 +173,38 @@ class CORE_EXPORT QgsProjContext
      */
     static PJ_CONTEXT *get();
 
+    /**
+     * Sets the maximum number of proj contexts which are kept in a process wide pool
+     * when the thread which owned them finishes.
+     *
+     * Pooled contexts are handed to new threads together with all the proj objects which were
+     * already created for them, so that short lived worker threads (e.g. rendering or server
+     * request threads) do not have to create the same coordinate operations over and over.
+     *
+     * \see maximumPoolSize()
+     * \since QGIS 3.18
+     */
+    static void setMaximumPoolSize( int size );
+
+    /**
+     * Returns the maximum number of proj contexts which are kept in the context pool.
+     *
+     * \see setMaximumPoolSize()
+     * \since QGIS 3.18
+     */
+    static int maximumPoolSize();
+
+    /**
+     * Destroys all pooled proj contexts, and disables the pool so that contexts are destroyed
+     * as soon as their thread finishes from now on.
+     *
+     * This is called when QGIS exits, before the coordinate transform and reference system caches
+     * are invalidated.
+     *
+     * \since QGIS 3.18
+     */
+    static void clearPool();
+
   private:
     PJ_CONTEXT *mContext = nullptr;
 
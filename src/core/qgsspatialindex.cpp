@@ -23,11 +23,16 @@
 #include "qgsfeaturesource.h"
 #include "qgsfeedback.h"
 #include "qgsspatialindexutils.h"
+#include "qgspackedhilbertrtree.h"
 
 #include <spatialindex/SpatialIndex.h>
 #include <QMutex>
 #include <QMutexLocker>
 
+#include <algorithm>
+#include <cmath>
+#include <queue>
+
 using namespace SpatialIndex;
 
 
@@ -238,6 +243,135 @@ class QgsFeatureIteratorDataStream : public IDataStream
 };
 
 
+/**
+ * \ingroup core
+ * \class QgsStaticRTree
+ * \brief A flat, packed and immutable R-tree, used by spatial indexes built with QgsSpatialIndex::FlagStaticIndex.
+ *
+ * The features are stored in a QgsPackedHilbertRTree, which is built by several threads for large numbers of features.
+ *
+ * \note not available in Python bindings
+*/
+class QgsStaticRTree
+{
+  public:
+
+    struct Item
+    {
+      QgsFeatureId id;
+      QgsRectangle bounds;
+    };
+
+    explicit QgsStaticRTree( const std::vector< Item > &items )
+    {
+      std::vector< double > boxes( items.size() * 4 );
+      for ( std::size_t i = 0; i < items.size(); ++i )
+      {
+        const QgsRectangle &bounds = items[i].bounds;
+        boxes[i * 4] = bounds.xMinimum();
+        boxes[i * 4 + 1] = bounds.yMinimum();
+        boxes[i * 4 + 2] = bounds.xMaximum();
+        boxes[i * 4 + 3] = bounds.yMaximum();
+      }
+      mTree = QgsPackedHilbertRTree( boxes );
+
+      const std::vector< std::size_t > &order = mTree.leafOrder();
+      mIds.resize( items.size() );
+      for ( std::size_t i = 0; i < items.size(); ++i )
+        mIds[i] = items[order[i]].id;
+    }
+
+    QList<QgsFeatureId> intersects( const QgsRectangle &rect ) const
+    {
+      QList<QgsFeatureId> list;
+      mTree.intersects( rect, [this, &list]( std::size_t position )
+      {
+        list.append( mIds[position] );
+        return true;
+      } );
+      return list;
+    }
+
+    /**
+     * Returns the nearest neighbors of the \a query rectangle, with the same results as the nearest neighbor
+     * queries of libspatialindex: features with the same distance as the last neighbor are also returned.
+     *
+     * If \a geometries is set, the distances to the features are computed from their stored geometries and \a queryGeometry.
+     */
+    QList<QgsFeatureId> nearestNeighbor( const QgsRectangle &query, int neighbors, double maxDistance,
+                                         const QHash< QgsFeatureId, QgsGeometry > *geometries, const QgsGeometry &queryGeometry ) const
+    {
+      QList<QgsFeatureId> list;
+      if ( mIds.empty() )
+        return list;
+
+      struct Candidate
+      {
+        double distance;
+        std::size_t position;
+        std::size_t level;
+        bool exact;
+
+        bool operator>( const Candidate &other ) const { return distance > other.distance; }
+      };
+      std::priority_queue< Candidate, std::vector< Candidate >, std::greater< Candidate > > queue;
+
+      const double *boxes = mTree.boxes();
+      auto boxDistance = [boxes, &query]( std::size_t position )
+      {
+        const double *box = boxes + position * 4;
+        const double dx = std::max( { box[0] - query.xMaximum(), query.xMinimum() - box[2], 0.0 } );
+        const double dy = std::max( { box[1] - query.yMaximum(), query.yMinimum() - box[3], 0.0 } );
+        return std::sqrt( dx * dx + dy * dy );
+      };
+
+      const std::vector< std::size_t > &levelBounds = mTree.levelBounds();
+      const std::size_t root = mTree.nodeCount() - 1;
+      queue.push( { boxDistance( root ), root, levelBounds.size() - 1, false } );
+
+      int count = 0;
+      double lastDistance = 0;
+      while ( !queue.empty() )
+      {
+        const Candidate candidate = queue.top();
+
+        // all the remaining candidates are further than the last neighbor or the maximum distance
+        if ( ( count >= neighbors && candidate.distance > lastDistance ) || ( maxDistance > 0 && candidate.distance > maxDistance ) )
+          break;
+
+        queue.pop();
+
+        if ( candidate.level > 0 )
+        {
+          const std::size_t first = mTree.firstChild( candidate.position, candidate.level );
+          const std::size_t end = std::min( first + QgsPackedHilbertRTree::NODE_SIZE, levelBounds[candidate.level - 1] );
+          for ( std::size_t child = first; child < end; ++child )
+            queue.push( { boxDistance( child ), child, candidate.level - 1, false } );
+        }
+        else if ( geometries && !candidate.exact )
+        {
+          // the distance to the geometry is at least the distance to its bounding box
+          const double distance = geometries->value( mIds[candidate.position] ).distance( queryGeometry );
+          queue.push( { distance, candidate.position, 0, true } );
+        }
+        else
+        {
+          list.append( mIds[candidate.position] );
+          lastDistance = candidate.distance;
+          count++;
+        }
+      }
+      return list;
+    }
+
+  private:
+
+    QgsPackedHilbertRTree mTree;
+
+    //! Feature ids of the leaves of the tree
+    std::vector< QgsFeatureId > mIds;
+};
+
 /**
  * \ingroup core
  * \class QgsSpatialIndexData
@@ -269,6 +403,12 @@ class QgsSpatialIndexData : public QSharedData
                                   const std::function< bool( const QgsFeature & ) > *callback = nullptr )
       : mFlags( flags )
     {
+      if ( flags & QgsSpatialIndex::FlagStaticIndex )
+      {
+        initStaticTree( fi, feedback, callback );
+        return;
+      }
+
       QgsFeatureIteratorDataStream fids( fi, feedback, mFlags, callback );
       initTree( &fids );
       if ( flags & QgsSpatialIndex::FlagStoreFeatureGeometries )
@@ -279,7 +419,12 @@ class QgsSpatialIndexData : public QSharedData
       : QSharedData( other )
       , mFlags( other.mFlags )
       , mGeometries( other.mGeometries )
+      , mStaticTree( other.mStaticTree )
     {
+      // static trees are never modified, so they can be shared
+      if ( mStaticTree )
+        return;
+
       QMutexLocker locker( &other.mMutex );
 
       initTree();
@@ -323,12 +468,41 @@ class QgsSpatialIndexData : public QSharedData
                                         leafCapacity, dimension, variant, indexId );
     }
 
+    void initStaticTree( QgsFeatureIterator fi, QgsFeedback *feedback, const std::function< bool( const QgsFeature & ) > *callback )
+    {
+      std::vector< QgsStaticRTree::Item > items;
+      QgsFeature f;
+      while ( fi.nextFeature( f ) )
+      {
+        if ( feedback && feedback->isCanceled() )
+          break;
+
+        if ( callback && !( *callback )( f ) )
+          break;
+
+        if ( !f.hasGeometry() )
+          continue;
+
+        const QgsRectangle rect = f.geometry().boundingBox();
+        if ( !rect.isFinite() )
+          continue;
+
+        items.push_back( { f.id(), rect } );
+        if ( mFlags & QgsSpatialIndex::FlagStoreFeatureGeometries )
+          mGeometries.insert( f.id(), f.geometry() );
+      }
+      mStaticTree = std::make_shared< const QgsStaticRTree >( items );
+    }
+
     //! Storage manager
     SpatialIndex::IStorageManager *mStorage = nullptr;
 
     //! R-tree containing spatial index
     SpatialIndex::ISpatialIndex *mRTree = nullptr;
 
+    //! Packed tree used instead of the R-tree for indexes built with FlagStaticIndex
+    std::shared_ptr< const QgsStaticRTree > mStaticTree;
+
     mutable QMutex mMutex;
 
 };
@@ -443,6 +617,9 @@ bool QgsSpatialIndex::insertFeature( QgsFeatureId id, const QgsRectangle &bounds
 
 bool QgsSpatialIndex::addFeature( QgsFeatureId id, const QgsRectangle &bounds )
 {
+  if ( d.constData()->mStaticTree )
+    return false;
+
   SpatialIndex::Region r( QgsSpatialIndexUtils::rectangleToRegion( bounds ) );
 
   QMutexLocker locker( &d->mMutex );
@@ -473,6 +650,9 @@ bool QgsSpatialIndex::addFeature( QgsFeatureId id, const QgsRectangle &bounds )
 
 bool QgsSpatialIndex::deleteFeature( const QgsFeature &f )
 {
+  if ( d.constData()->mStaticTree )
+    return false;
+
   SpatialIndex::Region r;
   QgsFeatureId id;
   if ( !featureInfo( f, r, id ) )
@@ -487,6 +667,9 @@ bool QgsSpatialIndex::deleteFeature( const QgsFeature &f )
 
 QList<QgsFeatureId> QgsSpatialIndex::intersects( const QgsRectangle &rect ) const
 {
+  if ( d->mStaticTree )
+    return d->mStaticTree->intersects( rect );
+
   QList<QgsFeatureId> list;
   QgisVisitor visitor( list );
 
@@ -500,6 +683,13 @@ QList<QgsFeatureId> QgsSpatialIndex::intersects( const QgsRectangle &rect ) cons
 
 QList<QgsFeatureId> QgsSpatialIndex::nearestNeighbor( const QgsPointXY &point, const int neighbors, const double maxDistance ) const
 {
+  if ( d->mStaticTree )
+  {
+    const bool useGeometries = d->mFlags & QgsSpatialIndex::FlagStoreFeatureGeometries;
+    return d->mStaticTree->nearestNeighbor( QgsRectangle( point.x(), point.y(), point.x(), point.y() ), neighbors, maxDistance,
+                                            useGeometries ? &d->mGeometries : nullptr, useGeometries ? QgsGeometry::fromPointXY( point ) : QgsGeometry() );
+  }
+
   QList<QgsFeatureId> list;
   QgisVisitor visitor( list );
 
@@ -526,6 +716,12 @@ QList<QgsFeatureId> QgsSpatialIndex::nearestNeighbor( const QgsPointXY &point, c
 
 QList<QgsFeatureId> QgsSpatialIndex::nearestNeighbor( const QgsGeometry &geometry, int neighbors, double maxDistance ) const
 {
+  if ( d->mStaticTree )
+  {
+    return d->mStaticTree->nearestNeighbor( geometry.boundingBox(), neighbors, maxDistance,
+                                            ( d->mFlags & QgsSpatialIndex::FlagStoreFeatureGeometries ) ? &d->mGeometries : nullptr, geometry );
+  }
+
   QList<QgsFeatureId> list;
   QgisVisitor visitor( list );
 
@@ -75,6 +75,7 @@ class CORE_EXPORT QgsSpatialIndex : public QgsFeatureSink
     enum Flag
     {
       FlagStoreFeatureGeometries = 1 << 0, //!< Indicates that the spatial index should also store feature geometries. This requires more memory, but can speed up operations by avoiding additional requests to data providers to fetch matching feature geometries. Additionally, it is required for non-bounding box nearest neighbor searches.
+      FlagStaticIndex = 1 << 1, //!< Indicates that the index is bulk loaded by its constructor and never modified afterwards. A flat, packed index is then built, which is faster to build and to query, but addFeature() and deleteFeature() always fail. This flag is ignored when creating an empty index. Since QGIS 3.18.
     };
     Q_DECLARE_FLAGS( Flags, Flag )
 
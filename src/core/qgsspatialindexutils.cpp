@@ -23,3 +23,59 @@ SpatialIndex::Region QgsSpatialIndexUtils::rectangleToRegion( const QgsRectangle
   double pt2[2] = { rectangle.xMaximum(), rectangle.yMaximum() };
   return SpatialIndex::Region( pt1, pt2, 2 );
 }
+
+quint32 QgsSpatialIndexUtils::hilbertValue( quint32 x, quint32 y )
+{
+  quint32 a = x ^ y;
+  quint32 b = 0xFFFF ^ a;
+  quint32 c = 0xFFFF ^ ( x | y );
+  quint32 d = x & ( y ^ 0xFFFF );
+
+  quint32 A = a | ( b >> 1 );
+  quint32 B = ( a >> 1 ) ^ a;
+  quint32 C = ( ( c >> 1 ) ^ ( b & ( d >> 1 ) ) ) ^ c;
+  quint32 D = ( ( a & ( c >> 1 ) ) ^ ( d >> 1 ) ) ^ d;
+
+  a = A;
+  b = B;
+  c = C;
+  d = D;
+  A = ( ( a & ( a >> 2 ) ) ^ ( b & ( b >> 2 ) ) );
+  B = ( ( a & ( b >> 2 ) ) ^ ( b & ( ( a ^ b ) >> 2 ) ) );
+  C ^= ( ( a & ( c >> 2 ) ) ^ ( b & ( d >> 2 ) ) );
+  D ^= ( ( b & ( c >> 2 ) ) ^ ( ( a ^ b ) & ( d >> 2 ) ) );
+
+  a = A;
+  b = B;
+  c = C;
+  d = D;
+  A = ( ( a & ( a >> 4 ) ) ^ ( b & ( b >> 4 ) ) );
+  B = ( ( a & ( b >> 4 ) ) ^ ( b & ( ( a ^ b ) >> 4 ) ) );
+  C ^= ( ( a & ( c >> 4 ) ) ^ ( b & ( d >> 4 ) ) );
+  D ^= ( ( b & ( c >> 4 ) ) ^ ( ( a ^ b ) & ( d >> 4 ) ) );
+
+  a = A;
+  b = B;
+  c = C;
+  d = D;
+  C ^= ( ( a & ( c >> 8 ) ) ^ ( b & ( d >> 8 ) ) );
+  D ^= ( ( b & ( c >> 8 ) ) ^ ( ( a ^ b ) & ( d >> 8 ) ) );
+
+  a = C ^ ( C >> 1 );
+  b = D ^ ( D >> 1 );
+
+  quint32 i0 = x ^ y;
+  quint32 i1 = b | ( 0xFFFF ^ ( i0 | a ) );
+
+  i0 = ( i0 | ( i0 << 8 ) ) & 0x00FF00FF;
+  i0 = ( i0 | ( i0 << 4 ) ) & 0x0F0F0F0F;
+  i0 = ( i0 | ( i0 << 2 ) ) & 0x33333333;
+  i0 = ( i0 | ( i0 << 1 ) ) & 0x55555555;
+
+  i1 = ( i1 | ( i1 << 8 ) ) & 0x00FF00FF;
+  i1 = ( i1 | ( i1 << 4 ) ) & 0x0F0F0F0F;
+  i1 = ( i1 | ( i1 << 2 ) ) & 0x33333333;
+  i1 = ( i1 | ( i1 << 1 ) ) & 0x55555555;
+
+  return ( i1 << 1 ) | i0;
+}
@@ -17,6 +17,7 @@
 #define QGSSPATIALINDEXUTILS_H
 
 #include "qgis_core.h"
+#include <QtGlobal>
 #define SIP_NO_FILE
 
 class QgsRectangle;
@@ -55,6 +56,17 @@ class CORE_EXPORT QgsSpatialIndexUtils
      */
     static SpatialIndex::Region rectangleToRegion( const QgsRectangle &rectangle );
 
+    /**
+     * Returns the position of the point at (\a x, \a y) along a Hilbert curve filling a grid of
+     * 65536 by 65536 cells.
+     *
+     * Sorting boxes by the Hilbert value of their center keeps boxes which are close to each other
+     * together, which is used to pack static spatial indexes.
+     *
+     * \since QGIS 3.18
+     */
+    static quint32 hilbertValue( quint32 x, quint32 y );
+
 };
 
 #endif // QGSSPATIALINDEXUTILS_H
@@ -29,6 +29,8 @@
 #include <QByteArray>
 #include <QVariant>
 
+#include <algorithm>
+
 #define ERR(message) QgsError(message, "Raster provider")
 
 void QgsRasterDataProvider::setUseSourceNoDataValue( int bandNo, bool use )
@@ -40,6 +42,18 @@ void QgsRasterDataProvider::setUseSourceNoDataValue( int bandNo, bool use )
       mUseSrcNoDataValue.append( false );
     }
   }
+  if ( mUseSrcNoDataValue[bandNo - 1] != use )
+  {
+    // the statistics of the band were computed with other no data values
+    mStatistics.erase( std::remove_if( mStatistics.begin(), mStatistics.end(), [bandNo]( const QgsRasterBandStats & stats )
+    {
+      return stats.bandNumber == bandNo;
+    } ), mStatistics.end() );
+    mHistograms.erase( std::remove_if( mHistograms.begin(), mHistograms.end(), [bandNo]( const QgsRasterHistogram & histogram )
+    {
+      return histogram.bandNumber == bandNo;
+    } ), mHistograms.end() );
+  }
   mUseSrcNoDataValue[bandNo - 1] = use;
 }
 
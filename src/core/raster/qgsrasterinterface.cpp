@@ -21,6 +21,8 @@
 #include <QByteArray>
 #include <QTime>
 #include <QStringList>
+#include <QThread>
+#include <QtConcurrentMap>
 
 #include "qgslogger.h"
 #include "qgsrasterbandstats.h"
@@ -33,6 +35,64 @@ QgsRasterInterface::QgsRasterInterface( QgsRasterInterface *input )
 {
 }
 
+///@cond PRIVATE
+
+/**
+ * Reduces the \a blockCount blocks returned by \a readBlock with \a reduce, then passes
+ * the partial results to \a merge in the order of the blocks.
+ *
+ * Blocks are read serially, as interfaces are not thread safe, and reduced concurrently
+ * by batches, while the next batch is read. Returns FALSE if canceled.
+ */
+template <typename Partial, typename ReadBlock, typename Reduce, typename Merge>
+static bool reduceBlocks( int blockCount, ReadBlock readBlock, Reduce reduce, Merge merge, QgsRasterBlockFeedback *feedback )
+{
+  struct Task
+  {
+    std::unique_ptr< QgsRasterBlock > block;
+    Partial partial;
+  };
+
+  const int batchSize = 2 * std::max( 1, QThread::idealThreadCount() );
+  auto readBatch = [&]( int firstBlock )
+  {
+    std::vector< Task > batch( std::min( batchSize, blockCount - firstBlock ) );
+    for ( std::size_t i = 0; i < batch.size(); ++i )
+    {
+      if ( feedback && feedback->isCanceled() )
+        break;
+      batch[i].block.reset( readBlock( firstBlock + static_cast< int >( i ) ) );
+    }
+    return batch;
+  };
+  auto reduceTask = [&reduce]( Task & task )
+  {
+    if ( task.block )
+      reduce( *task.block, task.partial );
+  };
+
+  std::vector< Task > batch = readBatch( 0 );
+  for ( int firstBlock = 0; firstBlock < blockCount; firstBlock += batchSize )
+  {
+    QFuture< void > reduction = QtConcurrent::map( batch, reduceTask );
+    std::vector< Task > nextBatch;
+    if ( firstBlock + batchSize < blockCount )
+      nextBatch = readBatch( firstBlock + batchSize );
+    reduction.waitForFinished();
+
+    if ( feedback && feedback->isCanceled() )
+      return false;
+
+    // merged in the order of the blocks, so that results do not depend on the scheduling
+    for ( const Task &task : batch )
+      merge( task.partial );
+    batch = std::move( nextBatch );
+  }
+  return true;
+}
+
+///@endcond
+
 void QgsRasterInterface::initStatistics( QgsRasterBandStats &statistics,
     int bandNo,
     int stats,
@@ -159,69 +219,92 @@ QgsRasterBandStats QgsRasterInterface::bandStatistics( int bandNo,
   double myYRes = myExtent.height() / myHeight;
   // TODO: progress signals
 
-  // used by single pass stdev
-  double myMean = 0;
-  double mySumOfSquares = 0;
-
-  bool myFirstIterationFlag = true;
-  bool isNoData = false;
-  for ( int myYBlock = 0; myYBlock < myNYBlocks; myYBlock++ )
+  // Partial statistics of a block, merged with the parallel form of the single pass stdev
+  struct StatisticsPartial
   {
-    for ( int myXBlock = 0; myXBlock < myNXBlocks; myXBlock++ )
+    double sum = 0;
+    qgssize elementCount = 0;
+    //! Number of finite values, used by min, max, mean and sum of squares
+    qgssize finiteCount = 0;
+    double minimum = std::numeric_limits<double>::max();
+    double maximum = std::numeric_limits<double>::lowest();
+    double mean = 0;
+    double sumOfSquares = 0;
+  };
+
+  auto readBlock = [&]( int blockIndex ) -> QgsRasterBlock *
+  {
+    const int myYBlock = blockIndex / myNXBlocks;
+    const int myXBlock = blockIndex % myNXBlocks;
+    QgsDebugMsgLevel( QStringLiteral( "myYBlock = %1 myXBlock = %2" ).arg( myYBlock ).arg( myXBlock ), 4 );
+    int myBlockWidth = std::min( myXBlockSize, myWidth - myXBlock * myXBlockSize );
+    int myBlockHeight = std::min( myYBlockSize, myHeight - myYBlock * myYBlockSize );
+
+    double xmin = myExtent.xMinimum() + myXBlock * myXBlockSize * myXRes;
+    double xmax = xmin + myBlockWidth * myXRes;
+    double ymin = myExtent.yMaximum() - myYBlock * myYBlockSize * myYRes;
+    double ymax = ymin - myBlockHeight * myYRes;
+
+    QgsRectangle myPartExtent( xmin, ymin, xmax, ymax );
+    return block( bandNo, myPartExtent, myBlockWidth, myBlockHeight, feedback );
+  };
+
+  auto reduce = []( const QgsRasterBlock & blk, StatisticsPartial & partial )
+  {
+    bool isNoData = false;
+    const qgssize count = static_cast< qgssize >( blk.height() ) * blk.width();
+    for ( qgssize i = 0; i < count; i++ )
     {
-      if ( feedback && feedback->isCanceled() )
-        return myRasterBandStats;
-
-      QgsDebugMsgLevel( QStringLiteral( "myYBlock = %1 myXBlock = %2" ).arg( myYBlock ).arg( myXBlock ), 4 );
-      int myBlockWidth = std::min( myXBlockSize, myWidth - myXBlock * myXBlockSize );
-      int myBlockHeight = std::min( myYBlockSize, myHeight - myYBlock * myYBlockSize );
+      double myValue = blk.valueAndNoData( i, isNoData );
+      if ( isNoData )
+        continue; // NULL
 
-      double xmin = myExtent.xMinimum() + myXBlock * myXBlockSize * myXRes;
-      double xmax = xmin + myBlockWidth * myXRes;
-      double ymin = myExtent.yMaximum() - myYBlock * myYBlockSize * myYRes;
-      double ymax = ymin - myBlockHeight * myYRes;
+      partial.sum += myValue;
+      partial.elementCount++;
 
-      QgsRectangle myPartExtent( xmin, ymin, xmax, ymax );
+      if ( !std::isfinite( myValue ) ) continue; // inf
 
-      std::unique_ptr< QgsRasterBlock > blk( block( bandNo, myPartExtent, myBlockWidth, myBlockHeight, feedback ) );
+      partial.minimum = std::min( partial.minimum, myValue );
+      partial.maximum = std::max( partial.maximum, myValue );
 
-      // Collect the histogram counts.
-      for ( qgssize i = 0; i < ( static_cast< qgssize >( myBlockHeight ) ) * myBlockWidth; i++ )
-      {
-        double myValue = blk->valueAndNoData( i, isNoData );
-        if ( isNoData )
-          continue; // NULL
-
-        myRasterBandStats.sum += myValue;
-        myRasterBandStats.elementCount++;
-
-        if ( !std::isfinite( myValue ) ) continue; // inf
-
-        if ( myFirstIterationFlag )
-        {
-          myFirstIterationFlag = false;
-          myRasterBandStats.minimumValue = myValue;
-          myRasterBandStats.maximumValue = myValue;
-        }
-        else
-        {
-          if ( myValue < myRasterBandStats.minimumValue )
-          {
-            myRasterBandStats.minimumValue = myValue;
-          }
-          if ( myValue > myRasterBandStats.maximumValue )
-          {
-            myRasterBandStats.maximumValue = myValue;
-          }
-        }
-
-        // Single pass stdev
-        double myDelta = myValue - myMean;
-        myMean += myDelta / myRasterBandStats.elementCount;
-        mySumOfSquares += myDelta * ( myValue - myMean );
-      }
+      // Single pass stdev
+      partial.finiteCount++;
+      double myDelta = myValue - partial.mean;
+      partial.mean += myDelta / partial.finiteCount;
+      partial.sumOfSquares += myDelta * ( myValue - partial.mean );
     }
+  };
+
+  StatisticsPartial total;
+  auto merge = [&total]( const StatisticsPartial & partial )
+  {
+    total.sum += partial.sum;
+    total.elementCount += partial.elementCount;
+    if ( partial.finiteCount == 0 )
+      return;
+
+    total.minimum = std::min( total.minimum, partial.minimum );
+    total.maximum = std::max( total.maximum, partial.maximum );
+
+    // Chan et al. combination of the means and sums of squares of two sets of values
+    const qgssize count = total.finiteCount + partial.finiteCount;
+    const double delta = partial.mean - total.mean;
+    total.mean += delta * partial.finiteCount / count;
+    total.sumOfSquares += partial.sumOfSquares + delta * delta * total.finiteCount * partial.finiteCount / count;
+    total.finiteCount = count;
+  };
+
+  if ( !reduceBlocks< StatisticsPartial >( myNXBlocks * myNYBlocks, readBlock, reduce, merge, feedback ) )
+    return myRasterBandStats;
+
+  myRasterBandStats.sum = total.sum;
+  myRasterBandStats.elementCount = total.elementCount;
+  if ( total.finiteCount > 0 )
+  {
+    myRasterBandStats.minimumValue = total.minimum;
+    myRasterBandStats.maximumValue = total.maximum;
   }
+  const double mySumOfSquares = total.sumOfSquares;
 
   myRasterBandStats.range = myRasterBandStats.maximumValue - myRasterBandStats.minimumValue;
   myRasterBandStats.mean = myRasterBandStats.sum / myRasterBandStats.elementCount;
@@ -461,49 +544,66 @@ QgsRasterHistogram QgsRasterInterface::histogram( int bandNo,
   double myBinSize = ( myMaximum - myMinimum ) / myBinCount;
 
   // TODO: progress signals
-  bool isNoData = false;
-  for ( int myYBlock = 0; myYBlock < myNYBlocks; myYBlock++ )
+
+  // Partial histogram of a block, merged by summing the counts
+  struct HistogramPartial
   {
-    for ( int myXBlock = 0; myXBlock < myNXBlocks; myXBlock++ )
-    {
-      if ( feedback && feedback->isCanceled() )
-        return myHistogram;
+    QgsRasterHistogram::HistogramVector histogramVector;
+    int nonNullCount = 0;
+  };
 
-      int myBlockWidth = std::min( myXBlockSize, myWidth - myXBlock * myXBlockSize );
-      int myBlockHeight = std::min( myYBlockSize, myHeight - myYBlock * myYBlockSize );
+  auto readBlock = [&]( int blockIndex ) -> QgsRasterBlock *
+  {
+    const int myYBlock = blockIndex / myNXBlocks;
+    const int myXBlock = blockIndex % myNXBlocks;
+    int myBlockWidth = std::min( myXBlockSize, myWidth - myXBlock * myXBlockSize );
+    int myBlockHeight = std::min( myYBlockSize, myHeight - myYBlock * myYBlockSize );
 
-      double xmin = myExtent.xMinimum() + myXBlock * myXBlockSize * myXRes;
-      double xmax = xmin + myBlockWidth * myXRes;
-      double ymin = myExtent.yMaximum() - myYBlock * myYBlockSize * myYRes;
-      double ymax = ymin - myBlockHeight * myYRes;
+    double xmin = myExtent.xMinimum() + myXBlock * myXBlockSize * myXRes;
+    double xmax = xmin + myBlockWidth * myXRes;
+    double ymin = myExtent.yMaximum() - myYBlock * myYBlockSize * myYRes;
+    double ymax = ymin - myBlockHeight * myYRes;
 
-      QgsRectangle myPartExtent( xmin, ymin, xmax, ymax );
+    QgsRectangle myPartExtent( xmin, ymin, xmax, ymax );
+    return block( bandNo, myPartExtent, myBlockWidth, myBlockHeight, feedback );
+  };
 
-      std::unique_ptr< QgsRasterBlock > blk( block( bandNo, myPartExtent, myBlockWidth, myBlockHeight, feedback ) );
+  auto reduce = [myBinCount, myMinimum, myBinSize, includeOutOfRange]( const QgsRasterBlock & blk, HistogramPartial & partial )
+  {
+    partial.histogramVector.fill( 0, myBinCount );
+    bool isNoData = false;
+    const qgssize count = static_cast< qgssize >( blk.height() ) * blk.width();
+    for ( qgssize i = 0; i < count; i++ )
+    {
+      double myValue = blk.valueAndNoData( i, isNoData );
+      if ( isNoData )
+      {
+        continue; // NULL
+      }
 
-      // Collect the histogram counts.
-      for ( qgssize i = 0; i < ( static_cast< qgssize >( myBlockHeight ) ) * myBlockWidth; i++ )
+      int myBinIndex = static_cast <int>( std::floor( ( myValue - myMinimum ) /  myBinSize ) );
+
+      if ( ( myBinIndex < 0 || myBinIndex > ( myBinCount - 1 ) ) && !includeOutOfRange )
       {
-        double myValue = blk->valueAndNoData( i, isNoData );
-        if ( isNoData )
-        {
-          continue; // NULL
-        }
-
-        int myBinIndex = static_cast <int>( std::floor( ( myValue - myMinimum ) /  myBinSize ) );
-
-        if ( ( myBinIndex < 0 || myBinIndex > ( myBinCount - 1 ) ) && !includeOutOfRange )
-        {
-          continue;
-        }
-        if ( myBinIndex < 0 ) myBinIndex = 0;
-        if ( myBinIndex > ( myBinCount - 1 ) ) myBinIndex = myBinCount - 1;
-
-        myHistogram.histogramVector[myBinIndex] += 1;
-        myHistogram.nonNullCount++;
+        continue;
       }
+      if ( myBinIndex < 0 ) myBinIndex = 0;
+      if ( myBinIndex > ( myBinCount - 1 ) ) myBinIndex = myBinCount - 1;
+
+      partial.histogramVector[myBinIndex] += 1;
+      partial.nonNullCount++;
     }
-  }
+  };
+
+  auto merge = [&myHistogram]( const HistogramPartial & partial )
+  {
+    for ( int i = 0; i < partial.histogramVector.size(); ++i )
+      myHistogram.histogramVector[i] += partial.histogramVector.at( i );
+    myHistogram.nonNullCount += partial.nonNullCount;
+  };
+
+  if ( !reduceBlocks< HistogramPartial >( myNXBlocks * myNYBlocks, readBlock, reduce, merge, feedback ) )
+    return myHistogram;
 
   myHistogram.valid = true;
   mHistograms.append( myHistogram );
@@ -18,6 +18,8 @@
 #include "qgsrasterviewport.h"
 #include "qgsrasterdataprovider.h"
 
+#include <QtConcurrentRun>
+
 QgsRasterIterator::QgsRasterIterator( QgsRasterInterface *input )
   : mInput( input )
   , mMaximumTileWidth( DEFAULT_MAXIMUM_TILE_WIDTH )
@@ -30,11 +32,27 @@ QgsRasterIterator::QgsRasterIterator( QgsRasterInterface *input )
     {
       mMaximumTileWidth = rdp->stepWidth();
       mMaximumTileHeight = rdp->stepHeight();
+
+      // align tiles to the native blocks of the provider, so that each block is read once.
+      // Sizes are rounded up, so that there are never more tiles than with the step size
+      const int blockWidth = rdp->xBlockSize();
+      const int blockHeight = rdp->yBlockSize();
+      if ( blockWidth > 0 && blockWidth <= mMaximumTileWidth )
+        mMaximumTileWidth = ( mMaximumTileWidth + blockWidth - 1 ) / blockWidth * blockWidth;
+      if ( blockHeight > 0 && blockHeight <= mMaximumTileHeight )
+        mMaximumTileHeight = ( mMaximumTileHeight + blockHeight - 1 ) / blockHeight * blockHeight;
       break;
     }
   }
 }
 
+void QgsRasterIterator::setPrefetchEnabled( bool enabled )
+{
+  mPrefetchEnabled = enabled;
+  if ( !enabled )
+    mPrefetch.discard();
+}
+
 void QgsRasterIterator::startRasterRead( int bandNumber, qgssize nCols, qgssize nRows, const QgsRectangle &extent, QgsRasterBlockFeedback *feedback )
 {
   if ( !mInput )
@@ -47,6 +65,7 @@ void QgsRasterIterator::startRasterRead( int bandNumber, qgssize nCols, qgssize
 
   //remove any previous part on that band
   removePartInfo( bandNumber );
+  mPrefetch.discard();
 
   //split raster into small portions if necessary
   RasterPartInfo pInfo;
@@ -109,25 +128,26 @@ bool QgsRasterIterator::readNextRasterPartInternal( int bandNumber, int &nCols,
   }
 
   //read data block
-  nCols = static_cast< int >( std::min( static_cast< qgssize >( mMaximumTileWidth ), pInfo.nCols - pInfo.currentCol ) );
-  nRows = static_cast< int >( std::min( static_cast< qgssize >( mMaximumTileHeight ), pInfo.nRows - pInfo.currentRow ) );
+  QgsRectangle blockRect = partExtent( pInfo, nCols, nRows );
   QgsDebugMsgLevel( QStringLiteral( "nCols = %1 nRows = %2" ).arg( nCols ).arg( nRows ), 4 );
 
-  //get subrectangle
-  QgsRectangle viewPortExtent = mExtent;
-  double xmin = viewPortExtent.xMinimum() + pInfo.currentCol / static_cast< double >( pInfo.nCols ) * viewPortExtent.width();
-  double xmax = pInfo.currentCol + nCols == pInfo.nCols ? viewPortExtent.xMaximum() :  // avoid extra FP math if not necessary
-                viewPortExtent.xMinimum() + ( pInfo.currentCol + nCols ) / static_cast< double >( pInfo.nCols ) * viewPortExtent.width();
-  double ymin = pInfo.currentRow + nRows == pInfo.nRows ? viewPortExtent.yMinimum() :  // avoid extra FP math if not necessary
-                viewPortExtent.yMaximum() - ( pInfo.currentRow + nRows ) / static_cast< double >( pInfo.nRows ) * viewPortExtent.height();
-  double ymax = viewPortExtent.yMaximum() - pInfo.currentRow / static_cast< double >( pInfo.nRows ) * viewPortExtent.height();
-  QgsRectangle blockRect( xmin, ymin, xmax, ymax );
-
   if ( blockExtent )
     *blockExtent = blockRect;
 
   if ( block )
-    block->reset( mInput->block( bandNumber, blockRect, nCols, nRows, mFeedback ) );
+  {
+    if ( mPrefetch.pending && mPrefetch.bandNumber == bandNumber && mPrefetch.col == pInfo.currentCol && mPrefetch.row == pInfo.currentRow
+         && mPrefetch.width == nCols && mPrefetch.height == nRows )
+    {
+      block->reset( mPrefetch.block.result() );
+      mPrefetch.pending = false;
+    }
+    else
+    {
+      mPrefetch.discard();
+      block->reset( mInput->block( bandNumber, blockRect, nCols, nRows, mFeedback ) );
+    }
+  }
   topLeftCol = pInfo.currentCol;
   topLeftRow = pInfo.currentRow;
 
@@ -142,12 +162,52 @@ bool QgsRasterIterator::readNextRasterPartInternal( int bandNumber, int &nCols,
     pInfo.currentRow += nRows;
   }
 
+  // read the next part while the caller processes this one
+  if ( block && mPrefetchEnabled && !mPrefetch.pending && pInfo.currentRow < pInfo.nRows )
+  {
+    QgsRasterDataProvider *provider = dynamic_cast< QgsRasterDataProvider * >( mInput );
+    if ( provider && ( provider->providerCapabilities() & QgsRasterDataProvider::ThreadSafeRead ) )
+    {
+      int nextCols = 0;
+      int nextRows = 0;
+      const QgsRectangle nextRect = partExtent( pInfo, nextCols, nextRows );
+      QgsRasterBlockFeedback *feedback = mFeedback;
+      mPrefetch.pending = true;
+      mPrefetch.bandNumber = bandNumber;
+      mPrefetch.col = pInfo.currentCol;
+      mPrefetch.row = pInfo.currentRow;
+      mPrefetch.width = nextCols;
+      mPrefetch.height = nextRows;
+      mPrefetch.block = QtConcurrent::run( [provider, bandNumber, nextRect, nextCols, nextRows, feedback]
+      {
+        return provider->block( bandNumber, nextRect, nextCols, nextRows, feedback );
+      } );
+    }
+  }
+
   return true;
 }
 
+QgsRectangle QgsRasterIterator::partExtent( const RasterPartInfo &pInfo, int &nCols, int &nRows ) const
+{
+  nCols = static_cast< int >( std::min( static_cast< qgssize >( mMaximumTileWidth ), pInfo.nCols - pInfo.currentCol ) );
+  nRows = static_cast< int >( std::min( static_cast< qgssize >( mMaximumTileHeight ), pInfo.nRows - pInfo.currentRow ) );
+
+  //get subrectangle
+  QgsRectangle viewPortExtent = mExtent;
+  double xmin = viewPortExtent.xMinimum() + pInfo.currentCol / static_cast< double >( pInfo.nCols ) * viewPortExtent.width();
+  double xmax = pInfo.currentCol + nCols == pInfo.nCols ? viewPortExtent.xMaximum() :  // avoid extra FP math if not necessary
+                viewPortExtent.xMinimum() + ( pInfo.currentCol + nCols ) / static_cast< double >( pInfo.nCols ) * viewPortExtent.width();
+  double ymin = pInfo.currentRow + nRows == pInfo.nRows ? viewPortExtent.yMinimum() :  // avoid extra FP math if not necessary
+                viewPortExtent.yMaximum() - ( pInfo.currentRow + nRows ) / static_cast< double >( pInfo.nRows ) * viewPortExtent.height();
+  double ymax = viewPortExtent.yMaximum() - pInfo.currentRow / static_cast< double >( pInfo.nRows ) * viewPortExtent.height();
+  return QgsRectangle( xmin, ymin, xmax, ymax );
+}
+
 void QgsRasterIterator::stopRasterRead( int bandNumber )
 {
   removePartInfo( bandNumber );
+  mPrefetch.discard();
 }
 
 void QgsRasterIterator::removePartInfo( int bandNumber )
@@ -158,3 +218,28 @@ void QgsRasterIterator::removePartInfo( int bandNumber )
     mRasterPartInfos.remove( bandNumber );
   }
 }
+
+///@cond PRIVATE
+
+QgsRasterIterator::Prefetch &QgsRasterIterator::Prefetch::operator=( const Prefetch & )
+{
+  discard();
+  return *this;
+}
+
+QgsRasterIterator::Prefetch::~Prefetch()
+{
+  discard();
+}
+
+void QgsRasterIterator::Prefetch::discard()
+{
+  if ( !pending )
+    return;
+
+  // the block is read from the input, which must outlive the read
+  delete block.result();
+  pending = false;
+}
+
+///@endcond
@@ -19,6 +19,7 @@
 #include "qgsrectangle.h"
 #include "qgis_sip.h"
 #include <QMap>
+#include <QFuture>
 
 class QgsMapToPixel;
 class QgsRasterBlock;
@@ -37,6 +38,10 @@ class CORE_EXPORT QgsRasterIterator
 
     /**
      * Constructor for QgsRasterIterator, iterating over the specified \a input raster source.
+     *
+     * Since QGIS 3.18, the default maximum tile size is the step size of the data provider of the input
+     * rounded up to a multiple of its native block size, so that tiles read at the native resolution
+     * of the provider, from the origin of its extent, cover whole blocks.
      */
     QgsRasterIterator( QgsRasterInterface *input );
 
@@ -144,6 +149,27 @@ class CORE_EXPORT QgsRasterIterator
      */
     int maximumTileHeight() const { return mMaximumTileHeight; }
 
+    /**
+     * Sets whether the next part of the raster is read in advance, on a worker thread, while
+     * the part returned by readNextRasterPart() is processed.
+     *
+     * Parts are only read in advance if the input is a data provider with the
+     * QgsRasterDataProvider::ThreadSafeRead capability. The input should not be read by other
+     * means during the iteration.
+     *
+     * \see isPrefetchEnabled()
+     * \since QGIS 3.18
+     */
+    void setPrefetchEnabled( bool enabled );
+
+    /**
+     * Returns TRUE if the next part of the raster is read in advance.
+     *
+     * \see setPrefetchEnabled()
+     * \since QGIS 3.18
+     */
+    bool isPrefetchEnabled() const { return mPrefetchEnabled; }
+
     //! Default maximum tile width
     static const int DEFAULT_MAXIMUM_TILE_WIDTH = 2000;
 
@@ -168,9 +194,39 @@ class CORE_EXPORT QgsRasterIterator
     int mMaximumTileWidth;
     int mMaximumTileHeight;
 
+#ifndef SIP_RUN
+
+    //! A part of the raster being read in advance
+    struct Prefetch
+    {
+      Prefetch() = default;
+      //! Copies of an iterator do not share the part it reads in advance
+      Prefetch( const Prefetch & ) {}
+      Prefetch &operator=( const Prefetch & );
+      ~Prefetch();
+
+      //! Waits for the read to finish and deletes its block
+      void discard();
+
+      bool pending = false;
+      int bandNumber = -1;
+      qgssize col = 0;
+      qgssize row = 0;
+      int width = 0;
+      int height = 0;
+      QFuture< QgsRasterBlock * > block;
+    };
+
+    bool mPrefetchEnabled = false;
+    Prefetch mPrefetch;
+#endif
+
     //! Remove part into and release memory
     void removePartInfo( int bandNumber );
     bool readNextRasterPartInternal( int bandNumber, int &nCols, int &nRows, std::unique_ptr<QgsRasterBlock> *block, int &topLeftCol, int &topLeftRow, QgsRectangle *blockExtent );
+
+    //! Returns the extent and size of the part of the raster starting at the current position of \a info
+    QgsRectangle partExtent( const RasterPartInfo &info, int &nCols, int &nRows ) const;
 };
 
 #endif // QGSRASTERITERATOR_H
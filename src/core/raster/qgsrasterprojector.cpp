@@ -22,6 +22,8 @@
 #include "qgscoordinatetransform.h"
 #include "qgsexception.h"
 
+#include <QtConcurrentMap>
+
 Q_NOWARN_DEPRECATED_PUSH // because of deprecated members
 QgsRasterProjector::QgsRasterProjector()
   : QgsRasterInterface( nullptr )
@@ -225,6 +227,33 @@ ProjectorData::ProjectorData( const QgsRectangle &extent, int width, int height,
   calcHelper( 1, pHelperBottom );
   mHelperTopRow = 0;
 
+  if ( mApproximate )
+  {
+    // flat copies of the control points and of the interpolation of the destination columns, for srcRowCols()
+    mCPX.reserve( static_cast< std::size_t >( mCPRows ) * mCPCols );
+    mCPY.reserve( static_cast< std::size_t >( mCPRows ) * mCPCols );
+    for ( const QList<QgsPointXY> &row : qgis::as_const( mCPMatrix ) )
+    {
+      for ( const QgsPointXY &point : row )
+      {
+        mCPX.push_back( point.x() );
+        mCPY.push_back( point.y() );
+      }
+    }
+
+    mDestColMatrixCols.resize( mDestCols );
+    mDestColXFracs.resize( mDestCols );
+    const double matrixColWidth = mDestExtent.width() / ( mCPCols - 1 );
+    for ( int destCol = 0; destCol < mDestCols; ++destCol )
+    {
+      const int matrixCol = this->matrixCol( destCol );
+      const double destX = mDestExtent.xMinimum() + ( destCol + 0.5 ) * mDestXRes;
+      const double matrixColX = mDestExtent.xMinimum() + matrixCol * matrixColWidth;
+      mDestColMatrixCols[destCol] = matrixCol;
+      mDestColXFracs[destCol] = ( destX - matrixColX ) / matrixColWidth;
+    }
+  }
+
   // Calculate source dimensions
   calcSrcExtent();
   calcSrcRowsCols();
@@ -579,6 +608,98 @@ bool ProjectorData::approximateSrcRowCol( int destRow, int destCol, int *srcRow,
   return true;
 }
 
+inline void ProjectorData::srcCoordsToRowCol( double x, double y, int *srcRow, int *srcCol ) const
+{
+  if ( !mExtent.contains( QgsPointXY( x, y ) ) )
+  {
+    *srcRow = -1;
+    *srcCol = -1;
+    return;
+  }
+
+  *srcRow = static_cast< int >( std::floor( ( mSrcExtent.yMaximum() - y ) / mSrcYRes ) );
+  *srcCol = static_cast< int >( std::floor( ( x - mSrcExtent.xMinimum() ) / mSrcXRes ) );
+  if ( *srcRow >= mSrcRows || *srcRow < 0 || *srcCol >= mSrcCols || *srcCol < 0 )
+  {
+    *srcRow = -1;
+    *srcCol = -1;
+  }
+}
+
+void ProjectorData::srcRowCols( int destRow, int *srcRows, int *srcCols ) const
+{
+  const double destY = mDestExtent.yMaximum() - ( destRow + 0.5 ) * mDestYRes;
+
+  if ( mApproximate )
+  {
+    // bilinear interpolation between the control points around the row, as approximateSrcRowCol() does
+    const int matrixRow = static_cast< int >( std::floor( ( destRow + 0.5 ) / mDestRowsPerMatrixRow ) );
+    const double matrixRowHeight = mDestExtent.height() / ( mCPRows - 1 );
+    const double destYMin = mDestExtent.yMaximum() - ( matrixRow + 1 ) * matrixRowHeight;
+    const double yfrac = ( destY - destYMin ) / matrixRowHeight;
+
+    const double *topX = mCPX.data() + static_cast< std::size_t >( matrixRow ) * mCPCols;
+    const double *topY = mCPY.data() + static_cast< std::size_t >( matrixRow ) * mCPCols;
+    const double *bottomX = topX + mCPCols;
+    const double *bottomY = topY + mCPCols;
+    const int *matrixCols = mDestColMatrixCols.data();
+    const double *xfracs = mDestColXFracs.data();
+
+    for ( int destCol = 0; destCol < mDestCols; ++destCol )
+    {
+      const int col = matrixCols[destCol];
+      const double xfrac = xfracs[destCol];
+      const double tx = topX[col] + ( topX[col + 1] - topX[col] ) * xfrac;
+      const double ty = topY[col] + ( topY[col + 1] - topY[col] ) * xfrac;
+      const double bx = bottomX[col] + ( bottomX[col + 1] - bottomX[col] ) * xfrac;
+      const double by = bottomY[col] + ( bottomY[col + 1] - bottomY[col] ) * xfrac;
+      srcCoordsToRowCol( bx + ( tx - bx ) * yfrac, by + ( ty - by ) * yfrac, srcRows + destCol, srcCols + destCol );
+    }
+    return;
+  }
+
+  // exact: the centers of the row cells are transformed in a single call
+  std::vector< double > x( mDestCols );
+  std::vector< double > y( mDestCols, destY );
+  std::vector< double > z( mDestCols, 0.0 );
+  for ( int destCol = 0; destCol < mDestCols; ++destCol )
+    x[destCol] = mDestExtent.xMinimum() + ( destCol + 0.5 ) * mDestXRes;
+
+  if ( mInverseCt.isValid() )
+  {
+    // a copy, as transforms keep state about the last transformation
+    const QgsCoordinateTransform ct = mInverseCt;
+    try
+    {
+      // points which can't be transformed get infinite coordinates, outside of the source extent
+      ct.transformCoords( mDestCols, x.data(), y.data(), z.data() );
+    }
+    catch ( QgsCsException & )
+    {
+      // transform the points one by one, so that only the failing ones are lost
+      for ( int destCol = 0; destCol < mDestCols; ++destCol )
+      {
+        x[destCol] = mDestExtent.xMinimum() + ( destCol + 0.5 ) * mDestXRes;
+        y[destCol] = destY;
+        z[destCol] = 0;
+        try
+        {
+          ct.transformInPlace( x[destCol], y[destCol], z[destCol] );
+        }
+        catch ( QgsCsException & )
+        {
+          x[destCol] = std::numeric_limits< double >::quiet_NaN();
+        }
+      }
+    }
+  }
+
+  for ( int destCol = 0; destCol < mDestCols; ++destCol )
+  {
+    srcCoordsToRowCol( x[destCol], y[destCol], srcRows + destCol, srcCols + destCol );
+  }
+}
+
 void ProjectorData::insertRows( const QgsCoordinateTransform &ct )
 {
   for ( int r = 0; r < mCPRows - 1; r++ )
@@ -849,41 +970,65 @@ QgsRasterBlock *QgsRasterProjector::block( int bandNo, QgsRectangle  const &exte
 
   outputBlock->setIsNoData();
 
-  int srcRow, srcCol;
-  for ( int i = 0; i < height; ++i )
+  // rows are projected by ranges, concurrently for large blocks
+  const int rangeRows = std::max( 1, 16384 / std::max( width, 1 ) );
+  QVector< int > rangeStarts;
+  for ( int row = 0; row < height; row += rangeRows )
+    rangeStarts << row;
+
+  auto projectRows = [&]( int firstRow )
   {
-    if ( feedback && feedback->isCanceled() )
-      break;
-    for ( int j = 0; j < width; ++j )
+    std::vector< int > srcRows( width );
+    std::vector< int > srcCols( width );
+    const int lastRow = std::min( firstRow + rangeRows, height );
+    for ( int i = firstRow; i < lastRow; ++i )
     {
-      bool inside = pd.srcRowCol( i, j, &srcRow, &srcCol );
-      if ( !inside ) continue; // we have everything set to no data
-
-      qgssize srcIndex = static_cast< qgssize >( srcRow * pd.srcCols() + srcCol );
+      if ( feedback && feedback->isCanceled() )
+        break;
 
-      // isNoData() may be slow so we check doNoData first
-      if ( doNoData && inputBlock->isNoData( srcRow, srcCol ) )
+      pd.srcRowCols( i, srcRows.data(), srcCols.data() );
+      for ( int j = 0; j < width; ++j )
       {
-        outputBlock->setIsNoData( i, j );
-        continue;
-      }
+        const int srcRow = srcRows[j];
+        const int srcCol = srcCols[j];
+        if ( srcRow < 0 ) continue; // we have everything set to no data
 
-      qgssize destIndex = static_cast< qgssize >( i * width + j );
-      char *srcBits = inputBlock->bits( srcIndex );
-      char *destBits = outputBlock->bits( destIndex );
-      if ( !srcBits )
-      {
-        // QgsDebugMsg( QStringLiteral( "Cannot get input block data: row = %1 col = %2" ).arg( i ).arg( j ) );
-        continue;
-      }
-      if ( !destBits )
-      {
-        // QgsDebugMsg( QStringLiteral( "Cannot set output block data: srcRow = %1 srcCol = %2" ).arg( srcRow ).arg( srcCol ) );
-        continue;
+        qgssize srcIndex = static_cast< qgssize >( srcRow ) * pd.srcCols() + srcCol;
+
+        // isNoData() may be slow so we check doNoData first
+        if ( doNoData && inputBlock->isNoData( srcRow, srcCol ) )
+        {
+          outputBlock->setIsNoData( i, j );
+          continue;
+        }
+
+        qgssize destIndex = static_cast< qgssize >( i ) * width + j;
+        char *srcBits = inputBlock->bits( srcIndex );
+        char *destBits = outputBlock->bits( destIndex );
+        if ( !srcBits )
+        {
+          // QgsDebugMsg( QStringLiteral( "Cannot get input block data: row = %1 col = %2" ).arg( i ).arg( j ) );
+          continue;
+        }
+        if ( !destBits )
+        {
+          // QgsDebugMsg( QStringLiteral( "Cannot set output block data: srcRow = %1 srcCol = %2" ).arg( srcRow ).arg( srcCol ) );
+          continue;
+        }
+        memcpy( destBits, srcBits, pixelSize );
+        outputBlock->setIsData( i, j );
       }
-      memcpy( destBits, srcBits, pixelSize );
-      outputBlock->setIsData( i, j );
     }
+  };
+
+  // rows only write to their own bytes of the output data and no data bitmap
+  if ( rangeStarts.size() > 1 )
+  {
+    QtConcurrent::blockingMap( rangeStarts, projectRows );
+  }
+  else if ( !rangeStarts.isEmpty() )
+  {
+    projectRows( rangeStarts.first() );
   }
 
   return outputBlock.release();
@@ -34,6 +34,7 @@
 #include "qgsrasterinterface.h"
 
 #include <cmath>
+#include <vector>
 
 class QgsPointXY;
 
@@ -152,6 +153,15 @@ class ProjectorData
      */
     bool srcRowCol( int destRow, int destCol, int *srcRow, int *srcCol );
 
+    /**
+     * Computes the source row and column indexes of all the cells of the \a destRow destination row,
+     * in the \a srcRows and \a srcCols arrays of destination width size. Indexes of cells outside
+     * of the source are set to -1.
+     *
+     * Unlike srcRowCol(), rows can be computed in any order and concurrently from several threads.
+     */
+    void srcRowCols( int destRow, int *srcRows, int *srcCols ) const;
+
     QgsRectangle srcExtent() const { return mSrcExtent; }
     int srcRows() const { return mSrcRows; }
     int srcCols() const { return mSrcCols; }
@@ -215,6 +225,9 @@ class ProjectorData
     //! Gets mCPMatrix as string
     QString cpToString();
 
+    //! Converts source coordinates to source row and column indexes, -1 if outside of the source
+    inline void srcCoordsToRowCol( double x, double y, int *srcRow, int *srcCol ) const;
+
     /**
      * Use approximation (requested precision is Approximate and it is possible to calculate
      * an approximation matrix with a sufficient precision).
@@ -293,6 +306,18 @@ class ProjectorData
     double mMaxSrcXRes;
     double mMaxSrcYRes;
 
+    //! Source x coordinates of mCPMatrix, row after row
+    std::vector< double > mCPX;
+
+    //! Source y coordinates of mCPMatrix, row after row
+    std::vector< double > mCPY;
+
+    //! Matrix column of each destination column
+    std::vector< int > mDestColMatrixCols;
+
+    //! Position of each destination column between its matrix column and the next one
+    std::vector< double > mDestColXFracs;
+
 };
 
 /// @endcond
@@ -21,6 +21,7 @@
 
 #include <cmath>
 #include <map>
+#include <numeric>
 #include <random>
 
 #include "qgssymbol.h"
@@ -52,6 +53,7 @@
 #include "qgsrenderedfeaturehandlerinterface.h"
 #include "qgslegendpatchshape.h"
 #include "qgsgeos.h"
+#include "qgswkbptr.h"
 
 QgsPropertiesDefinition QgsSymbol::sPropertyDefinitions;
 
@@ -257,6 +259,33 @@ const QgsPropertiesDefinition &QgsSymbol::propertyDefinitions()
   return sPropertyDefinitions;
 }
 
+///@cond PRIVATE
+struct QgsSymbol::WkbRenderBuffers
+{
+  struct Part
+  {
+    int firstRing = 0;
+    int ringCount = 0;
+    QgsRectangle bounds;
+  };
+
+  //! Decoded rings of all parts, in map coordinates and then in painter coordinates
+  QVector< QPolygonF > rings;
+
+  //! Number of rings in use, rings beyond this are kept for their allocated capacity
+  int ringCount = 0;
+
+  QVector< Part > parts;
+  QVector< int > partOrder;
+
+  //! Interior rings of the polygon part currently being rendered
+  QVector< QPolygonF > holes;
+
+  //! Scratch buffer for simplification
+  QPolygonF simplified;
+};
+///@endcond
+
 QgsSymbol::~QgsSymbol()
 {
   // delete all symbol layers (we own them, so it's okay)
@@ -1414,6 +1443,442 @@ void QgsSymbol::renderFeature( const QgsFeature &feature, QgsRenderContext &cont
   }
 }
 
+///@cond PRIVATE
+
+/**
+ * Replaces \a points by the bounding box of the points, as done by QgsMapToPixelSimplifier
+ * when a geometry is smaller than the simplification tolerance.
+ */
+static void generalizeWkbPointsByBoundingBox( QPolygonF &points, const QRectF &envelope, bool isRing )
+{
+  const double x1 = envelope.left();
+  const double y1 = envelope.top();
+  const double x2 = envelope.right();
+  const double y2 = envelope.bottom();
+
+  points.resize( 0 );
+  if ( !isRing )
+  {
+    points << QPointF( x1, y1 ) << QPointF( x2, y2 );
+  }
+  else
+  {
+    points << QPointF( x1, y1 ) << QPointF( x2, y1 ) << QPointF( x2, y2 ) << QPointF( x1, y2 ) << QPointF( x1, y1 );
+  }
+}
+
+/**
+ * Simplifies \a points in place, matching the results of QgsMapToPixelSimplifier's distance
+ * based simplification for a single line string or ring.
+ */
+static void simplifyWkbPoints( QPolygonF &points, QPolygonF &buffer, int simplifyFlags, double tolerance, bool isRing )
+{
+  const QRectF envelope = points.boundingRect();
+  if ( ( simplifyFlags & QgsMapToPixelSimplifier::SimplifyEnvelope ) &&
+       QgsMapToPixelSimplifier::isGeneralizableByMapBoundingBox( QgsRectangle( envelope ), tolerance ) )
+  {
+    generalizeWkbPointsByBoundingBox( points, envelope, isRing );
+    return;
+  }
+
+  const int numPoints = points.size();
+  bool isGeneralizable = ( simplifyFlags & QgsMapToPixelSimplifier::SimplifyGeometry ) && numPoints > ( isRing ? 4 : 2 );
+
+  if ( isRing && numPoints > 0 )
+  {
+    isRing = qgsDoubleNear( points.at( 0 ).x(), points.at( numPoints - 1 ).x() ) &&
+             qgsDoubleNear( points.at( 0 ).y(), points.at( numPoints - 1 ).y() );
+  }
+
+  const double squaredTolerance = tolerance * tolerance;
+  double lastX = 0.0;
+  double lastY = 0.0;
+  bool hasLongSegments = false;
+
+  buffer.resize( 0 );
+  buffer.reserve( numPoints );
+  const QPointF *point = points.constData();
+  for ( int i = 0; i < numPoints; ++i, ++point )
+  {
+    const double x = point->x();
+    const double y = point->y();
+    const float dx = static_cast< float >( x - lastX );
+    const float dy = static_cast< float >( y - lastY );
+
+    bool isLongSegment = false;
+    if ( i == 0 ||
+         !isGeneralizable ||
+         ( isLongSegment = ( dx * dx + dy * dy > squaredTolerance ) ) ||
+         ( !isRing && ( i == 1 || i >= numPoints - 2 ) ) )
+    {
+      buffer << *point;
+      lastX = x;
+      lastY = y;
+      hasLongSegments |= isLongSegment;
+    }
+  }
+
+  if ( buffer.size() < ( isRing ? 4 : 2 ) )
+  {
+    // simplified too much - either use the bounding box or keep the original points, as QgsMapToPixelSimplifier does
+    if ( !hasLongSegments )
+      generalizeWkbPointsByBoundingBox( points, envelope, isRing );
+    return;
+  }
+
+  if ( isRing && ( !qgsDoubleNear( lastX, buffer.at( 0 ).x() ) || !qgsDoubleNear( lastY, buffer.at( 0 ).y() ) ) )
+    buffer << buffer.at( 0 );
+
+  points.swap( buffer );
+}
+
+/**
+ * Converts a line string in map coordinates to painter coordinates in place. This matches QgsSymbol::_getLineString().
+ */
+static void wkbLineToPainterCoordinates( QPolygonF &points, QgsRenderContext &context, bool clipToExtent )
+{
+  const int nPoints = points.size();
+  const QgsCoordinateTransform ct = context.coordinateTransform();
+
+  if ( clipToExtent && nPoints > 1 && !( context.flags() & QgsRenderContext::ApplyClipAfterReprojection ) )
+  {
+    const QgsRectangle e = context.extent();
+    const double cw = e.width() / 10;
+    const double ch = e.height() / 10;
+    const QgsRectangle clipRect( e.xMinimum() - cw, e.yMinimum() - ch, e.xMaximum() + cw, e.yMaximum() + ch );
+    // lines which are completely inside the clip rectangle are unchanged by clipping
+    if ( !clipRect.contains( QgsRectangle( points.boundingRect() ) ) )
+      points = QgsClipper::clippedLine( points, clipRect );
+  }
+
+  if ( ct.isValid() )
+  {
+    try
+    {
+      ct.transformPolygon( points );
+    }
+    catch ( QgsCsException & )
+    {
+      // we don't abort the rendering here, instead we remove any invalid points and just plot those which ARE valid
+    }
+  }
+
+  points.erase( std::remove_if( points.begin(), points.end(),
+                                []( const QPointF point )
+  {
+    return !std::isfinite( point.x() ) || !std::isfinite( point.y() );
+  } ), points.end() );
+
+  if ( clipToExtent && nPoints > 1 && context.flags() & QgsRenderContext::ApplyClipAfterReprojection )
+  {
+    const QgsRectangle e = context.mapExtent();
+    const double cw = e.width() / 10;
+    const double ch = e.height() / 10;
+    const QgsRectangle clipRect( e.xMinimum() - cw, e.yMinimum() - ch, e.xMaximum() + cw, e.yMaximum() + ch );
+    points = QgsClipper::clippedLine( points, clipRect );
+  }
+
+  const QgsMapToPixel &mtp = context.mapToPixel();
+  QPointF *ptr = points.data();
+  for ( int i = 0; i < points.size(); ++i, ++ptr )
+  {
+    mtp.transformInPlace( ptr->rx(), ptr->ry() );
+  }
+}
+
+/**
+ * Converts a polygon ring in map coordinates to painter coordinates in place. This matches QgsSymbol::_getPolygonRing().
+ */
+static void wkbRingToPainterCoordinates( QPolygonF &ring, QgsRenderContext &context, bool clipToExtent, bool isExteriorRing, bool correctRingOrientation )
+{
+  if ( ring.isEmpty() )
+    return;
+
+  const QgsCoordinateTransform ct = context.coordinateTransform();
+
+  if ( correctRingOrientation )
+  {
+    // same as QgsCurve::orientation()
+    double area = 0;
+    const QPointF *point = ring.constData();
+    for ( int i = 0; i < ring.size() - 1; ++i, ++point )
+    {
+      area += 0.5 * ( point->x() * ( point + 1 )->y() - point->y() * ( point + 1 )->x() );
+    }
+    const bool isClockwise = area < 0;
+    if ( isExteriorRing != isClockwise )
+      std::reverse( ring.begin(), ring.end() );
+  }
+
+  if ( clipToExtent && !( context.flags() & QgsRenderContext::ApplyClipAfterReprojection ) && !context.extent().contains( ring.boundingRect() ) )
+  {
+    const QgsRectangle e = context.extent();
+    const double cw = e.width() / 10;
+    const double ch = e.height() / 10;
+    const QgsRectangle clipRect( e.xMinimum() - cw, e.yMinimum() - ch, e.xMaximum() + cw, e.yMaximum() + ch );
+    QgsClipper::trimPolygon( ring, clipRect );
+  }
+
+  if ( ct.isValid() )
+  {
+    try
+    {
+      ct.transformPolygon( ring );
+    }
+    catch ( QgsCsException & )
+    {
+      // we don't abort the rendering here, instead we remove any invalid points and just plot those which ARE valid
+    }
+  }
+
+  ring.erase( std::remove_if( ring.begin(), ring.end(),
+                              []( const QPointF point )
+  {
+    return !std::isfinite( point.x() ) || !std::isfinite( point.y() );
+  } ), ring.end() );
+
+  if ( clipToExtent && context.flags() & QgsRenderContext::ApplyClipAfterReprojection && !context.mapExtent().contains( ring.boundingRect() ) )
+  {
+    const QgsRectangle e = context.mapExtent();
+    const double cw = e.width() / 10;
+    const double ch = e.height() / 10;
+    const QgsRectangle clipRect( e.xMinimum() - cw, e.yMinimum() - ch, e.xMaximum() + cw, e.yMaximum() + ch );
+    QgsClipper::trimPolygon( ring, clipRect );
+  }
+
+  const QgsMapToPixel &mtp = context.mapToPixel();
+  QPointF *ptr = ring.data();
+  for ( int i = 0; i < ring.size(); ++i, ++ptr )
+  {
+    mtp.transformInPlace( ptr->rx(), ptr->ry() );
+  }
+
+  if ( !ring.empty() && !ring.isClosed() )
+    ring << ring.at( 0 );
+}
+
+///@endcond
+
+bool QgsSymbol::canRenderWkb() const
+{
+  if ( mType != Line && mType != Fill )
+    return false;
+
+  if ( mDataDefinedProperties.hasActiveProperties() )
+    return false;
+
+  for ( QgsSymbolLayer *layer : mLayers )
+  {
+    if ( layer->hasDataDefinedProperties() )
+      return false;
+
+    // these symbol layers only use the rendered points, and never the feature's geometry
+    const QString layerType = layer->layerType();
+    if ( layerType != QLatin1String( "SimpleLine" ) && layerType != QLatin1String( "SimpleFill" ) )
+      return false;
+  }
+  return true;
+}
+
+bool QgsSymbol::renderWkb( const QgsFeature &feature, const QByteArray &wkb, QgsRenderContext &context, bool selected )
+{
+  if ( context.renderingStopped() )
+    return true;
+
+  if ( !context.featureClipGeometry().isEmpty() || context.hasRenderedFeatureHandlers() )
+    return false;
+
+  const QgsVectorSimplifyMethod &simplifyMethod = context.vectorSimplifyMethod();
+  const bool simplify = simplifyMethod.forceLocalOptimization() && simplifyMethod.simplifyHints() != QgsVectorSimplifyMethod::NoSimplification;
+  if ( simplify && simplifyMethod.simplifyAlgorithm() != QgsVectorSimplifyMethod::Distance )
+    return false;
+
+  if ( !mWkbRenderBuffers )
+    mWkbRenderBuffers = qgis::make_unique< WkbRenderBuffers >();
+  WkbRenderBuffers &buffers = *mWkbRenderBuffers;
+  buffers.parts.clear();
+  buffers.ringCount = 0;
+
+  // step 1 - decode all parts into the ring buffers, in map coordinates
+  bool isPolygon = false;
+  QgsRectangle bounds;
+  bounds.setMinimal();
+  try
+  {
+    QgsConstWkbPtr wkbPtr( wkb );
+    const QgsWkbTypes::Type flatType = QgsWkbTypes::flatType( wkbPtr.readHeader() );
+    isPolygon = flatType == QgsWkbTypes::Polygon || flatType == QgsWkbTypes::MultiPolygon;
+    const bool isLine = flatType == QgsWkbTypes::LineString || flatType == QgsWkbTypes::MultiLineString;
+    if ( ( !isLine || mType != QgsSymbol::Line ) && ( !isPolygon || mType != QgsSymbol::Fill ) )
+      return false;
+
+    const bool isMulti = QgsWkbTypes::isMultiType( flatType );
+    int partCount = 1;
+    if ( isMulti )
+      wkbPtr >> partCount;
+
+    for ( int partIndex = 0; partIndex < partCount; ++partIndex )
+    {
+      if ( isMulti && QgsWkbTypes::flatType( wkbPtr.readHeader() ) != ( isPolygon ? QgsWkbTypes::Polygon : QgsWkbTypes::LineString ) )
+        return false;
+
+      WkbRenderBuffers::Part part;
+      part.firstRing = buffers.ringCount;
+      part.ringCount = 1;
+      if ( isPolygon )
+        wkbPtr >> part.ringCount;
+
+      for ( int ring = 0; ring < part.ringCount; ++ring )
+      {
+        if ( buffers.ringCount >= buffers.rings.size() )
+          buffers.rings.resize( buffers.ringCount + 1 );
+        wkbPtr >> buffers.rings[ buffers.ringCount++ ];
+      }
+
+      if ( part.ringCount > 0 )
+      {
+        part.bounds = QgsRectangle( buffers.rings.at( part.firstRing ).boundingRect() );
+        bounds.combineExtentWith( part.bounds );
+      }
+      buffers.parts << part;
+    }
+  }
+  catch ( QgsWkbException & )
+  {
+    return false;
+  }
+
+  GeometryRestorer geomRestorer( context );
+  context.setGeometry( nullptr );
+
+  if ( !bounds.isNull() )
+  {
+    try
+    {
+      const QPointF boundsOrigin = _getPoint( context, QgsPoint( bounds.xMinimum(), bounds.yMinimum() ) );
+      if ( std::isfinite( boundsOrigin.x() ) && std::isfinite( boundsOrigin.y() ) )
+        context.setTextureOrigin( boundsOrigin );
+    }
+    catch ( QgsCsException & )
+    {
+
+    }
+  }
+
+  bool clippingEnabled = clipFeaturesToExtent();
+  if ( clippingEnabled && context.testFlag( QgsRenderContext::RenderMapTile ) && canCauseArtifactsBetweenAdjacentTiles() )
+  {
+    clippingEnabled = false;
+  }
+
+  // step 2 - simplify and convert all parts to painter coordinates
+  const int simplifyFlags = simplifyMethod.simplifyHints();
+  const double tolerance = simplifyMethod.tolerance();
+  for ( WkbRenderBuffers::Part &part : buffers.parts )
+  {
+    if ( part.ringCount == 0 )
+      continue;
+
+    QPolygonF *rings = buffers.rings.data() + part.firstRing;
+    if ( simplify )
+    {
+      // matches the checks done by QgsMapToPixelSimplifier::simplify()
+      int numPoints = 0;
+      for ( int ring = 0; ring < part.ringCount; ++ring )
+        numPoints += rings[ring].size();
+
+      if ( numPoints > ( isPolygon ? 6 : 3 ) &&
+           std::max( part.bounds.width(), part.bounds.height() ) / numPoints <= tolerance * 2.0 )
+      {
+        if ( isPolygon && ( simplifyFlags & QgsMapToPixelSimplifier::SimplifyEnvelope ) &&
+             QgsMapToPixelSimplifier::isGeneralizableByMapBoundingBox( part.bounds, tolerance ) )
+        {
+          // the whole polygon is replaced by its bounding box, without interior rings
+          generalizeWkbPointsByBoundingBox( rings[0], rings[0].boundingRect(), true );
+          part.ringCount = 1;
+        }
+        else
+        {
+          for ( int ring = 0; ring < part.ringCount; ++ring )
+            simplifyWkbPoints( rings[ring], buffers.simplified, simplifyFlags, tolerance, isPolygon );
+        }
+      }
+    }
+
+    if ( isPolygon )
+    {
+      for ( int ring = 0; ring < part.ringCount; ++ring )
+        wkbRingToPainterCoordinates( rings[ring], context, clippingEnabled, ring == 0, mForceRHR );
+    }
+    else
+    {
+      wkbLineToPainterCoordinates( rings[0], context, clippingEnabled );
+    }
+  }
+
+  // polygon parts are drawn starting with larger parts down to smaller parts, as in renderFeature()
+  buffers.partOrder.resize( buffers.parts.size() );
+  std::iota( buffers.partOrder.begin(), buffers.partOrder.end(), 0 );
+  if ( isPolygon && buffers.parts.size() > 1 )
+  {
+    const QVector< WkbRenderBuffers::Part > &parts = buffers.parts;
+    std::stable_sort( buffers.partOrder.begin(), buffers.partOrder.end(), [&parts]( int a, int b )
+    {
+      return parts.at( a ).bounds.width() * parts.at( a ).bounds.height() > parts.at( b ).bounds.width() * parts.at( b ).bounds.height();
+    } );
+  }
+
+  mSymbolRenderContext->setGeometryPartCount( buffers.parts.size() );
+  mSymbolRenderContext->setGeometryPartNum( 1 );
+
+  // step 3 - render the parts using all symbol layers
+  for ( int symbolLayerIndex = 0; symbolLayerIndex < mLayers.count(); ++symbolLayerIndex )
+  {
+    QgsSymbolLayer *symbolLayer = mLayers.at( symbolLayerIndex );
+    if ( !symbolLayer->enabled() )
+      continue;
+
+    symbolLayer->startFeatureRender( feature, context );
+
+    int geometryPartNumber = 0;
+    for ( int partIndex : qgis::as_const( buffers.partOrder ) )
+    {
+      if ( context.renderingStopped() )
+        break;
+
+      const WkbRenderBuffers::Part &part = buffers.parts.at( partIndex );
+      if ( part.ringCount == 0 )
+        continue;
+
+      mSymbolRenderContext->setGeometryPartNum( geometryPartNumber + 1 );
+      const QPolygonF &exterior = buffers.rings.at( part.firstRing );
+      if ( isPolygon )
+      {
+        buffers.holes.clear();
+        for ( int ring = 1; ring < part.ringCount; ++ring )
+        {
+          const QPolygonF &hole = buffers.rings.at( part.firstRing + ring );
+          if ( !hole.isEmpty() )
+            buffers.holes.append( hole );
+        }
+        static_cast<QgsFillSymbol *>( this )->renderPolygon( exterior, !buffers.holes.isEmpty() ? &buffers.holes : nullptr, &feature, context, symbolLayerIndex, selected );
+      }
+      else
+      {
+        static_cast<QgsLineSymbol *>( this )->renderPolyline( exterior, &feature, context, symbolLayerIndex, selected );
+      }
+      geometryPartNumber++;
+    }
+
+    symbolLayer->stopFeatureRender( feature, context );
+  }
+
+  // release the references to the ring buffers, so that they are not detached when decoding the next feature
+  buffers.holes.clear();
+
+  return true;
+}
+
 QgsSymbolRenderContext *QgsSymbol::symbolRenderContext()
 {
   return mSymbolRenderContext.get();
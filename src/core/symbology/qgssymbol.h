@@ -616,6 +616,36 @@ class CORE_EXPORT QgsSymbol
      */
     void renderFeature( const QgsFeature &feature, QgsRenderContext &context, int layer = -1, bool selected = false, bool drawVertexMarker = false, int currentVertexMarkerType = 0, double currentVertexMarkerSize = 0.0 ) SIP_THROW( QgsCsException );
 
+    /**
+     * Returns TRUE if the symbol can render geometries directly from their WKB representation
+     * using renderWkb().
+     *
+     * This is the case for line and fill symbols which consist only of simple line and simple fill
+     * symbol layers without data defined properties.
+     *
+     * \note not available in Python bindings
+     * \since QGIS 3.18
+     */
+    bool canRenderWkb() const SIP_SKIP;
+
+    /**
+     * Renders a feature, using the \a wkb representation of its geometry. The geometry of
+     * \a feature itself is ignored.
+     *
+     * Unlike renderFeature(), this method does not construct any geometry objects. Coordinates are
+     * decoded directly from the WKB into buffers which are reused for all features rendered by the symbol.
+     *
+     * Only line strings, polygons and their multipart variants are supported, and canRenderWkb() must
+     * return TRUE for the symbol. If FALSE is returned then nothing was rendered, and renderFeature()
+     * must be used for the feature instead.
+     *
+     * Before calling this the startRender() method should be called to initialize the rendering process.
+     *
+     * \note not available in Python bindings
+     * \since QGIS 3.18
+     */
+    bool renderWkb( const QgsFeature &feature, const QByteArray &wkb, QgsRenderContext &context, bool selected = false ) SIP_SKIP;
+
     /**
      * Returns the symbol render context. Only valid between startRender and stopRender calls.
      *
@@ -726,6 +756,11 @@ class CORE_EXPORT QgsSymbol
 
     QgsPropertyCollection mDataDefinedProperties;
 
+    struct WkbRenderBuffers;
+
+    //! Coordinate buffers reused by renderWkb(), created on first use
+    std::unique_ptr< WkbRenderBuffers > mWkbRenderBuffers;
+
     /**
      * Called before symbol layers will be rendered for a particular \a feature.
      *
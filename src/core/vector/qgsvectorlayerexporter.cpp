@@ -62,6 +62,13 @@ QgsVectorLayerExporter::QgsVectorLayerExporter( const QString &uri,
 
   QMap<QString, QVariant> modifiedOptions( options );
 
+  // PostgreSQL tables are only indexed on request, e.g. so that indexes can be created
+  // after further loads into the table
+  if ( providerKey == QLatin1String( "postgres" ) )
+    mCreateSpatialIndex = false;
+  if ( modifiedOptions.contains( QStringLiteral( "SPATIAL_INDEX" ) ) )
+    mCreateSpatialIndex = modifiedOptions.take( QStringLiteral( "SPATIAL_INDEX" ) ).toBool();
+
   if ( providerKey == QLatin1String( "ogr" ) &&
        options.contains( QStringLiteral( "driverName" ) ) &&
        ( options[ QStringLiteral( "driverName" ) ].toString().compare( QLatin1String( "GPKG" ), Qt::CaseInsensitive ) == 0 ||
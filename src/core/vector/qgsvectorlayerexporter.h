@@ -98,6 +98,10 @@ class CORE_EXPORT QgsVectorLayerExporter : public QgsFeatureSink
      * \param overwrite set to TRUE to overwrite any existing data source
      * \param options optional provider dataset options
      * \param sinkFlags for how to add features
+     *
+     * The "SPATIAL_INDEX" option can be set to TRUE or FALSE to control whether a spatial index
+     * is created once the features are exported, for providers which support it. It defaults to TRUE,
+     * except for the PostgreSQL provider, which only creates a spatial index on request (since QGIS 3.18).
      */
     QgsVectorLayerExporter( const QString &uri,
                             const QString &provider,
@@ -15,6 +15,7 @@
 #include "qgsvectorlayerfeatureiterator.h"
 
 #include "qgsexpressionfieldbuffer.h"
+#include "qgsfeaturebatch.h"
 #include "qgsgeometrysimplifier.h"
 #include "qgssimplifymethod.h"
 #include "qgsvectordataprovider.h"
@@ -478,6 +479,31 @@ bool QgsVectorLayerFeatureIterator::fetchFeature( QgsFeature &f )
 
 
 
+int QgsVectorLayerFeatureIterator::fetchFeatureBatch( QgsFeatureBatch &batch, int maximumCount )
+{
+  if ( mSource->mHasEditBuffer || mHasVirtualAttributes || mTransform.isValid() )
+    return -1;
+
+  // features are only filtered by the provider
+  if ( mRequest.filterType() != mProviderRequest.filterType() )
+    return -1;
+
+  if ( mRequest.invalidGeometryCheck() != QgsFeatureRequest::GeometryNoCheck )
+    return -1;
+
+  if ( mClosed )
+    return 0;
+
+  if ( !mProviderIterator.nextBatch( batch, maximumCount ) )
+  {
+    close();
+    return 0;
+  }
+
+  return batch.count();
+}
+
+
 bool QgsVectorLayerFeatureIterator::rewind()
 {
   if ( mClosed )
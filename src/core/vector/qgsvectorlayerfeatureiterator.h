@@ -164,6 +164,13 @@ class CORE_EXPORT QgsVectorLayerFeatureIterator : public QgsAbstractFeatureItera
     //! fetch next feature, return TRUE on success
     bool fetchFeature( QgsFeature &feature ) override;
 
+    /**
+     * Fetches a batch of features directly from the provider's iterator, when the layer has
+     * no edits, joins or virtual fields which would require modifying the provider features.
+     * \note not available in Python bindings
+     */
+    int fetchFeatureBatch( QgsFeatureBatch &batch, int maximumCount ) override SIP_SKIP;
+
     /**
      * Overrides default method as we only need to filter features in the edit buffer
      * while for others filtering is left to the provider implementation.
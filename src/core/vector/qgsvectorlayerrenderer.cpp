@@ -17,6 +17,7 @@
 
 #include "diagram/qgsdiagram.h"
 
+#include "qgscategorizedsymbolrenderer.h"
 #include "qgsdiagramrenderer.h"
 #include "qgsmessagelog.h"
 #include "qgspallabeling.h"
@@ -34,6 +35,10 @@
 #include "qgspainteffect.h"
 #include "qgsfeaturefilterprovider.h"
 #include "qgsexception.h"
+#include "qgsexpression.h"
+#include "qgsfeaturebatch.h"
+#include "qgsgraduatedsymbolrenderer.h"
+#include "qgswkbptr.h"
 #include "qgslogger.h"
 #include "qgssettings.h"
 #include "qgsexpressioncontextutils.h"
@@ -44,6 +49,35 @@
 
 #include <QPicture>
 
+QgsVectorLayerTiledLabelRegistry::QgsVectorLayerTiledLabelRegistry( QgsVectorLayerLabelProvider *labelProvider, QgsVectorLayerDiagramProvider *diagramProvider )
+  : mLabelProvider( labelProvider )
+  , mDiagramProvider( diagramProvider )
+{
+}
+
+bool QgsVectorLayerTiledLabelRegistry::claimFeature( QgsFeatureId id )
+{
+  QMutexLocker locker( &mMutex );
+  if ( mClaimedIds.contains( id ) )
+    return false;
+
+  mClaimedIds.insert( id );
+  return true;
+}
+
+void QgsVectorLayerTiledLabelRegistry::registerFeature( QgsFeature &feature, QgsRenderContext &context, const QgsGeometry &obstacleGeometry, const QgsSymbol *symbol )
+{
+  QMutexLocker locker( &mMutex );
+  if ( mLabelProvider )
+  {
+    mLabelProvider->registerFeature( feature, context, obstacleGeometry, symbol );
+  }
+  if ( mDiagramProvider )
+  {
+    mDiagramProvider->registerFeature( feature, context, obstacleGeometry );
+  }
+}
+
 QgsVectorLayerRenderer::QgsVectorLayerRenderer( QgsVectorLayer *layer, QgsRenderContext &context )
   : QgsMapLayerRenderer( layer->id(), &context )
   , mLayer( layer )
@@ -198,6 +232,23 @@ bool QgsVectorLayerRenderer::forceRasterRender() const
   return mForceRasterRender;
 }
 
+void QgsVectorLayerRenderer::shareLabelingWith( QgsVectorLayerRenderer *tileRenderer )
+{
+  if ( !mTiledLabelRegistry )
+    mTiledLabelRegistry = std::make_shared< QgsVectorLayerTiledLabelRegistry >( mLabelProvider, mDiagramProvider );
+
+  tileRenderer->mTiledLabelRegistry = mTiledLabelRegistry;
+  // the tile renderer has no providers of its own, so it must also fetch the attributes required for labeling
+  tileRenderer->mAttrNames.unite( mAttrNames );
+}
+
+void QgsVectorLayerRenderer::setPartialRenderRegions( const QList<QgsRectangle> &extents, const QList<QRectF> &clipRects )
+{
+  Q_ASSERT( extents.count() == clipRects.count() );
+  mPartialRenderExtents = extents;
+  mPartialRenderClipRects = clipRects;
+}
+
 bool QgsVectorLayerRenderer::render()
 {
   if ( mGeometryType == QgsWkbTypes::NullGeometry || mGeometryType == QgsWkbTypes::UnknownGeometry )
@@ -222,9 +273,28 @@ bool QgsVectorLayerRenderer::render()
   }
 
   bool res = true;
-  for ( const std::unique_ptr< QgsFeatureRenderer > &renderer : mRenderers )
+  if ( mPartialRenderExtents.isEmpty() )
+  {
+    for ( const std::unique_ptr< QgsFeatureRenderer > &renderer : mRenderers )
+    {
+      res = renderInternal( renderer.get() ) && res;
+    }
+  }
+  else
   {
-    res = renderInternal( renderer.get() ) && res;
+    QgsRenderContext &context = *renderContext();
+    const QgsRectangle fullExtent = context.extent();
+    for ( int i = 0; i < mPartialRenderExtents.count() && !context.renderingStopped(); ++i )
+    {
+      context.setExtent( mPartialRenderExtents.at( i ) );
+      QgsScopedQPainterState painterState( context.painter() );
+      context.painter()->setClipRect( mPartialRenderClipRects.at( i ), Qt::IntersectClip );
+      for ( const std::unique_ptr< QgsFeatureRenderer > &renderer : mRenderers )
+      {
+        res = renderInternal( renderer.get() ) && res;
+      }
+    }
+    context.setExtent( fullExtent );
   }
 
   mReadyToCompose = true;
@@ -240,7 +310,7 @@ bool QgsVectorLayerRenderer::renderInternal( QgsFeatureRenderer *renderer )
     // a little shortcut for the null symbol renderer - most of the time it is not going to render anything
     // so we can even skip the whole loop to fetch features
     if ( !isMainRenderer ||
-         ( !mDrawVertexMarkers && !mLabelProvider && !mDiagramProvider && mSelectedFeatureIds.isEmpty() ) )
+         ( !mDrawVertexMarkers && !labelingRequired( *renderContext() ) && mSelectedFeatureIds.isEmpty() ) )
       return true;
   }
 
@@ -396,6 +466,8 @@ bool QgsVectorLayerRenderer::renderInternal( QgsFeatureRenderer *renderer )
 
   if ( ( renderer->capabilities() & QgsFeatureRenderer::SymbolLevels ) && renderer->usingSymbolLevels() )
     drawRendererLevels( renderer, fit );
+  else if ( canDrawRendererWkb( renderer ) )
+    drawRendererWkb( renderer, fit );
   else
     drawRenderer( renderer, fit );
 
@@ -429,6 +501,8 @@ void QgsVectorLayerRenderer::drawRenderer( QgsFeatureRenderer *renderer, QgsFeat
     clipEngine->prepareGeometry();
   }
 
+  const bool registerLabels = isMainRenderer && labelingRequired( context );
+
   QgsFeature fet;
   while ( fit.nextFeature( fet ) )
   {
@@ -469,7 +543,7 @@ void QgsVectorLayerRenderer::drawRenderer( QgsFeatureRenderer *renderer, QgsFeat
         }
 
         // new labeling engine
-        if ( isMainRenderer && context.labelingEngine() && ( mLabelProvider || mDiagramProvider ) )
+        if ( registerLabels && ( !mTiledLabelRegistry || mTiledLabelRegistry->claimFeature( fet.id() ) ) )
         {
           QgsGeometry obstacleGeometry;
           QgsSymbolList symbols = renderer->originalSymbolsForFeature( fet, context );
@@ -488,14 +562,7 @@ void QgsVectorLayerRenderer::drawRenderer( QgsFeatureRenderer *renderer, QgsFeat
           if ( mApplyLabelClipGeometries )
             context.setFeatureClipGeometry( mLabelClipFeatureGeom );
 
-          if ( mLabelProvider )
-          {
-            mLabelProvider->registerFeature( fet, context, obstacleGeometry, symbol );
-          }
-          if ( mDiagramProvider )
-          {
-            mDiagramProvider->registerFeature( fet, context, obstacleGeometry );
-          }
+          registerLabelFeature( fet, context, obstacleGeometry, symbol );
 
           if ( mApplyLabelClipGeometries )
             context.setFeatureClipGeometry( QgsGeometry() );
@@ -515,6 +582,214 @@ void QgsVectorLayerRenderer::drawRenderer( QgsFeatureRenderer *renderer, QgsFeat
   stopRenderer( renderer, nullptr );
 }
 
+///@cond PRIVATE
+
+//! Returns TRUE if the single part geometry of \a type at \a wkbPtr is empty, and moves past it
+static bool wkbPartIsEmpty( QgsConstWkbPtr &wkbPtr, QgsWkbTypes::Type type )
+{
+  const int pointSize = ( 2 + QgsWkbTypes::hasZ( type ) + QgsWkbTypes::hasM( type ) ) * static_cast< int >( sizeof( double ) );
+  switch ( QgsWkbTypes::flatType( type ) )
+  {
+    case QgsWkbTypes::Point:
+    {
+      double x = 0;
+      double y = 0;
+      wkbPtr >> x >> y;
+      wkbPtr += pointSize - 2 * static_cast< int >( sizeof( double ) );
+      return std::isnan( x ) || std::isnan( y );
+    }
+
+    case QgsWkbTypes::LineString:
+    {
+      int pointCount = 0;
+      wkbPtr >> pointCount;
+      wkbPtr += pointCount * pointSize;
+      return pointCount == 0;
+    }
+
+    case QgsWkbTypes::Polygon:
+    {
+      int ringCount = 0;
+      wkbPtr >> ringCount;
+      int exteriorPointCount = 0;
+      for ( int ring = 0; ring < ringCount; ++ring )
+      {
+        int pointCount = 0;
+        wkbPtr >> pointCount;
+        wkbPtr += pointCount * pointSize;
+        if ( ring == 0 )
+          exteriorPointCount = pointCount;
+      }
+      return exteriorPointCount == 0;
+    }
+
+    default:
+      throw QgsWkbException( QStringLiteral( "unsupported geometry type" ) );
+  }
+}
+
+//! Returns TRUE if the geometry stored as \a wkb is empty, matching QgsAbstractGeometry::isEmpty()
+static bool wkbGeometryIsEmpty( const QByteArray &wkb )
+{
+  try
+  {
+    QgsConstWkbPtr wkbPtr( wkb );
+    const QgsWkbTypes::Type type = wkbPtr.readHeader();
+    switch ( QgsWkbTypes::flatType( type ) )
+    {
+      case QgsWkbTypes::Point:
+      case QgsWkbTypes::LineString:
+      case QgsWkbTypes::Polygon:
+        return wkbPartIsEmpty( wkbPtr, type );
+
+      case QgsWkbTypes::MultiPoint:
+      case QgsWkbTypes::MultiLineString:
+      case QgsWkbTypes::MultiPolygon:
+      {
+        int partCount = 0;
+        wkbPtr >> partCount;
+        for ( int part = 0; part < partCount; ++part )
+        {
+          if ( !wkbPartIsEmpty( wkbPtr, wkbPtr.readHeader() ) )
+            return false;
+        }
+        return true;
+      }
+
+      default:
+        break;
+    }
+  }
+  catch ( QgsWkbException & )
+  {
+  }
+
+  // other geometry types, e.g. curves, are rare enough to be checked on the geometry itself
+  QgsGeometry geometry;
+  geometry.fromWkb( wkb );
+  return geometry.isEmpty();
+}
+
+///@endcond
+
+bool QgsVectorLayerRenderer::canDrawRendererWkb( QgsFeatureRenderer *renderer )
+{
+  QgsRenderContext &context = *renderContext();
+
+  // labels, diagrams, clipping and vertex markers all need the feature geometries
+  if ( renderer == mRenderer && labelingRequired( context ) )
+    return false;
+
+  if ( mDrawVertexMarkers && context.drawEditingInformation() )
+    return false;
+
+  if ( !mClippingRegions.empty() || context.hasRenderedFeatureHandlers() )
+    return false;
+
+  // only renderers which pick a symbol per feature and render it without modifying the feature
+  QString classAttribute;
+  if ( renderer->type() == QLatin1String( "categorizedSymbol" ) )
+    classAttribute = static_cast< QgsCategorizedSymbolRenderer * >( renderer )->classAttribute();
+  else if ( renderer->type() == QLatin1String( "graduatedSymbol" ) )
+    classAttribute = static_cast< QgsGraduatedSymbolRenderer * >( renderer )->classAttribute();
+  else if ( renderer->type() != QLatin1String( "singleSymbol" ) )
+    return false;
+
+  if ( !classAttribute.isEmpty() && mFields.lookupField( classAttribute ) < 0 && QgsExpression( classAttribute ).needsGeometry() )
+    return false;
+
+  const QgsSymbolList symbols = renderer->symbols( context );
+  if ( symbols.isEmpty() )
+    return false;
+
+  for ( const QgsSymbol *symbol : symbols )
+  {
+    if ( !symbol || !symbol->canRenderWkb() )
+      return false;
+  }
+  return true;
+}
+
+void QgsVectorLayerRenderer::drawRendererWkb( QgsFeatureRenderer *renderer, QgsFeatureIterator &fit )
+{
+  const bool isMainRenderer = renderer == mRenderer;
+
+  QgsExpressionContextScope *symbolScope = QgsExpressionContextUtils::updateSymbolScope( nullptr, new QgsExpressionContextScope() );
+  QgsRenderContext &context = *renderContext();
+  context.expressionContext().appendScope( symbolScope );
+
+  QgsFeatureBatch batch;
+  QgsFeature fet;
+  while ( !context.renderingStopped() && fit.nextBatch( batch ) )
+  {
+    const QgsFields fields = batch.fields();
+    const int fieldCount = fields.count();
+    fet.setFields( fields );
+
+    for ( int row = 0; row < batch.count(); ++row )
+    {
+      if ( context.renderingStopped() )
+      {
+        QgsDebugMsgLevel( QStringLiteral( "Drawing of vector layer %1 canceled." ).arg( layerId() ), 2 );
+        break;
+      }
+
+      if ( !batch.hasGeometry( row ) )
+        continue; // skip features without geometry
+
+      const QByteArray wkb = batch.geometryWkb( row );
+      if ( wkbGeometryIsEmpty( wkb ) )
+        continue; // skip features with empty geometries, as drawRenderer() does
+
+      // the feature only carries the attributes, its geometry is rendered straight from the batch
+      QgsAttributes attributes( fieldCount );
+      for ( int field = 0; field < fieldCount; ++field )
+        attributes[field] = batch.value( field, row );
+      fet.setId( batch.id( row ) );
+      fet.setAttributes( attributes );
+      fet.setValid( true );
+
+      try
+      {
+        context.expressionContext().setFeature( fet );
+
+        const bool sel = isMainRenderer && context.showSelection() && mSelectedFeatureIds.contains( fet.id() );
+
+        bool rendered = false;
+        if ( QgsSymbol *symbol = renderer->symbolForFeature( fet, context ) )
+        {
+          rendered = symbol->renderWkb( fet, wkb, context, sel );
+          if ( !rendered )
+          {
+            // geometry type which cannot be rendered from WKB, e.g. curves
+            QgsFeature feature( fet );
+            feature.setGeometry( batch.geometry( row ) );
+            rendered = renderer->renderFeature( feature, context, -1, sel, false );
+          }
+        }
+
+        // as soon as first feature is rendered, we can start showing layer updates.
+        // but if we are blocking render updates (so that a previously cached image is being shown), we wait
+        // at most e.g. 3 seconds before we start forcing progressive updates.
+        if ( rendered && ( !mBlockRenderUpdates || mElapsedTimer.elapsed() > MAX_TIME_TO_USE_CACHED_PREVIEW_IMAGE ) )
+        {
+          mReadyToCompose = true;
+        }
+      }
+      catch ( const QgsCsException &cse )
+      {
+        Q_UNUSED( cse )
+        QgsDebugMsg( QStringLiteral( "Failed to transform a point while drawing a feature with ID '%1'. Ignoring this feature. %2" )
+                     .arg( fet.id() ).arg( cse.what() ) );
+      }
+    }
+  }
+
+  delete context.expressionContext().popScope();
+
+  stopRenderer( renderer, nullptr );
+}
+
 void QgsVectorLayerRenderer::drawRendererLevels( QgsFeatureRenderer *renderer, QgsFeatureIterator &fit )
 {
   const bool isMainRenderer = renderer == mRenderer;
@@ -545,6 +820,8 @@ void QgsVectorLayerRenderer::drawRendererLevels( QgsFeatureRenderer *renderer, Q
   if ( mApplyLabelClipGeometries )
     context.setFeatureClipGeometry( mLabelClipFeatureGeom );
 
+  const bool registerLabels = isMainRenderer && labelingRequired( context );
+
   // 1. fetch features
   QgsFeature fet;
   while ( fit.nextFeature( fet ) )
@@ -576,7 +853,7 @@ void QgsVectorLayerRenderer::drawRendererLevels( QgsFeatureRenderer *renderer, Q
     features[sym].append( fet );
 
     // new labeling engine
-    if ( isMainRenderer && context.labelingEngine() && ( mLabelProvider || mDiagramProvider ) )
+    if ( registerLabels && ( !mTiledLabelRegistry || mTiledLabelRegistry->claimFeature( fet.id() ) ) )
     {
       QgsGeometry obstacleGeometry;
       QgsSymbolList symbols = renderer->originalSymbolsForFeature( fet, context );
@@ -592,14 +869,7 @@ void QgsVectorLayerRenderer::drawRendererLevels( QgsFeatureRenderer *renderer, Q
         QgsExpressionContextUtils::updateSymbolScope( symbol, symbolScope );
       }
 
-      if ( mLabelProvider )
-      {
-        mLabelProvider->registerFeature( fet, context, obstacleGeometry, symbol );
-      }
-      if ( mDiagramProvider )
-      {
-        mDiagramProvider->registerFeature( fet, context, obstacleGeometry );
-      }
+      registerLabelFeature( fet, context, obstacleGeometry, symbol );
     }
   }
 
@@ -690,6 +960,32 @@ void QgsVectorLayerRenderer::drawRendererLevels( QgsFeatureRenderer *renderer, Q
   stopRenderer( renderer, selRenderer );
 }
 
+bool QgsVectorLayerRenderer::labelingRequired( const QgsRenderContext &context ) const
+{
+  if ( mTiledLabelRegistry )
+    return mTiledLabelRegistry->hasProviders();
+
+  return context.labelingEngine() && ( mLabelProvider || mDiagramProvider );
+}
+
+void QgsVectorLayerRenderer::registerLabelFeature( QgsFeature &feature, QgsRenderContext &context, const QgsGeometry &obstacleGeometry, const QgsSymbol *symbol )
+{
+  if ( mTiledLabelRegistry )
+  {
+    mTiledLabelRegistry->registerFeature( feature, context, obstacleGeometry, symbol );
+    return;
+  }
+
+  if ( mLabelProvider )
+  {
+    mLabelProvider->registerFeature( feature, context, obstacleGeometry, symbol );
+  }
+  if ( mDiagramProvider )
+  {
+    mDiagramProvider->registerFeature( feature, context, obstacleGeometry );
+  }
+}
+
 void QgsVectorLayerRenderer::stopRenderer( QgsFeatureRenderer *renderer, QgsSingleSymbolRenderer *selRenderer )
 {
   QgsRenderContext &context = *renderContext();
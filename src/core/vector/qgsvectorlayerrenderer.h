@@ -33,6 +33,8 @@ class QgsMapClippingRegion;
 #include <QList>
 #include <QPainter>
 #include <QElapsedTimer>
+#include <QMutex>
+#include <memory>
 
 typedef QList<int> QgsAttributeList;
 
@@ -47,6 +49,52 @@ typedef QList<int> QgsAttributeList;
 
 class QgsVectorLayerLabelProvider;
 class QgsVectorLayerDiagramProvider;
+class QgsSymbol;
+
+/**
+ * \ingroup core
+ * Registers features with the label and diagram providers of a vector layer renderer
+ * on behalf of several renderers which draw different spatial tiles of the same layer
+ * in parallel.
+ *
+ * Features which span more than one tile are only registered once, and registration
+ * is serialized so that the providers are never accessed from two threads at once.
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.18
+ */
+class QgsVectorLayerTiledLabelRegistry
+{
+  public:
+
+    /**
+     * Constructor for QgsVectorLayerTiledLabelRegistry, forwarding features to the specified
+     * \a labelProvider and \a diagramProvider (either of which may be NULLPTR).
+     */
+    QgsVectorLayerTiledLabelRegistry( QgsVectorLayerLabelProvider *labelProvider, QgsVectorLayerDiagramProvider *diagramProvider );
+
+    //! Returns TRUE if features should be registered, i.e. there is a label or diagram provider
+    bool hasProviders() const { return mLabelProvider || mDiagramProvider; }
+
+    /**
+     * Claims the \a feature for labeling. Returns FALSE if the feature was already
+     * claimed by another tile, in which case it must not be registered again.
+     */
+    bool claimFeature( QgsFeatureId id );
+
+    /**
+     * Registers a \a feature (previously claimed with claimFeature()) with the label and diagram providers.
+     */
+    void registerFeature( QgsFeature &feature, QgsRenderContext &context, const QgsGeometry &obstacleGeometry, const QgsSymbol *symbol );
+
+  private:
+
+    QgsVectorLayerLabelProvider *mLabelProvider = nullptr;
+    QgsVectorLayerDiagramProvider *mDiagramProvider = nullptr;
+
+    QMutex mMutex;
+    QgsFeatureIds mClaimedIds;
+};
 
 /**
  * \ingroup core
@@ -92,6 +140,31 @@ class QgsVectorLayerRenderer : public QgsMapLayerRenderer
 
     void setLayerRenderingTimeHint( int time ) override;
 
+    /**
+     * Makes a \a tileRenderer, which renders a different spatial tile of the same layer
+     * in parallel with this renderer, send its labels and diagrams to this renderer's label
+     * and diagram providers.
+     *
+     * The \a tileRenderer must have been created with a render context without a labeling
+     * engine, so that it does not register any providers of its own.
+     *
+     * \since QGIS 3.18
+     */
+    void shareLabelingWith( QgsVectorLayerRenderer *tileRenderer );
+
+    /**
+     * Restricts rendering to parts of the map. Features are fetched separately for each
+     * of the \a extents (in the layer's CRS), and drawn with the painter clipped to the
+     * corresponding \a clipRects (in painter coordinates).
+     *
+     * This is used to render only the newly exposed parts of the map when a previous render
+     * of the layer is reused after the map was panned. Layers which register labels or diagrams
+     * must not be rendered in parts, as features would be registered once for every part.
+     *
+     * \since QGIS 3.18
+     */
+    void setPartialRenderRegions( const QList< QgsRectangle > &extents, const QList< QRectF > &clipRects );
+
   private:
 
     /**
@@ -112,6 +185,24 @@ class QgsVectorLayerRenderer : public QgsMapLayerRenderer
      */
     void drawRendererLevels( QgsFeatureRenderer *renderer, QgsFeatureIterator &fit );
 
+    /**
+     * Returns TRUE if all features of the layer can be drawn with \a renderer using drawRendererWkb(),
+     * without constructing geometry objects for them.
+     */
+    bool canDrawRendererWkb( QgsFeatureRenderer *renderer );
+
+    /**
+     * Draw layer with \a renderer, fetching features in batches and rendering their geometries
+     * directly from WKB. QgsFeatureRenderer::startRender() needs to be called before using this method.
+     */
+    void drawRendererWkb( QgsFeatureRenderer *renderer, QgsFeatureIterator &fit );
+
+    //! Returns TRUE if features must be registered with label or diagram providers
+    bool labelingRequired( const QgsRenderContext &context ) const;
+
+    //! Registers a feature with the label and diagram providers (directly, or via the tiled label registry)
+    void registerLabelFeature( QgsFeature &feature, QgsRenderContext &context, const QgsGeometry &obstacleGeometry, const QgsSymbol *symbol );
+
     //! Stop version 2 renderer and selected renderer (if required)
     void stopRenderer( QgsFeatureRenderer *renderer, QgsSingleSymbolRenderer *selRenderer );
 
@@ -161,6 +252,15 @@ class QgsVectorLayerRenderer : public QgsMapLayerRenderer
      */
     QgsVectorLayerDiagramProvider *mDiagramProvider = nullptr;
 
+    /**
+     * Shared label registry, set when the layer is rendered as several spatial tiles
+     * by different renderers.
+     */
+    std::shared_ptr< QgsVectorLayerTiledLabelRegistry > mTiledLabelRegistry;
+
+    QList< QgsRectangle > mPartialRenderExtents;
+    QList< QRectF > mPartialRenderClipRects;
+
     QPainter::CompositionMode mFeatureBlendMode;
 
     QgsVectorSimplifyMethod mSimplifyMethod;
@@ -486,6 +486,7 @@ void QgsMapCanvas::setCachingEnabled( bool enabled )
   if ( enabled )
   {
     mCache = new QgsMapRendererCache;
+    mCache->setDiskCache( mDiskCache );
   }
   else
   {
@@ -505,6 +506,27 @@ void QgsMapCanvas::clearCache()
     mCache->clear();
 }
 
+void QgsMapCanvas::setDiskCache( QgsMapRendererDiskCache *cache )
+{
+  if ( cache == mDiskCache )
+    return;
+
+  if ( mJob && mJob->isActive() )
+  {
+    // wait for the current rendering to finish, before touching the cache
+    mJob->waitForFinished();
+  }
+
+  mDiskCache = cache;
+  if ( mCache )
+    mCache->setDiskCache( mDiskCache );
+}
+
+QgsMapRendererDiskCache *QgsMapCanvas::diskCache() const
+{
+  return mDiskCache;
+}
+
 void QgsMapCanvas::setParallelRenderingEnabled( bool enabled )
 {
   mUseParallelRendering = enabled;
@@ -620,6 +642,9 @@ void QgsMapCanvas::refreshMap()
   connect( mJob, &QgsMapRendererJob::finished, this, &QgsMapCanvas::rendererJobFinished );
   mJob->setCache( mCache );
   mJob->setLayerRenderingTimeHints( mLastLayerRenderTime );
+  // labels may only keep their previous placement if no layer changed since, e.g. an obstacle which moved
+  mJob->setPreviousLabelingResults( mLabelingResultsOutdated ? nullptr : mLabelingResults );
+  mLabelingResultsOutdated = false;
 
   mJob->start();
 
@@ -2376,6 +2401,7 @@ void QgsMapCanvas::connectNotify( const char *signal )
 
 void QgsMapCanvas::layerRepaintRequested( bool deferred )
 {
+  mLabelingResultsOutdated = true;
   if ( !deferred )
     refresh();
 }
@@ -61,6 +61,7 @@ class QgsVectorLayer;
 class QgsLabelingResults;
 
 class QgsMapRendererCache;
+class QgsMapRendererDiskCache;
 class QgsMapRendererQImageJob;
 class QgsMapSettings;
 class QgsMapCanvasMap;
@@ -184,6 +185,28 @@ class GUI_EXPORT QgsMapCanvas : public QGraphicsView
      */
     void clearCache();
 
+    /**
+     * Sets a persistent disk \a cache of rendered layer images, which is used behind the in-memory
+     * cache of the canvas while caching is enabled.
+     *
+     * Ownership of \a cache is not transferred, and it must exist for the lifetime of the canvas
+     * (or until another disk cache is set). Several canvases may share the same disk cache.
+     * Set to NULLPTR to disable the disk cache.
+     *
+     * \see diskCache()
+     * \see setCachingEnabled()
+     * \since QGIS 3.18
+     */
+    void setDiskCache( QgsMapRendererDiskCache *cache );
+
+    /**
+     * Returns the persistent disk cache of rendered layer images, or NULLPTR if no disk cache is set.
+     *
+     * \see setDiskCache()
+     * \since QGIS 3.18
+     */
+    QgsMapRendererDiskCache *diskCache() const;
+
     /**
      * Blocks until the rendering job has finished.
      *
@@ -1246,6 +1269,9 @@ class GUI_EXPORT QgsMapCanvas : public QGraphicsView
     //! Labeling results from the recently rendered map
     QgsLabelingResults *mLabelingResults = nullptr;
 
+    //! Whether a layer requested a repaint since the last render was started, so that its label placements can't be reused
+    bool mLabelingResultsOutdated = false;
+
     //! Whether layers are rendered sequentially or in parallel
     bool mUseParallelRendering = false;
 
@@ -1255,6 +1281,9 @@ class GUI_EXPORT QgsMapCanvas : public QGraphicsView
     //! Optionally use cache with rendered map layers for the current map settings
     QgsMapRendererCache *mCache = nullptr;
 
+    //! Optional persistent cache behind mCache
+    QgsMapRendererDiskCache *mDiskCache = nullptr;
+
     QTimer *mResizeTimer = nullptr;
     QTimer *mRefreshTimer = nullptr;
 
@@ -82,6 +82,22 @@ QgsDelimitedTextFeatureIterator::QgsDelimitedTextFeatureIterator( QgsDelimitedTe
     // for the subset.  Also means we don't have to test geometries unless doing exact
     // intersection
 
+    else if ( mSource->mUseSpatialIndex && mSource->mSidecarIndex )
+    {
+      // Entries are sorted by their position in the file, for efficient sequential retrieval
+      const QVector< QgsPackedSpatialIndexFile::Entry > entries = mSource->mSidecarIndex->intersects( mFilterRect );
+      mFeatureIds.reserve( entries.size() );
+      mFeaturePositions.reserve( entries.size() );
+      for ( const QgsPackedSpatialIndexFile::Entry &entry : entries )
+      {
+        mFeatureIds << entry.id;
+        mFeaturePositions << entry.offset;
+      }
+      QgsDebugMsgLevel( QStringLiteral( "Layer has spatial index file - selected %1 features from index" ).arg( mFeatureIds.size() ), 4 );
+      mMode = FeatureIds;
+      mTestSubset = false;
+      mTestGeometry = mTestGeometryExact;
+    }
     else if ( mSource->mUseSpatialIndex )
     {
       mFeatureIds = mSource->mSpatialIndex->intersects( mFilterRect );
@@ -101,6 +117,7 @@ QgsDelimitedTextFeatureIterator::QgsDelimitedTextFeatureIterator( QgsDelimitedTe
     {
       mFeatureIds = QList<QgsFeatureId>() << request.filterFid();
     }
+    mFeaturePositions.clear();
     mMode = FeatureIds;
     mTestSubset = false;
   }
@@ -202,11 +219,14 @@ bool QgsDelimitedTextFeatureIterator::fetchFeature( QgsFeature &feature )
     while ( ! gotFeature )
     {
       qint64 fid = -1;
+      qint64 position = -1;
       if ( mMode == FeatureIds )
       {
         if ( mNextId < mFeatureIds.size() )
         {
           fid = mFeatureIds.at( mNextId );
+          if ( mNextId < mFeaturePositions.size() )
+            position = mFeaturePositions.at( mNextId );
         }
       }
       else if ( mNextId < mSource->mSubsetIndex.size() )
@@ -215,7 +235,7 @@ bool QgsDelimitedTextFeatureIterator::fetchFeature( QgsFeature &feature )
       }
       if ( fid < 0 ) break;
       mNextId++;
-      gotFeature = ( setNextFeatureId( fid ) && nextFeatureInternal( feature ) );
+      gotFeature = ( setNextFeatureId( fid, position ) && nextFeatureInternal( feature ) );
     }
   }
 
@@ -256,6 +276,7 @@ bool QgsDelimitedTextFeatureIterator::close()
   iteratorClosed();
 
   mFeatureIds = QList<QgsFeatureId>();
+  mFeaturePositions.clear();
   mClosed = true;
   return true;
 }
@@ -391,11 +412,18 @@ bool QgsDelimitedTextFeatureIterator::nextFeatureInternal( QgsFeature &feature )
   return false;
 }
 
-bool QgsDelimitedTextFeatureIterator::setNextFeatureId( qint64 fid )
+bool QgsDelimitedTextFeatureIterator::setNextFeatureId( qint64 fid, qint64 position )
 {
+  if ( position >= 0 )
+    return mSource->mFile->setNextRecordPosition( ( long ) fid, position );
   return mSource->mFile->setNextRecordId( ( long ) fid );
 }
 
+qint64 QgsDelimitedTextFeatureIterator::recordPosition() const
+{
+  return mSource->mFile->recordPosition();
+}
+
 
 
 QgsGeometry QgsDelimitedTextFeatureIterator::loadGeometryWkt( const QStringList &tokens, bool &isNull )
@@ -561,6 +589,15 @@ QgsDelimitedTextFeatureSource::QgsDelimitedTextFeatureSource( const QgsDelimited
   mFile.reset( new QgsDelimitedTextFile() );
   mFile->setFromUrl( url );
 
+  if ( mUseSpatialIndex && p->mSidecarIndex )
+  {
+    // a spatial index file which does not match the data file any more is ignored until the file is rescanned
+    if ( p->mSidecarIndex->isUpToDate() )
+      mSidecarIndex = p->mSidecarIndex;
+    else
+      mUseSpatialIndex = false;
+  }
+
   mExpressionContext << QgsExpressionContextUtils::globalScope()
                      << QgsExpressionContextUtils::projectScope( QgsProject::instance() );
   mExpressionContext.setFields( mFields );
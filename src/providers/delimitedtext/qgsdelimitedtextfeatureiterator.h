@@ -36,6 +36,7 @@ class QgsDelimitedTextFeatureSource final: public QgsAbstractFeatureSource
     QgsRectangle mExtent;
     bool mUseSpatialIndex;
     std::unique_ptr< QgsSpatialIndex > mSpatialIndex;
+    std::shared_ptr< QgsPackedSpatialIndexFile > mSidecarIndex;
     bool mUseSubsetIndex;
     QList<quintptr> mSubsetIndex;
     std::unique_ptr< QgsDelimitedTextFile > mFile;
@@ -77,12 +78,15 @@ class QgsDelimitedTextFeatureIterator final: public QgsAbstractFeatureIteratorFr
     bool wantGeometry( const QgsPointXY &point ) const;
     bool wantGeometry( const QgsGeometry &geom ) const;
 
+    //! Returns the position in the file of the record of the last feature read
+    qint64 recordPosition() const;
+
   protected:
     bool fetchFeature( QgsFeature &feature ) override;
 
   private:
 
-    bool setNextFeatureId( qint64 fid );
+    bool setNextFeatureId( qint64 fid, qint64 position = -1 );
 
     bool nextFeatureInternal( QgsFeature &feature );
     QgsGeometry loadGeometryWkt( const QStringList &tokens, bool &isNull );
@@ -90,6 +94,8 @@ class QgsDelimitedTextFeatureIterator final: public QgsAbstractFeatureIteratorFr
     void fetchAttribute( QgsFeature &feature, int fieldIdx, const QStringList &tokens );
 
     QList<QgsFeatureId> mFeatureIds;
+    //! Positions of the records of mFeatureIds in the file, when known
+    QVector<qint64> mFeaturePositions;
     IteratorMode mMode = FileScan;
     long mNextId = 0;
     bool mTestSubset = false;
@@ -501,6 +501,49 @@ bool QgsDelimitedTextFile::setNextRecordId( long nextRecordId )
   return setNextLineNumber( nextRecordId );
 }
 
+// Record positions pack the position in the file of the start of the buffer holding the record,
+// and the position of the record within that buffer
+static const int RECORD_POSITION_BUFFER_BITS = 24;
+
+bool QgsDelimitedTextFile::setNextRecordPosition( long nextRecordId, qint64 position )
+{
+  if ( ! mFile ) reset();
+
+  mHoldCurrentRecord = nextRecordId == mRecordLineNumber;
+  if ( mHoldCurrentRecord ) return true;
+
+  // The first line is read differently, as its end of line character is not known yet
+  if ( position < 0 || ! mStream || mLineNumber < 1 || nextRecordId < 2 )
+    return setNextLineNumber( nextRecordId );
+
+  const qint64 bufferPosition = position >> RECORD_POSITION_BUFFER_BITS;
+  const int posInBuffer = static_cast< int >( position & ( ( 1 << RECORD_POSITION_BUFFER_BITS ) - 1 ) );
+
+  // Records are usually requested in file order, so only read the file again when the record
+  // is not in the current buffer
+  if ( bufferPosition != mBufferPosition || posInBuffer >= mBuffer.size() )
+  {
+    if ( mStream->seek( bufferPosition ) )
+    {
+      mBuffer = mStream->read( qMax( mMaxBufferSize, posInBuffer + 1 ) );
+      mBufferPosition = bufferPosition;
+    }
+    if ( bufferPosition != mBufferPosition || posInBuffer >= mBuffer.size() )
+    {
+      // the file does not match the position, scan it from its start
+      mStream->seek( 0 );
+      mLineNumber = 0;
+      mRecordNumber = -1;
+      return setNextLineNumber( nextRecordId );
+    }
+  }
+
+  mPosInBuffer = posInBuffer;
+  mLineNumber = nextRecordId - 1;
+  mRecordNumber = -1;
+  return true;
+}
+
 QgsDelimitedTextFile::Status QgsDelimitedTextFile::nextRecord( QStringList &record )
 {
 
@@ -515,6 +558,7 @@ QgsDelimitedTextFile::Status QgsDelimitedTextFile::nextRecord( QStringList &reco
   {
     // Invalidate the record line number, in get EOF
     mRecordLineNumber = -1;
+    mRecordPosition = -1;
 
     // Find the first non-blank line to read
     QString buffer;
@@ -523,6 +567,7 @@ QgsDelimitedTextFile::Status QgsDelimitedTextFile::nextRecord( QStringList &reco
 
     mCurrentRecord.clear();
     mRecordLineNumber = mLineNumber;
+    mRecordPosition = mLinePosition;
     if ( mRecordNumber >= 0 )
     {
       mRecordNumber++;
@@ -579,6 +624,7 @@ QgsDelimitedTextFile::Status QgsDelimitedTextFile::nextLine( QString &buffer, bo
   {
     mPosInBuffer = 0;
     mBuffer = mStream->read( mMaxBufferSize );
+    mBufferPosition = 0;
   }
 
   while ( !mBuffer.isEmpty() )
@@ -637,6 +683,7 @@ QgsDelimitedTextFile::Status QgsDelimitedTextFile::nextLine( QString &buffer, bo
       }
 
       // Extract the current line from the buffer
+      mLinePosition = linePosition();
       buffer = mBuffer.mid( mPosInBuffer, eolPos - mPosInBuffer );
       // Update current position in buffer to be the one next to the end of
       // line character(s)
@@ -650,6 +697,7 @@ QgsDelimitedTextFile::Status QgsDelimitedTextFile::nextLine( QString &buffer, bo
         // didn't find any end of line character, then return the whole buffer
         // (to avoid unbounded line sizes)
         // and set the buffer to null so that we don't iterate any more.
+        mLinePosition = linePosition();
         buffer = mBuffer;
         mBuffer = QString();
       }
@@ -658,6 +706,15 @@ QgsDelimitedTextFile::Status QgsDelimitedTextFile::nextLine( QString &buffer, bo
         // Read more bytes from file to have up to mMaxBufferSize characters
         // in our buffer (after having subset it from mPosInBuffer)
         mBuffer = mBuffer.mid( mPosInBuffer );
+        if ( mBufferPosition >= 0 )
+        {
+          // The new buffer starts with the remaining characters of the current one, which
+          // precede the current position in the file
+          const qint64 streamPosition = mStream->pos();
+          QTextCodec::ConverterState state( QTextCodec::IgnoreHeader );
+          mBufferPosition = streamPosition < 0 || !mStream->codec() ? -1
+                            : streamPosition - mStream->codec()->fromUnicode( mBuffer.constData(), mBuffer.size(), &state ).size();
+        }
         mBuffer += mStream->read( mMaxBufferSize - mBuffer.size() );
         mPosInBuffer = 0;
         continue;
@@ -672,6 +729,13 @@ QgsDelimitedTextFile::Status QgsDelimitedTextFile::nextLine( QString &buffer, bo
   return RecordEOF;
 }
 
+qint64 QgsDelimitedTextFile::linePosition() const
+{
+  if ( mBufferPosition < 0 || mPosInBuffer >= ( 1 << RECORD_POSITION_BUFFER_BITS ) )
+    return -1;
+  return ( mBufferPosition << RECORD_POSITION_BUFFER_BITS ) | mPosInBuffer;
+}
+
 bool QgsDelimitedTextFile::setNextLineNumber( long nextLineNumber )
 {
   if ( ! mStream ) return false;
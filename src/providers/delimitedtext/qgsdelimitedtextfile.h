@@ -293,6 +293,26 @@ class QgsDelimitedTextFile : public QObject
      */
     bool setNextRecordId( long nextRecordId );
 
+    /**
+     * Returns the position of the start of the last record read in the file, or -1 if
+     * it is not known.
+     *
+     * The position can be passed to setNextRecordPosition() to read the record again
+     * without scanning the file from its start.
+     */
+    qint64 recordPosition() const
+    {
+      return mRecordPosition;
+    }
+
+    /**
+     * Set the next record to return from its position in the file, as returned by recordPosition().
+     *  \param  nextRecordId The id of the record at this position
+     *  \param  position The position of the record
+     *  \returns valid  True if the next record can be located
+     */
+    bool setNextRecordPosition( long nextRecordId, qint64 position );
+
     /**
      * Number record number of records visited. After scanning the file
      *  serves as a record count.
@@ -392,6 +412,11 @@ class QgsDelimitedTextFile : public QObject
      */
     bool setNextLineNumber( long nextLineNumber );
 
+    /**
+     * Returns the position of the current line in the file, see recordPosition().
+     */
+    qint64 linePosition() const;
+
     /**
      * Utility routine to add a field to a record, accounting for trimming
      *  and discarding, and maximum field count
@@ -433,6 +458,11 @@ class QgsDelimitedTextFile : public QObject
     QString mBuffer;
     int mPosInBuffer = 0;
     int mMaxBufferSize = 0;
+    // Position in the file of the first character of mBuffer, or -1 if unknown
+    qint64 mBufferPosition = -1;
+    // Positions of the start of the last line and last record read, see recordPosition()
+    qint64 mLinePosition = -1;
+    qint64 mRecordPosition = -1;
     QChar mFirstEOLChar = 0; // '\r' if EOL is "\r" or "\r\n", or `\n' if EOL is "\n"
     QStringList mCurrentRecord;
     bool mHoldCurrentRecord = false;
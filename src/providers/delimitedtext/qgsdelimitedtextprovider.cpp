@@ -268,10 +268,73 @@ void QgsDelimitedTextProvider::resetIndexes() const
   mUseSpatialIndex = false;
 
   mSubsetIndex.clear();
+  mSidecarIndex.reset();
   if ( mBuildSpatialIndex && mGeomRep != GeomNone )
     mSpatialIndex = qgis::make_unique< QgsSpatialIndex >();
 }
 
+QString QgsDelimitedTextProvider::sidecarIndexOptions() const
+{
+  // all the options which define the records of the file and the geometries read from them, but
+  // not the options which only affect attributes or how the layer is watched
+  QUrlQuery query( mFile->url() );
+  query.removeAllQueryItems( QStringLiteral( "watchFile" ) );
+  if ( mGeomRep == GeomAsWkt )
+  {
+    query.addQueryItem( QStringLiteral( "wktField" ), mWktFieldName );
+  }
+  else if ( mGeomRep == GeomAsXy )
+  {
+    query.addQueryItem( QStringLiteral( "xField" ), mXFieldName );
+    query.addQueryItem( QStringLiteral( "yField" ), mYFieldName );
+    query.addQueryItem( QStringLiteral( "zField" ), mZFieldName );
+    query.addQueryItem( QStringLiteral( "mField" ), mMFieldName );
+    query.addQueryItem( QStringLiteral( "xyDms" ), mXyDms ? QStringLiteral( "yes" ) : QStringLiteral( "no" ) );
+    query.addQueryItem( QStringLiteral( "decimalPoint" ), mDecimalPoint );
+  }
+  query.addQueryItem( QStringLiteral( "crs" ), mCrs.toWkt( QgsCoordinateReferenceSystem::WKT_PREFERRED ) );
+  return query.toString( QUrl::FullyEncoded );
+}
+
+bool QgsDelimitedTextProvider::openSidecarIndex() const
+{
+  const QString options = sidecarIndexOptions();
+  mSidecarIndex = QgsPackedSpatialIndexFile::open( QgsPackedSpatialIndexFile::indexPath( mFile->fileName(), QString(), options ), mFile->fileName(), options );
+  return static_cast< bool >( mSidecarIndex );
+}
+
+void QgsDelimitedTextProvider::writeSidecarIndex( const std::vector< QgsPackedSpatialIndexFile::Entry > &entries ) const
+{
+  const QString options = sidecarIndexOptions();
+  const QString indexPath = QgsPackedSpatialIndexFile::indexPath( mFile->fileName(), QString(), options );
+  QString error;
+  if ( QgsPackedSpatialIndexFile::write( indexPath, mFile->fileName(), entries, &error, options ) )
+  {
+    mSidecarIndex = QgsPackedSpatialIndexFile::open( indexPath, mFile->fileName(), options );
+  }
+  else
+  {
+    // e.g. a read only directory, or on Windows an outdated index file which another layer still has memory mapped
+    QgsMessageLog::logMessage( tr( "Spatial index file of %1 cannot be written, using an in-memory spatial index instead: %2" ).arg( mFile->fileName(), error ),
+                               QStringLiteral( "DelimitedText" ), Qgis::Warning );
+  }
+
+  if ( !mSidecarIndex )
+  {
+    for ( const QgsPackedSpatialIndexFile::Entry &entry : entries )
+      mSpatialIndex->addFeature( entry.id, entry.bounds );
+  }
+}
+
+static QgsPackedSpatialIndexFile::Entry sidecarIndexEntry( QgsFeatureId id, qint64 position, const QgsRectangle &bounds )
+{
+  QgsPackedSpatialIndexFile::Entry entry;
+  entry.id = id;
+  entry.offset = position;
+  entry.bounds = bounds;
+  return entry;
+}
+
 bool QgsDelimitedTextProvider::createSpatialIndex()
 {
   if ( mBuildSpatialIndex )
@@ -335,6 +398,18 @@ void QgsDelimitedTextProvider::scanFile( bool buildIndexes )
     return;
   }
 
+  // Without a subset, the spatial index of the whole file is stored in a sidecar index file, which only
+  // needs to be written if there is no up to date one.
+
+  std::vector< QgsPackedSpatialIndexFile::Entry > sidecarEntries;
+  bool buildSidecarIndex = false;
+  bool buildMemoryIndex = buildSpatialIndex;
+  if ( buildSpatialIndex && !mSubsetExpression )
+  {
+    buildSidecarIndex = !openSidecarIndex();
+    buildMemoryIndex = false;
+  }
+
   // Open the file and get number of rows, etc. We assume that the
   // file has a header row and process accordingly. Caller should make
   // sure that the delimited file is properly formed.
@@ -473,7 +548,11 @@ void QgsDelimitedTextProvider::scanFile( bool buildIndexes )
                 QgsRectangle bbox( geom.boundingBox() );
                 mExtent.combineExtentWith( bbox );
               }
-              if ( buildSpatialIndex )
+              if ( buildSidecarIndex )
+              {
+                sidecarEntries.emplace_back( sidecarIndexEntry( mFile->recordId(), mFile->recordPosition(), geom.boundingBox() ) );
+              }
+              else if ( buildMemoryIndex )
               {
                 QgsFeature f;
                 f.setId( mFile->recordId() );
@@ -540,7 +619,11 @@ void QgsDelimitedTextProvider::scanFile( bool buildIndexes )
             foundFirstGeometry = true;
           }
           mNumberFeatures++;
-          if ( buildSpatialIndex && std::isfinite( pt.x() ) && std::isfinite( pt.y() ) )
+          if ( buildSidecarIndex && std::isfinite( pt.x() ) && std::isfinite( pt.y() ) )
+          {
+            sidecarEntries.emplace_back( sidecarIndexEntry( mFile->recordId(), mFile->recordPosition(), QgsRectangle( pt.x(), pt.y(), pt.x(), pt.y() ) ) );
+          }
+          else if ( buildMemoryIndex && std::isfinite( pt.x() ) && std::isfinite( pt.y() ) )
           {
             QgsFeature f;
             f.setId( mFile->recordId() );
@@ -812,6 +895,9 @@ void QgsDelimitedTextProvider::scanFile( bool buildIndexes )
       mSubsetIndex = QList<quintptr>();
   }
 
+  if ( buildSidecarIndex )
+    writeSidecarIndex( sidecarEntries );
+
   mUseSpatialIndex = buildSpatialIndex;
 
   mValid = mGeometryType != QgsWkbTypes::UnknownGeometry;
@@ -884,7 +970,18 @@ void QgsDelimitedTextProvider::rescanFile() const
 
   mSubsetIndex.clear();
   mUseSubsetIndex = false;
-  QgsFeatureIterator fi = getFeatures( QgsFeatureRequest() );
+  // Without a subset, the spatial index of the whole file is stored in a sidecar index file
+  std::vector< QgsPackedSpatialIndexFile::Entry > sidecarEntries;
+  bool buildSidecarIndex = false;
+  bool buildMemoryIndex = buildSpatialIndex;
+  if ( buildSpatialIndex && !mSubsetExpression )
+  {
+    buildSidecarIndex = !openSidecarIndex();
+    buildMemoryIndex = false;
+  }
+
+  // The iterator is used directly to get the positions of the records in the file
+  QgsDelimitedTextFeatureIterator fi( new QgsDelimitedTextFeatureSource( this ), true, QgsFeatureRequest() );
   mNumberFeatures = 0;
   mExtent = QgsRectangle();
   QgsFeature f;
@@ -893,17 +990,19 @@ void QgsDelimitedTextProvider::rescanFile() const
   {
     if ( mGeometryType != QgsWkbTypes::NullGeometry && f.hasGeometry() )
     {
+      const QgsRectangle bbox( f.geometry().boundingBox() );
       if ( !foundFirstGeometry )
       {
-        mExtent = f.geometry().boundingBox();
+        mExtent = bbox;
         foundFirstGeometry = true;
       }
       else
       {
-        QgsRectangle bbox( f.geometry().boundingBox() );
         mExtent.combineExtentWith( bbox );
       }
-      if ( buildSpatialIndex )
+      if ( buildSidecarIndex )
+        sidecarEntries.emplace_back( sidecarIndexEntry( f.id(), fi.recordPosition(), bbox ) );
+      else if ( buildMemoryIndex )
         mSpatialIndex->addFeature( f );
     }
     if ( buildSubsetIndex )
@@ -919,6 +1018,9 @@ void QgsDelimitedTextProvider::rescanFile() const
       mSubsetIndex.clear();
   }
 
+  if ( buildSidecarIndex )
+    writeSidecarIndex( sidecarEntries );
+
   mUseSpatialIndex = buildSpatialIndex;
 }
 
@@ -24,6 +24,7 @@
 #include "qgscoordinatereferencesystem.h"
 #include "qgsdelimitedtextfile.h"
 #include "qgsfields.h"
+#include "qgspackedspatialindexfile.h"
 
 #include "qgsprovidermetadata.h"
 
@@ -146,6 +147,24 @@ class QgsDelimitedTextProvider final: public QgsVectorDataProvider
     void rescanFile() const;
     void resetCachedSubset() const;
     void resetIndexes() const;
+
+    /**
+     * Returns the options which define the features of the sidecar spatial index, so that
+     * an index built with other options, e.g. other geometry fields, is never used.
+     */
+    QString sidecarIndexOptions() const;
+
+    /**
+     * Opens the sidecar spatial index file of the data file, if it is up to date. Returns FALSE if
+     * it must be built from the features of the file.
+     */
+    bool openSidecarIndex() const;
+
+    /**
+     * Writes the sidecar spatial index file from the \a entries of all features of the file. If the
+     * index file cannot be written, the features are added to the in-memory spatial index instead.
+     */
+    void writeSidecarIndex( const std::vector< QgsPackedSpatialIndexFile::Entry > &entries ) const;
     void clearInvalidLines() const;
     void recordInvalidLine( const QString &message );
     void reportErrors( const QStringList &messages = QStringList(), bool showDialog = false ) const;
@@ -228,6 +247,8 @@ class QgsDelimitedTextProvider final: public QgsVectorDataProvider
     mutable bool mUseSpatialIndex;
     mutable bool mCachedUseSpatialIndex;
     mutable std::unique_ptr< QgsSpatialIndex > mSpatialIndex;
+    //! Spatial index of the whole file stored next to it, used instead of mSpatialIndex when there is no subset
+    mutable std::shared_ptr< QgsPackedSpatialIndexFile > mSidecarIndex;
 
     friend class QgsDelimitedTextFeatureIterator;
     friend class QgsDelimitedTextFeatureSource;
@@ -1437,6 +1437,16 @@ PGresult *QgsPostgresConn::PQgetResult()
   return ::PQgetResult( mConn );
 }
 
+bool QgsPostgresConn::PQputCopyData( const char *data, int size )
+{
+  return ::PQputCopyData( mConn, data, size ) == 1;
+}
+
+bool QgsPostgresConn::PQputCopyEnd( const QString &errorMessage )
+{
+  return ::PQputCopyEnd( mConn, errorMessage.isEmpty() ? nullptr : errorMessage.toUtf8().constData() ) == 1;
+}
+
 PGresult *QgsPostgresConn::PQprepare( const QString &stmtName, const QString &query, int nParams, const Oid *paramTypes )
 {
   QMutexLocker locker( &mLock );
@@ -280,6 +280,19 @@ class QgsPostgresConn : public QObject
      */
     PGresult *PQgetResult();
 
+    /**
+     * PQputCopyData sends \a data to the server during a COPY FROM STDIN started with PQsendQuery
+     * Thread safety must be ensured by the caller by calling QgsPostgresConn::lock() and QgsPostgresConn::unlock()
+     */
+    bool PQputCopyData( const char *data, int size );
+
+    /**
+     * PQputCopyEnd ends a COPY FROM STDIN, or aborts it if \a errorMessage is not empty. The result of the COPY
+     * must then be retrieved with PQgetResult
+     * Thread safety must be ensured by the caller by calling QgsPostgresConn::lock() and QgsPostgresConn::unlock()
+     */
+    bool PQputCopyEnd( const QString &errorMessage = QString() );
+
     bool begin();
     bool commit();
     bool rollback();
@@ -12,6 +12,7 @@
  *   (at your option) any later version.                                   *
  *                                                                         *
  ***************************************************************************/
+#include "qgsfeaturebatch.h"
 #include "qgsgeometry.h"
 #include "qgspostgresconnpool.h"
 #include "qgspostgresexpressioncompiler.h"
@@ -321,6 +322,76 @@ bool QgsPostgresFeatureIterator::fetchFeature( QgsFeature &feature )
   return true;
 }
 
+int QgsPostgresFeatureIterator::fetchFeatureBatch( QgsFeatureBatch &batch, int maximumCount )
+{
+  if ( mRequest.filterType() == QgsFeatureRequest::FilterExpression && !mExpressionCompiled )
+    return -1;
+
+  if ( mTransform.isValid() )
+    return -1;
+
+  if ( mClosed )
+    return 0;
+
+  batch.setFields( mSource->mFields );
+  batch.reserve( maximumCount );
+
+  // features which were already queued by fetchFeature() come first
+  while ( !mFeatureQueue.empty() && batch.count() < maximumCount )
+    batch.appendFeature( mFeatureQueue.dequeue() );
+
+  if ( batch.count() < maximumCount && !mLastFetch )
+  {
+    const int fetchCount = maximumCount - batch.count();
+    QString fetch = QStringLiteral( "FETCH FORWARD %1 FROM %2" ).arg( fetchCount ).arg( mCursorName );
+    QgsDebugMsgLevel( QStringLiteral( "fetching batch of %1 features." ).arg( fetchCount ), 4 );
+
+    lock();
+    if ( mConn->PQsendQuery( fetch ) == 0 ) // fetch features asynchronously
+    {
+      QgsMessageLog::logMessage( QObject::tr( "Fetching from cursor %1 failed\nDatabase error: %2" ).arg( mCursorName, mConn->PQerrorMessage() ), QObject::tr( "PostGIS" ) );
+    }
+
+    // rows are decoded into a single scratch feature, which is then copied into the batch columns
+    QgsFeature scratch;
+    QgsPostgresResult queryResult;
+    for ( ;; )
+    {
+      queryResult = mConn->PQgetResult();
+      if ( !queryResult.result() )
+        break;
+
+      if ( queryResult.PQresultStatus() != PGRES_TUPLES_OK )
+      {
+        QgsMessageLog::logMessage( QObject::tr( "Fetching from cursor %1 failed\nDatabase error: %2" ).arg( mCursorName, mConn->PQerrorMessage() ), QObject::tr( "PostGIS" ) );
+        break;
+      }
+
+      int rows = queryResult.PQntuples();
+      mLastFetch = rows < fetchCount;
+
+      for ( int row = 0; row < rows; row++ )
+      {
+        if ( getFeature( queryResult, row, scratch ) )
+          batch.appendFeature( scratch );
+      }
+    }
+    unlock();
+  }
+
+  mFetched += batch.count();
+
+  if ( batch.count() < maximumCount )
+  {
+    QgsDebugMsg( QStringLiteral( "Finished after %1 features" ).arg( mFetched ) );
+    close();
+
+    mSource->mShared->ensureFeaturesCountedAtLeast( mFetched );
+  }
+
+  return batch.count();
+}
+
 bool QgsPostgresFeatureIterator::nextFeatureFilterExpression( QgsFeature &f )
 {
   if ( !mExpressionCompiled )
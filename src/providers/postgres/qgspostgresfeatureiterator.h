@@ -81,6 +81,7 @@ class QgsPostgresFeatureIterator final: public QgsAbstractFeatureIteratorFromSou
 
   protected:
     bool fetchFeature( QgsFeature &feature ) override;
+    int fetchFeatureBatch( QgsFeatureBatch &batch, int maximumCount ) override;
     bool nextFeatureFilterExpression( QgsFeature &f ) override;
     bool prepareSimplification( const QgsSimplifyMethod &simplifyMethod ) override;
 
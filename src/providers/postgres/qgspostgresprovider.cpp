@@ -28,6 +28,11 @@
 #include "qgsvectorlayer.h"
 
 #include <QMessageBox>
+#include <QtEndian>
+
+#include <cmath>
+#include <cstring>
+#include <limits>
 
 #include "qgsvectorlayerexporter.h"
 #include "qgspostgresprovider.h"
@@ -1432,6 +1437,10 @@ bool QgsPostgresProvider::hasSufficientPermsAndCapabilities()
       if ( testAccess.PQresultStatus() == PGRES_TUPLES_OK && testAccess.PQntuples() == 1 )
       {
         mEnabledCapabilities |= QgsVectorDataProvider::AddAttributes | QgsVectorDataProvider::DeleteAttributes | QgsVectorDataProvider::RenameAttributes;
+
+        // owners can index the geometries, e.g. after loading them
+        if ( !mGeometryColumn.isNull() )
+          mEnabledCapabilities |= QgsVectorDataProvider::CreateSpatialIndex;
       }
     }
   }
@@ -2300,6 +2309,24 @@ bool QgsPostgresProvider::addFeatures( QgsFeatureList &flist, Flags flags )
   {
     conn->begin();
 
+    // Optimization: if we have a single primary key column whose default value
+    // is a sequence, and that none of the features have a value set for that
+    // column, then we can completely omit inserting it.
+    const bool skipSinglePKField = canSkipSinglePrimaryKeyField( flist );
+
+    // Bulk load the features when their ids are not needed, e.g. when exporting
+    // layers, which is much faster than inserting them one by one
+    if ( ( flags & QgsFeatureSink::FastInsert ) && copyFeatures( conn, flist, skipSinglePKField ) )
+    {
+      returnvalue &= conn->commit();
+      if ( mTransaction )
+        mTransaction->dirtyLastSavePoint();
+
+      mShared->addFeaturesCounted( flist.size() );
+      conn->unlock();
+      return returnvalue;
+    }
+
     // Prepare the INSERT statement
     QString insert = QStringLiteral( "INSERT INTO %1(" ).arg( mQuery );
     QString values;
@@ -2318,35 +2345,10 @@ bool QgsPostgresProvider::addFeatures( QgsFeatureList &flist, Flags flags )
       delim = ',';
     }
 
-    // Optimization: if we have a single primary key column whose default value
-    // is a sequence, and that none of the features have a value set for that
-    // column, then we can completely omit inserting it.
-    bool skipSinglePKField = false;
     bool overrideIdentity = false;
 
     if ( ( mPrimaryKeyType == PktInt || mPrimaryKeyType == PktInt64 || mPrimaryKeyType == PktFidMap || mPrimaryKeyType == PktUint64 ) )
     {
-      if ( mPrimaryKeyAttrs.size() == 1 &&
-           defaultValueClause( mPrimaryKeyAttrs[0] ).startsWith( "nextval(" ) )
-      {
-        bool foundNonEmptyPK = false;
-        int idx = mPrimaryKeyAttrs[0];
-        QString defaultValue = defaultValueClause( idx );
-        for ( int i = 0; i < flist.size(); i++ )
-        {
-          QgsAttributes attrs2 = flist[i].attributes();
-          QVariant v2 = attrs2.value( idx, QVariant( QVariant::Int ) );
-          // a PK field with a sequence val is auto populate by QGIS with this default
-          // we are only interested in non default values
-          if ( !v2.isNull() && v2.toString() != defaultValue )
-          {
-            foundNonEmptyPK = true;
-            break;
-          }
-        }
-        skipSinglePKField = !foundNonEmptyPK;
-      }
-
       if ( !skipSinglePKField )
       {
         for ( int idx : mPrimaryKeyAttrs )
@@ -2632,6 +2634,412 @@ bool QgsPostgresProvider::addFeatures( QgsFeatureList &flist, Flags flags )
   return returnvalue;
 }
 
+bool QgsPostgresProvider::canSkipSinglePrimaryKeyField( const QgsFeatureList &flist ) const
+{
+  if ( ( mPrimaryKeyType != PktInt && mPrimaryKeyType != PktInt64 && mPrimaryKeyType != PktFidMap && mPrimaryKeyType != PktUint64 ) ||
+       mPrimaryKeyAttrs.size() != 1 )
+    return false;
+
+  const int idx = mPrimaryKeyAttrs[0];
+  const QString defaultValue = defaultValueClause( idx );
+  if ( !defaultValue.startsWith( "nextval(" ) )
+    return false;
+
+  for ( const QgsFeature &feature : flist )
+  {
+    const QVariant v = feature.attributes().value( idx, QVariant( QVariant::Int ) );
+    // a PK field with a sequence val is auto populate by QGIS with this default
+    // we are only interested in non default values
+    if ( !v.isNull() && v.toString() != defaultValue )
+      return false;
+  }
+
+  return true;
+}
+
+//! Appends an integer to a binary COPY buffer, in network byte order
+template <typename T>
+static void appendCopyInteger( QByteArray &buffer, T value )
+{
+  value = qToBigEndian( value );
+  buffer.append( reinterpret_cast< const char * >( &value ), sizeof( T ) );
+}
+
+//! Appends a field of \a size bytes to a binary COPY buffer
+static void appendCopyField( QByteArray &buffer, const char *data, int size )
+{
+  appendCopyInteger<qint32>( buffer, size );
+  buffer.append( data, size );
+}
+
+/**
+ * Appends the binary encoding of a numeric value, given as a decimal \a text, to a COPY buffer.
+ * Returns FALSE if the text is not a decimal number, e.g. for infinite values.
+ */
+static bool appendCopyNumeric( QByteArray &buffer, const QString &text )
+{
+  const QString number = text.trimmed();
+  if ( number.compare( QLatin1String( "nan" ), Qt::CaseInsensitive ) == 0 )
+  {
+    // no digits, NaN sign
+    appendCopyInteger<qint32>( buffer, 4 * sizeof( qint16 ) );
+    appendCopyInteger<qint16>( buffer, 0 );
+    appendCopyInteger<qint16>( buffer, 0 );
+    appendCopyInteger<quint16>( buffer, 0xC000 );
+    appendCopyInteger<qint16>( buffer, 0 );
+    return true;
+  }
+
+  // decimal digits of the number, and the number of them which are before the decimal point
+  QByteArray digits;
+  int pointPosition = -1;
+  bool negative = false;
+  int i = 0;
+  if ( i < number.size() && ( number.at( i ) == QLatin1Char( '-' ) || number.at( i ) == QLatin1Char( '+' ) ) )
+    negative = number.at( i++ ) == QLatin1Char( '-' );
+  for ( ; i < number.size(); ++i )
+  {
+    const QChar c = number.at( i );
+    if ( c >= QLatin1Char( '0' ) && c <= QLatin1Char( '9' ) )
+      digits.append( c.toLatin1() );
+    else if ( c == QLatin1Char( '.' ) && pointPosition < 0 )
+      pointPosition = digits.size();
+    else
+      break;
+  }
+  if ( digits.isEmpty() )
+    return false;
+  if ( pointPosition < 0 )
+    pointPosition = digits.size();
+
+  // exponent, as in the strings of double values
+  if ( i < number.size() )
+  {
+    if ( number.at( i ) != QLatin1Char( 'e' ) && number.at( i ) != QLatin1Char( 'E' ) )
+      return false;
+    bool ok = false;
+    const int exponent = number.mid( i + 1 ).toInt( &ok );
+    if ( !ok || qAbs( exponent ) > 10000 )
+      return false;
+    pointPosition += exponent;
+  }
+
+  // the display scale is the number of digits after the decimal point, including trailing zeros
+  const int scale = std::max( 0, digits.size() - pointPosition );
+
+  int firstDigit = 0;
+  while ( firstDigit < digits.size() && digits.at( firstDigit ) == '0' )
+    firstDigit++;
+  digits = digits.mid( firstDigit );
+  pointPosition -= firstDigit;
+
+  // the value is stored as base 10000 digits, aligned on the decimal point, and the weight of the first one
+  QVector< qint16 > groups;
+  int weight = 0;
+  if ( !digits.isEmpty() )
+  {
+    const int leftPadding = ( ( -pointPosition ) % 4 + 4 ) % 4;
+    digits.prepend( QByteArray( leftPadding, '0' ) );
+    pointPosition += leftPadding;
+    digits.append( QByteArray( ( 4 - digits.size() % 4 ) % 4, '0' ) );
+    weight = pointPosition / 4 - 1;
+    for ( int j = 0; j < digits.size(); j += 4 )
+      groups << digits.mid( j, 4 ).toShort();
+    while ( groups.last() == 0 )
+      groups.removeLast();
+  }
+
+  if ( scale > 0x3FFF || weight < std::numeric_limits< qint16 >::min() || weight > std::numeric_limits< qint16 >::max()
+       || groups.size() > std::numeric_limits< qint16 >::max() )
+    return false;
+
+  appendCopyInteger<qint32>( buffer, static_cast< qint32 >( ( 4 + groups.size() ) * sizeof( qint16 ) ) );
+  appendCopyInteger<qint16>( buffer, static_cast< qint16 >( groups.size() ) );
+  appendCopyInteger<qint16>( buffer, static_cast< qint16 >( weight ) );
+  appendCopyInteger<quint16>( buffer, negative && !groups.isEmpty() ? 0x4000 : 0 );
+  appendCopyInteger<qint16>( buffer, static_cast< qint16 >( scale ) );
+  for ( qint16 group : qgis::as_const( groups ) )
+    appendCopyInteger<qint16>( buffer, group );
+  return true;
+}
+
+/**
+ * Appends the binary encoding of a \a value for a field of type \a typeName to a COPY buffer.
+ * Returns FALSE if the type has no binary encoding here, or if the value can't be converted to it.
+ */
+static bool appendCopyValue( QByteArray &buffer, const QVariant &value, const QString &typeName )
+{
+  if ( value.isNull() )
+  {
+    appendCopyInteger<qint32>( buffer, -1 );
+    return true;
+  }
+
+  bool ok = false;
+  if ( typeName == QLatin1String( "int2" ) || typeName == QLatin1String( "int4" ) || typeName == QLatin1String( "int8" ) )
+  {
+    // don't round decimal values, which the server would reject
+    if ( value.type() == QVariant::Double && !qgsDoubleNear( value.toDouble(), std::round( value.toDouble() ), 0 ) )
+      return false;
+
+    const qlonglong v = value.toLongLong( &ok );
+    if ( !ok )
+      return false;
+
+    if ( typeName == QLatin1String( "int2" ) )
+    {
+      if ( v < std::numeric_limits< qint16 >::min() || v > std::numeric_limits< qint16 >::max() )
+        return false;
+      appendCopyInteger<qint32>( buffer, sizeof( qint16 ) );
+      appendCopyInteger<qint16>( buffer, static_cast< qint16 >( v ) );
+    }
+    else if ( typeName == QLatin1String( "int4" ) )
+    {
+      if ( v < std::numeric_limits< qint32 >::min() || v > std::numeric_limits< qint32 >::max() )
+        return false;
+      appendCopyInteger<qint32>( buffer, sizeof( qint32 ) );
+      appendCopyInteger<qint32>( buffer, static_cast< qint32 >( v ) );
+    }
+    else
+    {
+      appendCopyInteger<qint32>( buffer, sizeof( qint64 ) );
+      appendCopyInteger<qint64>( buffer, v );
+    }
+  }
+  else if ( typeName == QLatin1String( "float4" ) || typeName == QLatin1String( "float8" ) )
+  {
+    const double v = value.toDouble( &ok );
+    if ( !ok )
+      return false;
+
+    if ( typeName == QLatin1String( "float4" ) )
+    {
+      const float f = static_cast< float >( v );
+      quint32 bits;
+      std::memcpy( &bits, &f, sizeof( bits ) );
+      appendCopyInteger<qint32>( buffer, sizeof( bits ) );
+      appendCopyInteger<quint32>( buffer, bits );
+    }
+    else
+    {
+      quint64 bits;
+      std::memcpy( &bits, &v, sizeof( bits ) );
+      appendCopyInteger<qint32>( buffer, sizeof( bits ) );
+      appendCopyInteger<quint64>( buffer, bits );
+    }
+  }
+  else if ( typeName == QLatin1String( "bool" ) )
+  {
+    // strings like "f" would be true for QVariant, leave them to the server
+    if ( value.type() != QVariant::Bool && value.type() != QVariant::Int && value.type() != QVariant::LongLong )
+      return false;
+
+    const char v = value.toBool() ? 1 : 0;
+    appendCopyField( buffer, &v, 1 );
+  }
+  else if ( typeName == QLatin1String( "text" ) || typeName == QLatin1String( "varchar" ) || typeName == QLatin1String( "bpchar" ) )
+  {
+    if ( value.type() == QVariant::List || value.type() == QVariant::StringList || value.type() == QVariant::Map )
+      return false;
+
+    const QByteArray v = value.toString().toUtf8();
+    appendCopyField( buffer, v.constData(), v.size() );
+  }
+  else if ( typeName == QLatin1String( "numeric" ) )
+  {
+    if ( value.type() == QVariant::Bool || value.type() == QVariant::List || value.type() == QVariant::StringList || value.type() == QVariant::Map )
+      return false;
+
+    // values are encoded from their text, so that decimal strings keep all their digits
+    return appendCopyNumeric( buffer, value.toString() );
+  }
+  else if ( typeName == QLatin1String( "bytea" ) )
+  {
+    if ( value.type() != QVariant::ByteArray )
+      return false;
+
+    const QByteArray v = value.toByteArray();
+    appendCopyField( buffer, v.constData(), v.size() );
+  }
+  // date and times are encoded as integers, which is how the server stores them since PostgreSQL 8.4
+  else if ( typeName == QLatin1String( "date" ) )
+  {
+    const QDate v = value.toDate();
+    if ( !v.isValid() )
+      return false;
+
+    // days since the PostgreSQL epoch
+    appendCopyInteger<qint32>( buffer, sizeof( qint32 ) );
+    appendCopyInteger<qint32>( buffer, static_cast< qint32 >( QDate( 2000, 1, 1 ).daysTo( v ) ) );
+  }
+  else if ( typeName == QLatin1String( "time" ) )
+  {
+    const QTime v = value.toTime();
+    if ( !v.isValid() )
+      return false;
+
+    // microseconds since midnight
+    appendCopyInteger<qint32>( buffer, sizeof( qint64 ) );
+    appendCopyInteger<qint64>( buffer, QTime( 0, 0 ).msecsTo( v ) * 1000LL );
+  }
+  else if ( typeName == QLatin1String( "timestamp" ) )
+  {
+    const QDateTime v = value.toDateTime();
+    if ( !v.isValid() )
+      return false;
+
+    // microseconds since the PostgreSQL epoch, for the date and time as they are, as the type has no time zone
+    appendCopyInteger<qint32>( buffer, sizeof( qint64 ) );
+    appendCopyInteger<qint64>( buffer, QDate( 2000, 1, 1 ).daysTo( v.date() ) * 86400000000LL + QTime( 0, 0 ).msecsTo( v.time() ) * 1000LL );
+  }
+  else
+  {
+    return false;
+  }
+
+  return true;
+}
+
+void QgsPostgresProvider::appendCopyGeometry( const QgsGeometry &geom, QByteArray &buffer ) const
+{
+  if ( geom.isNull() )
+  {
+    appendCopyInteger<qint32>( buffer, -1 );
+    return;
+  }
+
+  QgsGeometry convertedGeom( convertToProviderType( geom ) );
+  if ( convertedGeom.isNull() )
+    convertedGeom = geom;
+  if ( QgsWkbTypes::isMultiType( wkbType() ) && !convertedGeom.isMultipart() )
+    convertedGeom.convertToMultiType();
+
+  // geometries are written in the byte order of the machine, only their header differs between WKB and EWKB,
+  // which has flags for the dimensions and carries the SRID
+  const QByteArray wkb( convertedGeom.asWkb() );
+  const QgsWkbTypes::Type type = convertedGeom.wkbType();
+  quint32 ewkbType = static_cast< quint32 >( QgsWkbTypes::flatType( type ) ) | 0x20000000;
+  if ( QgsWkbTypes::hasZ( type ) )
+    ewkbType |= 0x80000000;
+  if ( QgsWkbTypes::hasM( type ) )
+    ewkbType |= 0x40000000;
+  const quint32 srid = ( mRequestedSrid.isEmpty() ? mDetectedSrid : mRequestedSrid ).toUInt();
+
+  appendCopyInteger<qint32>( buffer, wkb.size() + static_cast< int >( sizeof( srid ) ) );
+  buffer.append( wkb.constData(), 1 );
+  buffer.append( reinterpret_cast< const char * >( &ewkbType ), sizeof( ewkbType ) );
+  buffer.append( reinterpret_cast< const char * >( &srid ), sizeof( srid ) );
+  buffer.append( wkb.constData() + 5, wkb.size() - 5 );
+}
+
+bool QgsPostgresProvider::copyFeatures( QgsPostgresConn *conn, const QgsFeatureList &flist, bool skipSinglePKField ) const
+{
+  // COPY options need PostgreSQL 9.0, and only plain geometries are sent as EWKB
+  if ( conn->pgVersion() < 90000 || ( !mGeometryColumn.isNull() && mSpatialColType != SctGeometry ) )
+    return false;
+
+  QStringList columns;
+  if ( !mGeometryColumn.isNull() )
+    columns << quotedIdentifier( mGeometryColumn );
+
+  QList<int> fieldIds;
+  QStringList defaultValues;
+  for ( int idx = 0; idx < mAttributeFields.count(); ++idx )
+  {
+    const QString fieldName = mAttributeFields.at( idx ).name();
+    if ( ( skipSinglePKField && idx == mPrimaryKeyAttrs.at( 0 ) ) ||
+         !mGeneratedValues.value( idx ).isEmpty() ||
+         fieldName.isEmpty() || fieldName == mGeometryColumn )
+      continue;
+
+    // COPY can't override identity values generated always
+    if ( mIdentityFields.value( idx ) == 'a' )
+      return false;
+
+    columns << quotedIdentifier( fieldName );
+    fieldIds << idx;
+    defaultValues << defaultValueClause( idx );
+  }
+
+  if ( columns.isEmpty() )
+    return false;
+
+  // encode all the features before starting the COPY, so that they can still be inserted
+  // one by one if any of them can't be copied
+  QByteArray buffer;
+  buffer.append( "PGCOPY\n\377\r\n\0", 11 );
+  // flags and header extension length
+  appendCopyInteger<qint32>( buffer, 0 );
+  appendCopyInteger<qint32>( buffer, 0 );
+
+  for ( const QgsFeature &feature : flist )
+  {
+    const QgsAttributes attrs = feature.attributes();
+
+    appendCopyInteger<qint16>( buffer, static_cast< qint16 >( columns.size() ) );
+    if ( !mGeometryColumn.isNull() )
+      appendCopyGeometry( feature.geometry(), buffer );
+
+    for ( int i = 0; i < fieldIds.size(); ++i )
+    {
+      const int idx = fieldIds.at( i );
+      const QVariant value = attrs.value( idx, QVariant( QVariant::Int ) ); // default to NULL for missing attributes
+
+      // default values have to be evaluated by the server
+      if ( !defaultValues.at( i ).isEmpty() && ( value.isNull() || value.toString() == defaultValues.at( i ) ) )
+        return false;
+
+      if ( !appendCopyValue( buffer, value, mAttributeFields.at( idx ).typeName() ) )
+        return false;
+    }
+  }
+
+  // trailer
+  appendCopyInteger<qint16>( buffer, -1 );
+
+  const QString copy = QStringLiteral( "COPY %1(%2) FROM STDIN (FORMAT binary)" ).arg( mQuery, columns.join( ',' ) );
+  QgsDebugMsgLevel( QStringLiteral( "copy features: %1" ).arg( copy ), 2 );
+
+  QString error;
+  if ( !conn->PQsendQuery( copy ) )
+  {
+    error = conn->PQerrorMessage();
+  }
+  else
+  {
+    QgsPostgresResult result( conn->PQgetResult() );
+    if ( result.PQresultStatus() != PGRES_COPY_IN )
+    {
+      error = result.PQresultErrorMessage();
+    }
+    else
+    {
+      if ( !conn->PQputCopyData( buffer.constData(), buffer.size() ) )
+      {
+        error = conn->PQerrorMessage();
+        conn->PQputCopyEnd( error );
+      }
+      else if ( !conn->PQputCopyEnd() )
+      {
+        error = conn->PQerrorMessage();
+      }
+
+      result = conn->PQgetResult();
+      if ( error.isEmpty() && result.PQresultStatus() != PGRES_COMMAND_OK )
+        error = result.PQresultErrorMessage();
+    }
+
+    // consume the remaining results, so that the connection can be used again
+    while ( PGresult *res = conn->PQgetResult() )
+      ::PQclear( res );
+  }
+
+  if ( !error.isEmpty() )
+    throw PGException( error );
+
+  return true;
+}
+
 bool QgsPostgresProvider::deleteFeatures( const QgsFeatureIds &ids )
 {
   if ( ids.isEmpty() )
@@ -3526,6 +3934,38 @@ QgsFeatureSource::SpatialIndexPresence QgsPostgresProvider::hasSpatialIndex() co
   }
 }
 
+bool QgsPostgresProvider::createSpatialIndex()
+{
+  if ( mIsQuery || mGeometryColumn.isNull() || ( mSpatialColType != SctGeometry && mSpatialColType != SctGeography ) )
+    return false;
+
+  // nothing to do if the table is already indexed, e.g. by a previous export
+  if ( hasSpatialIndex() == SpatialIndexPresent )
+    return true;
+
+  QgsPostgresConn *conn = connectionRW();
+  if ( !conn )
+  {
+    return false;
+  }
+
+  const QString sql = QStringLiteral( "CREATE INDEX %1 ON %2 USING GIST (%3)" )
+                      .arg( quotedIdentifier( QStringLiteral( "sidx_%1_%2" ).arg( mTableName, mGeometryColumn ) ),
+                            mQuery,
+                            quotedIdentifier( mGeometryColumn ) );
+  QgsPostgresResult result( conn->PQexec( sql ) );
+  if ( result.PQresultStatus() != PGRES_COMMAND_OK )
+  {
+    pushError( tr( "PostGIS error while creating spatial index: %1" ).arg( result.PQresultErrorMessage() ) );
+    return false;
+  }
+
+  if ( mTransaction )
+    mTransaction->dirtyLastSavePoint();
+
+  return true;
+}
+
 bool QgsPostgresProvider::setSubsetString( const QString &theSQL, bool updateFeatureCount )
 {
   if ( theSQL.trimmed() == mSqlWhereClause )
@@ -196,6 +196,7 @@ class QgsPostgresProvider final: public QgsVectorDataProvider
     bool supportsSubsetString() const override { return true; }
     QgsVectorDataProvider::Capabilities capabilities() const override;
     SpatialIndexPresence hasSpatialIndex() const override;
+    bool createSpatialIndex() override;
 
     /**
      * The Postgres provider does its own transforms so we return
@@ -450,6 +451,10 @@ class QgsPostgresProvider final: public QgsVectorDataProvider
           : mWhat( r.PQresultErrorMessage() )
         {}
 
+        explicit PGException( const QString &message )
+          : mWhat( message )
+        {}
+
         QString errorMessage() const
         {
           return mWhat;
@@ -469,6 +474,26 @@ class QgsPostgresProvider final: public QgsVectorDataProvider
 
     QString paramValue( const QString &fieldvalue, const QString &defaultValue ) const;
 
+    /**
+     * Returns TRUE if the single primary key field, whose default value is a sequence, can be omitted
+     * when inserting the features of \a flist, because none of them have a value set for it.
+     */
+    bool canSkipSinglePrimaryKeyField( const QgsFeatureList &flist ) const;
+
+    /**
+     * Bulk loads the features of \a flist with a binary COPY FROM STDIN.
+     *
+     * Returns FALSE without sending anything if the features can't be copied, e.g. when a field type has
+     * no binary encoding here or when a default value must be evaluated, in which case features must be
+     * inserted instead.
+     *
+     * \throws PGException if the server fails to copy the features
+     */
+    bool copyFeatures( QgsPostgresConn *conn, const QgsFeatureList &flist, bool skipSinglePKField ) const;
+
+    //! Appends the EWKB of a \a geom to the COPY \a buffer, with the SRID of the layer
+    void appendCopyGeometry( const QgsGeometry &geom, QByteArray &buffer ) const;
+
     QgsPostgresConn *mConnectionRO = nullptr ; //!< Read-only database connection (initially)
     QgsPostgresConn *mConnectionRW = nullptr ; //!< Read-write database connection (on update)
 
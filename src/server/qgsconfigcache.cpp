@@ -20,8 +20,45 @@
 #include "qgsserverexception.h"
 #include "qgsstorebadlayerinfo.h"
 #include "qgsserverprojectutils.h"
+#include "qgscoordinatetransform.h"
+#include "qgsmaplayer.h"
 
 #include <QFile>
+#include <QElapsedTimer>
+
+/**
+ * Prepares the coordinate transforms from the layers of a \a project to its
+ * reference system and to the WMS output reference systems.
+ */
+static void warmUpTransforms( const QgsProject &project )
+{
+  QList< QgsCoordinateReferenceSystem > sourceCrsList;
+  const QMap< QString, QgsMapLayer * > layers = project.mapLayers( true );
+  for ( const QgsMapLayer *layer : layers )
+  {
+    const QgsCoordinateReferenceSystem crs = layer->crs();
+    if ( crs.isValid() && !sourceCrsList.contains( crs ) )
+      sourceCrsList << crs;
+  }
+
+  QList< QgsCoordinateReferenceSystem > destinationCrsList;
+  if ( project.crs().isValid() )
+    destinationCrsList << project.crs();
+  const QStringList outputCrsList = QgsServerProjectUtils::wmsOutputCrsList( project );
+  for ( const QString &authId : outputCrsList )
+  {
+    const QgsCoordinateReferenceSystem crs = QgsCoordinateReferenceSystem::fromOgcWmsCrs( authId );
+    if ( crs.isValid() && !destinationCrsList.contains( crs ) )
+      destinationCrsList << crs;
+  }
+
+  QElapsedTimer timer;
+  timer.start();
+  const int count = QgsCoordinateTransform::warmUpCache( sourceCrsList, destinationCrsList, project.transformContext() );
+  QgsMessageLog::logMessage(
+    QStringLiteral( "Prepared %1 coordinate transforms for project %2 in %3 ms" ).arg( count ).arg( project.fileName() ).arg( timer.elapsed() ),
+    QStringLiteral( "Server" ), Qgis::Info );
+}
 
 QgsConfigCache *QgsConfigCache::instance()
 {
@@ -107,6 +144,10 @@ const QgsProject *QgsConfigCache::project( const QString &path, const QgsServerS
           }
         }
       }
+      if ( settings && settings->warmUpTransforms() )
+      {
+        warmUpTransforms( *prj );
+      }
       mProjectCache.insert( path, prj.release() );
       mFileSystemWatcher.addPath( path );
     }
@@ -267,6 +267,17 @@ void QgsServerSettings::initSettings()
 
   mSettings[ sLogProfile.envVar ] = sLogProfile;
 
+  // warm up coordinate transforms
+  const Setting sWarmUpTransforms = { QgsServerSettingsEnv::QGIS_SERVER_WARM_UP_TRANSFORMS,
+                                      QgsServerSettingsEnv::DEFAULT_VALUE,
+                                      QStringLiteral( "Prepare the coordinate transforms used by a project when it is loaded" ),
+                                      QString(),
+                                      QVariant::Bool,
+                                      QVariant( false ),
+                                      QVariant()
+                                    };
+  mSettings[ sWarmUpTransforms.envVar ] = sWarmUpTransforms;
+
 }
 
 void QgsServerSettings::load()
@@ -512,6 +523,11 @@ bool QgsServerSettings::getPrintDisabled() const
   return value( QgsServerSettingsEnv::QGIS_SERVER_DISABLE_GETPRINT ).toBool();
 }
 
+bool QgsServerSettings::warmUpTransforms() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_WARM_UP_TRANSFORMS ).toBool();
+}
+
 bool QgsServerSettings::logProfile()
 {
   return value( QgsServerSettingsEnv::QGIS_SERVER_LOG_PROFILE, false ).toBool();
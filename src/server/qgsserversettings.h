@@ -71,6 +71,7 @@ class SERVER_EXPORT QgsServerSettingsEnv : public QObject
       QGIS_SERVER_LANDING_PAGE_PROJECTS_DIRECTORIES, //!< Directories used by the landing page service to find .qgs and .qgz projects (since QGIS 3.16)
       QGIS_SERVER_LANDING_PAGE_PROJECTS_PG_CONNECTIONS, //!< PostgreSQL connection strings used by the landing page service to find projects (since QGIS 3.16)
       QGIS_SERVER_LOG_PROFILE, //!< When QGIS_SERVER_LOG_LEVEL is 0 this flag adds to the logs detailed information about the time taken by the different processing steps inside the QGIS Server request (since QGIS 3.16)
+      QGIS_SERVER_WARM_UP_TRANSFORMS, //!< Prepare the coordinate transforms between the layers and the advertised output reference systems when a project is loaded. Improves the time of the first requests. (since QGIS 3.18)
     };
     Q_ENUM( EnvVar )
 };
@@ -276,6 +277,18 @@ class SERVER_EXPORT QgsServerSettings
      */
     bool getPrintDisabled() const;
 
+    /**
+     * Returns TRUE if the coordinate transforms between the layers of a project and the
+     * project and advertised WMS output reference systems are prepared when the project is loaded,
+     * instead of during the first requests which need them.
+     *
+     * The default value is FALSE, this value can be changed by setting the environment
+     * variable QGIS_SERVER_WARM_UP_TRANSFORMS.
+     *
+     * \since QGIS 3.18
+     */
+    bool warmUpTransforms() const;
+
     /**
      * Returns the string representation of a setting.
      * \since QGIS 3.16
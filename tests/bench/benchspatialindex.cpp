@@ -0,0 +1,161 @@
+/***************************************************************************
+     benchspatialindex.cpp
+     ---------------------
+    Date                 : February 2021
+    Copyright            : (C) 2021 by QGIS.org
+    Email                : info at qgis dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgstest.h"
+#include <QObject>
+
+#include "qgsapplication.h"
+#include "qgsgeometry.h"
+#include "qgsspatialindex.h"
+#include "qgsvectorlayer.h"
+#include "qgsvectordataprovider.h"
+
+#include <memory>
+
+/**
+ * Compares the build and query times of the R-tree spatial index with the static
+ * index built with QgsSpatialIndex::FlagStaticIndex, e.g.:
+ *
+ *     qgis_bench_spatialindex -iterations 5
+ */
+class BenchSpatialIndex : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void build_data();
+    void build();
+    void intersects_data();
+    void intersects();
+    void nearestNeighbor_data();
+    void nearestNeighbor();
+
+  private:
+    void addIndexTypes();
+
+    //! Number of features of the benchmark layer
+    static constexpr int FEATURE_COUNT = 200000;
+
+    //! Number of queries of each query benchmark
+    static constexpr int QUERY_COUNT = 10000;
+
+    std::unique_ptr< QgsVectorLayer > mLayer;
+    QVector< QgsRectangle > mQueries;
+};
+
+void BenchSpatialIndex::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+
+  // a fixed pseudo random set of small boxes, so that results are comparable between runs
+  quint32 seed = 1;
+  auto random = [&seed]( double max )
+  {
+    seed = seed * 1664525 + 1013904223;
+    return max * ( seed >> 8 ) / static_cast< double >( 1 << 24 );
+  };
+
+  mLayer = qgis::make_unique< QgsVectorLayer >( QStringLiteral( "Polygon?crs=epsg:3857" ), QStringLiteral( "boxes" ), QStringLiteral( "memory" ) );
+  QgsFeatureList features;
+  features.reserve( FEATURE_COUNT );
+  for ( int i = 0; i < FEATURE_COUNT; ++i )
+  {
+    const double x = random( 100000 );
+    const double y = random( 100000 );
+    QgsFeature feature;
+    feature.setGeometry( QgsGeometry::fromRect( QgsRectangle( x, y, x + random( 200 ), y + random( 200 ) ) ) );
+    features << feature;
+  }
+  mLayer->dataProvider()->addFeatures( features );
+
+  for ( int i = 0; i < QUERY_COUNT; ++i )
+  {
+    const double x = random( 100000 );
+    const double y = random( 100000 );
+    mQueries << QgsRectangle( x, y, x + 1000, y + 1000 );
+  }
+}
+
+void BenchSpatialIndex::cleanupTestCase()
+{
+  mLayer.reset();
+  QgsApplication::exitQgis();
+}
+
+void BenchSpatialIndex::addIndexTypes()
+{
+  QTest::addColumn< int >( "flags" );
+  QTest::newRow( "rtree" ) << static_cast< int >( QgsSpatialIndex::FlagStoreFeatureGeometries );
+  QTest::newRow( "static" ) << static_cast< int >( QgsSpatialIndex::FlagStoreFeatureGeometries | QgsSpatialIndex::FlagStaticIndex );
+}
+
+void BenchSpatialIndex::build_data()
+{
+  addIndexTypes();
+}
+
+void BenchSpatialIndex::build()
+{
+  QFETCH( int, flags );
+
+  QBENCHMARK
+  {
+    const QgsSpatialIndex index( *mLayer, nullptr, static_cast< QgsSpatialIndex::Flags >( flags ) );
+    Q_UNUSED( index )
+  }
+}
+
+void BenchSpatialIndex::intersects_data()
+{
+  addIndexTypes();
+}
+
+void BenchSpatialIndex::intersects()
+{
+  QFETCH( int, flags );
+
+  const QgsSpatialIndex index( *mLayer, nullptr, static_cast< QgsSpatialIndex::Flags >( flags ) );
+  long long count = 0;
+  QBENCHMARK
+  {
+    for ( const QgsRectangle &query : qgis::as_const( mQueries ) )
+      count += index.intersects( query ).size();
+  }
+  QVERIFY( count > 0 );
+}
+
+void BenchSpatialIndex::nearestNeighbor_data()
+{
+  addIndexTypes();
+}
+
+void BenchSpatialIndex::nearestNeighbor()
+{
+  QFETCH( int, flags );
+
+  const QgsSpatialIndex index( *mLayer, nullptr, static_cast< QgsSpatialIndex::Flags >( flags ) );
+  long long count = 0;
+  QBENCHMARK
+  {
+    for ( const QgsRectangle &query : qgis::as_const( mQueries ) )
+      count += index.nearestNeighbor( query.center(), 5 ).size();
+  }
+  QVERIFY( count > 0 );
+}
+
+QGSTEST_MAIN( BenchSpatialIndex )
+#include "benchspatialindex.moc"
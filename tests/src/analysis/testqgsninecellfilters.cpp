@@ -22,6 +22,7 @@
 #include "qgstotalcurvaturefilter.h"
 #include "qgsapplication.h"
 #include "qgssettings.h"
+#include "qgsogrutils.h"
 
 #ifdef HAVE_OPENCL
 #include "qgsopenclutils.h"
@@ -32,6 +33,31 @@
 // If true regenerate raster reference images
 const bool REGENERATE_REFERENCES = false;
 
+/**
+ * Returns the value of the top left neighbour of each cell, to check that every cell
+ * is filtered with the right neighbours.
+ */
+class TopLeftFilter : public QgsNineCellFilter
+{
+  public:
+    TopLeftFilter( const QString &inputFile, const QString &outputFile, bool threadSafe )
+      : QgsNineCellFilter( inputFile, outputFile, QStringLiteral( "GTiff" ) )
+      , mThreadSafe( threadSafe )
+    {}
+
+    float processNineCellWindow( float *x11, float *, float *,
+                                 float *, float *, float *,
+                                 float *, float *, float * ) override
+    {
+      return *x11 == mInputNodataValue ? mOutputNodataValue : *x11;
+    }
+
+    bool isThreadSafe() const override { return mThreadSafe; }
+
+  private:
+    bool mThreadSafe = false;
+};
+
 class TestNineCellFilters : public QObject
 {
     Q_OBJECT
@@ -47,6 +73,7 @@ class TestNineCellFilters : public QObject
     void testAspect();
     void testRuggedness();
     void testTotalCurvature();
+    void testNeighbours();
 #ifdef HAVE_OPENCL
     void testHillshadeCl();
     void testSlopeCl();
@@ -215,6 +242,39 @@ void TestNineCellFilters::testTotalCurvature()
   _testAlg<QgsTotalCurvatureFilter>( QStringLiteral( "totalcurvature" ) );
 }
 
+void TestNineCellFilters::testNeighbours()
+{
+  gdal::dataset_unique_ptr input( GDALOpen( SRC_FILE.toUtf8().constData(), GA_ReadOnly ) );
+  QVERIFY( input );
+  const int xSize = GDALGetRasterXSize( input.get() );
+  const int ySize = GDALGetRasterYSize( input.get() );
+  GDALRasterBandH inputBand = GDALGetRasterBand( input.get(), 1 );
+  const float nodata = static_cast< float >( GDALGetRasterNoDataValue( inputBand, nullptr ) );
+  std::vector< float > inputValues( static_cast< std::size_t >( xSize ) * ySize );
+  QCOMPARE( GDALRasterIO( inputBand, GF_Read, 0, 0, xSize, ySize, inputValues.data(), xSize, ySize, GDT_Float32, 0, 0 ), CE_None );
+
+  // rows are filtered by bands, in parallel or not
+  for ( bool threadSafe : { false, true } )
+  {
+    const QString outputFile = tempFile( threadSafe ? QStringLiteral( "neighbours_parallel" ) : QStringLiteral( "neighbours" ) );
+    TopLeftFilter filter( SRC_FILE, outputFile, threadSafe );
+    QCOMPARE( filter.processRaster(), 0 );
+
+    gdal::dataset_unique_ptr output( GDALOpen( outputFile.toUtf8().constData(), GA_ReadOnly ) );
+    QVERIFY( output );
+    std::vector< float > outputValues( inputValues.size() );
+    QCOMPARE( GDALRasterIO( GDALGetRasterBand( output.get(), 1 ), GF_Read, 0, 0, xSize, ySize, outputValues.data(), xSize, ySize, GDT_Float32, 0, 0 ), CE_None );
+
+    for ( int y = 0; y < ySize; ++y )
+    {
+      for ( int x = 0; x < xSize; ++x )
+      {
+        const float expected = x == 0 || y == 0 || inputValues[( y - 1 ) * xSize + x - 1] == nodata ? -9999 : inputValues[( y - 1 ) * xSize + x - 1];
+        QCOMPARE( outputValues[ y * xSize + x ], expected );
+      }
+    }
+  }
+}
 
 QGSTEST_MAIN( TestNineCellFilters )
 
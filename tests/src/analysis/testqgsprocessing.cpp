@@ -645,6 +645,7 @@ class TestQgsProcessing: public QObject
     void parameterType();
     void sourceTypeToString_data();
     void sourceTypeToString();
+    void modelPipelineFeatures();
     void modelSource();
 
   private:
@@ -11625,6 +11626,115 @@ void TestQgsProcessing::sourceTypeToString()
   QCOMPARE( QgsProcessing::sourceTypeToString( sourceType ), expected );
 }
 
+void TestQgsProcessing::modelPipelineFeatures()
+{
+  QgsVectorLayer *layer = new QgsVectorLayer( QStringLiteral( "Point?crs=epsg:3111&field=id:integer" ), QStringLiteral( "points" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer->isValid() );
+  QgsFeatureList features;
+  for ( int i = 0; i < 100; ++i )
+  {
+    QgsFeature f;
+    f.setAttributes( QgsAttributes() << i );
+    f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( i, 2 * i ) ) );
+    features << f;
+  }
+  QVERIFY( layer->dataProvider()->addFeatures( features ) );
+  QgsProject p;
+  p.addMapLayer( layer );
+
+  QgsProcessingContext context;
+  context.setProject( &p );
+
+  // a chain of three feature based algorithms, where only the last one is a model output
+  QgsProcessingModelAlgorithm model( QStringLiteral( "test" ), QStringLiteral( "testGroup" ) );
+  QgsProcessingModelParameter param;
+  param.setParameterName( QStringLiteral( "LAYER" ) );
+  model.addModelParameter( new QgsProcessingParameterFeatureSource( QStringLiteral( "LAYER" ) ), param );
+
+  QString previous;
+  for ( int i = 1; i <= 3; ++i )
+  {
+    QgsProcessingModelChildAlgorithm child;
+    child.setChildId( QStringLiteral( "translate%1" ).arg( i ) );
+    child.setAlgorithmId( QStringLiteral( "native:translategeometry" ) );
+    child.addParameterSources( QStringLiteral( "INPUT" ), QList< QgsProcessingModelChildParameterSource >() << ( previous.isEmpty() ? QgsProcessingModelChildParameterSource::fromModelParameter( QStringLiteral( "LAYER" ) )
+                               : QgsProcessingModelChildParameterSource::fromChildOutput( previous, QStringLiteral( "OUTPUT" ) ) ) );
+    child.addParameterSources( QStringLiteral( "DELTA_X" ), QList< QgsProcessingModelChildParameterSource >() << QgsProcessingModelChildParameterSource::fromStaticValue( i ) );
+    if ( i == 3 )
+    {
+      QMap<QString, QgsProcessingModelOutput> outputs;
+      QgsProcessingModelOutput output( QStringLiteral( "TRANSLATED" ) );
+      output.setChildOutputName( QStringLiteral( "OUTPUT" ) );
+      outputs.insert( QStringLiteral( "TRANSLATED" ), output );
+      child.setModelOutputs( outputs );
+    }
+    model.addChildAlgorithm( child );
+    previous = child.childId();
+  }
+
+  std::unique_ptr< QgsProcessingAlgorithm > alg( model.create() );
+  QVERIFY( alg->parameterDefinition( QStringLiteral( "PIPELINE_FEATURES" ) ) );
+  QVERIFY( alg->parameterDefinition( QStringLiteral( "PIPELINE_FEATURES" ) )->flags() & QgsProcessingParameterDefinition::FlagHidden );
+
+  QgsProcessingFeedback feedback;
+  QVariantMap params;
+  params.insert( QStringLiteral( "LAYER" ), QStringLiteral( "points" ) );
+  params.insert( QStringLiteral( "translate3:TRANSLATED" ), QgsProcessing::TEMPORARY_OUTPUT );
+
+  bool ok = false;
+  const QVariantMap results = alg->run( params, context, &feedback, &ok );
+  QVERIFY( ok );
+
+  params.insert( QStringLiteral( "PIPELINE_FEATURES" ), true );
+  std::unique_ptr< QgsProcessingAlgorithm > pipelinedAlg( model.create() );
+  const QVariantMap pipelinedResults = pipelinedAlg->run( params, context, &feedback, &ok );
+  QVERIFY( ok );
+
+  // the intermediate outputs are streamed, so are not available as results
+  QVERIFY( !results.value( QStringLiteral( "CHILD_RESULTS" ) ).toMap().value( QStringLiteral( "translate1" ) ).toMap().isEmpty() );
+  QVERIFY( pipelinedResults.value( QStringLiteral( "CHILD_RESULTS" ) ).toMap().value( QStringLiteral( "translate1" ) ).toMap().isEmpty() );
+  QVERIFY( pipelinedResults.value( QStringLiteral( "CHILD_RESULTS" ) ).toMap().value( QStringLiteral( "translate2" ) ).toMap().isEmpty() );
+
+  // but the model output is the same
+  QgsVectorLayer *output = qobject_cast< QgsVectorLayer * >( context.getMapLayer( results.value( QStringLiteral( "translate3:TRANSLATED" ) ).toString() ) );
+  QgsVectorLayer *pipelinedOutput = qobject_cast< QgsVectorLayer * >( context.getMapLayer( pipelinedResults.value( QStringLiteral( "translate3:TRANSLATED" ) ).toString() ) );
+  QVERIFY( output );
+  QVERIFY( pipelinedOutput );
+  QCOMPARE( pipelinedOutput->featureCount(), 100L );
+  QCOMPARE( pipelinedOutput->fields().names(), output->fields().names() );
+  QCOMPARE( pipelinedOutput->crs(), output->crs() );
+
+  QgsFeatureIterator it = output->getFeatures();
+  QgsFeatureIterator pipelinedIt = pipelinedOutput->getFeatures();
+  QgsFeature f;
+  QgsFeature pipelinedFeature;
+  int count = 0;
+  while ( it.nextFeature( f ) )
+  {
+    QVERIFY( pipelinedIt.nextFeature( pipelinedFeature ) );
+    QCOMPARE( pipelinedFeature.attributes(), f.attributes() );
+    QCOMPARE( pipelinedFeature.geometry().asWkt(), f.geometry().asWkt() );
+    QCOMPARE( f.geometry().asWkt(), QStringLiteral( "Point (%1 %2)" ).arg( f.attribute( 0 ).toInt() + 6 ).arg( f.attribute( 0 ).toInt() * 2 ) );
+    count++;
+  }
+  QCOMPARE( count, 100 );
+
+  // the inputs of children reading streamed features refer to the child producing them
+  QCOMPARE( pipelinedResults.value( QStringLiteral( "CHILD_INPUTS" ) ).toMap().value( QStringLiteral( "translate2" ) ).toMap().value( QStringLiteral( "INPUT" ) ), QVariant( QStringLiteral( "translate1" ) ) );
+  QCOMPARE( pipelinedResults.value( QStringLiteral( "CHILD_INPUTS" ) ).toMap().value( QStringLiteral( "translate3" ) ).toMap().value( QStringLiteral( "INPUT" ) ), QVariant( QStringLiteral( "translate2" ) ) );
+
+  // outputs which are used by expressions can't be streamed
+  QgsProcessingModelChildAlgorithm lastChild = model.childAlgorithm( QStringLiteral( "translate3" ) );
+  lastChild.addParameterSources( QStringLiteral( "DELTA_Y" ), QList< QgsProcessingModelChildParameterSource >() << QgsProcessingModelChildParameterSource::fromExpression( QStringLiteral( "@translate2_OUTPUT_maxx" ) ) );
+  model.setChildAlgorithm( lastChild );
+  std::unique_ptr< QgsProcessingAlgorithm > expressionAlg( model.create() );
+  const QVariantMap expressionResults = expressionAlg->run( params, context, &feedback, &ok );
+  QVERIFY( ok );
+  QVERIFY( expressionResults.value( QStringLiteral( "CHILD_RESULTS" ) ).toMap().value( QStringLiteral( "translate1" ) ).toMap().isEmpty() );
+  QVERIFY( !expressionResults.value( QStringLiteral( "CHILD_RESULTS" ) ).toMap().value( QStringLiteral( "translate2" ) ).toMap().isEmpty() );
+  QCOMPARE( expressionResults.value( QStringLiteral( "CHILD_INPUTS" ) ).toMap().value( QStringLiteral( "translate3" ) ).toMap().value( QStringLiteral( "DELTA_Y" ) ).toDouble(), 102.0 );
+}
+
 void TestQgsProcessing::modelSource()
 {
   QgsProcessingModelChildParameterSource source;
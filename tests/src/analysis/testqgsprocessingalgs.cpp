@@ -29,6 +29,7 @@
 #include "qgsalgorithmimportphotos.h"
 #include "qgsalgorithmtransform.h"
 #include "qgsalgorithmkmeansclustering.h"
+#include "qgsalgorithmdissolve.h"
 #include "qgsvectorlayer.h"
 #include "qgscategorizedsymbolrenderer.h"
 #include "qgssinglesymbolrenderer.h"
@@ -178,6 +179,10 @@ class TestQgsProcessingAlgs: public QObject
 
     void fileDownloader();
 
+    void parallelFeatures();
+    void parallelOverlay();
+    void cascadedUnion();
+
   private:
 
     bool imageCheck( const QString &testName, const QString &renderedImage );
@@ -6488,6 +6493,164 @@ void TestQgsProcessingAlgs::fileDownloader()
   QVERIFY( results.value( QStringLiteral( "OUTPUT" ) ).toString().endsWith( QLatin1String( ".txt" ) ) );
 }
 
+void TestQgsProcessingAlgs::parallelFeatures()
+{
+  std::unique_ptr< QgsProcessingAlgorithm > alg( QgsApplication::processingRegistry()->createAlgorithmById( QStringLiteral( "native:simplifygeometries" ) ) );
+  QVERIFY( alg != nullptr );
+  QVERIFY( alg->flags() & QgsProcessingAlgorithm::FlagSupportsParallelFeatures );
+
+  std::unique_ptr< QgsProcessingContext > context = qgis::make_unique< QgsProcessingContext >();
+  QgsProject p;
+  context->setProject( &p );
+
+  // enough features for several chunks of features on any number of threads
+  QgsVectorLayer *layer = new QgsVectorLayer( QStringLiteral( "LineString?crs=EPSG:3857&field=id:integer&field=tolerance:double" ), QStringLiteral( "lines" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer->isValid() );
+  QgsFeatureList features;
+  QList< QgsGeometry > expected;
+  for ( int i = 0; i < 20000; ++i )
+  {
+    QgsFeature f;
+    f.setAttributes( QgsAttributes() << i << ( i % 5 ) * 0.1 );
+    f.setGeometry( QgsGeometry::fromWkt( QStringLiteral( "LineString (%1 0, %2 0.15, %3 0.05, %4 0.4, %5 0)" ).arg( i ).arg( i + 0.2 ).arg( i + 0.4 ).arg( i + 0.6 ).arg( i + 0.8 ) ) );
+    features << f;
+    expected << f.geometry().simplify( ( i % 5 ) * 0.1 );
+  }
+  // a feature without geometry
+  QgsFeature noGeometry;
+  noGeometry.setAttributes( QgsAttributes() << 20000 << 0.1 );
+  features << noGeometry;
+  expected << QgsGeometry();
+  QVERIFY( layer->dataProvider()->addFeatures( features ) );
+  p.addMapLayer( layer );
+
+  QVariantMap parameters;
+  parameters.insert( QStringLiteral( "INPUT" ), QStringLiteral( "lines" ) );
+  parameters.insert( QStringLiteral( "METHOD" ), 0 );
+  parameters.insert( QStringLiteral( "TOLERANCE" ), QgsProperty::fromField( QStringLiteral( "tolerance" ) ) );
+  parameters.insert( QStringLiteral( "OUTPUT" ), QgsProcessing::TEMPORARY_OUTPUT );
+
+  QgsProcessingFeedback feedback;
+  bool ok = false;
+  const QVariantMap results = alg->run( parameters, *context, &feedback, &ok );
+  QVERIFY( ok );
+
+  // features are processed concurrently, but output in the order of the input features
+  QgsVectorLayer *outputLayer = qobject_cast< QgsVectorLayer * >( context->getMapLayer( results.value( QStringLiteral( "OUTPUT" ) ).toString() ) );
+  QVERIFY( outputLayer );
+  QCOMPARE( outputLayer->featureCount(), 20001L );
+  QgsFeatureIterator it = outputLayer->getFeatures();
+  QgsFeature f;
+  int i = 0;
+  while ( it.nextFeature( f ) )
+  {
+    QCOMPARE( f.attribute( 0 ).toInt(), i );
+    QCOMPARE( f.geometry().asWkt( 6 ), expected.at( i ).asWkt( 6 ) );
+    i++;
+  }
+  QCOMPARE( i, 20001 );
+}
+
+void TestQgsProcessingAlgs::parallelOverlay()
+{
+  std::unique_ptr< QgsProcessingContext > context = qgis::make_unique< QgsProcessingContext >();
+  QgsProject p;
+  context->setProject( &p );
+
+  // two grids of unit squares, shifted by half a square, with enough squares for several batches of features
+  auto gridLayer = [&p]( const QString & name, double offset )
+  {
+    QgsVectorLayer *layer = new QgsVectorLayer( QStringLiteral( "Polygon?crs=EPSG:3857&field=id:integer" ), name, QStringLiteral( "memory" ) );
+    QgsFeatureList features;
+    for ( int i = 0; i < 40; ++i )
+    {
+      for ( int j = 0; j < 40; ++j )
+      {
+        QgsFeature f;
+        f.setAttributes( QgsAttributes() << i * 40 + j );
+        f.setGeometry( QgsGeometry::fromRect( QgsRectangle( i + offset, j + offset, i + offset + 1, j + offset + 1 ) ) );
+        features << f;
+      }
+    }
+    layer->dataProvider()->addFeatures( features );
+    p.addMapLayer( layer );
+    return layer;
+  };
+  gridLayer( QStringLiteral( "a" ), 0 );
+  gridLayer( QStringLiteral( "b" ), 0.5 );
+
+  QVariantMap parameters;
+  parameters.insert( QStringLiteral( "INPUT" ), QStringLiteral( "a" ) );
+  parameters.insert( QStringLiteral( "OVERLAY" ), QStringLiteral( "b" ) );
+  parameters.insert( QStringLiteral( "OUTPUT" ), QgsProcessing::TEMPORARY_OUTPUT );
+
+  auto runOverlay = [&]( const QString & algorithmId, int expectedLastId, double expectedArea )
+  {
+    std::unique_ptr< QgsProcessingAlgorithm > alg( QgsApplication::processingRegistry()->createAlgorithmById( algorithmId ) );
+    QVERIFY( alg != nullptr );
+
+    QgsProcessingFeedback feedback;
+    bool ok = false;
+    const QVariantMap results = alg->run( parameters, *context, &feedback, &ok );
+    QVERIFY( ok );
+
+    QgsVectorLayer *outputLayer = qobject_cast< QgsVectorLayer * >( context->getMapLayer( results.value( QStringLiteral( "OUTPUT" ) ).toString() ) );
+    QVERIFY( outputLayer );
+
+    // features are overlaid concurrently, but output in the order of the input features
+    double area = 0;
+    int previousId = -1;
+    QgsFeature f;
+    QgsFeatureIterator it = outputLayer->getFeatures();
+    while ( it.nextFeature( f ) )
+    {
+      QVERIFY( f.attribute( 0 ).toInt() >= previousId );
+      previousId = f.attribute( 0 ).toInt();
+      area += f.geometry().area();
+    }
+    QCOMPARE( previousId, expectedLastId );
+    QGSCOMPARENEAR( area, expectedArea, 1e-6 );
+  };
+
+  runOverlay( QStringLiteral( "native:intersection" ), 1599, 39.5 * 39.5 );
+  // only the squares along the bottom and left edges of the first grid are not completely covered by the second grid
+  runOverlay( QStringLiteral( "native:difference" ), 1560, 1600 - 39.5 * 39.5 );
+}
+
+void TestQgsProcessingAlgs::cascadedUnion()
+{
+  // a grid of touching squares, with enough squares for several levels of tiles
+  QVector< QgsGeometry > squares;
+  for ( int i = 0; i < 60; ++i )
+  {
+    for ( int j = 0; j < 50; ++j )
+      squares << QgsGeometry::fromRect( QgsRectangle( i, j, i + 1, j + 1 ) );
+  }
+
+  QgsFeedback feedback;
+  const QgsGeometry result = QgsDissolveAlgorithm::cascadedUnion( squares, &feedback );
+  QVERIFY( result.lastError().isEmpty() );
+  QCOMPARE( QgsWkbTypes::geometryType( result.wkbType() ), QgsWkbTypes::PolygonGeometry );
+  QCOMPARE( result.constGet()->partCount(), 1 );
+  QGSCOMPARENEAR( result.area(), 3000, 1e-6 );
+  QVERIFY( result.isGeosEqual( QgsGeometry::fromRect( QgsRectangle( 0, 0, 60, 50 ) ) ) );
+  QCOMPARE( feedback.progress(), 100.0 );
+
+  // disjoint squares are kept as separate parts
+  QVector< QgsGeometry > disjoint;
+  for ( int i = 0; i < 1000; ++i )
+    disjoint << QgsGeometry::fromRect( QgsRectangle( 2 * i, 0, 2 * i + 1, 1 ) );
+  QCOMPARE( QgsDissolveAlgorithm::cascadedUnion( disjoint ).constGet()->partCount(), 1000 );
+
+  // few geometries are unioned at once
+  QVERIFY( QgsDissolveAlgorithm::cascadedUnion( squares.mid( 0, 2 ) ).isGeosEqual( QgsGeometry::fromRect( QgsRectangle( 0, 0, 1, 2 ) ) ) );
+
+  // a canceled union returns a null geometry
+  QgsFeedback canceledFeedback;
+  canceledFeedback.cancel();
+  QVERIFY( QgsDissolveAlgorithm::cascadedUnion( squares, &canceledFeedback ).isNull() );
+}
+
 void TestQgsProcessingAlgs::exportMeshTimeSeries()
 {
   std::unique_ptr< QgsProcessingAlgorithm > alg( QgsApplication::processingRegistry()->createAlgorithmById( QStringLiteral( "native:meshexporttimeseries" ) ) );
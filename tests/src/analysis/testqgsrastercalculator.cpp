@@ -20,6 +20,7 @@ Email                : nyall dot dawson at gmail dot com
 
 #include "qgsrastercalculator.h"
 #include "qgsrastercalcnode.h"
+#include "qgsrastercalckernel.h"
 #include "qgsrasterdataprovider.h"
 #include "qgsrasterlayer.h"
 #include "qgsrastermatrix.h"
@@ -54,6 +55,7 @@ class TestQgsRasterCalculator : public QObject
 
     void rasterRefOp();
     void dualOpRasterRaster(); //test dual op on raster ref and raster ref
+    void kernel(); //test compiled expressions against node calculation
 
     void calcWithLayers();
     void calcWithReprojectedLayers();
@@ -432,6 +434,71 @@ void TestQgsRasterCalculator::dualOpRasterRaster()
   QCOMPARE( result.data()[5], -9999.0 );
 }
 
+void TestQgsRasterCalculator::kernel()
+{
+  QgsRasterBlock m1( Qgis::Float32, 3, 2 );
+  m1.setNoDataValue( -1.0 );
+  m1.setValue( 0, 0, 1.0 );
+  m1.setValue( 0, 1, 2.0 );
+  m1.setValue( 0, 2, -2.0 );
+  m1.setValue( 1, 0, -1.0 ); //nodata
+  m1.setValue( 1, 1, 0.0 );
+  m1.setValue( 1, 2, 4.0 );
+  QMap<QString, QgsRasterBlock *> rasterData;
+  rasterData.insert( QStringLiteral( "raster1" ), &m1 );
+
+  QgsRasterBlock m2( Qgis::Float32, 3, 2 );
+  m2.setNoDataValue( -2.0 );
+  m2.setValue( 0, 0, 2.0 );
+  m2.setValue( 0, 1, 0.0 );
+  m2.setValue( 0, 2, 0.5 );
+  m2.setValue( 1, 0, 3.0 );
+  m2.setValue( 1, 1, -2.0 ); //nodata
+  m2.setValue( 1, 2, 8.0 );
+  rasterData.insert( QStringLiteral( "raster2" ), &m2 );
+
+  const QStringList expressions
+  {
+    QStringLiteral( "\"raster1\" + 2 * \"raster2\"" ),
+    QStringLiteral( "\"raster1\" / \"raster2\" - 1" ),
+    QStringLiteral( "\"raster1\" ^ \"raster2\"" ),
+    QStringLiteral( "sqrt( \"raster1\" ) + ln( \"raster2\" )" ),
+    QStringLiteral( "( \"raster1\" > 0 AND \"raster2\" < 5 ) * max( \"raster1\", \"raster2\" )" ),
+    QStringLiteral( "-abs( \"raster1\" - \"raster1\" * \"raster2\" ) >= 1" ),
+  };
+
+  for ( const QString &expression : expressions )
+  {
+    QString error;
+    std::unique_ptr< QgsRasterCalcNode > node( QgsRasterCalcNode::parseRasterCalcString( expression, error ) );
+    QVERIFY2( node, error.toUtf8().constData() );
+
+    QgsRasterMatrix expected( 1, 1, nullptr, -9999 );
+    QVERIFY( node->calculate( rasterData, expected ) );
+
+    std::unique_ptr< QgsRasterCalcKernel > kernel = QgsRasterCalcKernel::compile( *node );
+    QVERIFY( kernel );
+    QVector< const QgsRasterBlock * > inputs;
+    const QStringList references = kernel->rasterReferences();
+    for ( const QString &reference : references )
+      inputs << rasterData.value( reference );
+
+    // evaluate the cells in two chunks, as concurrent evaluations do
+    std::vector< float > result( 6 );
+    kernel->evaluate( inputs, 0, 4, result.data(), -9999 );
+    kernel->evaluate( inputs, 4, 2, result.data() + 4, -9999 );
+
+    for ( int i = 0; i < 6; ++i )
+    {
+      QCOMPARE( result[i], static_cast< float >( expected.data()[i] ) );
+    }
+  }
+
+  // matrices are not compiled
+  QgsRasterCalcNode matrixNode( new QgsRasterMatrix( 2, 1, new double[2] { 1.0, 2.0 }, -9999 ) );
+  QVERIFY( !QgsRasterCalcKernel::compile( matrixNode ) );
+}
+
 void TestQgsRasterCalculator::calcWithLayers()
 {
   QgsRasterCalculatorEntry entry1;
@@ -23,6 +23,15 @@
 #include "qgstest.h"
 #include "qgsexception.h"
 #include "qgslogger.h"
+#include "qgscoordinatetransformkernel_p.h"
+#include "qgsfeaturebatch.h"
+#include "qgsgeometry.h"
+#include "qgsprojutils.h"
+
+#if PROJ_VERSION_MAJOR>=6
+#include <proj.h>
+#endif
+#include <thread>
 
 class TestQgsCoordinateTransform: public QObject
 {
@@ -48,6 +57,13 @@ class TestQgsCoordinateTransform: public QObject
     void transformErrorOnePoint();
     void testDeprecated4240to4326();
     void testCustomProjTransform();
+    void kernel_data();
+    void kernel();
+    void kernelUnsupported();
+    void transformCoordsKernel();
+    void transformFeatureBatch();
+    void cacheStatistics();
+    void cacheProjObjectsSharedBetweenThreads();
 };
 
 
@@ -635,6 +651,301 @@ void TestQgsCoordinateTransform::testCustomProjTransform()
 #endif
 }
 
+void TestQgsCoordinateTransform::kernel_data()
+{
+  QTest::addColumn<QString>( "definition" );
+  QTest::addColumn<double>( "xMin" );
+  QTest::addColumn<double>( "yMin" );
+  QTest::addColumn<double>( "xMax" );
+  QTest::addColumn<double>( "yMax" );
+  QTest::addColumn<double>( "forwardTolerance" );
+  QTest::addColumn<double>( "inverseTolerance" );
+
+  QTest::newRow( "4326 to 3857" ) << QStringLiteral( "proj=pipeline step proj=unitconvert xy_in=deg xy_out=rad step proj=webmerc lat_0=0 lon_0=0 x_0=0 y_0=0 ellps=WGS84" )
+                                  << -179.0 << -85.0 << 179.0 << 85.0 << 0.000001 << 0.000000001;
+  QTest::newRow( "3857 to 4326" ) << QStringLiteral( "proj=pipeline step inv proj=webmerc lat_0=0 lon_0=0 x_0=0 y_0=0 ellps=WGS84 step proj=unitconvert xy_in=rad xy_out=deg" )
+                                  << -20000000.0 << -20000000.0 << 20000000.0 << 20000000.0 << 0.000000001 << 0.000001;
+  QTest::newRow( "4326 to 32632" ) << QStringLiteral( "proj=pipeline step proj=unitconvert xy_in=deg xy_out=rad step proj=utm zone=32 ellps=WGS84" )
+                                   << 3.0 << -80.0 << 15.0 << 84.0 << 0.001 << 0.00000001;
+  QTest::newRow( "4326 to 32733" ) << QStringLiteral( "+proj=pipeline +step +proj=axisswap +order=2,1 +step +proj=unitconvert +xy_in=deg +xy_out=rad +step +proj=utm +zone=33 +south +ellps=WGS84" )
+                                   << -80.0 << 9.0 << 0.0 << 21.0 << 0.001 << 0.00000001;
+  QTest::newRow( "32632 to 32633" ) << QStringLiteral( "proj=pipeline step inv proj=utm zone=32 ellps=WGS84 step proj=utm zone=33 ellps=WGS84" )
+                                    << 300000.0 << 0.0 << 700000.0 << 9000000.0 << 0.001 << 0.001;
+  QTest::newRow( "tmerc" ) << QStringLiteral( "proj=pipeline step proj=unitconvert xy_in=deg xy_out=rad step proj=tmerc lat_0=49 lon_0=-2 k=0.9996012717 x_0=400000 y_0=-100000 ellps=GRS80" )
+                           << -8.0 << 49.0 << 2.0 << 61.0 << 0.001 << 0.00000001;
+  QTest::newRow( "affine" ) << QStringLiteral( "proj=pipeline step proj=affine xoff=100 yoff=-200 s11=0.5 s12=0.25 s21=-0.25 s22=2 step proj=unitconvert xy_in=m xy_out=us-ft" )
+                            << -1000.0 << -1000.0 << 1000.0 << 1000.0 << 0.000001 << 0.000001;
+}
+
+void TestQgsCoordinateTransform::kernel()
+{
+#if PROJ_VERSION_MAJOR>=6
+  QFETCH( QString, definition );
+  QFETCH( double, xMin );
+  QFETCH( double, yMin );
+  QFETCH( double, xMax );
+  QFETCH( double, yMax );
+  QFETCH( double, forwardTolerance );
+  QFETCH( double, inverseTolerance );
+
+  const QgsCoordinateTransformKernel kernel = QgsCoordinateTransformKernel::fromProjDefinition( definition );
+  QVERIFY( kernel.isValid() );
+
+  QgsProjUtils::proj_pj_unique_ptr pj( proj_create( QgsProjContext::get(), definition.toUtf8().constData() ) );
+  QVERIFY( pj );
+
+  // a grid of points, large enough to be split into several chunks
+  QVector< double > x;
+  QVector< double > y;
+  const int steps = 40;
+  for ( int i = 0; i < steps; ++i )
+  {
+    for ( int j = 0; j < steps; ++j )
+    {
+      x << xMin + ( xMax - xMin ) * i / ( steps - 1 );
+      y << yMin + ( yMax - yMin ) * j / ( steps - 1 );
+    }
+  }
+  const int count = x.count();
+
+  QVector< double > projX = x;
+  QVector< double > projY = y;
+  proj_trans_generic( pj.get(), PJ_FWD, projX.data(), sizeof( double ), count, projY.data(), sizeof( double ), count, nullptr, 0, 0, nullptr, 0, 0 );
+
+  QVector< double > kernelX = x;
+  QVector< double > kernelY = y;
+  QCOMPARE( kernel.transform( count, kernelX.data(), kernelY.data(), false ), count );
+  for ( int i = 0; i < count; ++i )
+  {
+    QGSCOMPARENEAR( kernelX.at( i ), projX.at( i ), forwardTolerance );
+    QGSCOMPARENEAR( kernelY.at( i ), projY.at( i ), forwardTolerance );
+  }
+
+  // and back again
+  proj_trans_generic( pj.get(), PJ_INV, projX.data(), sizeof( double ), count, projY.data(), sizeof( double ), count, nullptr, 0, 0, nullptr, 0, 0 );
+  QCOMPARE( kernel.transform( count, kernelX.data(), kernelY.data(), true ), count );
+  for ( int i = 0; i < count; ++i )
+  {
+    QGSCOMPARENEAR( kernelX.at( i ), projX.at( i ), inverseTolerance );
+    QGSCOMPARENEAR( kernelY.at( i ), projY.at( i ), inverseTolerance );
+    QGSCOMPARENEAR( kernelX.at( i ), x.at( i ), inverseTolerance );
+    QGSCOMPARENEAR( kernelY.at( i ), y.at( i ), inverseTolerance );
+  }
+#endif
+}
+
+void TestQgsCoordinateTransform::kernelUnsupported()
+{
+  // operations which must be left to proj
+  QVERIFY( !QgsCoordinateTransformKernel::fromProjDefinition( QString() ).isValid() );
+  QVERIFY( !QgsCoordinateTransformKernel::fromProjDefinition( QStringLiteral( "proj=pipeline step proj=unitconvert xy_in=deg xy_out=rad step proj=utm zone=32 ellps=intl" ) ).isValid() );
+  QVERIFY( !QgsCoordinateTransformKernel::fromProjDefinition( QStringLiteral( "proj=pipeline step proj=unitconvert xy_in=deg xy_out=rad step proj=utm zone=32 ellps=WGS84 approx" ) ).isValid() );
+  QVERIFY( !QgsCoordinateTransformKernel::fromProjDefinition( QStringLiteral( "proj=pipeline step proj=unitconvert xy_in=deg xy_out=rad step proj=webmerc lon_0=0 ellps=WGS84 over" ) ).isValid() );
+  QVERIFY( !QgsCoordinateTransformKernel::fromProjDefinition( QStringLiteral( "proj=pipeline step proj=unitconvert xy_in=deg xy_out=m" ) ).isValid() );
+  QVERIFY( !QgsCoordinateTransformKernel::fromProjDefinition( QStringLiteral( "proj=pipeline step proj=affine xoff=1 zoff=3" ) ).isValid() );
+  QVERIFY( !QgsCoordinateTransformKernel::fromProjDefinition( QStringLiteral( "proj=pipeline step proj=axisswap order=1,3,2" ) ).isValid() );
+  QVERIFY( !QgsCoordinateTransformKernel::fromProjDefinition( QStringLiteral( "proj=pipeline "
+           "step proj=unitconvert xy_in=deg xy_out=rad "
+           "step proj=push v_3 "
+           "step proj=cart ellps=GRS80 "
+           "step proj=helmert x=1 y=2 z=3 rx=4 ry=5 rz=6 s=7 convention=position_vector "
+           "step inv proj=cart ellps=WGS84 "
+           "step proj=pop v_3 "
+           "step proj=unitconvert xy_in=rad xy_out=deg" ) ).isValid() );
+  // nothing to do
+  QVERIFY( !QgsCoordinateTransformKernel::fromProjDefinition( QStringLiteral( "proj=pipeline step proj=noop" ) ).isValid() );
+
+  // points outside the domain of the operation are left untouched
+  const QgsCoordinateTransformKernel kernel = QgsCoordinateTransformKernel::fromProjDefinition( QStringLiteral( "proj=pipeline step proj=unitconvert xy_in=deg xy_out=rad step proj=webmerc lat_0=0 lon_0=0 x_0=0 y_0=0 ellps=WGS84" ) );
+  QVERIFY( kernel.isValid() );
+  QVector< double > x( 1000, 10.0 );
+  QVector< double > y( 1000, 50.0 );
+  y[ 600 ] = 90.0;
+  const int transformed = kernel.transform( x.count(), x.data(), y.data(), false );
+  QVERIFY( transformed > 0 );
+  QVERIFY( transformed <= 600 );
+  QGSCOMPARENEAR( x.at( 0 ), 1113194.907933, 0.000001 );
+  QGSCOMPARENEAR( y.at( 0 ), 6446275.841017, 0.000001 );
+  QCOMPARE( x.at( transformed ), 10.0 );
+  QCOMPARE( y.at( transformed ), 50.0 );
+  QCOMPARE( y.at( 600 ), 90.0 );
+}
+
+void TestQgsCoordinateTransform::transformCoordsKernel()
+{
+  QgsCoordinateTransform ct( QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:4326" ) ), QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:32632" ) ), QgsCoordinateTransformContext() );
+  QVERIFY( ct.isValid() );
+
+  QVector< double > x( 1000, 9.0 );
+  QVector< double > y( 1000, 50.0 );
+  QVector< double > z( 1000, std::numeric_limits< double >::quiet_NaN() );
+  z[ 5 ] = 100;
+  ct.transformCoords( x.count(), x.data(), y.data(), z.data() );
+  for ( int i = 0; i < x.count(); ++i )
+  {
+    QGSCOMPARENEAR( x.at( i ), 500000.0, 0.001 );
+    QGSCOMPARENEAR( y.at( i ), 5538630.703, 0.001 );
+  }
+  QVERIFY( std::isnan( z.at( 0 ) ) );
+  QCOMPARE( z.at( 5 ), 100.0 );
+
+  ct.transformCoords( x.count(), x.data(), y.data(), z.data(), QgsCoordinateTransform::ReverseTransform );
+  for ( int i = 0; i < x.count(); ++i )
+  {
+    QGSCOMPARENEAR( x.at( i ), 9.0, 0.00000001 );
+    QGSCOMPARENEAR( y.at( i ), 50.0, 0.00000001 );
+  }
+
+  // huge northings are clamped to the pole, as by proj
+  QgsCoordinateTransform ct2( QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:3857" ) ), QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:4326" ) ), QgsCoordinateTransformContext() );
+  QVector< double > x2( 1000, 1113194.907933 );
+  QVector< double > y2( 1000, 6446275.841017 );
+  QVector< double > z2( 1000, 0.0 );
+  y2[ 700 ] = std::numeric_limits< double >::max();
+  ct2.transformCoords( x2.count(), x2.data(), y2.data(), z2.data() );
+  QGSCOMPARENEAR( x2.at( 0 ), 10.0, 0.00000001 );
+  QGSCOMPARENEAR( y2.at( 0 ), 50.0, 0.00000001 );
+  QGSCOMPARENEAR( x2.at( 999 ), 10.0, 0.00000001 );
+  QGSCOMPARENEAR( y2.at( 999 ), 50.0, 0.00000001 );
+  QGSCOMPARENEAR( y2.at( 700 ), 90.0, 0.00000001 );
+}
+
+void TestQgsCoordinateTransform::transformFeatureBatch()
+{
+  QgsCoordinateTransform ct( QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:4326" ) ), QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:3857" ) ), QgsCoordinateTransformContext() );
+
+  const QList< QgsGeometry > geometries = QList< QgsGeometry >()
+                                          << QgsGeometry::fromWkt( QStringLiteral( "Point (10 50)" ) )
+                                          << QgsGeometry()
+                                          << QgsGeometry::fromWkt( QStringLiteral( "LineStringZ (1 2 3, 4 5 6)" ) )
+                                          << QgsGeometry::fromWkt( QStringLiteral( "MultiPolygon (((0 0, 10 0, 10 10, 0 0)),((20 20, 30 20, 30 30, 20 20),(21 21, 29 21, 29 29, 21 21)))" ) )
+                                          << QgsGeometry::fromWkt( QStringLiteral( "CompoundCurveM (CircularStringM (1 1 5, 2 2 6, 3 1 7),(3 1 7, 4 1 8))" ) );
+
+  QgsFeatureBatch batch;
+  batch.setFields( QgsFields() );
+  for ( int i = 0; i < geometries.count(); ++i )
+  {
+    QgsFeature f( i );
+    f.setGeometry( geometries.at( i ) );
+    batch.appendFeature( f );
+  }
+
+  batch.transform( ct );
+  for ( int i = 0; i < geometries.count(); ++i )
+  {
+    QgsGeometry expected = geometries.at( i );
+    expected.transform( ct );
+    QCOMPARE( batch.hasGeometry( i ), !expected.isNull() );
+    if ( !expected.isNull() )
+      QCOMPARE( batch.geometry( i ).asWkt( 3 ), expected.asWkt( 3 ) );
+  }
+
+  batch.transform( ct, QgsCoordinateTransform::ReverseTransform );
+  for ( int i = 0; i < geometries.count(); ++i )
+  {
+    if ( !geometries.at( i ).isNull() )
+      QCOMPARE( batch.geometry( i ).asWkt( 3 ), geometries.at( i ).asWkt( 3 ) );
+  }
+}
+
+void TestQgsCoordinateTransform::cacheStatistics()
+{
+  QgsCoordinateTransform::invalidateCache();
+  const int previousMaximumSize = QgsCoordinateTransform::maximumCacheSize();
+
+  const QgsCoordinateReferenceSystem crs4326( QStringLiteral( "EPSG:4326" ) );
+  const QgsCoordinateReferenceSystem crs3857( QStringLiteral( "EPSG:3857" ) );
+  const QgsCoordinateReferenceSystem crs3111( QStringLiteral( "EPSG:3111" ) );
+  const QgsCoordinateReferenceSystem crs32632( QStringLiteral( "EPSG:32632" ) );
+
+  QgsCoordinateTransform::CacheStatistics before = QgsCoordinateTransform::cacheStatistics();
+  QCOMPARE( before.cachedTransforms, 0 );
+
+  // invalid and identical reference systems are skipped
+  QCOMPARE( QgsCoordinateTransform::warmUpCache( QList< QgsCoordinateReferenceSystem >() << crs4326 << crs3857 << QgsCoordinateReferenceSystem(),
+            QList< QgsCoordinateReferenceSystem >() << crs3857 << crs3111 << crs32632,
+            QgsCoordinateTransformContext() ), 5 );
+
+  QgsCoordinateTransform::CacheStatistics after = QgsCoordinateTransform::cacheStatistics();
+  QCOMPARE( after.cachedTransforms, 5 );
+  QCOMPARE( after.cacheMisses - before.cacheMisses, 5LL );
+  QCOMPARE( after.cacheHits, before.cacheHits );
+#if PROJ_VERSION_MAJOR>=6
+  QCOMPARE( after.projObjectsCreated - before.projObjectsCreated, 5LL );
+  QVERIFY( after.projCreationTime > before.projCreationTime );
+#endif
+
+  // transforms created afterwards are taken from the cache
+  QgsCoordinateTransform ct( crs4326, crs3111, QgsCoordinateTransformContext() );
+  QVERIFY( ct.isValid() );
+  before = after;
+  after = QgsCoordinateTransform::cacheStatistics();
+  QCOMPARE( after.cacheHits - before.cacheHits, 1LL );
+  QCOMPARE( after.projObjectsCreated, before.projObjectsCreated );
+
+  // shrinking the cache evicts the least recently used transforms, and keeps the one just used
+  QgsCoordinateTransform::setMaximumCacheSize( 2 );
+  QCOMPARE( QgsCoordinateTransform::maximumCacheSize(), 2 );
+  before = after;
+  after = QgsCoordinateTransform::cacheStatistics();
+  QCOMPARE( after.cachedTransforms, 2 );
+  QCOMPARE( after.evictions - before.evictions, 3LL );
+
+  QgsCoordinateTransform ct2( crs4326, crs3111, QgsCoordinateTransformContext() );
+  before = after;
+  after = QgsCoordinateTransform::cacheStatistics();
+  QCOMPARE( after.cacheHits - before.cacheHits, 1LL );
+
+  QgsCoordinateTransform ct3( crs4326, crs3857, QgsCoordinateTransformContext() );
+  before = after;
+  after = QgsCoordinateTransform::cacheStatistics();
+  QCOMPARE( after.cacheMisses - before.cacheMisses, 1LL );
+  QCOMPARE( after.cachedTransforms, 2 );
+  QCOMPARE( after.evictions - before.evictions, 1LL );
+
+  QgsCoordinateTransform::setMaximumCacheSize( previousMaximumSize );
+  QgsCoordinateTransform::invalidateCache();
+}
+
+void TestQgsCoordinateTransform::cacheProjObjectsSharedBetweenThreads()
+{
+#if PROJ_VERSION_MAJOR>=6
+  QgsCoordinateTransform::invalidateCache();
+
+  // use an operation which is not handled by QgsCoordinateTransformKernel, so that proj is always used
+  const QgsCoordinateTransform ct( QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:4326" ) ), QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:3111" ) ), QgsCoordinateTransformContext() );
+  const QgsPointXY expected = ct.transform( QgsPointXY( 145, -37 ) );
+
+  auto transformInThread = [&ct]
+  {
+    QgsPointXY res;
+    std::thread thread( [&ct, &res] { res = ct.transform( QgsPointXY( 145, -37 ) ); } );
+    thread.join();
+    return res;
+  };
+
+  // a new thread clones the operation which was already prepared for the main thread
+  QgsCoordinateTransform::CacheStatistics before = QgsCoordinateTransform::cacheStatistics();
+  QgsPointXY res = transformInThread();
+  QGSCOMPARENEAR( res.x(), expected.x(), 0.001 );
+  QGSCOMPARENEAR( res.y(), expected.y(), 0.001 );
+  QgsCoordinateTransform::CacheStatistics after = QgsCoordinateTransform::cacheStatistics();
+  QCOMPARE( after.projObjectsCloned - before.projObjectsCloned, 1LL );
+  QCOMPARE( after.projObjectsCreated, before.projObjectsCreated );
+
+  // the next thread reuses the pooled proj context of the finished thread, along with its operation
+  if ( QgsProjContext::maximumPoolSize() > 0 )
+  {
+    before = after;
+    res = transformInThread();
+    QGSCOMPARENEAR( res.x(), expected.x(), 0.001 );
+    QGSCOMPARENEAR( res.y(), expected.y(), 0.001 );
+    after = QgsCoordinateTransform::cacheStatistics();
+    QCOMPARE( after.projObjectsCloned, before.projObjectsCloned );
+    QCOMPARE( after.projObjectsCreated, before.projObjectsCreated );
+  }
+#endif
+}
 
 QGSTEST_MAIN( TestQgsCoordinateTransform )
 #include "testqgscoordinatetransform.moc"
@@ -21,6 +21,7 @@
 //header for class being tested
 #include "qgsexpression.h"
 #include "qgsfeature.h"
+#include "qgsfeaturebatch.h"
 #include "qgsfeatureiterator.h"
 #include "qgsfeaturerequest.h"
 #include "qgsgeometry.h"
@@ -3826,6 +3827,259 @@ class TestQgsExpression: public QObject
       QCOMPARE( result.toString(), QString( "f2" ) );
     }
 
+    void test_compiledEvaluation_data()
+    {
+      QTest::addColumn<QString>( "string" );
+
+      QTest::newRow( "plus int" ) << "\"i\" + 1";
+      QTest::newRow( "minus int longlong" ) << "\"i\" - \"l\"";
+      QTest::newRow( "mul int double" ) << "\"i\" * \"d\"";
+      QTest::newRow( "div" ) << "\"i\" / \"d\"";
+      QTest::newRow( "div by zero" ) << "\"i\" / 0";
+      QTest::newRow( "mod" ) << "\"i\" % 3";
+      QTest::newRow( "mod by zero" ) << "\"i\" % 0";
+      QTest::newRow( "mod double" ) << "\"d\" % 2";
+      QTest::newRow( "int div" ) << "\"d\" // 2";
+      QTest::newRow( "int div by zero" ) << "\"d\" // 0";
+      QTest::newRow( "pow" ) << "\"i\" ^ 2";
+      QTest::newRow( "unary minus int" ) << "-\"i\"";
+      QTest::newRow( "unary minus double" ) << "-\"d\"";
+      QTest::newRow( "not" ) << "NOT \"i\"";
+      QTest::newRow( "string plus" ) << "\"s\" + 'x'";
+      QTest::newRow( "string plus int" ) << "\"s\" + \"i\"";
+      QTest::newRow( "string mul" ) << "\"s\" * 2";
+      QTest::newRow( "concat" ) << "\"s\" || \"i\"";
+      QTest::newRow( "eq" ) << "\"i\" = \"l\"";
+      QTest::newRow( "ne" ) << "\"i\" <> \"d\"";
+      QTest::newRow( "lt string" ) << "\"s\" < 'm'";
+      QTest::newRow( "eq string int" ) << "\"s\" = \"i\"";
+      QTest::newRow( "is null" ) << "\"i\" IS NULL";
+      QTest::newRow( "is not null" ) << "\"s\" IS NOT NULL";
+      QTest::newRow( "is" ) << "\"d\" IS \"l\"";
+      QTest::newRow( "and" ) << "\"i\" > 1 AND \"s\" = 'abc'";
+      QTest::newRow( "or" ) << "\"i\" > 1 OR \"d\" < 0";
+      QTest::newRow( "and string" ) << "\"i\" AND \"s\"";
+      QTest::newRow( "static null and" ) << "NULL AND \"i\"";
+      QTest::newRow( "static true and" ) << "TRUE AND \"i\"";
+      QTest::newRow( "static false and" ) << "FALSE AND \"s\"";
+      QTest::newRow( "static true or" ) << "TRUE OR \"s\"";
+      QTest::newRow( "static false or" ) << "FALSE OR \"d\"";
+      QTest::newRow( "case" ) << "CASE WHEN \"i\" > 1 THEN 'a' WHEN \"d\" < 0 THEN \"s\" ELSE 'c' END";
+      QTest::newRow( "case no else" ) << "CASE WHEN 1 = 2 THEN 'a' WHEN \"i\" IS NULL THEN 'n' END";
+      QTest::newRow( "case static" ) << "CASE WHEN \"i\" > 5 THEN \"l\" WHEN TRUE THEN \"i\" ELSE \"d\" END";
+      QTest::newRow( "case string condition" ) << "CASE WHEN \"s\" THEN 1 END";
+      QTest::newRow( "function" ) << "upper(\"s\")";
+      QTest::newRow( "function null handling" ) << "coalesce(\"i\", \"d\", 5)";
+      QTest::newRow( "function optional parameter" ) << "round(\"d\")";
+      QTest::newRow( "function expression" ) << "abs(\"i\") + length(\"s\")";
+      QTest::newRow( "function error" ) << "to_int(\"s\") + \"i\"";
+      QTest::newRow( "in" ) << "\"i\" IN (1, 2) OR \"s\" IN ('abc')";
+      QTest::newRow( "date" ) << "to_date('2020-01-02') + to_interval('1 day') > \"dt\"";
+    }
+
+    void test_compiledEvaluation()
+    {
+      // prepared expressions are evaluated from their compiled form, which must always give
+      // exactly the same results as the expression tree
+      QFETCH( QString, string );
+
+      QgsFields fields;
+      fields.append( QgsField( QStringLiteral( "i" ), QVariant::Int ) );
+      fields.append( QgsField( QStringLiteral( "l" ), QVariant::LongLong ) );
+      fields.append( QgsField( QStringLiteral( "d" ), QVariant::Double ) );
+      fields.append( QgsField( QStringLiteral( "s" ), QVariant::String ) );
+      fields.append( QgsField( QStringLiteral( "dt" ), QVariant::DateTime ) );
+
+      const QList< QgsAttributes > attributes
+      {
+        QgsAttributes() << 2 << 2LL << 2.5 << QStringLiteral( "abc" ) << QDateTime( QDate( 2020, 1, 1 ), QTime( 0, 0 ) ),
+        QgsAttributes() << 0 << 0LL << 0.0 << QString( "" ) << QDateTime( QDate( 2020, 1, 5 ), QTime( 0, 0 ) ),
+        QgsAttributes() << -7 << 5000000000LL << -0.5 << QStringLiteral( "12" ) << QVariant(),
+        QgsAttributes() << QVariant( QVariant::Int ) << QVariant( QVariant::LongLong ) << QVariant( QVariant::Double ) << QVariant( QVariant::String ) << QVariant( QVariant::DateTime ),
+        QgsAttributes() << QVariant() << QVariant() << QVariant() << QVariant() << QVariant(),
+      };
+
+      QgsExpressionContext context;
+      context.setFields( fields );
+
+      QgsExpression exp( string );
+      QVERIFY( !exp.hasParserError() );
+      QVERIFY( exp.prepare( &context ) );
+
+      std::unique_ptr< QgsExpressionNode > tree( exp.rootNode()->clone() );
+      QVERIFY( tree->prepare( &exp, &context ) );
+
+      QgsFeature f( fields );
+      for ( const QgsAttributes &featureAttributes : attributes )
+      {
+        f.setAttributes( featureAttributes );
+        f.setValid( true );
+        context.setFeature( f );
+
+        const QVariant result = exp.evaluate( &context );
+        const QString error = exp.evalErrorString();
+
+        exp.setEvalErrorString( QString() );
+        const QVariant expected = tree->eval( &exp, &context );
+        QCOMPARE( result.type(), expected.type() );
+        QCOMPARE( result.isNull(), expected.isNull() );
+        QCOMPARE( result, expected );
+        QCOMPARE( error, exp.evalErrorString() );
+      }
+
+      // without a feature
+      context.setFeature( QgsFeature() );
+      const QVariant result = exp.evaluate( &context );
+      const QString error = exp.evalErrorString();
+      exp.setEvalErrorString( QString() );
+      const QVariant expected = tree->eval( &exp, &context );
+      QCOMPARE( result, expected );
+      QCOMPARE( error, exp.evalErrorString() );
+    }
+
+    void test_batchEvaluation_data()
+    {
+      QTest::addColumn<QString>( "string" );
+
+      // NULL values
+      QTest::newRow( "null column" ) << "\"i\"";
+      QTest::newRow( "null arithmetic" ) << "\"i\" + \"d\" * \"l\"";
+      QTest::newRow( "null unary minus" ) << "-\"d\"";
+      QTest::newRow( "null not" ) << "NOT \"i\"";
+      QTest::newRow( "null comparison" ) << "\"i\" > 1";
+      QTest::newRow( "null string comparison" ) << "\"s\" < 'm'";
+      QTest::newRow( "null is" ) << "\"i\" IS \"d\"";
+      QTest::newRow( "null is not null" ) << "\"s\" IS NOT NULL";
+      QTest::newRow( "null and false" ) << "\"i\" > 1 AND \"d\" > 100";
+      QTest::newRow( "null or true" ) << "\"i\" > 1 OR \"d\" IS NULL";
+      QTest::newRow( "null in" ) << "\"i\" IN (1, 2, -7)";
+      QTest::newRow( "null not in null" ) << "\"d\" NOT IN (2.5, NULL)";
+      QTest::newRow( "null concat" ) << "\"s\" || \"i\"";
+      QTest::newRow( "null string plus" ) << "\"s\" + 'x'";
+      QTest::newRow( "null like" ) << "\"s\" LIKE 'a%'";
+      QTest::newRow( "null case condition" ) << "CASE WHEN \"i\" THEN 'a' ELSE 'b' END";
+      QTest::newRow( "null case no else" ) << "CASE WHEN \"i\" > 1 THEN \"l\" WHEN \"d\" < 0 THEN \"s\" END";
+      QTest::newRow( "null function" ) << "abs(\"d\") + length(\"s\")";
+      QTest::newRow( "null generic function" ) << "lpad(\"s\", 5, '-')";
+      QTest::newRow( "coalesce nulls" ) << "coalesce(\"i\", \"d\", NULL)";
+
+      // errors
+      QTest::newRow( "div by zero" ) << "\"i\" / 0";
+      QTest::newRow( "mod by zero" ) << "\"i\" % 0";
+      QTest::newRow( "int div by zero" ) << "\"d\" // 0";
+      QTest::newRow( "string conversion" ) << "\"s\" * 2";
+      QTest::newRow( "string condition" ) << "\"i\" AND \"s\"";
+      QTest::newRow( "function error" ) << "to_int(\"s\") + \"i\"";
+      QTest::newRow( "error in condition" ) << "CASE WHEN to_int(\"s\") > 1 THEN 1 ELSE 0 END";
+      QTest::newRow( "error in branch" ) << "CASE WHEN \"i\" > 1 THEN to_int(\"s\") ELSE 0 END";
+      QTest::newRow( "error after false" ) << "\"i\" > 100 AND to_int(\"s\") > 1";
+      QTest::newRow( "error after true" ) << "\"i\" < 100 OR to_int(\"s\") > 1";
+      QTest::newRow( "coalesce error" ) << "coalesce(to_int(\"s\"), \"i\")";
+      QTest::newRow( "coalesce error after value" ) << "coalesce(\"i\", to_int(\"s\"))";
+      QTest::newRow( "error in unsupported function" ) << "day(\"dt\") + to_int(\"s\")";
+    }
+
+    void test_batchEvaluation()
+    {
+      // results, NULL types and errors of a batch must be the same as evaluating the features one by one
+      QFETCH( QString, string );
+
+      QgsFields fields;
+      fields.append( QgsField( QStringLiteral( "i" ), QVariant::Int ) );
+      fields.append( QgsField( QStringLiteral( "l" ), QVariant::LongLong ) );
+      fields.append( QgsField( QStringLiteral( "d" ), QVariant::Double ) );
+      fields.append( QgsField( QStringLiteral( "s" ), QVariant::String ) );
+      fields.append( QgsField( QStringLiteral( "dt" ), QVariant::DateTime ) );
+
+      // typed and invalid NULLs, strings which can and can't be converted to numbers
+      const QList< QgsAttributes > attributes
+      {
+        QgsAttributes() << 2 << 2LL << 2.5 << QStringLiteral( "abc" ) << QDateTime( QDate( 2020, 1, 1 ), QTime( 0, 0 ) ),
+        QgsAttributes() << QVariant( QVariant::Int ) << QVariant( QVariant::LongLong ) << QVariant( QVariant::Double ) << QVariant( QVariant::String ) << QVariant( QVariant::DateTime ),
+        QgsAttributes() << -7 << 5000000000LL << -0.5 << QStringLiteral( "12" ) << QVariant(),
+        QgsAttributes() << QVariant() << QVariant() << QVariant() << QVariant() << QVariant(),
+        QgsAttributes() << 0 << QVariant( QVariant::LongLong ) << 0.0 << QString( "" ) << QDateTime( QDate( 2020, 1, 5 ), QTime( 0, 0 ) ),
+        QgsAttributes() << QVariant( QVariant::Int ) << 3LL << QVariant() << QStringLiteral( "x" ) << QVariant( QVariant::DateTime ),
+      };
+
+      QgsFeatureBatch batch;
+      batch.setFields( fields );
+      QgsFeature f( fields );
+      for ( const QgsAttributes &featureAttributes : attributes )
+      {
+        f.setAttributes( featureAttributes );
+        f.setValid( true );
+        batch.appendFeature( f );
+      }
+
+      QgsExpressionContext context;
+      context.setFields( fields );
+
+      QgsExpression exp( string );
+      QVERIFY( !exp.hasParserError() );
+      QVERIFY( exp.prepare( &context ) );
+
+      QVector< bool > selection;
+      const QVector< QVariant > results = exp.evaluateBatch( batch, &context, &selection );
+      const QString batchError = exp.evalErrorString();
+      QCOMPARE( results.size(), batch.count() );
+      QCOMPARE( selection.size(), batch.count() );
+
+      QString firstError;
+      for ( int row = 0; row < batch.count(); ++row )
+      {
+        context.setFeature( batch.feature( row ) );
+        const QVariant expected = exp.evaluate( &context );
+        const QString expectedError = exp.evalErrorString();
+        if ( firstError.isNull() )
+          firstError = expectedError;
+
+        QCOMPARE( results.at( row ).type(), expected.type() );
+        QCOMPARE( results.at( row ).isNull(), expected.isNull() );
+        QCOMPARE( results.at( row ), expected );
+        QCOMPARE( selection.at( row ), expected.toBool() );
+
+        // the error of each feature, from a batch with this feature only
+        QgsFeatureBatch single;
+        single.setFields( fields );
+        single.appendFeature( batch.feature( row ) );
+        const QVector< QVariant > singleResult = exp.evaluateBatch( single, &context );
+        QCOMPARE( singleResult.at( 0 ), expected );
+        QCOMPARE( exp.hasEvalError(), !expectedError.isEmpty() );
+        QCOMPARE( exp.evalErrorString(), expectedError );
+      }
+      // the batch reports the error of its first failing feature
+      QCOMPARE( batchError, firstError );
+    }
+
+    void test_batchEvaluationWithoutContext()
+    {
+      QgsFields fields;
+      fields.append( QgsField( QStringLiteral( "i" ), QVariant::Int ) );
+
+      QgsFeatureBatch batch;
+      batch.setFields( fields );
+      QgsFeature f( fields );
+      f.setAttributes( QgsAttributes() << 1 );
+      batch.appendFeature( f );
+      batch.appendFeature( f );
+
+      // an expression evaluated one by one, and one which fails
+      const QStringList expressions { QStringLiteral( "day(to_date('2020-01-02'))" ), QStringLiteral( "1 / 0" ), QStringLiteral( "to_int('x')" ) };
+      for ( const QString &string : expressions )
+      {
+        QgsExpression exp( string );
+        const QVariant expected = exp.evaluate( nullptr );
+        const QString expectedError = exp.evalErrorString();
+
+        const QVector< QVariant > results = exp.evaluateBatch( batch, nullptr );
+        QCOMPARE( results.size(), 2 );
+        QCOMPARE( results.at( 0 ), expected );
+        QCOMPARE( results.at( 1 ), expected );
+        QCOMPARE( exp.evalErrorString(), expectedError );
+      }
+    }
+
     void test_env()
     {
       QgsExpressionContext context;
@@ -0,0 +1,235 @@
+/***************************************************************************
+     testqgsfeaturebatch.cpp
+     -----------------------
+    Date                 : February 2021
+    Copyright            : (C) 2021 by QGIS.org
+    Email                : info at qgis dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgstest.h"
+#include <QObject>
+#include <QString>
+
+#include "qgsapplication.h"
+#include "qgsfeature.h"
+#include "qgsfeaturebatch.h"
+#include "qgsfeatureiterator.h"
+#include "qgsfield.h"
+#include "qgsgeometry.h"
+#include "qgsvectorlayer.h"
+
+class TestQgsFeatureBatch: public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();// will be called before the first testfunction is executed.
+    void cleanupTestCase();// will be called after the last testfunction was executed.
+    void columns();
+    void appendFeature();
+    void nextBatch();
+    void nextBatchFallback();
+
+  private:
+    QgsVectorLayer *createLayer( int featureCount );
+};
+
+void TestQgsFeatureBatch::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+}
+
+void TestQgsFeatureBatch::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+QgsVectorLayer *TestQgsFeatureBatch::createLayer( int featureCount )
+{
+  QgsVectorLayer *layer = new QgsVectorLayer( QStringLiteral( "Point?crs=epsg:4326&field=id:integer&field=value:double&field=name:string&field=day:date" ),
+      QStringLiteral( "layer" ), QStringLiteral( "memory" ) );
+  QgsFeatureList features;
+  for ( int i = 0; i < featureCount; ++i )
+  {
+    QgsFeature f( layer->fields() );
+    f.setAttributes( QgsAttributes() << i << i * 0.5
+                     << ( i % 3 == 0 ? QVariant( QVariant::String ) : QVariant( QStringLiteral( "name %1" ).arg( i ) ) )
+                     << QDate( 2021, 1, 1 ).addDays( i ) );
+    if ( i % 4 != 0 )
+      f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( i, -i ) ) );
+    features << f;
+  }
+  layer->dataProvider()->addFeatures( features );
+  return layer;
+}
+
+void TestQgsFeatureBatch::columns()
+{
+  QgsFields fields;
+  fields.append( QgsField( QStringLiteral( "int" ), QVariant::Int ) );
+  fields.append( QgsField( QStringLiteral( "double" ), QVariant::Double ) );
+  fields.append( QgsField( QStringLiteral( "string" ), QVariant::String ) );
+  fields.append( QgsField( QStringLiteral( "date" ), QVariant::Date ) );
+
+  QgsFeatureBatch batch;
+  batch.setFields( fields );
+  QCOMPARE( batch.count(), 0 );
+  QVERIFY( batch.isEmpty() );
+  QCOMPARE( batch.columnType( 0 ), QgsFeatureBatch::Int64Column );
+  QCOMPARE( batch.columnType( 1 ), QgsFeatureBatch::DoubleColumn );
+  QCOMPARE( batch.columnType( 2 ), QgsFeatureBatch::StringColumn );
+  QCOMPARE( batch.columnType( 3 ), QgsFeatureBatch::VariantColumn );
+
+  QCOMPARE( batch.addRow( 11 ), 0 );
+  batch.setInt64( 0, 5 );
+  batch.setDouble( 1, 1.5 );
+  batch.setString( 2, QStringLiteral( "first" ) );
+  batch.setValue( 3, QDate( 2021, 2, 3 ) );
+  const QByteArray wkb = QgsGeometry::fromPointXY( QgsPointXY( 1, 2 ) ).asWkb();
+  batch.setGeometryWkb( wkb.constData(), wkb.size() );
+
+  QCOMPARE( batch.addRow( 12 ), 1 );
+  batch.setString( 2, QStringLiteral( "second" ) );
+
+  QCOMPARE( batch.count(), 2 );
+  QCOMPARE( batch.ids(), QVector< QgsFeatureId >() << 11 << 12 );
+  QCOMPARE( batch.int64Column( 0 )[0], 5LL );
+  QVERIFY( !batch.int64Column( 1 ) );
+  QCOMPARE( batch.doubleColumn( 1 )[0], 1.5 );
+  QVERIFY( !batch.doubleColumn( 0 ) );
+  QCOMPARE( batch.stringRef( 2, 0 ).toString(), QStringLiteral( "first" ) );
+  QCOMPARE( batch.stringRef( 2, 1 ).toString(), QStringLiteral( "second" ) );
+  QCOMPARE( batch.doubleValue( 0, 0 ), 5.0 );
+  QCOMPARE( batch.int64Value( 1, 0 ), 1LL );
+
+  QVERIFY( !batch.isNull( 0, 0 ) );
+  QVERIFY( batch.isNull( 0, 1 ) );
+  QVERIFY( batch.isNull( 3, 1 ) );
+  QCOMPARE( batch.value( 0, 0 ), QVariant( 5 ) );
+  QCOMPARE( batch.value( 0, 0 ).type(), QVariant::Int );
+  QVERIFY( batch.value( 0, 1 ).isNull() );
+  QCOMPARE( batch.value( 0, 1 ).type(), QVariant::Int );
+  QCOMPARE( batch.value( 3, 0 ), QVariant( QDate( 2021, 2, 3 ) ) );
+
+  QVERIFY( batch.hasGeometry( 0 ) );
+  QVERIFY( !batch.hasGeometry( 1 ) );
+  QCOMPARE( batch.geometryWkb( 0 ), wkb );
+  QVERIFY( batch.geometryWkb( 1 ).isEmpty() );
+  QCOMPARE( batch.geometry( 0 ).asWkt(), QStringLiteral( "Point (1 2)" ) );
+  QVERIFY( batch.geometry( 1 ).isNull() );
+
+  const QgsFeature f = batch.feature( 0 );
+  QCOMPARE( f.id(), 11LL );
+  QCOMPARE( f.attribute( QStringLiteral( "string" ) ), QVariant( QStringLiteral( "first" ) ) );
+  QCOMPARE( f.geometry().asWkt(), QStringLiteral( "Point (1 2)" ) );
+
+  // clearing keeps the fields
+  batch.clear();
+  QVERIFY( batch.isEmpty() );
+  QCOMPARE( batch.fields(), fields );
+  batch.addRow( 1 );
+  batch.setString( 2, QStringLiteral( "again" ) );
+  QCOMPARE( batch.stringRef( 2, 0 ).toString(), QStringLiteral( "again" ) );
+  QVERIFY( !batch.hasGeometry( 0 ) );
+}
+
+void TestQgsFeatureBatch::appendFeature()
+{
+  std::unique_ptr< QgsVectorLayer > layer( createLayer( 5 ) );
+  QgsFeatureBatch batch;
+  batch.setFields( layer->fields() );
+
+  QgsFeatureIterator it = layer->getFeatures();
+  QgsFeature f;
+  QgsFeatureList features;
+  while ( it.nextFeature( f ) )
+  {
+    batch.appendFeature( f );
+    features << f;
+  }
+
+  QCOMPARE( batch.count(), 5 );
+  for ( int row = 0; row < batch.count(); ++row )
+  {
+    const QgsFeature batchFeature = batch.feature( row );
+    QCOMPARE( batchFeature.id(), features.at( row ).id() );
+    QCOMPARE( batchFeature.attributes(), features.at( row ).attributes() );
+    QCOMPARE( batchFeature.geometry().asWkt(), features.at( row ).geometry().asWkt() );
+  }
+}
+
+void TestQgsFeatureBatch::nextBatch()
+{
+  std::unique_ptr< QgsVectorLayer > layer( createLayer( 25 ) );
+
+  QgsFeatureList expected;
+  QgsFeature f;
+  QgsFeatureIterator it = layer->getFeatures();
+  while ( it.nextFeature( f ) )
+    expected << f;
+
+  QgsFeatureBatch batch;
+  QgsFeatureList batched;
+  QList< int > batchSizes;
+  it = layer->getFeatures();
+  while ( it.nextBatch( batch, 10 ) )
+  {
+    batchSizes << batch.count();
+    for ( int row = 0; row < batch.count(); ++row )
+      batched << batch.feature( row );
+  }
+  QCOMPARE( batchSizes, QList< int >() << 10 << 10 << 5 );
+  QCOMPARE( batched.count(), expected.count() );
+  for ( int i = 0; i < expected.count(); ++i )
+  {
+    QCOMPARE( batched.at( i ).id(), expected.at( i ).id() );
+    QCOMPARE( batched.at( i ).attributes(), expected.at( i ).attributes() );
+    QCOMPARE( batched.at( i ).geometry().asWkt(), expected.at( i ).geometry().asWkt() );
+  }
+
+  // subset of attributes and limit
+  it = layer->getFeatures( QgsFeatureRequest().setSubsetOfAttributes( QgsAttributeList() << 1 ).setLimit( 7 ) );
+  QVERIFY( it.nextBatch( batch, 5 ) );
+  QCOMPARE( batch.count(), 5 );
+  QVERIFY( batch.isNull( 0, 1 ) );
+  QCOMPARE( batch.doubleColumn( 1 )[1], 0.5 );
+  QVERIFY( it.nextBatch( batch, 5 ) );
+  QCOMPARE( batch.count(), 2 );
+  QVERIFY( !it.nextBatch( batch, 5 ) );
+  QVERIFY( batch.isEmpty() );
+}
+
+void TestQgsFeatureBatch::nextBatchFallback()
+{
+  std::unique_ptr< QgsVectorLayer > layer( createLayer( 25 ) );
+
+  // fid filters are not handled by the native batch path, and must be fetched one by one
+  QgsFeatureIds ids;
+  ids << 3 << 4 << 20;
+  QgsFeatureIterator it = layer->getFeatures( QgsFeatureRequest().setFilterFids( ids ) );
+  QgsFeatureBatch batch;
+  QVERIFY( it.nextBatch( batch ) );
+  QCOMPARE( batch.count(), 3 );
+  QgsFeatureIds batchIds;
+  for ( int row = 0; row < batch.count(); ++row )
+    batchIds << batch.id( row );
+  QCOMPARE( batchIds, ids );
+  QVERIFY( !it.nextBatch( batch ) );
+
+  // expression filters which cannot be compiled are evaluated by the iterator
+  it = layer->getFeatures( QgsFeatureRequest().setFilterExpression( QStringLiteral( "\"id\" % 5 = 0" ) ) );
+  QVERIFY( it.nextBatch( batch ) );
+  QCOMPARE( batch.count(), 5 );
+  for ( int row = 0; row < batch.count(); ++row )
+    QCOMPARE( batch.int64Value( 0, row ) % 5, 0LL );
+}
+
+QGSTEST_MAIN( TestQgsFeatureBatch )
+#include "testqgsfeaturebatch.moc"
@@ -22,12 +22,14 @@
 #include <QApplication>
 #include <QFileInfo>
 #include <QDir>
+#include <QTemporaryDir>
 
 //qgis includes...
 #include <qgis.h>
 #include <qgsapplication.h>
 #include <qgsproviderregistry.h>
 #include <qgsrasterdataprovider.h>
+#include <qgsrasterbandstats.h>
 #include <qgsrectangle.h>
 
 /**
@@ -59,6 +61,8 @@ class TestQgsGdalProvider : public QObject
     void interactionBetweenRasterChangeAndCache(); // test that updading a raster invalidates the GDAL dataset cache (#20104)
     void scale0(); //test when data has scale 0 (#20493)
     void transformCoordinates();
+    void persistedExactStatistics();
+    void statisticsAfterNoDataChange();
 
   private:
     QString mTestDataDir;
@@ -399,5 +403,68 @@ void TestQgsGdalProvider::transformCoordinates()
 
 }
 
+void TestQgsGdalProvider::persistedExactStatistics()
+{
+  QTemporaryDir dir;
+  const QString raster = dir.filePath( QStringLiteral( "landsat.tif" ) );
+  QVERIFY( QFile::copy( mTestDataDir + "landsat.tif", raster ) );
+
+  const int stats = QgsRasterBandStats::Min | QgsRasterBandStats::Max | QgsRasterBandStats::Mean | QgsRasterBandStats::StdDev;
+  std::unique_ptr< QgsRasterDataProvider > rp( dynamic_cast< QgsRasterDataProvider * >( QgsProviderRegistry::instance()->createProvider( QStringLiteral( "gdal" ), raster, QgsDataProvider::ProviderOptions() ) ) );
+  QVERIFY( rp );
+  const QgsRasterBandStats computed = rp->bandStatistics( 1, stats, QgsRectangle(), 0 );
+  rp.reset();
+
+  // exact statistics are saved next to the dataset
+  QFile auxFile( raster + QStringLiteral( ".aux.xml" ) );
+  QVERIFY( auxFile.open( QIODevice::ReadOnly ) );
+  QVERIFY( auxFile.readAll().contains( "QGIS_EXACT_STATISTICS" ) );
+  auxFile.close();
+
+  // and used instead of a new computation once the dataset is opened again
+  rp.reset( dynamic_cast< QgsRasterDataProvider * >( QgsProviderRegistry::instance()->createProvider( QStringLiteral( "gdal" ), raster, QgsDataProvider::ProviderOptions() ) ) );
+  QVERIFY( rp );
+  const QgsRasterBandStats persisted = rp->bandStatistics( 1, stats, QgsRectangle(), 0 );
+  QCOMPARE( persisted.minimumValue, computed.minimumValue );
+  QCOMPARE( persisted.maximumValue, computed.maximumValue );
+  QCOMPARE( persisted.mean, computed.mean );
+  QCOMPARE( persisted.stdDev, computed.stdDev );
+}
+
+void TestQgsGdalProvider::statisticsAfterNoDataChange()
+{
+  QTemporaryDir dir;
+  const QString raster = dir.filePath( QStringLiteral( "landsat.tif" ) );
+  QVERIFY( QFile::copy( mTestDataDir + "landsat.tif", raster ) );
+
+  const int stats = QgsRasterBandStats::Min | QgsRasterBandStats::Max | QgsRasterBandStats::Mean | QgsRasterBandStats::StdDev;
+  std::unique_ptr< QgsRasterDataProvider > rp( dynamic_cast< QgsRasterDataProvider * >( QgsProviderRegistry::instance()->createProvider( QStringLiteral( "gdal" ), raster, QgsDataProvider::ProviderOptions() ) ) );
+  QVERIFY( rp );
+  const QgsRasterBandStats initial = rp->bandStatistics( 1, stats, QgsRectangle(), 0 );
+
+  // the minimum value becomes no data, so the statistics must be computed again
+  rp->setEditable( true );
+  QVERIFY( rp->setNoDataValue( 1, initial.minimumValue ) );
+  rp->setEditable( false );
+  const QgsRasterBandStats withNoData = rp->bandStatistics( 1, stats, QgsRectangle(), 0 );
+  QVERIFY( withNoData.minimumValue > initial.minimumValue );
+  QCOMPARE( withNoData.maximumValue, initial.maximumValue );
+  QVERIFY( withNoData.mean > initial.mean );
+
+  // the statistics persisted before the change are not used once the dataset is opened again
+  rp.reset( dynamic_cast< QgsRasterDataProvider * >( QgsProviderRegistry::instance()->createProvider( QStringLiteral( "gdal" ), raster, QgsDataProvider::ProviderOptions() ) ) );
+  QVERIFY( rp );
+  QVERIFY( rp->sourceHasNoDataValue( 1 ) );
+  const QgsRasterBandStats reopened = rp->bandStatistics( 1, stats, QgsRectangle(), 0 );
+  QCOMPARE( reopened.minimumValue, withNoData.minimumValue );
+  QCOMPARE( reopened.mean, withNoData.mean );
+
+  // nor when the source no data value is not used
+  rp->setUseSourceNoDataValue( 1, false );
+  const QgsRasterBandStats withoutNoData = rp->bandStatistics( 1, stats, QgsRectangle(), 0 );
+  QCOMPARE( withoutNoData.minimumValue, initial.minimumValue );
+  QCOMPARE( withoutNoData.maximumValue, initial.maximumValue );
+}
+
 QGSTEST_MAIN( TestQgsGdalProvider )
 #include "testqgsgdalprovider.moc"
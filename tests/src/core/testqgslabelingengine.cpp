@@ -32,6 +32,8 @@
 #include "qgssymbol.h"
 #include "pointset.h"
 
+#include <QThreadPool>
+
 class TestQgsLabelingEngine : public QObject
 {
     Q_OBJECT
@@ -90,6 +92,8 @@ class TestQgsLabelingEngine : public QObject
     void testLineAnchorHorizontal();
     void testLineAnchorHorizontalConstraints();
     void testShowAllLabelsWhenALabelHasNoCandidates();
+    void testDensePlacementIsDeterministic();
+    void testUsePreviousPlacements();
 
   private:
     QgsVectorLayer *vl = nullptr;
@@ -99,6 +103,7 @@ class TestQgsLabelingEngine : public QObject
     void setDefaultLabelParams( QgsPalLayerSettings &settings );
     QgsLabelingEngineSettings createLabelEngineSettings();
     bool imageCheck( const QString &testName, QImage &image, int mismatchCount );
+    QgsVectorLayer *createClusteredPointLayer( int clusterCount, double clusterSpacing, int pointsPerCluster, double pointSpacing );
 
 };
 
@@ -842,6 +847,32 @@ bool TestQgsLabelingEngine::imageCheck( const QString &testName, QImage &image,
   return resultFlag;
 }
 
+QgsVectorLayer *TestQgsLabelingEngine::createClusteredPointLayer( int clusterCount, double clusterSpacing, int pointsPerCluster, double pointSpacing )
+{
+  // square grid of clusters, each a grid of points five wide
+  QgsVectorLayer *layer = new QgsVectorLayer( QStringLiteral( "Point?crs=epsg:3857&field=id:integer" ), QStringLiteral( "vl" ), QStringLiteral( "memory" ) );
+  layer->setRenderer( new QgsNullSymbolRenderer() );
+
+  const int clustersPerRow = static_cast< int >( std::ceil( std::sqrt( clusterCount ) ) );
+  QgsFeatureList features;
+  int id = 0;
+  for ( int cluster = 0; cluster < clusterCount; ++cluster )
+  {
+    const double clusterX = ( cluster % clustersPerRow ) * clusterSpacing;
+    const double clusterY = ( cluster / clustersPerRow ) * clusterSpacing;
+    for ( int i = 0; i < pointsPerCluster; ++i )
+    {
+      QgsFeature f;
+      f.setAttributes( QgsAttributes() << id++ );
+      f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( clusterX + ( i % 5 ) * pointSpacing, clusterY + ( i / 5 ) * pointSpacing ) ) );
+      features << f;
+    }
+  }
+  layer->dataProvider()->addFeatures( features );
+  layer->updateExtents();
+  return layer;
+}
+
 // See https://github.com/qgis/QGIS/issues/23431
 void TestQgsLabelingEngine::testRegisterFeatureUnprojectible()
 {
@@ -3317,5 +3348,164 @@ void TestQgsLabelingEngine::testShowAllLabelsWhenALabelHasNoCandidates()
   QVERIFY( imageCheck( QStringLiteral( "show_all_labels_when_no_candidates" ), img, 20 ) );
 }
 
+void TestQgsLabelingEngine::testDensePlacementIsDeterministic()
+{
+  // candidates are generated and conflicts solved concurrently, but the placement must only depend on the input
+  QgsPalLayerSettings settings;
+  setDefaultLabelParams( settings );
+  settings.fieldName = QStringLiteral( "'label ' || \"id\"" );
+  settings.isExpression = true;
+  settings.placement = QgsPalLayerSettings::AroundPoint;
+
+  // separate clusters of crowded points, giving many independent groups of conflicting labels
+  std::unique_ptr< QgsVectorLayer> vl2( createClusteredPointLayer( 25, 200000, 20, 5000 ) );
+  QVERIFY( vl2->isValid() );
+
+  vl2->setLabeling( new QgsVectorLayerSimpleLabeling( settings ) );
+  vl2->setLabelsEnabled( true );
+
+  QgsMapSettings mapSettings;
+  mapSettings.setLabelingEngineSettings( createLabelEngineSettings() );
+  mapSettings.setDestinationCrs( vl2->crs() );
+  mapSettings.setOutputSize( QSize( 800, 800 ) );
+  mapSettings.setExtent( QgsRectangle( -50000, -50000, 900000, 900000 ) );
+  mapSettings.setLayers( QList<QgsMapLayer *>() << vl2.get() );
+  mapSettings.setOutputDpi( 96 );
+
+  auto placedLabels = [&mapSettings]
+  {
+    QgsMapRendererSequentialJob job( mapSettings );
+    job.start();
+    job.waitForFinished();
+
+    std::unique_ptr< QgsLabelingResults > results( job.takeLabelingResults() );
+    QList<QgsLabelPosition> labels = results->labelsWithinRect( mapSettings.extent() );
+    std::sort( labels.begin(), labels.end(), []( const QgsLabelPosition & a, const QgsLabelPosition & b ) { return a.featureId < b.featureId; } );
+    QStringList res;
+    for ( const QgsLabelPosition &label : qgis::as_const( labels ) )
+      res << QStringLiteral( "%1:%2" ).arg( label.featureId ).arg( label.labelRect.toString( 0 ) );
+    return res;
+  };
+
+  QThreadPool *pool = QThreadPool::globalInstance();
+  const int originalMaxThreadCount = pool->maxThreadCount();
+
+  pool->setMaxThreadCount( 1 );
+  const QStringList singleThreaded = placedLabels();
+
+  pool->setMaxThreadCount( std::max( QThread::idealThreadCount(), 4 ) );
+  QStringList multiThreaded;
+  for ( int i = 0; i < 3; ++i )
+  {
+    multiThreaded = placedLabels();
+    if ( multiThreaded != singleThreaded )
+      break;
+  }
+
+  pool->setMaxThreadCount( originalMaxThreadCount );
+
+  // crowded clusters, so some labels can't be placed
+  QVERIFY( singleThreaded.size() > 25 );
+  QVERIFY( singleThreaded.size() < 500 );
+  QCOMPARE( multiThreaded, singleThreaded );
+}
+
+void TestQgsLabelingEngine::testUsePreviousPlacements()
+{
+  QgsLabelingEngineSettings engineSettings = createLabelEngineSettings();
+  engineSettings.setFlag( QgsLabelingEngineSettings::UsePreviousPlacements, true );
+
+  // setting is stored in projects
+  QgsProject p;
+  engineSettings.writeSettingsToProject( &p );
+  QgsLabelingEngineSettings engineSettings2;
+  engineSettings2.readSettingsFromProject( &p );
+  QVERIFY( engineSettings2.testFlag( QgsLabelingEngineSettings::UsePreviousPlacements ) );
+
+  QgsPalLayerSettings settings;
+  setDefaultLabelParams( settings );
+  settings.fieldName = QStringLiteral( "'label ' || \"id\"" );
+  settings.isExpression = true;
+  settings.placement = QgsPalLayerSettings::AroundPoint;
+
+  std::unique_ptr< QgsVectorLayer> vl2( createClusteredPointLayer( 16, 250000, 10, 10000 ) );
+  QVERIFY( vl2->isValid() );
+
+  vl2->setLabeling( new QgsVectorLayerSimpleLabeling( settings ) );
+  vl2->setLabelsEnabled( true );
+
+  QgsMapSettings mapSettings;
+  mapSettings.setLabelingEngineSettings( engineSettings );
+  mapSettings.setDestinationCrs( vl2->crs() );
+  mapSettings.setOutputSize( QSize( 800, 800 ) );
+  mapSettings.setExtent( QgsRectangle( -200000, -200000, 1100000, 1100000 ) );
+  mapSettings.setLayers( QList<QgsMapLayer *>() << vl2.get() );
+  mapSettings.setOutputDpi( 96 );
+
+  auto render = [&mapSettings]( const QgsLabelingResults * previousResults )
+  {
+    QgsMapRendererSequentialJob job( mapSettings );
+    job.setPreviousLabelingResults( previousResults );
+    job.start();
+    job.waitForFinished();
+    return job.takeLabelingResults();
+  };
+
+  std::unique_ptr< QgsLabelingResults > first( render( nullptr ) );
+
+  // pan the map slightly
+  mapSettings.setExtent( QgsRectangle( -170000, -180000, 1130000, 1120000 ) );
+  std::unique_ptr< QgsLabelingResults > second( render( first.get() ) );
+
+  QHash< QgsFeatureId, QgsRectangle > secondRects;
+  const QList<QgsLabelPosition> secondLabels = second->labelsWithinRect( mapSettings.visibleExtent() );
+  for ( const QgsLabelPosition &label : secondLabels )
+    secondRects.insert( label.featureId, label.labelRect );
+
+  // labels which remain fully visible must keep their placement
+  int kept = 0;
+  const QList<QgsLabelPosition> firstLabels = first->labelsWithinRect( mapSettings.visibleExtent() );
+  for ( const QgsLabelPosition &label : firstLabels )
+  {
+    if ( !mapSettings.visibleExtent().contains( label.labelRect ) )
+      continue;
+
+    QVERIFY( secondRects.contains( label.featureId ) );
+    QCOMPARE( secondRects.value( label.featureId ).toString( 3 ), label.labelRect.toString( 3 ) );
+    kept++;
+  }
+  QVERIFY( kept > 16 );
+
+  // a change of the placement mode places all labels again
+  QgsPalLayerSettings overPointSettings = settings;
+  overPointSettings.placement = QgsPalLayerSettings::OverPoint;
+  vl2->setLabeling( new QgsVectorLayerSimpleLabeling( overPointSettings ) );
+  std::unique_ptr< QgsLabelingResults > third( render( second.get() ) );
+
+  const QList<QgsLabelPosition> thirdLabels = third->labelsWithinRect( mapSettings.visibleExtent() );
+  QVERIFY( thirdLabels.size() > 16 );
+  for ( const QgsLabelPosition &label : thirdLabels )
+  {
+    // labels over points are centered on them
+    const QgsPointXY point = vl2->getFeature( label.featureId ).geometry().asPoint();
+    QGSCOMPARENEAR( label.labelRect.center().x(), point.x(), label.labelRect.width() * 0.01 );
+    QGSCOMPARENEAR( label.labelRect.center().y(), point.y(), label.labelRect.height() * 0.01 );
+  }
+
+  // and so does a change of a setting which is not exposed by the label provider, such as the distance
+  QgsPalLayerSettings distanceSettings = settings;
+  distanceSettings.dist = 3;
+  vl2->setLabeling( new QgsVectorLayerSimpleLabeling( distanceSettings ) );
+  std::unique_ptr< QgsLabelingResults > fourth( render( second.get() ) );
+
+  const QList<QgsLabelPosition> fourthLabels = fourth->labelsWithinRect( mapSettings.visibleExtent() );
+  QVERIFY( fourthLabels.size() > 16 );
+  for ( const QgsLabelPosition &label : fourthLabels )
+  {
+    if ( secondRects.contains( label.featureId ) )
+      QVERIFY( secondRects.value( label.featureId ).toString( 3 ) != label.labelRect.toString( 3 ) );
+  }
+}
+
 QGSTEST_MAIN( TestQgsLabelingEngine )
 #include "testqgslabelingengine.moc"
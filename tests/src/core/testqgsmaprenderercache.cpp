@@ -15,10 +15,16 @@
 #include "qgstest.h"
 
 #include <QImage>
+#include <QTemporaryDir>
 
 #include "qgsmaprenderercache.h"
+#include "qgsmaprendererdiskcache.h"
+#include "qgsmapsettings.h"
+#include "qgsvectorlayer.h"
 #include "qgsmaptopixel.h"
 #include "qgsrectangle.h"
+#include "qgssinglesymbolrenderer.h"
+#include "qgssymbol.h"
 
 class TestQgsMapRendererCache: public QObject
 {
@@ -34,6 +40,10 @@ class TestQgsMapRendererCache: public QObject
     void cleanup(); // will be called after every testfunction.
 
     void testCache();
+    void testDiskCache();
+    void testPannedCacheImage();
+    void testDiskCacheInvalidation();
+    void testDiskCacheSharedDirectory();
 };
 
 
@@ -154,6 +164,237 @@ void TestQgsMapRendererCache::testCache()
   QVERIFY( !cache.hasAnyCacheImage( imgRedKey ) );
 }
 
+void TestQgsMapRendererCache::testPannedCacheImage()
+{
+  QgsMapRendererCache cache;
+  QImage imgRed( 100, 100, QImage::Format::Format_ARGB32_Premultiplied );
+  imgRed.fill( Qt::red );
+  const QString imgRedKey( "red" );
+
+  QgsRectangle extent1( 0, 0, 100, 100 );
+  QgsMapToPixel mtp1( 1, 50, 50, 100, 100, 0.0 );
+  cache.updateParameters( extent1, mtp1 );
+  cache.setCacheImage( imgRedKey, imgRed );
+
+  QRect validRect;
+  QImage img = cache.pannedCacheImage( imgRedKey, validRect );
+  QCOMPARE( validRect, QRect( 0, 0, 100, 100 ) );
+  QCOMPARE( img.pixelColor( 10, 20 ), QColor( Qt::red ) );
+
+  // pan right by 20 pixels and down by 10 pixels
+  QgsRectangle extent2( 20, -10, 120, 90 );
+  QgsMapToPixel mtp2( 1, 70, 40, 100, 100, 0.0 );
+  cache.updateParameters( extent2, mtp2 );
+  QVERIFY( !cache.hasCacheImage( imgRedKey ) );
+  img = cache.pannedCacheImage( imgRedKey, validRect );
+  QCOMPARE( img.size(), imgRed.size() );
+  QCOMPARE( validRect, QRect( 0, 0, 80, 90 ) );
+  QCOMPARE( img.pixelColor( 10, 20 ), QColor( Qt::red ) );
+  QCOMPARE( img.pixelColor( 90, 20 ), QColor( Qt::transparent ) );
+  QCOMPARE( img.pixelColor( 10, 95 ), QColor( Qt::transparent ) );
+
+  // no reuse for sub-pixel pans
+  QgsMapToPixel mtp3( 1, 70.5, 40, 100, 100, 0.0 );
+  cache.updateParameters( QgsRectangle( 20.5, -10, 120.5, 90 ), mtp3 );
+  QVERIFY( cache.pannedCacheImage( imgRedKey, validRect ).isNull() );
+  QVERIFY( validRect.isNull() );
+
+  // no reuse after zooming
+  QgsMapToPixel mtp4( 2, 50, 50, 100, 100, 0.0 );
+  cache.updateParameters( QgsRectangle( -50, -50, 150, 150 ), mtp4 );
+  QVERIFY( cache.pannedCacheImage( imgRedKey, validRect ).isNull() );
+
+  // no overlap at all
+  QgsMapToPixel mtp5( 1, 250, 50, 100, 100, 0.0 );
+  cache.updateParameters( QgsRectangle( 200, 0, 300, 100 ), mtp5 );
+  QVERIFY( cache.pannedCacheImage( imgRedKey, validRect ).isNull() );
+}
+
+void TestQgsMapRendererCache::testDiskCache()
+{
+  QTemporaryDir dir;
+  QVERIFY( dir.isValid() );
+
+  QgsVectorLayer layer( QStringLiteral( "Point?crs=epsg:3857" ), QStringLiteral( "points" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer.isValid() );
+
+  QgsMapSettings settings;
+  settings.setLayers( QList< QgsMapLayer * >() << &layer );
+  settings.setDestinationCrs( layer.crs() );
+  settings.setOutputSize( QSize( 100, 100 ) );
+  settings.setExtent( QgsRectangle( 0, 0, 100, 100 ) );
+  QVERIFY( QgsMapRendererDiskCache::canCacheLayer( &layer, settings ) );
+
+  QImage imgRed( settings.deviceOutputSize(), QImage::Format::Format_ARGB32_Premultiplied );
+  imgRed.fill( Qt::red );
+
+  {
+    QgsMapRendererDiskCache cache( dir.path() );
+    QVERIFY( cache.cacheImage( &layer, settings ).isNull() );
+    QCOMPARE( cache.misses(), 1LL );
+
+    QVERIFY( cache.insertImage( &layer, settings, imgRed ) );
+    QCOMPARE( cache.count(), 1 );
+    QVERIFY( cache.currentSize() >= imgRed.bytesPerLine() * imgRed.height() );
+
+    const QImage img = cache.cacheImage( &layer, settings );
+    QCOMPARE( img.size(), imgRed.size() );
+    QCOMPARE( img.pixelColor( 10, 20 ), QColor( Qt::red ) );
+    QCOMPARE( cache.hits(), 1LL );
+
+    // different extent
+    QgsMapSettings panned = settings;
+    panned.setExtent( QgsRectangle( 20, 0, 120, 100 ) );
+    QVERIFY( cache.cacheImage( &layer, panned ).isNull() );
+
+    // editable layers are never cached
+    layer.startEditing();
+    QVERIFY( !QgsMapRendererDiskCache::canCacheLayer( &layer, settings ) );
+    QVERIFY( cache.cacheImage( &layer, settings ).isNull() );
+    layer.rollBack();
+  }
+
+  {
+    // images persist across cache instances
+    QgsMapRendererDiskCache cache( dir.path() );
+    QCOMPARE( cache.count(), 1 );
+    const QImage img = cache.cacheImage( &layer, settings );
+    QCOMPARE( img.pixelColor( 10, 20 ), QColor( Qt::red ) );
+
+    // the memory cache loads images from the disk tier during rendering
+    QgsMapRendererCache memoryCache;
+    memoryCache.setDiskCache( &cache );
+    QCOMPARE( memoryCache.diskCache(), &cache );
+
+    // least recently used images are evicted
+    QgsMapSettings panned = settings;
+    panned.setExtent( QgsRectangle( 20, 0, 120, 100 ) );
+    QImage imgBlue = imgRed;
+    imgBlue.fill( Qt::blue );
+    cache.setMaximumSize( cache.currentSize() );
+    QVERIFY( cache.insertImage( &layer, panned, imgBlue ) );
+    QCOMPARE( cache.count(), 1 );
+    QVERIFY( cache.cacheImage( &layer, settings ).isNull() );
+    QCOMPARE( cache.cacheImage( &layer, panned ).pixelColor( 10, 20 ), QColor( Qt::blue ) );
+
+    cache.invalidateLayer( layer.id() );
+    QCOMPARE( cache.count(), 0 );
+    QCOMPARE( cache.currentSize(), 0LL );
+  }
+}
+
+void TestQgsMapRendererCache::testDiskCacheInvalidation()
+{
+  QTemporaryDir dir;
+  QVERIFY( dir.isValid() );
+
+  QgsVectorLayer layer( QStringLiteral( "Point?crs=epsg:3857" ), QStringLiteral( "points" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer.isValid() );
+
+  QgsMapSettings settings;
+  settings.setLayers( QList< QgsMapLayer * >() << &layer );
+  settings.setDestinationCrs( layer.crs() );
+  settings.setOutputSize( QSize( 100, 100 ) );
+  settings.setExtent( QgsRectangle( 0, 0, 100, 100 ) );
+
+  QImage imgRed( settings.deviceOutputSize(), QImage::Format::Format_ARGB32_Premultiplied );
+  imgRed.fill( Qt::red );
+
+  QgsMapRendererDiskCache diskCache( dir.path() );
+  QgsMapRendererCache cache;
+  cache.setDiskCache( &diskCache );
+
+  // a render job stores the image in both tiers
+  cache.setCacheImageWithParameters( layer.id(), imgRed, settings.visibleExtent(), settings.mapToPixel(), QList< QgsMapLayer * >() << &layer );
+  QVERIFY( diskCache.insertImage( &layer, settings, imgRed ) );
+  QVERIFY( !diskCache.cacheImage( &layer, settings ).isNull() );
+  QCOMPARE( diskCache.hits(), 1LL );
+
+  // editing the layer invalidates its image on disk, even once the image was cleared from memory
+  cache.clear();
+  QVERIFY( !cache.hasAnyCacheImage( layer.id() ) );
+  QVERIFY( layer.startEditing() );
+  QgsFeature feature;
+  feature.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( 50, 50 ) ) );
+  QVERIFY( layer.addFeature( feature ) );
+  QVERIFY( layer.commitChanges() );
+
+  QCOMPARE( diskCache.count(), 0 );
+  diskCache.resetStatistics();
+  QVERIFY( diskCache.cacheImage( &layer, settings ).isNull() );
+  QCOMPARE( diskCache.hits(), 0LL );
+  QCOMPARE( diskCache.misses(), 1LL );
+
+  // explicit invalidations of the layer are forwarded to the disk cache too
+  QVERIFY( diskCache.insertImage( &layer, settings, imgRed ) );
+  cache.invalidateCacheForLayer( &layer );
+  QVERIFY( diskCache.cacheImage( &layer, settings ).isNull() );
+  QCOMPARE( diskCache.hits(), 0LL );
+
+  // the invalidation is persisted in the index
+  diskCache.sync();
+  QgsMapRendererDiskCache reopened( dir.path() );
+  QCOMPARE( reopened.count(), 0 );
+}
+
+void TestQgsMapRendererCache::testDiskCacheSharedDirectory()
+{
+  QTemporaryDir dir;
+  QVERIFY( dir.isValid() );
+
+  QgsVectorLayer layer( QStringLiteral( "Point?crs=epsg:3857" ), QStringLiteral( "points" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer.isValid() );
+
+  QgsMapSettings settings;
+  settings.setLayers( QList< QgsMapLayer * >() << &layer );
+  settings.setDestinationCrs( layer.crs() );
+  settings.setOutputSize( QSize( 100, 100 ) );
+  settings.setExtent( QgsRectangle( 0, 0, 100, 100 ) );
+  QgsMapSettings panned = settings;
+  panned.setExtent( QgsRectangle( 20, 0, 120, 100 ) );
+
+  QImage imgRed( settings.deviceOutputSize(), QImage::Format::Format_ARGB32_Premultiplied );
+  imgRed.fill( Qt::red );
+  QImage imgBlue = imgRed;
+  imgBlue.fill( Qt::blue );
+
+  // recent image files which are not indexed yet may belong to another process, and are kept
+  QFile unindexed( QDir( dir.path() ).filePath( QStringLiteral( "unindexed.raw" ) ) );
+  QVERIFY( unindexed.open( QIODevice::WriteOnly ) );
+  unindexed.close();
+
+  // two caches (e.g. in two processes) sharing the same directory keep the images of each other
+  QgsMapRendererDiskCache cache1( dir.path() );
+  QgsMapRendererDiskCache cache2( dir.path() );
+  QVERIFY( unindexed.exists() );
+  QVERIFY( cache1.insertImage( &layer, settings, imgRed ) );
+  QVERIFY( cache2.insertImage( &layer, panned, imgBlue ) );
+  cache1.sync();
+  cache2.sync();
+
+  {
+    QgsMapRendererDiskCache reopened( dir.path() );
+    QCOMPARE( reopened.count(), 2 );
+    QCOMPARE( reopened.cacheImage( &layer, settings ).pixelColor( 10, 20 ), QColor( Qt::red ) );
+    QCOMPARE( reopened.cacheImage( &layer, panned ).pixelColor( 10, 20 ), QColor( Qt::blue ) );
+  }
+
+  // images removed by one cache are not written back to the index by the other one
+  cache2.invalidateLayer( layer.id() );
+  cache2.sync();
+  cache1.sync();
+  QCOMPARE( cache1.count(), 0 );
+  {
+    QgsMapRendererDiskCache reopened( dir.path() );
+    QCOMPARE( reopened.count(), 0 );
+  }
+
+  // changing the style of the layer changes the key of its images
+  QVERIFY( cache1.insertImage( &layer, settings, imgRed ) );
+  QVERIFY( !cache1.cacheImage( &layer, settings ).isNull() );
+  layer.setRenderer( new QgsSingleSymbolRenderer( QgsMarkerSymbol::createSimple( QVariantMap( { { QStringLiteral( "color" ), QStringLiteral( "0,255,0" ) } } ) ) ) );
+  QVERIFY( cache1.cacheImage( &layer, settings ).isNull() );
+}
 
 QGSTEST_MAIN( TestQgsMapRendererCache )
 #include "testqgsmaprenderercache.moc"
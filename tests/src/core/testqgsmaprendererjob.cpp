@@ -31,6 +31,8 @@
 #include "qgsfield.h"
 #include "qgis.h"
 #include "qgsmaprenderersequentialjob.h"
+#include "qgsmaprendererparalleljob.h"
+#include "qgsmaprenderercache.h"
 #include "qgsmaplayer.h"
 #include "qgsreadwritecontext.h"
 #include "qgsproviderregistry.h"
@@ -90,6 +92,9 @@ class TestQgsMapRendererJob : public QObject
 
     void temporalRender();
 
+    void parallelLayerTiles();
+    void pannedRenderReuse();
+
   private:
     bool imageCheck( const QString &type, const QImage &image, int mismatchCount = 0 );
 
@@ -946,6 +951,148 @@ void TestQgsMapRendererJob::temporalRender()
 
 }
 
+void TestQgsMapRendererJob::parallelLayerTiles()
+{
+  std::unique_ptr< QgsVectorLayer > polygonsLayer = qgis::make_unique< QgsVectorLayer >( TEST_DATA_DIR + QStringLiteral( "/polys.shp" ),
+      QStringLiteral( "polys" ), QStringLiteral( "ogr" ) );
+  QVERIFY( polygonsLayer->isValid() );
+
+  QgsPalLayerSettings settings;
+  settings.fieldName = QStringLiteral( "Name" );
+  settings.placement = QgsPalLayerSettings::OverPoint;
+  QgsTextFormat format;
+  format.setFont( QgsFontUtils::getStandardTestFont( QStringLiteral( "Bold" ) ) );
+  format.setSize( 12 );
+  settings.setFormat( format );
+  polygonsLayer->setLabeling( new QgsVectorLayerSimpleLabeling( settings ) );
+  polygonsLayer->setLabelsEnabled( true );
+
+  QgsMapSettings mapSettings;
+  mapSettings.setExtent( polygonsLayer->extent() );
+  mapSettings.setDestinationCrs( polygonsLayer->crs() );
+  mapSettings.setOutputSize( QSize( 512, 512 ) );
+  mapSettings.setOutputDpi( 96 );
+  mapSettings.setLayers( QList<QgsMapLayer *>() << polygonsLayer.get() );
+
+  // make sure there are enough threads to split the layer into tiles
+  const int prevThreadCount = QThreadPool::globalInstance()->maxThreadCount();
+  QThreadPool::globalInstance()->setMaxThreadCount( 4 );
+
+  // tiles must render exactly the same image as the whole layer...
+  mapSettings.setFlag( QgsMapSettings::DrawLabeling, false );
+  QgsMapRendererParallelJob job( mapSettings );
+  job.start();
+  job.waitForFinished();
+  const QImage expected = job.renderedImage();
+
+  mapSettings.setFlag( QgsMapSettings::RenderLayerTilesInParallel, true );
+  QgsMapRendererParallelJob tiledJob( mapSettings );
+  tiledJob.start();
+  tiledJob.waitForFinished();
+  QVERIFY( tiledJob.errors().isEmpty() );
+  QCOMPARE( tiledJob.renderedImage(), expected );
+
+  // ...and register every feature with the labeling engine exactly once
+  mapSettings.setFlag( QgsMapSettings::DrawLabeling, true );
+  mapSettings.setFlag( QgsMapSettings::RenderLayerTilesInParallel, false );
+  QgsMapRendererParallelJob labelJob( mapSettings );
+  labelJob.start();
+  labelJob.waitForFinished();
+  std::unique_ptr< QgsLabelingResults > results( labelJob.takeLabelingResults() );
+
+  mapSettings.setFlag( QgsMapSettings::RenderLayerTilesInParallel, true );
+  QgsMapRendererParallelJob tiledLabelJob( mapSettings );
+  tiledLabelJob.start();
+  tiledLabelJob.waitForFinished();
+  std::unique_ptr< QgsLabelingResults > tiledResults( tiledLabelJob.takeLabelingResults() );
+
+  QThreadPool::globalInstance()->setMaxThreadCount( prevThreadCount );
+
+  const QList< QgsLabelPosition > labels = results->labelsWithinRect( mapSettings.visibleExtent() );
+  QVERIFY( !labels.isEmpty() );
+  QCOMPARE( tiledResults->labelsWithinRect( mapSettings.visibleExtent() ).count(), labels.count() );
+}
+
+void TestQgsMapRendererJob::pannedRenderReuse()
+{
+  std::unique_ptr< QgsVectorLayer > polygonsLayer = qgis::make_unique< QgsVectorLayer >( TEST_DATA_DIR + QStringLiteral( "/polys.shp" ),
+      QStringLiteral( "polys" ), QStringLiteral( "ogr" ) );
+  QVERIFY( polygonsLayer->isValid() );
+
+  QgsMapSettings mapSettings;
+  mapSettings.setExtent( polygonsLayer->extent() );
+  mapSettings.setDestinationCrs( polygonsLayer->crs() );
+  mapSettings.setOutputSize( QSize( 512, 512 ) );
+  mapSettings.setOutputDpi( 96 );
+  mapSettings.setLayers( QList<QgsMapLayer *>() << polygonsLayer.get() );
+
+  QgsMapRendererCache cache;
+  QgsMapRendererParallelJob job( mapSettings );
+  job.setCache( &cache );
+  job.start();
+  job.waitForFinished();
+  QVERIFY( cache.hasCacheImage( polygonsLayer->id() ) );
+
+  // replace the cached render by a plain image, so that the reused part of the panned render can be told apart
+  QImage previousRender = cache.cacheImage( polygonsLayer->id() );
+  previousRender.fill( QColor( 0, 255, 0 ) );
+  cache.setCacheImageWithParameters( polygonsLayer->id(), previousRender, mapSettings.visibleExtent(), mapSettings.mapToPixel(),
+                                     QList< QgsMapLayer * >() << polygonsLayer.get() );
+
+  // pan the map by a whole number of pixels in both directions
+  const double mapUnitsPerPixel = mapSettings.mapUnitsPerPixel();
+  QgsRectangle pannedExtent = mapSettings.visibleExtent();
+  pannedExtent.setXMinimum( pannedExtent.xMinimum() + 40 * mapUnitsPerPixel );
+  pannedExtent.setXMaximum( pannedExtent.xMaximum() + 40 * mapUnitsPerPixel );
+  pannedExtent.setYMinimum( pannedExtent.yMinimum() - 25 * mapUnitsPerPixel );
+  pannedExtent.setYMaximum( pannedExtent.yMaximum() - 25 * mapUnitsPerPixel );
+  mapSettings.setExtent( pannedExtent );
+
+  QgsMapRendererParallelJob fullJob( mapSettings );
+  fullJob.start();
+  fullJob.waitForFinished();
+  const QImage expected = fullJob.renderedImage();
+
+  QgsMapRendererParallelJob pannedJob( mapSettings );
+  pannedJob.setCache( &cache );
+  pannedJob.start();
+  pannedJob.waitForFinished();
+  QVERIFY( pannedJob.errors().isEmpty() );
+  const QImage panned = pannedJob.renderedImage();
+
+  // the part covered by the previous render is copied from it, and only the newly exposed strips
+  // on the right and at the bottom are drawn. These may only differ by antialiasing rounding
+  QCOMPARE( panned.size(), expected.size() );
+  const QRect reusedRect( 0, 0, expected.width() - 40, expected.height() - 25 );
+  int reusedMismatches = 0;
+  int mismatches = 0;
+  for ( int y = 0; y < expected.height(); ++y )
+  {
+    const QRgb *expectedLine = reinterpret_cast< const QRgb * >( expected.constScanLine( y ) );
+    const QRgb *pannedLine = reinterpret_cast< const QRgb * >( panned.constScanLine( y ) );
+    for ( int x = 0; x < expected.width(); ++x )
+    {
+      if ( reusedRect.contains( x, y ) )
+      {
+        if ( pannedLine[x] != qRgb( 0, 255, 0 ) )
+          reusedMismatches++;
+        continue;
+      }
+
+      if ( std::abs( qRed( expectedLine[x] ) - qRed( pannedLine[x] ) ) > 2
+           || std::abs( qGreen( expectedLine[x] ) - qGreen( pannedLine[x] ) ) > 2
+           || std::abs( qBlue( expectedLine[x] ) - qBlue( pannedLine[x] ) ) > 2
+           || std::abs( qAlpha( expectedLine[x] ) - qAlpha( pannedLine[x] ) ) > 2 )
+        mismatches++;
+    }
+  }
+  QCOMPARE( reusedMismatches, 0 );
+  QCOMPARE( mismatches, 0 );
+
+  // the completed render replaces the cached image
+  QVERIFY( cache.hasCacheImage( polygonsLayer->id() ) );
+}
+
 bool TestQgsMapRendererJob::imageCheck( const QString &testName, const QImage &image, int mismatchCount )
 {
   mReport += "<h2>" + testName + "</h2>\n";
@@ -0,0 +1,237 @@
+/***************************************************************************
+     testqgspackedspatialindexfile.cpp
+     ---------------------------------
+    Date                 : February 2021
+    Copyright            : (C) 2021 by QGIS.org
+    Email                : info at qgis dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgstest.h"
+#include <QObject>
+#include <QFile>
+#include <QTemporaryDir>
+
+#include "qgsapplication.h"
+#include "qgspackedspatialindexfile.h"
+
+#include <algorithm>
+
+class TestQgsPackedSpatialIndexFile: public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();// will be called before the first testfunction is executed.
+    void cleanupTestCase();// will be called after the last testfunction was executed.
+    void indexPath();
+    void intersects();
+    void emptyIndex();
+    void outOfDate();
+    void sourceOptions();
+    void invalidFile();
+
+  private:
+    static std::vector< QgsPackedSpatialIndexFile::Entry > gridEntries( int size );
+    static QString writeSource( const QString &path, const QByteArray &content );
+    QTemporaryDir mDir;
+};
+
+void TestQgsPackedSpatialIndexFile::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+  QVERIFY( mDir.isValid() );
+}
+
+void TestQgsPackedSpatialIndexFile::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+std::vector< QgsPackedSpatialIndexFile::Entry > TestQgsPackedSpatialIndexFile::gridEntries( int size )
+{
+  std::vector< QgsPackedSpatialIndexFile::Entry > entries;
+  for ( int i = 0; i < size; ++i )
+  {
+    for ( int j = 0; j < size; ++j )
+    {
+      QgsPackedSpatialIndexFile::Entry entry;
+      entry.id = i * size + j;
+      entry.offset = 1000 - entry.id;
+      // a mix of points and small boxes
+      entry.bounds = entry.id % 3 == 0 ? QgsRectangle( i, j, i, j ) : QgsRectangle( i, j, i + 0.5, j + 1.5 );
+      entries.emplace_back( entry );
+    }
+  }
+  return entries;
+}
+
+QString TestQgsPackedSpatialIndexFile::writeSource( const QString &path, const QByteArray &content )
+{
+  QFile file( path );
+  file.open( QIODevice::WriteOnly | QIODevice::Truncate );
+  file.write( content );
+  file.close();
+  return path;
+}
+
+void TestQgsPackedSpatialIndexFile::indexPath()
+{
+  QCOMPARE( QgsPackedSpatialIndexFile::indexPath( QStringLiteral( "/data/points.csv" ) ), QStringLiteral( "/data/points.csv.qgsidx" ) );
+  QCOMPARE( QgsPackedSpatialIndexFile::indexPath( QStringLiteral( "/data/file.gml" ), QStringLiteral( "roads" ) ), QStringLiteral( "/data/file.gml.roads.qgsidx" ) );
+  // layer names are sanitized
+  QVERIFY( !QgsPackedSpatialIndexFile::indexPath( QStringLiteral( "/data/file.gml" ), QStringLiteral( "a/b" ) ).contains( QStringLiteral( "a/b" ) ) );
+
+  // each set of source options gets its own index file
+  const QString xyPath = QgsPackedSpatialIndexFile::indexPath( QStringLiteral( "/data/points.csv" ), QString(), QStringLiteral( "xField=x&yField=y" ) );
+  const QString yxPath = QgsPackedSpatialIndexFile::indexPath( QStringLiteral( "/data/points.csv" ), QString(), QStringLiteral( "xField=y&yField=x" ) );
+  QVERIFY( xyPath.startsWith( QStringLiteral( "/data/points.csv." ) ) );
+  QVERIFY( xyPath.endsWith( QStringLiteral( ".qgsidx" ) ) );
+  QVERIFY( xyPath != QStringLiteral( "/data/points.csv.qgsidx" ) );
+  QVERIFY( xyPath != yxPath );
+  QCOMPARE( QgsPackedSpatialIndexFile::indexPath( QStringLiteral( "/data/points.csv" ), QString(), QStringLiteral( "xField=x&yField=y" ) ), xyPath );
+}
+
+void TestQgsPackedSpatialIndexFile::intersects()
+{
+  const QString source = writeSource( mDir.filePath( QStringLiteral( "grid.csv" ) ), QByteArray( "grid" ) );
+  const QString indexPath = QgsPackedSpatialIndexFile::indexPath( source );
+
+  std::vector< QgsPackedSpatialIndexFile::Entry > entries = gridEntries( 50 );
+  // entries without a bounding box are skipped
+  QgsPackedSpatialIndexFile::Entry noGeometry;
+  noGeometry.id = 5000;
+  noGeometry.bounds.setMinimal();
+  entries.emplace_back( noGeometry );
+
+  QString error;
+  QVERIFY( QgsPackedSpatialIndexFile::write( indexPath, source, entries, &error ) );
+  QVERIFY( error.isEmpty() );
+
+  std::unique_ptr< QgsPackedSpatialIndexFile > index = QgsPackedSpatialIndexFile::open( indexPath, source );
+  QVERIFY( index );
+  QVERIFY( index->isUpToDate() );
+  QCOMPARE( index->count(), 2500LL );
+  QCOMPARE( index->extent(), QgsRectangle( 0, 0, 49.5, 50.5 ) );
+
+  const QList< QgsRectangle > queries = QList< QgsRectangle >()
+                                        << QgsRectangle( 10.2, 10.2, 12.7, 15.1 )
+                                        << QgsRectangle( 0, 0, 0, 0 )
+                                        << QgsRectangle( -10, -10, 100, 100 )
+                                        << QgsRectangle( 48, 49, 60, 60 )
+                                        << QgsRectangle( 100, 100, 110, 110 );
+  for ( const QgsRectangle &query : queries )
+  {
+    std::vector< QgsFeatureId > expected;
+    for ( const QgsPackedSpatialIndexFile::Entry &entry : entries )
+    {
+      if ( entry.id != noGeometry.id && entry.bounds.intersects( query ) )
+        expected.push_back( entry.id );
+    }
+    std::sort( expected.begin(), expected.end() );
+
+    const QVector< QgsPackedSpatialIndexFile::Entry > results = index->intersects( query );
+    std::vector< QgsFeatureId > ids;
+    for ( int i = 0; i < results.size(); ++i )
+    {
+      ids.push_back( results.at( i ).id );
+      // offsets are kept with their feature, and results are sorted by offset
+      QCOMPARE( results.at( i ).offset, 1000 - results.at( i ).id );
+      if ( i > 0 )
+        QVERIFY( results.at( i - 1 ).offset <= results.at( i ).offset );
+    }
+    std::sort( ids.begin(), ids.end() );
+    QCOMPARE( ids, expected );
+  }
+}
+
+void TestQgsPackedSpatialIndexFile::emptyIndex()
+{
+  const QString source = writeSource( mDir.filePath( QStringLiteral( "empty.csv" ) ), QByteArray( "empty" ) );
+  const QString indexPath = QgsPackedSpatialIndexFile::indexPath( source );
+
+  QVERIFY( QgsPackedSpatialIndexFile::write( indexPath, source, std::vector< QgsPackedSpatialIndexFile::Entry >() ) );
+  std::unique_ptr< QgsPackedSpatialIndexFile > index = QgsPackedSpatialIndexFile::open( indexPath, source );
+  QVERIFY( index );
+  QCOMPARE( index->count(), 0LL );
+  QVERIFY( index->intersects( QgsRectangle( -1, -1, 1, 1 ) ).isEmpty() );
+}
+
+void TestQgsPackedSpatialIndexFile::outOfDate()
+{
+  const QString source = writeSource( mDir.filePath( QStringLiteral( "changed.csv" ) ), QByteArray( "before" ) );
+  const QString indexPath = QgsPackedSpatialIndexFile::indexPath( source );
+
+  QVERIFY( QgsPackedSpatialIndexFile::write( indexPath, source, gridEntries( 5 ) ) );
+  std::unique_ptr< QgsPackedSpatialIndexFile > index = QgsPackedSpatialIndexFile::open( indexPath, source );
+  QVERIFY( index );
+  QVERIFY( index->isUpToDate() );
+
+  writeSource( source, QByteArray( "after the change" ) );
+  QVERIFY( !index->isUpToDate() );
+  QVERIFY( !QgsPackedSpatialIndexFile::open( indexPath, source ) );
+
+  // rebuilding the index makes it usable again
+  QVERIFY( QgsPackedSpatialIndexFile::write( indexPath, source, gridEntries( 5 ) ) );
+  QVERIFY( QgsPackedSpatialIndexFile::open( indexPath, source ) );
+}
+
+void TestQgsPackedSpatialIndexFile::sourceOptions()
+{
+  const QString source = writeSource( mDir.filePath( QStringLiteral( "options.csv" ) ), QByteArray( "options" ) );
+  const QString options = QStringLiteral( "xField=x&yField=y&skipLines=1" );
+  const QString indexPath = QgsPackedSpatialIndexFile::indexPath( source, QString(), options );
+
+  QVERIFY( QgsPackedSpatialIndexFile::write( indexPath, source, gridEntries( 5 ), nullptr, options ) );
+  QVERIFY( QgsPackedSpatialIndexFile::open( indexPath, source, options ) );
+
+  // an index built with other options is never used, even if the data file did not change
+  QVERIFY( !QgsPackedSpatialIndexFile::open( indexPath, source ) );
+  QVERIFY( !QgsPackedSpatialIndexFile::open( indexPath, source, QStringLiteral( "xField=x&yField=y&skipLines=2" ) ) );
+  QFile::copy( indexPath, QgsPackedSpatialIndexFile::indexPath( source, QString(), QStringLiteral( "wktField=wkt" ) ) );
+  QVERIFY( !QgsPackedSpatialIndexFile::open( QgsPackedSpatialIndexFile::indexPath( source, QString(), QStringLiteral( "wktField=wkt" ) ), source, QStringLiteral( "wktField=wkt" ) ) );
+}
+
+void TestQgsPackedSpatialIndexFile::invalidFile()
+{
+  const QString source = writeSource( mDir.filePath( QStringLiteral( "invalid.csv" ) ), QByteArray( "invalid" ) );
+  const QString indexPath = QgsPackedSpatialIndexFile::indexPath( source );
+
+  QVERIFY( !QgsPackedSpatialIndexFile::open( indexPath, source ) );
+
+  writeSource( indexPath, QByteArray( "not an index file" ) );
+  QVERIFY( !QgsPackedSpatialIndexFile::open( indexPath, source ) );
+
+  // truncated index
+  QVERIFY( QgsPackedSpatialIndexFile::write( indexPath, source, gridEntries( 5 ) ) );
+  QFile file( indexPath );
+  QVERIFY( file.resize( file.size() - 8 ) );
+  QVERIFY( !QgsPackedSpatialIndexFile::open( indexPath, source ) );
+
+  // inconsistent node levels: 25 leaves give levels ending at 25, 27 and 28
+  QVERIFY( QgsPackedSpatialIndexFile::write( indexPath, source, gridEntries( 5 ) ) );
+  QVERIFY( QgsPackedSpatialIndexFile::open( indexPath, source ) );
+  QVERIFY( file.open( QIODevice::ReadOnly ) );
+  QByteArray content = file.readAll();
+  file.close();
+  const qint64 levelBounds[] = { 25, 27, 28 };
+  const int levelBoundsPosition = content.indexOf( QByteArray( reinterpret_cast< const char * >( levelBounds ), sizeof( levelBounds ) ) );
+  QVERIFY( levelBoundsPosition > 0 );
+
+  const qint64 invalidLevelBounds[][3] = { { 25, 26, 28 }, { 25, 28, 27 }, { 25, 27, 27 } };
+  for ( const auto &invalid : invalidLevelBounds )
+  {
+    content.replace( levelBoundsPosition, sizeof( levelBounds ), reinterpret_cast< const char * >( invalid ), sizeof( levelBounds ) );
+    writeSource( indexPath, content );
+    QVERIFY( !QgsPackedSpatialIndexFile::open( indexPath, source ) );
+  }
+}
+
+QGSTEST_MAIN( TestQgsPackedSpatialIndexFile )
+#include "testqgspackedspatialindexfile.moc"
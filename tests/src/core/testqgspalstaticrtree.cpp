@@ -0,0 +1,221 @@
+/***************************************************************************
+     testqgspalstaticrtree.cpp
+     -------------------------
+    Date                 : February 2021
+    Copyright            : (C) 2021 by QGIS.org
+    Email                : info at qgis dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgstest.h"
+#include <QObject>
+
+#include "palstaticrtree.h"
+
+#include <algorithm>
+#include <random>
+
+struct TestItem
+{
+  int id = 0;
+  QgsRectangle bounds;
+};
+
+class TestQgsPalStaticRtree: public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void emptyIndex();
+    void singleItem();
+    void identicalBoxes();
+    void degenerateBoxes();
+    void randomBoxes();
+    void stopSearch();
+
+  private:
+    static QList< int > found( const PalStaticRtree< TestItem > &index, const QgsRectangle &bounds );
+    static QList< int > bruteForce( const std::vector< TestItem > &items, const QgsRectangle &bounds );
+    static void buildIndex( PalStaticRtree< TestItem > &index, std::vector< TestItem > &items );
+};
+
+QList< int > TestQgsPalStaticRtree::found( const PalStaticRtree< TestItem > &index, const QgsRectangle &bounds )
+{
+  QList< int > res;
+  index.intersects( bounds, [&res]( TestItem * item )-> bool
+  {
+    res << item->id;
+    return true;
+  } );
+  std::sort( res.begin(), res.end() );
+  return res;
+}
+
+QList< int > TestQgsPalStaticRtree::bruteForce( const std::vector< TestItem > &items, const QgsRectangle &bounds )
+{
+  // boxes which touch the query box are matched too
+  QList< int > res;
+  for ( const TestItem &item : items )
+  {
+    if ( item.bounds.xMinimum() <= bounds.xMaximum() && item.bounds.yMinimum() <= bounds.yMaximum()
+         && item.bounds.xMaximum() >= bounds.xMinimum() && item.bounds.yMaximum() >= bounds.yMinimum() )
+      res << item.id;
+  }
+  return res;
+}
+
+void TestQgsPalStaticRtree::buildIndex( PalStaticRtree< TestItem > &index, std::vector< TestItem > &items )
+{
+  for ( TestItem &item : items )
+    index.add( &item, item.bounds );
+  index.finish();
+}
+
+void TestQgsPalStaticRtree::emptyIndex()
+{
+  PalStaticRtree< TestItem > index;
+  index.finish();
+  QCOMPARE( index.size(), static_cast< std::size_t >( 0 ) );
+  QVERIFY( found( index, QgsRectangle( -1000, -1000, 1000, 1000 ) ).isEmpty() );
+  QVERIFY( found( index, QgsRectangle() ).isEmpty() );
+}
+
+void TestQgsPalStaticRtree::singleItem()
+{
+  std::vector< TestItem > items( 1 );
+  items[0].bounds = QgsRectangle( 1, 2, 3, 4 );
+
+  PalStaticRtree< TestItem > index( items.size() );
+  buildIndex( index, items );
+  QCOMPARE( index.size(), static_cast< std::size_t >( 1 ) );
+
+  QCOMPARE( found( index, QgsRectangle( 0, 0, 10, 10 ) ), QList< int >() << 0 );
+  QCOMPARE( found( index, QgsRectangle( 2, 3, 2, 3 ) ), QList< int >() << 0 );
+  // touching boxes
+  QCOMPARE( found( index, QgsRectangle( 3, 4, 5, 5 ) ), QList< int >() << 0 );
+  QVERIFY( found( index, QgsRectangle( 3.1, 4.1, 5, 5 ) ).isEmpty() );
+}
+
+void TestQgsPalStaticRtree::identicalBoxes()
+{
+  // the extent of all data has no width or height
+  std::vector< TestItem > items( 100 );
+  for ( int i = 0; i < 100; ++i )
+  {
+    items[i].id = i;
+    items[i].bounds = QgsRectangle( 5, 5, 5, 5 );
+  }
+
+  PalStaticRtree< TestItem > index( items.size() );
+  buildIndex( index, items );
+
+  QCOMPARE( found( index, QgsRectangle( 5, 5, 5, 5 ) ), bruteForce( items, QgsRectangle( 5, 5, 5, 5 ) ) );
+  QCOMPARE( found( index, QgsRectangle( 0, 0, 10, 10 ) ).size(), 100 );
+  QVERIFY( found( index, QgsRectangle( 6, 6, 10, 10 ) ).isEmpty() );
+}
+
+void TestQgsPalStaticRtree::degenerateBoxes()
+{
+  // points, and horizontal and vertical segments
+  std::vector< TestItem > items;
+  int id = 0;
+  for ( int x = 0; x < 20; ++x )
+  {
+    for ( int y = 0; y < 20; ++y )
+    {
+      TestItem item;
+      item.id = id++;
+      switch ( ( x + y ) % 3 )
+      {
+        case 0:
+          item.bounds = QgsRectangle( x, y, x, y );
+          break;
+        case 1:
+          item.bounds = QgsRectangle( x, y, x + 0.5, y );
+          break;
+        default:
+          item.bounds = QgsRectangle( x, y, x, y + 0.5 );
+          break;
+      }
+      items.emplace_back( item );
+    }
+  }
+
+  PalStaticRtree< TestItem > index( items.size() );
+  buildIndex( index, items );
+  QCOMPARE( index.size(), items.size() );
+
+  const QList< QgsRectangle > queries = QList< QgsRectangle >()
+                                        << QgsRectangle()
+                                        << QgsRectangle( 3, 3, 3, 3 )
+                                        << QgsRectangle( 3.25, 3, 3.25, 3 )
+                                        << QgsRectangle( 3.5, 0, 3.5, 20 )
+                                        << QgsRectangle( 0, 7.5, 20, 7.5 )
+                                        << QgsRectangle( 2.1, 2.1, 2.9, 2.9 )
+                                        << QgsRectangle( 4.5, 4.5, 10.5, 12.2 )
+                                        << QgsRectangle( -10, -10, 30, 30 )
+                                        << QgsRectangle( 30, 30, 40, 40 );
+  for ( const QgsRectangle &query : queries )
+    QCOMPARE( found( index, query ), bruteForce( items, query ) );
+}
+
+void TestQgsPalStaticRtree::randomBoxes()
+{
+  // enough boxes for several levels of nodes
+  std::mt19937 generator( 42 );
+  std::uniform_real_distribution< double > position( -1000, 1000 );
+  std::uniform_real_distribution< double > size( 0, 50 );
+
+  std::vector< TestItem > items( 5000 );
+  for ( int i = 0; i < 5000; ++i )
+  {
+    const double x = position( generator );
+    const double y = position( generator );
+    items[i].id = i;
+    items[i].bounds = QgsRectangle( x, y, x + size( generator ), y + size( generator ) );
+  }
+
+  PalStaticRtree< TestItem > index( items.size() );
+  buildIndex( index, items );
+  QCOMPARE( index.size(), items.size() );
+
+  for ( int i = 0; i < 200; ++i )
+  {
+    const double x = position( generator );
+    const double y = position( generator );
+    const double width = i % 4 == 0 ? 0 : size( generator ) * 4;
+    const double height = i % 5 == 0 ? 0 : size( generator ) * 4;
+    const QgsRectangle query( x, y, x + width, y + height );
+    QCOMPARE( found( index, query ), bruteForce( items, query ) );
+  }
+
+  QCOMPARE( found( index, QgsRectangle( -2000, -2000, 2000, 2000 ) ).size(), 5000 );
+}
+
+void TestQgsPalStaticRtree::stopSearch()
+{
+  std::vector< TestItem > items( 100 );
+  for ( int i = 0; i < 100; ++i )
+  {
+    items[i].id = i;
+    items[i].bounds = QgsRectangle( i, 0, i + 1, 1 );
+  }
+
+  PalStaticRtree< TestItem > index( items.size() );
+  buildIndex( index, items );
+
+  int count = 0;
+  index.intersects( QgsRectangle( 0, 0, 100, 1 ), [&count]( TestItem * )-> bool
+  {
+    return ++count < 10;
+  } );
+  QCOMPARE( count, 10 );
+}
+
+QGSTEST_MAIN( TestQgsPalStaticRtree )
+#include "testqgspalstaticrtree.moc"
@@ -0,0 +1,119 @@
+/***************************************************************************
+     testqgspreparedgeometrycache.cpp
+     --------------------------------
+    Date                 : February 2021
+    Copyright            : (C) 2021 by QGIS.org
+    Email                : info at qgis dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgstest.h"
+#include <QObject>
+
+#include "qgsapplication.h"
+#include "qgsgeometryengine.h"
+#include "qgspreparedgeometrycache.h"
+
+class TestQgsPreparedGeometryCache: public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();// will be called before the first testfunction is executed.
+    void cleanupTestCase();// will be called after the last testfunction was executed.
+    void preparedEngine();
+    void changedGeometry();
+    void maximumSize();
+};
+
+void TestQgsPreparedGeometryCache::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+}
+
+void TestQgsPreparedGeometryCache::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+void TestQgsPreparedGeometryCache::preparedEngine()
+{
+  QgsPreparedGeometryCache cache;
+  QVERIFY( !cache.preparedEngine( QStringLiteral( "a" ), 1, QgsGeometry() ) );
+  QCOMPARE( cache.count(), 0 );
+
+  const QgsGeometry polygon = QgsGeometry::fromWkt( QStringLiteral( "Polygon ((0 0, 10 0, 10 10, 0 10, 0 0))" ) );
+  std::shared_ptr< QgsGeometryEngine > engine = cache.preparedEngine( QStringLiteral( "a" ), 1, polygon );
+  QVERIFY( engine );
+  QVERIFY( engine->intersects( QgsGeometry::fromWkt( QStringLiteral( "Point (5 5)" ) ).constGet() ) );
+  QVERIFY( !engine->intersects( QgsGeometry::fromWkt( QStringLiteral( "Point (15 5)" ) ).constGet() ) );
+  QCOMPARE( cache.count(), 1 );
+  QVERIFY( cache.size() >= QgsPreparedGeometryCache::estimatedSize( polygon ) );
+
+  // same feature, even with a copy of the geometry fetched again
+  QCOMPARE( cache.preparedEngine( QStringLiteral( "a" ), 1, polygon ).get(), engine.get() );
+  QCOMPARE( cache.preparedEngine( QStringLiteral( "a" ), 1, QgsGeometry::fromWkt( polygon.asWkt() ) ).get(), engine.get() );
+
+  // other feature or source
+  QVERIFY( cache.preparedEngine( QStringLiteral( "a" ), 2, polygon ).get() != engine.get() );
+  QVERIFY( cache.preparedEngine( QStringLiteral( "b" ), 1, polygon ).get() != engine.get() );
+  QCOMPARE( cache.count(), 3 );
+
+  cache.clear();
+  QCOMPARE( cache.count(), 0 );
+  QCOMPARE( cache.size(), 0 );
+  // engines remain valid when they are removed from the cache
+  QVERIFY( engine->intersects( QgsGeometry::fromWkt( QStringLiteral( "Point (5 5)" ) ).constGet() ) );
+}
+
+void TestQgsPreparedGeometryCache::changedGeometry()
+{
+  QgsPreparedGeometryCache cache;
+  std::shared_ptr< QgsGeometryEngine > engine = cache.preparedEngine( QStringLiteral( "a" ), 1, QgsGeometry::fromWkt( QStringLiteral( "Polygon ((0 0, 10 0, 10 10, 0 10, 0 0))" ) ) );
+
+  // the feature geometry changed, so the engine must be prepared again
+  std::shared_ptr< QgsGeometryEngine > changed = cache.preparedEngine( QStringLiteral( "a" ), 1, QgsGeometry::fromWkt( QStringLiteral( "Polygon ((20 0, 30 0, 30 10, 20 10, 20 0))" ) ) );
+  QVERIFY( changed.get() != engine.get() );
+  QVERIFY( changed->intersects( QgsGeometry::fromWkt( QStringLiteral( "Point (25 5)" ) ).constGet() ) );
+  QVERIFY( !changed->intersects( QgsGeometry::fromWkt( QStringLiteral( "Point (5 5)" ) ).constGet() ) );
+  QCOMPARE( cache.count(), 1 );
+}
+
+void TestQgsPreparedGeometryCache::maximumSize()
+{
+  QgsPreparedGeometryCache cache( 10 );
+  QCOMPARE( cache.maximumSize(), 10 );
+
+  // the least recently used engines are evicted
+  const QgsGeometry point = QgsGeometry::fromWkt( QStringLiteral( "Point (1 1)" ) );
+  const int pointSize = QgsPreparedGeometryCache::estimatedSize( point );
+  QVERIFY( pointSize > 0 );
+  for ( int i = 0; i < 20; ++i )
+    cache.preparedEngine( QStringLiteral( "a" ), i, point );
+  QVERIFY( cache.size() <= 10 );
+  QCOMPARE( cache.count(), 10 / pointSize );
+
+  // geometries larger than the whole cache are prepared but not cached
+  QgsPolylineXY line;
+  for ( int i = 0; i < 1000; ++i )
+    line << QgsPointXY( i, i % 2 );
+  const QgsGeometry largeLine = QgsGeometry::fromPolylineXY( line );
+  QVERIFY( QgsPreparedGeometryCache::estimatedSize( largeLine ) > 10 );
+  cache.clear();
+  QVERIFY( cache.preparedEngine( QStringLiteral( "a" ), 1, largeLine ) );
+  QCOMPARE( cache.count(), 0 );
+
+  cache.setMaximumSize( 1000 );
+  QCOMPARE( cache.maximumSize(), 1000 );
+  QVERIFY( cache.preparedEngine( QStringLiteral( "a" ), 1, largeLine ) );
+  QCOMPARE( cache.count(), 1 );
+}
+
+QGSTEST_MAIN( TestQgsPreparedGeometryCache )
+#include "testqgspreparedgeometrycache.moc"
@@ -40,6 +40,7 @@ class TestQgsRasterIterator : public QObject
 
     void testBasic();
     void testNoBlock();
+    void testPrefetch();
 
   private:
 
@@ -354,6 +355,67 @@ void TestQgsRasterIterator::testNoBlock()
 }
 
 
+void TestQgsRasterIterator::testPrefetch()
+{
+  QgsRasterDataProvider *provider = mpRasterLayer->dataProvider();
+  QVERIFY( provider );
+  QVERIFY( provider->providerCapabilities() & QgsRasterDataProvider::ThreadSafeRead );
+
+  QgsRasterIterator it( provider );
+  QgsRasterIterator prefetchIt( provider );
+  QVERIFY( !prefetchIt.isPrefetchEnabled() );
+  prefetchIt.setPrefetchEnabled( true );
+  QVERIFY( prefetchIt.isPrefetchEnabled() );
+
+  // tiles are aligned to the blocks of the provider, when they are not larger than the tiles
+  if ( provider->xBlockSize() <= QgsRasterIterator::DEFAULT_MAXIMUM_TILE_WIDTH )
+    QCOMPARE( it.maximumTileWidth() % provider->xBlockSize(), 0 );
+  if ( provider->yBlockSize() <= QgsRasterIterator::DEFAULT_MAXIMUM_TILE_HEIGHT )
+    QCOMPARE( it.maximumTileHeight() % provider->yBlockSize(), 0 );
+
+  it.setMaximumTileWidth( 3000 );
+  it.setMaximumTileHeight( 2500 );
+  prefetchIt.setMaximumTileWidth( 3000 );
+  prefetchIt.setMaximumTileHeight( 2500 );
+  it.startRasterRead( 1, mpRasterLayer->width(), mpRasterLayer->height(), mpRasterLayer->extent() );
+  prefetchIt.startRasterRead( 1, mpRasterLayer->width(), mpRasterLayer->height(), mpRasterLayer->extent() );
+
+  int nCols;
+  int nRows;
+  int topLeftCol;
+  int topLeftRow;
+  std::unique_ptr< QgsRasterBlock > block;
+  int prefetchCols;
+  int prefetchRows;
+  int prefetchLeftCol;
+  int prefetchTopRow;
+  std::unique_ptr< QgsRasterBlock > prefetchBlock;
+  int parts = 0;
+  while ( it.readNextRasterPart( 1, nCols, nRows, block, topLeftCol, topLeftRow ) )
+  {
+    QVERIFY( prefetchIt.readNextRasterPart( 1, prefetchCols, prefetchRows, prefetchBlock, prefetchLeftCol, prefetchTopRow ) );
+    QCOMPARE( prefetchCols, nCols );
+    QCOMPARE( prefetchRows, nRows );
+    QCOMPARE( prefetchLeftCol, topLeftCol );
+    QCOMPARE( prefetchTopRow, topLeftRow );
+    QVERIFY( prefetchBlock->isValid() );
+    QCOMPARE( prefetchBlock->data(), block->data() );
+    parts++;
+  }
+  QVERIFY( !prefetchIt.readNextRasterPart( 1, prefetchCols, prefetchRows, prefetchBlock, prefetchLeftCol, prefetchTopRow ) );
+  QCOMPARE( parts, 9 );
+
+  // restarting discards the pending read
+  prefetchIt.startRasterRead( 1, mpRasterLayer->width(), mpRasterLayer->height(), mpRasterLayer->extent() );
+  QVERIFY( prefetchIt.readNextRasterPart( 1, prefetchCols, prefetchRows, prefetchBlock, prefetchLeftCol, prefetchTopRow ) );
+  prefetchIt.startRasterRead( 1, mpRasterLayer->width(), mpRasterLayer->height(), mpRasterLayer->extent() );
+  QVERIFY( prefetchIt.readNextRasterPart( 1, prefetchCols, prefetchRows, prefetchBlock, prefetchLeftCol, prefetchTopRow ) );
+  QCOMPARE( prefetchLeftCol, 0 );
+  QCOMPARE( prefetchTopRow, 0 );
+  prefetchIt.stopRasterRead( 1 );
+}
+
+
 QGSTEST_MAIN( TestQgsRasterIterator )
 
 #include "testqgsrasteriterator.moc"
@@ -45,6 +45,7 @@
 #include "qgsrastertransparency.h"
 #include "qgspalettedrasterrenderer.h"
 #include "qgsrasterlayertemporalproperties.h"
+#include "qgsrasterprojector.h"
 
 //qgis unit test includes
 #include <qgsrenderchecker.h>
@@ -98,6 +99,7 @@ class TestQgsRasterLayer : public QObject
     void regression992(); //test for issue #992 - GeoJP2 images improperly displayed as all black
     void testRefreshRendererIfNeeded();
     void sample();
+    void projectedBlock();
     void testTemporalProperties();
 
 
@@ -1006,6 +1008,51 @@ void TestQgsRasterLayer::sample()
   QVERIFY( !ok );
 }
 
+void TestQgsRasterLayer::projectedBlock()
+{
+  const QgsCoordinateReferenceSystem destCrs( QStringLiteral( "EPSG:4326" ) );
+  QgsRasterProjector projector;
+  projector.setInput( mpLandsatRasterLayer->dataProvider() );
+  projector.setCrs( mpLandsatRasterLayer->crs(), destCrs, QgsCoordinateTransformContext() );
+
+  const QgsCoordinateTransform transform( mpLandsatRasterLayer->crs(), destCrs, QgsCoordinateTransformContext() );
+  const QgsRectangle extent = transform.transformBoundingBox( mpLandsatRasterLayer->extent() );
+
+  // large enough to be projected by several concurrent ranges of rows
+  const int width = 400;
+  const int height = 300;
+
+  projector.setPrecision( QgsRasterProjector::Exact );
+  std::unique_ptr< QgsRasterBlock > exact( projector.block( 1, extent, width, height ) );
+  projector.setPrecision( QgsRasterProjector::Approximate );
+  std::unique_ptr< QgsRasterBlock > approximate( projector.block( 1, extent, width, height ) );
+
+  QVERIFY( exact->isValid() );
+  QVERIFY( approximate->isValid() );
+  QCOMPARE( exact->width(), width );
+  QCOMPARE( exact->height(), height );
+
+  int dataCells = 0;
+  int differentCells = 0;
+  for ( int row = 0; row < height; ++row )
+  {
+    for ( int col = 0; col < width; ++col )
+    {
+      const bool exactIsNoData = exact->isNoData( row, col );
+      if ( !exactIsNoData )
+        dataCells++;
+      if ( exactIsNoData != approximate->isNoData( row, col ) || ( !exactIsNoData && exact->value( row, col ) != approximate->value( row, col ) ) )
+        differentCells++;
+    }
+  }
+
+  // the source is reprojected within the bounding box of its extent
+  QVERIFY( dataCells > width * height / 2 );
+  QVERIFY( dataCells < width * height );
+  // the approximation only differs from the exact projection at the edges of a few source pixels
+  QVERIFY( differentCells < dataCells / 20 );
+}
+
 void TestQgsRasterLayer::testTemporalProperties()
 {
   QgsRasterLayerTemporalProperties *temporalProperties = qobject_cast< QgsRasterLayerTemporalProperties * >( mTemporalRasterLayer->temporalProperties() );
@@ -427,6 +427,88 @@ class TestQgsSpatialIndex : public QObject
       QCOMPARE( i2.nearestNeighbor( g, 2, 0.2 ), QList< QgsFeatureId >() );
     }
 
+    void testStaticIndex()
+    {
+      QgsVectorLayer *vl = new QgsVectorLayer( QStringLiteral( "LineString" ), QStringLiteral( "x" ), QStringLiteral( "memory" ) );
+      int fid = 0;
+      QgsFeatureList flist;
+      for ( int x = 0; x < 60; ++x )
+      {
+        for ( int y = 0; y < 60; ++y )
+        {
+          QgsFeature f( fid++ );
+          f.setGeometry( qgis::make_unique< QgsLineString >( QgsPoint( x, y ), QgsPoint( x + 0.3 * ( fid % 4 + 1 ), y + 0.7 * ( fid % 3 ) ) ) );
+          flist << f;
+        }
+      }
+      // features without geometry are skipped
+      flist << QgsFeature( fid++ );
+      vl->dataProvider()->addFeatures( flist );
+
+      const QgsSpatialIndex rtree( *vl, nullptr, QgsSpatialIndex::FlagStoreFeatureGeometries );
+      const QgsSpatialIndex staticIndex( *vl, nullptr, QgsSpatialIndex::FlagStoreFeatureGeometries | QgsSpatialIndex::FlagStaticIndex );
+      const QgsSpatialIndex staticBoxIndex( *vl, nullptr, QgsSpatialIndex::FlagStaticIndex );
+      const QgsSpatialIndex boxIndex( *vl );
+
+      auto sorted = []( QList< QgsFeatureId > ids )
+      {
+        std::sort( ids.begin(), ids.end() );
+        return ids;
+      };
+
+      const QList< QgsRectangle > rects = QList< QgsRectangle >() << QgsRectangle( 10.2, 10.2, 12.7, 15.1 )
+                                          << QgsRectangle( 0, 0, 0, 0 )
+                                          << QgsRectangle( -10, -10, 100, 100 )
+                                          << QgsRectangle( 58, 59, 70, 70 )
+                                          << QgsRectangle( 100, 100, 110, 110 );
+      for ( const QgsRectangle &rect : rects )
+      {
+        QCOMPARE( sorted( staticIndex.intersects( rect ) ), sorted( rtree.intersects( rect ) ) );
+      }
+      QCOMPARE( staticIndex.intersects( QgsRectangle( -10, -10, 100, 100 ) ).size(), 3600 );
+
+      const QList< QgsPointXY > points = QList< QgsPointXY >() << QgsPointXY( 10.1, 20.6 ) << QgsPointXY( -5, -5 ) << QgsPointXY( 30.45, 70 );
+      for ( const QgsPointXY &point : points )
+      {
+        for ( int neighbors : { 1, 3, 10 } )
+        {
+          QCOMPARE( sorted( staticIndex.nearestNeighbor( point, neighbors ) ), sorted( rtree.nearestNeighbor( point, neighbors ) ) );
+          QCOMPARE( sorted( staticIndex.nearestNeighbor( point, neighbors, 1.5 ) ), sorted( rtree.nearestNeighbor( point, neighbors, 1.5 ) ) );
+          QCOMPARE( sorted( staticBoxIndex.nearestNeighbor( point, neighbors ) ), sorted( boxIndex.nearestNeighbor( point, neighbors ) ) );
+        }
+      }
+
+      const QgsGeometry g = QgsGeometry::fromWkt( QStringLiteral( "LineString (20.1 20.1, 25.2 21.4, 22.3 30.5)" ) );
+      QCOMPARE( sorted( staticIndex.nearestNeighbor( g, 5 ) ), sorted( rtree.nearestNeighbor( g, 5 ) ) );
+      QCOMPARE( sorted( staticIndex.nearestNeighbor( g, 5, 0.2 ) ), sorted( rtree.nearestNeighbor( g, 5, 0.2 ) ) );
+
+      // results are sorted by distance
+      QCOMPARE( staticIndex.nearestNeighbor( QgsPointXY( 10.05, 70 ), 1 ), QList< QgsFeatureId >() << 659 );
+
+      QCOMPARE( staticIndex.geometry( 1 ).asWkt( 1 ), rtree.geometry( 1 ).asWkt( 1 ) );
+      QVERIFY( staticBoxIndex.geometry( 1 ).isNull() );
+
+      // static indexes cannot be modified, but copies share their tree
+      QgsSpatialIndex copy( staticIndex );
+      QgsFeature f = vl->getFeature( 1 );
+      QVERIFY( !copy.deleteFeature( f ) );
+      QVERIFY( !copy.addFeature( f ) );
+      QVERIFY( !copy.addFeature( 5000, QgsRectangle( 0, 0, 1, 1 ) ) );
+      QCOMPARE( sorted( copy.intersects( QgsRectangle( 10.2, 10.2, 12.7, 15.1 ) ) ), sorted( rtree.intersects( QgsRectangle( 10.2, 10.2, 12.7, 15.1 ) ) ) );
+
+      // empty static index
+      const QgsSpatialIndex empty( QgsFeatureIterator(), nullptr, QgsSpatialIndex::FlagStaticIndex );
+      QVERIFY( empty.intersects( QgsRectangle( -10, -10, 100, 100 ) ).isEmpty() );
+      QVERIFY( empty.nearestNeighbor( QgsPointXY( 0, 0 ), 1 ).isEmpty() );
+
+      // the flag is ignored for empty indexes
+      QgsSpatialIndex manual( QgsSpatialIndex::FlagStaticIndex );
+      QVERIFY( manual.addFeature( f ) );
+      QCOMPARE( manual.intersects( f.geometry().boundingBox() ), QList< QgsFeatureId >() << 1 );
+
+      delete vl;
+    }
+
 };
 
 QGSTEST_MAIN( TestQgsSpatialIndex )
@@ -17,6 +17,7 @@
 #include <QStringList>
 #include <QApplication>
 #include <QFileInfo>
+#include <QPainter>
 
 //qgis includes...
 #include "qgsmultirenderchecker.h"
@@ -31,6 +32,8 @@
 #include "qgsfillsymbollayer.h"
 #include "qgssinglesymbolrenderer.h"
 #include "qgsmarkersymbollayer.h"
+#include "qgsmapsettings.h"
+#include "qgsrendercontext.h"
 
 #include "qgsstyle.h"
 
@@ -70,6 +73,7 @@ class TestQgsSymbol : public QObject
     void testParseColor();
     void testParseColorList();
     void symbolProperties();
+    void renderWkb();
 };
 
 TestQgsSymbol::TestQgsSymbol() = default;
@@ -461,5 +465,67 @@ void TestQgsSymbol::symbolProperties()
   delete fillSymbol2;
 }
 
+void TestQgsSymbol::renderWkb()
+{
+  QgsLineSymbol lineSymbol;
+  QVERIFY( lineSymbol.canRenderWkb() );
+  QgsFillSymbol fillSymbol;
+  QVERIFY( fillSymbol.canRenderWkb() );
+  QgsMarkerSymbol markerSymbol;
+  QVERIFY( !markerSymbol.canRenderWkb() );
+
+  std::unique_ptr< QgsLineSymbol > markerLineSymbol( new QgsLineSymbol( QgsSymbolLayerList() << new QgsMarkerLineSymbolLayer() ) );
+  QVERIFY( !markerLineSymbol->canRenderWkb() );
+  lineSymbol.symbolLayer( 0 )->setDataDefinedProperty( QgsSymbolLayer::PropertyStrokeWidth, QgsProperty::fromExpression( QStringLiteral( "2" ) ) );
+  QVERIFY( !lineSymbol.canRenderWkb() );
+  lineSymbol.symbolLayer( 0 )->setDataDefinedProperty( QgsSymbolLayer::PropertyStrokeWidth, QgsProperty() );
+
+  QgsMapSettings ms;
+  ms.setExtent( QgsRectangle( 0, 0, 100, 100 ) );
+  ms.setOutputSize( QSize( 200, 200 ) );
+
+  // rendering from WKB must give exactly the same result as rendering the feature's geometry
+  auto render = [&ms]( QgsSymbol * symbol, const QgsGeometry & geometry, bool fromWkb ) -> QImage
+  {
+    QImage image( ms.outputSize(), QImage::Format_ARGB32_Premultiplied );
+    image.fill( Qt::transparent );
+    QPainter painter( &image );
+    QgsRenderContext context = QgsRenderContext::fromMapSettings( ms );
+    context.setPainter( &painter );
+
+    QgsFeature feature;
+    bool rendered = true;
+    symbol->startRender( context );
+    if ( fromWkb )
+    {
+      rendered = symbol->renderWkb( feature, geometry.asWkb(), context );
+    }
+    else
+    {
+      feature.setGeometry( geometry );
+      symbol->renderFeature( feature, context );
+    }
+    symbol->stopRender( context );
+    painter.end();
+    return rendered ? image : QImage();
+  };
+
+  const QgsGeometry line = QgsGeometry::fromWkt( QStringLiteral( "MultiLineStringZ ((-20 10 1, 50 50 2, 120 60 3),(10 90 1, 30 70 1))" ) );
+  QImage expected = render( &lineSymbol, line, false );
+  QImage actual = render( &lineSymbol, line, true );
+  QVERIFY( !actual.isNull() );
+  QCOMPARE( actual, expected );
+
+  const QgsGeometry polygon = QgsGeometry::fromWkt( QStringLiteral( "MultiPolygon (((10 10, 10 60, 60 60, 60 10, 10 10),(20 20, 30 20, 30 30, 20 20)),((70 70, 150 70, 150 150, 70 70)))" ) );
+  expected = render( &fillSymbol, polygon, false );
+  actual = render( &fillSymbol, polygon, true );
+  QVERIFY( !actual.isNull() );
+  QCOMPARE( actual, expected );
+
+  // unsupported geometry types must be rendered with renderFeature()
+  QVERIFY( render( &lineSymbol, QgsGeometry::fromWkt( QStringLiteral( "CircularString (0 0, 10 10, 20 0)" ) ), true ).isNull() );
+  QVERIFY( render( &fillSymbol, line, true ).isNull() );
+}
+
 QGSTEST_MAIN( TestQgsSymbol )
 #include "testqgssymbol.moc"
@@ -33,6 +33,7 @@ from qgis.core import (
     QgsFeatureRequest,
     QgsFeatureSource,
     QgsFeature,
+    QgsFeatureSink,
     QgsFieldConstraints,
     QgsDataProvider,
     NULL,
@@ -1715,6 +1716,106 @@ class TestPyQgsPostgresProvider(unittest.TestCase, ProviderTestCase):
         self.assertEqual(f['f2'], 123.456)
         self.assertEqual(f['f3'], '12345678.90123456789')
 
+    def testImportBulkCopy(self):
+        """Test exported features, which are loaded with a binary COPY"""
+        uri = 'MultiPolygonZ?crs=epsg:3857&field=i:int&field=l:int8&field=d:double&field=s:string(20)'
+        uri += '&field=dt:date&field=t:time&field=ts:datetime'
+        lyr = QgsVectorLayer(uri, "x", "memory")
+        self.assertTrue(lyr.isValid())
+
+        f1 = QgsFeature(lyr.fields())
+        f1.setAttributes([1, 1234567890123, 1.5, 'héllo', QDate(2021, 2, 3), QTime(10, 11, 12, 13), QDateTime(QDate(1999, 12, 31), QTime(23, 59, 58, 500))])
+        f1.setGeometry(QgsGeometry.fromWkt('MultiPolygonZ(((0 0 1, 1 0 2, 1 1 3, 0 0 1)))'))
+        f2 = QgsFeature(lyr.fields())
+        f2.setAttributes([-2, None, None, None, None, None, None])
+        # single part geometries are forced to multi part ones
+        f3 = QgsFeature(lyr.fields())
+        f3.setAttributes([3, -5, -0.25, '', QDate(1900, 1, 1), QTime(0, 0), QDateTime(QDate(2030, 6, 7), QTime(8, 9, 10))])
+        f3.setGeometry(QgsGeometry.fromWkt('PolygonZ((10 10 0, 11 10 0, 11 11 0, 10 10 0))'))
+        self.assertTrue(lyr.dataProvider().addFeatures([f1, f2, f3]))
+
+        self.execSQLCommand('DROP TABLE IF EXISTS qgis_test.import_copy')
+        uri = '%s table="qgis_test"."import_copy" (g) key=\'id\'' % self.dbconn
+        err = QgsVectorLayerExporter.exportLayer(lyr, uri, "postgres", lyr.crs(), False, {'SPATIAL_INDEX': True})
+        self.assertEqual(err[0], QgsVectorLayerExporter.NoError,
+                         'unexpected import error {0}'.format(err))
+
+        olyr = QgsVectorLayer(uri, "y", "postgres")
+        self.assertTrue(olyr.isValid())
+        self.assertEqual(olyr.featureCount(), 3)
+        self.assertEqual(olyr.crs().authid(), 'EPSG:3857')
+        # the requested spatial index is created once the features are loaded
+        self.assertEqual(olyr.hasSpatialIndex(), QgsFeatureSource.SpatialIndexPresent)
+
+        features = {f['i']: f for f in olyr.getFeatures()}
+        self.assertEqual(features[1]['l'], 1234567890123)
+        self.assertEqual(features[1]['d'], 1.5)
+        self.assertEqual(features[1]['s'], 'héllo')
+        self.assertEqual(features[1]['dt'], QDate(2021, 2, 3))
+        self.assertEqual(features[1]['t'], QTime(10, 11, 12, 13))
+        self.assertEqual(features[1]['ts'], QDateTime(QDate(1999, 12, 31), QTime(23, 59, 58, 500)))
+        self.assertEqual(features[1].geometry().asWkt(), 'MultiPolygonZ (((0 0 1, 1 0 2, 1 1 3, 0 0 1)))')
+
+        self.assertEqual(features[-2].attributes()[2:], [NULL] * 6)
+        self.assertFalse(features[-2].hasGeometry())
+
+        self.assertEqual(features[3]['l'], -5)
+        self.assertEqual(features[3]['d'], -0.25)
+        self.assertEqual(features[3]['s'], '')
+        self.assertEqual(features[3]['dt'], QDate(1900, 1, 1))
+        self.assertEqual(features[3]['t'], QTime(0, 0))
+        self.assertEqual(features[3]['ts'], QDateTime(QDate(2030, 6, 7), QTime(8, 9, 10)))
+        self.assertEqual(features[3].geometry().asWkt(), 'MultiPolygonZ (((10 10 0, 11 10 0, 11 11 0, 10 10 0)))')
+
+        # features are appended to the loaded ones
+        self.assertTrue(olyr.dataProvider().addFeatures([QgsFeature(olyr.fields())], QgsFeatureSink.FastInsert))
+        self.assertEqual(olyr.featureCount(), 4)
+
+    def testBulkCopyNumeric(self):
+        """Test that numeric values are loaded with a binary COPY"""
+        self.execSQLCommand('DROP TABLE IF EXISTS qgis_test.copy_numeric')
+        self.execSQLCommand('CREATE TABLE qgis_test.copy_numeric (pk serial PRIMARY KEY, n numeric)')
+        # COPY doesn't apply rules, so the features are only added when they are copied
+        self.execSQLCommand('CREATE RULE copy_numeric_no_insert AS ON INSERT TO qgis_test.copy_numeric DO INSTEAD NOTHING')
+
+        vl = QgsVectorLayer('%s table="qgis_test"."copy_numeric" key=\'pk\'' % self.dbconn, "copy_numeric", "postgres")
+        self.assertTrue(vl.isValid())
+
+        values = [1.25, '12345678.90123456789', -0.0001, 0, 1e20, '-1.500', float('nan'), None]
+        features = []
+        for value in values:
+            f = QgsFeature(vl.fields())
+            f['n'] = value
+            features.append(f)
+        self.assertTrue(vl.dataProvider().addFeatures(features, QgsFeatureSink.FastInsert))
+
+        cur = self.con.cursor()
+        cur.execute('SELECT n::text FROM qgis_test.copy_numeric ORDER BY pk')
+        self.assertEqual([r[0] for r in cur.fetchall()],
+                         ['1.25', '12345678.90123456789', '-0.0001', '0', '100000000000000000000', '-1.500', 'NaN', None])
+        cur.close()
+
+    def testImportNoSpatialIndex(self):
+        """Test that exported tables are only indexed on request"""
+        lyr = QgsVectorLayer('Point?crs=epsg:4326&field=i:int', "x", "memory")
+        self.assertTrue(lyr.isValid())
+        f = QgsFeature(lyr.fields())
+        f.setAttributes([1])
+        f.setGeometry(QgsGeometry.fromWkt('Point(1 2)'))
+        self.assertTrue(lyr.dataProvider().addFeatures([f]))
+
+        for options in ({}, {'SPATIAL_INDEX': False}):
+            self.execSQLCommand('DROP TABLE IF EXISTS qgis_test.import_no_index')
+            uri = '%s table="qgis_test"."import_no_index" (g) key=\'id\'' % self.dbconn
+            err = QgsVectorLayerExporter.exportLayer(lyr, uri, "postgres", lyr.crs(), False, options)
+            self.assertEqual(err[0], QgsVectorLayerExporter.NoError,
+                             'unexpected import error {0}'.format(err))
+
+            olyr = QgsVectorLayer(uri, "y", "postgres")
+            self.assertTrue(olyr.isValid())
+            self.assertEqual(olyr.featureCount(), 1)
+            self.assertEqual(olyr.hasSpatialIndex(), QgsFeatureSource.SpatialIndexNotPresent)
+
     # See https://github.com/qgis/QGIS/issues/23163
     def testImportKey(self):
         uri = 'point?field=f1:int'